@@ -81,6 +81,7 @@ LOCAL_HAL_FILES := \
         src/QCameraStream.cpp\
         ../usbcamcore/src/QualcommUsbCamera.cpp\
         ../usbcamcore/src/QCameraMjpegDecode.cpp\
+        ../usbcamcore/src/QCameraUsbColorConv.cpp\
         ../usbcamcore/src/QCameraUsbParm.cpp
 
 LOCAL_HAL_WRAPPER_FILES := ../wrapper/QualcommCamera.cpp
@@ -89,6 +90,7 @@ LOCAL_C_INCLUDES := \
         $(LOCAL_PATH)/../wrapper \
         $(LOCAL_PATH)/inc \
         $(LOCAL_PATH)/../usbcamcore/inc\
+        $(LOCAL_PATH)/../../../mm-image-codec/qyuvscale \
         $(LOCAL_PATH)/../../stack/mm-camera-interface/inc \
         $(LOCAL_PATH)/../../stack/mm-jpeg-interface/inc \
         $(LOCAL_PATH)/../../../ \
@@ -120,6 +122,7 @@ LOCAL_SRC_FILES := \
 LOCAL_SHARED_LIBRARIES := libutils libui libcamera_client liblog libcutils libmmjpeg
 LOCAL_SHARED_LIBRARIES += libmmcamera_interface
 LOCAL_SHARED_LIBRARIES += libgenlock libbinder libmmjpeg_interface libhardware
+LOCAL_SHARED_LIBRARIES += libqyuvscale
 
 LOCAL_CFLAGS += -include bionic/libc/kernel/common/linux/socket.h
 
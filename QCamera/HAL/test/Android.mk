@@ -1 +1,19 @@
-
+LOCAL_PATH := $(call my-dir)
+
+#YUYV converter correctness and throughput bench
+
+include $(CLEAR_VARS)
+LOCAL_MODULE_TAGS := optional
+
+LOCAL_CFLAGS := -Wall -Wextra -Werror
+
+LOCAL_C_INCLUDES := $(LOCAL_PATH)/../usbcamcore/inc
+
+LOCAL_SRC_FILES := usbcam_conv_bench.cpp ../usbcamcore/src/QCameraUsbColorConv.cpp
+
+LOCAL_SHARED_LIBRARIES := liblog
+
+LOCAL_MODULE           := usbcam-conv-bench
+LOCAL_PRELINK_MODULE   := false
+
+include $(BUILD_EXECUTABLE)
@@ -0,0 +1,245 @@
+/* Copyright (c) 2014, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+/* Correctness and throughput bench for the USB camera YUYV converter.
+ *
+ * Every output layout is checked against a plain per-byte reference for
+ * frame sizes that do and do not fill whole SIMD iterations and for
+ * padded input/output strides. The NV21 reference is the routine the
+ * HAL used before the converter was added.
+ *
+ * Then converts the common UVC preview sizes with the reference and
+ * with usbcamConvertYUYV and reports the time per frame and input
+ * throughput of both.
+ *
+ * usage: usbcam-conv-bench [iterations]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include "QCameraUsbColorConv.h"
+
+#define BENCH_DEFAULT_ITERATIONS 200
+
+static int g_failures = 0;
+
+static int64_t bench_now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+/* Former convert_YUYV_to_420_NV12 of QualcommUsbCamera.cpp, NV21 out */
+static int ref_convert_nv21(const char *in_buf, char *out_buf, int wd, int ht)
+{
+    int row, col, uv_row;
+
+    for (row = 0; row < ht; row++)
+        for (col = 0; col < wd * 2; col += 2)
+            out_buf[row * wd + col / 2] = in_buf[row * wd * 2 + col];
+
+    for (row = 0, uv_row = ht; row < ht; row += 2, uv_row++)
+        for (col = 1; col < wd * 2; col += 4) {
+            out_buf[uv_row * wd + col / 2] = in_buf[row * wd * 2 + col + 2];
+            out_buf[uv_row * wd + col / 2 + 1] = in_buf[row * wd * 2 + col];
+        }
+    return 0;
+}
+
+/* Per-byte reference honouring strides and all output layouts */
+static void ref_convert(const uint8_t *in, uint8_t *out,
+                        const usbcam_conv_params_t *p)
+{
+    uint8_t *c = out + p->y_stride * p->y_scanline;
+    int row, col;
+
+    for (row = 0; row < p->height; row++) {
+        const uint8_t *line = in + row * p->in_stride;
+        for (col = 0; col < p->width; col++)
+            out[row * p->y_stride + col] = line[col * 2];
+        if (row & 1)
+            continue;
+        for (col = 0; col < p->width; col += 2) {
+            uint8_t cb = line[col * 2 + 1];
+            uint8_t cr = line[col * 2 + 3];
+            switch (p->fmt) {
+            case USBCAM_CONV_FMT_NV12:
+                c[(row / 2) * p->c_stride + col] = cb;
+                c[(row / 2) * p->c_stride + col + 1] = cr;
+                break;
+            case USBCAM_CONV_FMT_NV21:
+                c[(row / 2) * p->c_stride + col] = cr;
+                c[(row / 2) * p->c_stride + col + 1] = cb;
+                break;
+            default:
+                c[(row / 2) * p->c_stride + col / 2] = cr;
+                c[(p->height / 2 + row / 2) * p->c_stride + col / 2] = cb;
+                break;
+            }
+        }
+    }
+}
+
+static size_t out_size(const usbcam_conv_params_t *p)
+{
+    return (size_t)p->y_stride * p->y_scanline + (size_t)p->c_stride * p->height;
+}
+
+static void fill_random(uint8_t *buf, size_t len, uint32_t seed)
+{
+    size_t i;
+    for (i = 0; i < len; i++) {
+        seed = seed * 1103515245 + 12345;
+        buf[i] = (uint8_t)(seed >> 16);
+    }
+}
+
+static void check_case(int wd, int ht, int pad, usbcam_conv_fmt_t fmt)
+{
+    usbcam_conv_params_t p;
+    uint8_t *in, *ref, *out;
+    size_t in_len, len;
+
+    usbcamConvInitParams(&p, wd, ht, fmt);
+    p.in_stride += pad * 2;
+    p.y_stride += pad;
+    p.y_scanline += pad ? 2 : 0;
+    p.c_stride += pad;
+
+    in_len = (size_t)p.in_stride * ht;
+    len = out_size(&p);
+    in = (uint8_t *)malloc(in_len);
+    ref = (uint8_t *)malloc(len);
+    out = (uint8_t *)malloc(len);
+    if (!in || !ref || !out) {
+        printf("FAIL: no memory\n");
+        g_failures++;
+        free(in);
+        free(ref);
+        free(out);
+        return;
+    }
+    fill_random(in, in_len, (uint32_t)(wd * 31 + ht + fmt));
+    /* padding must be left alone, start both outputs from the same bytes */
+    memset(ref, 0xA5, len);
+    memset(out, 0xA5, len);
+
+    ref_convert(in, ref, &p);
+    if ((usbcamConvertYUYV((const char *)in, (char *)out, &p) != 0) ||
+            (memcmp(ref, out, len) != 0)) {
+        printf("FAIL: fmt %d %dx%d pad %d\n", fmt, wd, ht, pad);
+        g_failures++;
+    }
+
+    /* packed NV21 must match what the HAL produced before */
+    if ((USBCAM_CONV_FMT_NV21 == fmt) && (0 == pad)) {
+        ref_convert_nv21((const char *)in, (char *)ref, wd, ht);
+        if (memcmp(ref, out, (size_t)wd * ht * 3 / 2) != 0) {
+            printf("FAIL: NV21 %dx%d differs from the old HAL routine\n",
+                   wd, ht);
+            g_failures++;
+        }
+    }
+    free(in);
+    free(ref);
+    free(out);
+}
+
+static void bench(int wd, int ht, int iterations)
+{
+    usbcam_conv_params_t p;
+    size_t in_len = (size_t)wd * ht * 2;
+    char *in = (char *)malloc(in_len);
+    char *out = (char *)malloc((size_t)wd * ht * 3 / 2);
+    int64_t t_ref, t_conv;
+    int i;
+
+    if (!in || !out) {
+        free(in);
+        free(out);
+        return;
+    }
+    fill_random((uint8_t *)in, in_len, 7);
+    usbcamConvInitParams(&p, wd, ht, USBCAM_CONV_FMT_NV21);
+
+    t_ref = bench_now_ns();
+    for (i = 0; i < iterations; i++)
+        ref_convert_nv21(in, out, wd, ht);
+    t_ref = (bench_now_ns() - t_ref) / iterations;
+
+    t_conv = bench_now_ns();
+    for (i = 0; i < iterations; i++)
+        usbcamConvertYUYV(in, out, &p);
+    t_conv = (bench_now_ns() - t_conv) / iterations;
+
+    printf("  %4dx%-4d  reference %6lld us %6.0f MB/s   converter %6lld us "
+           "%6.0f MB/s   x%.1f\n", wd, ht,
+           (long long)(t_ref / 1000), (double)in_len * 1000.0 / (double)t_ref,
+           (long long)(t_conv / 1000), (double)in_len * 1000.0 / (double)t_conv,
+           (double)t_ref / (double)t_conv);
+    free(in);
+    free(out);
+}
+
+int main(int argc, char **argv)
+{
+    static const int sizes[][2] = {
+        { 2, 2 }, { 16, 2 }, { 30, 4 }, { 34, 6 }, { 62, 8 }, { 66, 10 },
+        { 176, 144 }, { 322, 240 }, { 640, 480 }, { 1278, 720 },
+    };
+    static const int benches[][2] = {
+        { 640, 480 }, { 1280, 720 }, { 1920, 1080 },
+    };
+    int iterations = (argc > 1) ? atoi(argv[1]) : BENCH_DEFAULT_ITERATIONS;
+    size_t i;
+    int fmt, pad;
+
+    if (iterations < 1) {
+        printf("usage: %s [iterations]\n", argv[0]);
+        return 1;
+    }
+
+    for (i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++)
+        for (fmt = USBCAM_CONV_FMT_NV12; fmt <= USBCAM_CONV_FMT_YV12; fmt++)
+            for (pad = 0; pad <= 32; pad += 32)
+                check_case(sizes[i][0], sizes[i][1], pad,
+                           (usbcam_conv_fmt_t)fmt);
+
+    printf("YUYV to NV21, %d iterations\n", iterations);
+    for (i = 0; i < sizeof(benches) / sizeof(benches[0]); i++)
+        bench(benches[i][0], benches[i][1], iterations);
+
+    printf("%s: %d failures\n", (g_failures == 0) ? "PASS" : "FAIL",
+           g_failures);
+    return (g_failures == 0) ? 0 : 1;
+}
@@ -0,0 +1,59 @@
+/* Copyright (c) 2011-2012, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef __QCAMERA_USB_COLOR_CONV_H
+#define __QCAMERA_USB_COLOR_CONV_H
+
+/* Output layouts supported by the YUYV (YUV 4:2:2 packed) converter */
+typedef enum {
+    USBCAM_CONV_FMT_NV12,   /* Y plane + interleaved CbCr plane */
+    USBCAM_CONV_FMT_NV21,   /* Y plane + interleaved CrCb plane */
+    USBCAM_CONV_FMT_YV12,   /* Y plane + Cr plane + Cb plane    */
+} usbcam_conv_fmt_t;
+
+typedef struct {
+    int                 width;      /* frame width in pixels, even    */
+    int                 height;     /* frame height in lines, even    */
+    int                 in_stride;  /* bytes per YUYV input line      */
+    int                 y_stride;   /* bytes per output luma line     */
+    int                 y_scanline; /* luma lines before chroma plane */
+    int                 c_stride;   /* bytes per output chroma line   */
+    usbcam_conv_fmt_t   fmt;
+} usbcam_conv_params_t;
+
+/* Fills params for a tightly packed frame of the given format */
+void usbcamConvInitParams(usbcam_conv_params_t *params,
+                          int width, int height,
+                          usbcam_conv_fmt_t fmt);
+
+/* Converts one YUYV frame. Chroma is taken from the even input lines.
+ * Input and output buffers must not overlap. */
+int usbcamConvertYUYV(const char *in_buf, char *out_buf,
+                      const usbcam_conv_params_t *params);
+
+#endif /* __QCAMERA_USB_COLOR_CONV_H */
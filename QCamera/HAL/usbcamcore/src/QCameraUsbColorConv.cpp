@@ -0,0 +1,278 @@
+/* Copyright (c) 2011-2012, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+//#define ALOG_NDEBUG 0
+#define ALOG_NIDEBUG 0
+#define LOG_TAG "QCameraUsbColorConv"
+#include <utils/Log.h>
+
+#include <stdint.h>
+#include <string.h>
+
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+#include <arm_neon.h>
+#define USBCAM_CONV_NEON 1
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define USBCAM_CONV_SSE2 1
+#endif
+
+#include "QCameraUsbColorConv.h"
+
+/******************************************************************************
+ * Each YUYV input line is split into luma and, on even lines, chroma. The
+ * row kernels below process as many pixels as possible with SIMD and finish
+ * the remainder (and the whole line when no SIMD is available) in C.
+ *
+ * YUYV macropixel:  Y0 U Y1 V  ->  two luma samples + one Cb/Cr pair
+ *****************************************************************************/
+
+/* Number of pixels consumed per SIMD iteration */
+#if USBCAM_CONV_NEON
+#define USBCAM_CONV_SIMD_PIX   32
+#elif USBCAM_CONV_SSE2
+#define USBCAM_CONV_SIMD_PIX   16
+#else
+#define USBCAM_CONV_SIMD_PIX   0
+#endif
+
+static void conv_row_luma(const uint8_t *in, uint8_t *y, int wd)
+{
+    int col = 0;
+
+#if USBCAM_CONV_NEON
+    for (; col + USBCAM_CONV_SIMD_PIX <= wd; col += USBCAM_CONV_SIMD_PIX) {
+        uint8x16x4_t px = vld4q_u8(in + col * 2);
+        uint8x16x2_t luma;
+        luma.val[0] = px.val[0];
+        luma.val[1] = px.val[2];
+        vst2q_u8(y + col, luma);
+    }
+#elif USBCAM_CONV_SSE2
+    const __m128i mask = _mm_set1_epi16(0x00FF);
+    for (; col + USBCAM_CONV_SIMD_PIX <= wd; col += USBCAM_CONV_SIMD_PIX) {
+        __m128i a = _mm_loadu_si128((const __m128i *)(in + col * 2));
+        __m128i b = _mm_loadu_si128((const __m128i *)(in + col * 2 + 16));
+        _mm_storeu_si128((__m128i *)(y + col),
+            _mm_packus_epi16(_mm_and_si128(a, mask), _mm_and_si128(b, mask)));
+    }
+#endif
+    for (; col < wd; col++)
+        y[col] = in[col * 2];
+}
+
+/* Luma plus interleaved chroma. swap = 0 writes CbCr, swap = 1 CrCb */
+static void conv_row_semiplanar(const uint8_t *in, uint8_t *y, uint8_t *c,
+                                int wd, int swap)
+{
+    int col = 0;
+
+#if USBCAM_CONV_NEON
+    for (; col + USBCAM_CONV_SIMD_PIX <= wd; col += USBCAM_CONV_SIMD_PIX) {
+        uint8x16x4_t px = vld4q_u8(in + col * 2);
+        uint8x16x2_t luma, chroma;
+        luma.val[0] = px.val[0];
+        luma.val[1] = px.val[2];
+        chroma.val[0] = swap ? px.val[3] : px.val[1];
+        chroma.val[1] = swap ? px.val[1] : px.val[3];
+        vst2q_u8(y + col, luma);
+        vst2q_u8(c + col, chroma);
+    }
+#elif USBCAM_CONV_SSE2
+    const __m128i mask = _mm_set1_epi16(0x00FF);
+    for (; col + USBCAM_CONV_SIMD_PIX <= wd; col += USBCAM_CONV_SIMD_PIX) {
+        __m128i a = _mm_loadu_si128((const __m128i *)(in + col * 2));
+        __m128i b = _mm_loadu_si128((const __m128i *)(in + col * 2 + 16));
+        __m128i chroma = _mm_packus_epi16(_mm_srli_epi16(a, 8),
+                                          _mm_srli_epi16(b, 8));
+        if (swap) {
+            chroma = _mm_or_si128(_mm_slli_epi16(chroma, 8),
+                                  _mm_srli_epi16(chroma, 8));
+        }
+        _mm_storeu_si128((__m128i *)(y + col),
+            _mm_packus_epi16(_mm_and_si128(a, mask), _mm_and_si128(b, mask)));
+        _mm_storeu_si128((__m128i *)(c + col), chroma);
+    }
+#endif
+    for (; col < wd; col += 2) {
+        const uint8_t *px = in + col * 2;
+        y[col]         = px[0];
+        y[col + 1]     = px[2];
+        c[col]         = swap ? px[3] : px[1];
+        c[col + 1]     = swap ? px[1] : px[3];
+    }
+}
+
+/* Luma plus separate Cb and Cr planes */
+static void conv_row_planar(const uint8_t *in, uint8_t *y,
+                            uint8_t *cb, uint8_t *cr, int wd)
+{
+    int col = 0;
+
+#if USBCAM_CONV_NEON
+    for (; col + USBCAM_CONV_SIMD_PIX <= wd; col += USBCAM_CONV_SIMD_PIX) {
+        uint8x16x4_t px = vld4q_u8(in + col * 2);
+        uint8x16x2_t luma;
+        luma.val[0] = px.val[0];
+        luma.val[1] = px.val[2];
+        vst2q_u8(y + col, luma);
+        vst1q_u8(cb + col / 2, px.val[1]);
+        vst1q_u8(cr + col / 2, px.val[3]);
+    }
+#elif USBCAM_CONV_SSE2
+    const __m128i mask = _mm_set1_epi16(0x00FF);
+    const __m128i zero = _mm_setzero_si128();
+    for (; col + USBCAM_CONV_SIMD_PIX <= wd; col += USBCAM_CONV_SIMD_PIX) {
+        __m128i a = _mm_loadu_si128((const __m128i *)(in + col * 2));
+        __m128i b = _mm_loadu_si128((const __m128i *)(in + col * 2 + 16));
+        __m128i chroma = _mm_packus_epi16(_mm_srli_epi16(a, 8),
+                                          _mm_srli_epi16(b, 8));
+        _mm_storeu_si128((__m128i *)(y + col),
+            _mm_packus_epi16(_mm_and_si128(a, mask), _mm_and_si128(b, mask)));
+        _mm_storel_epi64((__m128i *)(cb + col / 2),
+            _mm_packus_epi16(_mm_and_si128(chroma, mask), zero));
+        _mm_storel_epi64((__m128i *)(cr + col / 2),
+            _mm_packus_epi16(_mm_srli_epi16(chroma, 8), zero));
+    }
+#endif
+    for (; col < wd; col += 2) {
+        const uint8_t *px = in + col * 2;
+        y[col]         = px[0];
+        y[col + 1]     = px[2];
+        cb[col / 2]    = px[1];
+        cr[col / 2]    = px[3];
+    }
+}
+
+/******************************************************************************
+ * Function: usbcamConvInitParams
+ * Description: Fills conversion parameters for a frame without padding
+ *
+ * Input parameters:
+ *   params              - parameters to fill
+ *   width, height       - frame dimensions
+ *   fmt                 - output layout
+ *
+ * Return values:
+ *   None
+ * Notes: YV12 chroma lines are half the luma line length
+ *****************************************************************************/
+void usbcamConvInitParams(usbcam_conv_params_t *params,
+                          int width, int height,
+                          usbcam_conv_fmt_t fmt)
+{
+    params->width       = width;
+    params->height      = height;
+    params->in_stride   = width * 2;
+    params->y_stride    = width;
+    params->y_scanline  = height;
+    params->c_stride    = (USBCAM_CONV_FMT_YV12 == fmt) ? width / 2 : width;
+    params->fmt         = fmt;
+}
+
+/******************************************************************************
+ * Function: usbcamConvertYUYV
+ * Description: Converts a YUYV frame into a 4:2:0 planar/semiplanar frame
+ *
+ * Input parameters:
+ *   in_buf              - YUYV input frame
+ *   out_buf             - output frame, must not overlap with in_buf
+ *   params              - dimensions, strides and output layout
+ *
+ * Return values:
+ *      0   Success
+ *      -1  Error
+ * Notes: For YV12 the Cr plane follows the luma plane and the Cb plane
+ *        follows the Cr plane, each height/2 lines of c_stride bytes
+ *****************************************************************************/
+int usbcamConvertYUYV(const char *in_buf, char *out_buf,
+                      const usbcam_conv_params_t *params)
+{
+    const uint8_t *in = (const uint8_t *)in_buf;
+    uint8_t *y, *c, *cb, *cr;
+    int row, wd, ht;
+
+    if (!in_buf || !out_buf || !params) {
+        ALOGE("%s: Invalid input", __func__);
+        return -1;
+    }
+    wd = params->width;
+    ht = params->height;
+    if ((wd <= 0) || (ht <= 0) || (wd & 1) || (ht & 1) ||
+        (params->in_stride < wd * 2) || (params->y_stride < wd) ||
+        (params->y_scanline < ht)) {
+        ALOGE("%s: Invalid dimensions %dx%d", __func__, wd, ht);
+        return -1;
+    }
+
+    y = (uint8_t *)out_buf;
+    c = y + params->y_stride * params->y_scanline;
+
+    switch (params->fmt) {
+    case USBCAM_CONV_FMT_NV12:
+    case USBCAM_CONV_FMT_NV21:
+        if (params->c_stride < wd) {
+            ALOGE("%s: Invalid chroma stride %d", __func__, params->c_stride);
+            return -1;
+        }
+        for (row = 0; row < ht; row += 2) {
+            conv_row_semiplanar(in, y, c, wd,
+                                USBCAM_CONV_FMT_NV21 == params->fmt);
+            in += params->in_stride;
+            y  += params->y_stride;
+            conv_row_luma(in, y, wd);
+            in += params->in_stride;
+            y  += params->y_stride;
+            c  += params->c_stride;
+        }
+        break;
+    case USBCAM_CONV_FMT_YV12:
+        if (params->c_stride < wd / 2) {
+            ALOGE("%s: Invalid chroma stride %d", __func__, params->c_stride);
+            return -1;
+        }
+        cr = c;
+        cb = cr + params->c_stride * (ht / 2);
+        for (row = 0; row < ht; row += 2) {
+            conv_row_planar(in, y, cb, cr, wd);
+            in += params->in_stride;
+            y  += params->y_stride;
+            conv_row_luma(in, y, wd);
+            in += params->in_stride;
+            y  += params->y_stride;
+            cb += params->c_stride;
+            cr += params->c_stride;
+        }
+        break;
+    default:
+        ALOGE("%s: Unsupported output format %d", __func__, params->fmt);
+        return -1;
+    }
+
+    return 0;
+}
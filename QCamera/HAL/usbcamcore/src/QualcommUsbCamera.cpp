@@ -46,6 +46,8 @@
 #include "QCameraUsbPriv.h"
 #include "QCameraMjpegDecode.h"
 #include "QCameraUsbParm.h"
+#include "QCameraUsbColorConv.h"
+#include "qyuvscale.h"
 #include <gralloc_priv.h>
 #include <genlock.h>
 
@@ -116,7 +118,6 @@ static int put_buf_to_display(   camera_hardware_t *camHal, int buffer_id);
 static int convert_data_frm_cam_to_disp(camera_hardware_t *camHal, int buffer_id);
 static void * previewloop(void *);
 static void * takePictureThread(void *);
-static int convert_YUYV_to_420_NV12(char *in_buf, char *out_buf, int wd, int ht);
 static int get_uvc_device(char *devname);
 static int getPreviewCaptureFmt(camera_hardware_t *camHal);
 static int allocate_ion_memory(QCameraHalMemInfo_t *mem_info, int ion_type);
@@ -698,48 +699,6 @@ int usbcam_dump(struct camera_device * device, int fd)
 *  Static function definitions below
 *****************************************************************************/
 
-/******************************************************************************/
-/* No in place conversion supported. Output buffer and input MUST should be   */
-/* different input buffer for a 4x4 pixel video                             ***/
-/******                  YUYVYUYV          00 01 02 03 04 05 06 07 ************/
-/******                  YUYVYUYV          08 09 10 11 12 13 14 15 ************/
-/******                  YUYVYUYV          16 17 18 19 20 21 22 23 ************/
-/******                  YUYVYUYV          24 25 26 27 28 29 30 31 ************/
-/******************************************************************************/
-/* output generated by this function ******************************************/
-/************************** YYYY            00 02 04 06            ************/
-/************************** YYYY            08 10 12 14            ************/
-/************************** YYYY            16 18 20 22            ************/
-/************************** YYYY            24 26 28 30            ************/
-/************************** VUVU            03 01 07 05            ************/
-/************************** VUVU            19 17 23 21            ************/
-/******************************************************************************/
-
-static int convert_YUYV_to_420_NV12(char *in_buf, char *out_buf, int wd, int ht)
-{
-    int rc =0;
-    int row, col, uv_row;
-
-    ALOGD("%s: E", __func__);
-    /* Arrange Y */
-    for(row = 0; row < ht; row++)
-        for(col = 0; col < wd * 2; col += 2)
-        {
-            out_buf[row * wd + col / 2] = in_buf[row * wd * 2 + col];
-        }
-
-    /* Arrange UV */
-    for(row = 0, uv_row = ht; row < ht; row += 2, uv_row++)
-        for(col = 1; col < wd * 2; col += 4)
-        {
-            out_buf[uv_row * wd + col / 2]= in_buf[row * wd * 2 + col + 2];
-            out_buf[uv_row * wd + col / 2 + 1]  = in_buf[row * wd * 2 + col];
-        }
-
-    ALOGD("%s: X", __func__);
-    return rc;
-}
-
 /******************************************************************************
  * Function: initDisplayBuffers
  * Description: This function initializes the preview buffers
@@ -1930,15 +1889,21 @@ static int convert_data_frm_cam_to_disp(camera_hardware_t *camHal, int buffer_id
     if( (V4L2_PIX_FMT_YUYV == camHal->captureFormat) &&
         (HAL_PIXEL_FORMAT_YCrCb_420_SP == camHal->dispFormat))
     {
-        convert_YUYV_to_420_NV12(
+        usbcam_conv_params_t convParams;
+
+        usbcamConvInitParams(&convParams, camHal->prevWidth,
+                             camHal->prevHeight, USBCAM_CONV_FMT_NV21);
+        rc = usbcamConvertYUYV(
             (char *)camHal->buffers[camHal->curCaptureBuf.index].data,
             (char *)camHal->previewMem.camera_memory[buffer_id]->data,
-            camHal->prevWidth,
-            camHal->prevHeight);
+            &convParams);
+        if(rc < 0) {
+            ALOGE("%s: usbcamConvertYUYV failed", __func__);
+            return rc;
+        }
         ALOGD("%s: Copied %d bytes from camera buffer %d to display buffer: %d",
              __func__, camHal->curCaptureBuf.bytesused,
              camHal->curCaptureBuf.index, buffer_id);
-        rc = 0;
     }
 
     /* If camera buffer is MJPEG encoded, call mjpeg decode call */
@@ -2807,7 +2772,11 @@ int encodeJpeg(camera_hardware_t *camHal)
     src_image_buffer_info   *srcBuf = NULL;
     QCameraHalMemInfo_t jpegInMemInfo;
     camera_memory_t*    jpegInMem;
+    QCameraHalMemInfo_t thumbInMemInfo;
+    camera_memory_t*    thumbInMem = NULL;
+    qyuv_image_t        scaleSrc, scaleDst;
     uint32_t            jobId;
+    usbcam_conv_params_t convParams;
 
     ALOGI("%s: E", __func__);
 
@@ -2827,10 +2796,55 @@ int encodeJpeg(camera_hardware_t *camHal)
         return -1;
     }
 
-    rc = convert_YUYV_to_420_NV12(
+    usbcamConvInitParams(&convParams, camHal->pictWidth, camHal->pictHeight,
+                         USBCAM_CONV_FMT_NV21);
+    rc = usbcamConvertYUYV(
         (char *)camHal->buffers[camHal->curCaptureBuf.index].data,
-        (char *)jpegInMem->data, camHal->pictWidth, camHal->pictHeight);
-    ERROR_CHECK_EXIT(rc, "convert_YUYV_to_420_NV12");
+        (char *)jpegInMem->data, &convParams);
+    ERROR_CHECK_EXIT(rc, "usbcamConvertYUYV");
+
+    /************************************************************************/
+    /* - Scale the thumbnail from the NV21 main image before encoding       */
+    /************************************************************************/
+    memset(&thumbInMemInfo, 0, sizeof(thumbInMemInfo));
+    if(camHal->thumbnailWidth > 0 && camHal->thumbnailHeight > 0){
+        scaleSrc.y          = (uint8_t *)jpegInMem->data;
+        scaleSrc.uv         = scaleSrc.y + camHal->pictWidth * camHal->pictHeight;
+        scaleSrc.width      = camHal->pictWidth;
+        scaleSrc.height     = camHal->pictHeight;
+        scaleSrc.y_stride   = camHal->pictWidth;
+        scaleSrc.uv_stride  = (camHal->pictWidth + 1) & ~1;
+
+        scaleDst.width      = camHal->thumbnailWidth;
+        scaleDst.height     = camHal->thumbnailHeight;
+        scaleDst.y_stride   = camHal->thumbnailWidth;
+        scaleDst.uv_stride  = (camHal->thumbnailWidth + 1) & ~1;
+
+        thumbInMemInfo.size = scaleDst.y_stride * scaleDst.height +
+                        scaleDst.uv_stride * ((scaleDst.height + 1) / 2);
+        rc = allocate_ion_memory(&thumbInMemInfo,
+                            ((0x1 << CAMERA_ZSL_ION_HEAP_ID) |
+                            (0x1 << CAMERA_ZSL_ION_FALLBACK_HEAP_ID)));
+        if(!rc){
+            thumbInMem = camHal->get_memory(thumbInMemInfo.fd,
+                            thumbInMemInfo.size, 1, camHal->cb_ctxt);
+            if(!thumbInMem)
+                deallocate_ion_memory(&thumbInMemInfo);
+        }
+        if(thumbInMem){
+            scaleDst.y  = (uint8_t *)thumbInMem->data;
+            scaleDst.uv = scaleDst.y + scaleDst.y_stride * scaleDst.height;
+            if(qyuv_scale(&scaleSrc, NULL, &scaleDst, 0, QYUV_FILTER_AUTO, 0)){
+                ALOGE("%s: thumbnail scaling failed", __func__);
+                thumbInMem->release(thumbInMem);
+                thumbInMem = NULL;
+                deallocate_ion_memory(&thumbInMemInfo);
+            }
+        }else
+            ALOGE("%s: no memory for thumbnail, encoding without", __func__);
+        rc = 0;
+    }
+
     /************************************************************************/
     /* - Populate JPEG encoding parameters from the camHal context          */
     /************************************************************************/
@@ -2844,8 +2858,8 @@ int encodeJpeg(camera_hardware_t *camHal)
     mmJpegJob.encode_job.encode_parm.exif_numEntries    = 0;
     mmJpegJob.encode_job.encode_parm.exif_data          = NULL;
 
-    /* TBD: Add thumbnail support */
-    mmJpegJob.encode_job.encode_parm.buf_info.src_imgs.src_img_num = 1;
+    mmJpegJob.encode_job.encode_parm.buf_info.src_imgs.src_img_num =
+                            thumbInMem ? 2 : 1;
     mmJpegJob.encode_job.encode_parm.buf_info.src_imgs.is_video_frame = 0;
 
     /* Fill main image information */
@@ -2868,7 +2882,26 @@ int encodeJpeg(camera_hardware_t *camHal)
     srcBuf->crop.height         = srcBuf->src_dim.height;
     srcBuf->quality             = camHal->pictJpegQlty;
 
-    /* TBD:Fill thumbnail image information */
+    /* Fill thumbnail image information, already scaled to output size */
+    if(thumbInMem){
+        srcBuf = &mmJpegJob.encode_job.encode_parm.buf_info.src_imgs.src_img[
+                            JPEG_SRC_IMAGE_TYPE_THUMB];
+        srcBuf->type                = JPEG_SRC_IMAGE_TYPE_THUMB;
+        srcBuf->img_fmt             = JPEG_SRC_IMAGE_FMT_YUV;
+        srcBuf->color_format        = MM_JPEG_COLOR_FORMAT_YCRCBLP_H2V2;
+        srcBuf->num_bufs            = 1;
+        srcBuf->src_image[0].fd        = thumbInMemInfo.fd;
+        srcBuf->src_image[0].buf_vaddr = (uint8_t*)thumbInMem->data;
+        srcBuf->src_dim.width       = camHal->thumbnailWidth;
+        srcBuf->src_dim.height      = camHal->thumbnailHeight;
+        srcBuf->out_dim.width       = camHal->thumbnailWidth;
+        srcBuf->out_dim.height      = camHal->thumbnailHeight;
+        srcBuf->crop.offset_x       = 0;
+        srcBuf->crop.offset_y       = 0;
+        srcBuf->crop.width          = srcBuf->src_dim.width;
+        srcBuf->crop.height         = srcBuf->src_dim.height;
+        srcBuf->quality             = camHal->thumbnailJpegQlty;
+    }
 
     /* Fill out buf information */
     mmJpegJob.encode_job.encode_parm.buf_info.sink_img.buf_vaddr =
@@ -2912,6 +2945,12 @@ int encodeJpeg(camera_hardware_t *camHal)
     if(rc)
         ALOGE("%s: ION memory de-allocation failed", __func__);
 
+    if(thumbInMem){
+        thumbInMem->release(thumbInMem);
+        if(deallocate_ion_memory(&thumbInMemInfo))
+            ALOGE("%s: thumbnail ION memory de-allocation failed", __func__);
+    }
+
     ALOGI("%s: X rc = %d", __func__, rc);
     return rc;
 }
@@ -7,6 +7,9 @@ include $(CLEAR_VARS)
 LOCAL_SRC_FILES := \
         util/QCameraCmdThread.cpp \
         util/QCameraQueue.cpp \
+        util/QCameraRingQueue.cpp \
+        util/QCameraExecutor.cpp \
+        util/QCameraCapsCache.cpp \
         QCamera2Hal.cpp \
         QCamera2Factory.cpp
 
@@ -17,7 +20,8 @@ LOCAL_SRC_FILES += \
         HAL3/QCamera3Stream.cpp \
         HAL3/QCamera3Channel.cpp \
         HAL3/QCamera3VendorTags.cpp \
-        HAL3/QCamera3PostProc.cpp
+        HAL3/QCamera3PostProc.cpp \
+        HAL3/QCamera3InFlight.cpp
 
 #HAL 1.0 source
 LOCAL_SRC_FILES += \
@@ -47,6 +51,7 @@ LOCAL_C_INCLUDES := \
         system/media/camera/include \
         $(LOCAL_PATH)/../mm-image-codec/qexif \
         $(LOCAL_PATH)/../mm-image-codec/qomx_core \
+        $(LOCAL_PATH)/../mm-image-codec/qyuvscale \
         $(LOCAL_PATH)/util \
 
 #HAL 1.0 Include paths
@@ -61,7 +66,7 @@ LOCAL_C_INCLUDES += \
         hardware/qcom/display/libgralloc
 
 LOCAL_SHARED_LIBRARIES := libcamera_client liblog libhardware libutils libcutils libdl
-LOCAL_SHARED_LIBRARIES += libmmcamera_interface libmmjpeg_interface libui libcamera_metadata
+LOCAL_SHARED_LIBRARIES += libmmcamera_interface libmmjpeg_interface libui libcamera_metadata libqyuvscale
 
 LOCAL_MODULE_PATH := $(TARGET_OUT_SHARED_LIBRARIES)/hw
 LOCAL_MODULE := camera.$(TARGET_BOARD_PLATFORM)
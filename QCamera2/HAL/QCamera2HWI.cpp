@@ -41,6 +41,8 @@
 
 #include "QCamera2HWI.h"
 #include "QCameraMem.h"
+#include "QCameraCapsCache.h"
+#include "mm_camera_dump.h"
 
 #define MAP_TO_DRIVER_COORDINATE(val, base, scale, offset) \
   ((int32_t)val * (int32_t)scale / (int32_t)base + (int32_t)offset)
@@ -294,6 +296,7 @@ int QCamera2HardwareInterface::start_preview(struct camera_device *device)
         return BAD_VALUE;
     }
     CDBG_HIGH("[KPI Perf] %s: E PROFILE_START_PREVIEW", __func__);
+    hw->mStartPreviewTime = systemTime();
     hw->lockAPI();
     qcamera_api_result_t apiResult;
     qcamera_sm_evt_enum_t evt = QCAMERA_SM_EVT_START_PREVIEW;
@@ -1072,7 +1075,15 @@ QCamera2HardwareInterface::QCamera2HardwareInterface(uint32_t cameraId)
       mPostviewJob(-1),
       mMetadataJob(-1),
       mReprocJob(-1),
-      mRawdataJob(-1)
+      mRawdataJob(-1),
+      mAsyncAllocEnabled(true),
+      mOpenTime(0),
+      mStartPreviewTime(0),
+      mOpenToFirstFrame(0),
+      mStartToFirstFrame(0),
+      mCbMapLastCount(0),
+      mCbMapLastTime(0),
+      mCbMapRate(0)
 {
     getLogLevel();
     ATRACE_CALL();
@@ -1102,9 +1113,20 @@ QCamera2HardwareInterface::QCamera2HardwareInterface(uint32_t cameraId)
 #endif
 
     memset(mDeffOngoingJobs, 0, sizeof(mDeffOngoingJobs));
+    memset(mDeffJobChannel, 0, sizeof(mDeffJobChannel));
+    memset(mDeffJobStatus, 0, sizeof(mDeffJobStatus));
 
-    mDefferedWorkThread.launch(defferedWorkRoutine, this);
-    mDefferedWorkThread.sendCmd(CAMERA_CMD_TYPE_START_DATA_PROC, FALSE, FALSE);
+    char value[PROPERTY_VALUE_MAX];
+    property_get("persist.camera.mem.async_alloc", value, "1");
+    mAsyncAllocEnabled = atoi(value) > 0 ? true : false;
+
+    mDeffNextWorker = 0;
+    for (uint32_t i = 0; i < MAX_DEFF_WORKERS; i++) {
+        mDeffWorkers[i].pme = this;
+        mDeffWorkers[i].thread.launch(defferedWorkRoutine, &mDeffWorkers[i]);
+        mDeffWorkers[i].thread.sendCmd(CAMERA_CMD_TYPE_START_DATA_PROC,
+                FALSE, FALSE);
+    }
 }
 
 /*===========================================================================
@@ -1118,8 +1140,11 @@ QCamera2HardwareInterface::QCamera2HardwareInterface(uint32_t cameraId)
  *==========================================================================*/
 QCamera2HardwareInterface::~QCamera2HardwareInterface()
 {
-    mDefferedWorkThread.sendCmd(CAMERA_CMD_TYPE_STOP_DATA_PROC, TRUE, TRUE);
-    mDefferedWorkThread.exit();
+    for (uint32_t i = 0; i < MAX_DEFF_WORKERS; i++) {
+        mDeffWorkers[i].thread.sendCmd(CAMERA_CMD_TYPE_STOP_DATA_PROC,
+                TRUE, TRUE);
+        mDeffWorkers[i].thread.exit();
+    }
 
     closeCamera();
     m_stateMachine.releaseThread();
@@ -1152,6 +1177,7 @@ int QCamera2HardwareInterface::openCamera(struct hw_device_t **hw_device)
     }
     CDBG_HIGH("[KPI Perf] %s: E PROFILE_OPEN_CAMERA camera id %d",
         __func__,mCameraId);
+    mOpenTime = systemTime();
     rc = openCamera();
     if (rc == NO_ERROR){
         *hw_device = &mCameraDevice.common;
@@ -1293,12 +1319,24 @@ int QCamera2HardwareInterface::closeCamera()
     // delete all channels if not already deleted
     for (i = 0; i < QCAMERA_CH_TYPE_MAX; i++) {
         if (m_channels[i] != NULL) {
+            waitDefferedAlloc(m_channels[i]);
             m_channels[i]->stop();
             delete m_channels[i];
             m_channels[i] = NULL;
         }
     }
 
+    // no more frames can be dumped, finish writing the queued ones
+    mm_camera_dump_flush();
+    mm_camera_dump_stats_t dumpStats;
+    mm_camera_dump_get_stats(&dumpStats);
+    if (dumpStats.queued > 0 || dumpStats.dropped > 0) {
+        ALOGI("%s: frame dumps: %u queued, %u written, %u dropped, %u failed,"
+              " %llu bytes", __func__, dumpStats.queued, dumpStats.written,
+              dumpStats.dropped, dumpStats.failed,
+              (unsigned long long)dumpStats.bytes_written);
+    }
+
     rc = mCameraHandle->ops->close_camera(mCameraHandle->camera_handle);
     mCameraHandle = NULL;
 
@@ -1325,6 +1363,25 @@ int QCamera2HardwareInterface::initCapabilities(uint32_t cameraId,
     ATRACE_CALL();
     int rc = NO_ERROR;
     QCameraHeapMemory *capabilityHeap = NULL;
+    struct camera_info *info = get_cam_info(cameraId);
+
+    /* Capability cached by an earlier boot saves the backend query */
+    {
+        QCameraCapsCache capsCache(cameraId, get_cam_sensor_name(cameraId),
+                info->facing, info->orientation);
+        cam_capability_t *caps =
+                (cam_capability_t *)malloc(sizeof(cam_capability_t));
+        if (caps != NULL) {
+            if (capsCache.load(QCAMERA_CACHE_HAL1_CAPABILITY, caps,
+                    sizeof(cam_capability_t)) == NO_ERROR) {
+                CDBG_HIGH("%s: camera %d capability from cache",
+                        __func__, cameraId);
+                gCamCaps[cameraId] = caps;
+                return NO_ERROR;
+            }
+            free(caps);
+        }
+    }
 
     /* Allocate memory for capability buffer */
     capabilityHeap = new QCameraHeapMemory(QCAMERA_ION_USE_CACHE);
@@ -1358,6 +1415,12 @@ int QCamera2HardwareInterface::initCapabilities(uint32_t cameraId,
     }
     memcpy(gCamCaps[cameraId], DATA_PTR(capabilityHeap,0),
                                         sizeof(cam_capability_t));
+    {
+        QCameraCapsCache capsCache(cameraId, get_cam_sensor_name(cameraId),
+                info->facing, info->orientation);
+        capsCache.store(QCAMERA_CACHE_HAL1_CAPABILITY, gCamCaps[cameraId],
+                sizeof(cam_capability_t));
+    }
 
     rc = NO_ERROR;
 
@@ -1441,6 +1504,7 @@ int QCamera2HardwareInterface::releaseTorchCamera()
     if ( !m_stateMachine.isPreviewRunning() &&
             !m_stateMachine.isPreviewReady() &&
             ( m_channels[QCAMERA_CH_TYPE_PREVIEW] != NULL ) ) {
+        waitDefferedAlloc(m_channels[QCAMERA_CH_TYPE_PREVIEW]);
         delete m_channels[QCAMERA_CH_TYPE_PREVIEW];
         m_channels[QCAMERA_CH_TYPE_PREVIEW] = NULL;
     }
@@ -2737,7 +2801,10 @@ int QCamera2HardwareInterface::takePicture()
                 (NULL != m_channels[QCAMERA_CH_TYPE_CAPTURE])) {
 
                 // configure capture channel
-                rc = m_channels[QCAMERA_CH_TYPE_CAPTURE]->config();
+                rc = waitDefferedAlloc(m_channels[QCAMERA_CH_TYPE_CAPTURE]);
+                if (rc == NO_ERROR) {
+                    rc = m_channels[QCAMERA_CH_TYPE_CAPTURE]->config();
+                }
                 if (rc != NO_ERROR) {
                     ALOGE("%s: cannot configure capture channel", __func__);
                     delChannel(QCAMERA_CH_TYPE_CAPTURE);
@@ -3365,6 +3432,18 @@ int QCamera2HardwareInterface::dump(int fd)
     fdprintf(fd, "StoreMetaDataInFrame: %d \n", mStoreMetaDataInFrame);
     fdprintf(fd, "\n Configuration: %s", mParameters.dump().string());
     fdprintf(fd, "\n State Information: %s", m_stateMachine.dump().string());
+    fdprintf(fd, "\n Memory Pool: %s", m_memoryPool.dump().string());
+    fdprintf(fd, "\n Preview callback mappings per second: %u\n", mCbMapRate);
+    fdprintf(fd, "\n Open to first preview frame: %lld ms\n",
+            (long long)ns2ms(mOpenToFirstFrame));
+    fdprintf(fd, "\n Start preview to first frame: %lld ms\n",
+            (long long)ns2ms(mStartToFirstFrame));
+    mm_camera_dump_stats_t dumpStats;
+    mm_camera_dump_get_stats(&dumpStats);
+    fdprintf(fd, "\n Frame dumps (all cameras): %u queued, %u written,"
+            " %u dropped, %u failed, %llu bytes\n", dumpStats.queued,
+            dumpStats.written, dumpStats.dropped, dumpStats.failed,
+            (unsigned long long)dumpStats.bytes_written);
     fdprintf(fd, "\n Camera HAL information End \n");
     return NO_ERROR;
 }
@@ -4093,6 +4172,28 @@ int32_t QCamera2HardwareInterface::addStreamToChannel(QCameraChannel *pChannel,
                 }
             }
         }
+    } else if (needDefferedAlloc(streamType, bDynAllocBuf)) {
+        rc = pChannel->addStream(*this,
+                pStreamInfo,
+                minStreamBufNum,
+                &gCamCaps[mCameraId]->padding_info,
+                streamCB, userData,
+                bDynAllocBuf,
+                true);
+
+        // Buffers are allocated and mapped on the deferred work pool,
+        // the channel waits for them before it gets configured
+        if ( !rc ) {
+            DefferWorkArgs args;
+
+            memset(&args, 0, sizeof(DefferWorkArgs));
+            args.allocArgs.type = streamType;
+            args.allocArgs.ch = pChannel;
+
+            if (queueDefferedWork(CMD_DEFF_ALLOCATE_BUFF, args) == -1) {
+                rc = UNKNOWN_ERROR;
+            }
+        }
     } else {
         rc = pChannel->addStream(*this,
                 pStreamInfo,
@@ -4158,6 +4259,7 @@ int32_t QCamera2HardwareInterface::addPreviewChannel()
                             metadata_stream_cb_routine, this);
     if (rc != NO_ERROR) {
         ALOGE("%s: add metadata stream failed, ret = %d", __func__, rc);
+        waitDefferedAlloc(pChannel);
         delete pChannel;
         return rc;
     }
@@ -4177,6 +4279,7 @@ int32_t QCamera2HardwareInterface::addPreviewChannel()
     }
     if (rc != NO_ERROR) {
         ALOGE("%s: add preview stream failed, ret = %d", __func__, rc);
+        waitDefferedAlloc(pChannel);
         delete pChannel;
         return rc;
     }
@@ -4203,6 +4306,7 @@ int32_t QCamera2HardwareInterface::addVideoChannel()
 
     if (m_channels[QCAMERA_CH_TYPE_VIDEO] != NULL) {
         // if we had video channel before, delete it first
+        waitDefferedAlloc(m_channels[QCAMERA_CH_TYPE_VIDEO]);
         delete m_channels[QCAMERA_CH_TYPE_VIDEO];
         m_channels[QCAMERA_CH_TYPE_VIDEO] = NULL;
     }
@@ -4226,6 +4330,7 @@ int32_t QCamera2HardwareInterface::addVideoChannel()
                             video_stream_cb_routine, this);
     if (rc != NO_ERROR) {
         ALOGE("%s: add video stream failed, ret = %d", __func__, rc);
+        waitDefferedAlloc(pChannel);
         delete pChannel;
         return rc;
     }
@@ -4254,6 +4359,7 @@ int32_t QCamera2HardwareInterface::addSnapshotChannel()
 
     if (m_channels[QCAMERA_CH_TYPE_SNAPSHOT] != NULL) {
         // if we had ZSL channel before, delete it first
+        waitDefferedAlloc(m_channels[QCAMERA_CH_TYPE_SNAPSHOT]);
         delete m_channels[QCAMERA_CH_TYPE_SNAPSHOT];
         m_channels[QCAMERA_CH_TYPE_SNAPSHOT] = NULL;
     }
@@ -4276,6 +4382,7 @@ int32_t QCamera2HardwareInterface::addSnapshotChannel()
                             snapshot_stream_cb_routine, this);
     if (rc != NO_ERROR) {
         ALOGE("%s: add snapshot stream failed, ret = %d", __func__, rc);
+        waitDefferedAlloc(pChannel);
         delete pChannel;
         return rc;
     }
@@ -4302,6 +4409,7 @@ int32_t QCamera2HardwareInterface::addRawChannel()
 
     if (m_channels[QCAMERA_CH_TYPE_RAW] != NULL) {
         // if we had raw channel before, delete it first
+        waitDefferedAlloc(m_channels[QCAMERA_CH_TYPE_RAW]);
         delete m_channels[QCAMERA_CH_TYPE_RAW];
         m_channels[QCAMERA_CH_TYPE_RAW] = NULL;
     }
@@ -4325,6 +4433,7 @@ int32_t QCamera2HardwareInterface::addRawChannel()
                             metadata_stream_cb_routine, this);
     if (rc != NO_ERROR) {
         ALOGE("%s: add metadata stream failed, ret = %d", __func__, rc);
+        waitDefferedAlloc(pChannel);
         delete pChannel;
         return rc;
     }
@@ -4334,6 +4443,7 @@ int32_t QCamera2HardwareInterface::addRawChannel()
                             raw_stream_cb_routine, this);
     if (rc != NO_ERROR) {
         ALOGE("%s: add snapshot stream failed, ret = %d", __func__, rc);
+        waitDefferedAlloc(pChannel);
         delete pChannel;
         return rc;
     }
@@ -4363,11 +4473,13 @@ int32_t QCamera2HardwareInterface::addZSLChannel()
 
     if (m_channels[QCAMERA_CH_TYPE_ZSL] != NULL) {
         // if we had ZSL channel before, delete it first
+        waitDefferedAlloc(m_channels[QCAMERA_CH_TYPE_ZSL]);
         delete m_channels[QCAMERA_CH_TYPE_ZSL];
         m_channels[QCAMERA_CH_TYPE_ZSL] = NULL;
     }
 
      if (m_channels[QCAMERA_CH_TYPE_PREVIEW] != NULL) {
+        waitDefferedAlloc(m_channels[QCAMERA_CH_TYPE_PREVIEW]);
         delete m_channels[QCAMERA_CH_TYPE_PREVIEW];
         m_channels[QCAMERA_CH_TYPE_PREVIEW] = NULL;
     }
@@ -4405,6 +4517,7 @@ int32_t QCamera2HardwareInterface::addZSLChannel()
                             metadata_stream_cb_routine, this);
     if (rc != NO_ERROR) {
         ALOGE("%s: add metadata stream failed, ret = %d", __func__, rc);
+        waitDefferedAlloc(pChannel);
         delete pChannel;
         return rc;
     }
@@ -4418,6 +4531,7 @@ int32_t QCamera2HardwareInterface::addZSLChannel()
     }
     if (rc != NO_ERROR) {
         ALOGE("%s: add preview stream failed, ret = %d", __func__, rc);
+        waitDefferedAlloc(pChannel);
         delete pChannel;
         return rc;
     }
@@ -4426,6 +4540,7 @@ int32_t QCamera2HardwareInterface::addZSLChannel()
                             NULL, this);
     if (rc != NO_ERROR) {
         ALOGE("%s: add snapshot stream failed, ret = %d", __func__, rc);
+        waitDefferedAlloc(pChannel);
         delete pChannel;
         return rc;
     }
@@ -4439,6 +4554,7 @@ int32_t QCamera2HardwareInterface::addZSLChannel()
                                 this);
         if (rc != NO_ERROR) {
             ALOGE("%s: add raw stream failed, ret = %d", __func__, rc);
+            waitDefferedAlloc(pChannel);
             delete pChannel;
             return rc;
         }
@@ -4470,6 +4586,7 @@ int32_t QCamera2HardwareInterface::addCaptureChannel()
     bool raw_yuv = false;
 
     if (m_channels[QCAMERA_CH_TYPE_CAPTURE] != NULL) {
+        waitDefferedAlloc(m_channels[QCAMERA_CH_TYPE_CAPTURE]);
         delete m_channels[QCAMERA_CH_TYPE_CAPTURE];
         m_channels[QCAMERA_CH_TYPE_CAPTURE] = NULL;
     }
@@ -4507,6 +4624,7 @@ int32_t QCamera2HardwareInterface::addCaptureChannel()
                             metadata_stream_cb_routine, this);
     if (rc != NO_ERROR) {
         ALOGE("%s: add metadata stream failed, ret = %d", __func__, rc);
+        waitDefferedAlloc(pChannel);
         delete pChannel;
         return rc;
     }
@@ -4517,6 +4635,7 @@ int32_t QCamera2HardwareInterface::addCaptureChannel()
 
         if (rc != NO_ERROR) {
             ALOGE("%s: add postview stream failed, ret = %d", __func__, rc);
+            waitDefferedAlloc(pChannel);
             delete pChannel;
             return rc;
         }
@@ -4526,6 +4645,7 @@ int32_t QCamera2HardwareInterface::addCaptureChannel()
 
         if (rc != NO_ERROR) {
             ALOGE("%s: add preview stream failed, ret = %d", __func__, rc);
+            waitDefferedAlloc(pChannel);
             delete pChannel;
             return rc;
         }
@@ -4535,6 +4655,7 @@ int32_t QCamera2HardwareInterface::addCaptureChannel()
                             NULL, this);
     if (rc != NO_ERROR) {
         ALOGE("%s: add snapshot stream failed, ret = %d", __func__, rc);
+        waitDefferedAlloc(pChannel);
         delete pChannel;
         return rc;
     }
@@ -4548,6 +4669,7 @@ int32_t QCamera2HardwareInterface::addCaptureChannel()
                                 this);
         if (rc != NO_ERROR) {
             ALOGE("%s: add raw stream failed, ret = %d", __func__, rc);
+            waitDefferedAlloc(pChannel);
             delete pChannel;
             return rc;
         }
@@ -4574,6 +4696,7 @@ int32_t QCamera2HardwareInterface::addMetaDataChannel()
     QCameraChannel *pChannel = NULL;
 
     if (m_channels[QCAMERA_CH_TYPE_METADATA] != NULL) {
+        waitDefferedAlloc(m_channels[QCAMERA_CH_TYPE_METADATA]);
         delete m_channels[QCAMERA_CH_TYPE_METADATA];
         m_channels[QCAMERA_CH_TYPE_METADATA] = NULL;
     }
@@ -4598,6 +4721,7 @@ int32_t QCamera2HardwareInterface::addMetaDataChannel()
                             metadata_stream_cb_routine, this);
     if (rc != NO_ERROR) {
         ALOGE("%s: add metadata stream failed, ret = %d", __func__, rc);
+        waitDefferedAlloc(pChannel);
         delete pChannel;
         return rc;
     }
@@ -4911,6 +5035,8 @@ int32_t QCamera2HardwareInterface::delChannel(qcamera_ch_type_enum_t ch_type,
                                               bool destroy)
 {
     if (m_channels[ch_type] != NULL) {
+        // buffers may still be allocated on the deferred work pool
+        waitDefferedAlloc(m_channels[ch_type]);
         if (destroy) {
             delete m_channels[ch_type];
             m_channels[ch_type] = NULL;
@@ -4938,7 +5064,10 @@ int32_t QCamera2HardwareInterface::startChannel(qcamera_ch_type_enum_t ch_type)
 {
     int32_t rc = UNKNOWN_ERROR;
     if (m_channels[ch_type] != NULL) {
-        rc = m_channels[ch_type]->config();
+        rc = waitDefferedAlloc(m_channels[ch_type]);
+        if (NO_ERROR == rc) {
+            rc = m_channels[ch_type]->config();
+        }
         if (NO_ERROR == rc) {
             rc = m_channels[ch_type]->start();
         }
@@ -6252,7 +6381,7 @@ bool QCamera2HardwareInterface::needFDMetadata(qcamera_ch_type_enum_t channel_ty
  * DESCRIPTION: data process routine that executes deffered tasks
  *
  * PARAMETERS :
- *   @data    : user data ptr (QCamera2HardwareInterface)
+ *   @data    : user data ptr (DeffWorker of the pool)
  *
  * RETURN     : None
  *==========================================================================*/
@@ -6262,8 +6391,9 @@ void *QCamera2HardwareInterface::defferedWorkRoutine(void *obj)
     int ret;
     uint8_t is_active = FALSE;
 
-    QCamera2HardwareInterface *pme = (QCamera2HardwareInterface *)obj;
-    QCameraCmdThread *cmdThread = &pme->mDefferedWorkThread;
+    DeffWorker *worker = (DeffWorker *)obj;
+    QCamera2HardwareInterface *pme = worker->pme;
+    QCameraCmdThread *cmdThread = &worker->thread;
     cmdThread->setName("CAM_defrdWrk");
 
     do {
@@ -6311,6 +6441,7 @@ void *QCamera2HardwareInterface::defferedWorkRoutine(void *obj)
                         }
 
                         cam_stream_type_t streamType = dw->args.allocArgs.type;
+                        int32_t status = NO_ERROR;
 
                         uint32_t iNumOfStreams = pChannel->getNumOfStreams();
                         QCameraStream *pStream = NULL;
@@ -6322,7 +6453,8 @@ void *QCamera2HardwareInterface::defferedWorkRoutine(void *obj)
                             }
 
                             if ( pStream->isTypeOf(streamType)) {
-                                if ( pStream->allocateBuffers() ) {
+                                status = pStream->allocateBuffers();
+                                if ( status ) {
                                     ALOGE("%s: Error allocating buffers !!!",
                                             __func__);
                                 }
@@ -6331,9 +6463,10 @@ void *QCamera2HardwareInterface::defferedWorkRoutine(void *obj)
                         }
                         {
                             Mutex::Autolock l(pme->mDeffLock);
+                            pme->mDeffJobStatus[dw->id] = status;
                             pme->mDeffOngoingJobs[dw->id] = false;
                             delete dw;
-                            pme->mDeffCond.signal();
+                            pme->mDeffCond.broadcast();
                         }
 
                     }
@@ -6351,7 +6484,7 @@ void *QCamera2HardwareInterface::defferedWorkRoutine(void *obj)
                             Mutex::Autolock l(pme->mDeffLock);
                             pme->mDeffOngoingJobs[dw->id] = false;
                             delete dw;
-                            pme->mDeffCond.signal();
+                            pme->mDeffCond.broadcast();
                         }
                     }
                     break;
@@ -6395,9 +6528,16 @@ int32_t QCamera2HardwareInterface::queueDefferedWork(DefferedWorkCmd cmd,
         if (!mDeffOngoingJobs[i]) {
             mCmdQueue.enqueue(new DeffWork(cmd, i, args));
             mDeffOngoingJobs[i] = true;
-            mDefferedWorkThread.sendCmd(CAMERA_CMD_TYPE_DO_NEXT_JOB,
+            mDeffJobStatus[i] = NO_ERROR;
+            mDeffJobChannel[i] = (CMD_DEFF_ALLOCATE_BUFF == cmd) ?
+                    args.allocArgs.ch : NULL;
+            // any idle worker can pick the job from the shared queue,
+            // wake them in turn so independent jobs run in parallel
+            mDeffWorkers[mDeffNextWorker].thread.sendCmd(
+                    CAMERA_CMD_TYPE_DO_NEXT_JOB,
                     FALSE,
                     FALSE);
+            mDeffNextWorker = (mDeffNextWorker + 1) % MAX_DEFF_WORKERS;
             return (int32_t)i;
         }
     }
@@ -6432,6 +6572,78 @@ int32_t QCamera2HardwareInterface::waitDefferedWork(int32_t &job_id)
     return NO_ERROR;
 }
 
+/*===========================================================================
+ * FUNCTION   : waitDefferedAlloc
+ *
+ * DESCRIPTION: waits for all deferred buffer allocations queued for a
+ *              channel. Has to be called before the channel gets
+ *              configured, started or deleted, which also frees the job
+ *              slots so a new channel at the same address starts clean.
+ *
+ * PARAMETERS :
+ *   @pChannel : channel whose stream buffers are being allocated
+ *
+ * RETURN     : int32_t type of status
+ *              NO_ERROR  -- success
+ *              none-zero failure code of the first failed allocation
+ *==========================================================================*/
+int32_t QCamera2HardwareInterface::waitDefferedAlloc(QCameraChannel *pChannel)
+{
+    int32_t rc = NO_ERROR;
+    Mutex::Autolock l(mDeffLock);
+
+    if (NULL == pChannel) {
+        return NO_ERROR;
+    }
+
+    for (uint32_t i = 0; i < MAX_ONGOING_JOBS; ++i) {
+        if (mDeffJobChannel[i] != pChannel) {
+            continue;
+        }
+        while (mDeffOngoingJobs[i]) {
+            mDeffCond.wait(mDeffLock);
+        }
+        if ((NO_ERROR == rc) && (NO_ERROR != mDeffJobStatus[i])) {
+            rc = mDeffJobStatus[i];
+        }
+        mDeffJobChannel[i] = NULL;
+    }
+
+    return rc;
+}
+
+/*===========================================================================
+ * FUNCTION   : needDefferedAlloc
+ *
+ * DESCRIPTION: checks if stream buffers can be allocated on the deferred
+ *              work pool while the rest of the channel setup continues
+ *
+ * PARAMETERS :
+ *   @streamType   : type of the stream
+ *   @bDynAllocBuf : flag if the stream allocates buffers on demand
+ *
+ * RETURN     : true  -- allocate buffers asynchronously
+ *              false -- allocate buffers in place
+ *==========================================================================*/
+bool QCamera2HardwareInterface::needDefferedAlloc(cam_stream_type_t streamType,
+                                                  bool bDynAllocBuf)
+{
+    if (!mAsyncAllocEnabled || bDynAllocBuf) {
+        return false;
+    }
+
+    switch (streamType) {
+    case CAM_STREAM_TYPE_PREVIEW:
+        // gralloc buffers need the preview window
+        return isNoDisplayMode() || (NULL != mPreviewWindow);
+    case CAM_STREAM_TYPE_POSTVIEW:
+        // shares the preview window, it is queued from takePicture
+        return false;
+    default:
+        return true;
+    }
+}
+
 /*===========================================================================
  * FUNCTION   : isRegularCapture
  *
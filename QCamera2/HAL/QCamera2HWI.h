@@ -125,6 +125,7 @@ typedef struct {
 #define QCAMERA_ION_USE_CACHE   true
 #define QCAMERA_ION_USE_NOCACHE false
 #define MAX_ONGOING_JOBS 25
+#define MAX_DEFF_WORKERS 3
 
 extern volatile uint32_t gCamHalLogLevel;
 
@@ -337,6 +338,8 @@ private:
     bool needScaleReprocess();
     void debugShowVideoFPS();
     void debugShowPreviewFPS();
+    void debugShowCbMapRate();
+    void debugShowStartupLatency();
     void dumpJpegToFile(const void *data, size_t size, uint32_t index);
     void dumpFrameToFile(QCameraStream *stream,
             mm_camera_buf_def_t *frame, uint32_t dump_type);
@@ -581,6 +584,9 @@ private:
     } DefferWorkArgs;
 
     bool mDeffOngoingJobs[MAX_ONGOING_JOBS];
+    // channel a buffer allocation job works on, and its result
+    QCameraChannel *mDeffJobChannel[MAX_ONGOING_JOBS];
+    int32_t mDeffJobStatus[MAX_ONGOING_JOBS];
 
     struct DeffWork
     {
@@ -596,7 +602,15 @@ private:
         DefferWorkArgs args;
     };
 
-    QCameraCmdThread      mDefferedWorkThread;
+    struct DeffWorker
+    {
+        QCamera2HardwareInterface *pme;
+        QCameraCmdThread thread;
+    };
+
+    // deferred work is run by a small pool of workers sharing mCmdQueue
+    DeffWorker            mDeffWorkers[MAX_DEFF_WORKERS];
+    uint32_t              mDeffNextWorker;
     QCameraQueue          mCmdQueue;
 
     Mutex                 mDeffLock;
@@ -605,6 +619,8 @@ private:
     int32_t queueDefferedWork(DefferedWorkCmd cmd,
                               DefferWorkArgs args);
     int32_t waitDefferedWork(int32_t &job_id);
+    int32_t waitDefferedAlloc(QCameraChannel *pChannel);
+    bool needDefferedAlloc(cam_stream_type_t streamType, bool bDynAllocBuf);
     static void *defferedWorkRoutine(void *obj);
 
     int32_t mSnapshotJob;
@@ -613,6 +629,19 @@ private:
     int32_t mReprocJob;
     int32_t mRawdataJob;
     uint32_t mOutputCount;
+
+    bool mAsyncAllocEnabled;
+
+    // startup latency, from open and from start preview to first frame
+    nsecs_t mOpenTime;
+    nsecs_t mStartPreviewTime;
+    nsecs_t mOpenToFirstFrame;
+    nsecs_t mStartToFirstFrame;
+
+    // preview callback mappings created per second
+    uint32_t mCbMapLastCount;
+    nsecs_t mCbMapLastTime;
+    uint32_t mCbMapRate;
 };
 
 }; // namespace qcamera
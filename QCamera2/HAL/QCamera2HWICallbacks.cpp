@@ -36,6 +36,7 @@
 #include <utils/Trace.h>
 #include <utils/Timers.h>
 #include "QCamera2HWI.h"
+#include "mm_camera_dump.h"
 
 namespace qcamera {
 
@@ -571,6 +572,7 @@ void QCamera2HardwareInterface::preview_stream_cb_routine(mm_camera_super_buf_t
     if(pme->m_bPreviewStarted) {
        CDBG_HIGH("[KPI Perf] %s : PROFILE_FIRST_PREVIEW_FRAME", __func__);
        pme->m_bPreviewStarted = false ;
+       pme->debugShowStartupLatency();
     }
 
     // Display the buffer.
@@ -621,6 +623,7 @@ int32_t QCamera2HardwareInterface::sendPreviewCallback(QCameraStream *stream,
 {
     camera_memory_t *previewMem = NULL;
     camera_memory_t *data = NULL;
+    void *mapping = NULL;
     size_t previewBufSize = 0;
     cam_dimension_t preview_dim;
     cam_format_t previewFmt;
@@ -651,10 +654,11 @@ int32_t QCamera2HardwareInterface::sendPreviewCallback(QCameraStream *stream,
                     (size_t)preview_dim.height * 3 / 2;
             }
         if(previewBufSize != (size_t)memory->getSize(idx)) {
-            previewMem = mGetMemory(memory->getFd(idx),
-                       previewBufSize, 1, mCallbackCookie);
-            if (!previewMem || !previewMem->data) {
-                ALOGE("%s: mGetMemory failed.\n", __func__);
+            previewMem = memory->getCallbackMemory(idx, previewBufSize,
+                    &mapping);
+            debugShowCbMapRate();
+            if (!previewMem) {
+                ALOGE("%s: getCallbackMemory failed.\n", __func__);
                 return NO_MEMORY;
             } else {
                 data = previewMem;
@@ -671,16 +675,16 @@ int32_t QCamera2HardwareInterface::sendPreviewCallback(QCameraStream *stream,
     cbArg.cb_type = QCAMERA_DATA_CALLBACK;
     cbArg.msg_type = CAMERA_MSG_PREVIEW_FRAME;
     cbArg.data = data;
-    if ( previewMem ) {
-        cbArg.user_data = previewMem;
-        cbArg.release_cb = releaseCameraMemory;
+    if ( mapping ) {
+        cbArg.user_data = mapping;
+        cbArg.release_cb = QCameraMemory::releaseCallbackMemory;
     }
     cbArg.cookie = this;
     rc = m_cbNotifier.notifyCallback(cbArg);
     if (rc != NO_ERROR) {
         ALOGE("%s: fail sending notification", __func__);
-        if (previewMem) {
-            previewMem->release(previewMem);
+        if (mapping) {
+            QCameraMemory::releaseCallbackMemory(mapping, this, rc);
         }
     }
 
@@ -737,6 +741,12 @@ void QCamera2HardwareInterface::nodisplay_preview_stream_cb_routine(
         pme->debugShowPreviewFPS();
     }
 
+    if (pme->m_bPreviewStarted) {
+        CDBG_HIGH("[KPI Perf] %s : PROFILE_FIRST_PREVIEW_FRAME", __func__);
+        pme->m_bPreviewStarted = false;
+        pme->debugShowStartupLatency();
+    }
+
     QCameraMemory *previewMemObj = (QCameraMemory *)frame->mem_info;
     camera_memory_t *preview_mem = NULL;
     if (previewMemObj != NULL) {
@@ -1787,29 +1797,28 @@ void QCamera2HardwareInterface::dumpFrameToFile(QCameraStream *stream,
                     }
 
                     filePath.append(buf);
-                    int file_fd = open(filePath.string(), O_RDWR | O_CREAT, 0777);
-                    if (file_fd > 0) {
-                        void *data = NULL;
-                        ssize_t written_len = 0;
-
-                        for (uint32_t i = 0; i < offset.num_planes; i++) {
-                            uint32_t index = offset.mp[i].offset;
-                            if (i > 0) {
-                                index += offset.mp[i-1].len;
-                            }
-                            for (int j = 0; j < offset.mp[i].height; j++) {
-                                data = (void *)((uint8_t *)frame->buffer + index);
-                                written_len += write(file_fd, data,
-                                        (size_t)offset.mp[i].width);
-                                index += (uint32_t)offset.mp[i].stride;
-                            }
-                        }
 
-                        CDBG_HIGH("%s: written number of bytes %d\n",
-                            __func__, written_len);
-                        close(file_fd);
-                    } else {
-                        ALOGE("%s: fail t open file for image dumping", __func__);
+                    // Only the copy happens here, the file is written by
+                    // the dump thread so stream callbacks are not delayed
+                    mm_camera_dump_plane_t planes[MM_CAMERA_DUMP_MAX_PLANES];
+                    uint32_t num_planes = offset.num_planes;
+                    if (num_planes > MM_CAMERA_DUMP_MAX_PLANES) {
+                        num_planes = MM_CAMERA_DUMP_MAX_PLANES;
+                    }
+                    for (uint32_t i = 0; i < num_planes; i++) {
+                        uint32_t index = offset.mp[i].offset;
+                        if (i > 0) {
+                            index += offset.mp[i-1].len;
+                        }
+                        planes[i].base = (uint8_t *)frame->buffer + index;
+                        planes[i].width = (size_t)offset.mp[i].width;
+                        planes[i].stride = (size_t)offset.mp[i].stride;
+                        planes[i].height = (size_t)offset.mp[i].height;
+                    }
+                    if (mm_camera_dump_frame(filePath.string(), planes,
+                            num_planes) != 0) {
+                        ALOGE("%s: fail to queue %s for image dumping",
+                              __func__, filePath.string());
                     }
                     mDumpFrmCnt++;
                 }
@@ -1876,6 +1885,63 @@ void QCamera2HardwareInterface::debugShowPreviewFPS()
     }
 }
 
+/*===========================================================================
+ * FUNCTION   : debugShowCbMapRate
+ *
+ * DESCRIPTION: Updates and logs the number of preview callback mappings
+ *              created per second. With mappings reused across frames
+ *              this drops to zero once every buffer has been mapped.
+ *
+ * PARAMETERS : None
+ *
+ * RETURN     : None
+ *==========================================================================*/
+void QCamera2HardwareInterface::debugShowCbMapRate()
+{
+    nsecs_t now = systemTime();
+    nsecs_t diff = now - mCbMapLastTime;
+    if (diff > s2ns(1)) {
+        uint32_t count = QCameraMemory::getCallbackMapCount();
+        mCbMapRate = (uint32_t)(((uint64_t)(count - mCbMapLastCount) *
+                (uint64_t)s2ns(1)) / (uint64_t)diff);
+        CDBG_HIGH("[KPI Perf] %s: PROFILE_PREVIEW_CB_MAPPINGS_PER_SECOND : %u",
+                __func__, mCbMapRate);
+        mCbMapLastTime = now;
+        mCbMapLastCount = count;
+    }
+}
+
+/*===========================================================================
+ * FUNCTION   : debugShowStartupLatency
+ *
+ * DESCRIPTION: Logs the time it took to get the first preview frame, both
+ *              from camera open and from start preview. The open to first
+ *              frame latency is only reported for the first preview after
+ *              the camera got opened.
+ *
+ * PARAMETERS : None
+ *
+ * RETURN     : None
+ *==========================================================================*/
+void QCamera2HardwareInterface::debugShowStartupLatency()
+{
+    nsecs_t now = systemTime();
+
+    if (0 < mStartPreviewTime) {
+        mStartToFirstFrame = now - mStartPreviewTime;
+        CDBG_HIGH("[KPI Perf] %s: PROFILE_START_PREVIEW_TO_FIRST_FRAME : %lld ms",
+                __func__, (long long)ns2ms(mStartToFirstFrame));
+        mStartPreviewTime = 0;
+    }
+
+    if (0 < mOpenTime) {
+        mOpenToFirstFrame = now - mOpenTime;
+        CDBG_HIGH("[KPI Perf] %s: PROFILE_OPEN_TO_FIRST_FRAME : %lld ms",
+                __func__, (long long)ns2ms(mOpenToFirstFrame));
+        mOpenTime = 0;
+    }
+}
+
 /*===========================================================================
  * FUNCTION   : ~QCameraCbNotifier
  *
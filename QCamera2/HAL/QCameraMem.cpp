@@ -36,6 +36,7 @@
 #include <utils/Errors.h>
 #include <utils/Trace.h>
 #include <utils/Log.h>
+#include <cutils/properties.h>
 #include <gralloc_priv.h>
 #include <QComOMXMetadata.h>
 #include "QCamera2HWI.h"
@@ -50,6 +51,8 @@ using namespace android;
 
 namespace qcamera {
 
+uint32_t QCameraMemory::sCbMapCount = 0;
+
 // QCaemra2Memory base class
 
 /*===========================================================================
@@ -71,6 +74,7 @@ QCameraMemory::QCameraMemory(bool cached,
 {
     mBufferCount = 0;
     memset(mMemInfo, 0, sizeof(mMemInfo));
+    memset(mCbMapping, 0, sizeof(mCbMapping));
 }
 
 /*===========================================================================
@@ -84,6 +88,7 @@ QCameraMemory::QCameraMemory(bool cached,
  *==========================================================================*/
 QCameraMemory::~QCameraMemory()
 {
+    releaseCallbackMappings();
 }
 
 /*===========================================================================
@@ -279,6 +284,166 @@ inline void QCameraMemory::traceLogAllocEnd(size_t size)
 #endif
 }
 
+/*===========================================================================
+ * FUNCTION   : getCallbackMemory
+ *
+ * DESCRIPTION: returns a framework mapping of the first @size bytes of a
+ *              buffer, for callbacks that must not expose the padding.
+ *              The mapping is created once per buffer and reused for
+ *              following frames as long as fd and size stay the same.
+ *
+ * PARAMETERS :
+ *   @index   : index of the buffer
+ *   @size    : number of bytes to map
+ *   @releaseData: [output] reference to be passed to releaseCallbackMemory
+ *              once the callback is done with the mapping
+ *
+ * RETURN     : camera memory ptr
+ *              NULL if not supported or failed
+ *==========================================================================*/
+camera_memory_t *QCameraMemory::getCallbackMemory(uint32_t index,
+        size_t size, void **releaseData)
+{
+    struct QCameraCbMapping *mapping = NULL;
+    int fd;
+
+    if ((index >= mBufferCount) || (NULL == releaseData)) {
+        ALOGE("%s: Invalid input, index %d of %d", __func__,
+                index, mBufferCount);
+        return NULL;
+    }
+
+    fd = mMemInfo[index].fd;
+    mapping = mCbMapping[index];
+    if ((NULL != mapping) &&
+            ((mapping->fd != fd) || (mapping->size != size))) {
+        mCbMapping[index] = NULL;
+        putCallbackMapping(mapping);
+        mapping = NULL;
+    }
+
+    if (NULL == mapping) {
+        mapping = (struct QCameraCbMapping *)malloc(sizeof(*mapping));
+        if (NULL == mapping) {
+            ALOGE("%s: No memory for callback mapping", __func__);
+            return NULL;
+        }
+        mapping->mem = mapCallbackMemory(fd, size);
+        if ((NULL == mapping->mem) || (NULL == mapping->mem->data)) {
+            ALOGE("%s: mapping buffer %d failed", __func__, index);
+            if (NULL != mapping->mem) {
+                mapping->mem->release(mapping->mem);
+            }
+            free(mapping);
+            return NULL;
+        }
+        mapping->fd = fd;
+        mapping->size = size;
+        mapping->refCnt = 1;
+        mCbMapping[index] = mapping;
+        __atomic_add_fetch(&sCbMapCount, 1, __ATOMIC_RELAXED);
+    }
+
+    __atomic_add_fetch(&mapping->refCnt, 1, __ATOMIC_RELAXED);
+    *releaseData = mapping;
+    return mapping->mem;
+}
+
+/*===========================================================================
+ * FUNCTION   : releaseCallbackMemory
+ *
+ * DESCRIPTION: drops the reference a callback holds on a mapping returned
+ *              by getCallbackMemory. Matches camera_release_callback.
+ *
+ * PARAMETERS :
+ *   @releaseData: reference returned by getCallbackMemory
+ *   @cookie  : context data
+ *   @cbStatus: callback status
+ *
+ * RETURN     : none
+ *==========================================================================*/
+void QCameraMemory::releaseCallbackMemory(void *releaseData,
+        void * /*cookie*/, int32_t /*cbStatus*/)
+{
+    if (NULL != releaseData) {
+        putCallbackMapping((struct QCameraCbMapping *)releaseData);
+    }
+}
+
+/*===========================================================================
+ * FUNCTION   : getCallbackMapCount
+ *
+ * DESCRIPTION: number of callback mappings created so far by all memory
+ *              objects of the process
+ *
+ * PARAMETERS : none
+ *
+ * RETURN     : mapping count
+ *==========================================================================*/
+uint32_t QCameraMemory::getCallbackMapCount()
+{
+    return __atomic_load_n(&sCbMapCount, __ATOMIC_RELAXED);
+}
+
+/*===========================================================================
+ * FUNCTION   : mapCallbackMemory
+ *
+ * DESCRIPTION: creates a framework mapping of part of a buffer. Memory
+ *              types not shared with the framework can not do this.
+ *
+ * PARAMETERS :
+ *   @fd      : buffer fd
+ *   @size    : number of bytes to map
+ *
+ * RETURN     : camera memory ptr
+ *              NULL if not supported or failed
+ *==========================================================================*/
+camera_memory_t *QCameraMemory::mapCallbackMemory(int /*fd*/,
+        size_t /*size*/)
+{
+    return NULL;
+}
+
+/*===========================================================================
+ * FUNCTION   : releaseCallbackMappings
+ *
+ * DESCRIPTION: drops the references of this memory object on its callback
+ *              mappings. Mappings still used by a callback are released
+ *              once the callback is done.
+ *
+ * PARAMETERS : none
+ *
+ * RETURN     : none
+ *==========================================================================*/
+void QCameraMemory::releaseCallbackMappings()
+{
+    for (int i = 0; i < MM_CAMERA_MAX_NUM_FRAMES; i++) {
+        if (NULL != mCbMapping[i]) {
+            putCallbackMapping(mCbMapping[i]);
+            mCbMapping[i] = NULL;
+        }
+    }
+}
+
+/*===========================================================================
+ * FUNCTION   : putCallbackMapping
+ *
+ * DESCRIPTION: drops one reference of a callback mapping and unmaps it
+ *              when it was the last one
+ *
+ * PARAMETERS :
+ *   @mapping : callback mapping
+ *
+ * RETURN     : none
+ *==========================================================================*/
+void QCameraMemory::putCallbackMapping(struct QCameraCbMapping *mapping)
+{
+    if (0 == __atomic_sub_fetch(&mapping->refCnt, 1, __ATOMIC_ACQ_REL)) {
+        mapping->mem->release(mapping->mem);
+        free(mapping);
+    }
+}
+
 /*===========================================================================
  * FUNCTION   : alloc
  *
@@ -426,6 +591,7 @@ int QCameraMemory::allocOneBuffer(QCameraMemInfo &memInfo,
     memInfo.size = alloc.len;
     memInfo.cached = cached;
     memInfo.heap_id = heap_id;
+    memInfo.is_secure = secure_mode;
 
     ALOGD("%s : ION buffer %lx with size %d allocated",
             __func__, (unsigned long)memInfo.handle, alloc.len);
@@ -481,7 +647,24 @@ void QCameraMemory::deallocOneBuffer(QCameraMemInfo &memInfo)
  * RETURN     : None
  *==========================================================================*/
 QCameraMemoryPool::QCameraMemoryPool()
+    : mLruHead(NULL),
+      mLruTail(NULL),
+      mCachedBytes(0)
 {
+    char prop[PROPERTY_VALUE_MAX];
+    int budgetMb;
+
+    memset(mBuckets, 0, sizeof(mBuckets));
+    memset(mStats, 0, sizeof(mStats));
+
+    memset(prop, 0, sizeof(prop));
+    property_get("persist.camera.mem.pool.budget", prop, "");
+    budgetMb = atoi(prop);
+    if (budgetMb <= 0) {
+        budgetMb = QCAMERA_MEM_POOL_DEFAULT_BUDGET_MB;
+    }
+    mBudget = (size_t)budgetMb << 20;
+
     pthread_mutex_init(&mLock, NULL);
 }
 
@@ -501,10 +684,191 @@ QCameraMemoryPool::~QCameraMemoryPool()
     pthread_mutex_destroy(&mLock);
 }
 
+/*===========================================================================
+ * FUNCTION   : alignedSize
+ *
+ * DESCRIPTION: size allocOneBuffer will actually allocate for a request
+ *
+ * PARAMETERS :
+ *   @size    : requested size
+ *   @is_secure: whether a secure buffer is requested
+ *
+ * RETURN     : page (or 1 MiB for secure buffers) aligned size
+ *==========================================================================*/
+size_t QCameraMemoryPool::alignedSize(size_t size, uint32_t is_secure)
+{
+    if (is_secure == SECURE) {
+        return (size + 1048575U) & (~1048575U);
+    }
+    return (size + 4095U) & (~4095U);
+}
+
+/*===========================================================================
+ * FUNCTION   : sizeClass
+ *
+ * DESCRIPTION: maps a buffer size to its bucket. Every power of two is
+ *              split into 2^QCAMERA_MEM_POOL_SUB_CLASS_BITS classes, so
+ *              the sizes within one bucket differ by at most 25%.
+ *
+ * PARAMETERS :
+ *   @size    : aligned buffer size
+ *
+ * RETURN     : size class index
+ *==========================================================================*/
+uint32_t QCameraMemoryPool::sizeClass(size_t size)
+{
+    uint32_t msb = QCAMERA_MEM_POOL_MIN_SHIFT;
+    uint32_t cls;
+
+    while ((msb < 31) && ((size >> (msb + 1)) != 0)) {
+        msb++;
+    }
+    cls = (msb - QCAMERA_MEM_POOL_MIN_SHIFT) << QCAMERA_MEM_POOL_SUB_CLASS_BITS;
+    cls |= (size >> (msb - QCAMERA_MEM_POOL_SUB_CLASS_BITS)) &
+            ((1U << QCAMERA_MEM_POOL_SUB_CLASS_BITS) - 1);
+    if (cls >= QCAMERA_MEM_POOL_NUM_CLASSES) {
+        cls = QCAMERA_MEM_POOL_NUM_CLASSES - 1;
+    }
+    return cls;
+}
+
+/*===========================================================================
+ * FUNCTION   : linkLocked
+ *
+ * DESCRIPTION: adds an idle buffer to its bucket and to the head of the LRU
+ *
+ * PARAMETERS :
+ *   @entry   : pool entry to link
+ *
+ * RETURN     : none
+ *==========================================================================*/
+void QCameraMemoryPool::linkLocked(PoolEntry *entry)
+{
+    PoolEntry **bucket = &mBuckets[entry->streamType][entry->sizeClass];
+
+    entry->bucketPrev = NULL;
+    entry->bucketNext = *bucket;
+    if (NULL != *bucket) {
+        (*bucket)->bucketPrev = entry;
+    }
+    *bucket = entry;
+
+    entry->lruPrev = NULL;
+    entry->lruNext = mLruHead;
+    if (NULL != mLruHead) {
+        mLruHead->lruPrev = entry;
+    } else {
+        mLruTail = entry;
+    }
+    mLruHead = entry;
+
+    mCachedBytes += entry->memInfo.size;
+    mStats[entry->streamType].cachedBytes += entry->memInfo.size;
+    mStats[entry->streamType].cachedCnt++;
+}
+
+/*===========================================================================
+ * FUNCTION   : unlinkLocked
+ *
+ * DESCRIPTION: removes an idle buffer from its bucket and from the LRU
+ *
+ * PARAMETERS :
+ *   @entry   : pool entry to unlink
+ *
+ * RETURN     : none
+ *==========================================================================*/
+void QCameraMemoryPool::unlinkLocked(PoolEntry *entry)
+{
+    if (NULL != entry->bucketPrev) {
+        entry->bucketPrev->bucketNext = entry->bucketNext;
+    } else {
+        mBuckets[entry->streamType][entry->sizeClass] = entry->bucketNext;
+    }
+    if (NULL != entry->bucketNext) {
+        entry->bucketNext->bucketPrev = entry->bucketPrev;
+    }
+
+    if (NULL != entry->lruPrev) {
+        entry->lruPrev->lruNext = entry->lruNext;
+    } else {
+        mLruHead = entry->lruNext;
+    }
+    if (NULL != entry->lruNext) {
+        entry->lruNext->lruPrev = entry->lruPrev;
+    } else {
+        mLruTail = entry->lruPrev;
+    }
+
+    mCachedBytes -= entry->memInfo.size;
+    mStats[entry->streamType].cachedBytes -= entry->memInfo.size;
+    mStats[entry->streamType].cachedCnt--;
+}
+
+/*===========================================================================
+ * FUNCTION   : trimLocked
+ *
+ * DESCRIPTION: frees least recently released buffers until the idle bytes
+ *              fit into the given budget
+ *
+ * PARAMETERS :
+ *   @budget  : number of idle bytes allowed to stay in the pool
+ *
+ * RETURN     : none
+ *==========================================================================*/
+void QCameraMemoryPool::trimLocked(size_t budget)
+{
+    while ((mCachedBytes > budget) && (NULL != mLruTail)) {
+        PoolEntry *entry = mLruTail;
+        unlinkLocked(entry);
+        mStats[entry->streamType].evictions++;
+        freeBuffer(entry->memInfo);
+        delete entry;
+    }
+}
+
+/*===========================================================================
+ * FUNCTION   : allocNewBuffer
+ *
+ * DESCRIPTION: allocates a new buffer when no cached one fits
+ *
+ * PARAMETERS :
+ *   @memInfo : reference to struct that stores additional memory allocation info
+ *   @heap_id : type of heap
+ *   @size    : size of the buffer
+ *   @cached  : whether the buffer should be cached
+ *   @is_secure: whether the buffer should be secure
+ *
+ * RETURN     : int32_t type of status
+ *              NO_ERROR  -- success
+ *              none-zero failure code
+ *==========================================================================*/
+int QCameraMemoryPool::allocNewBuffer(MemInfo &memInfo, unsigned int heap_id,
+        size_t size, bool cached, uint32_t is_secure)
+{
+    return QCameraMemory::allocOneBuffer(memInfo, heap_id, size, cached,
+            is_secure);
+}
+
+/*===========================================================================
+ * FUNCTION   : freeBuffer
+ *
+ * DESCRIPTION: frees a buffer that leaves the pool
+ *
+ * PARAMETERS :
+ *   @memInfo : reference to struct that stores additional memory allocation info
+ *
+ * RETURN     : none
+ *==========================================================================*/
+void QCameraMemoryPool::freeBuffer(MemInfo &memInfo)
+{
+    QCameraMemory::deallocOneBuffer(memInfo);
+}
+
 /*===========================================================================
  * FUNCTION   : releaseBuffer
  *
- * DESCRIPTION: release one cached buffers
+ * DESCRIPTION: release one cached buffers. Least recently released buffers
+ *              are freed once the pool holds more than its budget.
  *
  * PARAMETERS :
  *   @memInfo : reference to struct that stores additional memory allocation info
@@ -516,9 +880,30 @@ void QCameraMemoryPool::releaseBuffer(
         struct QCameraMemory::QCameraMemInfo &memInfo,
         cam_stream_type_t streamType)
 {
+    PoolEntry *entry = NULL;
+
     pthread_mutex_lock(&mLock);
 
-    mPools[streamType].push_back(memInfo);
+    if (memInfo.size > mBudget) {
+        mStats[streamType].evictions++;
+        freeBuffer(memInfo);
+        pthread_mutex_unlock(&mLock);
+        return;
+    }
+
+    entry = new PoolEntry;
+    if (NULL == entry) {
+        ALOGE("%s: No memory for pool entry", __func__);
+        freeBuffer(memInfo);
+        pthread_mutex_unlock(&mLock);
+        return;
+    }
+
+    entry->memInfo = memInfo;
+    entry->streamType = streamType;
+    entry->sizeClass = sizeClass(memInfo.size);
+    linkLocked(entry);
+    trimLocked(mBudget);
 
     pthread_mutex_unlock(&mLock);
 }
@@ -536,23 +921,129 @@ void QCameraMemoryPool::clear()
 {
     pthread_mutex_lock(&mLock);
 
-    for (int i = CAM_STREAM_TYPE_DEFAULT; i < CAM_STREAM_TYPE_MAX; i++ ) {
-        List<struct QCameraMemory::QCameraMemInfo>::iterator it;
-        it = mPools[i].begin();
-        for( ; it != mPools[i].end() ; it++) {
-            QCameraMemory::deallocOneBuffer(*it);
-        }
+    while (NULL != mLruTail) {
+        PoolEntry *entry = mLruTail;
+        unlinkLocked(entry);
+        freeBuffer(entry->memInfo);
+        delete entry;
+    }
+
+    pthread_mutex_unlock(&mLock);
+}
+
+/*===========================================================================
+ * FUNCTION   : setBudget
+ *
+ * DESCRIPTION: sets the number of idle bytes the pool may keep and trims
+ *              the pool down to it
+ *
+ * PARAMETERS :
+ *   @budget  : budget in bytes
+ *
+ * RETURN     : none
+ *==========================================================================*/
+void QCameraMemoryPool::setBudget(size_t budget)
+{
+    pthread_mutex_lock(&mLock);
+
+    mBudget = budget;
+    trimLocked(mBudget);
+
+    pthread_mutex_unlock(&mLock);
+}
+
+/*===========================================================================
+ * FUNCTION   : getBudget
+ *
+ * DESCRIPTION: returns the number of idle bytes the pool may keep
+ *
+ * PARAMETERS : none
+ *
+ * RETURN     : budget in bytes
+ *==========================================================================*/
+size_t QCameraMemoryPool::getBudget()
+{
+    size_t budget;
+
+    pthread_mutex_lock(&mLock);
+    budget = mBudget;
+    pthread_mutex_unlock(&mLock);
 
-        mPools[i].clear();
+    return budget;
+}
+
+/*===========================================================================
+ * FUNCTION   : getStats
+ *
+ * DESCRIPTION: returns the counters of one stream type
+ *
+ * PARAMETERS :
+ *   @streamType: type of stream
+ *   @stats   : [output] counters of the stream type
+ *
+ * RETURN     : none
+ *==========================================================================*/
+void QCameraMemoryPool::getStats(cam_stream_type_t streamType,
+        pool_stats_t &stats)
+{
+    pthread_mutex_lock(&mLock);
+    stats = mStats[streamType];
+    pthread_mutex_unlock(&mLock);
+}
+
+/*===========================================================================
+ * FUNCTION   : dump
+ *
+ * DESCRIPTION: Composes a string with the pool counters of every stream
+ *              type that used the pool
+ *
+ * PARAMETERS : none
+ *
+ * RETURN     : Formatted string
+ *==========================================================================*/
+String8 QCameraMemoryPool::dump()
+{
+    String8 str("\n");
+    char s[160];
+
+    pthread_mutex_lock(&mLock);
+
+    snprintf(s, sizeof(s), "Cached: %zu bytes, Budget: %zu bytes\n",
+            mCachedBytes, mBudget);
+    str += s;
+
+    for (int i = CAM_STREAM_TYPE_DEFAULT; i < CAM_STREAM_TYPE_MAX; i++) {
+        const pool_stats_t &st = mStats[i];
+        uint32_t total = st.hits + st.misses;
+
+        if ((0 == total) && (0 == st.cachedCnt)) {
+            continue;
+        }
+        snprintf(s, sizeof(s),
+                "Stream type %d: hits %u misses %u (%u%%) evictions %u "
+                "allocated %llu reused %llu cached %zu/%u\n",
+                i, st.hits, st.misses,
+                (0 == total) ? 0 : (st.hits * 100) / total,
+                st.evictions,
+                (unsigned long long)st.allocBytes,
+                (unsigned long long)st.reuseBytes,
+                st.cachedBytes, st.cachedCnt);
+        str += s;
     }
 
     pthread_mutex_unlock(&mLock);
+
+    return str;
 }
 
 /*===========================================================================
  * FUNCTION   : findBufferLocked
  *
- * DESCRIPTION: search for a appropriate cached buffer
+ * DESCRIPTION: search for the best fitting cached buffer. Buckets are
+ *              visited from the size class of the request upwards, so the
+ *              first bucket holding a fit contains the best fit. Buffers
+ *              more than QCAMERA_MEM_POOL_MAX_WASTE_RATIO times larger than
+ *              the request are not reused.
  *
  * PARAMETERS :
  *   @memInfo : reference to struct that stores additional memory allocation info
@@ -560,6 +1051,7 @@ void QCameraMemoryPool::clear()
  *   @size    : size of the buffer
  *   @cached  : whether the buffer should be cached
  *   @streaType: type of stream this buffer belongs to
+ *   @is_secure: whether the buffer should be secure
  *
  * RETURN     : int32_t type of status
  *              NO_ERROR  -- success
@@ -567,28 +1059,39 @@ void QCameraMemoryPool::clear()
  *==========================================================================*/
 int QCameraMemoryPool::findBufferLocked(
         struct QCameraMemory::QCameraMemInfo &memInfo, unsigned int heap_id,
-        size_t size, bool cached, cam_stream_type_t streamType)
+        size_t size, bool cached, cam_stream_type_t streamType,
+        uint32_t is_secure)
 {
-    int rc = NAME_NOT_FOUND;
-
-    if (mPools[streamType].empty()) {
-        return NAME_NOT_FOUND;
-    }
+    size_t minSize = alignedSize(size, is_secure);
+    size_t maxSize = minSize * QCAMERA_MEM_POOL_MAX_WASTE_RATIO;
+    uint32_t first = sizeClass(minSize);
+    uint32_t last = sizeClass(maxSize);
+
+    for (uint32_t cls = first; cls <= last; cls++) {
+        PoolEntry *best = NULL;
+        PoolEntry *entry = mBuckets[streamType][cls];
+
+        for ( ; NULL != entry; entry = entry->bucketNext) {
+            if ((entry->memInfo.size >= minSize) &&
+                (entry->memInfo.size <= maxSize) &&
+                (entry->memInfo.heap_id == heap_id) &&
+                (entry->memInfo.cached == cached) &&
+                (entry->memInfo.is_secure == is_secure) &&
+                ((NULL == best) ||
+                 (entry->memInfo.size < best->memInfo.size))) {
+                best = entry;
+            }
+        }
 
-    List<struct QCameraMemory::QCameraMemInfo>::iterator it;
-    it = mPools[streamType].begin();
-    for ( ; it != mPools[streamType].end() ; it++) {
-        if ( ((*it).size >= size) &&
-            ((*it).heap_id == heap_id) &&
-            ((*it).cached == cached) ) {
-            memInfo = *it;
-            mPools[streamType].erase(it);
-            rc = NO_ERROR;
-            break;
+        if (NULL != best) {
+            unlinkLocked(best);
+            memInfo = best->memInfo;
+            delete best;
+            return NO_ERROR;
         }
     }
 
-    return rc;
+    return NAME_NOT_FOUND;
 }
 
 /*===========================================================================
@@ -603,6 +1106,7 @@ int QCameraMemoryPool::findBufferLocked(
  *   @size    : size of the buffer
  *   @cached  : whether the buffer should be cached
  *   @streaType: type of stream this buffer belongs to
+ *   @secure_mode: whether the buffer should be secure
  *
  * RETURN     : int32_t type of status
  *              NO_ERROR  -- success
@@ -617,11 +1121,19 @@ int QCameraMemoryPool::allocateBuffer(
 
     pthread_mutex_lock(&mLock);
 
-    rc = findBufferLocked(memInfo, heap_id, size, cached, streamType);
+    rc = findBufferLocked(memInfo, heap_id, size, cached, streamType,
+            secure_mode);
     if (NAME_NOT_FOUND == rc ) {
-        ALOGE("%s : Buffer not found!", __func__);
-        rc = QCameraMemory::allocOneBuffer(memInfo, heap_id, size, cached,
-                 secure_mode);
+        CDBG_HIGH("%s : Buffer not found!", __func__);
+        rc = allocNewBuffer(memInfo, heap_id, size, cached, secure_mode);
+        if (NO_ERROR == rc) {
+            memInfo.is_secure = secure_mode;
+            mStats[streamType].misses++;
+            mStats[streamType].allocBytes += memInfo.size;
+        }
+    } else {
+        mStats[streamType].hits++;
+        mStats[streamType].reuseBytes += memInfo.size;
     }
 
     pthread_mutex_unlock(&mLock);
@@ -724,6 +1236,9 @@ int QCameraHeapMemory::allocate(uint8_t count, size_t size, uint32_t isSecure)
     }
     if (rc == 0) {
         mBufferCount = count;
+        for (int i = 0; i < count; i++) {
+            mBufIndex.add(mPtr[i], i);
+        }
     }
     traceLogAllocEnd((size * count));
     return OK;
@@ -767,6 +1282,9 @@ int QCameraHeapMemory::allocateMore(uint8_t count, size_t size)
             mPtr[i] = vaddr;
         }
     }
+    for (int i = mBufferCount; i < count + mBufferCount; i++) {
+        mBufIndex.add(mPtr[i], i);
+    }
     mBufferCount = (uint8_t)(mBufferCount + count);
     traceLogAllocEnd((size * count));
     return OK;
@@ -788,6 +1306,7 @@ void QCameraHeapMemory::deallocate()
         mPtr[i] = NULL;
     }
     dealloc();
+    mBufIndex.clear();
     mBufferCount = 0;
 }
 
@@ -860,17 +1379,10 @@ camera_memory_t *QCameraHeapMemory::getMemory(uint32_t /*index*/, bool /*metadat
 int QCameraHeapMemory::getMatchBufIndex(const void *opaque,
                                         bool metadata) const
 {
-    int index = -1;
     if (metadata) {
         return -1;
     }
-    for (int i = 0; i < mBufferCount; i++) {
-        if (mPtr[i] == opaque) {
-            index = i;
-            break;
-        }
-    }
-    return index;
+    return mBufIndex.find(opaque);
 }
 
 /*===========================================================================
@@ -935,6 +1447,9 @@ int QCameraStreamMemory::allocate(uint8_t count, size_t size, uint32_t isSecure)
             mCameraMemory[i] = 0;
         } else {
             mCameraMemory[i] = mGetMemory(mMemInfo[i].fd, mMemInfo[i].size, 1, this);
+            if (mCameraMemory[i]) {
+                mBufIndex.add(mCameraMemory[i]->data, i);
+            }
         }
     }
     mBufferCount = count;
@@ -965,6 +1480,9 @@ int QCameraStreamMemory::allocateMore(uint8_t count, size_t size)
 
     for (int i = mBufferCount; i < mBufferCount + count; i++) {
         mCameraMemory[i] = mGetMemory(mMemInfo[i].fd, mMemInfo[i].size, 1, this);
+        if (mCameraMemory[i]) {
+            mBufIndex.add(mCameraMemory[i]->data, i);
+        }
     }
     mBufferCount = (uint8_t)(mBufferCount + count);
     traceLogAllocEnd((size * count));
@@ -982,12 +1500,14 @@ int QCameraStreamMemory::allocateMore(uint8_t count, size_t size)
  *==========================================================================*/
 void QCameraStreamMemory::deallocate()
 {
+    releaseCallbackMappings();
     for (int i = 0; i < mBufferCount; i ++) {
         if (mCameraMemory[i])
             mCameraMemory[i]->release(mCameraMemory[i]);
         mCameraMemory[i] = NULL;
     }
     dealloc();
+    mBufIndex.clear();
     mBufferCount = 0;
 }
 
@@ -1065,17 +1585,10 @@ camera_memory_t *QCameraStreamMemory::getMemory(uint32_t index,
 int QCameraStreamMemory::getMatchBufIndex(const void *opaque,
                                           bool metadata) const
 {
-    int index = -1;
     if (metadata) {
         return -1;
     }
-    for (int i = 0; i < mBufferCount; i++) {
-        if (mCameraMemory[i]->data == opaque) {
-            index = i;
-            break;
-        }
-    }
-    return index;
+    return mBufIndex.find(opaque);
 }
 
 /*===========================================================================
@@ -1100,6 +1613,23 @@ void *QCameraStreamMemory::getPtr(uint32_t index) const
     return mCameraMemory[index]->data;
 }
 
+/*===========================================================================
+ * FUNCTION   : mapCallbackMemory
+ *
+ * DESCRIPTION: creates a framework mapping of part of a buffer
+ *
+ * PARAMETERS :
+ *   @fd      : buffer fd
+ *   @size    : number of bytes to map
+ *
+ * RETURN     : camera memory ptr
+ *              NULL if failed
+ *==========================================================================*/
+camera_memory_t *QCameraStreamMemory::mapCallbackMemory(int fd, size_t size)
+{
+    return mGetMemory(fd, size, 1, this);
+}
+
 /*===========================================================================
  * FUNCTION   : QCameraVideoMemory
  *
@@ -1172,6 +1702,9 @@ int QCameraVideoMemory::allocate(uint8_t count, size_t size, uint32_t isSecure)
         nh->data[2] = (int)mMemInfo[i].size;
         nh->data[3] = private_handle_t::PRIV_FLAGS_ITU_R_709;
     }
+    for (int i = 0; i < count; i ++) {
+        mMetaIndex.add(mMetadata[i]->data, i);
+    }
     mBufferCount = count;
     traceLogAllocEnd((size * count));
     return NO_ERROR;
@@ -1193,21 +1726,26 @@ int QCameraVideoMemory::allocate(uint8_t count, size_t size, uint32_t isSecure)
 int QCameraVideoMemory::allocateMore(uint8_t count, size_t size)
 {
     traceLogAllocStart(size, count, "VideoMemsize");
+    // the stream buffers are counted in by QCameraStreamMemory
+    uint8_t first = mBufferCount;
     int rc = QCameraStreamMemory::allocateMore(count, size);
     if (rc < 0)
         return rc;
 
-    for (int i = mBufferCount; i < count + mBufferCount; i ++) {
+    for (int i = first; i < count + first; i ++) {
         mMetadata[i] = mGetMemory(-1,
                 sizeof(struct encoder_media_buffer_type), 1, this);
         if (!mMetadata[i]) {
             ALOGE("allocation of video metadata failed.");
-            for (int j = mBufferCount; j <= i-1; j ++) {
-                mMetadata[j]->release(mMetadata[j]);
+            for (int j = first; j < count + first; j ++) {
+                if (j < i)
+                    mMetadata[j]->release(mMetadata[j]);
+                mBufIndex.remove(mCameraMemory[j]->data);
                 mCameraMemory[j]->release(mCameraMemory[j]);
                 mCameraMemory[j] = NULL;
                 deallocOneBuffer(mMemInfo[j]);;
             }
+            mBufferCount = first;
             return NO_MEMORY;
         }
         struct encoder_media_buffer_type * packet =
@@ -1219,7 +1757,10 @@ int QCameraVideoMemory::allocateMore(uint8_t count, size_t size)
         nh->data[1] = 0;
         nh->data[2] = (int)mMemInfo[i].size;
     }
-    mBufferCount = (uint8_t)(mBufferCount + count);
+    for (int i = first; i < count + first; i ++) {
+        mMetaIndex.add(mMetadata[i]->data, i);
+    }
+    mBufferCount = (uint8_t)(first + count);
     traceLogAllocEnd((size * count));
     return NO_ERROR;
 }
@@ -1255,6 +1796,7 @@ void QCameraVideoMemory::deallocate()
         mMetadata[i]->release(mMetadata[i]);
         mMetadata[i] = NULL;
     }
+    mMetaIndex.clear();
     QCameraStreamMemory::deallocate();
     mBufferCount = 0;
 }
@@ -1297,21 +1839,10 @@ camera_memory_t *QCameraVideoMemory::getMemory(uint32_t index,
 int QCameraVideoMemory::getMatchBufIndex(const void *opaque,
                                          bool metadata) const
 {
-    int index = -1;
-    for (int i = 0; i < mBufferCount; i++) {
-        if (metadata) {
-            if (mMetadata[i]->data == opaque) {
-                index = i;
-                break;
-            }
-        } else {
-            if (mCameraMemory[i]->data == opaque) {
-                index = i;
-                break;
-            }
-        }
+    if (metadata) {
+        return mMetaIndex.find(opaque);
     }
-    return index;
+    return mBufIndex.find(opaque);
 }
 
 /*===========================================================================
@@ -1413,15 +1944,12 @@ int QCameraGrallocMemory::displayBuffer(uint32_t index)
     int stride = 0;
     err = mWindow->dequeue_buffer(mWindow, &buffer_handle, &stride);
     if (err == NO_ERROR && buffer_handle != NULL) {
-        int i;
         CDBG("%s: dequed buf hdl =%p", __func__, *buffer_handle);
-        for(i = 0; i < mBufferCount; i++) {
-            if(mBufferHandle[i] == buffer_handle) {
-                CDBG("%s: Found buffer in idx:%d", __func__, i);
-                mLocalFlag[i] = BUFFER_OWNED;
-                dequeuedIdx = i;
-                break;
-            }
+        int i = mHandleIndex.find(buffer_handle);
+        if (i >= 0) {
+            CDBG("%s: Found buffer in idx:%d", __func__, i);
+            mLocalFlag[i] = BUFFER_OWNED;
+            dequeuedIdx = i;
         }
     } else {
         CDBG_HIGH("%s: dequeue_buffer, no free buffer from display now", __func__);
@@ -1597,6 +2125,12 @@ int QCameraGrallocMemory::allocate(uint8_t count, size_t /*size*/,
         mMemInfo[cnt].size = (size_t)mPrivateHandle[cnt]->size;
         mMemInfo[cnt].handle = ion_info_fd.handle;
     }
+    for (int i = 0; i < count; i++) {
+        if (mCameraMemory[i]) {
+            mBufIndex.add(mCameraMemory[i]->data, i);
+        }
+        mHandleIndex.add(mBufferHandle[i], i);
+    }
     mBufferCount = count;
 
     //Cancel min_undequeued_buffer buffers back to the window
@@ -1644,6 +2178,7 @@ void QCameraGrallocMemory::deallocate()
 {
     CDBG("%s: E ", __FUNCTION__);
 
+    releaseCallbackMappings();
     for (int cnt = 0; cnt < mBufferCount; cnt++) {
         mCameraMemory[cnt]->release(mCameraMemory[cnt]);
         struct ion_handle_data ion_handle;
@@ -1665,6 +2200,8 @@ void QCameraGrallocMemory::deallocate()
         mLocalFlag[cnt] = BUFFER_NOT_OWNED;
         CDBG_HIGH("put buffer %d successfully", cnt);
     }
+    mBufIndex.clear();
+    mHandleIndex.clear();
     mBufferCount = 0;
     CDBG(" %s : X ",__FUNCTION__);
 }
@@ -1746,17 +2283,10 @@ camera_memory_t *QCameraGrallocMemory::getMemory(uint32_t index,
 int QCameraGrallocMemory::getMatchBufIndex(const void *opaque,
                                            bool metadata) const
 {
-    int index = -1;
     if (metadata) {
         return -1;
     }
-    for (int i = 0; i < mBufferCount; i++) {
-        if (mCameraMemory[i]->data == opaque) {
-            index = i;
-            break;
-        }
-    }
-    return index;
+    return mBufIndex.find(opaque);
 }
 
 /*===========================================================================
@@ -1778,4 +2308,21 @@ void *QCameraGrallocMemory::getPtr(uint32_t index) const
     return mCameraMemory[index]->data;
 }
 
+/*===========================================================================
+ * FUNCTION   : mapCallbackMemory
+ *
+ * DESCRIPTION: creates a framework mapping of part of a buffer
+ *
+ * PARAMETERS :
+ *   @fd      : buffer fd
+ *   @size    : number of bytes to map
+ *
+ * RETURN     : camera memory ptr
+ *              NULL if failed
+ *==========================================================================*/
+camera_memory_t *QCameraGrallocMemory::mapCallbackMemory(int fd, size_t size)
+{
+    return mGetMemory(fd, size, 1, this);
+}
+
 }; //namespace qcamera
@@ -33,6 +33,8 @@
 #include <hardware/camera.h>
 #include <utils/Mutex.h>
 #include <utils/List.h>
+#include <utils/String8.h>
+#include "QCameraPtrIndex.h"
 
 extern "C" {
 #include <sys/types.h>
@@ -42,6 +44,9 @@ extern "C" {
 
 namespace qcamera {
 
+// every buffer of a stream has to fit in the pointer indexes below
+QCAMERA_PTR_INDEX_CHECK_CAPACITY(MM_CAMERA_MAX_NUM_FRAMES);
+
 class QCameraMemoryPool;
 
 // Base class for all memory types. Abstract.
@@ -85,10 +90,26 @@ public:
     void traceLogAllocStart(size_t size, int count, const char *allocName);
     void traceLogAllocEnd(size_t size);
 
+    camera_memory_t *getCallbackMemory(uint32_t index, size_t size,
+            void **releaseData);
+    static void releaseCallbackMemory(void *releaseData, void *cookie,
+            int32_t cbStatus);
+    static uint32_t getCallbackMapCount();
+
 protected:
 
     friend class QCameraMemoryPool;
 
+    // Framework mapping of the first bytes of a buffer, handed out with
+    // data callbacks. The memory object keeps one reference until the
+    // buffer is deallocated and every callback in flight holds one more.
+    struct QCameraCbMapping {
+        camera_memory_t *mem;
+        int fd;
+        size_t size;
+        int32_t refCnt;
+    };
+
     struct QCameraMemInfo {
         int fd;
         int main_ion_fd;
@@ -96,6 +117,7 @@ protected:
         size_t size;
         bool cached;
         unsigned int heap_id;
+        uint32_t is_secure;
     };
 
     int alloc(int count, size_t size, unsigned int heap_id,
@@ -105,14 +127,33 @@ protected:
             unsigned int heap_id, size_t size, bool cached, uint32_t is_secure);
     static void deallocOneBuffer(struct QCameraMemInfo &memInfo);
     int cacheOpsInternal(uint32_t index, unsigned int cmd, void *vaddr);
+    virtual camera_memory_t *mapCallbackMemory(int fd, size_t size);
+    void releaseCallbackMappings();
+    static void putCallbackMapping(struct QCameraCbMapping *mapping);
 
     bool m_bCached;
     uint8_t mBufferCount;
     struct QCameraMemInfo mMemInfo[MM_CAMERA_MAX_NUM_FRAMES];
     QCameraMemoryPool *mMemoryPool;
     cam_stream_type_t mStreamType;
+    struct QCameraCbMapping *mCbMapping[MM_CAMERA_MAX_NUM_FRAMES];
+    static uint32_t sCbMapCount;
+    // buffer pointer handed to the framework -> buffer index
+    QCameraPtrIndex mBufIndex;
 };
 
+// Number of size classes per power of two in QCameraMemoryPool
+#define QCAMERA_MEM_POOL_SUB_CLASS_BITS 2
+// Smallest buffer the pool tracks is one page (2^12)
+#define QCAMERA_MEM_POOL_MIN_SHIFT 12
+#define QCAMERA_MEM_POOL_NUM_CLASSES \
+    ((32 - QCAMERA_MEM_POOL_MIN_SHIFT) << QCAMERA_MEM_POOL_SUB_CLASS_BITS)
+// A cached buffer is reused only when it is at most this many times
+// larger than the request
+#define QCAMERA_MEM_POOL_MAX_WASTE_RATIO 2
+// Default limit of idle bytes held by the pool, in MB
+#define QCAMERA_MEM_POOL_DEFAULT_BUDGET_MB 256
+
 class QCameraMemoryPool {
 
 public:
@@ -126,14 +167,57 @@ public:
     void releaseBuffer(struct QCameraMemory::QCameraMemInfo &memInfo,
             cam_stream_type_t streamType);
     void clear();
+    void setBudget(size_t budget);
+    size_t getBudget();
+    android::String8 dump();
+
+    typedef struct {
+        uint32_t hits;          // requests served from cached buffers
+        uint32_t misses;        // requests that needed a new allocation
+        uint32_t evictions;     // cached buffers freed to honour the budget
+        uint64_t allocBytes;    // bytes of new allocations
+        uint64_t reuseBytes;    // bytes of reused buffers
+        size_t cachedBytes;     // bytes currently idle in the pool
+        uint32_t cachedCnt;     // buffers currently idle in the pool
+    } pool_stats_t;
+
+    void getStats(cam_stream_type_t streamType, pool_stats_t &stats);
 
 protected:
 
-    int findBufferLocked(struct QCameraMemory::QCameraMemInfo &memInfo,
-            unsigned int heap_id, size_t size, bool cached,
-            cam_stream_type_t streamType);
-
-    android::List<QCameraMemory::QCameraMemInfo> mPools[CAM_STREAM_TYPE_MAX];
+    typedef struct QCameraMemory::QCameraMemInfo MemInfo;
+
+    // Idle buffer, linked into its size class bucket and the pool LRU
+    typedef struct PoolEntry {
+        MemInfo memInfo;
+        cam_stream_type_t streamType;
+        uint32_t sizeClass;
+        struct PoolEntry *bucketPrev;
+        struct PoolEntry *bucketNext;
+        struct PoolEntry *lruPrev;
+        struct PoolEntry *lruNext;
+    } PoolEntry;
+
+    // Backend hooks, overridden by tests to avoid touching ion
+    virtual int allocNewBuffer(MemInfo &memInfo, unsigned int heap_id,
+            size_t size, bool cached, uint32_t is_secure);
+    virtual void freeBuffer(MemInfo &memInfo);
+
+    static size_t alignedSize(size_t size, uint32_t is_secure);
+    static uint32_t sizeClass(size_t size);
+    int findBufferLocked(MemInfo &memInfo, unsigned int heap_id,
+            size_t size, bool cached, cam_stream_type_t streamType,
+            uint32_t is_secure);
+    void linkLocked(PoolEntry *entry);
+    void unlinkLocked(PoolEntry *entry);
+    void trimLocked(size_t budget);
+
+    PoolEntry *mBuckets[CAM_STREAM_TYPE_MAX][QCAMERA_MEM_POOL_NUM_CLASSES];
+    PoolEntry *mLruHead;   // most recently released
+    PoolEntry *mLruTail;   // next to be evicted
+    size_t mCachedBytes;
+    size_t mBudget;
+    pool_stats_t mStats[CAM_STREAM_TYPE_MAX];
     pthread_mutex_t mLock;
 };
 
@@ -177,6 +261,8 @@ public:
     virtual void *getPtr(uint32_t index) const;
 
 protected:
+    virtual camera_memory_t *mapCallbackMemory(int fd, size_t size);
+
     camera_request_memory mGetMemory;
     camera_memory_t *mCameraMemory[MM_CAMERA_MAX_NUM_FRAMES];
 };
@@ -196,6 +282,7 @@ public:
 
 private:
     camera_memory_t *mMetadata[MM_CAMERA_MAX_NUM_FRAMES];
+    QCameraPtrIndex mMetaIndex;     // metadata pointer -> buffer index
 };
 ;
 
@@ -226,6 +313,9 @@ public:
     // Returns the buffer index of the dequeued buffer.
     int displayBuffer(uint32_t index);
 
+protected:
+    virtual camera_memory_t *mapCallbackMemory(int fd, size_t size);
+
 private:
     buffer_handle_t *mBufferHandle[MM_CAMERA_MAX_NUM_FRAMES];
     int mLocalFlag[MM_CAMERA_MAX_NUM_FRAMES];
@@ -235,6 +325,7 @@ private:
     camera_request_memory mGetMemory;
     camera_memory_t *mCameraMemory[MM_CAMERA_MAX_NUM_FRAMES];
     int mMinUndequeuedBuffers;
+    QCameraPtrIndex mHandleIndex;   // gralloc handle -> buffer index
 };
 
 }; // namespace qcamera
@@ -624,11 +624,238 @@ const QCameraParameters::QCameraMap<cam_cds_mode_type_t>
     { CDS_MODE_AUTO, CAM_CDS_MODE_AUTO}
 };
 
+// Parameter setters with the user keys each one reads. updateParameters
+// only runs an ON_CHANGE setter when one of its keys differs from the last
+// applied parameters, so a setter reading a new key must list it here.
+const QCameraParameters::param_setter_entry_t
+        QCameraParameters::PARAM_SETTERS[] = {
+    { &QCameraParameters::setPreviewSize, PARAM_SETTER_ON_CHANGE,
+        { KEY_PREVIEW_SIZE } },
+    { &QCameraParameters::setVideoSize, PARAM_SETTER_ON_CHANGE,
+        { KEY_VIDEO_SIZE, KEY_PREVIEW_SIZE } },
+    { &QCameraParameters::setPictureSize, PARAM_SETTER_ON_CHANGE,
+        { KEY_PICTURE_SIZE } },
+    { &QCameraParameters::setPreviewFormat, PARAM_SETTER_ON_CHANGE,
+        { KEY_PREVIEW_FORMAT } },
+    { &QCameraParameters::setPictureFormat, PARAM_SETTER_ON_CHANGE,
+        { KEY_PICTURE_FORMAT } },
+    { &QCameraParameters::setJpegQuality, PARAM_SETTER_ON_CHANGE,
+        { KEY_JPEG_QUALITY, KEY_JPEG_THUMBNAIL_QUALITY } },
+    { &QCameraParameters::setOrientation, PARAM_SETTER_ON_CHANGE,
+        { KEY_QC_ORIENTATION } },
+    { &QCameraParameters::setRotation, PARAM_SETTER_ON_CHANGE,
+        { KEY_ROTATION } },
+    { &QCameraParameters::setVideoRotation, PARAM_SETTER_ON_CHANGE,
+        { KEY_QC_VIDEO_ROTATION } },
+    { &QCameraParameters::setNoDisplayMode, PARAM_SETTER_ON_CHANGE,
+        { KEY_QC_NO_DISPLAY_MODE } },
+    { &QCameraParameters::setZslMode, PARAM_SETTER_ON_CHANGE,
+        { KEY_QC_ZSL } },
+    { &QCameraParameters::setZslAttributes, PARAM_SETTER_ON_CHANGE,
+        { KEY_QC_ZSL_BURST_INTERVAL, KEY_QC_ZSL_BURST_LOOKBACK,
+          KEY_QC_ZSL_QUEUE_DEPTH } },
+    { &QCameraParameters::setCameraMode, PARAM_SETTER_ON_CHANGE,
+        { KEY_QC_CAMERA_MODE } },
+    { &QCameraParameters::setSceneSelectionMode, PARAM_SETTER_ON_CHANGE,
+        { KEY_QC_SCENE_SELECTION } },
+    { &QCameraParameters::setRecordingHint, PARAM_SETTER_ON_CHANGE,
+        { KEY_RECORDING_HINT } },
+    { &QCameraParameters::setRdiMode, PARAM_SETTER_ON_CHANGE,
+        { KEY_QC_RDI_MODE } },
+    { &QCameraParameters::setSecureMode, PARAM_SETTER_ON_CHANGE,
+        { KEY_QC_SECURE_MODE } },
+    { &QCameraParameters::setPreviewFrameRate, PARAM_SETTER_ON_CHANGE,
+        { KEY_PREVIEW_FRAME_RATE } },
+    // fps range follows recording hint, HFR and thermal adjustments
+    { &QCameraParameters::setPreviewFpsRange, PARAM_SETTER_ALWAYS,
+        { NULL } },
+    { &QCameraParameters::setAutoExposure, PARAM_SETTER_ON_CHANGE,
+        { KEY_QC_AUTO_EXPOSURE } },
+    // effect is reapplied after scene mode transitions
+    { &QCameraParameters::setEffect, PARAM_SETTER_ALWAYS,
+        { NULL } },
+    { &QCameraParameters::setBrightness, PARAM_SETTER_ON_CHANGE,
+        { KEY_QC_BRIGHTNESS } },
+    { &QCameraParameters::setZoom, PARAM_SETTER_ON_CHANGE,
+        { KEY_ZOOM } },
+    { &QCameraParameters::setSharpness, PARAM_SETTER_ON_CHANGE,
+        { KEY_QC_SHARPNESS } },
+    { &QCameraParameters::setSaturation, PARAM_SETTER_ON_CHANGE,
+        { KEY_QC_SATURATION } },
+    { &QCameraParameters::setContrast, PARAM_SETTER_ON_CHANGE,
+        { KEY_QC_CONTRAST } },
+    { &QCameraParameters::setFocusMode, PARAM_SETTER_ON_CHANGE,
+        { KEY_FOCUS_MODE } },
+    { &QCameraParameters::setISOValue, PARAM_SETTER_ON_CHANGE,
+        { KEY_QC_ISO_MODE } },
+    { &QCameraParameters::setSkinToneEnhancement, PARAM_SETTER_ON_CHANGE,
+        { KEY_QC_SCE_FACTOR } },
+    { &QCameraParameters::setFlash, PARAM_SETTER_ON_CHANGE,
+        { KEY_FLASH_MODE } },
+    { &QCameraParameters::setAecLock, PARAM_SETTER_ON_CHANGE,
+        { KEY_AUTO_EXPOSURE_LOCK } },
+    { &QCameraParameters::setAwbLock, PARAM_SETTER_ON_CHANGE,
+        { KEY_AUTO_WHITEBALANCE_LOCK } },
+    { &QCameraParameters::setLensShadeValue, PARAM_SETTER_ON_CHANGE,
+        { KEY_QC_LENSSHADE } },
+    { &QCameraParameters::setMCEValue, PARAM_SETTER_ON_CHANGE,
+        { KEY_QC_MEMORY_COLOR_ENHANCEMENT } },
+    { &QCameraParameters::setDISValue, PARAM_SETTER_ON_CHANGE,
+        { KEY_QC_DIS } },
+    { &QCameraParameters::setAntibanding, PARAM_SETTER_ON_CHANGE,
+        { KEY_ANTIBANDING } },
+    { &QCameraParameters::setExposureCompensation, PARAM_SETTER_ON_CHANGE,
+        { KEY_EXPOSURE_COMPENSATION } },
+    { &QCameraParameters::setWhiteBalance, PARAM_SETTER_ON_CHANGE,
+        { KEY_WHITE_BALANCE } },
+    { &QCameraParameters::setSceneMode, PARAM_SETTER_ON_CHANGE,
+        { KEY_SCENE_MODE, KEY_QC_HDR_NEED_1X } },
+    { &QCameraParameters::setFocusAreas, PARAM_SETTER_ON_CHANGE,
+        { KEY_FOCUS_AREAS } },
+    { &QCameraParameters::setMeteringAreas, PARAM_SETTER_ON_CHANGE,
+        { KEY_METERING_AREAS } },
+    { &QCameraParameters::setSelectableZoneAf, PARAM_SETTER_ON_CHANGE,
+        { KEY_QC_SELECTABLE_ZONE_AF } },
+    { &QCameraParameters::setRedeyeReduction, PARAM_SETTER_ON_CHANGE,
+        { KEY_QC_REDEYE_REDUCTION } },
+    // bracketing follows HDR scene state detected at runtime
+    { &QCameraParameters::setAEBracket, PARAM_SETTER_ALWAYS,
+        { NULL } },
+    { &QCameraParameters::setAutoHDR, PARAM_SETTER_ON_CHANGE,
+        { KEY_QC_AUTO_HDR_ENABLE } },
+    { &QCameraParameters::setGpsLocation, PARAM_SETTER_ON_CHANGE,
+        { KEY_GPS_PROCESSING_METHOD, KEY_GPS_LATITUDE, KEY_QC_GPS_LATITUDE_REF,
+          KEY_GPS_LONGITUDE, KEY_QC_GPS_LONGITUDE_REF, KEY_QC_GPS_ALTITUDE_REF,
+          KEY_GPS_ALTITUDE, KEY_QC_GPS_STATUS, KEY_GPS_TIMESTAMP } },
+    { &QCameraParameters::setWaveletDenoise, PARAM_SETTER_ON_CHANGE,
+        { KEY_QC_DENOISE, KEY_PICTURE_FORMAT } },
+    { &QCameraParameters::setFaceRecognition, PARAM_SETTER_ON_CHANGE,
+        { KEY_QC_FACE_RECOGNITION, KEY_QC_MAX_NUM_REQUESTED_FACES } },
+    { &QCameraParameters::setFlip, PARAM_SETTER_ON_CHANGE,
+        { KEY_QC_PREVIEW_FLIP, KEY_QC_VIDEO_FLIP,
+          KEY_QC_SNAPSHOT_PICTURE_FLIP } },
+    { &QCameraParameters::setVideoHDR, PARAM_SETTER_ON_CHANGE,
+        { KEY_QC_VIDEO_HDR } },
+    { &QCameraParameters::setVtEnable, PARAM_SETTER_ON_CHANGE,
+        { KEY_QC_VT_ENABLE } },
+    { &QCameraParameters::setAFBracket, PARAM_SETTER_ON_CHANGE,
+        { KEY_QC_AF_BRACKET } },
+    { &QCameraParameters::setReFocus, PARAM_SETTER_ON_CHANGE,
+        { KEY_QC_RE_FOCUS } },
+    { &QCameraParameters::setChromaFlash, PARAM_SETTER_ON_CHANGE,
+        { KEY_QC_CHROMA_FLASH } },
+    { &QCameraParameters::setOptiZoom, PARAM_SETTER_ON_CHANGE,
+        { KEY_QC_OPTI_ZOOM } },
+    { &QCameraParameters::setBurstNum, PARAM_SETTER_ON_ADV_CHANGE,
+        { KEY_QC_SNAPSHOT_BURST_NUM } },
+    { &QCameraParameters::setBurstLEDOnPeriod, PARAM_SETTER_ON_CHANGE,
+        { KEY_QC_SNAPSHOT_BURST_LED_ON_PERIOD } },
+    { &QCameraParameters::setRetroActiveBurstNum, PARAM_SETTER_ON_CHANGE,
+        { KEY_QC_NUM_RETRO_BURST_PER_SHUTTER } },
+    { &QCameraParameters::setSnapshotFDReq, PARAM_SETTER_ON_CHANGE,
+        { KEY_QC_SNAPSHOT_FD_DATA } },
+    { &QCameraParameters::setTintlessValue, PARAM_SETTER_ON_CHANGE,
+        { KEY_QC_TINTLESS_ENABLE } },
+    { &QCameraParameters::setCDSMode, PARAM_SETTER_ON_CHANGE,
+        { KEY_QC_CDS_MODE } },
+    // update live snapshot size after all other parameters are set
+    { &QCameraParameters::setLiveSnapshotSize, PARAM_SETTER_ALWAYS,
+        { NULL } },
+    { &QCameraParameters::setJpegThumbnailSize, PARAM_SETTER_ALWAYS,
+        { NULL } },
+    { &QCameraParameters::setMobicat, PARAM_SETTER_FULL_ONLY,
+        { NULL } },
+    { &QCameraParameters::setLongshotParam, PARAM_SETTER_ON_CHANGE,
+        { KEY_QC_LONG_SHOT } },
+};
+
+#define PARAM_KEY_INDEX_SIZE 128
+
+QCameraParameters::param_key_index_t
+        QCameraParameters::PARAM_KEY_INDEX[PARAM_KEY_INDEX_SIZE];
+size_t QCameraParameters::PARAM_KEY_INDEX_CNT = 0;
+pthread_once_t QCameraParameters::PARAM_KEY_INDEX_ONCE = PTHREAD_ONCE_INIT;
+
 #define DEFAULT_CAMERA_AREA "(0, 0, 0, 0, 0)"
 #define DATA_PTR(MEM_OBJ,INDEX) MEM_OBJ->getPtr( INDEX )
 #define TOTAL_RAM_SIZE_512MB 536870912
 #define PARAM_MAP_SIZE(MAP) (sizeof(MAP)/sizeof(MAP[0]))
 
+// Indexes are built when the library is loaded, the maps above are
+// constant initialized by then.
+const QCameraNameLookup<QCameraParameters::QCameraMap<cam_auto_exposure_mode_type> >
+        QCameraParameters::AUTO_EXPOSURE_LOOKUP(
+        AUTO_EXPOSURE_MAP, PARAM_MAP_SIZE(AUTO_EXPOSURE_MAP));
+const QCameraNameLookup<QCameraParameters::QCameraMap<cam_format_t> >
+        QCameraParameters::PREVIEW_FORMATS_LOOKUP(
+        PREVIEW_FORMATS_MAP, PARAM_MAP_SIZE(PREVIEW_FORMATS_MAP));
+const QCameraNameLookup<QCameraParameters::QCameraMap<cam_format_t> >
+        QCameraParameters::PICTURE_TYPES_LOOKUP(
+        PICTURE_TYPES_MAP, PARAM_MAP_SIZE(PICTURE_TYPES_MAP));
+const QCameraNameLookup<QCameraParameters::QCameraMap<cam_focus_mode_type> >
+        QCameraParameters::FOCUS_MODES_LOOKUP(
+        FOCUS_MODES_MAP, PARAM_MAP_SIZE(FOCUS_MODES_MAP));
+const QCameraNameLookup<QCameraParameters::QCameraMap<cam_effect_mode_type> >
+        QCameraParameters::EFFECT_MODES_LOOKUP(
+        EFFECT_MODES_MAP, PARAM_MAP_SIZE(EFFECT_MODES_MAP));
+const QCameraNameLookup<QCameraParameters::QCameraMap<cam_scene_mode_type> >
+        QCameraParameters::SCENE_MODES_LOOKUP(
+        SCENE_MODES_MAP, PARAM_MAP_SIZE(SCENE_MODES_MAP));
+const QCameraNameLookup<QCameraParameters::QCameraMap<cam_flash_mode_t> >
+        QCameraParameters::FLASH_MODES_LOOKUP(
+        FLASH_MODES_MAP, PARAM_MAP_SIZE(FLASH_MODES_MAP));
+const QCameraNameLookup<QCameraParameters::QCameraMap<cam_focus_algorithm_type> >
+        QCameraParameters::FOCUS_ALGO_LOOKUP(
+        FOCUS_ALGO_MAP, PARAM_MAP_SIZE(FOCUS_ALGO_MAP));
+const QCameraNameLookup<QCameraParameters::QCameraMap<cam_wb_mode_type> >
+        QCameraParameters::WHITE_BALANCE_MODES_LOOKUP(
+        WHITE_BALANCE_MODES_MAP, PARAM_MAP_SIZE(WHITE_BALANCE_MODES_MAP));
+const QCameraNameLookup<QCameraParameters::QCameraMap<cam_antibanding_mode_type> >
+        QCameraParameters::ANTIBANDING_MODES_LOOKUP(
+        ANTIBANDING_MODES_MAP, PARAM_MAP_SIZE(ANTIBANDING_MODES_MAP));
+const QCameraNameLookup<QCameraParameters::QCameraMap<cam_iso_mode_type> >
+        QCameraParameters::ISO_MODES_LOOKUP(
+        ISO_MODES_MAP, PARAM_MAP_SIZE(ISO_MODES_MAP));
+const QCameraNameLookup<QCameraParameters::QCameraMap<cam_hfr_mode_t> >
+        QCameraParameters::HFR_MODES_LOOKUP(
+        HFR_MODES_MAP, PARAM_MAP_SIZE(HFR_MODES_MAP));
+const QCameraNameLookup<QCameraParameters::QCameraMap<cam_bracket_mode> >
+        QCameraParameters::BRACKETING_MODES_LOOKUP(
+        BRACKETING_MODES_MAP, PARAM_MAP_SIZE(BRACKETING_MODES_MAP));
+const QCameraNameLookup<QCameraParameters::QCameraMap<int> >
+        QCameraParameters::ON_OFF_MODES_LOOKUP(
+        ON_OFF_MODES_MAP, PARAM_MAP_SIZE(ON_OFF_MODES_MAP));
+const QCameraNameLookup<QCameraParameters::QCameraMap<int> >
+        QCameraParameters::ENABLE_DISABLE_MODES_LOOKUP(
+        ENABLE_DISABLE_MODES_MAP, PARAM_MAP_SIZE(ENABLE_DISABLE_MODES_MAP));
+const QCameraNameLookup<QCameraParameters::QCameraMap<int> >
+        QCameraParameters::DENOISE_ON_OFF_MODES_LOOKUP(
+        DENOISE_ON_OFF_MODES_MAP, PARAM_MAP_SIZE(DENOISE_ON_OFF_MODES_MAP));
+const QCameraNameLookup<QCameraParameters::QCameraMap<int> >
+        QCameraParameters::TRUE_FALSE_MODES_LOOKUP(
+        TRUE_FALSE_MODES_MAP, PARAM_MAP_SIZE(TRUE_FALSE_MODES_MAP));
+const QCameraNameLookup<QCameraParameters::QCameraMap<int> >
+        QCameraParameters::TOUCH_AF_AEC_MODES_LOOKUP(
+        TOUCH_AF_AEC_MODES_MAP, PARAM_MAP_SIZE(TOUCH_AF_AEC_MODES_MAP));
+const QCameraNameLookup<QCameraParameters::QCameraMap<cam_flip_t> >
+        QCameraParameters::FLIP_MODES_LOOKUP(
+        FLIP_MODES_MAP, PARAM_MAP_SIZE(FLIP_MODES_MAP));
+const QCameraNameLookup<QCameraParameters::QCameraMap<int> >
+        QCameraParameters::AF_BRACKETING_MODES_LOOKUP(
+        AF_BRACKETING_MODES_MAP, PARAM_MAP_SIZE(AF_BRACKETING_MODES_MAP));
+const QCameraNameLookup<QCameraParameters::QCameraMap<int> >
+        QCameraParameters::RE_FOCUS_MODES_LOOKUP(
+        RE_FOCUS_MODES_MAP, PARAM_MAP_SIZE(RE_FOCUS_MODES_MAP));
+const QCameraNameLookup<QCameraParameters::QCameraMap<int> >
+        QCameraParameters::CHROMA_FLASH_MODES_LOOKUP(
+        CHROMA_FLASH_MODES_MAP, PARAM_MAP_SIZE(CHROMA_FLASH_MODES_MAP));
+const QCameraNameLookup<QCameraParameters::QCameraMap<int> >
+        QCameraParameters::OPTI_ZOOM_MODES_LOOKUP(
+        OPTI_ZOOM_MODES_MAP, PARAM_MAP_SIZE(OPTI_ZOOM_MODES_MAP));
+const QCameraNameLookup<QCameraParameters::QCameraMap<cam_cds_mode_type_t> >
+        QCameraParameters::CDS_MODES_LOOKUP(
+        CDS_MODES_MAP, PARAM_MAP_SIZE(CDS_MODES_MAP));
+
 /*===========================================================================
  * FUNCTION   : QCameraParameters
  *
@@ -694,7 +921,9 @@ QCameraParameters::QCameraParameters()
       m_bAeBracketingEnabled(false),
       mFlashValue(CAM_FLASH_MODE_OFF),
       mFlashDaemonValue(CAM_FLASH_MODE_OFF),
-      mHfrMode(CAM_HFR_MODE_OFF)
+      mHfrMode(CAM_HFR_MODE_OFF),
+      m_bParamDiffEnabled(true),
+      m_bAdvCamFeaturesApplied(false)
 {
     char value[PROPERTY_VALUE_MAX];
     // TODO: may move to parameter instead of sysprop
@@ -715,6 +944,10 @@ QCameraParameters::QCameraParameters()
         m_ThermalMode = QCAMERA_THERMAL_ADJUST_FPS;
     }
 
+    // Setting to 0 runs every parameter setter on each updateParameters
+    property_get("persist.camera.param.diff", value, "1");
+    m_bParamDiffEnabled = atoi(value) > 0 ? true : false;
+
     memset(&m_LiveSnapshotSize, 0, sizeof(m_LiveSnapshotSize));
     memset(&m_default_fps_range, 0, sizeof(m_default_fps_range));
     memset(&m_hfrFpsRange, 0, sizeof(m_hfrFpsRange));
@@ -781,7 +1014,9 @@ QCameraParameters::QCameraParameters(const String8 &params)
     m_bAeBracketingEnabled(false),
     mFlashValue(CAM_FLASH_MODE_OFF),
     mFlashDaemonValue(CAM_FLASH_MODE_OFF),
-    mHfrMode(CAM_HFR_MODE_OFF)
+    mHfrMode(CAM_HFR_MODE_OFF),
+    m_bParamDiffEnabled(false),
+    m_bAdvCamFeaturesApplied(false)
 {
     memset(&m_LiveSnapshotSize, 0, sizeof(m_LiveSnapshotSize));
     memset(&m_default_fps_range, 0, sizeof(m_default_fps_range));
@@ -1078,23 +1313,16 @@ String8 QCameraParameters::createFpsRangeString(const cam_fps_range_t* fps,
  * DESCRIPTION: lookup a value by its name
  *
  * PARAMETERS :
- *   @attr    : map contains <name, value>
- *   @len     : size of the map
+ *   @map     : indexed map contains <name, value>
  *   @name    : name to be looked up
  *
  * RETURN     : valid value if found
  *              NAME_NOT_FOUND if not found
  *==========================================================================*/
-template <class mapType> int lookupAttr(const mapType *arr,
-        size_t len, const char *name)
+template <class mapType> int lookupAttr(const QCameraNameLookup<mapType> &map,
+        const char *name)
 {
-    if (name) {
-        for (size_t i = 0; i < len; i++) {
-            if (!strcmp(arr[i].desc, name))
-                return arr[i].val;
-        }
-    }
-    return NAME_NOT_FOUND;
+    return map.lookup(name);
 }
 
 /*===========================================================================
@@ -1103,21 +1331,15 @@ template <class mapType> int lookupAttr(const mapType *arr,
  * DESCRIPTION: lookup a name by its value
  *
  * PARAMETERS :
- *   @attr    : map contains <name, value>
- *   @len     : size of the map
+ *   @map     : indexed map contains <name, value>
  *   @value   : value to be looked up
  *
  * RETURN     : name str or NULL if not found
  *==========================================================================*/
-template <class mapType> const char *lookupNameByValue(const mapType *arr,
-        size_t len, int value)
+template <class mapType> const char *lookupNameByValue(
+        const QCameraNameLookup<mapType> &map, int value)
 {
-    for (size_t i = 0; i < len; i++) {
-        if (arr[i].val == value) {
-            return arr[i].desc;
-        }
-    }
-    return NULL;
+    return map.lookupName(value);
 }
 
 /*===========================================================================
@@ -1297,7 +1519,7 @@ int32_t QCameraParameters::setLiveSnapshotSize(const QCameraParameters& params)
     const char *hsrStr = params.get(KEY_QC_VIDEO_HIGH_SPEED_RECORDING);
 
     if (hsrStr != NULL && strcmp(hsrStr, "off")) {
-        int32_t value = lookupAttr(HFR_MODES_MAP, PARAM_MAP_SIZE(HFR_MODES_MAP), hsrStr);
+        int32_t value = lookupAttr(HFR_MODES_LOOKUP, hsrStr);
         for (size_t i = 0; i < m_pCapability->hfr_tbl_cnt; i++) {
             if (m_pCapability->hfr_tbl[i].mode == value) {
                 livesnapshot_sizes_tbl_cnt =
@@ -1310,7 +1532,7 @@ int32_t QCameraParameters::setLiveSnapshotSize(const QCameraParameters& params)
         }
     }
     else if (hfrStr != NULL && strcmp(hfrStr, "off")) {
-        int32_t value = lookupAttr(HFR_MODES_MAP, PARAM_MAP_SIZE(HFR_MODES_MAP), hfrStr);
+        int32_t value = lookupAttr(HFR_MODES_LOOKUP, hfrStr);
         if (value != NAME_NOT_FOUND) {
             // if HFR is enabled, change live snapshot size
             if (value > CAM_HFR_MODE_OFF) {
@@ -1408,8 +1630,7 @@ int32_t QCameraParameters::setRawSize(cam_dimension_t &dim)
 int32_t QCameraParameters::setPreviewFormat(const QCameraParameters& params)
 {
     const char *str = params.getPreviewFormat();
-    int32_t previewFormat = lookupAttr(PREVIEW_FORMATS_MAP,
-            PARAM_MAP_SIZE(PREVIEW_FORMATS_MAP), str);
+    int32_t previewFormat = lookupAttr(PREVIEW_FORMATS_LOOKUP, str);
     if (previewFormat != NAME_NOT_FOUND) {
         mPreviewFormat = (cam_format_t)previewFormat;
 
@@ -1436,7 +1657,7 @@ int32_t QCameraParameters::setPreviewFormat(const QCameraParameters& params)
 int32_t QCameraParameters::setPictureFormat(const QCameraParameters& params)
 {
     const char *str = params.getPictureFormat();
-    int32_t pictureFormat = lookupAttr(PICTURE_TYPES_MAP, PARAM_MAP_SIZE(PICTURE_TYPES_MAP), str);
+    int32_t pictureFormat = lookupAttr(PICTURE_TYPES_LOOKUP, str);
     if (pictureFormat != NAME_NOT_FOUND) {
         mPictureFormat = pictureFormat;
 
@@ -1817,12 +2038,12 @@ bool QCameraParameters::UpdateHFRFrameRate(const QCameraParameters& params)
 
     // check if HFR is enabled
     if (hfrStr != NULL && strcmp(hfrStr, "off")) {
-        hfrMode = lookupAttr(HFR_MODES_MAP, PARAM_MAP_SIZE(HFR_MODES_MAP), hfrStr);
+        hfrMode = lookupAttr(HFR_MODES_LOOKUP, hfrStr);
         if (NAME_NOT_FOUND != hfrMode) newHfrMode = hfrMode;
     }
     // check if HSR is enabled
     else if (hsrStr != NULL && strcmp(hsrStr, "off")) {
-        hfrMode = lookupAttr(HFR_MODES_MAP, PARAM_MAP_SIZE(HFR_MODES_MAP), hsrStr);
+        hfrMode = lookupAttr(HFR_MODES_LOOKUP, hsrStr);
         if (NAME_NOT_FOUND != hfrMode) newHfrMode = hfrMode;
     }
     ALOGE("%s: prevHfrMode - %d, currentHfrMode = %d ",
@@ -2639,8 +2860,7 @@ bool QCameraParameters::isAutoHDREnabled()
 {
     const char *str = get(KEY_QC_AUTO_HDR_ENABLE);
     if (str != NULL) {
-        int32_t value = lookupAttr(ENABLE_DISABLE_MODES_MAP,
-                PARAM_MAP_SIZE(ENABLE_DISABLE_MODES_MAP), str);
+        int32_t value = lookupAttr(ENABLE_DISABLE_MODES_LOOKUP, str);
         if (value == NAME_NOT_FOUND) {
             ALOGE("%s: Invalid Auto HDR value %s", __func__, str);
             return false;
@@ -3191,8 +3411,7 @@ int32_t QCameraParameters::setNumOfSnapshot()
 
     const char *bracket_str = get(KEY_QC_AE_BRACKET_HDR);
     if (bracket_str != NULL && strlen(bracket_str) > 0) {
-        int value = lookupAttr(BRACKETING_MODES_MAP, PARAM_MAP_SIZE(BRACKETING_MODES_MAP),
-                bracket_str);
+        int value = lookupAttr(BRACKETING_MODES_LOOKUP, bracket_str);
         switch (value) {
         case CAM_EXP_BRACKETING_ON:
             {
@@ -3247,8 +3466,7 @@ int32_t QCameraParameters::setRecordingHint(const QCameraParameters& params)
     const char *prev_str = get(KEY_RECORDING_HINT);
     if (str != NULL) {
         if (prev_str == NULL || strcmp(str, prev_str) != 0) {
-            int32_t value = lookupAttr(TRUE_FALSE_MODES_MAP, PARAM_MAP_SIZE(TRUE_FALSE_MODES_MAP),
-                    str);
+            int32_t value = lookupAttr(TRUE_FALSE_MODES_LOOKUP, str);
             if(value != NAME_NOT_FOUND){
                 updateParamEntry(KEY_RECORDING_HINT, str);
                 setRecordingHintValue(value);
@@ -3313,8 +3531,7 @@ int32_t QCameraParameters::setZslMode(const QCameraParameters& params)
 
     if (str_val != NULL) {
         if (prev_val == NULL || strcmp(str_val, prev_val) != 0) {
-            int32_t value = lookupAttr(ON_OFF_MODES_MAP, PARAM_MAP_SIZE(ON_OFF_MODES_MAP),
-                    str_val);
+            int32_t value = lookupAttr(ON_OFF_MODES_LOOKUP, str_val);
             if (value != NAME_NOT_FOUND) {
                 set(KEY_QC_ZSL, str_val);
                 m_bZslMode_new = (value > 0)? true : false;
@@ -3350,8 +3567,7 @@ int32_t QCameraParameters::setZslMode(const QCameraParameters& params)
 int32_t QCameraParameters::setWaveletDenoise(const QCameraParameters& params)
 {
     const char *str_pf = params.getPictureFormat();
-    int32_t pictureFormat = lookupAttr(PICTURE_TYPES_MAP, PARAM_MAP_SIZE(PICTURE_TYPES_MAP),
-            str_pf);
+    int32_t pictureFormat = lookupAttr(PICTURE_TYPES_LOOKUP, str_pf);
     if (pictureFormat != NAME_NOT_FOUND) {
         if (CAM_FORMAT_YUV_422_NV16 == pictureFormat) {
             ALOGE("NV16 format isn't supported in denoise lib!");
@@ -3410,8 +3626,7 @@ int32_t QCameraParameters::setSceneSelectionMode(const QCameraParameters& params
     const char *prev_str = get(KEY_QC_SCENE_SELECTION);
     if (NULL != str) {
         if ((NULL == prev_str) || (strcmp(str, prev_str) != 0)) {
-                int32_t value = lookupAttr(ENABLE_DISABLE_MODES_MAP,
-                        PARAM_MAP_SIZE(ENABLE_DISABLE_MODES_MAP), str);
+                int32_t value = lookupAttr(ENABLE_DISABLE_MODES_LOOKUP, str);
             if (value != NAME_NOT_FOUND) {
                 ALOGD("%s: Setting selection value %s", __func__, str);
                 if (value && m_bZslMode_new) {
@@ -3608,7 +3823,7 @@ int32_t QCameraParameters::setFlip(const QCameraParameters& params)
     const char *prev_val = get(KEY_QC_PREVIEW_FLIP);
     if(str != NULL){
         if (prev_val == NULL || strcmp(str, prev_val) != 0) {
-            int32_t value = lookupAttr(FLIP_MODES_MAP, PARAM_MAP_SIZE(FLIP_MODES_MAP), str);
+            int32_t value = lookupAttr(FLIP_MODES_LOOKUP, str);
             if(value != NAME_NOT_FOUND){
                 set(KEY_QC_PREVIEW_FLIP, str);
                 m_bPreviewFlipChanged = true;
@@ -3621,7 +3836,7 @@ int32_t QCameraParameters::setFlip(const QCameraParameters& params)
     prev_val = get(KEY_QC_VIDEO_FLIP);
     if(str != NULL){
         if (prev_val == NULL || strcmp(str, prev_val) != 0) {
-            int32_t value = lookupAttr(FLIP_MODES_MAP, PARAM_MAP_SIZE(FLIP_MODES_MAP), str);
+            int32_t value = lookupAttr(FLIP_MODES_LOOKUP, str);
             if(value != NAME_NOT_FOUND){
                 set(KEY_QC_VIDEO_FLIP, str);
                 m_bVideoFlipChanged = true;
@@ -3634,7 +3849,7 @@ int32_t QCameraParameters::setFlip(const QCameraParameters& params)
     prev_val = get(KEY_QC_SNAPSHOT_PICTURE_FLIP);
     if(str != NULL){
         if (prev_val == NULL || strcmp(str, prev_val) != 0) {
-            int32_t value = lookupAttr(FLIP_MODES_MAP, PARAM_MAP_SIZE(FLIP_MODES_MAP), str);
+            int32_t value = lookupAttr(FLIP_MODES_LOOKUP, str);
             if(value != NAME_NOT_FOUND){
                 set(KEY_QC_SNAPSHOT_PICTURE_FLIP, str);
                 m_bSnapshotFlipChanged = true;
@@ -3787,10 +4002,215 @@ int32_t QCameraParameters::setLongshotParam(const QCameraParameters& params)
     return NO_ERROR;
 }
 
+/*===========================================================================
+ * FUNCTION   : compareParamKeyIndex
+ *
+ * DESCRIPTION: qsort comparator ordering key index entries the same way
+ *              as the keys of flattened parameters
+ *
+ * PARAMETERS :
+ *   @a       : first param_key_index_t entry
+ *   @b       : second param_key_index_t entry
+ *
+ * RETURN     : <0, 0 or >0 as for strcmp
+ *==========================================================================*/
+int QCameraParameters::compareParamKeyIndex(const void *a, const void *b)
+{
+    const param_key_index_t *lhs = (const param_key_index_t *)a;
+    const param_key_index_t *rhs = (const param_key_index_t *)b;
+    int rc = strcmp(lhs->key, rhs->key);
+    if (rc == 0) {
+        rc = (int)lhs->setterIdx - (int)rhs->setterIdx;
+    }
+    return rc;
+}
+
+/*===========================================================================
+ * FUNCTION   : buildParamKeyIndex
+ *
+ * DESCRIPTION: build the sorted key to setter index from PARAM_SETTERS.
+ *              Called once through pthread_once.
+ *
+ * PARAMETERS : none
+ *
+ * RETURN     : none
+ *==========================================================================*/
+void QCameraParameters::buildParamKeyIndex()
+{
+    size_t cnt = 0;
+    for (size_t i = 0; i < PARAM_MAP_SIZE(PARAM_SETTERS); i++) {
+        for (size_t k = 0; k < PARAM_SETTER_MAX_KEYS; k++) {
+            const char *key = PARAM_SETTERS[i].keys[k];
+            if (key == NULL) {
+                break;
+            }
+            if (cnt >= PARAM_KEY_INDEX_SIZE) {
+                ALOGE("%s: key index full, parameter diff disabled", __func__);
+                PARAM_KEY_INDEX_CNT = 0;
+                return;
+            }
+            PARAM_KEY_INDEX[cnt].key = key;
+            PARAM_KEY_INDEX[cnt].len = strlen(key);
+            PARAM_KEY_INDEX[cnt].setterIdx = (uint8_t)i;
+            cnt++;
+        }
+    }
+    qsort(PARAM_KEY_INDEX, cnt, sizeof(param_key_index_t),
+            compareParamKeyIndex);
+    PARAM_KEY_INDEX_CNT = cnt;
+}
+
+/*===========================================================================
+ * FUNCTION   : compareParamKey
+ *
+ * DESCRIPTION: compare two keys that are not NUL terminated
+ *
+ * PARAMETERS :
+ *   @a       : first key
+ *   @alen    : length of first key
+ *   @b       : second key
+ *   @blen    : length of second key
+ *
+ * RETURN     : <0, 0 or >0 as for strcmp
+ *==========================================================================*/
+static int compareParamKey(const char *a, size_t alen,
+        const char *b, size_t blen)
+{
+    int rc = memcmp(a, b, (alen < blen) ? alen : blen);
+    if (rc == 0) {
+        rc = (alen < blen) ? -1 : ((alen > blen) ? 1 : 0);
+    }
+    return rc;
+}
+
+/*===========================================================================
+ * FUNCTION   : nextParamPair
+ *
+ * DESCRIPTION: split the next "key=value" pair off flattened parameters
+ *
+ * PARAMETERS :
+ *   @p       : current position in the flattened string
+ *   @key     : [output] start of the key
+ *   @keyLen  : [output] length of the key
+ *   @val     : [output] start of the value
+ *   @valLen  : [output] length of the value
+ *
+ * RETURN     : position of the following pair, NULL when none is left
+ *==========================================================================*/
+static const char *nextParamPair(const char *p, const char **key,
+        size_t *keyLen, const char **val, size_t *valLen)
+{
+    while (p != NULL && *p != '\0') {
+        const char *end = strchr(p, ';');
+        size_t len = (end != NULL) ? (size_t)(end - p) : strlen(p);
+        const char *eq = (const char *)memchr(p, '=', len);
+        const char *next = (end != NULL) ? end + 1 : p + len;
+        if (eq != NULL) {
+            *key = p;
+            *keyLen = (size_t)(eq - p);
+            *val = eq + 1;
+            *valLen = len - *keyLen - 1;
+            return next;
+        }
+        p = next;
+    }
+    return NULL;
+}
+
+/*===========================================================================
+ * FUNCTION   : markParamKeyDirty
+ *
+ * DESCRIPTION: mark every setter reading the given key as dirty
+ *
+ * PARAMETERS :
+ *   @key     : key, not NUL terminated
+ *   @len     : length of the key
+ *   @dirty   : per setter dirty flags, indexed like PARAM_SETTERS
+ *
+ * RETURN     : none
+ *==========================================================================*/
+void QCameraParameters::markParamKeyDirty(const char *key, size_t len,
+        bool *dirty)
+{
+    size_t lo = 0;
+    size_t hi = PARAM_KEY_INDEX_CNT;
+    while (lo < hi) {
+        size_t mid = (lo + hi) / 2;
+        if (compareParamKey(PARAM_KEY_INDEX[mid].key,
+                PARAM_KEY_INDEX[mid].len, key, len) < 0) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    for (; lo < PARAM_KEY_INDEX_CNT; lo++) {
+        if (compareParamKey(PARAM_KEY_INDEX[lo].key,
+                PARAM_KEY_INDEX[lo].len, key, len) != 0) {
+            break;
+        }
+        dirty[PARAM_KEY_INDEX[lo].setterIdx] = true;
+    }
+}
+
+/*===========================================================================
+ * FUNCTION   : markChangedParamKeys
+ *
+ * DESCRIPTION: walk two flattened parameter sets side by side and mark
+ *              the setters of keys whose values differ. Flattened
+ *              parameters come out of a sorted map, so one merge pass
+ *              covers both sets.
+ *
+ * PARAMETERS :
+ *   @params  : flattened parameters being applied
+ *   @ref     : flattened parameters to compare against
+ *   @markRemoved : also mark keys that are only present in @ref
+ *   @dirty   : per setter dirty flags, indexed like PARAM_SETTERS
+ *
+ * RETURN     : none
+ *==========================================================================*/
+void QCameraParameters::markChangedParamKeys(const char *params,
+        const char *ref, bool markRemoved, bool *dirty)
+{
+    const char *pKey = NULL, *pVal = NULL, *rKey = NULL, *rVal = NULL;
+    size_t pKeyLen = 0, pValLen = 0, rKeyLen = 0, rValLen = 0;
+
+    params = nextParamPair(params, &pKey, &pKeyLen, &pVal, &pValLen);
+    ref = nextParamPair(ref, &rKey, &rKeyLen, &rVal, &rValLen);
+    while (params != NULL || ref != NULL) {
+        int rc;
+        if (params == NULL) {
+            rc = 1;
+        } else if (ref == NULL) {
+            rc = -1;
+        } else {
+            rc = compareParamKey(pKey, pKeyLen, rKey, rKeyLen);
+        }
+
+        if (rc < 0) {
+            markParamKeyDirty(pKey, pKeyLen, dirty);
+            params = nextParamPair(params, &pKey, &pKeyLen, &pVal, &pValLen);
+        } else if (rc > 0) {
+            if (markRemoved) {
+                markParamKeyDirty(rKey, rKeyLen, dirty);
+            }
+            ref = nextParamPair(ref, &rKey, &rKeyLen, &rVal, &rValLen);
+        } else {
+            if (pValLen != rValLen || memcmp(pVal, rVal, pValLen) != 0) {
+                markParamKeyDirty(pKey, pKeyLen, dirty);
+            }
+            params = nextParamPair(params, &pKey, &pKeyLen, &pVal, &pValLen);
+            ref = nextParamPair(ref, &rKey, &rKeyLen, &rVal, &rValLen);
+        }
+    }
+}
+
 /*===========================================================================
  * FUNCTION   : updateParameters
  *
- * DESCRIPTION: update parameters from user setting
+ * DESCRIPTION: update parameters from user setting. Only setters whose
+ *              keys changed since the last successful update are run,
+ *              unless a full update is needed (first update, previous
+ *              update failed or persist.camera.param.diff is 0).
  *
  * PARAMETERS :
  *   @params  : user setting parameters
@@ -3805,85 +4225,71 @@ int32_t QCameraParameters::updateParameters(QCameraParameters& params,
 {
     int32_t final_rc = NO_ERROR;
     int32_t rc;
+    bool dirty[PARAM_MAP_SIZE(PARAM_SETTERS)];
+    bool fullUpdate;
+    int numRun = 0;
+    String8 paramsFlat = params.flatten();
     m_bNeedRestart = false;
 
+    pthread_once(&PARAM_KEY_INDEX_ONCE, buildParamKeyIndex);
+    fullUpdate = !m_bParamDiffEnabled || m_LastParamsFlat.isEmpty() ||
+            (PARAM_KEY_INDEX_CNT == 0);
+    memset(dirty, fullUpdate, sizeof(dirty));
+    if (!fullUpdate) {
+        // keys changed by the user, and keys where the user value
+        // differs from what the HAL currently reports
+        String8 currentFlat = flatten();
+        markChangedParamKeys(paramsFlat.string(), m_LastParamsFlat.string(),
+                true, dirty);
+        markChangedParamKeys(paramsFlat.string(), currentFlat.string(),
+                false, dirty);
+    }
+
     if(initBatchUpdate(m_pParamBuf) < 0 ) {
         ALOGE("%s:Failed to initialize group update table",__func__);
-        rc = BAD_TYPE;
+        final_rc = BAD_TYPE;
         goto UPDATE_PARAM_DONE;
     }
 
-    if ((rc = setPreviewSize(params)))                  final_rc = rc;
-    if ((rc = setVideoSize(params)))                    final_rc = rc;
-    if ((rc = setPictureSize(params)))                  final_rc = rc;
-    if ((rc = setPreviewFormat(params)))                final_rc = rc;
-    if ((rc = setPictureFormat(params)))                final_rc = rc;
-    if ((rc = setJpegQuality(params)))                  final_rc = rc;
-    if ((rc = setOrientation(params)))                  final_rc = rc;
-    if ((rc = setRotation(params)))                     final_rc = rc;
-    if ((rc = setVideoRotation(params)))                final_rc = rc;
-    if ((rc = setNoDisplayMode(params)))                final_rc = rc;
-    if ((rc = setZslMode(params)))                      final_rc = rc;
-    if ((rc = setZslAttributes(params)))                final_rc = rc;
-    if ((rc = setCameraMode(params)))                   final_rc = rc;
-    if ((rc = setSceneSelectionMode(params)))           final_rc = rc;
-    if ((rc = setRecordingHint(params)))                final_rc = rc;
-    if ((rc = setRdiMode(params)))                      final_rc = rc;
-    if ((rc = setSecureMode(params)))                   final_rc = rc;
-    if ((rc = setPreviewFrameRate(params)))             final_rc = rc;
-    if ((rc = setPreviewFpsRange(params)))              final_rc = rc;
-    if ((rc = setAutoExposure(params)))                 final_rc = rc;
-    if ((rc = setEffect(params)))                       final_rc = rc;
-    if ((rc = setBrightness(params)))                   final_rc = rc;
-    if ((rc = setZoom(params)))                         final_rc = rc;
-    if ((rc = setSharpness(params)))                    final_rc = rc;
-    if ((rc = setSaturation(params)))                   final_rc = rc;
-    if ((rc = setContrast(params)))                     final_rc = rc;
-    if ((rc = setFocusMode(params)))                    final_rc = rc;
-    if ((rc = setISOValue(params)))                     final_rc = rc;
-    if ((rc = setSkinToneEnhancement(params)))          final_rc = rc;
-    if ((rc = setFlash(params)))                        final_rc = rc;
-    if ((rc = setAecLock(params)))                      final_rc = rc;
-    if ((rc = setAwbLock(params)))                      final_rc = rc;
-    if ((rc = setLensShadeValue(params)))               final_rc = rc;
-    if ((rc = setMCEValue(params)))                     final_rc = rc;
-    if ((rc = setDISValue(params)))                     final_rc = rc;
-    if ((rc = setAntibanding(params)))                  final_rc = rc;
-    if ((rc = setExposureCompensation(params)))         final_rc = rc;
-    if ((rc = setWhiteBalance(params)))                 final_rc = rc;
-    if ((rc = setSceneMode(params)))                    final_rc = rc;
-    if ((rc = setFocusAreas(params)))                   final_rc = rc;
-    if ((rc = setMeteringAreas(params)))                final_rc = rc;
-    if ((rc = setSelectableZoneAf(params)))             final_rc = rc;
-    if ((rc = setRedeyeReduction(params)))              final_rc = rc;
-    if ((rc = setAEBracket(params)))                    final_rc = rc;
-    if ((rc = setAutoHDR(params)))                      final_rc = rc;
-    if ((rc = setGpsLocation(params)))                  final_rc = rc;
-    if ((rc = setWaveletDenoise(params)))               final_rc = rc;
-    if ((rc = setFaceRecognition(params)))              final_rc = rc;
-    if ((rc = setFlip(params)))                         final_rc = rc;
-    if ((rc = setVideoHDR(params)))                     final_rc = rc;
-    if ((rc = setVtEnable(params)))                     final_rc = rc;
-    if ((rc = setAFBracket(params)))                    final_rc = rc;
-    if ((rc = setReFocus(params)))                      final_rc = rc;
-    if ((rc = setChromaFlash(params)))                  final_rc = rc;
-    if ((rc = setOptiZoom(params)))                     final_rc = rc;
-    if ((rc = setBurstNum(params)))                     final_rc = rc;
-    if ((rc = setBurstLEDOnPeriod(params)))             final_rc = rc;
-    if ((rc = setRetroActiveBurstNum(params)))          final_rc = rc;
-    if ((rc = setSnapshotFDReq(params)))                final_rc = rc;
-    if ((rc = setTintlessValue(params)))                final_rc = rc;
-    if ((rc = setCDSMode(params)))                      final_rc = rc;
+    for (size_t i = 0; i < PARAM_MAP_SIZE(PARAM_SETTERS); i++) {
+        bool run = dirty[i];
+        switch (PARAM_SETTERS[i].policy) {
+        case PARAM_SETTER_ALWAYS:
+            run = true;
+            break;
+        case PARAM_SETTER_FULL_ONLY:
+            run = fullUpdate;
+            break;
+        case PARAM_SETTER_ON_ADV_CHANGE:
+            run = run || (isAdvCamFeaturesEnabled() != m_bAdvCamFeaturesApplied);
+            m_bAdvCamFeaturesApplied = isAdvCamFeaturesEnabled();
+            break;
+        case PARAM_SETTER_ON_CHANGE:
+        default:
+            break;
+        }
+        if (run) {
+            numRun++;
+            if ((rc = (this->*PARAM_SETTERS[i].setter)(params))) final_rc = rc;
+        }
+    }
 
-    // update live snapshot size after all other parameters are set
-    if ((rc = setLiveSnapshotSize(params)))             final_rc = rc;
-    if ((rc = setJpegThumbnailSize(params)))            final_rc = rc;
-    if ((rc = setStatsDebugMask()))                     final_rc = rc;
-    if ((rc = setPAAF()))                               final_rc = rc;
-    if ((rc = setMobicat(params)))                      final_rc = rc;
-    if ((rc = setLongshotParam(params)))                final_rc = rc;
+    if (fullUpdate) {
+        if ((rc = setStatsDebugMask()))                 final_rc = rc;
+        if ((rc = setPAAF()))                           final_rc = rc;
+    }
     if ((rc = updateFlash(false)))                      final_rc = rc;
+
+    CDBG("%s: %s update ran %d of %d setters", __func__,
+            fullUpdate ? "full" : "diff", numRun,
+            (int)PARAM_MAP_SIZE(PARAM_SETTERS));
 UPDATE_PARAM_DONE:
+    // a failed update is applied in full next time
+    if (final_rc == NO_ERROR) {
+        m_LastParamsFlat = paramsFlat;
+    } else {
+        m_LastParamsFlat.clear();
+    }
     needRestart = m_bNeedRestart;
     return final_rc;
 }
@@ -4119,8 +4525,7 @@ int32_t QCameraParameters::initDefaultParameters()
         set(KEY_SUPPORTED_FOCUS_MODES, focusModeValues);
 
         // Set default focus mode and update corresponding parameter buf
-        const char *focusMode = lookupNameByValue(FOCUS_MODES_MAP,
-                PARAM_MAP_SIZE(FOCUS_MODES_MAP),
+        const char *focusMode = lookupNameByValue(FOCUS_MODES_LOOKUP,
                 m_pCapability->supported_focus_modes[0]);
         if (focusMode != NULL) {
             setFocusMode(focusMode);
@@ -4562,6 +4967,8 @@ int32_t QCameraParameters::init(cam_capability_t *capabilities,
         goto TRANS_INIT_ERROR2;
     }
     m_pParamBuf = (parm_buffer_t*) DATA_PTR(m_pParamHeap,0);
+    /* new buffer, first batch has to clear it completely */
+    memset(&m_parmDirty, 0, sizeof(m_parmDirty));
 
     initDefaultParameters();
 
@@ -4616,6 +5023,7 @@ void QCameraParameters::deinit()
     m_AdjustFPS = NULL;
 
     m_tempMap.clear();
+    m_LastParamsFlat.clear();
 
     m_bInited = false;
 }
@@ -4844,7 +5252,7 @@ int32_t QCameraParameters::setPreviewFpsRange(int min_fps,
 int32_t QCameraParameters::setAutoExposure(const char *autoExp)
 {
     if (autoExp != NULL) {
-        int32_t value = lookupAttr(AUTO_EXPOSURE_MAP, PARAM_MAP_SIZE(AUTO_EXPOSURE_MAP), autoExp);
+        int32_t value = lookupAttr(AUTO_EXPOSURE_LOOKUP, autoExp);
         if (value != NAME_NOT_FOUND) {
             CDBG_HIGH("%s: Setting auto exposure %s", __func__, autoExp);
             updateParamEntry(KEY_QC_AUTO_EXPOSURE, autoExp);
@@ -4873,7 +5281,7 @@ int32_t QCameraParameters::setAutoExposure(const char *autoExp)
 int32_t QCameraParameters::setEffect(const char *effect)
 {
     if (effect != NULL) {
-        int32_t value = lookupAttr(EFFECT_MODES_MAP, PARAM_MAP_SIZE(EFFECT_MODES_MAP), effect);
+        int32_t value = lookupAttr(EFFECT_MODES_LOOKUP, effect);
         if (value != NAME_NOT_FOUND) {
             CDBG_HIGH("%s: Setting effect %s", __func__, effect);
             updateParamEntry(KEY_EFFECT, effect);
@@ -4930,7 +5338,7 @@ int32_t QCameraParameters::setFocusMode(const char *focusMode)
 {
     int32_t rc;
     if (focusMode != NULL) {
-        int32_t value = lookupAttr(FOCUS_MODES_MAP, PARAM_MAP_SIZE(FOCUS_MODES_MAP), focusMode);
+        int32_t value = lookupAttr(FOCUS_MODES_LOOKUP, focusMode);
         if (value != NAME_NOT_FOUND) {
             CDBG_HIGH("%s: Setting focus mode %s", __func__, focusMode);
             uint8_t fm = (uint8_t)value;
@@ -5070,8 +5478,7 @@ int32_t QCameraParameters::setContrast(int contrast)
 int32_t QCameraParameters::setSceneDetect(const char *sceneDetect)
 {
     if (sceneDetect != NULL) {
-        int32_t value = lookupAttr(ON_OFF_MODES_MAP, PARAM_MAP_SIZE(ON_OFF_MODES_MAP),
-                sceneDetect);
+        int32_t value = lookupAttr(ON_OFF_MODES_LOOKUP, sceneDetect);
         if (value != NAME_NOT_FOUND) {
             CDBG_HIGH("%s: Setting Scene Detect %s", __func__, sceneDetect);
             updateParamEntry(KEY_QC_SCENE_DETECT, sceneDetect);
@@ -5101,8 +5508,7 @@ int32_t QCameraParameters::setSceneDetect(const char *sceneDetect)
 int32_t QCameraParameters::setSensorSnapshotHDR(const char *snapshotHDR)
 {
     if (snapshotHDR != NULL) {
-        int32_t value = lookupAttr(ON_OFF_MODES_MAP, PARAM_MAP_SIZE(ON_OFF_MODES_MAP),
-                snapshotHDR);
+        int32_t value = lookupAttr(ON_OFF_MODES_LOOKUP, snapshotHDR);
         if (value != NAME_NOT_FOUND) {
             CDBG_HIGH("%s: Setting Sensor Snapshot HDR %s", __func__, snapshotHDR);
             updateParamEntry(KEY_QC_SENSOR_HDR, snapshotHDR);
@@ -5134,7 +5540,7 @@ int32_t QCameraParameters::setSensorSnapshotHDR(const char *snapshotHDR)
 int32_t QCameraParameters::setVideoHDR(const char *videoHDR)
 {
     if (videoHDR != NULL) {
-        int32_t value = lookupAttr(ON_OFF_MODES_MAP, PARAM_MAP_SIZE(ON_OFF_MODES_MAP), videoHDR);
+        int32_t value = lookupAttr(ON_OFF_MODES_LOOKUP, videoHDR);
         if (value != NAME_NOT_FOUND) {
             CDBG_HIGH("%s: Setting Video HDR %s", __func__, videoHDR);
             updateParamEntry(KEY_QC_VIDEO_HDR, videoHDR);
@@ -5166,8 +5572,7 @@ int32_t QCameraParameters::setVideoHDR(const char *videoHDR)
 int32_t QCameraParameters::setVtEnable(const char *vtEnable)
 {
     if (vtEnable != NULL) {
-        int32_t value = lookupAttr(ENABLE_DISABLE_MODES_MAP,
-                PARAM_MAP_SIZE(ENABLE_DISABLE_MODES_MAP), vtEnable);
+        int32_t value = lookupAttr(ENABLE_DISABLE_MODES_LOOKUP, vtEnable);
         if (value != NAME_NOT_FOUND) {
             CDBG_HIGH("%s: Setting Vt Enable %s", __func__, vtEnable);
             m_bAVTimerEnabled = true;
@@ -5201,7 +5606,7 @@ int32_t QCameraParameters::setFaceRecognition(const char *faceRecog,
         uint32_t maxFaces)
 {
     if (faceRecog != NULL) {
-        int32_t value = lookupAttr(ON_OFF_MODES_MAP, PARAM_MAP_SIZE(ON_OFF_MODES_MAP), faceRecog);
+        int32_t value = lookupAttr(ON_OFF_MODES_LOOKUP, faceRecog);
         if (value != NAME_NOT_FOUND) {
             CDBG_HIGH("%s: Setting face recognition %s", __func__, faceRecog);
             updateParamEntry(KEY_QC_FACE_RECOGNITION, faceRecog);
@@ -5275,7 +5680,7 @@ int32_t QCameraParameters::setZoom(int zoom_level)
 int32_t  QCameraParameters::setISOValue(const char *isoValue)
 {
     if (isoValue != NULL) {
-        int32_t value = lookupAttr(ISO_MODES_MAP, PARAM_MAP_SIZE(ISO_MODES_MAP), isoValue);
+        int32_t value = lookupAttr(ISO_MODES_LOOKUP, isoValue);
         if (value != NAME_NOT_FOUND) {
             CDBG_HIGH("%s: Setting ISO value %s", __func__, isoValue);
             updateParamEntry(KEY_QC_ISO_MODE, isoValue);
@@ -5348,7 +5753,7 @@ int32_t QCameraParameters::setLongshotEnable(bool enable)
 int32_t QCameraParameters::setFlash(const char *flashStr)
 {
     if (flashStr != NULL) {
-        int32_t value = lookupAttr(FLASH_MODES_MAP, PARAM_MAP_SIZE(FLASH_MODES_MAP), flashStr);
+        int32_t value = lookupAttr(FLASH_MODES_LOOKUP, flashStr);
         if (value != NAME_NOT_FOUND) {
             CDBG_HIGH("%s: Setting Flash value %s", __func__, flashStr);
 
@@ -5384,8 +5789,7 @@ int32_t QCameraParameters::setFlash(const char *flashStr)
 int32_t QCameraParameters::setAecLock(const char *aecLockStr)
 {
     if (aecLockStr != NULL) {
-        int32_t value = lookupAttr(TRUE_FALSE_MODES_MAP, PARAM_MAP_SIZE(TRUE_FALSE_MODES_MAP),
-                aecLockStr);
+        int32_t value = lookupAttr(TRUE_FALSE_MODES_LOOKUP, aecLockStr);
         if (value != NAME_NOT_FOUND) {
             CDBG_HIGH("%s: Setting AECLock value %s", __func__, aecLockStr);
             updateParamEntry(KEY_AUTO_EXPOSURE_LOCK, aecLockStr);
@@ -5415,8 +5819,7 @@ int32_t QCameraParameters::setAecLock(const char *aecLockStr)
 int32_t QCameraParameters::setAwbLock(const char *awbLockStr)
 {
     if (awbLockStr != NULL) {
-        int32_t value = lookupAttr(TRUE_FALSE_MODES_MAP, PARAM_MAP_SIZE(TRUE_FALSE_MODES_MAP),
-                awbLockStr);
+        int32_t value = lookupAttr(TRUE_FALSE_MODES_LOOKUP, awbLockStr);
         if (value != NAME_NOT_FOUND) {
             CDBG_HIGH("%s: Setting AWBLock value %s", __func__, awbLockStr);
             updateParamEntry(KEY_AUTO_WHITEBALANCE_LOCK, awbLockStr);
@@ -5445,8 +5848,7 @@ int32_t QCameraParameters::setAwbLock(const char *awbLockStr)
 int32_t QCameraParameters::setMCEValue(const char *mceStr)
 {
     if (mceStr != NULL) {
-        int32_t value = lookupAttr(ENABLE_DISABLE_MODES_MAP,
-                PARAM_MAP_SIZE(ENABLE_DISABLE_MODES_MAP), mceStr);
+        int32_t value = lookupAttr(ENABLE_DISABLE_MODES_LOOKUP, mceStr);
         if (value != NAME_NOT_FOUND) {
             CDBG_HIGH("%s: Setting AWBLock value %s", __func__, mceStr);
             updateParamEntry(KEY_QC_MEMORY_COLOR_ENHANCEMENT, mceStr);
@@ -5510,8 +5912,7 @@ int32_t QCameraParameters::setTintlessValue(const QCameraParameters& params)
 int32_t QCameraParameters::setTintlessValue(const char *tintStr)
 {
     if (tintStr != NULL) {
-        int32_t value = lookupAttr(ENABLE_DISABLE_MODES_MAP,
-                PARAM_MAP_SIZE(ENABLE_DISABLE_MODES_MAP), tintStr);
+        int32_t value = lookupAttr(ENABLE_DISABLE_MODES_LOOKUP, tintStr);
         if (value != NAME_NOT_FOUND) {
             CDBG_HIGH("%s: Setting Tintless value %s", __func__, tintStr);
             updateParamEntry(KEY_QC_TINTLESS_ENABLE, tintStr);
@@ -5558,7 +5959,7 @@ int32_t QCameraParameters::setCDSMode(const QCameraParameters& params)
     if (cds_mode_str) {
         ALOGV("%s: Set CDS mode = %s", __func__, cds_mode_str);
 
-        int cds_mode = lookupAttr(CDS_MODES_MAP, PARAM_MAP_SIZE(CDS_MODES_MAP), cds_mode_str);
+        int cds_mode = lookupAttr(CDS_MODES_LOOKUP, cds_mode_str);
 
         rc = AddSetParmEntryToBatch(m_pParamBuf,
                                     CAM_INTF_PARM_CDS_MODE,
@@ -5586,8 +5987,7 @@ int32_t QCameraParameters::setCDSMode(const QCameraParameters& params)
 int32_t QCameraParameters::setDISValue(const char *disStr)
 {
     if (disStr != NULL) {
-        int32_t value = lookupAttr(ENABLE_DISABLE_MODES_MAP,
-                PARAM_MAP_SIZE(ENABLE_DISABLE_MODES_MAP), disStr);
+        int32_t value = lookupAttr(ENABLE_DISABLE_MODES_LOOKUP, disStr);
         if (value != NAME_NOT_FOUND) {
             //For some IS types (like EIS 2.0), when DIS value is changed, we need to restart
             //preview because of topology change in backend. But, for now, restart preview
@@ -5648,8 +6048,7 @@ int32_t QCameraParameters::setHighFrameRate(const int32_t hfrMode)
 int32_t QCameraParameters::setLensShadeValue(const char *lensShadeStr)
 {
     if (lensShadeStr != NULL) {
-        int32_t value = lookupAttr(ENABLE_DISABLE_MODES_MAP,
-                PARAM_MAP_SIZE(ENABLE_DISABLE_MODES_MAP), lensShadeStr);
+        int32_t value = lookupAttr(ENABLE_DISABLE_MODES_LOOKUP, lensShadeStr);
         if (value != NAME_NOT_FOUND) {
             CDBG_HIGH("%s: Setting LensShade value %s", __func__, lensShadeStr);
             updateParamEntry(KEY_QC_LENSSHADE, lensShadeStr);
@@ -5705,8 +6104,7 @@ int32_t QCameraParameters::setExposureCompensation(int expComp)
 int32_t QCameraParameters::setWhiteBalance(const char *wbStr)
 {
     if (wbStr != NULL) {
-        int32_t value = lookupAttr(WHITE_BALANCE_MODES_MAP,
-                PARAM_MAP_SIZE(WHITE_BALANCE_MODES_MAP), wbStr);
+        int32_t value = lookupAttr(WHITE_BALANCE_MODES_LOOKUP, wbStr);
         if (value != NAME_NOT_FOUND) {
             CDBG_HIGH("%s: Setting WhiteBalance value %s", __func__, wbStr);
             updateParamEntry(KEY_WHITE_BALANCE, wbStr);
@@ -5748,8 +6146,7 @@ int QCameraParameters::getAutoFlickerMode()
 int32_t QCameraParameters::setAntibanding(const char *antiBandingStr)
 {
     if (antiBandingStr != NULL) {
-        int32_t value = lookupAttr(ANTIBANDING_MODES_MAP, PARAM_MAP_SIZE(ANTIBANDING_MODES_MAP),
-                antiBandingStr);
+        int32_t value = lookupAttr(ANTIBANDING_MODES_LOOKUP, antiBandingStr);
         if (value != NAME_NOT_FOUND) {
             CDBG_HIGH("%s: Setting AntiBanding value %s", __func__, antiBandingStr);
             updateParamEntry(KEY_ANTIBANDING, antiBandingStr);
@@ -5959,7 +6356,7 @@ int32_t QCameraParameters::setMeteringAreas(const char *meteringAreasStr)
 int32_t QCameraParameters::setSceneMode(const char *sceneModeStr)
 {
     if (sceneModeStr != NULL) {
-        int32_t value = lookupAttr(SCENE_MODES_MAP, PARAM_MAP_SIZE(SCENE_MODES_MAP), sceneModeStr);
+        int32_t value = lookupAttr(SCENE_MODES_LOOKUP, sceneModeStr);
         if (value != NAME_NOT_FOUND) {
             CDBG("%s: Setting SceneMode %s", __func__, sceneModeStr);
             updateParamEntry(KEY_SCENE_MODE, sceneModeStr);
@@ -5998,7 +6395,7 @@ int32_t QCameraParameters::setSceneMode(const char *sceneModeStr)
 int32_t QCameraParameters::setSelectableZoneAf(const char *selZoneAFStr)
 {
     if (selZoneAFStr != NULL) {
-        int32_t value = lookupAttr(FOCUS_ALGO_MAP, PARAM_MAP_SIZE(FOCUS_ALGO_MAP), selZoneAFStr);
+        int32_t value = lookupAttr(FOCUS_ALGO_LOOKUP, selZoneAFStr);
         if (value != NAME_NOT_FOUND) {
             CDBG("%s: Setting Selectable Zone AF value %s", __func__, selZoneAFStr);
             updateParamEntry(KEY_QC_SELECTABLE_ZONE_AF, selZoneAFStr);
@@ -6055,8 +6452,7 @@ int32_t QCameraParameters::setAEBracket(const char *aecBracketStr)
     cam_exp_bracketing_t expBracket;
     memset(&expBracket, 0, sizeof(expBracket));
 
-    int value = lookupAttr(BRACKETING_MODES_MAP, PARAM_MAP_SIZE(BRACKETING_MODES_MAP),
-            aecBracketStr);
+    int value = lookupAttr(BRACKETING_MODES_LOOKUP, aecBracketStr);
     switch (value) {
     case CAM_EXP_BRACKETING_ON:
         {
@@ -6110,8 +6506,7 @@ int32_t QCameraParameters::set3ALock(const char *lockStr)
 {
     int32_t rc = NO_ERROR;
     if (lockStr != NULL) {
-        int value = lookupAttr(TRUE_FALSE_MODES_MAP, PARAM_MAP_SIZE(TRUE_FALSE_MODES_MAP),
-                lockStr);
+        int value = lookupAttr(TRUE_FALSE_MODES_LOOKUP, lockStr);
         if (value != NAME_NOT_FOUND) {
             CDBG_HIGH("%s: Setting Lock lockStr =%s", __func__, lockStr);
             if(initBatchUpdate(m_pParamBuf) < 0 ) {
@@ -6130,7 +6525,7 @@ int32_t QCameraParameters::set3ALock(const char *lockStr)
             } else {
                // retrieve previous focus value.
                const char *focus = get(KEY_FOCUS_MODE);
-               int val = lookupAttr(FOCUS_MODES_MAP, PARAM_MAP_SIZE(FOCUS_MODES_MAP), focus);
+               int val = lookupAttr(FOCUS_MODES_LOOKUP, focus);
                if (val != NAME_NOT_FOUND) {
                    focus_mode = (int32_t) val;
                    CDBG("%s: focus mode %s", __func__, focus);
@@ -6328,8 +6723,7 @@ int32_t QCameraParameters::setAFBracket(const char *afBracketStr)
     CDBG_HIGH("%s: afBracketStr =%s",__func__,afBracketStr);
 
     if(afBracketStr != NULL) {
-        int value = lookupAttr(AF_BRACKETING_MODES_MAP, PARAM_MAP_SIZE(AF_BRACKETING_MODES_MAP),
-                afBracketStr);
+        int value = lookupAttr(AF_BRACKETING_MODES_LOOKUP, afBracketStr);
         if (value != NAME_NOT_FOUND) {
             m_bAFBracketingOn = (value != 0);
             updateParamEntry(KEY_QC_AF_BRACKET, afBracketStr);
@@ -6360,8 +6754,7 @@ int32_t QCameraParameters::setReFocus(const char *reFocusStr)
     CDBG_HIGH("%s: reFocusStr =%s",__func__,reFocusStr);
 
     if(reFocusStr != NULL) {
-        int value = lookupAttr(RE_FOCUS_MODES_MAP, PARAM_MAP_SIZE(RE_FOCUS_MODES_MAP),
-                reFocusStr);
+        int value = lookupAttr(RE_FOCUS_MODES_LOOKUP, reFocusStr);
         if (value != NAME_NOT_FOUND) {
             m_bAFBracketingOn = (value != 0);
             m_bReFocusOn = (value != 0);
@@ -6389,8 +6782,7 @@ int32_t QCameraParameters::setChromaFlash(const char *chromaFlashStr)
 {
     CDBG_HIGH("%s: chromaFlashStr =%s",__func__,chromaFlashStr);
     if(chromaFlashStr != NULL) {
-        int value = lookupAttr(CHROMA_FLASH_MODES_MAP, PARAM_MAP_SIZE(CHROMA_FLASH_MODES_MAP),
-                chromaFlashStr);
+        int value = lookupAttr(CHROMA_FLASH_MODES_LOOKUP, chromaFlashStr);
         if(value != NAME_NOT_FOUND) {
             m_bChromaFlashOn = (value != 0);
             updateParamEntry(KEY_QC_CHROMA_FLASH, chromaFlashStr);
@@ -6420,8 +6812,7 @@ int32_t QCameraParameters::setOptiZoom(const char *optiZoomStr)
 {
     CDBG_HIGH("%s: optiZoomStr =%s",__func__,optiZoomStr);
     if(optiZoomStr != NULL) {
-        int value = lookupAttr(OPTI_ZOOM_MODES_MAP, PARAM_MAP_SIZE(OPTI_ZOOM_MODES_MAP),
-                optiZoomStr);
+        int value = lookupAttr(OPTI_ZOOM_MODES_LOOKUP, optiZoomStr);
         if(value != NAME_NOT_FOUND) {
             m_bOptiZoomOn = (value != 0);
             updateParamEntry(KEY_QC_OPTI_ZOOM, optiZoomStr);
@@ -6605,8 +6996,7 @@ int32_t QCameraParameters::updateFlash(bool commitSettings)
 int32_t QCameraParameters::setRedeyeReduction(const char *redeyeStr)
 {
     if (redeyeStr != NULL) {
-        int32_t value = lookupAttr(ENABLE_DISABLE_MODES_MAP,
-                PARAM_MAP_SIZE(ENABLE_DISABLE_MODES_MAP), redeyeStr);
+        int32_t value = lookupAttr(ENABLE_DISABLE_MODES_LOOKUP, redeyeStr);
         if (value != NAME_NOT_FOUND) {
             CDBG("%s: Setting RedEye Reduce value %s", __func__, redeyeStr);
             updateParamEntry(KEY_QC_REDEYE_REDUCTION, redeyeStr);
@@ -6678,8 +7068,7 @@ int32_t QCameraParameters::setWaveletDenoise(const char *wnrStr)
     }
 
     if (wnrStr != NULL) {
-        int value = lookupAttr(DENOISE_ON_OFF_MODES_MAP,
-                PARAM_MAP_SIZE(DENOISE_ON_OFF_MODES_MAP), wnrStr);
+        int value = lookupAttr(DENOISE_ON_OFF_MODES_LOOKUP, wnrStr);
         if (value != NAME_NOT_FOUND) {
             updateParamEntry(KEY_QC_DENOISE, wnrStr);
 
@@ -6719,8 +7108,7 @@ int32_t QCameraParameters::setRdiMode(const char *str)
   CDBG("RDI_DEBUG %s: rdi mode value: %s", __func__, str);
 
   if (str != NULL) {
-    int32_t value = lookupAttr(ENABLE_DISABLE_MODES_MAP,
-            PARAM_MAP_SIZE(ENABLE_DISABLE_MODES_MAP), str);
+    int32_t value = lookupAttr(ENABLE_DISABLE_MODES_LOOKUP, str);
     if (value != NAME_NOT_FOUND) {
       updateParamEntry(KEY_QC_RDI_MODE, str);
       m_bRdiMode = (value == 0)? false : true;
@@ -6753,8 +7141,7 @@ int32_t QCameraParameters::setSecureMode(const char *str)
   ALOGD("%s: Secure mode value: %s", __func__, str);
 
   if (str != NULL) {
-    int32_t value = lookupAttr(ENABLE_DISABLE_MODES_MAP,
-            PARAM_MAP_SIZE(ENABLE_DISABLE_MODES_MAP), str);
+    int32_t value = lookupAttr(ENABLE_DISABLE_MODES_LOOKUP, str);
     if (value != NAME_NOT_FOUND) {
       updateParamEntry(KEY_QC_SECURE_MODE, str);
       m_bSecureMode = (value == 0)? false : true;
@@ -7054,7 +7441,7 @@ int QCameraParameters::getFlipMode(cam_stream_type_t type)
 
     if(str != NULL){
         //Need give corresponding filp value based on flip mode strings
-        int value = lookupAttr(FLIP_MODES_MAP, PARAM_MAP_SIZE(FLIP_MODES_MAP), str);
+        int value = lookupAttr(FLIP_MODES_LOOKUP, str);
         if(value != NAME_NOT_FOUND)
             flipMode = value;
         }
@@ -7642,7 +8029,7 @@ uint16_t QCameraParameters::getExifIsoSpeed()
 {
     uint16_t isoSpeed = 0;
     const char *iso_str = get(QCameraParameters::KEY_QC_ISO_MODE);
-    int iso_index = lookupAttr(ISO_MODES_MAP, PARAM_MAP_SIZE(ISO_MODES_MAP), iso_str);
+    int iso_index = lookupAttr(ISO_MODES_LOOKUP, iso_str);
     switch (iso_index) {
     case CAM_ISO_MODE_AUTO:
         isoSpeed = 0;
@@ -8383,8 +8770,7 @@ bool QCameraParameters::isYUVFrameInfoNeeded()
     }
     const char *aecBracketStr =  get(KEY_QC_AE_BRACKET_HDR);
 
-    int value = lookupAttr(BRACKETING_MODES_MAP, PARAM_MAP_SIZE(BRACKETING_MODES_MAP),
-            aecBracketStr);
+    int value = lookupAttr(BRACKETING_MODES_LOOKUP, aecBracketStr);
     CDBG_HIGH("%s: aecBracketStr=%s, value=%d.", __func__, aecBracketStr, value);
     return (value == CAM_EXP_BRACKETING_ON);
 }
@@ -8401,7 +8787,7 @@ bool QCameraParameters::isYUVFrameInfoNeeded()
  *==========================================================================*/
 const char *QCameraParameters::getFrameFmtString(cam_format_t fmt)
 {
-    return lookupNameByValue(PICTURE_TYPES_MAP, PARAM_MAP_SIZE(PICTURE_TYPES_MAP), fmt);
+    return lookupNameByValue(PICTURE_TYPES_LOOKUP, fmt);
 }
 
 /*===========================================================================
@@ -8420,7 +8806,8 @@ int32_t QCameraParameters::initBatchUpdate(parm_buffer_t *p_table)
 {
     m_tempMap.clear();
 
-    memset(p_table, 0, sizeof(parm_buffer_t));
+    cam_parm_batch_init(p_table,
+        (p_table == m_pParamBuf) ? &m_parmDirty : NULL);
     return NO_ERROR;
 }
 
@@ -8442,7 +8829,6 @@ int32_t QCameraParameters::initBatchUpdate(parm_buffer_t *p_table)
 int32_t QCameraParameters::AddSetParmEntryToBatch(parm_buffer_t *p_table,
         cam_intf_parm_type_t paramType, size_t paramLength, void *paramValue)
 {
-    void* dst;
     if ((NULL == p_table) || (NULL == paramValue) ||
         (paramType >= CAM_INTF_PARM_MAX)) {
         ALOGE("%s: Error invalid param. p_table: %p, paramValue: %p, "
@@ -8450,20 +8836,16 @@ int32_t QCameraParameters::AddSetParmEntryToBatch(parm_buffer_t *p_table,
         return BAD_VALUE;
     }
     /*************************************************************************
-    *                   Copy contents into entry                             *
+    *           Copy contents into entry and track it as dirty               *
     *************************************************************************/
-    if (paramLength > get_size_of(paramType)) {
+    if (cam_parm_batch_add(p_table,
+            (p_table == m_pParamBuf) ? &m_parmDirty : NULL,
+            paramType, (uint32_t)paramLength, paramValue) < 0) {
         ALOGE("%s:Size of input larger than max entry size. paramType: %d "
             "paramLength: %d sizeof(paramType): %d",
             __func__, paramType, paramLength, get_size_of(paramType));
         return BAD_VALUE;
     }
-
-    dst = get_pointer_of(paramType, p_table);
-    if (NULL != dst) {
-        memcpy(dst, paramValue, paramLength);
-        p_table->is_valid[paramType] = 1;
-    }
     return NO_ERROR;
 }
 
@@ -8489,7 +8871,8 @@ int32_t QCameraParameters::AddGetParmEntryToBatch(parm_buffer_t *p_table,
         return BAD_VALUE;
     }
     /* Set the is_reqd flag for this param so that backend can fill the value*/
-    p_table->is_reqd[paramType] = 1;
+    cam_parm_batch_add_get(p_table,
+        (p_table == m_pParamBuf) ? &m_parmDirty : NULL, paramType);
 
     return NO_ERROR;
 }
@@ -8508,16 +8891,14 @@ int32_t QCameraParameters::AddGetParmEntryToBatch(parm_buffer_t *p_table,
 int32_t QCameraParameters::commitSetBatch()
 {
     int32_t rc = NO_ERROR;
-    int32_t i = 0;
-
-    /* Loop to check if atleast one entry is valid */
-    for(i = 0; i < CAM_INTF_PARM_MAX; i++){
-        if(m_pParamBuf->is_valid[i])
-            break;
-    }
 
-    if (i < CAM_INTF_PARM_MAX) {
-        rc = m_pCamOpsTbl->ops->set_parms(m_pCamOpsTbl->camera_handle, m_pParamBuf);
+    /* Dirty tracker tells if atleast one entry is valid */
+    if (m_parmDirty.num_entries > 0) {
+        CDBG("%s: %u params, %u bytes delta vs %zu bytes flat", __func__,
+            m_parmDirty.num_entries, cam_parm_delta_size(&m_parmDirty),
+            sizeof(parm_buffer_t));
+        rc = m_pCamOpsTbl->ops->set_parms_delta(m_pCamOpsTbl->camera_handle,
+            m_pParamBuf, &m_parmDirty);
     }
     if (rc == NO_ERROR) {
         // commit change from temp storage into param map
@@ -8540,15 +8921,9 @@ int32_t QCameraParameters::commitSetBatch()
 int32_t QCameraParameters::commitGetBatch()
 {
     int32_t rc = NO_ERROR;
-    int32_t i = 0;
-
-    /* Loop to check if atleast one entry is valid */
-    for(i = 0; i < CAM_INTF_PARM_MAX; i++){
-        if(m_pParamBuf->is_valid[i])
-            break;
-    }
 
-    if (i < CAM_INTF_PARM_MAX) {
+    /* Dirty tracker tells if atleast one entry is requested */
+    if (m_parmDirty.num_entries > 0) {
         return m_pCamOpsTbl->ops->get_parms(m_pCamOpsTbl->camera_handle, m_pParamBuf);
     } else {
         return NO_ERROR;
@@ -22,12 +22,14 @@
 #include <camera/CameraParameters.h>
 #include <cutils/properties.h>
 #include <hardware/camera.h>
+#include <pthread.h>
 #include <stdlib.h>
 #include <utils/Errors.h>
 #include "cam_intf.h"
 #include "cam_types.h"
 #include "QCameraMem.h"
 #include "QCameraThermalAdapter.h"
+#include "QCameraLookupMap.h"
 
 extern "C" {
 #include <mm_jpeg_interface.h>
@@ -45,6 +47,8 @@ static const char ExifUndefinedPrefix[] = { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
 #define EXIF_ASCII_PREFIX_SIZE           8   //(sizeof(ExifAsciiPrefix))
 #define FOCAL_LENGTH_DECIMAL_PRECISION   100
 
+#define PARAM_SETTER_MAX_KEYS            9   // keys read by one parameter setter
+
 class QCameraTorchInterface
 {
 public:
@@ -801,10 +805,70 @@ private:
     static const QCameraMap<int> OPTI_ZOOM_MODES_MAP[];
     static const QCameraMap<cam_cds_mode_type_t> CDS_MODES_MAP[];
 
+    // hashed/dense indexes over the maps above, used for all lookups
+    static const QCameraNameLookup<QCameraMap<cam_auto_exposure_mode_type> > AUTO_EXPOSURE_LOOKUP;
+    static const QCameraNameLookup<QCameraMap<cam_format_t> > PREVIEW_FORMATS_LOOKUP;
+    static const QCameraNameLookup<QCameraMap<cam_format_t> > PICTURE_TYPES_LOOKUP;
+    static const QCameraNameLookup<QCameraMap<cam_focus_mode_type> > FOCUS_MODES_LOOKUP;
+    static const QCameraNameLookup<QCameraMap<cam_effect_mode_type> > EFFECT_MODES_LOOKUP;
+    static const QCameraNameLookup<QCameraMap<cam_scene_mode_type> > SCENE_MODES_LOOKUP;
+    static const QCameraNameLookup<QCameraMap<cam_flash_mode_t> > FLASH_MODES_LOOKUP;
+    static const QCameraNameLookup<QCameraMap<cam_focus_algorithm_type> > FOCUS_ALGO_LOOKUP;
+    static const QCameraNameLookup<QCameraMap<cam_wb_mode_type> > WHITE_BALANCE_MODES_LOOKUP;
+    static const QCameraNameLookup<QCameraMap<cam_antibanding_mode_type> > ANTIBANDING_MODES_LOOKUP;
+    static const QCameraNameLookup<QCameraMap<cam_iso_mode_type> > ISO_MODES_LOOKUP;
+    static const QCameraNameLookup<QCameraMap<cam_hfr_mode_t> > HFR_MODES_LOOKUP;
+    static const QCameraNameLookup<QCameraMap<cam_bracket_mode> > BRACKETING_MODES_LOOKUP;
+    static const QCameraNameLookup<QCameraMap<int> > ON_OFF_MODES_LOOKUP;
+    static const QCameraNameLookup<QCameraMap<int> > ENABLE_DISABLE_MODES_LOOKUP;
+    static const QCameraNameLookup<QCameraMap<int> > DENOISE_ON_OFF_MODES_LOOKUP;
+    static const QCameraNameLookup<QCameraMap<int> > TRUE_FALSE_MODES_LOOKUP;
+    static const QCameraNameLookup<QCameraMap<int> > TOUCH_AF_AEC_MODES_LOOKUP;
+    static const QCameraNameLookup<QCameraMap<cam_flip_t> > FLIP_MODES_LOOKUP;
+    static const QCameraNameLookup<QCameraMap<int> > AF_BRACKETING_MODES_LOOKUP;
+    static const QCameraNameLookup<QCameraMap<int> > RE_FOCUS_MODES_LOOKUP;
+    static const QCameraNameLookup<QCameraMap<int> > CHROMA_FLASH_MODES_LOOKUP;
+    static const QCameraNameLookup<QCameraMap<int> > OPTI_ZOOM_MODES_LOOKUP;
+    static const QCameraNameLookup<QCameraMap<cam_cds_mode_type_t> > CDS_MODES_LOOKUP;
+
+    // setters run by updateParameters, in the order they are applied
+    typedef int32_t (QCameraParameters::*ParamSetter)(const QCameraParameters&);
+
+    typedef enum {
+        PARAM_SETTER_ON_CHANGE,     // run when one of its keys changed
+        PARAM_SETTER_ALWAYS,        // depends on internal state, run every update
+        PARAM_SETTER_FULL_ONLY,     // driven by properties, run on full updates
+        PARAM_SETTER_ON_ADV_CHANGE, // key change or advanced feature state change
+    } param_setter_policy_t;
+
+    typedef struct {
+        ParamSetter setter;
+        param_setter_policy_t policy;
+        const char *keys[PARAM_SETTER_MAX_KEYS];
+    } param_setter_entry_t;
+
+    typedef struct {
+        const char *key;
+        size_t len;
+        uint8_t setterIdx;
+    } param_key_index_t;
+
+    static const param_setter_entry_t PARAM_SETTERS[];
+    static param_key_index_t PARAM_KEY_INDEX[];
+    static size_t PARAM_KEY_INDEX_CNT;
+    static pthread_once_t PARAM_KEY_INDEX_ONCE;
+
+    static void buildParamKeyIndex();
+    static int compareParamKeyIndex(const void *a, const void *b);
+    static void markParamKeyDirty(const char *key, size_t len, bool *dirty);
+    static void markChangedParamKeys(const char *params, const char *ref,
+            bool markRemoved, bool *dirty);
+
     cam_capability_t *m_pCapability;
     mm_camera_vtbl_t *m_pCamOpsTbl;
     QCameraHeapMemory *m_pParamHeap;
     parm_buffer_t     *m_pParamBuf;  // ptr to param buf in m_pParamHeap
+    cam_parm_dirty_t   m_parmDirty;  // entries set in current m_pParamBuf batch
 
     bool m_bZslMode;                // if ZSL is enabled
     bool m_bZslMode_new;
@@ -868,6 +932,9 @@ private:
     int32_t mFlashValue;
     int32_t mFlashDaemonValue;
     int32_t mHfrMode;
+    bool m_bParamDiffEnabled;       // dispatch only setters whose keys changed
+    String8 m_LastParamsFlat;       // last successfully applied user parameters
+    bool m_bAdvCamFeaturesApplied;  // advanced feature state seen by setBurstNum
 };
 
 }; // namespace qcamera
@@ -37,6 +37,7 @@
 
 #include "QCamera2HWI.h"
 #include "QCameraPostProc.h"
+#include "qyuvscale.h"
 
 namespace qcamera {
 
@@ -71,20 +72,28 @@ QCameraPostProcessor::QCameraPostProcessor(QCamera2HardwareInterface *cam_ctrl)
       m_bThumbnailNeeded(TRUE),
       m_pReprocChannel(NULL),
       m_bInited(FALSE),
-      m_inputPPQ(releasePPInputData, this),
+      m_inputPPQ(MAX_POSTPROC_INPUT_Q_DEPTH, RING_QUEUE_MPSC,
+                 releasePPInputData, this),
       m_ongoingPPQ(releaseOngoingPPData, this),
-      m_inputJpegQ(releaseJpegData, this),
+      m_inputJpegQ(MAX_POSTPROC_INPUT_Q_DEPTH, RING_QUEUE_MPSC,
+                   releaseJpegData, this),
       m_ongoingJpegQ(releaseJpegData, this),
-      m_inputRawQ(releaseRawData, this),
+      m_inputRawQ(MAX_POSTPROC_INPUT_Q_DEPTH, RING_QUEUE_MPSC,
+                  releaseRawData, this),
+      m_inputSaveQ(MAX_POSTPROC_INPUT_Q_DEPTH, RING_QUEUE_MPSC),
       mSaveFrmCnt(0),
       mUseSaveProc(false),
       mUseJpegBurst(false),
       mJpegMemOpt(true),
       m_JpegOutputMemCount(0),
-      mNewJpegSessionNeeded(true)
+      mNewJpegSessionNeeded(true),
+      mThumbHalScale(true),
+      mThumbScaleActive(false),
+      m_pThumbScaleMem(NULL)
 {
     memset(&mJpegHandle, 0, sizeof(mJpegHandle));
     memset(&m_pJpegOutputMem, 0, sizeof(m_pJpegOutputMem));
+    memset(&m_thumbScaleOffset, 0, sizeof(m_thumbScaleOffset));
     m_DataMem = NULL ;
 }
 
@@ -104,6 +113,7 @@ QCameraPostProcessor::~QCameraPostProcessor()
         delete m_pJpegExifObj;
         m_pJpegExifObj = NULL;
     }
+    releaseThumbScaleBufs();
     if (m_pReprocChannel != NULL) {
         m_pReprocChannel->stop();
         delete m_pReprocChannel;
@@ -352,6 +362,9 @@ int32_t QCameraPostProcessor::getJpegEncodingConfig(mm_jpeg_encode_params_t& enc
     property_get("persist.camera.jpeg_burst", prop, "0");
     mUseJpegBurst = (atoi(prop) > 0) && !mUseSaveProc;
     encode_parm.burst_mode = mUseJpegBurst;
+    property_get("persist.camera.thumb.hal_scale", prop, "1");
+    mThumbHalScale = atoi(prop) > 0;
+    mThumbScaleActive = false;
 
     cam_rect_t crop;
     memset(&crop, 0, sizeof(cam_rect_t));
@@ -485,6 +498,12 @@ int32_t QCameraPostProcessor::getJpegEncodingConfig(mm_jpeg_encode_params_t& enc
             encode_parm.thumb_dim.dst_dim.height = tmp_dim.width;
         }
         encode_parm.thumb_dim.crop = crop;
+
+        if (!need_thumb_rotate && mThumbHalScale &&
+                (NO_ERROR == configThumbScale(encode_parm, main_stream))) {
+            // thumbnail is scaled from the main image in HAL per job
+            mThumbScaleActive = true;
+        }
     }
 
     encode_parm.num_dst_bufs = 1;
@@ -537,6 +556,213 @@ on_error:
     return ret;
 }
 
+/*===========================================================================
+ * FUNCTION   : configThumbScale
+ *
+ * DESCRIPTION: set up thumbnail buffers that get the main image scaled
+ *              and rotated by the HAL before each encode, one per main
+ *              stream buffer so jobs in flight never share one
+ *
+ * PARAMETERS :
+ *   @encode_parm : session config, thumbnail part gets overridden
+ *   @main_stream : main stream the thumbnail is scaled from
+ *
+ * RETURN     : int32_t type of status
+ *              NO_ERROR  -- success
+ *              none-zero failure code, thumbnail is left to the encoder
+ *==========================================================================*/
+int32_t QCameraPostProcessor::configThumbScale(mm_jpeg_encode_params_t& encode_parm,
+                                               QCameraStream *main_stream)
+{
+    cam_dimension_t dim;
+    memset(&dim, 0, sizeof(cam_dimension_t));
+    m_parent->getThumbnailSize(dim);
+    cam_format_t img_fmt = CAM_FORMAT_YUV_420_NV12;
+    QCameraMemory *pStreamMem = main_stream->getStreamBufs();
+    if (pStreamMem == NULL) {
+        return BAD_VALUE;
+    }
+    uint8_t cnt = pStreamMem->getCnt();
+
+    main_stream->getFormat(img_fmt);
+    if ((img_fmt != CAM_FORMAT_YUV_420_NV12) &&
+            (img_fmt != CAM_FORMAT_YUV_420_NV21)) {
+        CDBG_HIGH("%s: main format %d not supported by scaler", __func__, img_fmt);
+        return BAD_VALUE;
+    }
+
+    // leave room for either orientation
+    int32_t max_dim = (dim.width > dim.height) ? dim.width : dim.height;
+    int32_t stride = PAD_TO_SIZE(max_dim, CAM_PAD_TO_32);
+    int32_t scanline = PAD_TO_SIZE(max_dim, CAM_PAD_TO_2);
+    cam_frame_len_offset_t offset;
+    memset(&offset, 0, sizeof(cam_frame_len_offset_t));
+    offset.num_planes = 2;
+    offset.mp[0].len = (uint32_t)(stride * scanline);
+    offset.mp[0].stride = stride;
+    offset.mp[0].scanline = scanline;
+    offset.mp[0].width = dim.width;
+    offset.mp[0].height = dim.height;
+    offset.mp[1].len = (uint32_t)(stride * scanline / 2);
+    offset.mp[1].stride = stride;
+    offset.mp[1].scanline = scanline / 2;
+    offset.mp[1].width = dim.width;
+    offset.mp[1].height = dim.height / 2;
+    offset.frame_len = offset.mp[0].len + offset.mp[1].len;
+
+    if (m_pThumbScaleMem == NULL) {
+        m_pThumbScaleMem = new QCameraHeapMemory(QCAMERA_ION_USE_CACHE);
+        if (m_pThumbScaleMem == NULL) {
+            ALOGE("%s: no memory for thumbnail buffer object", __func__);
+            return NO_MEMORY;
+        }
+        if (m_pThumbScaleMem->allocate(cnt, offset.frame_len, NON_SECURE) < 0) {
+            ALOGE("%s: cannot allocate %d thumbnail buffers", __func__, cnt);
+            delete m_pThumbScaleMem;
+            m_pThumbScaleMem = NULL;
+            return NO_MEMORY;
+        }
+    } else if ((m_pThumbScaleMem->getCnt() < cnt) ||
+            (m_pThumbScaleMem->getSize(0) < (ssize_t)offset.frame_len)) {
+        // buffers may still be referenced until the session is destroyed
+        ALOGE("%s: thumbnail buffers too small for new session", __func__);
+        return NO_MEMORY;
+    }
+    m_thumbScaleOffset = offset;
+
+    encode_parm.num_tmb_bufs = cnt;
+    for (uint32_t i = 0; i < cnt; i++) {
+        camera_memory_t *thumb_mem = m_pThumbScaleMem->getMemory(i, false);
+        if (thumb_mem != NULL) {
+            encode_parm.src_thumb_buf[i].index = i;
+            encode_parm.src_thumb_buf[i].buf_size = thumb_mem->size;
+            encode_parm.src_thumb_buf[i].buf_vaddr = (uint8_t *)thumb_mem->data;
+            encode_parm.src_thumb_buf[i].fd = m_pThumbScaleMem->getFd(i);
+            encode_parm.src_thumb_buf[i].format = MM_JPEG_FMT_YUV;
+            encode_parm.src_thumb_buf[i].offset = offset;
+        }
+    }
+    encode_parm.thumb_color_format = getColorfmtFromImgFmt(img_fmt);
+
+    // thumbnail comes out of the scaler already rotated
+    uint32_t jpeg_rotation = m_parent->getJpegRotation();
+    encode_parm.thumb_dim.dst_dim = dim;
+    if ((90 == jpeg_rotation) || (270 == jpeg_rotation)) {
+        encode_parm.thumb_dim.dst_dim.width = dim.height;
+        encode_parm.thumb_dim.dst_dim.height = dim.width;
+    }
+    encode_parm.thumb_dim.src_dim = encode_parm.thumb_dim.dst_dim;
+    memset(&encode_parm.thumb_dim.crop, 0, sizeof(cam_rect_t));
+    encode_parm.thumb_dim.crop.width = encode_parm.thumb_dim.dst_dim.width;
+    encode_parm.thumb_dim.crop.height = encode_parm.thumb_dim.dst_dim.height;
+    encode_parm.thumb_rotation = 0;
+
+    return NO_ERROR;
+}
+
+/*===========================================================================
+ * FUNCTION   : scaleThumbnail
+ *
+ * DESCRIPTION: scale the cropped main image into the thumbnail buffer
+ *              matching the main buffer index, applying jpeg rotation
+ *              unless reprocess has rotated the main image already
+ *
+ * PARAMETERS :
+ *   @main_stream   : main stream
+ *   @main_frame    : main frame to scale from
+ *   @crop          : crop of the main image
+ *   @jpeg_rotation : rotation requested for the jpeg
+ *   @thumb_dim     : output of scaled thumbnail dimension
+ *
+ * RETURN     : int32_t type of status
+ *              NO_ERROR  -- success
+ *              none-zero failure code
+ *==========================================================================*/
+int32_t QCameraPostProcessor::scaleThumbnail(QCameraStream *main_stream,
+                                             mm_camera_buf_def_t *main_frame,
+                                             const cam_rect_t &crop,
+                                             uint32_t jpeg_rotation,
+                                             cam_dimension_t &thumb_dim)
+{
+    uint32_t idx = main_frame->buf_idx;
+    if ((m_pThumbScaleMem == NULL) || (idx >= m_pThumbScaleMem->getCnt()) ||
+            (main_frame->buffer == NULL)) {
+        ALOGE("%s: no thumbnail buffer for main buf %d", __func__, idx);
+        return BAD_VALUE;
+    }
+
+    cam_dimension_t src_dim;
+    memset(&src_dim, 0, sizeof(cam_dimension_t));
+    main_stream->getFrameDimension(src_dim);
+    cam_frame_len_offset_t main_offset;
+    memset(&main_offset, 0, sizeof(cam_frame_len_offset_t));
+    main_stream->getFrameOffset(main_offset);
+
+    // sizes are fixed by the session the buffers were set up for
+    thumb_dim.width = m_thumbScaleOffset.mp[0].width;
+    thumb_dim.height = m_thumbScaleOffset.mp[0].height;
+    if ((90 == jpeg_rotation) || (270 == jpeg_rotation)) {
+        thumb_dim.width = m_thumbScaleOffset.mp[0].height;
+        thumb_dim.height = m_thumbScaleOffset.mp[0].width;
+    }
+    int rotation = m_parent->needRotationReprocess() ? 0 : (int)jpeg_rotation;
+
+    uint8_t *main_ptr = (uint8_t *)main_frame->buffer;
+    qyuv_image_t src;
+    src.y = main_ptr + main_offset.mp[0].offset;
+    src.uv = main_ptr + main_offset.mp[0].len + main_offset.mp[1].offset;
+    src.width = (uint32_t)src_dim.width;
+    src.height = (uint32_t)src_dim.height;
+    src.y_stride = (uint32_t)main_offset.mp[0].stride;
+    src.uv_stride = (uint32_t)main_offset.mp[1].stride;
+
+    qyuv_rect_t src_crop;
+    src_crop.left = (uint32_t)crop.left;
+    src_crop.top = (uint32_t)crop.top;
+    src_crop.width = (uint32_t)crop.width;
+    src_crop.height = (uint32_t)crop.height;
+
+    uint8_t *thumb_ptr = (uint8_t *)m_pThumbScaleMem->getPtr(idx);
+    qyuv_image_t dst;
+    dst.y = thumb_ptr;
+    dst.uv = thumb_ptr + m_thumbScaleOffset.mp[0].len;
+    dst.width = (uint32_t)thumb_dim.width;
+    dst.height = (uint32_t)thumb_dim.height;
+    dst.y_stride = (uint32_t)m_thumbScaleOffset.mp[0].stride;
+    dst.uv_stride = (uint32_t)m_thumbScaleOffset.mp[1].stride;
+
+    if (qyuv_scale(&src, &src_crop, &dst, rotation, QYUV_FILTER_AUTO, 0) != 0) {
+        ALOGE("%s: crop (%d, %d) %dx%d rejected, using full frame", __func__,
+              crop.left, crop.top, crop.width, crop.height);
+        if (qyuv_scale(&src, NULL, &dst, rotation, QYUV_FILTER_AUTO, 0) != 0) {
+            return BAD_VALUE;
+        }
+    }
+    m_pThumbScaleMem->cleanInvalidateCache(idx);
+
+    return NO_ERROR;
+}
+
+/*===========================================================================
+ * FUNCTION   : releaseThumbScaleBufs
+ *
+ * DESCRIPTION: free the scaled thumbnail buffers. Only safe once the jpeg
+ *              session using them has been destroyed.
+ *
+ * PARAMETERS : None
+ *
+ * RETURN     : None
+ *==========================================================================*/
+void QCameraPostProcessor::releaseThumbScaleBufs()
+{
+    if (m_pThumbScaleMem != NULL) {
+        m_pThumbScaleMem->deallocate();
+        delete m_pThumbScaleMem;
+        m_pThumbScaleMem = NULL;
+    }
+    mThumbScaleActive = false;
+}
+
 /*===========================================================================
  * FUNCTION   : sendEvtNotify
  *
@@ -648,7 +874,12 @@ int32_t QCameraPostProcessor::processData(mm_camera_super_buf_t *frame)
         ATRACE_INT("Camera:Reprocess", 1);
         CDBG_HIGH("%s: need reprocess", __func__);
         // enqueu to post proc input queue
-        m_inputPPQ.enqueue((void *)frame);
+        if (false == m_inputPPQ.enqueue((void *)frame)) {
+            ALOGE("%s: Input PP queue is full, dropping frame", __func__);
+            releasePPInputData(frame, this);
+            free(frame);
+            return NO_MEMORY;
+        }
     } else if (m_parent->mParameters.isNV16PictureFormat() ||
         m_parent->mParameters.isNV21PictureFormat()) {
         //check if raw frame information is needed.
@@ -689,7 +920,12 @@ int32_t QCameraPostProcessor::processData(mm_camera_super_buf_t *frame)
         }
 
         // enqueu to jpeg input queue
-        m_inputJpegQ.enqueue((void *)jpeg_job);
+        if (false == m_inputJpegQ.enqueue((void *)jpeg_job)) {
+            ALOGE("%s: Input jpeg queue is full, dropping frame", __func__);
+            releaseJpegJobData(jpeg_job);
+            free(jpeg_job);
+            return NO_MEMORY;
+        }
     }
     m_dataProcTh.sendCmd(CAMERA_CMD_TYPE_DO_NEXT_JOB, FALSE, FALSE);
 
@@ -716,7 +952,12 @@ int32_t QCameraPostProcessor::processRawData(mm_camera_super_buf_t *frame)
     }
 
     // enqueu to raw input queue
-    m_inputRawQ.enqueue((void *)frame);
+    if (false == m_inputRawQ.enqueue((void *)frame)) {
+        ALOGE("%s: Input raw queue is full, dropping frame", __func__);
+        releaseRawData(frame, this);
+        free(frame);
+        return NO_MEMORY;
+    }
     m_dataProcTh.sendCmd(CAMERA_CMD_TYPE_DO_NEXT_JOB, FALSE, FALSE);
     return NO_ERROR;
 }
@@ -756,7 +997,14 @@ int32_t QCameraPostProcessor::processJpegEvt(qcamera_jpeg_evt_payload_t *evt)
             return NO_MEMORY;
         }
         *saveData = *evt;
-        m_inputSaveQ.enqueue((void *) saveData);
+        if (false == m_inputSaveQ.enqueue((void *) saveData)) {
+            ALOGE("%s: Input save queue is full, dropping jpeg", __func__);
+            free(saveData);
+            // Release jpeg job data, the image will not reach the app
+            m_ongoingJpegQ.flushNodes(matchJobId, (void*)&evt->jobId);
+            sendEvtNotify(CAMERA_MSG_ERROR, UNKNOWN_ERROR, 0);
+            return NO_MEMORY;
+        }
         m_saveProcTh.sendCmd(CAMERA_CMD_TYPE_DO_NEXT_JOB, FALSE, FALSE);
     } else {
         // Release jpeg job data
@@ -947,7 +1195,12 @@ int32_t QCameraPostProcessor::processPPData(mm_camera_super_buf_t *frame)
     }
 
     // enqueu reprocessed frame to jpeg input queue
-    m_inputJpegQ.enqueue((void *)jpeg_job);
+    if (false == m_inputJpegQ.enqueue((void *)jpeg_job)) {
+        ALOGE("%s: Input jpeg queue is full, dropping frame", __func__);
+        releaseJpegJobData(jpeg_job);
+        free(jpeg_job);
+        return NO_MEMORY;
+    }
 
     ALOGD("%s: %d] ", __func__, __LINE__);
     // wait up data proc thread
@@ -1698,7 +1951,26 @@ int32_t QCameraPostProcessor::encodeData(qcamera_jpeg_data_t *jpeg_job_data,
     CDBG_HIGH("%s: jpeg rotation is set to %d", __func__, jpg_job.encode_job.rotation);
 
     // thumbnail dim
-    if (m_bThumbnailNeeded == TRUE) {
+    if ((m_bThumbnailNeeded == TRUE) && mThumbScaleActive) {
+        // thumbnail buffers of this session hold the scaled main image
+        ret = scaleThumbnail(main_stream, main_frame, crop, jpeg_rotation,
+                jpg_job.encode_job.thumb_dim.dst_dim);
+        if (ret != NO_ERROR) {
+            ALOGE("%s: cannot scale thumbnail from main image", __func__);
+            return ret;
+        }
+        jpg_job.encode_job.thumb_dim.src_dim = jpg_job.encode_job.thumb_dim.dst_dim;
+        jpg_job.encode_job.thumb_dim.crop.left = 0;
+        jpg_job.encode_job.thumb_dim.crop.top = 0;
+        jpg_job.encode_job.thumb_dim.crop.width =
+                jpg_job.encode_job.thumb_dim.dst_dim.width;
+        jpg_job.encode_job.thumb_dim.crop.height =
+                jpg_job.encode_job.thumb_dim.dst_dim.height;
+        jpg_job.encode_job.thumb_index = main_frame->buf_idx;
+        CDBG_HIGH("%s, scaled thumbnail w/h (%dx%d)", __func__,
+            jpg_job.encode_job.thumb_dim.dst_dim.width,
+            jpg_job.encode_job.thumb_dim.dst_dim.height);
+    } else if (m_bThumbnailNeeded == TRUE) {
         m_parent->getThumbnailSize(jpg_job.encode_job.thumb_dim.dst_dim);
 
         if (thumb_stream == NULL) {
@@ -2105,9 +2377,10 @@ void *QCameraPostProcessor::dataProcessRoutine(void *data)
                     pme->mJpegSessionId = 0;
                 }
 
-                // free jpeg out buf and exif obj
+                // free jpeg out buf, scaled thumbnails and exif obj
                 FREE_JPEG_OUTPUT_BUFFER(pme->m_pJpegOutputMem,
                     pme->m_JpegOutputMemCount);
+                pme->releaseThumbScaleBufs();
 
                 if (pme->m_pJpegExifObj != NULL) {
                     delete pme->m_pJpegExifObj;
@@ -2468,6 +2741,7 @@ QCameraExif::QCameraExif()
     : m_nNumEntries(0)
 {
     memset(m_Entries, 0, sizeof(m_Entries));
+    cam_exif_arena_init(&m_Arena);
 }
 
 /*===========================================================================
@@ -2481,86 +2755,15 @@ QCameraExif::QCameraExif()
  *==========================================================================*/
 QCameraExif::~QCameraExif()
 {
-    for (uint32_t i = 0; i < m_nNumEntries; i++) {
-        switch (m_Entries[i].tag_entry.type) {
-        case EXIF_BYTE:
-            {
-                if (m_Entries[i].tag_entry.count > 1 &&
-                    m_Entries[i].tag_entry.data._bytes != NULL) {
-                    free(m_Entries[i].tag_entry.data._bytes);
-                    m_Entries[i].tag_entry.data._bytes = NULL;
-                }
-            }
-            break;
-        case EXIF_ASCII:
-            {
-                if (m_Entries[i].tag_entry.data._ascii != NULL) {
-                    free(m_Entries[i].tag_entry.data._ascii);
-                    m_Entries[i].tag_entry.data._ascii = NULL;
-                }
-            }
-            break;
-        case EXIF_SHORT:
-            {
-                if (m_Entries[i].tag_entry.count > 1 &&
-                    m_Entries[i].tag_entry.data._shorts != NULL) {
-                    free(m_Entries[i].tag_entry.data._shorts);
-                    m_Entries[i].tag_entry.data._shorts = NULL;
-                }
-            }
-            break;
-        case EXIF_LONG:
-            {
-                if (m_Entries[i].tag_entry.count > 1 &&
-                    m_Entries[i].tag_entry.data._longs != NULL) {
-                    free(m_Entries[i].tag_entry.data._longs);
-                    m_Entries[i].tag_entry.data._longs = NULL;
-                }
-            }
-            break;
-        case EXIF_RATIONAL:
-            {
-                if (m_Entries[i].tag_entry.count > 1 &&
-                    m_Entries[i].tag_entry.data._rats != NULL) {
-                    free(m_Entries[i].tag_entry.data._rats);
-                    m_Entries[i].tag_entry.data._rats = NULL;
-                }
-            }
-            break;
-        case EXIF_UNDEFINED:
-            {
-                if (m_Entries[i].tag_entry.data._undefined != NULL) {
-                    free(m_Entries[i].tag_entry.data._undefined);
-                    m_Entries[i].tag_entry.data._undefined = NULL;
-                }
-            }
-            break;
-        case EXIF_SLONG:
-            {
-                if (m_Entries[i].tag_entry.count > 1 &&
-                    m_Entries[i].tag_entry.data._slongs != NULL) {
-                    free(m_Entries[i].tag_entry.data._slongs);
-                    m_Entries[i].tag_entry.data._slongs = NULL;
-                }
-            }
-            break;
-        case EXIF_SRATIONAL:
-            {
-                if (m_Entries[i].tag_entry.count > 1 &&
-                    m_Entries[i].tag_entry.data._srats != NULL) {
-                    free(m_Entries[i].tag_entry.data._srats);
-                    m_Entries[i].tag_entry.data._srats = NULL;
-                }
-            }
-            break;
-        }
-    }
+    cam_exif_arena_reset(&m_Arena);
 }
 
 /*===========================================================================
  * FUNCTION   : addEntry
  *
- * DESCRIPTION: function to add an entry to exif data
+ * DESCRIPTION: function to add an entry to exif data. Payloads are copied
+ *              into the arena embedded in the object, adding a tag that is
+ *              already present overwrites its value in place.
  *
  * PARAMETERS :
  *   @tagid   : exif tag ID
@@ -2577,144 +2780,12 @@ int32_t QCameraExif::addEntry(exif_tag_id_t tagid,
                               uint32_t count,
                               void *data)
 {
-    int32_t rc = NO_ERROR;
-    if(m_nNumEntries >= MAX_EXIF_TABLE_ENTRIES) {
-        ALOGE("%s: Number of entries exceeded limit", __func__);
+    if (cam_exif_add_entry(&m_Arena, m_Entries, &m_nNumEntries,
+            MAX_EXIF_TABLE_ENTRIES, tagid, type, count, data) != 0) {
+        ALOGE("%s: No room for tag 0x%x", __func__, tagid);
         return NO_MEMORY;
     }
-
-    m_Entries[m_nNumEntries].tag_id = tagid;
-    m_Entries[m_nNumEntries].tag_entry.type = type;
-    m_Entries[m_nNumEntries].tag_entry.count = count;
-    m_Entries[m_nNumEntries].tag_entry.copy = 1;
-    switch (type) {
-    case EXIF_BYTE:
-        {
-            if (count > 1) {
-                uint8_t *values = (uint8_t *)malloc(count);
-                if (values == NULL) {
-                    ALOGE("%s: No memory for byte array", __func__);
-                    rc = NO_MEMORY;
-                } else {
-                    memcpy(values, data, count);
-                    m_Entries[m_nNumEntries].tag_entry.data._bytes = values;
-                }
-            } else {
-                m_Entries[m_nNumEntries].tag_entry.data._byte = *(uint8_t *)data;
-            }
-        }
-        break;
-    case EXIF_ASCII:
-        {
-            char *str = NULL;
-            str = (char *)malloc(count + 1);
-            if (str == NULL) {
-                ALOGE("%s: No memory for ascii string", __func__);
-                rc = NO_MEMORY;
-            } else {
-                memset(str, 0, count + 1);
-                memcpy(str, data, count);
-                m_Entries[m_nNumEntries].tag_entry.data._ascii = str;
-            }
-        }
-        break;
-    case EXIF_SHORT:
-        {
-            if (count > 1) {
-                uint16_t *values = (uint16_t *)malloc(count * sizeof(uint16_t));
-                if (values == NULL) {
-                    ALOGE("%s: No memory for short array", __func__);
-                    rc = NO_MEMORY;
-                } else {
-                    memcpy(values, data, count * sizeof(uint16_t));
-                    m_Entries[m_nNumEntries].tag_entry.data._shorts = values;
-                }
-            } else {
-                m_Entries[m_nNumEntries].tag_entry.data._short = *(uint16_t *)data;
-            }
-        }
-        break;
-    case EXIF_LONG:
-        {
-            if (count > 1) {
-                uint32_t *values = (uint32_t *)malloc(count * sizeof(uint32_t));
-                if (values == NULL) {
-                    ALOGE("%s: No memory for long array", __func__);
-                    rc = NO_MEMORY;
-                } else {
-                    memcpy(values, data, count * sizeof(uint32_t));
-                    m_Entries[m_nNumEntries].tag_entry.data._longs = values;
-                }
-            } else {
-                m_Entries[m_nNumEntries].tag_entry.data._long = *(uint32_t *)data;
-            }
-        }
-        break;
-    case EXIF_RATIONAL:
-        {
-            if (count > 1) {
-                rat_t *values = (rat_t *)malloc(count * sizeof(rat_t));
-                if (values == NULL) {
-                    ALOGE("%s: No memory for rational array", __func__);
-                    rc = NO_MEMORY;
-                } else {
-                    memcpy(values, data, count * sizeof(rat_t));
-                    m_Entries[m_nNumEntries].tag_entry.data._rats = values;
-                }
-            } else {
-                m_Entries[m_nNumEntries].tag_entry.data._rat = *(rat_t *)data;
-            }
-        }
-        break;
-    case EXIF_UNDEFINED:
-        {
-            uint8_t *values = (uint8_t *)malloc(count);
-            if (values == NULL) {
-                ALOGE("%s: No memory for undefined array", __func__);
-                rc = NO_MEMORY;
-            } else {
-                memcpy(values, data, count);
-                m_Entries[m_nNumEntries].tag_entry.data._undefined = values;
-            }
-        }
-        break;
-    case EXIF_SLONG:
-        {
-            if (count > 1) {
-                int32_t *values = (int32_t *)malloc(count * sizeof(int32_t));
-                if (values == NULL) {
-                    ALOGE("%s: No memory for signed long array", __func__);
-                    rc = NO_MEMORY;
-                } else {
-                    memcpy(values, data, count * sizeof(int32_t));
-                    m_Entries[m_nNumEntries].tag_entry.data._slongs = values;
-                }
-            } else {
-                m_Entries[m_nNumEntries].tag_entry.data._slong = *(int32_t *)data;
-            }
-        }
-        break;
-    case EXIF_SRATIONAL:
-        {
-            if (count > 1) {
-                srat_t *values = (srat_t *)malloc(count * sizeof(srat_t));
-                if (values == NULL) {
-                    ALOGE("%s: No memory for signed rational array", __func__);
-                    rc = NO_MEMORY;
-                } else {
-                    memcpy(values, data, count * sizeof(srat_t));
-                    m_Entries[m_nNumEntries].tag_entry.data._srats = values;
-                }
-            } else {
-                m_Entries[m_nNumEntries].tag_entry.data._srat = *(srat_t *)data;
-            }
-        }
-        break;
-    }
-
-    // Increase number of entries
-    m_nNumEntries++;
-    return rc;
+    return NO_ERROR;
 }
 
 }; // namespace qcamera
@@ -33,10 +33,13 @@
 extern "C" {
 #include <mm_camera_interface.h>
 #include <mm_jpeg_interface.h>
+#include <cam_exif_arena.h>
 }
 #include "QCamera2HWI.h"
+#include "QCameraRingQueue.h"
 
 #define MAX_JPEG_BURST 2
+#define MAX_POSTPROC_INPUT_Q_DEPTH 64
 
 namespace qcamera {
 
@@ -99,6 +102,7 @@ public:
 private:
     QEXIF_INFO_DATA m_Entries[MAX_EXIF_TABLE_ENTRIES];  // exif tags for JPEG encoder
     uint32_t  m_nNumEntries;                            // number of valid entries
+    cam_exif_arena_t m_Arena;                           // storage of tag payloads
 };
 
 class QCameraPostProcessor
@@ -134,6 +138,14 @@ private:
                                   QCameraStream *thumb_stream);
     int32_t encodeData(qcamera_jpeg_data_t *jpeg_job_data,
                        uint8_t &needNewSess);
+    int32_t configThumbScale(mm_jpeg_encode_params_t& encode_parm,
+                             QCameraStream *main_stream);
+    int32_t scaleThumbnail(QCameraStream *main_stream,
+                           mm_camera_buf_def_t *main_frame,
+                           const cam_rect_t &crop,
+                           uint32_t jpeg_rotation,
+                           cam_dimension_t &thumb_dim);
+    void releaseThumbScaleBufs();
     int32_t queryStreams(QCameraStream **main,
             QCameraStream **thumb,
             QCameraStream **reproc,
@@ -182,12 +194,12 @@ private:
 
     int8_t                     m_bInited; // if postproc is inited
 
-    QCameraQueue m_inputPPQ;            // input queue for postproc
+    QCameraRingQueue m_inputPPQ;        // input queue for postproc
     QCameraQueue m_ongoingPPQ;          // ongoing postproc queue
-    QCameraQueue m_inputJpegQ;          // input jpeg job queue
+    QCameraRingQueue m_inputJpegQ;      // input jpeg job queue
     QCameraQueue m_ongoingJpegQ;        // ongoing jpeg job queue
-    QCameraQueue m_inputRawQ;           // input raw job queue
-    QCameraQueue m_inputSaveQ;          // input save job queue
+    QCameraRingQueue m_inputRawQ;       // input raw job queue
+    QCameraRingQueue m_inputSaveQ;      // input save job queue
     QCameraCmdThread m_dataProcTh;      // thread for data processing
     QCameraCmdThread m_saveProcTh;      // thread for storing buffers
     uint32_t mSaveFrmCnt;               // save frame counter
@@ -197,6 +209,10 @@ private:
     bool mJpegMemOpt;
     uint32_t   m_JpegOutputMemCount;
     uint8_t mNewJpegSessionNeeded;
+    bool mThumbHalScale;                // scale thumbnail from main in HAL
+    bool mThumbScaleActive;             // current session uses m_pThumbScaleMem
+    QCameraHeapMemory *m_pThumbScaleMem; // one scaled thumbnail per main buf
+    cam_frame_len_offset_t m_thumbScaleOffset;
 };
 
 }; // namespace qcamera
@@ -242,6 +242,8 @@ QCameraStream::QCameraStream(QCameraAllocator &allocator,
         mDataCB(NULL),
         mUserData(NULL),
         mDataQ(releaseFrameData, this),
+        mExecutor(NULL),
+        mExecLane(-1),
         mStreamInfoBuf(NULL),
         mStreamBufs(NULL),
         mAllocator(allocator),
@@ -544,9 +546,13 @@ int32_t QCameraStream::calcOffset(cam_stream_info_t *streamInfo)
 int32_t QCameraStream::start()
 {
     int32_t rc = 0;
-    rc = mProcTh.launch(dataProcRoutine, this);
-    if (rc == NO_ERROR) {
+    if (openExecLane()) {
         m_bActive = true;
+    } else {
+        rc = mProcTh.launch(dataProcRoutine, this);
+        if (rc == NO_ERROR) {
+            m_bActive = true;
+        }
     }
     pthread_mutex_init(&m_lock, NULL);
     pthread_cond_init(&m_cond, NULL);
@@ -568,10 +574,69 @@ int32_t QCameraStream::stop()
 {
     int32_t rc = 0;
     m_bActive = false;
-    rc = mProcTh.exit();
+    if (mExecLane >= 0) {
+        rc = mExecutor->closeLane(mExecLane);
+        mExecLane = -1;
+    } else {
+        rc = mProcTh.exit();
+    }
     return rc;
 }
 
+/*===========================================================================
+ * FUNCTION   : openExecLane
+ *
+ * DESCRIPTION: open a lane on the shared stream executor when the stream type
+ *              is set in persist.camera.exec.streams (bit mask of
+ *              cam_stream_type_t). Frames of the stream are then processed
+ *              on the executor workers instead of a dedicated thread.
+ *              persist.camera.exec.cpu.<type> and persist.camera.exec.nice.<type>
+ *              give the cpu and nice value of the lane.
+ *
+ * PARAMETERS : none
+ *
+ * RETURN     : true if the stream uses the shared executor
+ *==========================================================================*/
+bool QCameraStream::openExecLane()
+{
+    char prop[PROPERTY_VALUE_MAX];
+    char value[PROPERTY_VALUE_MAX];
+    char name[EXEC_LANE_NAME_LEN];
+    exec_lane_attr_t attr;
+    int type = (int)mStreamInfo->stream_type;
+
+    property_get("persist.camera.exec.streams", value, "0");
+    if (!((uint32_t)strtoul(value, NULL, 0) & (1U << type))) {
+        return false;
+    }
+
+    property_get("persist.camera.exec.workers", value, "2");
+    mExecutor = QCameraExecutor::getInstance((uint32_t)atoi(value));
+    if (NULL == mExecutor) {
+        return false;
+    }
+
+    memset(&attr, 0, sizeof(attr));
+    snprintf(name, sizeof(name), "strm_%d_%u", type, mHandle & 0xFF);
+    attr.name = name;
+    snprintf(prop, sizeof(prop), "persist.camera.exec.cpu.%d", type);
+    property_get(prop, value, "-1");
+    attr.cpu = atoi(value);
+    snprintf(prop, sizeof(prop), "persist.camera.exec.nice.%d", type);
+    property_get(prop, value, "0");
+    attr.nice = atoi(value);
+
+    mExecLane = mExecutor->openLane(dataProcJob, releaseFrameData, this, &attr);
+    if (mExecLane < 0) {
+        ALOGE("%s: No executor lane for stream type %d, using own thread",
+              __func__, type);
+        return false;
+    }
+    CDBG_HIGH("%s: stream type %d on executor lane %d", __func__, type,
+          mExecLane);
+    return true;
+}
+
 /*===========================================================================
  * FUNCTION   : syncRuntimeParams
  *
@@ -670,9 +735,12 @@ int32_t QCameraStream::processZoomDone(preview_stream_ops_t *previewWindow,
 int32_t QCameraStream::processDataNotify(mm_camera_super_buf_t *frame)
 {
     CDBG("%s:\n", __func__);
-    if (m_bActive) {
+    if (m_bActive && (mExecLane < 0)) {
         mDataQ.enqueue((void *)frame);
         return mProcTh.sendCmd(CAMERA_CMD_TYPE_DO_NEXT_JOB, FALSE, FALSE);
+    } else if (m_bActive &&
+            (NO_ERROR == mExecutor->post(mExecLane, (void *)frame))) {
+        return NO_ERROR;
     } else {
         CDBG_HIGH("%s: Stream thread is not active, no ops here", __func__);
         bufDone(frame->bufs[0]->buf_idx);
@@ -756,13 +824,7 @@ void *QCameraStream::dataProcRoutine(void *data)
                 mm_camera_super_buf_t *frame =
                     (mm_camera_super_buf_t *)pme->mDataQ.dequeue();
                 if (NULL != frame) {
-                    if (pme->mDataCB != NULL) {
-                        pme->mDataCB(frame, pme, pme->mUserData);
-                    } else {
-                        // no data cb routine, return buf here
-                        pme->bufDone(frame->bufs[0]->buf_idx);
-                        free(frame);
-                    }
+                    dataProcJob(frame, pme);
                 }
             }
             break;
@@ -780,6 +842,32 @@ void *QCameraStream::dataProcRoutine(void *data)
     return NULL;
 }
 
+/*===========================================================================
+ * FUNCTION   : dataProcJob
+ *
+ * DESCRIPTION: process one frame, from the stream thread or from a lane of
+ *              the shared executor
+ *
+ * PARAMETERS :
+ *   @job     : stream frame
+ *   @data    : user data ptr (stream object)
+ *
+ * RETURN     : none
+ *==========================================================================*/
+void QCameraStream::dataProcJob(void *job, void *data)
+{
+    QCameraStream *pme = (QCameraStream *)data;
+    mm_camera_super_buf_t *frame = (mm_camera_super_buf_t *)job;
+
+    if (pme->mDataCB != NULL) {
+        pme->mDataCB(frame, pme, pme->mUserData);
+    } else {
+        // no data cb routine, return buf here
+        pme->bufDone(frame->bufs[0]->buf_idx);
+        free(frame);
+    }
+}
+
 /*===========================================================================
  * FUNCTION   : bufDone
  *
@@ -892,34 +980,20 @@ int32_t QCameraStream::getBufs(cam_frame_len_offset_t *offset,
         return NO_MEMORY;
     }
 
-    for (uint32_t i = 0; i < numBufAlloc; i++) {
-        ssize_t bufSize = mStreamBufs->getSize(i);
-        if (BAD_INDEX != bufSize) {
-            rc = ops_tbl->map_ops(i, -1, mStreamBufs->getFd(i),
-                    (uint32_t)bufSize, ops_tbl->userdata);
-            if (rc < 0) {
-                ALOGE("%s: map_stream_buf failed: %d", __func__, rc);
-                for (uint32_t j = 0; j < i; j++) {
-                    ops_tbl->unmap_ops(j, -1, ops_tbl->userdata);
-                }
-                mStreamBufs->deallocate();
-                delete mStreamBufs;
-                mStreamBufs = NULL;
-                return INVALID_OPERATION;
-            }
-        } else {
-            ALOGE("Failed to retrieve buffer size (bad index)");
-            return INVALID_OPERATION;
-        }
+    rc = mapBufs(0, numBufAlloc, ops_tbl);
+    if (rc < 0) {
+        ALOGE("%s: map_stream_buf failed: %d", __func__, rc);
+        mStreamBufs->deallocate();
+        delete mStreamBufs;
+        mStreamBufs = NULL;
+        return INVALID_OPERATION;
     }
 
     //regFlags array is allocated by us, but consumed and freed by mm-camera-interface
     regFlags = (uint8_t *)malloc(sizeof(uint8_t) * mNumBufs);
     if (!regFlags) {
         ALOGE("%s: Out of memory", __func__);
-        for (uint32_t i = 0; i < numBufAlloc; i++) {
-            ops_tbl->unmap_ops(i, -1, ops_tbl->userdata);
-        }
+        unmapBufs(0, numBufAlloc, ops_tbl);
         mStreamBufs->deallocate();
         delete mStreamBufs;
         mStreamBufs = NULL;
@@ -930,9 +1004,7 @@ int32_t QCameraStream::getBufs(cam_frame_len_offset_t *offset,
     mBufDefs = (mm_camera_buf_def_t *)malloc(mNumBufs * sizeof(mm_camera_buf_def_t));
     if (mBufDefs == NULL) {
         ALOGE("%s: getRegFlags failed %d", __func__, rc);
-        for (uint32_t i = 0; i < numBufAlloc; i++) {
-            ops_tbl->unmap_ops(i, -1, ops_tbl->userdata);
-        }
+        unmapBufs(0, numBufAlloc, ops_tbl);
         mStreamBufs->deallocate();
         delete mStreamBufs;
         mStreamBufs = NULL;
@@ -948,9 +1020,7 @@ int32_t QCameraStream::getBufs(cam_frame_len_offset_t *offset,
     rc = mStreamBufs->getRegFlags(regFlags);
     if (rc < 0) {
         ALOGE("%s: getRegFlags failed %d", __func__, rc);
-        for (uint32_t i = 0; i < numBufAlloc; i++) {
-            ops_tbl->unmap_ops(i, -1, ops_tbl->userdata);
-        }
+        unmapBufs(0, numBufAlloc, ops_tbl);
         mStreamBufs->deallocate();
         delete mStreamBufs;
         mStreamBufs = NULL;
@@ -1149,21 +1219,16 @@ void *QCameraStream::BufAllocRoutine(void *data)
                                                    pme->mFrameLenOffset.frame_len,
                                                    pme->mNumBufsNeedAlloc);
         if (rc == NO_ERROR){
-            for (uint32_t i = numBufAlloc; i < pme->mNumBufs; i++) {
-                ssize_t bufSize = pme->mStreamBufs->getSize(i);
-                if (BAD_INDEX != bufSize) {
-                    rc = pme->m_MemOpsTbl.map_ops(i, -1, pme->mStreamBufs->getFd(i),
-                            (uint32_t)bufSize, pme->m_MemOpsTbl.userdata);
-                    if (rc == 0) {
-                        pme->mStreamBufs->getBufDef(pme->mFrameLenOffset, pme->mBufDefs[i], i);
-                        pme->mCamOps->qbuf(pme->mCamHandle, pme->mChannelHandle,
-                                &pme->mBufDefs[i]);
-                    } else {
-                        ALOGE("%s: map_stream_buf %d failed: %d", __func__, rc, i);
-                    }
-                } else {
-                    ALOGE("Failed to retrieve buffer size (bad index)");
+            rc = pme->mapBufs(numBufAlloc, pme->mNumBufsNeedAlloc,
+                    &pme->m_MemOpsTbl);
+            if (rc == 0) {
+                for (uint32_t i = numBufAlloc; i < pme->mNumBufs; i++) {
+                    pme->mStreamBufs->getBufDef(pme->mFrameLenOffset, pme->mBufDefs[i], i);
+                    pme->mCamOps->qbuf(pme->mCamHandle, pme->mChannelHandle,
+                            &pme->mBufDefs[i]);
                 }
+            } else {
+                ALOGE("%s: map_stream_buf failed: %d", __func__, rc);
             }
 
             pme->mNumBufsNeedAlloc = 0;
@@ -1228,11 +1293,9 @@ int32_t QCameraStream::putBufs(mm_camera_map_unmap_ops_tbl_t *ops_tbl)
         CDBG_HIGH("%s: return from buf allocation thread", __func__);
     }
 
-    for (uint32_t i = 0; i < mNumBufs; i++) {
-        rc = ops_tbl->unmap_ops(i, -1, ops_tbl->userdata);
-        if (rc < 0) {
-            ALOGE("%s: map_stream_buf failed: %d", __func__, rc);
-        }
+    rc = unmapBufs(0, mNumBufs, ops_tbl);
+    if (rc < 0) {
+        ALOGE("%s: map_stream_buf failed: %d", __func__, rc);
     }
     mBufDefs = NULL; // mBufDefs just keep a ptr to the buffer
                      // mm-camera-interface own the buffer, so no need to free
@@ -1245,6 +1308,136 @@ int32_t QCameraStream::putBufs(mm_camera_map_unmap_ops_tbl_t *ops_tbl)
     return rc;
 }
 
+/*===========================================================================
+ * FUNCTION   : mapBufs
+ *
+ * DESCRIPTION: map a range of stream buffers to server. All buffers of the
+ *              range go in one domain socket message when the ops table
+ *              provides bundled mapping, otherwise or when the bundled
+ *              message fails one message per buffer.
+ *
+ * PARAMETERS :
+ *   @first      : index of first buffer to map
+ *   @count      : number of buffers to map
+ *   @ops_tbl    : ptr to buf mapping/unmapping ops
+ *
+ * RETURN     : int32_t type of status
+ *              NO_ERROR  -- success, all buffers mapped
+ *              none-zero failure code, no buffer of the range left mapped
+ *==========================================================================*/
+int32_t QCameraStream::mapBufs(uint32_t first, uint32_t count,
+        mm_camera_map_unmap_ops_tbl_t *ops_tbl)
+{
+    int32_t rc = NO_ERROR;
+    uint32_t end = first + count;
+    uint32_t i = first;
+    cam_buf_map_type_list bufMapList;
+
+    while (i < end) {
+        uint32_t batchStart = i;
+        bool mapped = false;
+        memset(&bufMapList, 0, sizeof(bufMapList));
+        while ((i < end) && (bufMapList.length < CAM_MAX_NUM_BUFS_PER_MAP)) {
+            ssize_t bufSize = mStreamBufs->getSize(i);
+            if (BAD_INDEX == bufSize) {
+                ALOGE("%s: Bad index %u", __func__, i);
+                rc = BAD_INDEX;
+                break;
+            }
+            cam_buf_map_type *bufMap =
+                    &bufMapList.buf_maps[bufMapList.length++];
+            bufMap->type = CAM_MAPPING_BUF_TYPE_STREAM_BUF;
+            bufMap->frame_idx = i;
+            bufMap->plane_idx = -1;
+            bufMap->fd = mStreamBufs->getFd(i);
+            bufMap->size = (size_t)bufSize;
+            i++;
+        }
+        // nothing of the current batch reached the server yet
+        i = batchStart;
+        if ((rc == NO_ERROR) && (NULL != ops_tbl->bundled_map_ops)) {
+            if (ops_tbl->bundled_map_ops(&bufMapList,
+                    ops_tbl->userdata) >= 0) {
+                i += bufMapList.length;
+                mapped = true;
+            } else {
+                ALOGE("%s: bundled mapping failed, mapping one by one",
+                        __func__);
+            }
+        }
+        for (uint32_t j = 0; (rc == NO_ERROR) && !mapped &&
+                (j < bufMapList.length); j++) {
+            cam_buf_map_type *bufMap = &bufMapList.buf_maps[j];
+            rc = ops_tbl->map_ops(bufMap->frame_idx, -1, bufMap->fd,
+                    (uint32_t)bufMap->size, ops_tbl->userdata);
+            if (rc >= 0) {
+                i++;
+            }
+        }
+        if (rc < 0) {
+            ALOGE("%s: mapping buffer %u failed: %d", __func__, i, rc);
+            if (i > first) {
+                unmapBufs(first, i - first, ops_tbl);
+            }
+            return rc;
+        }
+    }
+
+    return NO_ERROR;
+}
+
+/*===========================================================================
+ * FUNCTION   : unmapBufs
+ *
+ * DESCRIPTION: unmap a range of stream buffers from server, in one domain
+ *              socket message when the ops table provides bundled unmapping
+ *
+ * PARAMETERS :
+ *   @first      : index of first buffer to unmap
+ *   @count      : number of buffers to unmap
+ *   @ops_tbl    : ptr to buf mapping/unmapping ops
+ *
+ * RETURN     : int32_t type of status
+ *              NO_ERROR  -- success
+ *              none-zero failure code of the last failed unmapping
+ *==========================================================================*/
+int32_t QCameraStream::unmapBufs(uint32_t first, uint32_t count,
+        mm_camera_map_unmap_ops_tbl_t *ops_tbl)
+{
+    int32_t rc = NO_ERROR;
+    uint32_t end = first + count;
+    uint32_t i = first;
+    cam_buf_unmap_type_list bufUnmapList;
+
+    while (i < end) {
+        memset(&bufUnmapList, 0, sizeof(bufUnmapList));
+        for (; (i < end) && (bufUnmapList.length < CAM_MAX_NUM_BUFS_PER_MAP);
+                i++) {
+            cam_buf_unmap_type *bufUnmap =
+                    &bufUnmapList.buf_unmaps[bufUnmapList.length++];
+            bufUnmap->type = CAM_MAPPING_BUF_TYPE_STREAM_BUF;
+            bufUnmap->frame_idx = i;
+            bufUnmap->plane_idx = -1;
+        }
+        if ((NULL != ops_tbl->bundled_unmap_ops) &&
+                (ops_tbl->bundled_unmap_ops(&bufUnmapList,
+                        ops_tbl->userdata) >= 0)) {
+            continue;
+        }
+        // no bundled unmapping, or the server rejected it
+        for (uint32_t j = 0; j < bufUnmapList.length; j++) {
+            int32_t ret = ops_tbl->unmap_ops(
+                    bufUnmapList.buf_unmaps[j].frame_idx, -1,
+                    ops_tbl->userdata);
+            if (ret < 0) {
+                rc = ret;
+            }
+        }
+    }
+
+    return rc;
+}
+
 /*===========================================================================
  * FUNCTION   : invalidateBuf
  *
@@ -32,6 +32,7 @@
 
 #include <hardware/camera.h>
 #include "QCameraCmdThread.h"
+#include "QCameraExecutor.h"
 #include "QCameraMem.h"
 #include "QCameraAllocator.h"
 
@@ -75,6 +76,7 @@ public:
 
     static void dataNotifyCB(mm_camera_super_buf_t *recvd_frame, void *userdata);
     static void *dataProcRoutine(void *data);
+    static void dataProcJob(void *job, void *data);
     static void *BufAllocRoutine(void *data);
     uint32_t getMyHandle() const {return mHandle;}
     bool isTypeOf(cam_stream_type_t type);
@@ -127,6 +129,8 @@ private:
 
     QCameraQueue     mDataQ;
     QCameraCmdThread mProcTh; // thread for dataCB
+    QCameraExecutor *mExecutor; // shared executor used instead of mProcTh
+    int32_t mExecLane; // lane of the stream on mExecutor, -1 if none
 
     QCameraHeapMemory *mStreamInfoBuf;
     QCameraMemory *mStreamBufs;
@@ -178,6 +182,11 @@ private:
                      mm_camera_buf_def_t **bufs,
                      mm_camera_map_unmap_ops_tbl_t *ops_tbl);
     int32_t putBufs(mm_camera_map_unmap_ops_tbl_t *ops_tbl);
+    int32_t mapBufs(uint32_t first, uint32_t count,
+                     mm_camera_map_unmap_ops_tbl_t *ops_tbl);
+    int32_t unmapBufs(uint32_t first, uint32_t count,
+                     mm_camera_map_unmap_ops_tbl_t *ops_tbl);
+    bool openExecLane();
     int32_t invalidateBuf(uint32_t index);
     int32_t cleanInvalidateBuf(uint32_t index);
     int32_t calcOffset(cam_stream_info_t *streamInfo);
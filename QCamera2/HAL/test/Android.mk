@@ -48,3 +48,81 @@ LOCAL_CFLAGS += -O0
 include $(BUILD_EXECUTABLE)
 
 
+
+#memory pool replay test
+
+include $(CLEAR_VARS)
+
+LOCAL_SRC_FILES:= \
+    qcamera_mempool_test.cpp \
+    ../QCameraMem.cpp \
+
+LOCAL_SHARED_LIBRARIES:= \
+    libcamera_client \
+    liblog \
+    libhardware \
+    libutils \
+    libcutils \
+    libui \
+
+LOCAL_C_INCLUDES += \
+    $(LOCAL_PATH)/.. \
+    $(LOCAL_PATH)/../../stack/common \
+    $(LOCAL_PATH)/../../stack/mm-camera-interface/inc \
+    $(LOCAL_PATH)/../../stack/mm-jpeg-interface/inc \
+    $(LOCAL_PATH)/../../util \
+    $(LOCAL_PATH)/../../../mm-image-codec/qexif \
+    $(LOCAL_PATH)/../../../mm-image-codec/qomx_core \
+    frameworks/native/include/media/openmax \
+    frameworks/native/include/media/hardware \
+    hardware/qcom/display/libgralloc \
+    hardware/qcom/media/libstagefrighthw \
+    system/media/camera/include \
+    $(TARGET_OUT_INTERMEDIATES)/KERNEL_OBJ/usr/include \
+
+LOCAL_MODULE:= qcamera-mempool-test
+LOCAL_MODULE_TAGS:= tests
+
+LOCAL_CFLAGS += -Wall -Wextra -Werror -Wno-unused-parameter
+
+include $(BUILD_EXECUTABLE)
+
+#HAL3 in flight depth replay
+
+include $(CLEAR_VARS)
+
+LOCAL_SRC_FILES:= \
+    qcamera3_inflight_replay.cpp \
+    ../../HAL3/QCamera3InFlight.cpp \
+
+LOCAL_SHARED_LIBRARIES:= \
+    liblog \
+    libutils \
+    libcutils \
+
+LOCAL_C_INCLUDES += \
+    $(LOCAL_PATH)/../../HAL3 \
+
+LOCAL_MODULE:= qcamera3-inflight-replay
+LOCAL_MODULE_TAGS:= tests
+
+LOCAL_CFLAGS += -Wall -Wextra -Werror -Wno-unused-parameter
+
+include $(BUILD_EXECUTABLE)
+
+#HAL3 frame ring out of order replay
+
+include $(CLEAR_VARS)
+
+LOCAL_SRC_FILES:= \
+    qcamera3_framering_test.cpp \
+
+LOCAL_C_INCLUDES += \
+    $(LOCAL_PATH)/../../HAL3 \
+
+LOCAL_MODULE:= qcamera3-framering-test
+LOCAL_MODULE_TAGS:= tests
+
+LOCAL_CFLAGS += -Wall -Wextra -Werror -Wno-unused-parameter
+
+include $(BUILD_EXECUTABLE)
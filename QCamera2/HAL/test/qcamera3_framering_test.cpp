@@ -0,0 +1,290 @@
+/* Copyright (c) 2014, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+// Replays out of order completions through QCamera3FrameRing and checks
+// it against a linear list, the structure HAL3 used before the ring.
+//
+// Requests are inserted in frame number order, the way
+// processCaptureRequest adds them. Their buffers, metadata and drops
+// complete out of order within a window of in flight frames, the way
+// captureResultCb sees them. After every step find, first/next iteration
+// order and size must match the reference. Runs start right below the
+// frame number wrap, and one run uses a window larger than the initial
+// capacity. The slot array must never grow beyond the window.
+//
+// usage: qcamera3-framering-test [-n frames] [-s seed]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "QCamera3FrameRing.h"
+
+using namespace qcamera;
+
+#define REF_MAX_ENTRIES 1024
+#define DEFAULT_FRAMES 20000
+
+static int g_failures = 0;
+
+#define TEST_CHECK(cond) do { \
+    if (!(cond)) { \
+        printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+        g_failures++; \
+    } \
+} while (0)
+
+typedef struct {
+    uint32_t frame_number;
+    uint32_t buffers;   // buffers still to come back
+    bool meta;          // metadata still to come back
+} TestRequest;
+
+/*===========================================================================
+ * CLASS      : RefList
+ *
+ * DESCRIPTION: reference bookkeeping, unsorted array searched linearly
+ *==========================================================================*/
+class RefList {
+public:
+    RefList() : mCount(0) {}
+
+    TestRequest *find(uint32_t frameNumber)
+    {
+        for (uint32_t i = 0; i < mCount; i++) {
+            if (mEntries[i].frame_number == frameNumber) {
+                return &mEntries[i];
+            }
+        }
+        return NULL;
+    }
+    TestRequest *insert(uint32_t frameNumber)
+    {
+        if (mCount >= REF_MAX_ENTRIES) {
+            return NULL;
+        }
+        memset(&mEntries[mCount], 0, sizeof(TestRequest));
+        mEntries[mCount].frame_number = frameNumber;
+        return &mEntries[mCount++];
+    }
+    void erase(uint32_t frameNumber)
+    {
+        TestRequest *entry = find(frameNumber);
+        if (entry != NULL) {
+            *entry = mEntries[--mCount];
+        }
+    }
+    // lowest frame number after frameNumber, wrap aware, base is the
+    // oldest live frame
+    TestRequest *next(uint32_t base, uint32_t frameNumber, bool first)
+    {
+        TestRequest *best = NULL;
+        for (uint32_t i = 0; i < mCount; i++) {
+            uint32_t d = mEntries[i].frame_number - base;
+            if (!first && d <= frameNumber - base) {
+                continue;
+            }
+            if (best == NULL || d < best->frame_number - base) {
+                best = &mEntries[i];
+            }
+        }
+        return best;
+    }
+    uint32_t size() const { return mCount; }
+    TestRequest *at(uint32_t i) { return &mEntries[i]; }
+
+private:
+    TestRequest mEntries[REF_MAX_ENTRIES];
+    uint32_t mCount;
+};
+
+static void compare(QCamera3FrameRing<TestRequest> &ring, RefList &ref,
+        uint32_t base)
+{
+    TEST_CHECK(ring.size() == ref.size());
+    TEST_CHECK(ring.empty() == (ref.size() == 0));
+
+    for (uint32_t i = 0; i < ref.size(); i++) {
+        TestRequest *expected = ref.at(i);
+        TestRequest *got = ring.find(expected->frame_number);
+        TEST_CHECK(got != NULL);
+        if (got != NULL) {
+            TEST_CHECK(got->frame_number == expected->frame_number);
+            TEST_CHECK(got->buffers == expected->buffers);
+            TEST_CHECK(got->meta == expected->meta);
+        }
+    }
+
+    TestRequest *r = ring.first();
+    TestRequest *e = ref.next(base, 0, true);
+    uint32_t visited = 0;
+    while (r != NULL && e != NULL) {
+        TEST_CHECK(r->frame_number == e->frame_number);
+        visited++;
+        uint32_t frame = r->frame_number;
+        r = ring.next(frame);
+        e = ref.next(base, frame, false);
+    }
+    TEST_CHECK(r == NULL && e == NULL);
+    TEST_CHECK(visited == ref.size());
+}
+
+static void complete(QCamera3FrameRing<TestRequest> &ring, RefList &ref,
+        uint32_t frameNumber, bool buffer)
+{
+    TestRequest *r = ring.find(frameNumber);
+    TestRequest *e = ref.find(frameNumber);
+    TEST_CHECK((r == NULL) == (e == NULL));
+    if (r == NULL || e == NULL) {
+        return;
+    }
+    if (buffer && e->buffers > 0) {
+        r->buffers--;
+        e->buffers--;
+    } else if (!buffer) {
+        r->meta = false;
+        e->meta = false;
+    }
+    if (e->buffers == 0 && !e->meta) {
+        ring.erase(frameNumber);
+        ref.erase(frameNumber);
+    }
+}
+
+/*===========================================================================
+ * FUNCTION   : replay
+ *
+ * DESCRIPTION: submit frames in order and complete them out of order
+ *
+ * PARAMETERS :
+ *   @start  : first frame number
+ *   @frames : number of frames to submit
+ *   @window : maximum span of frame numbers in flight
+ *
+ * RETURN     : None
+ *==========================================================================*/
+static void replay(uint32_t start, uint32_t frames, uint32_t window)
+{
+    QCamera3FrameRing<TestRequest> ring;
+    RefList ref;
+    uint32_t next = start;
+    uint32_t maxCapacity = 32;
+
+    while (maxCapacity < window) {
+        maxCapacity <<= 1;
+    }
+    while (next - start < frames || ref.size() > 0) {
+        uint32_t oldest = ref.size() ? ref.next(start, 0, true)->frame_number
+                                     : next;
+        bool submit = (next - start < frames) &&
+            (next - oldest < window) && (rand() % 3 != 0);
+        if (submit) {
+            TestRequest *r = ring.insert(next);
+            TestRequest *e = ref.insert(next);
+            TEST_CHECK(r != NULL && e != NULL);
+            if (r == NULL || e == NULL) {
+                return;
+            }
+            r->frame_number = e->frame_number = next;
+            r->buffers = e->buffers = 1 + rand() % 3;
+            r->meta = e->meta = true;
+            // re-inserting a live frame returns the same entry
+            TEST_CHECK(ring.insert(next) == r);
+            next++;
+        } else if (ref.size() > 0) {
+            // any live frame completes, drops included, as seen when
+            // reprocess and regular requests finish out of order
+            TestRequest *e = ref.at(rand() % ref.size());
+            complete(ring, ref, e->frame_number, rand() % 2 == 0);
+        }
+
+        // lookups of frames that are not live
+        TEST_CHECK(ring.find(next) == NULL);
+        TEST_CHECK(ring.find(start - 1) == NULL);
+        ring.erase(next + 7);
+
+        compare(ring, ref, oldest);
+        TEST_CHECK(ring.capacity() <= maxCapacity);
+    }
+
+    TEST_CHECK(ring.empty());
+    TEST_CHECK(ring.first() == NULL);
+    printf("start %10u, window %3u: %u frames, capacity %u\n",
+           start, window, frames, ring.capacity());
+}
+
+static void clearAndReuse()
+{
+    QCamera3FrameRing<TestRequest> ring(4);
+    for (uint32_t i = 0; i < 20; i++) {
+        TEST_CHECK(ring.insert(i * 3) != NULL);
+    }
+    TEST_CHECK(ring.size() == 20);
+    uint32_t capacity = ring.capacity();
+    TEST_CHECK(capacity >= 64);
+    ring.clear();
+    TEST_CHECK(ring.empty());
+    TEST_CHECK(ring.first() == NULL);
+    TEST_CHECK(ring.find(0) == NULL);
+    TEST_CHECK(ring.capacity() == capacity);
+    // flush followed by requests far away from the old frame numbers
+    TEST_CHECK(ring.insert(100000) != NULL);
+    TEST_CHECK(ring.first() == ring.find(100000));
+    TEST_CHECK(ring.next(100000) == NULL);
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t frames = DEFAULT_FRAMES;
+    unsigned int seed = 1;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:s:")) != -1) {
+        switch (opt) {
+        case 'n':
+            frames = (uint32_t)atoi(optarg);
+            break;
+        case 's':
+            seed = (unsigned int)atoi(optarg);
+            break;
+        default:
+            printf("usage: %s [-n frames] [-s seed]\n", argv[0]);
+            return 1;
+        }
+    }
+    srand(seed);
+
+    clearAndReuse();
+    replay(0, frames, 8);
+    replay(0xFFFFFFFF - frames / 2, frames, 8);
+    replay(0xFFFFFFF0, frames, 100);
+
+    printf("%s: %d failures\n", g_failures ? "FAIL" : "PASS", g_failures);
+    return g_failures ? 1 : 0;
+}
@@ -0,0 +1,412 @@
+/* Copyright (c) 2014, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+// Replays capture request traces through QCamera3InFlight against a fake
+// backend and prints throughput, stalls and depth per depth limit.
+//
+// The fake backend stands in for mm_camera_ops and the channels: the
+// sensor streams continuously, one frame per frame duration, and takes
+// the next queued request if there is one. Metadata of every frame comes
+// back a fixed pipeline latency after the frame started. The request
+// gate mirrors processCaptureRequest and handleMetadataWithLock of
+// QCamera3HardwareInterface: every metadata signals the framework
+// thread, every request waits for one signal, and keeps waiting while
+// the pending count is at the in flight depth. Only those extra waits
+// are recorded as stalls.
+//
+// usage: qcamera3-inflight-replay [-n requests_per_phase]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "QCamera3InFlight.h"
+
+using namespace qcamera;
+
+#define REPLAY_MAX_FRAMES 4096
+#define REPLAY_PIPELINE_FRAMES 3
+#define REPLAY_MAX_BUFFERS 8
+#define REPLAY_DEFAULT_DEPTH 5
+#define REPLAY_NO_REQUEST 0xFFFFFFFF
+#define MS (1000000LL)
+
+static int g_failures = 0;
+
+#define TEST_CHECK(cond) do { \
+    if (!(cond)) { \
+        printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+        g_failures++; \
+    } \
+} while (0)
+
+/** replay_phase_t
+*  One phase of a request trace
+*  @count: number of requests
+*  @frame_duration: frame duration of every request in ns
+**/
+typedef struct {
+    uint32_t count;
+    int64_t frame_duration;
+} replay_phase_t;
+
+// preview at 30 fps, burst at 60 fps, long exposure stills, preview
+static const replay_phase_t g_trace[] = {
+    { 60, 8 * MS },
+    { 60, 4 * MS },
+    { 10, 24 * MS },
+    { 60, 8 * MS },
+};
+
+static int64_t replayNowNs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static void replaySleepUntil(int64_t when)
+{
+    struct timespec ts;
+    ts.tv_sec = when / 1000000000LL;
+    ts.tv_nsec = when % 1000000000LL;
+    clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL);
+}
+
+class ReplayHwi;
+
+/*===========================================================================
+ * CLASS      : ReplayBackend
+ *
+ * DESCRIPTION: fake camera backend, frames stream one frame duration
+ *              apart and their metadata is delivered a pipeline latency
+ *              after the frame started
+ *==========================================================================*/
+class ReplayBackend {
+public:
+    ReplayBackend(ReplayHwi *hwi, int64_t latency, int64_t frameDuration);
+    ~ReplayBackend();
+    void request(uint32_t frameNumber, int64_t frameDuration);
+    void stop();
+
+private:
+    static void *sensorThread(void *data);
+    static void *resultThread(void *data);
+
+    ReplayHwi *mHwi;
+    int64_t mLatency;
+    int64_t mFrameDuration; // of the last request, kept while idle
+    pthread_mutex_t mLock;
+    pthread_cond_t mCond;
+    bool mStop;
+    // requests queued to the sensor
+    uint32_t mReqFrame[REPLAY_MAX_FRAMES];
+    int64_t mReqDuration[REPLAY_MAX_FRAMES];
+    uint32_t mReqHead, mReqTail;
+    // results waiting for their delivery time, in time order
+    uint32_t mResFrame[REPLAY_MAX_FRAMES];
+    int64_t mResDue[REPLAY_MAX_FRAMES];
+    uint32_t mResHead, mResTail;
+    pthread_t mSensorTid, mResultTid;
+};
+
+/*===========================================================================
+ * CLASS      : ReplayHwi
+ *
+ * DESCRIPTION: request gate of QCamera3HardwareInterface
+ *==========================================================================*/
+class ReplayHwi {
+public:
+    ReplayHwi(uint32_t maxBuffers, int64_t minFrameDuration);
+    ~ReplayHwi();
+    int processCaptureRequest(uint32_t frameNumber, int64_t frameDuration);
+    void metadataCb(uint32_t frameNumber);
+    void waitIdle();
+
+    QCamera3InFlight mInFlight;
+    ReplayBackend *mBackend;
+    uint32_t mResults;
+    uint32_t mMaxPending;
+
+private:
+    pthread_mutex_t mMutex;
+    pthread_cond_t mRequestCond;
+    int mPendingRequest;
+};
+
+ReplayBackend::ReplayBackend(ReplayHwi *hwi, int64_t latency,
+        int64_t frameDuration)
+    : mHwi(hwi), mLatency(latency), mFrameDuration(frameDuration),
+      mStop(false),
+      mReqHead(0), mReqTail(0), mResHead(0), mResTail(0)
+{
+    pthread_mutex_init(&mLock, NULL);
+    pthread_cond_init(&mCond, NULL);
+    pthread_create(&mSensorTid, NULL, sensorThread, this);
+    pthread_create(&mResultTid, NULL, resultThread, this);
+}
+
+ReplayBackend::~ReplayBackend()
+{
+    stop();
+    pthread_mutex_destroy(&mLock);
+    pthread_cond_destroy(&mCond);
+}
+
+void ReplayBackend::request(uint32_t frameNumber, int64_t frameDuration)
+{
+    pthread_mutex_lock(&mLock);
+    mReqFrame[mReqTail % REPLAY_MAX_FRAMES] = frameNumber;
+    mReqDuration[mReqTail % REPLAY_MAX_FRAMES] = frameDuration;
+    mReqTail++;
+    pthread_cond_broadcast(&mCond);
+    pthread_mutex_unlock(&mLock);
+}
+
+void ReplayBackend::stop()
+{
+    pthread_mutex_lock(&mLock);
+    if (mStop) {
+        pthread_mutex_unlock(&mLock);
+        return;
+    }
+    mStop = true;
+    pthread_cond_broadcast(&mCond);
+    pthread_mutex_unlock(&mLock);
+    pthread_join(mSensorTid, NULL);
+    pthread_join(mResultTid, NULL);
+}
+
+void *ReplayBackend::sensorThread(void *data)
+{
+    ReplayBackend *be = (ReplayBackend *)data;
+    int64_t nextSlot = 0;
+
+    pthread_mutex_lock(&be->mLock);
+    while (!be->mStop) {
+        uint32_t frame = REPLAY_NO_REQUEST;
+        if (be->mReqHead != be->mReqTail) {
+            frame = be->mReqFrame[be->mReqHead % REPLAY_MAX_FRAMES];
+            be->mFrameDuration =
+                be->mReqDuration[be->mReqHead % REPLAY_MAX_FRAMES];
+            be->mReqHead++;
+        }
+        int64_t duration = be->mFrameDuration;
+
+        int64_t start = replayNowNs();
+        if (start < nextSlot) {
+            start = nextSlot;
+        }
+        nextSlot = start + duration;
+        be->mResFrame[be->mResTail % REPLAY_MAX_FRAMES] = frame;
+        be->mResDue[be->mResTail % REPLAY_MAX_FRAMES] = start + be->mLatency;
+        be->mResTail++;
+        pthread_cond_broadcast(&be->mCond);
+
+        pthread_mutex_unlock(&be->mLock);
+        replaySleepUntil(nextSlot);
+        pthread_mutex_lock(&be->mLock);
+    }
+    pthread_mutex_unlock(&be->mLock);
+    return NULL;
+}
+
+void *ReplayBackend::resultThread(void *data)
+{
+    ReplayBackend *be = (ReplayBackend *)data;
+
+    pthread_mutex_lock(&be->mLock);
+    while (!be->mStop) {
+        if (be->mResHead == be->mResTail) {
+            pthread_cond_wait(&be->mCond, &be->mLock);
+            continue;
+        }
+        uint32_t frame = be->mResFrame[be->mResHead % REPLAY_MAX_FRAMES];
+        int64_t due = be->mResDue[be->mResHead % REPLAY_MAX_FRAMES];
+        be->mResHead++;
+
+        pthread_mutex_unlock(&be->mLock);
+        replaySleepUntil(due);
+        be->mHwi->metadataCb(frame);
+        pthread_mutex_lock(&be->mLock);
+    }
+    pthread_mutex_unlock(&be->mLock);
+    return NULL;
+}
+
+ReplayHwi::ReplayHwi(uint32_t maxBuffers, int64_t minFrameDuration)
+    : mInFlight(REPLAY_DEFAULT_DEPTH), mBackend(NULL), mResults(0),
+      mMaxPending(0), mPendingRequest(0)
+{
+    pthread_mutex_init(&mMutex, NULL);
+    pthread_cond_init(&mRequestCond, NULL);
+    mInFlight.configure(maxBuffers, minFrameDuration);
+}
+
+ReplayHwi::~ReplayHwi()
+{
+    pthread_mutex_destroy(&mMutex);
+    pthread_cond_destroy(&mRequestCond);
+}
+
+int ReplayHwi::processCaptureRequest(uint32_t frameNumber,
+        int64_t frameDuration)
+{
+    struct timespec ts;
+    int rc = 0;
+
+    pthread_mutex_lock(&mMutex);
+    mBackend->request(frameNumber, frameDuration);
+
+    clock_gettime(CLOCK_REALTIME, &ts);
+    ts.tv_sec += 5;
+    mPendingRequest++;
+    if ((uint32_t)mPendingRequest > mMaxPending) {
+        mMaxPending = mPendingRequest;
+    }
+    mInFlight.requestSubmitted(frameNumber, frameDuration, replayNowNs());
+    int64_t stallStart = 0;
+    do {
+        rc = pthread_cond_timedwait(&mRequestCond, &mMutex, &ts);
+        if (rc == ETIMEDOUT) {
+            rc = -ENODEV;
+            break;
+        }
+        if (stallStart == 0 && mPendingRequest >= (int)mInFlight.getDepth()) {
+            stallStart = replayNowNs();
+        }
+    } while (mPendingRequest >= (int)mInFlight.getDepth());
+    if (stallStart != 0) {
+        mInFlight.stallRecorded(replayNowNs() - stallStart);
+    }
+    pthread_mutex_unlock(&mMutex);
+    return rc;
+}
+
+void ReplayHwi::metadataCb(uint32_t frameNumber)
+{
+    pthread_mutex_lock(&mMutex);
+    if (frameNumber != REPLAY_NO_REQUEST) {
+        mPendingRequest--;
+        mResults++;
+        mInFlight.resultReceived(frameNumber, replayNowNs());
+    }
+    pthread_cond_signal(&mRequestCond);
+    pthread_mutex_unlock(&mMutex);
+}
+
+void ReplayHwi::waitIdle()
+{
+    for (int i = 0; i < 5000; i++) {
+        pthread_mutex_lock(&mMutex);
+        bool idle = (mPendingRequest == 0);
+        pthread_mutex_unlock(&mMutex);
+        if (idle) {
+            return;
+        }
+        usleep(1000);
+    }
+}
+
+static void replayRun(uint32_t maxBuffers, uint32_t perPhase)
+{
+    const uint32_t phases = sizeof(g_trace) / sizeof(g_trace[0]);
+    const int64_t minDuration = 4 * MS;
+    ReplayHwi hwi(maxBuffers, minDuration);
+    ReplayBackend backend(&hwi, REPLAY_PIPELINE_FRAMES * 8 * MS,
+            g_trace[0].frame_duration);
+    uint32_t frame = 0, timeouts = 0, p, i;
+    int64_t sensorTime = 0;
+
+    hwi.mBackend = &backend;
+    int64_t start = replayNowNs();
+    for (p = 0; p < phases; p++) {
+        uint32_t count = perPhase ? perPhase : g_trace[p].count;
+        for (i = 0; i < count; i++) {
+            if (hwi.processCaptureRequest(frame++, g_trace[p].frame_duration)) {
+                timeouts++;
+            }
+            sensorTime += g_trace[p].frame_duration;
+        }
+    }
+    hwi.waitIdle();
+    int64_t elapsed = replayNowNs() - start;
+    backend.stop();
+
+    TEST_CHECK(timeouts == 0);
+    TEST_CHECK(hwi.mResults == frame);
+    TEST_CHECK(hwi.mInFlight.getDepth() >= 2);
+    TEST_CHECK(hwi.mInFlight.getDepth() <= hwi.mInFlight.getMaxDepth());
+    TEST_CHECK(hwi.mInFlight.getStallCount() <= frame);
+    if (maxBuffers == REPLAY_MAX_BUFFERS) {
+        // the depth covers the pipeline, only phase changes may block
+        TEST_CHECK(hwi.mInFlight.getStallCount() < frame / 4);
+    }
+
+    printf("max buffers %u: %4u requests in %5lld ms (sensor %5lld ms, %3lld%%),"
+           " depth %u, max pending %u, stalls %4u, stall time %5lld ms\n",
+           maxBuffers, frame, (long long)(elapsed / MS),
+           (long long)(sensorTime / MS),
+           (long long)(sensorTime * 100 / elapsed),
+           hwi.mInFlight.getDepth(), hwi.mMaxPending,
+           hwi.mInFlight.getStallCount(),
+           (long long)(hwi.mInFlight.getStallTime() / MS));
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t perPhase = 0;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:")) != -1) {
+        switch (opt) {
+        case 'n':
+            perPhase = (uint32_t)atoi(optarg);
+            break;
+        default:
+            printf("usage: %s [-n requests_per_phase]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (perPhase * 4 >= REPLAY_MAX_FRAMES) {
+        printf("at most %d requests per phase\n", REPLAY_MAX_FRAMES / 4 - 1);
+        return 1;
+    }
+
+    for (uint32_t maxBuffers = 2; maxBuffers <= REPLAY_MAX_BUFFERS;
+         maxBuffers++) {
+        replayRun(maxBuffers, perPhase);
+    }
+
+    printf("%s: %d failures\n", g_failures ? "FAIL" : "PASS", g_failures);
+    return g_failures ? 1 : 0;
+}
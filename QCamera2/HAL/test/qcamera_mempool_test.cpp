@@ -0,0 +1,567 @@
+/* Copyright (c) 2014, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+// Replays stream buffer allocation traces of mode switches through
+// QCameraMemoryPool and checks reuse, budget and bookkeeping. Also checks
+// that stream memory resolves buffer pointers to the right index across
+// allocate, allocateMore and deallocate. The ion backend is replaced, so
+// the test runs without camera hardware.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <utils/Errors.h>
+#include "QCameraMem.h"
+
+using namespace android;
+
+namespace qcamera {
+volatile uint32_t gCamHalLogLevel = 0;
+}
+
+using namespace qcamera;
+
+#define TRACE_MAX_SETS 8
+#define MB (1024 * 1024)
+
+typedef enum {
+    TRACE_ALLOC,
+    TRACE_RELEASE,
+    TRACE_END,
+} trace_op_t;
+
+/** trace_entry_t
+*  One step of a recorded allocation trace
+*  @op: allocate or release a buffer set
+*  @set: buffer set slot, mirrors one QCameraStreamMemory object
+*  @type: stream type the set was allocated for
+*  @size: frame length of one buffer
+*  @count: number of buffers in the set
+**/
+typedef struct {
+    trace_op_t op;
+    int set;
+    cam_stream_type_t type;
+    size_t size;
+    uint8_t count;
+} trace_entry_t;
+
+// Frame lengths as reported by the backend for a 13MP sensor: 4:3 and
+// 16:9 NV21 preview, full size and 16:9 live snapshot NV21, 10-bit raw
+// and metadata.
+#define PREVIEW_4_3   (1440 * 1088 * 3 / 2)
+#define PREVIEW_16_9  (1920 * 1088 * 3 / 2)
+#define SNAPSHOT_13MP (4160 * 3120 * 3 / 2)
+#define SNAPSHOT_VID  (4160 * 2352 * 3 / 2)
+#define RAW_13MP      (4208 * 3120 * 10 / 8)
+#define METADATA      (604160)
+
+// preview -> ZSL snapshot -> preview -> video with live snapshot -> preview
+static const trace_entry_t g_transitions[] = {
+    { TRACE_ALLOC,   0, CAM_STREAM_TYPE_METADATA,     METADATA,      8 },
+    { TRACE_ALLOC,   1, CAM_STREAM_TYPE_PREVIEW,      PREVIEW_4_3,   7 },
+    { TRACE_ALLOC,   2, CAM_STREAM_TYPE_SNAPSHOT,     SNAPSHOT_13MP, 5 },
+    { TRACE_RELEASE, 2, CAM_STREAM_TYPE_SNAPSHOT,     0,             0 },
+    { TRACE_ALLOC,   3, CAM_STREAM_TYPE_RAW,          RAW_13MP,      1 },
+    { TRACE_ALLOC,   4, CAM_STREAM_TYPE_OFFLINE_PROC, SNAPSHOT_13MP, 1 },
+    { TRACE_RELEASE, 4, CAM_STREAM_TYPE_OFFLINE_PROC, 0,             0 },
+    { TRACE_RELEASE, 3, CAM_STREAM_TYPE_RAW,          0,             0 },
+    { TRACE_RELEASE, 1, CAM_STREAM_TYPE_PREVIEW,      0,             0 },
+    { TRACE_RELEASE, 0, CAM_STREAM_TYPE_METADATA,     0,             0 },
+    { TRACE_ALLOC,   0, CAM_STREAM_TYPE_METADATA,     METADATA,      8 },
+    { TRACE_ALLOC,   1, CAM_STREAM_TYPE_PREVIEW,      PREVIEW_16_9,  7 },
+    { TRACE_ALLOC,   2, CAM_STREAM_TYPE_SNAPSHOT,     SNAPSHOT_VID,  2 },
+    { TRACE_RELEASE, 2, CAM_STREAM_TYPE_SNAPSHOT,     0,             0 },
+    { TRACE_RELEASE, 1, CAM_STREAM_TYPE_PREVIEW,      0,             0 },
+    { TRACE_RELEASE, 0, CAM_STREAM_TYPE_METADATA,     0,             0 },
+    { TRACE_ALLOC,   0, CAM_STREAM_TYPE_METADATA,     METADATA,      8 },
+    { TRACE_ALLOC,   1, CAM_STREAM_TYPE_PREVIEW,      PREVIEW_4_3,   7 },
+    { TRACE_RELEASE, 1, CAM_STREAM_TYPE_PREVIEW,      0,             0 },
+    { TRACE_RELEASE, 0, CAM_STREAM_TYPE_METADATA,     0,             0 },
+    { TRACE_END,     0, CAM_STREAM_TYPE_DEFAULT,      0,             0 },
+};
+
+/*===========================================================================
+ * CLASS      : TestMemoryPool
+ *
+ * DESCRIPTION: memory pool backed by fake buffers, counts the buffers and
+ *              bytes that are currently allocated
+ *==========================================================================*/
+class TestMemoryPool : public QCameraMemoryPool {
+public:
+    typedef QCameraMemoryPool::MemInfo MemInfo;
+
+    TestMemoryPool() : mLive(0), mLiveBytes(0), mNextFd(100) {}
+    virtual ~TestMemoryPool() { clear(); }
+
+    int mLive;
+    size_t mLiveBytes;
+
+protected:
+    virtual int allocNewBuffer(MemInfo &memInfo, unsigned int heap_id,
+            size_t size, bool cached, uint32_t is_secure)
+    {
+        memset(&memInfo, 0, sizeof(memInfo));
+        memInfo.fd = mNextFd++;
+        memInfo.size = alignedSize(size, is_secure);
+        memInfo.cached = cached;
+        memInfo.heap_id = heap_id;
+        mLive++;
+        mLiveBytes += memInfo.size;
+        return NO_ERROR;
+    }
+
+    virtual void freeBuffer(MemInfo &memInfo)
+    {
+        mLive--;
+        mLiveBytes -= memInfo.size;
+        memset(&memInfo, 0, sizeof(memInfo));
+    }
+
+private:
+    int mNextFd;
+};
+
+/** mem_info_set_t
+*  Buffers held by one stream memory object
+**/
+typedef struct {
+    TestMemoryPool::MemInfo info[MM_CAMERA_MAX_NUM_FRAMES];
+    uint8_t count;
+} mem_info_set_t;
+
+/** replay_result_t
+*  Outcome of replaying one trace
+*  @max_waste_pct: largest over-allocation of a reused buffer, in percent
+*  @budget_exceeded: pool held more idle bytes than its budget
+*  @alloc_failed: an allocation returned an error
+**/
+typedef struct {
+    uint32_t max_waste_pct;
+    bool budget_exceeded;
+    bool alloc_failed;
+} replay_result_t;
+
+/*===========================================================================
+ * FUNCTION   : replay
+ *
+ * DESCRIPTION: runs a trace through the pool
+ *
+ * PARAMETERS :
+ *   @pool    : pool under test
+ *   @trace   : allocation trace terminated by TRACE_END
+ *   @result  : [output] replay outcome
+ *
+ * RETURN     : none
+ *==========================================================================*/
+static void replay(TestMemoryPool &pool, const trace_entry_t *trace,
+        replay_result_t &result)
+{
+    QCameraMemoryPool::pool_stats_t stats;
+    mem_info_set_t sets[TRACE_MAX_SETS];
+
+    memset(sets, 0, sizeof(sets));
+    for ( ; trace->op != TRACE_END; trace++) {
+        mem_info_set_t &set = sets[trace->set];
+
+        if (trace->op == TRACE_ALLOC) {
+            size_t want = (trace->size + 4095U) & (~4095U);
+            for (uint8_t i = 0; i < trace->count; i++) {
+                if (NO_ERROR != pool.allocateBuffer(set.info[i], ION_HEAP(0),
+                        trace->size, true, trace->type, NON_SECURE)) {
+                    result.alloc_failed = true;
+                    return;
+                }
+                uint32_t waste = (uint32_t)
+                    (((set.info[i].size - want) * 100) / want);
+                if (waste > result.max_waste_pct) {
+                    result.max_waste_pct = waste;
+                }
+            }
+            set.count = trace->count;
+        } else {
+            for (uint8_t i = 0; i < set.count; i++) {
+                pool.releaseBuffer(set.info[i], trace->type);
+            }
+            set.count = 0;
+        }
+
+        size_t cached = 0;
+        for (int t = 0; t < CAM_STREAM_TYPE_MAX; t++) {
+            pool.getStats((cam_stream_type_t)t, stats);
+            cached += stats.cachedBytes;
+        }
+        if (cached > pool.getBudget()) {
+            result.budget_exceeded = true;
+        }
+    }
+}
+
+/*===========================================================================
+ * FUNCTION   : getTotals
+ *
+ * DESCRIPTION: sums the pool counters over all stream types
+ *
+ * PARAMETERS :
+ *   @pool    : pool under test
+ *   @total   : [output] summed counters
+ *
+ * RETURN     : none
+ *==========================================================================*/
+static void getTotals(TestMemoryPool &pool,
+        QCameraMemoryPool::pool_stats_t &total)
+{
+    QCameraMemoryPool::pool_stats_t stats;
+
+    memset(&total, 0, sizeof(total));
+    for (int t = 0; t < CAM_STREAM_TYPE_MAX; t++) {
+        pool.getStats((cam_stream_type_t)t, stats);
+        total.hits += stats.hits;
+        total.misses += stats.misses;
+        total.evictions += stats.evictions;
+        total.allocBytes += stats.allocBytes;
+        total.reuseBytes += stats.reuseBytes;
+        total.cachedBytes += stats.cachedBytes;
+        total.cachedCnt += stats.cachedCnt;
+    }
+}
+
+/*===========================================================================
+ * FUNCTION   : testTransitions
+ *
+ * DESCRIPTION: replays the mode switch trace several times with the
+ *              default budget, regardless of the budget property. Once
+ *              every configuration has been seen, all requests have to
+ *              be served from the pool.
+ *
+ * PARAMETERS : none
+ *
+ * RETURN     : number of failed checks
+ *==========================================================================*/
+static int testTransitions()
+{
+    TestMemoryPool pool;
+    QCameraMemoryPool::pool_stats_t first, total;
+    replay_result_t result;
+    int failures = 0;
+
+    memset(&result, 0, sizeof(result));
+    pool.setBudget(QCAMERA_MEM_POOL_DEFAULT_BUDGET_MB * MB);
+    replay(pool, g_transitions, result);
+    getTotals(pool, first);
+    for (int i = 0; i < 4; i++) {
+        replay(pool, g_transitions, result);
+    }
+    getTotals(pool, total);
+
+    uint32_t hits = total.hits - first.hits;
+    uint32_t misses = total.misses - first.misses;
+    printf("transitions: first pass %u/%u hits, steady state %u/%u hits, "
+           "max waste %u%%\n", first.hits, first.hits + first.misses,
+           hits, hits + misses, result.max_waste_pct);
+    printf("%s", pool.dump().string());
+
+    if (result.alloc_failed || result.budget_exceeded) {
+        printf("FAIL: alloc failed %d budget exceeded %d\n",
+               result.alloc_failed, result.budget_exceeded);
+        failures++;
+    }
+    if (misses != 0) {
+        printf("FAIL: %u misses after warm up\n", misses);
+        failures++;
+    }
+    if (result.max_waste_pct > (QCAMERA_MEM_POOL_MAX_WASTE_RATIO - 1) * 100) {
+        printf("FAIL: reused buffer wastes %u%%\n", result.max_waste_pct);
+        failures++;
+    }
+    if ((size_t)pool.mLiveBytes != total.cachedBytes) {
+        printf("FAIL: %zu live bytes but %zu cached\n",
+               pool.mLiveBytes, total.cachedBytes);
+        failures++;
+    }
+
+    pool.clear();
+    if ((pool.mLive != 0) || (pool.mLiveBytes != 0)) {
+        printf("FAIL: %d buffers leaked after clear\n", pool.mLive);
+        failures++;
+    }
+    return failures;
+}
+
+/*===========================================================================
+ * FUNCTION   : testBudget
+ *
+ * DESCRIPTION: replays the mode switch trace with a budget below the
+ *              working set, so the pool has to evict
+ *
+ * PARAMETERS : none
+ *
+ * RETURN     : number of failed checks
+ *==========================================================================*/
+static int testBudget()
+{
+    TestMemoryPool pool;
+    QCameraMemoryPool::pool_stats_t total;
+    replay_result_t result;
+    int failures = 0;
+
+    memset(&result, 0, sizeof(result));
+    pool.setBudget(64 * MB);
+    for (int i = 0; i < 3; i++) {
+        replay(pool, g_transitions, result);
+    }
+    getTotals(pool, total);
+
+    printf("budget: %u/%u hits, %u evictions, %zu bytes cached\n",
+           total.hits, total.hits + total.misses, total.evictions,
+           total.cachedBytes);
+
+    if (result.alloc_failed || result.budget_exceeded) {
+        printf("FAIL: alloc failed %d budget exceeded %d\n",
+               result.alloc_failed, result.budget_exceeded);
+        failures++;
+    }
+    if ((total.evictions == 0) || (total.hits == 0)) {
+        printf("FAIL: expected both evictions and hits\n");
+        failures++;
+    }
+
+    pool.setBudget(0);
+    getTotals(pool, total);
+    if ((pool.mLive != 0) || (total.cachedCnt != 0)) {
+        printf("FAIL: %d buffers left with zero budget\n", pool.mLive);
+        failures++;
+    }
+    return failures;
+}
+
+/*===========================================================================
+ * FUNCTION   : testBestFit
+ *
+ * DESCRIPTION: the smallest cached buffer that fits has to be reused,
+ *              and buffers that would waste too much must not be
+ *
+ * PARAMETERS : none
+ *
+ * RETURN     : number of failed checks
+ *==========================================================================*/
+static int testBestFit()
+{
+    static const size_t sizes[] = { 8 * MB, 4 * MB, 5 * MB, 6 * MB };
+    static const size_t count = sizeof(sizes) / sizeof(sizes[0]);
+    TestMemoryPool pool;
+    TestMemoryPool::MemInfo held[count];
+    TestMemoryPool::MemInfo info;
+    int failures = 0;
+
+    for (size_t i = 0; i < count; i++) {
+        pool.allocateBuffer(held[i], ION_HEAP(0), sizes[i], true,
+                CAM_STREAM_TYPE_SNAPSHOT, NON_SECURE);
+    }
+    for (size_t i = 0; i < count; i++) {
+        pool.releaseBuffer(held[i], CAM_STREAM_TYPE_SNAPSHOT);
+    }
+
+    pool.allocateBuffer(info, ION_HEAP(0), 4 * MB + 4096, true,
+            CAM_STREAM_TYPE_SNAPSHOT, NON_SECURE);
+    if (info.size != 5 * MB) {
+        printf("FAIL: best fit returned %zu bytes\n", info.size);
+        failures++;
+    }
+    pool.releaseBuffer(info, CAM_STREAM_TYPE_SNAPSHOT);
+
+    pool.allocateBuffer(info, ION_HEAP(0), 1 * MB, true,
+            CAM_STREAM_TYPE_SNAPSHOT, NON_SECURE);
+    if (info.size != 1 * MB) {
+        printf("FAIL: 1MB request reused a %zu byte buffer\n", info.size);
+        failures++;
+    }
+    pool.releaseBuffer(info, CAM_STREAM_TYPE_SNAPSHOT);
+
+    pool.allocateBuffer(info, ION_HEAP(0), 4 * MB, false,
+            CAM_STREAM_TYPE_SNAPSHOT, NON_SECURE);
+    if (pool.mLive != 6) {
+        printf("FAIL: uncached request reused a cached buffer\n");
+        failures++;
+    }
+    pool.releaseBuffer(info, CAM_STREAM_TYPE_SNAPSHOT);
+
+    printf("best fit: %s\n", failures ? "failed" : "ok");
+    return failures;
+}
+
+/*===========================================================================
+ * FUNCTION   : testReleaseMemory
+ *
+ * DESCRIPTION: release op of the fake framework memory
+ *
+ * PARAMETERS :
+ *   @mem     : memory to release
+ *
+ * RETURN     : none
+ *==========================================================================*/
+static void testReleaseMemory(camera_memory_t *mem)
+{
+    free(mem->data);
+    free(mem);
+}
+
+/*===========================================================================
+ * FUNCTION   : testGetMemory
+ *
+ * DESCRIPTION: fake camera_request_memory, hands out a small heap block
+ *              per buffer so every buffer has its own data pointer
+ *
+ * PARAMETERS :
+ *   @fd       : buffer fd, unused
+ *   @buf_size : buffer size, unused
+ *   @num_bufs : number of buffers, unused
+ *   @user     : memory object, unused
+ *
+ * RETURN     : camera memory, NULL if out of memory
+ *==========================================================================*/
+static camera_memory_t *testGetMemory(int /*fd*/, size_t /*buf_size*/,
+        unsigned int /*num_bufs*/, void * /*user*/)
+{
+    camera_memory_t *mem = (camera_memory_t *)calloc(1, sizeof(*mem));
+    if (mem == NULL) {
+        return NULL;
+    }
+    mem->data = malloc(64);
+    mem->size = 64;
+    mem->release = testReleaseMemory;
+    return mem;
+}
+
+/*===========================================================================
+ * FUNCTION   : checkBufIndex
+ *
+ * DESCRIPTION: every buffer pointer of the memory has to resolve to its
+ *              index and pointers of other buffers must not resolve
+ *
+ * PARAMETERS :
+ *   @mem     : memory under test
+ *   @stale   : pointers of released buffers
+ *   @staleCnt: number of stale pointers
+ *
+ * RETURN     : number of failed checks
+ *==========================================================================*/
+static int checkBufIndex(QCameraStreamMemory &mem, void *const *stale,
+        int staleCnt)
+{
+    int failures = 0;
+
+    for (uint32_t i = 0; i < mem.getCnt(); i++) {
+        int index = mem.getMatchBufIndex(mem.getPtr(i), false);
+        if (index != (int)i) {
+            printf("FAIL: buffer %u resolved to %d\n", i, index);
+            failures++;
+        }
+        if (mem.getMatchBufIndex(mem.getPtr(i), true) != -1) {
+            printf("FAIL: buffer %u matched as metadata\n", i);
+            failures++;
+        }
+    }
+    for (int i = 0; i < staleCnt; i++) {
+        bool live = false;
+        for (uint32_t j = 0; j < mem.getCnt(); j++) {
+            live |= (mem.getPtr(j) == stale[i]);
+        }
+        if (!live && (mem.getMatchBufIndex(stale[i], false) != -1)) {
+            printf("FAIL: released buffer %d still resolves\n", i);
+            failures++;
+        }
+    }
+    return failures;
+}
+
+/*===========================================================================
+ * FUNCTION   : testBufIndex
+ *
+ * DESCRIPTION: the pointer -> index map of a stream memory has to follow
+ *              allocate, allocateMore and deallocate
+ *
+ * PARAMETERS : none
+ *
+ * RETURN     : number of failed checks
+ *==========================================================================*/
+static int testBufIndex()
+{
+    TestMemoryPool pool;
+    QCameraStreamMemory mem(testGetMemory, true, &pool,
+            CAM_STREAM_TYPE_PREVIEW);
+    void *stale[MM_CAMERA_MAX_NUM_FRAMES];
+    int staleCnt = 0;
+    int failures = 0;
+
+    for (int round = 0; round < 3; round++) {
+        if (NO_ERROR != mem.allocate(5, PREVIEW_4_3, NON_SECURE)) {
+            printf("FAIL: allocate\n");
+            return failures + 1;
+        }
+        failures += checkBufIndex(mem, stale, staleCnt);
+        if (NO_ERROR != mem.allocateMore(4, PREVIEW_4_3)) {
+            printf("FAIL: allocateMore\n");
+            return failures + 1;
+        }
+        failures += checkBufIndex(mem, stale, staleCnt);
+        if (mem.getMatchBufIndex(&mem, false) != -1) {
+            printf("FAIL: unknown pointer resolved\n");
+            failures++;
+        }
+
+        staleCnt = (int)mem.getCnt();
+        for (int i = 0; i < staleCnt; i++) {
+            stale[i] = mem.getPtr((uint32_t)i);
+        }
+        mem.deallocate();
+        for (int i = 0; i < staleCnt; i++) {
+            if (mem.getMatchBufIndex(stale[i], false) != -1) {
+                printf("FAIL: buffer %d resolves after deallocate\n", i);
+                failures++;
+            }
+        }
+    }
+
+    printf("buffer index: %s\n", failures ? "failed" : "ok");
+    return failures;
+}
+
+int main(int, char **)
+{
+    int failures = 0;
+
+    failures += testTransitions();
+    failures += testBudget();
+    failures += testBestFit();
+    failures += testBufIndex();
+
+    printf("%s\n", failures ? "FAILED" : "PASSED");
+    return failures ? 1 : 0;
+}
@@ -1906,6 +1906,67 @@ status_t CameraContext::autoFocus()
     return ret;
 }
 
+/*===========================================================================
+ * FUNCTION   : benchParameters
+ *
+ * DESCRIPTION: Measures the cost of setParameters when only the zoom
+ *              level changes between calls
+ *
+ * PARAMETERS :
+ *   @iterations : number of setParameters calls
+ *
+ * RETURN     : status_t type of status
+ *              NO_ERROR  -- success
+ *              none-zero failure code
+ *==========================================================================*/
+status_t CameraContext::benchParameters(int iterations)
+{
+    useLock();
+    status_t ret = NO_ERROR;
+    int maxZoom = mParams.getInt(CameraParameters::KEY_MAX_ZOOM);
+    int zoom = mParams.getInt(CameraParameters::KEY_ZOOM);
+    nsecs_t total = 0, worst = 0;
+
+    if ( !mHardwareActive || ( 0 >= maxZoom ) ) {
+        printf("Zoom not available for parameter benchmark\n");
+        signalFinished();
+        return NO_ERROR;
+    }
+
+    if ( 0 > zoom ) {
+        zoom = 0;
+    }
+    int altZoom = ( zoom < maxZoom ) ? ( zoom + 1 ) : ( zoom - 1 );
+
+    for ( int i = 0 ; i < iterations ; i++ ) {
+        mParams.set(CameraParameters::KEY_ZOOM, ( i & 1 ) ? zoom : altZoom);
+        nsecs_t start = systemTime(SYSTEM_TIME_MONOTONIC);
+        ret = mCamera->setParameters(mParams.flatten());
+        nsecs_t elapsed = systemTime(SYSTEM_TIME_MONOTONIC) - start;
+        if ( NO_ERROR != ret ) {
+            printf("setParameters failed %d\n", ret);
+            break;
+        }
+        total += elapsed;
+        if ( elapsed > worst ) {
+            worst = elapsed;
+        }
+    }
+
+    mParams.set(CameraParameters::KEY_ZOOM, zoom);
+    mCamera->setParameters(mParams.flatten());
+
+    if ( ( NO_ERROR == ret ) && ( 0 < iterations ) ) {
+        printf("setParameters zoom only: %d calls avg %lld us max %lld us\n",
+                iterations,
+                (long long)(total / iterations / 1000),
+                (long long)(worst / 1000));
+    }
+
+    signalFinished();
+    return ret;
+}
+
 /*===========================================================================
  * FUNCTION   : enablePreviewCallbacks
  *
@@ -2684,6 +2745,8 @@ void CameraContext::printMenu(sp<CameraContext> currentCamera)
     printf("   %c. zsl:  %s\n",
             Interpreter::ZSL_CMD, mParams.get(CameraContext::KEY_ZSL)?
             mParams.get(CameraContext::KEY_ZSL) : "NULL"   );
+    printf("   %c. Benchmark zoom only setParameters\n",
+            Interpreter::PARAM_BENCH_CMD);
 
     printf("\n");
     printf("   Choice: ");
@@ -2992,6 +3055,7 @@ Interpreter::Interpreter(const char *file)
         case ENABLE_PRV_CALLBACKS_CMD:
         case EXIT_CMD:
         case ZSL_CMD:
+        case PARAM_BENCH_CMD:
         case DELAY:
             p2 = p1;
             while( (p2 != (mScript + len)) && (*p2 != '|')) {
@@ -3284,6 +3348,16 @@ status_t TestContext::FunctionalTest()
         }
             break;
 
+        case Interpreter::PARAM_BENCH_CMD:
+        {
+            int iterations = 100;
+            if ( command.arg ) {
+                iterations = atoi(command.arg);
+            }
+            stat = currentCamera->benchParameters(iterations);
+        }
+            break;
+
         case Interpreter::TAKEPICTURE_CMD:
         {
             stat = currentCamera->takePicture();
@@ -73,6 +73,7 @@ public:
     status_t stopPreview();
     status_t resumePreview();
     status_t autoFocus();
+    status_t benchParameters(int iterations);
     status_t enablePreviewCallbacks();
     status_t takePicture();
     status_t startRecording();
@@ -247,6 +248,7 @@ public:
         EXIT_CMD = 'q',
         DELAY = 'd',
         ZSL_CMD = 'z',
+        PARAM_BENCH_CMD = 'b',
         INVALID_CMD = '0'
     };
 
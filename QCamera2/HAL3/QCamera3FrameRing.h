@@ -0,0 +1,319 @@
+/* Copyright (c) 2014, The Linux Foundataion. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef __QCAMERA3_FRAME_RING_H__
+#define __QCAMERA3_FRAME_RING_H__
+
+#include <stdint.h>
+#include <stddef.h>
+
+namespace qcamera {
+
+/* Bookkeeping indexed by frame number. Entries live in a power of two
+ * slot array at frame_number % capacity, so find/insert/erase are O(1).
+ * The array only grows when the window of live frame numbers outgrows it,
+ * steady state operation does not allocate. Frame numbers may wrap. */
+template <typename T>
+class QCamera3FrameRing {
+public:
+    QCamera3FrameRing(uint32_t initialSize = kDefaultSize);
+    ~QCamera3FrameRing();
+
+    T *find(uint32_t frameNumber);
+    T *insert(uint32_t frameNumber);
+    void erase(uint32_t frameNumber);
+    T *first();
+    T *next(uint32_t frameNumber);
+    void clear();
+
+    uint32_t size() const { return mCount; };
+    bool empty() const { return mCount == 0; };
+    uint32_t capacity() const { return mCapacity; };
+
+private:
+    QCamera3FrameRing(const QCamera3FrameRing &);
+    QCamera3FrameRing &operator=(const QCamera3FrameRing &);
+
+    typedef struct {
+        uint32_t frame_number;
+        bool used;
+        T data;
+    } Slot;
+
+    bool resize(uint32_t window);
+    Slot &slotOf(uint32_t frameNumber)
+        { return mSlots[frameNumber & (mCapacity - 1)]; };
+
+    static const uint32_t kDefaultSize = 32;
+
+    Slot *mSlots;
+    uint32_t mCapacity;
+    uint32_t mHead;  // lowest live frame number
+    uint32_t mTail;  // one past the highest live frame number
+    uint32_t mCount;
+};
+
+/*===========================================================================
+ * FUNCTION   : QCamera3FrameRing
+ *
+ * DESCRIPTION: constructor of QCamera3FrameRing
+ *
+ * PARAMETERS :
+ *   @initialSize : initial number of slots, rounded up to a power of two
+ *
+ * RETURN     : None
+ *==========================================================================*/
+template <typename T>
+QCamera3FrameRing<T>::QCamera3FrameRing(uint32_t initialSize)
+    : mSlots(NULL),
+      mCapacity(0),
+      mHead(0),
+      mTail(0),
+      mCount(0)
+{
+    resize(initialSize);
+}
+
+/*===========================================================================
+ * FUNCTION   : ~QCamera3FrameRing
+ *
+ * DESCRIPTION: destructor of QCamera3FrameRing
+ *
+ * PARAMETERS : None
+ *
+ * RETURN     : None
+ *==========================================================================*/
+template <typename T>
+QCamera3FrameRing<T>::~QCamera3FrameRing()
+{
+    delete[] mSlots;
+}
+
+/*===========================================================================
+ * FUNCTION   : find
+ *
+ * DESCRIPTION: look up the entry of a frame number
+ *
+ * PARAMETERS :
+ *   @frameNumber : frame number
+ *
+ * RETURN     : entry pointer, NULL if the frame number has no entry
+ *==========================================================================*/
+template <typename T>
+T *QCamera3FrameRing<T>::find(uint32_t frameNumber)
+{
+    if (mCount == 0 || (frameNumber - mHead) >= (mTail - mHead)) {
+        return NULL;
+    }
+    Slot &slot = slotOf(frameNumber);
+    if (!slot.used || slot.frame_number != frameNumber) {
+        return NULL;
+    }
+    return &slot.data;
+}
+
+/*===========================================================================
+ * FUNCTION   : insert
+ *
+ * DESCRIPTION: get the entry of a frame number, creating a value
+ *              initialized one if it does not exist yet. Pointers returned
+ *              earlier are invalidated if the slot array has to grow.
+ *
+ * PARAMETERS :
+ *   @frameNumber : frame number
+ *
+ * RETURN     : entry pointer, NULL if the slot array could not grow
+ *==========================================================================*/
+template <typename T>
+T *QCamera3FrameRing<T>::insert(uint32_t frameNumber)
+{
+    uint32_t head = mHead;
+    uint32_t tail = mTail;
+    if (mCount == 0) {
+        head = frameNumber;
+        tail = frameNumber + 1;
+    } else if ((int32_t)(frameNumber - mHead) < 0) {
+        head = frameNumber;
+    } else if ((int32_t)(frameNumber - mTail) >= 0) {
+        tail = frameNumber + 1;
+    }
+
+    if ((tail - head) > mCapacity && !resize(tail - head)) {
+        return NULL;
+    }
+    mHead = head;
+    mTail = tail;
+
+    Slot &slot = slotOf(frameNumber);
+    if (!slot.used) {
+        slot.frame_number = frameNumber;
+        slot.used = true;
+        slot.data = T();
+        mCount++;
+    }
+    return &slot.data;
+}
+
+/*===========================================================================
+ * FUNCTION   : erase
+ *
+ * DESCRIPTION: remove the entry of a frame number
+ *
+ * PARAMETERS :
+ *   @frameNumber : frame number
+ *
+ * RETURN     : None
+ *==========================================================================*/
+template <typename T>
+void QCamera3FrameRing<T>::erase(uint32_t frameNumber)
+{
+    if (find(frameNumber) == NULL) {
+        return;
+    }
+    slotOf(frameNumber).used = false;
+    mCount--;
+
+    if (mCount == 0) {
+        mHead = mTail;
+        return;
+    }
+    while (!slotOf(mHead).used) {
+        mHead++;
+    }
+    while (!slotOf(mTail - 1).used) {
+        mTail--;
+    }
+}
+
+/*===========================================================================
+ * FUNCTION   : first
+ *
+ * DESCRIPTION: entry with the lowest frame number
+ *
+ * PARAMETERS : None
+ *
+ * RETURN     : entry pointer, NULL if empty
+ *==========================================================================*/
+template <typename T>
+T *QCamera3FrameRing<T>::first()
+{
+    return (mCount == 0) ? NULL : &slotOf(mHead).data;
+}
+
+/*===========================================================================
+ * FUNCTION   : next
+ *
+ * DESCRIPTION: entry following a frame number in frame number order
+ *
+ * PARAMETERS :
+ *   @frameNumber : frame number to continue after
+ *
+ * RETURN     : entry pointer, NULL if there are no later entries
+ *==========================================================================*/
+template <typename T>
+T *QCamera3FrameRing<T>::next(uint32_t frameNumber)
+{
+    if (mCount == 0) {
+        return NULL;
+    }
+    uint32_t frame = frameNumber + 1;
+    if ((int32_t)(frame - mHead) < 0) {
+        frame = mHead;
+    }
+    for (; frame != mTail; frame++) {
+        Slot &slot = slotOf(frame);
+        if (slot.used) {
+            return &slot.data;
+        }
+    }
+    return NULL;
+}
+
+/*===========================================================================
+ * FUNCTION   : clear
+ *
+ * DESCRIPTION: remove all entries, keeping the slot array
+ *
+ * PARAMETERS : None
+ *
+ * RETURN     : None
+ *==========================================================================*/
+template <typename T>
+void QCamera3FrameRing<T>::clear()
+{
+    for (uint32_t i = 0; i < mCapacity; i++) {
+        mSlots[i].used = false;
+    }
+    mHead = mTail = 0;
+    mCount = 0;
+}
+
+/*===========================================================================
+ * FUNCTION   : resize
+ *
+ * DESCRIPTION: grow the slot array to hold a window of frame numbers and
+ *              move the live entries over
+ *
+ * PARAMETERS :
+ *   @window : number of consecutive frame numbers to hold
+ *
+ * RETURN     : true on success, false if out of memory
+ *==========================================================================*/
+template <typename T>
+bool QCamera3FrameRing<T>::resize(uint32_t window)
+{
+    uint32_t capacity = (mCapacity > 0) ? mCapacity : 1;
+    while (capacity < window) {
+        capacity <<= 1;
+    }
+    if (capacity == mCapacity) {
+        return true;
+    }
+
+    Slot *slots = new Slot[capacity];
+    if (slots == NULL) {
+        return false;
+    }
+    for (uint32_t i = 0; i < capacity; i++) {
+        slots[i].used = false;
+    }
+    for (uint32_t i = 0; i < mCapacity; i++) {
+        if (mSlots[i].used) {
+            slots[mSlots[i].frame_number & (capacity - 1)] = mSlots[i];
+        }
+    }
+    delete[] mSlots;
+    mSlots = slots;
+    mCapacity = capacity;
+    return true;
+}
+
+}; // namespace qcamera
+
+#endif /* __QCAMERA3_FRAME_RING_H__ */
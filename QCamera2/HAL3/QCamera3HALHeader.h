@@ -68,6 +68,8 @@ class QCamera3Channel;
         camera3_stream_t *stream;
         stream_status_t status;
         QCamera3Channel *channel;
+        // buffers handed to the HAL and not yet returned
+        uint32_t num_pending_buffers;
     } stream_info_t;
 
     typedef struct {
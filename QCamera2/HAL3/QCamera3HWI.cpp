@@ -37,6 +37,7 @@
 #include <fcntl.h>
 #include <utils/Log.h>
 #include <utils/Errors.h>
+#include <utils/Timers.h>
 #include <ui/Fence.h>
 #include <gralloc_priv.h>
 #include "QCamera3HWI.h"
@@ -44,6 +45,7 @@
 #include "QCamera3Channel.h"
 #include "QCamera3PostProc.h"
 #include "QCamera3VendorTags.h"
+#include "QCameraCapsCache.h"
 
 using namespace android;
 
@@ -183,6 +185,42 @@ const QCamera3HardwareInterface::QCameraMap QCamera3HardwareInterface::REFERENCE
     { ANDROID_SENSOR_REFERENCE_ILLUMINANT1_WHITE_FLUORESCENT, CAM_AWB_COLD_FLO},
 };
 
+// Indexes are built when the library is loaded, the maps above are
+// constant initialized by then.
+const QCameraEnumLookup<QCamera3HardwareInterface::QCameraMap>
+        QCamera3HardwareInterface::EFFECT_MODES_LOOKUP(
+        EFFECT_MODES_MAP, METADATA_MAP_SIZE(EFFECT_MODES_MAP));
+const QCameraEnumLookup<QCamera3HardwareInterface::QCameraMap>
+        QCamera3HardwareInterface::WHITE_BALANCE_MODES_LOOKUP(
+        WHITE_BALANCE_MODES_MAP, METADATA_MAP_SIZE(WHITE_BALANCE_MODES_MAP));
+const QCameraEnumLookup<QCamera3HardwareInterface::QCameraMap>
+        QCamera3HardwareInterface::SCENE_MODES_LOOKUP(
+        SCENE_MODES_MAP, METADATA_MAP_SIZE(SCENE_MODES_MAP));
+const QCameraEnumLookup<QCamera3HardwareInterface::QCameraMap>
+        QCamera3HardwareInterface::FOCUS_MODES_LOOKUP(
+        FOCUS_MODES_MAP, METADATA_MAP_SIZE(FOCUS_MODES_MAP));
+const QCameraEnumLookup<QCamera3HardwareInterface::QCameraMap>
+        QCamera3HardwareInterface::ANTIBANDING_MODES_LOOKUP(
+        ANTIBANDING_MODES_MAP, METADATA_MAP_SIZE(ANTIBANDING_MODES_MAP));
+const QCameraEnumLookup<QCamera3HardwareInterface::QCameraMap>
+        QCamera3HardwareInterface::LENS_STATE_LOOKUP(
+        LENS_STATE_MAP, METADATA_MAP_SIZE(LENS_STATE_MAP));
+const QCameraEnumLookup<QCamera3HardwareInterface::QCameraMap>
+        QCamera3HardwareInterface::AE_FLASH_MODE_LOOKUP(
+        AE_FLASH_MODE_MAP, METADATA_MAP_SIZE(AE_FLASH_MODE_MAP));
+const QCameraEnumLookup<QCamera3HardwareInterface::QCameraMap>
+        QCamera3HardwareInterface::FLASH_MODES_LOOKUP(
+        FLASH_MODES_MAP, METADATA_MAP_SIZE(FLASH_MODES_MAP));
+const QCameraEnumLookup<QCamera3HardwareInterface::QCameraMap>
+        QCamera3HardwareInterface::FACEDETECT_MODES_LOOKUP(
+        FACEDETECT_MODES_MAP, METADATA_MAP_SIZE(FACEDETECT_MODES_MAP));
+const QCameraEnumLookup<QCamera3HardwareInterface::QCameraMap>
+        QCamera3HardwareInterface::REFERENCE_ILLUMINANT_LOOKUP(
+        REFERENCE_ILLUMINANT_MAP, METADATA_MAP_SIZE(REFERENCE_ILLUMINANT_MAP));
+const QCameraNameLookup<QCamera3HardwareInterface::QCameraPropMap>
+        QCamera3HardwareInterface::CDS_LOOKUP(
+        CDS_MAP, METADATA_MAP_SIZE(CDS_MAP));
+
 camera3_device_ops_t QCamera3HardwareInterface::mCameraOps = {
     initialize:                         QCamera3HardwareInterface::initialize,
     configure_streams:                  QCamera3HardwareInterface::configure_streams,
@@ -221,6 +259,7 @@ QCamera3HardwareInterface::QCamera3HardwareInterface(uint32_t cameraId,
       mFirstRequest(false),
       mParamHeap(NULL),
       mParameters(NULL),
+      mInFlight(kMaxInFlight),
       mJpegSettings(NULL),
       mIsZslMode(false),
       mMinProcessedFrameDuration(0),
@@ -253,6 +292,7 @@ QCamera3HardwareInterface::QCamera3HardwareInterface(uint32_t cameraId,
     mPendingRequest = 0;
     mCurrentRequestId = -1;
     pthread_mutex_init(&mMutex, NULL);
+    memset(&mParmDirty, 0, sizeof(mParmDirty));
 
     for (size_t i = 0; i < CAMERA3_TEMPLATE_COUNT; i++)
         mDefaultMetadata[i] = NULL;
@@ -591,6 +631,7 @@ int QCamera3HardwareInterface::configureStreams(
             }
             stream_info->stream = newStream;
             stream_info->status = VALID;
+            stream_info->num_pending_buffers = 0;
             stream_info->channel = NULL;
             mStreamInfo.push_back(stream_info);
         }
@@ -826,7 +867,7 @@ int QCamera3HardwareInterface::configureStreams(
     }
 
     // settings/parameters don't carry over for new configureStreams
-    memset(mParameters, 0, sizeof(parm_buffer_t));
+    cam_parm_batch_init(mParameters, &mParmDirty);
 
     AddSetParmEntryToBatch(mParameters, CAM_INTF_PARM_HAL_VERSION,
                 sizeof(hal_version), &hal_version);
@@ -840,8 +881,7 @@ int QCamera3HardwareInterface::configureStreams(
     mPendingRequestsList.clear();
     mPendingFrameDropList.clear();
     // Initialize/Reset the pending buffers list
-    mPendingBuffersMap.num_buffers = 0;
-    mPendingBuffersMap.mPendingBufferList.clear();
+    resetPendingBuffers();
 
     /*flush the metadata list*/
     if (!mStoredMetadataList.empty()) {
@@ -858,6 +898,19 @@ int QCamera3HardwareInterface::configureStreams(
     //Get min frame duration for this streams configuration
     deriveMinFrameDuration();
 
+    //Size in flight requests by the buffers the framework may dequeue
+    uint32_t maxBuffers = 0;
+    for (List<stream_info_t*>::iterator it = mStreamInfo.begin();
+        it != mStreamInfo.end(); it++) {
+        if ((*it)->stream->stream_type == CAMERA3_STREAM_INPUT ||
+            (*it)->stream->format == HAL_PIXEL_FORMAT_BLOB)
+            continue;
+        if ((*it)->stream->max_buffers > maxBuffers)
+            maxBuffers = (*it)->stream->max_buffers;
+    }
+    mInFlight.configure(maxBuffers,
+        MAX(mMinRawFrameDuration, mMinProcessedFrameDuration));
+
     pthread_mutex_unlock(&mMutex);
     return rc;
 }
@@ -898,6 +951,11 @@ int QCamera3HardwareInterface::validateCaptureRequest(
                 __FUNCTION__, frameNumber);
         return BAD_VALUE;
     }
+    if (request->num_output_buffers > MAX_NUM_STREAMS) {
+        ALOGE("%s: Request %d: Too many output buffers %d!",
+                __FUNCTION__, frameNumber, request->num_output_buffers);
+        return BAD_VALUE;
+    }
     if (request->input_buffer != NULL) {
         b = request->input_buffer;
         QCamera3Channel *channel =
@@ -1049,21 +1107,21 @@ void QCamera3HardwareInterface::handleMetadataWithLock(
     mm_camera_super_buf_t *metadata_buf)
 {
     metadata_buffer_t *metadata = (metadata_buffer_t *)metadata_buf->bufs[0]->buffer;
-    int32_t frame_number_valid = *(int32_t *)
-        POINTER_OF_META(CAM_INTF_META_FRAME_NUMBER_VALID, metadata);
-    uint32_t pending_requests = *(uint32_t *)POINTER_OF_META(
+    int32_t frame_number_valid = *POINTER_OF_META_TYPED(
+        CAM_INTF_META_FRAME_NUMBER_VALID, metadata);
+    uint32_t pending_requests = *POINTER_OF_META_TYPED(
         CAM_INTF_META_PENDING_REQUESTS, metadata);
-    uint32_t frame_number = *(uint32_t *)
-        POINTER_OF_META(CAM_INTF_META_FRAME_NUMBER, metadata);
-    nsecs_t capture_time = *(int64_t *)
-        POINTER_OF_META(CAM_INTF_META_SENSOR_TIMESTAMP, metadata);
-    cam_frame_dropped_t cam_frame_drop = *(cam_frame_dropped_t *)
-        POINTER_OF_META(CAM_INTF_META_FRAME_DROPPED, metadata);
-
-    int32_t urgent_frame_number_valid = *(int32_t *)
-        POINTER_OF_META(CAM_INTF_META_URGENT_FRAME_NUMBER_VALID, metadata);
-    uint32_t urgent_frame_number = *(uint32_t *)
-        POINTER_OF_META(CAM_INTF_META_URGENT_FRAME_NUMBER, metadata);
+    uint32_t frame_number = *POINTER_OF_META_TYPED(
+        CAM_INTF_META_FRAME_NUMBER, metadata);
+    nsecs_t capture_time = *POINTER_OF_META_TYPED(
+        CAM_INTF_META_SENSOR_TIMESTAMP, metadata);
+    cam_frame_dropped_t cam_frame_drop = *POINTER_OF_META_TYPED(
+        CAM_INTF_META_FRAME_DROPPED, metadata);
+
+    int32_t urgent_frame_number_valid = *POINTER_OF_META_TYPED(
+        CAM_INTF_META_URGENT_FRAME_NUMBER_VALID, metadata);
+    uint32_t urgent_frame_number = *POINTER_OF_META_TYPED(
+        CAM_INTF_META_URGENT_FRAME_NUMBER, metadata);
 
     if (urgent_frame_number_valid) {
         CDBG("%s: valid urgent frame_number = %d, capture_time = %lld",
@@ -1071,8 +1129,9 @@ void QCamera3HardwareInterface::handleMetadataWithLock(
 
         //Recieved an urgent Frame Number, handle it
         //using HAL3.1 quirk for partial results
-        for (List<PendingRequestInfo>::iterator i =
-            mPendingRequestsList.begin(); i != mPendingRequestsList.end(); i++) {
+        for (PendingRequestInfo *i = mPendingRequestsList.first();
+            i != NULL && i->frame_number <= urgent_frame_number;
+            i = mPendingRequestsList.next(i->frame_number)) {
             camera3_notify_msg_t notify_msg;
             CDBG("%s: Iterator Frame = %d urgent frame = %d",
                 __func__, i->frame_number, urgent_frame_number);
@@ -1127,22 +1186,26 @@ void QCamera3HardwareInterface::handleMetadataWithLock(
     }
     CDBG("%s: valid frame_number = %d, capture_time = %lld", __func__,
             frame_number, capture_time);
+    nsecs_t resultTime;
+    resultTime = systemTime();
 
     // Go through the pending requests info and send shutter/results to frameworks
-    for (List<PendingRequestInfo>::iterator i = mPendingRequestsList.begin();
-        i != mPendingRequestsList.end() && i->frame_number <= frame_number;) {
+    for (PendingRequestInfo *i = mPendingRequestsList.first();
+        i != NULL && i->frame_number <= frame_number;
+        i = mPendingRequestsList.first()) {
         camera3_capture_result_t result;
         CDBG("%s: frame_number in the list is %d", __func__, i->frame_number);
 
         // Flush out all entries with less or equal frame numbers.
         mPendingRequest--;
+        mInFlight.resultReceived(i->frame_number, resultTime);
 
         // Check whether any stream buffer corresponding to this is dropped or not
         // If dropped, then send the ERROR_BUFFER for the corresponding stream
         if (cam_frame_drop.frame_dropped) {
             camera3_notify_msg_t notify_msg;
-            for (List<RequestedBufferInfo>::iterator j = i->buffers.begin();
-                    j != i->buffers.end(); j++) {
+            for (uint32_t b = 0; b < i->num_buffers; b++) {
+                RequestedBufferInfo *j = &i->buffers[b];
                 QCamera3Channel *channel = (QCamera3Channel *)j->stream->priv;
                 uint32_t streamID = channel->getStreamID(channel->getStreamTypeMask());
                 for (uint32_t k = 0; k < cam_frame_drop.cam_stream_ID.num_streams; k++) {
@@ -1157,11 +1220,8 @@ void QCamera3HardwareInterface::handleMetadataWithLock(
                        mCallbackOps->notify(mCallbackOps, &notify_msg);
                        CDBG("%s: End of reporting error frame#=%d, streamID=%d",
                               __func__, i->frame_number, streamID);
-                       PendingFrameDropInfo PendingFrameDrop;
-                       PendingFrameDrop.frame_number=i->frame_number;
-                       PendingFrameDrop.stream_ID = streamID;
                        // Add the Frame drop info to mPendingFrameDropList
-                       mPendingFrameDropList.push_back(PendingFrameDrop);
+                       addFrameDrop(i->frame_number, streamID);
                    }
                 }
             }
@@ -1183,8 +1243,8 @@ void QCamera3HardwareInterface::handleMetadataWithLock(
             if (mIsZslMode) {
                 bool found_metadata = false;
                 //for ZSL case store the metadata buffer and corresp. ZSL handle ptr
-                for (List<RequestedBufferInfo>::iterator j = i->buffers.begin();
-                    j != i->buffers.end(); j++) {
+                for (uint32_t b = 0; b < i->num_buffers; b++) {
+                    RequestedBufferInfo *j = &i->buffers[b];
                     if (j->stream->stream_type == CAMERA3_STREAM_BIDIRECTIONAL) {
                         //check if corresp. zsl already exists in the stored metadata list
                         for (List<MetadataBufferInfo>::iterator m = mStoredMetadataList.begin();
@@ -1207,8 +1267,8 @@ void QCamera3HardwareInterface::handleMetadataWithLock(
                 if (!found_metadata) {
                     if (!i->input_buffer_present && i->blob_request) {
                         //livesnapshot or fallback non-zsl snapshot case
-                        for (List<RequestedBufferInfo>::iterator j = i->buffers.begin();
-                                j != i->buffers.end(); j++){
+                        for (uint32_t b = 0; b < i->num_buffers; b++) {
+                            RequestedBufferInfo *j = &i->buffers[b];
                             if (j->stream->stream_type == CAMERA3_STREAM_OUTPUT &&
                                 j->stream->format == HAL_PIXEL_FORMAT_BLOB) {
                                 mPictureChannel->queueMetadata(metadata_buf,mMetadataChannel,true);
@@ -1236,52 +1296,34 @@ void QCamera3HardwareInterface::handleMetadataWithLock(
         result.frame_number = i->frame_number;
         result.num_output_buffers = 0;
         result.output_buffers = NULL;
-        for (List<RequestedBufferInfo>::iterator j = i->buffers.begin();
-                    j != i->buffers.end(); j++) {
-            if (j->buffer) {
+        for (uint32_t b = 0; b < i->num_buffers; b++) {
+            if (i->buffers[b].buffer_ready) {
                 result.num_output_buffers++;
             }
         }
 
         if (result.num_output_buffers > 0) {
-            camera3_stream_buffer_t *result_buffers =
-                new camera3_stream_buffer_t[result.num_output_buffers];
-            if (!result_buffers) {
-                ALOGE("%s: Fatal error: out of memory", __func__);
-            }
+            camera3_stream_buffer_t result_buffers[MAX_NUM_STREAMS];
             size_t result_buffers_idx = 0;
-            for (List<RequestedBufferInfo>::iterator j = i->buffers.begin();
-                    j != i->buffers.end(); j++) {
-                if (j->buffer) {
-                    for (List<PendingFrameDropInfo>::iterator m = mPendingFrameDropList.begin();
-                            m != mPendingFrameDropList.end(); m++) {
-                        QCamera3Channel *channel = (QCamera3Channel *)j->buffer->stream->priv;
-                        uint32_t streamID = channel->getStreamID(channel->getStreamTypeMask());
-                        if((m->stream_ID == streamID) && (m->frame_number==frame_number)) {
-                            j->buffer->status=CAMERA3_BUFFER_STATUS_ERROR;
-                            CDBG("%s: Stream STATUS_ERROR frame_number=%d, streamID=%d",
-                                  __func__, frame_number, streamID);
-                            m = mPendingFrameDropList.erase(m);
-                            break;
-                        }
+            for (uint32_t b = 0; b < i->num_buffers; b++) {
+                RequestedBufferInfo *j = &i->buffers[b];
+                if (j->buffer_ready) {
+                    QCamera3Channel *channel = (QCamera3Channel *)j->buffer.stream->priv;
+                    uint32_t streamID = channel->getStreamID(channel->getStreamTypeMask());
+                    if (consumeFrameDrop(i->frame_number, streamID)) {
+                        j->buffer.status=CAMERA3_BUFFER_STATUS_ERROR;
+                        CDBG("%s: Stream STATUS_ERROR frame_number=%d, streamID=%d",
+                              __func__, i->frame_number, streamID);
                     }
 
-                    for (List<PendingBufferInfo>::iterator k =
-                      mPendingBuffersMap.mPendingBufferList.begin();
-                      k != mPendingBuffersMap.mPendingBufferList.end(); k++) {
-                      if (k->buffer == j->buffer->buffer) {
+                    if (removePendingBuffer(i->frame_number, j->buffer.buffer)) {
                         CDBG("%s: Found buffer %p in pending buffer List "
                               "for frame %d, Take it out!!", __func__,
-                               k->buffer, k->frame_number);
-                        mPendingBuffersMap.num_buffers--;
-                        k = mPendingBuffersMap.mPendingBufferList.erase(k);
-                        break;
-                      }
+                               j->buffer.buffer, i->frame_number);
                     }
 
-                    result_buffers[result_buffers_idx++] = *(j->buffer);
-                    free(j->buffer);
-                    j->buffer = NULL;
+                    result_buffers[result_buffers_idx++] = j->buffer;
+                    j->buffer_ready = false;
                 }
             }
             result.output_buffers = result_buffers;
@@ -1290,7 +1332,6 @@ void QCamera3HardwareInterface::handleMetadataWithLock(
             CDBG("%s: meta frame_number = %d, capture_time = %lld",
                     __func__, result.frame_number, i->timestamp);
             free_camera_metadata((camera_metadata_t *)result.result);
-            delete[] result_buffers;
         } else {
             mCallbackOps->process_capture_result(mCallbackOps, &result);
             CDBG("%s: meta frame_number = %d, capture_time = %lld",
@@ -1298,7 +1339,7 @@ void QCamera3HardwareInterface::handleMetadataWithLock(
             free_camera_metadata((camera_metadata_t *)result.result);
         }
         // erase the element from the list
-        i = mPendingRequestsList.erase(i);
+        mPendingRequestsList.erase(i->frame_number);
     }
 
 done_metadata:
@@ -1324,50 +1365,32 @@ void QCamera3HardwareInterface::handleBufferWithLock(
     // If the frame number doesn't exist in the pending request list,
     // directly send the buffer to the frameworks, and update pending buffers map
     // Otherwise, book-keep the buffer.
-    List<PendingRequestInfo>::iterator i = mPendingRequestsList.begin();
-    while (i != mPendingRequestsList.end() && i->frame_number != frame_number){
-        i++;
-    }
-    if (i == mPendingRequestsList.end()) {
+    PendingRequestInfo *i = mPendingRequestsList.find(frame_number);
+    if (i == NULL) {
         // Verify all pending requests frame_numbers are greater
-        for (List<PendingRequestInfo>::iterator j = mPendingRequestsList.begin();
-                j != mPendingRequestsList.end(); j++) {
-            if (j->frame_number < frame_number) {
-                ALOGE("%s: Error: pending frame number %d is smaller than %d",
-                        __func__, j->frame_number, frame_number);
-            }
+        PendingRequestInfo *j = mPendingRequestsList.first();
+        if (j != NULL && j->frame_number < frame_number) {
+            ALOGE("%s: Error: pending frame number %d is smaller than %d",
+                    __func__, j->frame_number, frame_number);
         }
         camera3_capture_result_t result;
         result.result = NULL;
         result.frame_number = frame_number;
         result.num_output_buffers = 1;
-        for (List<PendingFrameDropInfo>::iterator m = mPendingFrameDropList.begin();
-                m != mPendingFrameDropList.end(); m++) {
-            QCamera3Channel *channel = (QCamera3Channel *)buffer->stream->priv;
-            uint32_t streamID = channel->getStreamID(channel->getStreamTypeMask());
-            if((m->stream_ID == streamID) && (m->frame_number==frame_number) ) {
-                buffer->status=CAMERA3_BUFFER_STATUS_ERROR;
-                CDBG("%s: Stream STATUS_ERROR frame_number=%d, streamID=%d",
-                        __func__, frame_number, streamID);
-                m = mPendingFrameDropList.erase(m);
-                break;
-            }
+        QCamera3Channel *channel = (QCamera3Channel *)buffer->stream->priv;
+        uint32_t streamID = channel->getStreamID(channel->getStreamTypeMask());
+        if (consumeFrameDrop(frame_number, streamID)) {
+            buffer->status=CAMERA3_BUFFER_STATUS_ERROR;
+            CDBG("%s: Stream STATUS_ERROR frame_number=%d, streamID=%d",
+                    __func__, frame_number, streamID);
         }
         result.output_buffers = buffer;
         CDBG("%s: result frame_number = %d, buffer = %p",
                 __func__, frame_number, buffer->buffer);
 
-        for (List<PendingBufferInfo>::iterator k =
-                mPendingBuffersMap.mPendingBufferList.begin();
-                k != mPendingBuffersMap.mPendingBufferList.end(); k++ ) {
-            if (k->buffer == buffer->buffer) {
-                CDBG("%s: Found Frame buffer, take it out from list",
-                        __func__);
-
-                mPendingBuffersMap.num_buffers--;
-                k = mPendingBuffersMap.mPendingBufferList.erase(k);
-                break;
-            }
+        if (removePendingBuffer(frame_number, buffer->buffer)) {
+            CDBG("%s: Found Frame buffer, take it out from list",
+                    __func__);
         }
         CDBG("%s: mPendingBuffersMap.num_buffers = %d",
             __func__, mPendingBuffersMap.num_buffers);
@@ -1391,15 +1414,14 @@ void QCamera3HardwareInterface::handleBufferWithLock(
         }
         mCallbackOps->process_capture_result(mCallbackOps, &result);
     } else {
-        for (List<RequestedBufferInfo>::iterator j = i->buffers.begin();
-                j != i->buffers.end(); j++) {
+        for (uint32_t b = 0; b < i->num_buffers; b++) {
+            RequestedBufferInfo *j = &i->buffers[b];
             if (j->stream == buffer->stream) {
-                if (j->buffer != NULL) {
+                if (j->buffer_ready) {
                     ALOGE("%s: Error: buffer is already set", __func__);
                 } else {
-                    j->buffer = (camera3_stream_buffer_t *)malloc(
-                            sizeof(camera3_stream_buffer_t));
-                    *(j->buffer) = *buffer;
+                    j->buffer = *buffer;
+                    j->buffer_ready = true;
                     CDBG("%s: cache buffer %p at result frame_number %d",
                             __func__, buffer, frame_number);
                 }
@@ -1423,23 +1445,15 @@ void QCamera3HardwareInterface::unblockRequestIfNecessary()
 {
     bool max_buffers_dequeued = false;
 
-    uint32_t queued_buffers = 0;
     for(List<stream_info_t*>::iterator it=mStreamInfo.begin();
         it != mStreamInfo.end(); it++) {
-        queued_buffers = 0;
-        for (List<PendingBufferInfo>::iterator k =
-            mPendingBuffersMap.mPendingBufferList.begin();
-            k != mPendingBuffersMap.mPendingBufferList.end(); k++ ) {
-            if (k->stream == (*it)->stream)
-                queued_buffers++;
-
-            CDBG("%s: Dequeued %d buffers for stream %p", __func__,
-                queued_buffers, (*it)->stream);
-            if (queued_buffers >=(* it)->stream->max_buffers) {
-                CDBG("%s: Wait!!! Max buffers Dequed", __func__);
-                max_buffers_dequeued = true;
-                break;
-            }
+        CDBG("%s: Dequeued %d buffers for stream %p", __func__,
+            (*it)->num_pending_buffers, (*it)->stream);
+        if ((*it)->num_pending_buffers > 0 &&
+            (*it)->num_pending_buffers >= (*it)->stream->max_buffers) {
+            CDBG("%s: Wait!!! Max buffers Dequed", __func__);
+            max_buffers_dequeued = true;
+            break;
         }
     }
 
@@ -1449,6 +1463,173 @@ void QCamera3HardwareInterface::unblockRequestIfNecessary()
     }
 }
 
+/*===========================================================================
+ * FUNCTION   : addPendingBuffer
+ *
+ * DESCRIPTION: Book-keep a buffer handed to the HAL until it is returned.
+ *              Note that mMutex is held when this function is called.
+ *
+ * PARAMETERS :
+ *   @frame_number : frame number of the request
+ *   @stream       : stream of the buffer
+ *   @buffer       : buffer handle
+ *
+ * RETURN     : NO_ERROR on success
+ *              NO_MEMORY if the pending buffer map cannot grow
+ *==========================================================================*/
+int32_t QCamera3HardwareInterface::addPendingBuffer(uint32_t frame_number,
+        camera3_stream_t *stream, buffer_handle_t *buffer)
+{
+    PendingFrameBuffers *frame =
+        mPendingBuffersMap.mPendingBufferList.insert(frame_number);
+    if (frame == NULL || frame->num_buffers >= MAX_NUM_STREAMS) {
+        return NO_MEMORY;
+    }
+    frame->frame_number = frame_number;
+
+    PendingBufferInfo *bufferInfo = &frame->buffers[frame->num_buffers++];
+    bufferInfo->frame_number = frame_number;
+    bufferInfo->stream = stream;
+    bufferInfo->buffer = buffer;
+    mPendingBuffersMap.num_buffers++;
+    updateStreamPendingBuffers(stream, 1);
+    return NO_ERROR;
+}
+
+/*===========================================================================
+ * FUNCTION   : removePendingBuffer
+ *
+ * DESCRIPTION: Drop a returned buffer from the pending buffers map. Frame
+ *              drop info of the frame is released with its last buffer.
+ *              Note that mMutex is held when this function is called.
+ *
+ * PARAMETERS :
+ *   @frame_number : frame number of the request
+ *   @buffer       : buffer handle
+ *
+ * RETURN     : true if the buffer was pending, false otherwise
+ *==========================================================================*/
+bool QCamera3HardwareInterface::removePendingBuffer(uint32_t frame_number,
+        buffer_handle_t *buffer)
+{
+    PendingFrameBuffers *frame =
+        mPendingBuffersMap.mPendingBufferList.find(frame_number);
+    if (frame == NULL) {
+        return false;
+    }
+
+    for (uint32_t k = 0; k < frame->num_buffers; k++) {
+        if (frame->buffers[k].buffer == buffer) {
+            updateStreamPendingBuffers(frame->buffers[k].stream, -1);
+            frame->buffers[k] = frame->buffers[--frame->num_buffers];
+            mPendingBuffersMap.num_buffers--;
+            if (frame->num_buffers == 0) {
+                mPendingBuffersMap.mPendingBufferList.erase(frame_number);
+                mPendingFrameDropList.erase(frame_number);
+            }
+            return true;
+        }
+    }
+    return false;
+}
+
+/*===========================================================================
+ * FUNCTION   : updateStreamPendingBuffers
+ *
+ * DESCRIPTION: Adjust the count of buffers pending on a stream
+ *
+ * PARAMETERS :
+ *   @stream : stream of the buffer
+ *   @delta  : change of the count
+ *
+ * RETURN     : None
+ *==========================================================================*/
+void QCamera3HardwareInterface::updateStreamPendingBuffers(
+        camera3_stream_t *stream, int32_t delta)
+{
+    for (List<stream_info_t*>::iterator it = mStreamInfo.begin();
+        it != mStreamInfo.end(); it++) {
+        if ((*it)->stream == stream) {
+            (*it)->num_pending_buffers += delta;
+            break;
+        }
+    }
+}
+
+/*===========================================================================
+ * FUNCTION   : resetPendingBuffers
+ *
+ * DESCRIPTION: Forget all pending buffers
+ *
+ * PARAMETERS : None
+ *
+ * RETURN     : None
+ *==========================================================================*/
+void QCamera3HardwareInterface::resetPendingBuffers()
+{
+    mPendingBuffersMap.num_buffers = 0;
+    mPendingBuffersMap.mPendingBufferList.clear();
+    for (List<stream_info_t*>::iterator it = mStreamInfo.begin();
+        it != mStreamInfo.end(); it++) {
+        (*it)->num_pending_buffers = 0;
+    }
+}
+
+/*===========================================================================
+ * FUNCTION   : addFrameDrop
+ *
+ * DESCRIPTION: Remember that a stream buffer of a frame was dropped
+ *
+ * PARAMETERS :
+ *   @frame_number : frame number of the request
+ *   @streamID     : stream ID of the dropped buffer
+ *
+ * RETURN     : None
+ *==========================================================================*/
+void QCamera3HardwareInterface::addFrameDrop(uint32_t frame_number,
+        uint32_t streamID)
+{
+    PendingFrameDropInfo *drop = mPendingFrameDropList.insert(frame_number);
+    if (drop == NULL || drop->num_streams >= MAX_NUM_STREAMS) {
+        ALOGE("%s: cannot record drop of frame %d stream %d",
+                __func__, frame_number, streamID);
+        return;
+    }
+    drop->frame_number = frame_number;
+    drop->stream_ID[drop->num_streams++] = streamID;
+}
+
+/*===========================================================================
+ * FUNCTION   : consumeFrameDrop
+ *
+ * DESCRIPTION: Check and clear the drop of a stream buffer of a frame
+ *
+ * PARAMETERS :
+ *   @frame_number : frame number of the request
+ *   @streamID     : stream ID of the buffer
+ *
+ * RETURN     : true if the buffer was dropped, false otherwise
+ *==========================================================================*/
+bool QCamera3HardwareInterface::consumeFrameDrop(uint32_t frame_number,
+        uint32_t streamID)
+{
+    PendingFrameDropInfo *drop = mPendingFrameDropList.find(frame_number);
+    if (drop == NULL) {
+        return false;
+    }
+
+    for (uint32_t k = 0; k < drop->num_streams; k++) {
+        if (drop->stream_ID[k] == streamID) {
+            drop->stream_ID[k] = drop->stream_ID[--drop->num_streams];
+            if (drop->num_streams == 0) {
+                mPendingFrameDropList.erase(frame_number);
+            }
+            return true;
+        }
+    }
+    return false;
+}
+
 /*===========================================================================
  * FUNCTION   : processCaptureRequest
  *
@@ -1500,7 +1681,7 @@ int QCamera3HardwareInterface::processCaptureRequest(
             uint8_t captureIntent =
                 meta.find(ANDROID_CONTROL_CAPTURE_INTENT).data.u8[0];
 
-            memset(mParameters, 0, sizeof(parm_buffer_t));
+            cam_parm_batch_init(mParameters, &mParmDirty);
             AddSetParmEntryToBatch(mParameters, CAM_INTF_PARM_HAL_VERSION,
                 sizeof(hal_version), &hal_version);
             AddSetParmEntryToBatch(mParameters, CAM_INTF_META_CAPTURE_INTENT,
@@ -1610,37 +1791,44 @@ int QCamera3HardwareInterface::processCaptureRequest(
     }
 
     /* Update pending request list and pending buffers map */
-    PendingRequestInfo pendingRequest;
-    pendingRequest.frame_number = frameNumber;
-    pendingRequest.num_buffers = request->num_output_buffers;
-    pendingRequest.request_id = request_id;
-    pendingRequest.blob_request = blob_request;
-    pendingRequest.timestamp = 0;
-    pendingRequest.bNotified = 0;
+    PendingRequestInfo *pendingRequest =
+        mPendingRequestsList.insert(frameNumber);
+    if (pendingRequest == NULL) {
+        ALOGE("%s: no memory for pending request %d", __func__, frameNumber);
+        pthread_mutex_unlock(&mMutex);
+        return NO_MEMORY;
+    }
+    pendingRequest->frame_number = frameNumber;
+    pendingRequest->num_buffers = request->num_output_buffers;
+    pendingRequest->request_id = request_id;
+    pendingRequest->blob_request = blob_request;
+    pendingRequest->timestamp = 0;
+    pendingRequest->bNotified = 0;
     if (blob_request)
-        pendingRequest.input_jpeg_settings = *mJpegSettings;
-    pendingRequest.input_buffer_present = (request->input_buffer != NULL)? 1 : 0;
+        pendingRequest->input_jpeg_settings = *mJpegSettings;
+    pendingRequest->input_buffer_present = (request->input_buffer != NULL)? 1 : 0;
 
     for (size_t i = 0; i < request->num_output_buffers; i++) {
-        RequestedBufferInfo requestedBuf;
-        requestedBuf.stream = request->output_buffers[i].stream;
-        requestedBuf.buffer = NULL;
-        pendingRequest.buffers.push_back(requestedBuf);
+        RequestedBufferInfo *requestedBuf = &pendingRequest->buffers[i];
+        requestedBuf->stream = request->output_buffers[i].stream;
+        requestedBuf->buffer_ready = false;
 
         // Add to buffer handle the pending buffers list
-        PendingBufferInfo bufferInfo;
-        bufferInfo.frame_number = frameNumber;
-        bufferInfo.buffer = request->output_buffers[i].buffer;
-        bufferInfo.stream = request->output_buffers[i].stream;
-        mPendingBuffersMap.mPendingBufferList.push_back(bufferInfo);
-        mPendingBuffersMap.num_buffers++;
+        rc = addPendingBuffer(frameNumber, request->output_buffers[i].stream,
+                request->output_buffers[i].buffer);
+        if (rc != NO_ERROR) {
+            ALOGE("%s: no memory for pending buffers of %d",
+                    __func__, frameNumber);
+            pthread_mutex_unlock(&mMutex);
+            return rc;
+        }
         CDBG("%s: frame = %d, buffer = %p, stream = %p, stream format = %d",
-          __func__, frameNumber, bufferInfo.buffer, bufferInfo.stream,
-          bufferInfo.stream->format);
+          __func__, frameNumber, request->output_buffers[i].buffer,
+          request->output_buffers[i].stream,
+          request->output_buffers[i].stream->format);
     }
     CDBG("%s: mPendingBuffersMap.num_buffers = %d",
           __func__, mPendingBuffersMap.num_buffers);
-    mPendingRequestsList.push_back(pendingRequest);
 
     // Notify metadata channel we receive a request
     mMetadataChannel->request(NULL, frameNumber);
@@ -1743,6 +1931,11 @@ int QCamera3HardwareInterface::processCaptureRequest(
     }
     //Block on conditional variable
     mPendingRequest++;
+    mInFlight.requestSubmitted(frameNumber, getMinFrameDuration(request),
+            systemTime());
+    //Every request waits for one result, only waits beyond that are
+    //caused by the in flight depth and count as a stall
+    nsecs_t stallStart = 0;
     do {
         if (!isValidTimeout) {
             CDBG("%s: Blocking on conditional wait", __func__);
@@ -1758,7 +1951,13 @@ int QCamera3HardwareInterface::processCaptureRequest(
             }
         }
         CDBG("%s: Unblocked", __func__);
-    }while (mPendingRequest >= kMaxInFlight);
+        if (stallStart == 0 && mPendingRequest >= (int)mInFlight.getDepth()) {
+            stallStart = systemTime();
+        }
+    }while (mPendingRequest >= (int)mInFlight.getDepth());
+    if (stallStart != 0) {
+        mInFlight.stallRecorded(systemTime() - stallStart);
+    }
 
     pthread_mutex_unlock(&mMutex);
 
@@ -1802,13 +2001,13 @@ void QCamera3HardwareInterface::dump(int fd)
     pthread_mutex_lock(&mMutex);
     fdprintf(fd, "\n Camera HAL3 information Begin \n");
 
-    fdprintf(fd, "\nNumber of pending requests: %zd \n",
+    fdprintf(fd, "\nNumber of pending requests: %u \n",
         mPendingRequestsList.size());
     fdprintf(fd, "-------+-------------------+-------------+----------+---------------------\n");
     fdprintf(fd, " Frame | Number of Buffers |   Req Id:   | Blob Req | Input buffer present\n");
     fdprintf(fd, "-------+-------------------+-------------+----------+---------------------\n");
-    for(List<PendingRequestInfo>::iterator i = mPendingRequestsList.begin();
-        i != mPendingRequestsList.end(); i++) {
+    for (PendingRequestInfo *i = mPendingRequestsList.first(); i != NULL;
+        i = mPendingRequestsList.next(i->frame_number)) {
         fdprintf(fd, " %5d | %17d | %11d | %8d | %19d \n",
         i->frame_number, i->num_buffers, i->request_id, i->blob_request,
         i->input_buffer_present);
@@ -1832,26 +2031,39 @@ void QCamera3HardwareInterface::dump(int fd)
     fdprintf(fd, "-------+-------------\n");
     fdprintf(fd, " Frame | Stream type \n");
     fdprintf(fd, "-------+-------------\n");
-    for(List<PendingBufferInfo>::iterator i =
-        mPendingBuffersMap.mPendingBufferList.begin();
-        i != mPendingBuffersMap.mPendingBufferList.end(); i++) {
-        fdprintf(fd, " %5d | %11d \n",
-            i->frame_number, i->stream->stream_type);
+    for (PendingFrameBuffers *i = mPendingBuffersMap.mPendingBufferList.first();
+        i != NULL; i = mPendingBuffersMap.mPendingBufferList.next(i->frame_number)) {
+        for (uint32_t k = 0; k < i->num_buffers; k++) {
+            fdprintf(fd, " %5d | %11d \n",
+                i->frame_number, i->buffers[k].stream->stream_type);
+        }
     }
     fdprintf(fd, "-------+-------------\n");
 
-    fdprintf(fd, "\nPending frame drop list: %zd\n",
+    fdprintf(fd, "\nPending frame drop list: %u\n",
         mPendingFrameDropList.size());
     fdprintf(fd, "-------+-----------\n");
     fdprintf(fd, " Frame | Stream ID \n");
     fdprintf(fd, "-------+-----------\n");
-    for(List<PendingFrameDropInfo>::iterator i = mPendingFrameDropList.begin();
-        i != mPendingFrameDropList.end(); i++) {
-        fdprintf(fd, " %5d | %9d \n",
-            i->frame_number, i->stream_ID);
+    for (PendingFrameDropInfo *i = mPendingFrameDropList.first(); i != NULL;
+        i = mPendingFrameDropList.next(i->frame_number)) {
+        for (uint32_t k = 0; k < i->num_streams; k++) {
+            fdprintf(fd, " %5d | %9d \n",
+                i->frame_number, i->stream_ID[k]);
+        }
     }
     fdprintf(fd, "-------+-----------\n");
 
+    fdprintf(fd, "\nIn flight requests: %d, depth: %u (max %u)\n",
+        mPendingRequest, mInFlight.getDepth(), mInFlight.getMaxDepth());
+    fdprintf(fd, "Frame duration: %lld ns, result latency min: %lld ns avg: %lld ns\n",
+        (long long)mInFlight.getFrameDuration(),
+        (long long)mInFlight.getMinLatency(),
+        (long long)mInFlight.getAvgLatency());
+    fdprintf(fd, "Request stalls: %u, total: %lld ns, max: %lld ns\n",
+        mInFlight.getStallCount(), (long long)mInFlight.getStallTime(),
+        (long long)mInFlight.getMaxStallTime());
+
     fdprintf(fd, "\n Camera HAL3 information End \n");
     pthread_mutex_unlock(&mMutex);
     return;
@@ -1897,20 +2109,22 @@ int QCamera3HardwareInterface::flush()
     mPendingRequest = 0;
     pthread_cond_signal(&mRequestCond);
 
-    List<PendingRequestInfo>::iterator i = mPendingRequestsList.begin();
-    frameNum = i->frame_number;
+    PendingRequestInfo *i = mPendingRequestsList.first();
+    if (i != NULL)
+        frameNum = i->frame_number;
     CDBG("%s: Latest frame num on  mPendingRequestsList = %d",
       __func__, frameNum);
 
     // Go through the pending buffers and send buffer errors
-    for (List<PendingBufferInfo>::iterator k =
-         mPendingBuffersMap.mPendingBufferList.begin();
-         k != mPendingBuffersMap.mPendingBufferList.end();  ) {
-         CDBG("%s: frame = %d, buffer = %p, stream = %p, stream format = %d",
-          __func__, k->frame_number, k->buffer, k->stream,
-          k->stream->format);
-
-        if (k->frame_number < frameNum) {
+    for (PendingFrameBuffers *f = mPendingBuffersMap.mPendingBufferList.first();
+         f != NULL && (i == NULL || f->frame_number < frameNum);
+         f = mPendingBuffersMap.mPendingBufferList.first()) {
+        for (uint32_t b = 0; b < f->num_buffers; b++) {
+            PendingBufferInfo *k = &f->buffers[b];
+            CDBG("%s: frame = %d, buffer = %p, stream = %p, stream format = %d",
+              __func__, k->frame_number, k->buffer, k->stream,
+              k->stream->format);
+
             // Send Error notify to frameworks for each buffer for which
             // metadata buffer is already sent
             CDBG("%s: Sending ERROR BUFFER for frame %d, buffer %p",
@@ -1922,7 +2136,7 @@ int QCamera3HardwareInterface::flush()
             notify_msg.message.error.frame_number = k->frame_number;
             mCallbackOps->notify(mCallbackOps, &notify_msg);
             CDBG("%s: notify frame_number = %d", __func__,
-                    i->frame_number);
+                    k->frame_number);
 
             pStream_Buf.acquire_fence = -1;
             pStream_Buf.release_fence = -1;
@@ -1937,17 +2151,15 @@ int QCamera3HardwareInterface::flush()
             mCallbackOps->process_capture_result(mCallbackOps, &result);
 
             mPendingBuffersMap.num_buffers--;
-            k = mPendingBuffersMap.mPendingBufferList.erase(k);
-        }
-        else {
-          k++;
         }
+        mPendingBuffersMap.mPendingBufferList.erase(f->frame_number);
     }
 
     CDBG("%s:Sending ERROR REQUEST for all pending requests", __func__);
 
     // Go through the pending requests info and send error request to framework
-    for (i = mPendingRequestsList.begin(); i != mPendingRequestsList.end(); ) {
+    for (i = mPendingRequestsList.first(); i != NULL;
+            i = mPendingRequestsList.first()) {
         CDBG("%s:Sending ERROR REQUEST for frame %d",
               __func__, i->frame_number);
 
@@ -1962,10 +2174,10 @@ int QCamera3HardwareInterface::flush()
         result.num_output_buffers = 0;
         result.output_buffers = NULL;
 
-        for (List<PendingBufferInfo>::iterator k =
-             mPendingBuffersMap.mPendingBufferList.begin();
-             k != mPendingBuffersMap.mPendingBufferList.end(); ) {
-          if (k->frame_number == i->frame_number) {
+        PendingFrameBuffers *f =
+            mPendingBuffersMap.mPendingBufferList.find(i->frame_number);
+        for (uint32_t b = 0; f != NULL && b < f->num_buffers; b++) {
+            PendingBufferInfo *k = &f->buffers[b];
             CDBG("%s: Sending Error for frame = %d, buffer = %p,"
                    " stream = %p, stream format = %d",__func__,
                    k->frame_number, k->buffer, k->stream, k->stream->format);
@@ -1983,16 +2195,12 @@ int QCamera3HardwareInterface::flush()
 
             mCallbackOps->process_capture_result(mCallbackOps, &result);
             mPendingBuffersMap.num_buffers--;
-            k = mPendingBuffersMap.mPendingBufferList.erase(k);
-          }
-          else {
-            k++;
-          }
         }
+        mPendingBuffersMap.mPendingBufferList.erase(i->frame_number);
         CDBG("%s: mPendingBuffersMap.num_buffers = %d",
               __func__, mPendingBuffersMap.num_buffers);
 
-        i = mPendingRequestsList.erase(i);
+        mPendingRequestsList.erase(i->frame_number);
     }
 
     /* Reset pending buffer list and requests list */
@@ -2000,8 +2208,7 @@ int QCamera3HardwareInterface::flush()
     /* Reset pending frame Drop list and requests list */
     mPendingFrameDropList.clear();
 
-    mPendingBuffersMap.num_buffers = 0;
-    mPendingBuffersMap.mPendingBufferList.clear();
+    resetPendingBuffers();
     CDBG("%s: Cleared all the pending buffers ", __func__);
 
     /*flush the metadata list*/
@@ -2116,338 +2323,386 @@ QCamera3HardwareInterface::translateCbMetadataToResultMetadata
                                frameNumber);
         }
     }
-    if (IS_META_AVAILABLE(CAM_INTF_META_FACE_DETECTION, metadata)){
-        cam_face_detection_data_t *faceDetectionInfo =
-            (cam_face_detection_data_t *)POINTER_OF_META(CAM_INTF_META_FACE_DETECTION, metadata);
-        uint8_t numFaces = faceDetectionInfo->num_faces_detected;
-        int32_t faceIds[MAX_ROI];
-        uint8_t faceScores[MAX_ROI];
-        int32_t faceRectangles[MAX_ROI * 4];
-        int32_t faceLandmarks[MAX_ROI * 6];
-        size_t j = 0, k = 0;
-        for (size_t i = 0; i < numFaces; i++) {
-            faceIds[i] = faceDetectionInfo->faces[i].face_id;
-            faceScores[i] = (uint8_t)faceDetectionInfo->faces[i].score;
-            convertToRegions(faceDetectionInfo->faces[i].face_boundary,
-                faceRectangles+j, -1);
-            convertLandmarks(faceDetectionInfo->faces[i], faceLandmarks+k);
-            j+= 4;
-            k+= 6;
-        }
-
-        if (numFaces <= 0) {
-            memset(faceIds, 0, sizeof(int32_t) * MAX_ROI);
-            memset(faceScores, 0, sizeof(uint8_t) * MAX_ROI);
-            memset(faceRectangles, 0, sizeof(int32_t) * MAX_ROI * 4);
-            memset(faceLandmarks, 0, sizeof(int32_t) * MAX_ROI * 6);
-        }
-
-        camMetadata.update(ANDROID_STATISTICS_FACE_IDS, faceIds, numFaces);
-        camMetadata.update(ANDROID_STATISTICS_FACE_SCORES, faceScores, numFaces);
-        camMetadata.update(ANDROID_STATISTICS_FACE_RECTANGLES, faceRectangles, numFaces * 4U);
-        camMetadata.update(ANDROID_STATISTICS_FACE_LANDMARKS, faceLandmarks, numFaces * 6U);
-    }
-    if (IS_META_AVAILABLE(CAM_INTF_META_TONEMAP_MODE, metadata)){
-         uint8_t  *toneMapMode =
-            (uint8_t *)POINTER_OF_META(CAM_INTF_META_TONEMAP_MODE, metadata);
-         camMetadata.update(ANDROID_TONEMAP_MODE, toneMapMode, 1);
-    }
-    if (IS_META_AVAILABLE(CAM_INTF_META_COLOR_CORRECT_MODE, metadata)){
-        uint8_t  *color_correct_mode =
-            (uint8_t *)POINTER_OF_META(CAM_INTF_META_COLOR_CORRECT_MODE, metadata);
-        camMetadata.update(ANDROID_COLOR_CORRECTION_MODE, color_correct_mode, 1);
-    }
-    if (IS_META_AVAILABLE(CAM_INTF_META_EDGE_MODE, metadata)) {
-        cam_edge_application_t  *edgeApplication =
-            (cam_edge_application_t *)POINTER_OF_META(CAM_INTF_META_EDGE_MODE, metadata);
-        uint8_t edgeStrength = (uint8_t)edgeApplication->sharpness;
-        camMetadata.update(ANDROID_EDGE_MODE, &(edgeApplication->edge_mode), 1);
-        camMetadata.update(ANDROID_EDGE_STRENGTH, &edgeStrength, 1);
-    }
-    if (IS_META_AVAILABLE(CAM_INTF_META_FLASH_POWER, metadata)) {
-        uint8_t  *flashPower =
-            (uint8_t *)POINTER_OF_META(CAM_INTF_META_FLASH_POWER, metadata);
-        camMetadata.update(ANDROID_FLASH_FIRING_POWER, flashPower, 1);
-    }
-    if (IS_META_AVAILABLE(CAM_INTF_META_FLASH_FIRING_TIME, metadata)) {
-        int64_t  *flashFiringTime =
-            (int64_t *)POINTER_OF_META(CAM_INTF_META_FLASH_FIRING_TIME, metadata);
-        camMetadata.update(ANDROID_FLASH_FIRING_TIME, flashFiringTime, 1);
-    }
-    if (IS_META_AVAILABLE(CAM_INTF_META_FLASH_STATE, metadata)) {
-        int32_t *flashState = (int32_t *)POINTER_OF_META(CAM_INTF_META_FLASH_STATE, metadata);
-        uint8_t val = (uint8_t)*flashState;
-        if (!gCamCapability[mCameraId]->flash_available) {
-            val = (uint8_t) ANDROID_FLASH_STATE_UNAVAILABLE;
-        }
-        camMetadata.update(ANDROID_FLASH_STATE, &val, 1);
-    }
-    if (IS_META_AVAILABLE(CAM_INTF_META_FLASH_MODE, metadata)){
-        uint8_t *flashMode = (uint8_t*)
-            POINTER_OF_META(CAM_INTF_META_FLASH_MODE, metadata);
-        int val = lookupFwkName(FLASH_MODES_MAP, METADATA_MAP_SIZE(FLASH_MODES_MAP), *flashMode);
-        if (NAME_NOT_FOUND != val) {
-            uint8_t fwk_flashMode = (uint8_t)val;
-            camMetadata.update(ANDROID_FLASH_MODE, &fwk_flashMode, 1);
-        }
-    }
-    if (IS_META_AVAILABLE(CAM_INTF_META_HOTPIXEL_MODE, metadata)) {
-        uint8_t  *hotPixelMode =
-            (uint8_t *)POINTER_OF_META(CAM_INTF_META_HOTPIXEL_MODE, metadata);
-        camMetadata.update(ANDROID_HOT_PIXEL_MODE, hotPixelMode, 1);
-    }
-    if (IS_META_AVAILABLE(CAM_INTF_META_LENS_APERTURE, metadata)){
-        float  *lensAperture =
-            (float *)POINTER_OF_META(CAM_INTF_META_LENS_APERTURE, metadata);
-        camMetadata.update(ANDROID_LENS_APERTURE , lensAperture, 1);
-    }
-    if (IS_META_AVAILABLE(CAM_INTF_META_LENS_FILTERDENSITY, metadata)) {
-        float  *filterDensity =
-            (float *)POINTER_OF_META(CAM_INTF_META_LENS_FILTERDENSITY, metadata);
-        camMetadata.update(ANDROID_LENS_FILTER_DENSITY , filterDensity, 1);
-    }
-    if (IS_META_AVAILABLE(CAM_INTF_META_LENS_FOCAL_LENGTH, metadata)){
-        float  *focalLength =
-            (float *)POINTER_OF_META(CAM_INTF_META_LENS_FOCAL_LENGTH, metadata);
-        camMetadata.update(ANDROID_LENS_FOCAL_LENGTH, focalLength, 1);
-    }
-    if (IS_META_AVAILABLE(CAM_INTF_META_LENS_FOCUS_DISTANCE, metadata)) {
-        float  *focusDistance =
-            (float *)POINTER_OF_META(CAM_INTF_META_LENS_FOCUS_DISTANCE, metadata);
-        camMetadata.update(ANDROID_LENS_FOCUS_DISTANCE , focusDistance, 1);
-    }
-    if (IS_META_AVAILABLE(CAM_INTF_META_LENS_FOCUS_RANGE, metadata)) {
-        float  *focusRange =
-            (float *)POINTER_OF_META(CAM_INTF_META_LENS_FOCUS_RANGE, metadata);
-        camMetadata.update(ANDROID_LENS_FOCUS_RANGE , focusRange, 2);
-    }
-    if (IS_META_AVAILABLE(CAM_INTF_META_LENS_STATE, metadata)) {
-        cam_af_lens_state_t *lensState = (cam_af_lens_state_t *)
-            POINTER_OF_META(CAM_INTF_META_LENS_STATE, metadata);
-        int val = lookupFwkName(LENS_STATE_MAP, METADATA_MAP_SIZE(LENS_STATE_MAP), *lensState);
-        if (NAME_NOT_FOUND != val) {
-            uint8_t fwk_lensState = (cam_af_lens_state_t)val;
-            camMetadata.update(ANDROID_LENS_STATE , &fwk_lensState, 1);
-        }
-    }
-    if (IS_META_AVAILABLE(CAM_INTF_META_LENS_OPT_STAB_MODE, metadata)) {
-        uint8_t  *opticalStab =
-            (uint8_t *)POINTER_OF_META(CAM_INTF_META_LENS_OPT_STAB_MODE, metadata);
-        camMetadata.update(ANDROID_LENS_OPTICAL_STABILIZATION_MODE ,opticalStab, 1);
-    }
-    if (IS_META_AVAILABLE(CAM_INTF_META_NOISE_REDUCTION_MODE, metadata)) {
-        uint8_t  *noiseRedMode =
-            (uint8_t *)POINTER_OF_META(CAM_INTF_META_NOISE_REDUCTION_MODE, metadata);
-        camMetadata.update(ANDROID_NOISE_REDUCTION_MODE , noiseRedMode, 1);
-    }
-    if (IS_META_AVAILABLE(CAM_INTF_META_NOISE_REDUCTION_STRENGTH, metadata)) {
-        uint8_t  *noiseRedStrength =
-            (uint8_t *)POINTER_OF_META(CAM_INTF_META_NOISE_REDUCTION_STRENGTH, metadata);
-        camMetadata.update(ANDROID_NOISE_REDUCTION_STRENGTH, noiseRedStrength, 1);
-    }
-    if (IS_META_AVAILABLE(CAM_INTF_META_SCALER_CROP_REGION, metadata)) {
-        cam_crop_region_t  *hScalerCropRegion =(cam_crop_region_t *)
-            POINTER_OF_META(CAM_INTF_META_SCALER_CROP_REGION, metadata);
-        int32_t scalerCropRegion[4];
-        scalerCropRegion[0] = hScalerCropRegion->left;
-        scalerCropRegion[1] = hScalerCropRegion->top;
-        scalerCropRegion[2] = hScalerCropRegion->width;
-        scalerCropRegion[3] = hScalerCropRegion->height;
-        camMetadata.update(ANDROID_SCALER_CROP_REGION, scalerCropRegion, 4);
-    }
-    if (IS_META_AVAILABLE(CAM_INTF_META_SENSOR_EXPOSURE_TIME, metadata)){
-        int64_t  *sensorExpTime =
-            (int64_t *)POINTER_OF_META(CAM_INTF_META_SENSOR_EXPOSURE_TIME, metadata);
-        mMetadataResponse.exposure_time = *sensorExpTime;
-        CDBG("%s: sensorExpTime = %lld", __func__, *sensorExpTime);
-        camMetadata.update(ANDROID_SENSOR_EXPOSURE_TIME , sensorExpTime, 1);
-    }
-    if (IS_META_AVAILABLE(CAM_INTF_META_SENSOR_FRAME_DURATION, metadata)){
-        int64_t  *sensorFameDuration =
-            (int64_t *)POINTER_OF_META(CAM_INTF_META_SENSOR_FRAME_DURATION, metadata);
-        CDBG("%s: sensorFameDuration = %lld", __func__, *sensorFameDuration);
-        camMetadata.update(ANDROID_SENSOR_FRAME_DURATION, sensorFameDuration, 1);
-    }
-    if (IS_META_AVAILABLE(CAM_INTF_META_SENSOR_SENSITIVITY, metadata)){
-        int32_t  *sensorSensitivity =
-            (int32_t *)POINTER_OF_META(CAM_INTF_META_SENSOR_SENSITIVITY, metadata);
-        CDBG("%s: sensorSensitivity = %d", __func__, *sensorSensitivity);
-        mMetadataResponse.iso_speed = *sensorSensitivity;
-        camMetadata.update(ANDROID_SENSOR_SENSITIVITY, sensorSensitivity, 1);
-    }
-    if (IS_META_AVAILABLE(CAM_INTF_META_SHADING_MODE, metadata)) {
-     uint8_t *shadingMode = (uint8_t *)
-             POINTER_OF_META(CAM_INTF_META_SHADING_MODE, metadata);
-     camMetadata.update(ANDROID_SHADING_MODE, shadingMode, 1);
-    }
-    if (IS_META_AVAILABLE(CAM_INTF_META_STATS_FACEDETECT_MODE, metadata)) {
-        uint8_t *faceDetectMode = (uint8_t *)
-                POINTER_OF_META(CAM_INTF_META_STATS_FACEDETECT_MODE, metadata);
-        int val = lookupFwkName(FACEDETECT_MODES_MAP, METADATA_MAP_SIZE(FACEDETECT_MODES_MAP),
-                *faceDetectMode);
-        if (NAME_NOT_FOUND != val) {
-            uint8_t fwk_faceDetectMode = (uint8_t)val;
-            camMetadata.update(ANDROID_STATISTICS_FACE_DETECT_MODE, &fwk_faceDetectMode, 1);
-        }
-    }
-    if (IS_META_AVAILABLE(CAM_INTF_META_STATS_HISTOGRAM_MODE, metadata)) {
-     uint8_t  *histogramMode =
-        (uint8_t *)POINTER_OF_META(CAM_INTF_META_STATS_HISTOGRAM_MODE, metadata);
-     camMetadata.update(ANDROID_STATISTICS_HISTOGRAM_MODE, histogramMode, 1);
-    }
-    if (IS_META_AVAILABLE(CAM_INTF_META_STATS_SHARPNESS_MAP_MODE, metadata)){
-       uint8_t  *sharpnessMapMode =
-          (uint8_t *)POINTER_OF_META(CAM_INTF_META_STATS_SHARPNESS_MAP_MODE, metadata);
-       camMetadata.update(ANDROID_STATISTICS_SHARPNESS_MAP_MODE,
-                          sharpnessMapMode, 1);
-    }
-    if (IS_META_AVAILABLE(CAM_INTF_META_STATS_SHARPNESS_MAP, metadata)){
-       cam_sharpness_map_t  *sharpnessMap = (cam_sharpness_map_t *)
-       POINTER_OF_META(CAM_INTF_META_STATS_SHARPNESS_MAP, metadata);
-       camMetadata.update(ANDROID_STATISTICS_SHARPNESS_MAP,
-                          (int32_t*)sharpnessMap->sharpness,
-                          CAM_MAX_MAP_WIDTH*CAM_MAX_MAP_HEIGHT);
-    }
-    if (IS_META_AVAILABLE(CAM_INTF_META_LENS_SHADING_MAP, metadata)) {
-        cam_lens_shading_map_t *lensShadingMap = (cam_lens_shading_map_t *)
-            POINTER_OF_META(CAM_INTF_META_LENS_SHADING_MAP, metadata);
-        size_t map_height = (size_t)gCamCapability[mCameraId]->lens_shading_map_size.height;
-        size_t map_width = (size_t)gCamCapability[mCameraId]->lens_shading_map_size.width;
-        camMetadata.update(ANDROID_STATISTICS_LENS_SHADING_MAP,
-                (float*)lensShadingMap->lens_shading, 4U * map_width * map_height);
-    }
-    if (IS_META_AVAILABLE(CAM_INTF_META_TONEMAP_CURVES, metadata)){
-        //Populate CAM_INTF_META_TONEMAP_CURVES
-        /* ch0 = G, ch 1 = B, ch 2 = R*/
-        cam_rgb_tonemap_curves *tonemap = (cam_rgb_tonemap_curves *)
-        POINTER_OF_META(CAM_INTF_META_TONEMAP_CURVES, metadata);
-        camMetadata.update(ANDROID_TONEMAP_CURVE_GREEN,
-                        (float*)tonemap->curves[0].tonemap_points,
-                        tonemap->tonemap_points_cnt * 2);
-
-        camMetadata.update(ANDROID_TONEMAP_CURVE_BLUE,
-                        (float*)tonemap->curves[1].tonemap_points,
-                        tonemap->tonemap_points_cnt * 2);
-
-        camMetadata.update(ANDROID_TONEMAP_CURVE_RED,
-                        (float*)tonemap->curves[2].tonemap_points,
-                        tonemap->tonemap_points_cnt * 2);
-    }
-    if (IS_META_AVAILABLE(CAM_INTF_META_COLOR_CORRECT_GAINS, metadata)){
-        cam_color_correct_gains_t *colorCorrectionGains = (cam_color_correct_gains_t*)
-            POINTER_OF_META(CAM_INTF_META_COLOR_CORRECT_GAINS, metadata);
-        camMetadata.update(ANDROID_COLOR_CORRECTION_GAINS, colorCorrectionGains->gains, 4);
-    }
-    if (IS_META_AVAILABLE(CAM_INTF_META_COLOR_CORRECT_TRANSFORM, metadata)){
-        cam_color_correct_matrix_t *colorCorrectionMatrix = (cam_color_correct_matrix_t*)
-                POINTER_OF_META(CAM_INTF_META_COLOR_CORRECT_TRANSFORM, metadata);
-        camMetadata.update(ANDROID_COLOR_CORRECTION_TRANSFORM,
-            (camera_metadata_rational_t*)(void *)colorCorrectionMatrix->transform_matrix, 9);
-    }
-    if (IS_META_AVAILABLE(CAM_INTF_META_PRED_COLOR_CORRECT_GAINS, metadata)){
-        cam_color_correct_gains_t *predColorCorrectionGains = (cam_color_correct_gains_t*)
-            POINTER_OF_META(CAM_INTF_META_PRED_COLOR_CORRECT_GAINS, metadata);
-        camMetadata.update(ANDROID_STATISTICS_PREDICTED_COLOR_GAINS,
-            predColorCorrectionGains->gains, 4);
-    }
-    if (IS_META_AVAILABLE(CAM_INTF_META_PRED_COLOR_CORRECT_TRANSFORM, metadata)){
-        cam_color_correct_matrix_t *predColorCorrectionMatrix = (cam_color_correct_matrix_t*)
-            POINTER_OF_META(CAM_INTF_META_PRED_COLOR_CORRECT_TRANSFORM, metadata);
-        camMetadata.update(ANDROID_STATISTICS_PREDICTED_COLOR_TRANSFORM,
-            (camera_metadata_rational_t*)(void *)predColorCorrectionMatrix->transform_matrix, 9);
-    }
-    if (IS_META_AVAILABLE(CAM_INTF_META_BLACK_LEVEL_LOCK, metadata)){
-        uint8_t *blackLevelLock = (uint8_t*)
-            POINTER_OF_META(CAM_INTF_META_BLACK_LEVEL_LOCK, metadata);
-        camMetadata.update(ANDROID_BLACK_LEVEL_LOCK, blackLevelLock, 1);
-    }
-    if (IS_META_AVAILABLE(CAM_INTF_META_SCENE_FLICKER, metadata)){
-        uint8_t *sceneFlicker = (uint8_t*)
-            POINTER_OF_META(CAM_INTF_META_SCENE_FLICKER, metadata);
-        camMetadata.update(ANDROID_STATISTICS_SCENE_FLICKER, sceneFlicker, 1);
-    }
-    if (IS_META_AVAILABLE(CAM_INTF_PARM_EFFECT, metadata)) {
-        uint8_t *effectMode = (uint8_t*)
-            POINTER_OF_META(CAM_INTF_PARM_EFFECT, metadata);
-        int val = lookupFwkName(EFFECT_MODES_MAP, METADATA_MAP_SIZE(EFFECT_MODES_MAP),
-                *effectMode);
-        if (val != NAME_NOT_FOUND) {
-            uint8_t fwk_effectMode = (uint8_t)val;
-            camMetadata.update(ANDROID_CONTROL_EFFECT_MODE, &fwk_effectMode, 1);
-        }
-    }
+    cam_intf_valid_map_t validMap;
+    cam_intf_valid_iter_t validIter;
+    cam_intf_parm_type_t metaId;
+
+    /* Visit only the entries present in this frame */
+    cam_intf_build_valid_map(metadata, &validMap);
+    cam_intf_valid_iter_init(&validIter, &validMap);
+    while (cam_intf_valid_iter_next(&validIter, &metaId)) {
+        switch (metaId) {
+        case CAM_INTF_META_FACE_DETECTION: {
+            cam_face_detection_data_t *faceDetectionInfo =
+                (cam_face_detection_data_t *)POINTER_OF_META(CAM_INTF_META_FACE_DETECTION, metadata);
+            uint8_t numFaces = faceDetectionInfo->num_faces_detected;
+            int32_t faceIds[MAX_ROI];
+            uint8_t faceScores[MAX_ROI];
+            int32_t faceRectangles[MAX_ROI * 4];
+            int32_t faceLandmarks[MAX_ROI * 6];
+            size_t j = 0, k = 0;
+            for (size_t i = 0; i < numFaces; i++) {
+                faceIds[i] = faceDetectionInfo->faces[i].face_id;
+                faceScores[i] = (uint8_t)faceDetectionInfo->faces[i].score;
+                convertToRegions(faceDetectionInfo->faces[i].face_boundary,
+                    faceRectangles+j, -1);
+                convertLandmarks(faceDetectionInfo->faces[i], faceLandmarks+k);
+                j+= 4;
+                k+= 6;
+            }
 
-    // CDS
-    if (IS_META_AVAILABLE(CAM_INTF_PARM_CDS_MODE, metadata)) {
-        cam_cds_mode_type_t *cds = (cam_cds_mode_type_t *)
-                POINTER_OF_META(CAM_INTF_PARM_CDS_MODE, metadata);
-        int32_t mode = *cds;
-        camMetadata.update(QCAMERA_CDS_MODE,
-                &mode, 1);
-    }
-
-    if (IS_META_AVAILABLE(CAM_INTF_META_LENS_SHADING_MAP_MODE, metadata)) {
-        uint8_t shadingMapMode = (uint8_t)
-                *((uint32_t *)POINTER_OF_META(CAM_INTF_META_LENS_SHADING_MAP_MODE, metadata));
-        camMetadata.update(ANDROID_STATISTICS_LENS_SHADING_MAP_MODE, &shadingMapMode, 1);
-    }
-
-    if (IS_META_AVAILABLE(CAM_INTF_META_AEC_ROI, metadata)) {
-        cam_area_t  *hAeRegions =
-            (cam_area_t *)POINTER_OF_META(CAM_INTF_META_AEC_ROI, metadata);
-        int32_t aeRegions[5];
-        convertToRegions(hAeRegions->rect, aeRegions, hAeRegions->weight);
-        camMetadata.update(ANDROID_CONTROL_AE_REGIONS, aeRegions, 5);
-        CDBG("%s: Metadata : ANDROID_CONTROL_AE_REGIONS: FWK: [%d,%d,%d,%d] HAL: [%d,%d,%d,%d]",
-                __func__, aeRegions[0], aeRegions[1], aeRegions[2], aeRegions[3],
-                hAeRegions->rect.left, hAeRegions->rect.top, hAeRegions->rect.width,
-                hAeRegions->rect.height);
-    }
-
-    if (IS_META_AVAILABLE(CAM_INTF_META_AF_ROI, metadata)) {
-        /*af regions*/
-        cam_area_t  *hAfRegions =
-            (cam_area_t *)POINTER_OF_META(CAM_INTF_META_AF_ROI, metadata);
-        int32_t afRegions[5];
-        convertToRegions(hAfRegions->rect, afRegions, hAfRegions->weight);
-        camMetadata.update(ANDROID_CONTROL_AF_REGIONS, afRegions, 5);
-        CDBG("%s: Metadata : ANDROID_CONTROL_AF_REGIONS: FWK: [%d,%d,%d,%d] HAL: [%d,%d,%d,%d]",
-                __func__, afRegions[0], afRegions[1], afRegions[2], afRegions[3],
-                hAfRegions->rect.left, hAfRegions->rect.top, hAfRegions->rect.width,
-                hAfRegions->rect.height);
-    }
-
-    if (IS_META_AVAILABLE(CAM_INTF_META_CAPTURE_INTENT, metadata)) {
-         uint8_t captureIntent = (uint8_t)
-                 *((uint32_t*) POINTER_OF_META(CAM_INTF_META_CAPTURE_INTENT, metadata));
-         camMetadata.update(ANDROID_CONTROL_CAPTURE_INTENT, &captureIntent, 1);
-    }
-
-    if (IS_META_AVAILABLE(CAM_INTF_PARM_ANTIBANDING, metadata)) {
-        int hal_ab_mode = (int)
-                *((uint32_t *)POINTER_OF_META(CAM_INTF_PARM_ANTIBANDING, metadata));
-        int val = lookupFwkName(ANTIBANDING_MODES_MAP, METADATA_MAP_SIZE(ANTIBANDING_MODES_MAP),
-                hal_ab_mode);
-        if (val != NAME_NOT_FOUND) {
-            uint8_t fwk_ab_mode = (uint8_t)val;
-            camMetadata.update(ANDROID_CONTROL_AE_ANTIBANDING_MODE, &fwk_ab_mode, 1);
+            if (numFaces <= 0) {
+                memset(faceIds, 0, sizeof(int32_t) * MAX_ROI);
+                memset(faceScores, 0, sizeof(uint8_t) * MAX_ROI);
+                memset(faceRectangles, 0, sizeof(int32_t) * MAX_ROI * 4);
+                memset(faceLandmarks, 0, sizeof(int32_t) * MAX_ROI * 6);
+            }
+
+            camMetadata.update(ANDROID_STATISTICS_FACE_IDS, faceIds, numFaces);
+            camMetadata.update(ANDROID_STATISTICS_FACE_SCORES, faceScores, numFaces);
+            camMetadata.update(ANDROID_STATISTICS_FACE_RECTANGLES, faceRectangles, numFaces * 4U);
+            camMetadata.update(ANDROID_STATISTICS_FACE_LANDMARKS, faceLandmarks, numFaces * 6U);
+            break;
         }
-    }
-    if (IS_META_AVAILABLE(CAM_INTF_PARM_BESTSHOT_MODE, metadata)) {
-        int sceneMode = (int)
-                *((uint32_t *)POINTER_OF_META(CAM_INTF_PARM_BESTSHOT_MODE, metadata));
-        int val = lookupFwkName(SCENE_MODES_MAP, METADATA_MAP_SIZE(SCENE_MODES_MAP), sceneMode);
-        if (NAME_NOT_FOUND != val) {
-            uint8_t fwkSceneMode = (uint8_t)val;
-            camMetadata.update(ANDROID_CONTROL_SCENE_MODE, &fwkSceneMode, 1);
-            CDBG("%s: Metadata : ANDROID_CONTROL_SCENE_MODE", __func__);
-        } else {
-            CDBG_HIGH("%s: Metadata not found : ANDROID_CONTROL_SCENE_MODE", __func__);
+        case CAM_INTF_META_TONEMAP_MODE: {
+            uint8_t  *toneMapMode =
+               (uint8_t *)POINTER_OF_META(CAM_INTF_META_TONEMAP_MODE, metadata);
+            camMetadata.update(ANDROID_TONEMAP_MODE, toneMapMode, 1);
+            break;
+        }
+        case CAM_INTF_META_COLOR_CORRECT_MODE: {
+            uint8_t  *color_correct_mode =
+                (uint8_t *)POINTER_OF_META(CAM_INTF_META_COLOR_CORRECT_MODE, metadata);
+            camMetadata.update(ANDROID_COLOR_CORRECTION_MODE, color_correct_mode, 1);
+            break;
+        }
+        case CAM_INTF_META_EDGE_MODE: {
+            cam_edge_application_t  *edgeApplication =
+                (cam_edge_application_t *)POINTER_OF_META(CAM_INTF_META_EDGE_MODE, metadata);
+            uint8_t edgeStrength = (uint8_t)edgeApplication->sharpness;
+            camMetadata.update(ANDROID_EDGE_MODE, &(edgeApplication->edge_mode), 1);
+            camMetadata.update(ANDROID_EDGE_STRENGTH, &edgeStrength, 1);
+            break;
+        }
+        case CAM_INTF_META_FLASH_POWER: {
+            uint8_t  *flashPower =
+                (uint8_t *)POINTER_OF_META(CAM_INTF_META_FLASH_POWER, metadata);
+            camMetadata.update(ANDROID_FLASH_FIRING_POWER, flashPower, 1);
+            break;
+        }
+        case CAM_INTF_META_FLASH_FIRING_TIME: {
+            int64_t  *flashFiringTime =
+                (int64_t *)POINTER_OF_META(CAM_INTF_META_FLASH_FIRING_TIME, metadata);
+            camMetadata.update(ANDROID_FLASH_FIRING_TIME, flashFiringTime, 1);
+            break;
+        }
+        case CAM_INTF_META_FLASH_STATE: {
+            int32_t *flashState = (int32_t *)POINTER_OF_META(CAM_INTF_META_FLASH_STATE, metadata);
+            uint8_t val = (uint8_t)*flashState;
+            if (!gCamCapability[mCameraId]->flash_available) {
+                val = (uint8_t) ANDROID_FLASH_STATE_UNAVAILABLE;
+            }
+            camMetadata.update(ANDROID_FLASH_STATE, &val, 1);
+            break;
+        }
+        case CAM_INTF_META_FLASH_MODE: {
+            uint8_t *flashMode = (uint8_t*)
+                POINTER_OF_META(CAM_INTF_META_FLASH_MODE, metadata);
+            int val = lookupFwkName(FLASH_MODES_LOOKUP, *flashMode);
+            if (NAME_NOT_FOUND != val) {
+                uint8_t fwk_flashMode = (uint8_t)val;
+                camMetadata.update(ANDROID_FLASH_MODE, &fwk_flashMode, 1);
+            }
+            break;
+        }
+        case CAM_INTF_META_HOTPIXEL_MODE: {
+            uint8_t  *hotPixelMode =
+                (uint8_t *)POINTER_OF_META(CAM_INTF_META_HOTPIXEL_MODE, metadata);
+            camMetadata.update(ANDROID_HOT_PIXEL_MODE, hotPixelMode, 1);
+            break;
+        }
+        case CAM_INTF_META_LENS_APERTURE: {
+            float  *lensAperture =
+                (float *)POINTER_OF_META(CAM_INTF_META_LENS_APERTURE, metadata);
+            camMetadata.update(ANDROID_LENS_APERTURE , lensAperture, 1);
+            break;
+        }
+        case CAM_INTF_META_LENS_FILTERDENSITY: {
+            float  *filterDensity =
+                (float *)POINTER_OF_META(CAM_INTF_META_LENS_FILTERDENSITY, metadata);
+            camMetadata.update(ANDROID_LENS_FILTER_DENSITY , filterDensity, 1);
+            break;
+        }
+        case CAM_INTF_META_LENS_FOCAL_LENGTH: {
+            float  *focalLength =
+                (float *)POINTER_OF_META(CAM_INTF_META_LENS_FOCAL_LENGTH, metadata);
+            camMetadata.update(ANDROID_LENS_FOCAL_LENGTH, focalLength, 1);
+            break;
+        }
+        case CAM_INTF_META_LENS_FOCUS_DISTANCE: {
+            float  *focusDistance =
+                (float *)POINTER_OF_META(CAM_INTF_META_LENS_FOCUS_DISTANCE, metadata);
+            camMetadata.update(ANDROID_LENS_FOCUS_DISTANCE , focusDistance, 1);
+            break;
+        }
+        case CAM_INTF_META_LENS_FOCUS_RANGE: {
+            float  *focusRange =
+                (float *)POINTER_OF_META(CAM_INTF_META_LENS_FOCUS_RANGE, metadata);
+            camMetadata.update(ANDROID_LENS_FOCUS_RANGE , focusRange, 2);
+            break;
+        }
+        case CAM_INTF_META_LENS_STATE: {
+            cam_af_lens_state_t *lensState = (cam_af_lens_state_t *)
+                POINTER_OF_META(CAM_INTF_META_LENS_STATE, metadata);
+            int val = lookupFwkName(LENS_STATE_LOOKUP, *lensState);
+            if (NAME_NOT_FOUND != val) {
+                uint8_t fwk_lensState = (cam_af_lens_state_t)val;
+                camMetadata.update(ANDROID_LENS_STATE , &fwk_lensState, 1);
+            }
+            break;
+        }
+        case CAM_INTF_META_LENS_OPT_STAB_MODE: {
+            uint8_t  *opticalStab =
+                (uint8_t *)POINTER_OF_META(CAM_INTF_META_LENS_OPT_STAB_MODE, metadata);
+            camMetadata.update(ANDROID_LENS_OPTICAL_STABILIZATION_MODE ,opticalStab, 1);
+            break;
+        }
+        case CAM_INTF_META_NOISE_REDUCTION_MODE: {
+            uint8_t  *noiseRedMode =
+                (uint8_t *)POINTER_OF_META(CAM_INTF_META_NOISE_REDUCTION_MODE, metadata);
+            camMetadata.update(ANDROID_NOISE_REDUCTION_MODE , noiseRedMode, 1);
+            break;
+        }
+        case CAM_INTF_META_NOISE_REDUCTION_STRENGTH: {
+            uint8_t  *noiseRedStrength =
+                (uint8_t *)POINTER_OF_META(CAM_INTF_META_NOISE_REDUCTION_STRENGTH, metadata);
+            camMetadata.update(ANDROID_NOISE_REDUCTION_STRENGTH, noiseRedStrength, 1);
+            break;
+        }
+        case CAM_INTF_META_SCALER_CROP_REGION: {
+            cam_crop_region_t  *hScalerCropRegion =(cam_crop_region_t *)
+                POINTER_OF_META(CAM_INTF_META_SCALER_CROP_REGION, metadata);
+            int32_t scalerCropRegion[4];
+            scalerCropRegion[0] = hScalerCropRegion->left;
+            scalerCropRegion[1] = hScalerCropRegion->top;
+            scalerCropRegion[2] = hScalerCropRegion->width;
+            scalerCropRegion[3] = hScalerCropRegion->height;
+            camMetadata.update(ANDROID_SCALER_CROP_REGION, scalerCropRegion, 4);
+            break;
+        }
+        case CAM_INTF_META_SENSOR_EXPOSURE_TIME: {
+            int64_t  *sensorExpTime =
+                (int64_t *)POINTER_OF_META(CAM_INTF_META_SENSOR_EXPOSURE_TIME, metadata);
+            mMetadataResponse.exposure_time = *sensorExpTime;
+            CDBG("%s: sensorExpTime = %lld", __func__, *sensorExpTime);
+            camMetadata.update(ANDROID_SENSOR_EXPOSURE_TIME , sensorExpTime, 1);
+            break;
+        }
+        case CAM_INTF_META_SENSOR_FRAME_DURATION: {
+            int64_t  *sensorFameDuration =
+                (int64_t *)POINTER_OF_META(CAM_INTF_META_SENSOR_FRAME_DURATION, metadata);
+            CDBG("%s: sensorFameDuration = %lld", __func__, *sensorFameDuration);
+            camMetadata.update(ANDROID_SENSOR_FRAME_DURATION, sensorFameDuration, 1);
+            break;
+        }
+        case CAM_INTF_META_SENSOR_SENSITIVITY: {
+            int32_t  *sensorSensitivity =
+                (int32_t *)POINTER_OF_META(CAM_INTF_META_SENSOR_SENSITIVITY, metadata);
+            CDBG("%s: sensorSensitivity = %d", __func__, *sensorSensitivity);
+            mMetadataResponse.iso_speed = *sensorSensitivity;
+            camMetadata.update(ANDROID_SENSOR_SENSITIVITY, sensorSensitivity, 1);
+            break;
+        }
+        case CAM_INTF_META_SHADING_MODE: {
+            uint8_t *shadingMode = (uint8_t *)
+                    POINTER_OF_META(CAM_INTF_META_SHADING_MODE, metadata);
+            camMetadata.update(ANDROID_SHADING_MODE, shadingMode, 1);
+            break;
+        }
+        case CAM_INTF_META_STATS_FACEDETECT_MODE: {
+            uint8_t *faceDetectMode = (uint8_t *)
+                    POINTER_OF_META(CAM_INTF_META_STATS_FACEDETECT_MODE, metadata);
+            int val = lookupFwkName(FACEDETECT_MODES_LOOKUP, *faceDetectMode);
+            if (NAME_NOT_FOUND != val) {
+                uint8_t fwk_faceDetectMode = (uint8_t)val;
+                camMetadata.update(ANDROID_STATISTICS_FACE_DETECT_MODE, &fwk_faceDetectMode, 1);
+            }
+            break;
+        }
+        case CAM_INTF_META_STATS_HISTOGRAM_MODE: {
+            uint8_t  *histogramMode =
+               (uint8_t *)POINTER_OF_META(CAM_INTF_META_STATS_HISTOGRAM_MODE, metadata);
+            camMetadata.update(ANDROID_STATISTICS_HISTOGRAM_MODE, histogramMode, 1);
+            break;
+        }
+        case CAM_INTF_META_STATS_SHARPNESS_MAP_MODE: {
+            uint8_t  *sharpnessMapMode =
+               (uint8_t *)POINTER_OF_META(CAM_INTF_META_STATS_SHARPNESS_MAP_MODE, metadata);
+            camMetadata.update(ANDROID_STATISTICS_SHARPNESS_MAP_MODE,
+                               sharpnessMapMode, 1);
+            break;
+        }
+        case CAM_INTF_META_STATS_SHARPNESS_MAP: {
+            cam_sharpness_map_t  *sharpnessMap = (cam_sharpness_map_t *)
+            POINTER_OF_META(CAM_INTF_META_STATS_SHARPNESS_MAP, metadata);
+            camMetadata.update(ANDROID_STATISTICS_SHARPNESS_MAP,
+                               (int32_t*)sharpnessMap->sharpness,
+                               CAM_MAX_MAP_WIDTH*CAM_MAX_MAP_HEIGHT);
+            break;
+        }
+        case CAM_INTF_META_LENS_SHADING_MAP: {
+            cam_lens_shading_map_t *lensShadingMap = (cam_lens_shading_map_t *)
+                POINTER_OF_META(CAM_INTF_META_LENS_SHADING_MAP, metadata);
+            size_t map_height = (size_t)gCamCapability[mCameraId]->lens_shading_map_size.height;
+            size_t map_width = (size_t)gCamCapability[mCameraId]->lens_shading_map_size.width;
+            camMetadata.update(ANDROID_STATISTICS_LENS_SHADING_MAP,
+                    (float*)lensShadingMap->lens_shading, 4U * map_width * map_height);
+            break;
+        }
+        case CAM_INTF_META_TONEMAP_CURVES: {
+            //Populate CAM_INTF_META_TONEMAP_CURVES
+            /* ch0 = G, ch 1 = B, ch 2 = R*/
+            cam_rgb_tonemap_curves *tonemap = (cam_rgb_tonemap_curves *)
+            POINTER_OF_META(CAM_INTF_META_TONEMAP_CURVES, metadata);
+            camMetadata.update(ANDROID_TONEMAP_CURVE_GREEN,
+                            (float*)tonemap->curves[0].tonemap_points,
+                            tonemap->tonemap_points_cnt * 2);
+
+            camMetadata.update(ANDROID_TONEMAP_CURVE_BLUE,
+                            (float*)tonemap->curves[1].tonemap_points,
+                            tonemap->tonemap_points_cnt * 2);
+
+            camMetadata.update(ANDROID_TONEMAP_CURVE_RED,
+                            (float*)tonemap->curves[2].tonemap_points,
+                            tonemap->tonemap_points_cnt * 2);
+            break;
+        }
+        case CAM_INTF_META_COLOR_CORRECT_GAINS: {
+            cam_color_correct_gains_t *colorCorrectionGains = (cam_color_correct_gains_t*)
+                POINTER_OF_META(CAM_INTF_META_COLOR_CORRECT_GAINS, metadata);
+            camMetadata.update(ANDROID_COLOR_CORRECTION_GAINS, colorCorrectionGains->gains, 4);
+            break;
+        }
+        case CAM_INTF_META_COLOR_CORRECT_TRANSFORM: {
+            cam_color_correct_matrix_t *colorCorrectionMatrix = (cam_color_correct_matrix_t*)
+                    POINTER_OF_META(CAM_INTF_META_COLOR_CORRECT_TRANSFORM, metadata);
+            camMetadata.update(ANDROID_COLOR_CORRECTION_TRANSFORM,
+                (camera_metadata_rational_t*)(void *)colorCorrectionMatrix->transform_matrix, 9);
+            break;
+        }
+        case CAM_INTF_META_PRED_COLOR_CORRECT_GAINS: {
+            cam_color_correct_gains_t *predColorCorrectionGains = (cam_color_correct_gains_t*)
+                POINTER_OF_META(CAM_INTF_META_PRED_COLOR_CORRECT_GAINS, metadata);
+            camMetadata.update(ANDROID_STATISTICS_PREDICTED_COLOR_GAINS,
+                predColorCorrectionGains->gains, 4);
+            break;
+        }
+        case CAM_INTF_META_PRED_COLOR_CORRECT_TRANSFORM: {
+            cam_color_correct_matrix_t *predColorCorrectionMatrix = (cam_color_correct_matrix_t*)
+                POINTER_OF_META(CAM_INTF_META_PRED_COLOR_CORRECT_TRANSFORM, metadata);
+            camMetadata.update(ANDROID_STATISTICS_PREDICTED_COLOR_TRANSFORM,
+                (camera_metadata_rational_t*)(void *)predColorCorrectionMatrix->transform_matrix, 9);
+            break;
+        }
+        case CAM_INTF_META_BLACK_LEVEL_LOCK: {
+            uint8_t *blackLevelLock = (uint8_t*)
+                POINTER_OF_META(CAM_INTF_META_BLACK_LEVEL_LOCK, metadata);
+            camMetadata.update(ANDROID_BLACK_LEVEL_LOCK, blackLevelLock, 1);
+            break;
+        }
+        case CAM_INTF_META_SCENE_FLICKER: {
+            uint8_t *sceneFlicker = (uint8_t*)
+                POINTER_OF_META(CAM_INTF_META_SCENE_FLICKER, metadata);
+            camMetadata.update(ANDROID_STATISTICS_SCENE_FLICKER, sceneFlicker, 1);
+            break;
+        }
+        case CAM_INTF_PARM_EFFECT: {
+            uint8_t *effectMode = (uint8_t*)
+                POINTER_OF_META(CAM_INTF_PARM_EFFECT, metadata);
+            int val = lookupFwkName(EFFECT_MODES_LOOKUP, *effectMode);
+            if (val != NAME_NOT_FOUND) {
+                uint8_t fwk_effectMode = (uint8_t)val;
+                camMetadata.update(ANDROID_CONTROL_EFFECT_MODE, &fwk_effectMode, 1);
+            }
+            break;
+        }
+        // CDS
+        case CAM_INTF_PARM_CDS_MODE: {
+            cam_cds_mode_type_t *cds = (cam_cds_mode_type_t *)
+                    POINTER_OF_META(CAM_INTF_PARM_CDS_MODE, metadata);
+            int32_t mode = *cds;
+            camMetadata.update(QCAMERA_CDS_MODE,
+                    &mode, 1);
+            break;
+        }
+        case CAM_INTF_META_LENS_SHADING_MAP_MODE: {
+            uint8_t shadingMapMode = (uint8_t)
+                    *((uint32_t *)POINTER_OF_META(CAM_INTF_META_LENS_SHADING_MAP_MODE, metadata));
+            camMetadata.update(ANDROID_STATISTICS_LENS_SHADING_MAP_MODE, &shadingMapMode, 1);
+            break;
+        }
+        case CAM_INTF_META_AEC_ROI: {
+            cam_area_t  *hAeRegions =
+                (cam_area_t *)POINTER_OF_META(CAM_INTF_META_AEC_ROI, metadata);
+            int32_t aeRegions[5];
+            convertToRegions(hAeRegions->rect, aeRegions, hAeRegions->weight);
+            camMetadata.update(ANDROID_CONTROL_AE_REGIONS, aeRegions, 5);
+            CDBG("%s: Metadata : ANDROID_CONTROL_AE_REGIONS: FWK: [%d,%d,%d,%d] HAL: [%d,%d,%d,%d]",
+                    __func__, aeRegions[0], aeRegions[1], aeRegions[2], aeRegions[3],
+                    hAeRegions->rect.left, hAeRegions->rect.top, hAeRegions->rect.width,
+                    hAeRegions->rect.height);
+            break;
+        }
+        case CAM_INTF_META_AF_ROI: {
+            /*af regions*/
+            cam_area_t  *hAfRegions =
+                (cam_area_t *)POINTER_OF_META(CAM_INTF_META_AF_ROI, metadata);
+            int32_t afRegions[5];
+            convertToRegions(hAfRegions->rect, afRegions, hAfRegions->weight);
+            camMetadata.update(ANDROID_CONTROL_AF_REGIONS, afRegions, 5);
+            CDBG("%s: Metadata : ANDROID_CONTROL_AF_REGIONS: FWK: [%d,%d,%d,%d] HAL: [%d,%d,%d,%d]",
+                    __func__, afRegions[0], afRegions[1], afRegions[2], afRegions[3],
+                    hAfRegions->rect.left, hAfRegions->rect.top, hAfRegions->rect.width,
+                    hAfRegions->rect.height);
+            break;
+        }
+        case CAM_INTF_META_CAPTURE_INTENT: {
+            uint8_t captureIntent = (uint8_t)
+                    *((uint32_t*) POINTER_OF_META(CAM_INTF_META_CAPTURE_INTENT, metadata));
+            camMetadata.update(ANDROID_CONTROL_CAPTURE_INTENT, &captureIntent, 1);
+            break;
+        }
+        case CAM_INTF_PARM_ANTIBANDING: {
+            int hal_ab_mode = (int)
+                    *((uint32_t *)POINTER_OF_META(CAM_INTF_PARM_ANTIBANDING, metadata));
+            int val = lookupFwkName(ANTIBANDING_MODES_LOOKUP, hal_ab_mode);
+            if (val != NAME_NOT_FOUND) {
+                uint8_t fwk_ab_mode = (uint8_t)val;
+                camMetadata.update(ANDROID_CONTROL_AE_ANTIBANDING_MODE, &fwk_ab_mode, 1);
+            }
+            break;
+        }
+        case CAM_INTF_PARM_BESTSHOT_MODE: {
+            int sceneMode = (int)
+                    *((uint32_t *)POINTER_OF_META(CAM_INTF_PARM_BESTSHOT_MODE, metadata));
+            int val = lookupFwkName(SCENE_MODES_LOOKUP, sceneMode);
+            if (NAME_NOT_FOUND != val) {
+                uint8_t fwkSceneMode = (uint8_t)val;
+                camMetadata.update(ANDROID_CONTROL_SCENE_MODE, &fwkSceneMode, 1);
+                CDBG("%s: Metadata : ANDROID_CONTROL_SCENE_MODE", __func__);
+            } else {
+                CDBG_HIGH("%s: Metadata not found : ANDROID_CONTROL_SCENE_MODE", __func__);
+            }
+            break;
+        }
+        case CAM_INTF_META_MODE: {
+            uint8_t mode = (uint8_t) *((uint32_t *)POINTER_OF_META(CAM_INTF_META_MODE, metadata));
+            camMetadata.update(ANDROID_CONTROL_MODE, &mode, 1);
+            break;
+        }
+        default:
+            break;
         }
-    }
-    if (IS_META_AVAILABLE(CAM_INTF_META_MODE, metadata)) {
-         uint8_t mode = (uint8_t) *((uint32_t *)POINTER_OF_META(CAM_INTF_META_MODE, metadata));
-         camMetadata.update(ANDROID_CONTROL_MODE, &mode, 1);
     }
 
     /* Constant metadata values to be update*/
@@ -2606,113 +2861,141 @@ QCamera3HardwareInterface::translateCbUrgentMetadataToResultMetadata
     uint8_t partial_result_tag = ANDROID_QUIRKS_PARTIAL_RESULT_PARTIAL;
     camMetadata.update(ANDROID_QUIRKS_PARTIAL_RESULT, &partial_result_tag, 1);
 
-    if (IS_META_AVAILABLE(CAM_INTF_META_AEC_PRECAPTURE_TRIGGER, metadata)) {
-        cam_trigger_t *aecTrigger =
-                (cam_trigger_t *)POINTER_OF_META(CAM_INTF_META_AEC_PRECAPTURE_TRIGGER, metadata);
-        camMetadata.update(ANDROID_CONTROL_AE_PRECAPTURE_ID,
-                &aecTrigger->trigger_id, 1);
-        CDBG("%s: urgent Metadata : ANDROID_CONTROL_AE_PRECAPTURE_ID", __func__);
-    }
-    if (IS_META_AVAILABLE(CAM_INTF_META_AEC_STATE, metadata)) {
-        uint8_t *ae_state = (uint8_t *)
-            POINTER_OF_META(CAM_INTF_META_AEC_STATE, metadata);
-        camMetadata.update(ANDROID_CONTROL_AE_STATE, ae_state, 1);
-        CDBG("%s: urgent Metadata : ANDROID_CONTROL_AE_STATE", __func__);
-    }
-    if (IS_META_AVAILABLE(CAM_INTF_PARM_FOCUS_MODE, metadata)) {
-        uint8_t  *focusMode = (uint8_t *)
-            POINTER_OF_META(CAM_INTF_PARM_FOCUS_MODE, metadata);
-        int val = lookupFwkName(FOCUS_MODES_MAP, METADATA_MAP_SIZE(FOCUS_MODES_MAP), *focusMode);
-        if (NAME_NOT_FOUND != val) {
-            uint8_t fwkAfMode = (uint8_t)val;
-            camMetadata.update(ANDROID_CONTROL_AF_MODE, &fwkAfMode, 1);
-            CDBG("%s: urgent Metadata : ANDROID_CONTROL_AF_MODE", __func__);
-        } else {
-            CDBG_HIGH("%s: urgent Metadata not found : ANDROID_CONTROL_AF_MODE", __func__);
-        }
-    }
-    if (IS_META_AVAILABLE(CAM_INTF_META_AF_STATE, metadata)) {
-        uint8_t  *afState = (uint8_t *)
-            POINTER_OF_META(CAM_INTF_META_AF_STATE, metadata);
-        camMetadata.update(ANDROID_CONTROL_AF_STATE, afState, 1);
-        CDBG("%s: urgent Metadata : ANDROID_CONTROL_AF_STATE", __func__);
-    }
-    if (IS_META_AVAILABLE(CAM_INTF_META_AF_TRIGGER, metadata)) {
-        cam_trigger_t *af_trigger =
-                (cam_trigger_t *)POINTER_OF_META(CAM_INTF_META_AF_TRIGGER, metadata);
-        camMetadata.update(ANDROID_CONTROL_AF_TRIGGER_ID, &af_trigger->trigger_id, 1);
-        CDBG("%s: urgent Metadata : ANDROID_CONTROL_AF_TRIGGER_ID", __func__);
-    }
-    if (IS_META_AVAILABLE(CAM_INTF_PARM_WHITE_BALANCE, metadata)) {
-        int32_t  *whiteBalance = (int32_t *)
-            POINTER_OF_META(CAM_INTF_PARM_WHITE_BALANCE, metadata);
-        int val = lookupFwkName(WHITE_BALANCE_MODES_MAP,
-                METADATA_MAP_SIZE(WHITE_BALANCE_MODES_MAP), *whiteBalance);
-        if (NAME_NOT_FOUND != val) {
-            uint8_t fwkWhiteBalanceMode = (uint8_t)val;
-            camMetadata.update(ANDROID_CONTROL_AWB_MODE, &fwkWhiteBalanceMode, 1);
-            CDBG("%s: urgent Metadata : ANDROID_CONTROL_AWB_MODE", __func__);
-        } else {
-            CDBG_HIGH("%s: urgent Metadata not found : ANDROID_CONTROL_AWB_MODE", __func__);
-        }
-    }
-    if (IS_META_AVAILABLE(CAM_INTF_META_AWB_REGIONS, metadata)) {
-        /*awb regions*/
-        cam_area_t  *hAwbRegions = (cam_area_t *)
-            POINTER_OF_META(CAM_INTF_META_AWB_REGIONS, metadata);
-        int32_t awbRegions[5];
-        convertToRegions(hAwbRegions->rect, awbRegions,hAwbRegions->weight);
-        camMetadata.update(ANDROID_CONTROL_AWB_REGIONS, awbRegions, 5);
-        CDBG("%s: urgent Metadata : ANDROID_CONTROL_AWB_REGIONS", __func__);
-    }
-    if (IS_META_AVAILABLE(CAM_INTF_META_AWB_STATE, metadata)) {
-        uint8_t  *whiteBalanceState = (uint8_t *)
-            POINTER_OF_META(CAM_INTF_META_AWB_STATE, metadata);
-        camMetadata.update(ANDROID_CONTROL_AWB_STATE, whiteBalanceState, 1);
-        CDBG("%s: urgent Metadata : ANDROID_CONTROL_AWB_STATE", __func__);
-    }
-    if (IS_META_AVAILABLE(CAM_INTF_PARM_EXPOSURE_COMPENSATION, metadata)) {
-        int32_t  *expCompensation =
-          (int32_t *)POINTER_OF_META(CAM_INTF_PARM_EXPOSURE_COMPENSATION, metadata);
-        camMetadata.update(ANDROID_CONTROL_AE_EXPOSURE_COMPENSATION,
-                                      expCompensation, 1);
-        CDBG("%s: urgent Metadata : ANDROID_CONTROL_AE_EXPOSURE_COMPENSATION",
-            __func__);
-    }
-    if (IS_META_AVAILABLE(CAM_INTF_PARM_AEC_LOCK, metadata)) {
-        uint8_t ae_lock = (uint8_t)
-                *((uint32_t *)POINTER_OF_META(CAM_INTF_PARM_AEC_LOCK, metadata));
-        camMetadata.update(ANDROID_CONTROL_AE_LOCK,
-                &ae_lock, 1);
-        CDBG("%s: urgent Metadata : ANDROID_CONTROL_AE_LOCK", __func__);
-    }
-    if (IS_META_AVAILABLE(CAM_INTF_PARM_AWB_LOCK, metadata)) {
-        uint8_t awb_lock = (uint8_t)
-                *((uint32_t *)POINTER_OF_META(CAM_INTF_PARM_AWB_LOCK, metadata));
-        camMetadata.update(ANDROID_CONTROL_AWB_LOCK, &awb_lock, 1);
-        CDBG("%s: urgent Metadata : ANDROID_CONTROL_AWB_LOCK", __func__);
-    }
-    if (IS_META_AVAILABLE(CAM_INTF_PARM_FPS_RANGE, metadata)) {
-        int32_t fps_range[2];
-        cam_fps_range_t * float_range =
-          (cam_fps_range_t *)POINTER_OF_PARAM(CAM_INTF_PARM_FPS_RANGE, metadata);
-        fps_range[0] = (int32_t)float_range->min_fps;
-        fps_range[1] = (int32_t)float_range->max_fps;
-        camMetadata.update(ANDROID_CONTROL_AE_TARGET_FPS_RANGE,
-                                      fps_range, 2);
-        CDBG("%s: urgent Metadata : ANDROID_CONTROL_AE_TARGET_FPS_RANGE [%d, %d]",
-            __func__, fps_range[0], fps_range[1]);
-    }
-    if (IS_META_AVAILABLE(CAM_INTF_META_AEC_MODE, metadata)) {
-        aeMode = (uint8_t) *((uint32_t*) POINTER_OF_META(CAM_INTF_META_AEC_MODE, metadata));
-    }
-    if (IS_META_AVAILABLE(CAM_INTF_PARM_LED_MODE, metadata)) {
-        flashMode = (int32_t*)
-                POINTER_OF_PARAM(CAM_INTF_PARM_LED_MODE, metadata);
-    }
-    if (IS_META_AVAILABLE(CAM_INTF_PARM_REDEYE_REDUCTION, metadata)) {
-        redeye = (int32_t*)
-                POINTER_OF_PARAM(CAM_INTF_PARM_REDEYE_REDUCTION, metadata);
+    cam_intf_valid_map_t validMap;
+    cam_intf_valid_iter_t validIter;
+    cam_intf_parm_type_t metaId;
+
+    /* Visit only the entries present in this frame */
+    cam_intf_build_valid_map(metadata, &validMap);
+    cam_intf_valid_iter_init(&validIter, &validMap);
+    while (cam_intf_valid_iter_next(&validIter, &metaId)) {
+        switch (metaId) {
+        case CAM_INTF_META_AEC_PRECAPTURE_TRIGGER: {
+            cam_trigger_t *aecTrigger =
+                    (cam_trigger_t *)POINTER_OF_META(CAM_INTF_META_AEC_PRECAPTURE_TRIGGER, metadata);
+            camMetadata.update(ANDROID_CONTROL_AE_PRECAPTURE_ID,
+                    &aecTrigger->trigger_id, 1);
+            CDBG("%s: urgent Metadata : ANDROID_CONTROL_AE_PRECAPTURE_ID", __func__);
+            break;
+        }
+        case CAM_INTF_META_AEC_STATE: {
+            uint8_t *ae_state = (uint8_t *)
+                POINTER_OF_META(CAM_INTF_META_AEC_STATE, metadata);
+            camMetadata.update(ANDROID_CONTROL_AE_STATE, ae_state, 1);
+            CDBG("%s: urgent Metadata : ANDROID_CONTROL_AE_STATE", __func__);
+            break;
+        }
+        case CAM_INTF_PARM_FOCUS_MODE: {
+            uint8_t  *focusMode = (uint8_t *)
+                POINTER_OF_META(CAM_INTF_PARM_FOCUS_MODE, metadata);
+            int val = lookupFwkName(FOCUS_MODES_LOOKUP, *focusMode);
+            if (NAME_NOT_FOUND != val) {
+                uint8_t fwkAfMode = (uint8_t)val;
+                camMetadata.update(ANDROID_CONTROL_AF_MODE, &fwkAfMode, 1);
+                CDBG("%s: urgent Metadata : ANDROID_CONTROL_AF_MODE", __func__);
+            } else {
+                CDBG_HIGH("%s: urgent Metadata not found : ANDROID_CONTROL_AF_MODE", __func__);
+            }
+            break;
+        }
+        case CAM_INTF_META_AF_STATE: {
+            uint8_t  *afState = (uint8_t *)
+                POINTER_OF_META(CAM_INTF_META_AF_STATE, metadata);
+            camMetadata.update(ANDROID_CONTROL_AF_STATE, afState, 1);
+            CDBG("%s: urgent Metadata : ANDROID_CONTROL_AF_STATE", __func__);
+            break;
+        }
+        case CAM_INTF_META_AF_TRIGGER: {
+            cam_trigger_t *af_trigger =
+                    (cam_trigger_t *)POINTER_OF_META(CAM_INTF_META_AF_TRIGGER, metadata);
+            camMetadata.update(ANDROID_CONTROL_AF_TRIGGER_ID, &af_trigger->trigger_id, 1);
+            CDBG("%s: urgent Metadata : ANDROID_CONTROL_AF_TRIGGER_ID", __func__);
+            break;
+        }
+        case CAM_INTF_PARM_WHITE_BALANCE: {
+            int32_t  *whiteBalance = (int32_t *)
+                POINTER_OF_META(CAM_INTF_PARM_WHITE_BALANCE, metadata);
+            int val = lookupFwkName(WHITE_BALANCE_MODES_LOOKUP,
+                    *whiteBalance);
+            if (NAME_NOT_FOUND != val) {
+                uint8_t fwkWhiteBalanceMode = (uint8_t)val;
+                camMetadata.update(ANDROID_CONTROL_AWB_MODE, &fwkWhiteBalanceMode, 1);
+                CDBG("%s: urgent Metadata : ANDROID_CONTROL_AWB_MODE", __func__);
+            } else {
+                CDBG_HIGH("%s: urgent Metadata not found : ANDROID_CONTROL_AWB_MODE", __func__);
+            }
+            break;
+        }
+        case CAM_INTF_META_AWB_REGIONS: {
+            /*awb regions*/
+            cam_area_t  *hAwbRegions = (cam_area_t *)
+                POINTER_OF_META(CAM_INTF_META_AWB_REGIONS, metadata);
+            int32_t awbRegions[5];
+            convertToRegions(hAwbRegions->rect, awbRegions,hAwbRegions->weight);
+            camMetadata.update(ANDROID_CONTROL_AWB_REGIONS, awbRegions, 5);
+            CDBG("%s: urgent Metadata : ANDROID_CONTROL_AWB_REGIONS", __func__);
+            break;
+        }
+        case CAM_INTF_META_AWB_STATE: {
+            uint8_t  *whiteBalanceState = (uint8_t *)
+                POINTER_OF_META(CAM_INTF_META_AWB_STATE, metadata);
+            camMetadata.update(ANDROID_CONTROL_AWB_STATE, whiteBalanceState, 1);
+            CDBG("%s: urgent Metadata : ANDROID_CONTROL_AWB_STATE", __func__);
+            break;
+        }
+        case CAM_INTF_PARM_EXPOSURE_COMPENSATION: {
+            int32_t  *expCompensation =
+              (int32_t *)POINTER_OF_META(CAM_INTF_PARM_EXPOSURE_COMPENSATION, metadata);
+            camMetadata.update(ANDROID_CONTROL_AE_EXPOSURE_COMPENSATION,
+                                          expCompensation, 1);
+            CDBG("%s: urgent Metadata : ANDROID_CONTROL_AE_EXPOSURE_COMPENSATION",
+                __func__);
+            break;
+        }
+        case CAM_INTF_PARM_AEC_LOCK: {
+            uint8_t ae_lock = (uint8_t)
+                    *((uint32_t *)POINTER_OF_META(CAM_INTF_PARM_AEC_LOCK, metadata));
+            camMetadata.update(ANDROID_CONTROL_AE_LOCK,
+                    &ae_lock, 1);
+            CDBG("%s: urgent Metadata : ANDROID_CONTROL_AE_LOCK", __func__);
+            break;
+        }
+        case CAM_INTF_PARM_AWB_LOCK: {
+            uint8_t awb_lock = (uint8_t)
+                    *((uint32_t *)POINTER_OF_META(CAM_INTF_PARM_AWB_LOCK, metadata));
+            camMetadata.update(ANDROID_CONTROL_AWB_LOCK, &awb_lock, 1);
+            CDBG("%s: urgent Metadata : ANDROID_CONTROL_AWB_LOCK", __func__);
+            break;
+        }
+        case CAM_INTF_PARM_FPS_RANGE: {
+            int32_t fps_range[2];
+            cam_fps_range_t * float_range =
+              (cam_fps_range_t *)POINTER_OF_PARAM(CAM_INTF_PARM_FPS_RANGE, metadata);
+            fps_range[0] = (int32_t)float_range->min_fps;
+            fps_range[1] = (int32_t)float_range->max_fps;
+            camMetadata.update(ANDROID_CONTROL_AE_TARGET_FPS_RANGE,
+                                          fps_range, 2);
+            CDBG("%s: urgent Metadata : ANDROID_CONTROL_AE_TARGET_FPS_RANGE [%d, %d]",
+                __func__, fps_range[0], fps_range[1]);
+            break;
+        }
+        case CAM_INTF_META_AEC_MODE: {
+            aeMode = (uint8_t) *((uint32_t*) POINTER_OF_META(CAM_INTF_META_AEC_MODE, metadata));
+            break;
+        }
+        case CAM_INTF_PARM_LED_MODE: {
+            flashMode = (int32_t*)
+                    POINTER_OF_PARAM(CAM_INTF_PARM_LED_MODE, metadata);
+            break;
+        }
+        case CAM_INTF_PARM_REDEYE_REDUCTION: {
+            redeye = (int32_t*)
+                    POINTER_OF_PARAM(CAM_INTF_PARM_REDEYE_REDUCTION, metadata);
+            break;
+        }
+        default:
+            break;
+        }
     }
 
     uint8_t fwk_aeMode;
@@ -2722,8 +3005,7 @@ QCamera3HardwareInterface::translateCbUrgentMetadataToResultMetadata
     } else if (flashMode != NULL &&
             ((*flashMode == CAM_FLASH_MODE_AUTO)||
              (*flashMode == CAM_FLASH_MODE_ON))) {
-        int val = lookupFwkName(AE_FLASH_MODE_MAP, METADATA_MAP_SIZE(AE_FLASH_MODE_MAP),
-                *flashMode);
+        int val = lookupFwkName(AE_FLASH_MODE_LOOKUP, *flashMode);
         if (NAME_NOT_FOUND != val) {
             fwk_aeMode = (uint8_t)val;
             camMetadata.update(ANDROID_CONTROL_AE_MODE, &fwk_aeMode, 1);
@@ -2876,6 +3158,25 @@ int QCamera3HardwareInterface::initCapabilities(uint32_t cameraId)
     int rc = 0;
     mm_camera_vtbl_t *cameraHandle = NULL;
     QCamera3HeapMemory *capabilityHeap = NULL;
+    struct camera_info *info = get_cam_info(cameraId);
+
+    /* Capability cached by an earlier boot saves opening the camera */
+    {
+        QCameraCapsCache capsCache(cameraId, get_cam_sensor_name(cameraId),
+                info->facing, info->orientation);
+        cam_capability_t *caps =
+                (cam_capability_t *)malloc(sizeof(cam_capability_t));
+        if (caps != NULL) {
+            if (capsCache.load(QCAMERA_CACHE_HAL3_CAPABILITY, caps,
+                    sizeof(cam_capability_t)) == NO_ERROR) {
+                CDBG_HIGH("%s: camera %d capability from cache",
+                        __func__, cameraId);
+                gCamCapability[cameraId] = caps;
+                return 0;
+            }
+            free(caps);
+        }
+    }
 
     cameraHandle = camera_open((uint8_t)cameraId);
     if (!cameraHandle) {
@@ -2920,6 +3221,14 @@ int QCamera3HardwareInterface::initCapabilities(uint32_t cameraId)
     }
     memcpy(gCamCapability[cameraId], DATA_PTR(capabilityHeap,0),
                                         sizeof(cam_capability_t));
+    {
+        /* Blobs built from an older capability are stale now */
+        QCameraCapsCache capsCache(cameraId, get_cam_sensor_name(cameraId),
+                info->facing, info->orientation);
+        capsCache.invalidate();
+        capsCache.store(QCAMERA_CACHE_HAL3_CAPABILITY,
+                gCamCapability[cameraId], sizeof(cam_capability_t));
+    }
     rc = 0;
 
 query_failed:
@@ -2977,6 +3286,8 @@ int QCamera3HardwareInterface::initParameters()
     }
 
     mParameters = (parm_buffer_t*) DATA_PTR(mParamHeap,0);
+    /* new buffer, first batch has to clear it completely */
+    memset(&mParmDirty, 0, sizeof(mParmDirty));
     return rc;
 }
 
@@ -3071,6 +3382,24 @@ int QCamera3HardwareInterface::initStaticMetadata(uint32_t cameraId)
 {
     int rc = 0;
     CameraMetadata staticInfo;
+    struct camera_info *info = get_cam_info(cameraId);
+    QCameraCapsCache capsCache(cameraId, get_cam_sensor_name(cameraId),
+            info->facing, info->orientation);
+    size_t cachedSize = 0;
+    const camera_metadata_t *cached = (const camera_metadata_t *)
+            capsCache.map(QCAMERA_CACHE_HAL3_STATIC_META, &cachedSize);
+
+    /* The cached blob stays mapped for the life of the process, like the
+     * metadata built below is never freed */
+    if (cached != NULL) {
+        if (get_camera_metadata_size(cached) == cachedSize) {
+            CDBG_HIGH("%s: camera %d static metadata from cache",
+                    __func__, cameraId);
+            gStaticMetadata[cameraId] = cached;
+            return rc;
+        }
+        QCameraCapsCache::unmap(cached, cachedSize);
+    }
 
     /* android.info: hardware level */
     uint8_t supportedHardwareLevel = ANDROID_INFO_SUPPORTED_HARDWARE_LEVEL_FULL;
@@ -3283,7 +3612,7 @@ int QCamera3HardwareInterface::initStaticMetadata(uint32_t cameraId)
     uint8_t avail_effects[CAM_EFFECT_MODE_MAX];
     size_t size = 0;
     for (size_t i = 0; i < gCamCapability[cameraId]->supported_effects_cnt; i++) {
-        int val = lookupFwkName(EFFECT_MODES_MAP, METADATA_MAP_SIZE(EFFECT_MODES_MAP),
+        int val = lookupFwkName(EFFECT_MODES_LOOKUP,
                 gCamCapability[cameraId]->supported_effects[i]);
         if (val != NAME_NOT_FOUND) {
             avail_effects[size] = (uint8_t)val;
@@ -3298,7 +3627,7 @@ int QCamera3HardwareInterface::initStaticMetadata(uint32_t cameraId)
     uint8_t supported_indexes[CAM_SCENE_MODE_MAX];
     size_t supported_scene_modes_cnt = 0;
     for (size_t i = 0; i < gCamCapability[cameraId]->supported_scene_modes_cnt; i++) {
-        int val = lookupFwkName(SCENE_MODES_MAP, METADATA_MAP_SIZE(SCENE_MODES_MAP),
+        int val = lookupFwkName(SCENE_MODES_LOOKUP,
                 gCamCapability[cameraId]->supported_scene_modes[i]);
         if (val != NAME_NOT_FOUND) {
             avail_scene_modes[supported_scene_modes_cnt] = (uint8_t)val;
@@ -3324,7 +3653,7 @@ int QCamera3HardwareInterface::initStaticMetadata(uint32_t cameraId)
     uint8_t avail_antibanding_modes[CAM_ANTIBANDING_MODE_MAX];
     size = 0;
     for (size_t i = 0; i < gCamCapability[cameraId]->supported_antibandings_cnt; i++) {
-        int val = lookupFwkName(ANTIBANDING_MODES_MAP, METADATA_MAP_SIZE(ANTIBANDING_MODES_MAP),
+        int val = lookupFwkName(ANTIBANDING_MODES_LOOKUP,
                 gCamCapability[cameraId]->supported_antibandings[i]);
         if (val != NAME_NOT_FOUND) {
             avail_antibanding_modes[size] = (uint8_t)val;
@@ -3339,7 +3668,7 @@ int QCamera3HardwareInterface::initStaticMetadata(uint32_t cameraId)
     uint8_t avail_af_modes[CAM_FOCUS_MODE_MAX];
     size = 0;
     for (size_t i = 0; i < gCamCapability[cameraId]->supported_focus_modes_cnt; i++) {
-        int val = lookupFwkName(FOCUS_MODES_MAP, METADATA_MAP_SIZE(FOCUS_MODES_MAP),
+        int val = lookupFwkName(FOCUS_MODES_LOOKUP,
                 gCamCapability[cameraId]->supported_focus_modes[i]);
         if (val != NAME_NOT_FOUND) {
             avail_af_modes[size] = (uint8_t)val;
@@ -3353,8 +3682,7 @@ int QCamera3HardwareInterface::initStaticMetadata(uint32_t cameraId)
     uint8_t avail_awb_modes[CAM_WB_MODE_MAX];
     size = 0;
     for (size_t i = 0; i < gCamCapability[cameraId]->supported_white_balances_cnt; i++) {
-        int val = lookupFwkName(WHITE_BALANCE_MODES_MAP,
-                METADATA_MAP_SIZE(WHITE_BALANCE_MODES_MAP),
+        int val = lookupFwkName(WHITE_BALANCE_MODES_LOOKUP,
                 gCamCapability[cameraId]->supported_white_balances[i]);
         if (val != NAME_NOT_FOUND) {
             avail_awb_modes[size] = (uint8_t)val;
@@ -3422,8 +3750,7 @@ int QCamera3HardwareInterface::initStaticMetadata(uint32_t cameraId)
     staticInfo.update(ANDROID_LED_AVAILABLE_LEDS,
                       &avail_leds, 0);
 
-    int val = lookupFwkName(REFERENCE_ILLUMINANT_MAP,
-                METADATA_MAP_SIZE(REFERENCE_ILLUMINANT_MAP),
+    int val = lookupFwkName(REFERENCE_ILLUMINANT_LOOKUP,
                 gCamCapability[cameraId]->reference_illuminant1);
     if (val != NAME_NOT_FOUND) {
         uint8_t fwkReferenceIlluminant = (uint8_t)val;
@@ -3431,8 +3758,7 @@ int QCamera3HardwareInterface::initStaticMetadata(uint32_t cameraId)
                 &fwkReferenceIlluminant, 1);
     }
 
-    val = lookupFwkName(REFERENCE_ILLUMINANT_MAP,
-                METADATA_MAP_SIZE(REFERENCE_ILLUMINANT_MAP),
+    val = lookupFwkName(REFERENCE_ILLUMINANT_LOOKUP,
                 gCamCapability[cameraId]->reference_illuminant2);
     if (val != NAME_NOT_FOUND) {
         uint8_t fwkReferenceIlluminant = (uint8_t)val;
@@ -3465,6 +3791,8 @@ int QCamera3HardwareInterface::initStaticMetadata(uint32_t cameraId)
                 (void *)gCamCapability[cameraId]->calibration_transform2, 9);
 
     gStaticMetadata[cameraId] = staticInfo.release();
+    capsCache.store(QCAMERA_CACHE_HAL3_STATIC_META, gStaticMetadata[cameraId],
+            get_camera_metadata_size(gStaticMetadata[cameraId]));
     return rc;
 }
 
@@ -3538,8 +3866,7 @@ void QCamera3HardwareInterface::makeOverridesList(
         size_t index = supported_indexes[i];
         overridesList[j] = gCamCapability[camera_id]->flash_available ?
                 ANDROID_CONTROL_AE_MODE_ON_AUTO_FLASH : ANDROID_CONTROL_AE_MODE_ON;
-        int val = lookupFwkName(WHITE_BALANCE_MODES_MAP,
-                METADATA_MAP_SIZE(WHITE_BALANCE_MODES_MAP),
+        int val = lookupFwkName(WHITE_BALANCE_MODES_LOOKUP,
                 overridesTable[index].awb_mode);
         if (NAME_NOT_FOUND != val) {
             overridesList[j+1] = (uint8_t)val;
@@ -3552,8 +3879,7 @@ void QCamera3HardwareInterface::makeOverridesList(
            }
         }
         if (supt) {
-            val = lookupFwkName(FOCUS_MODES_MAP, METADATA_MAP_SIZE(FOCUS_MODES_MAP),
-                    focus_override);
+            val = lookupFwkName(FOCUS_MODES_LOOKUP, focus_override);
             if (NAME_NOT_FOUND != val) {
                 overridesList[j+2] = (uint8_t)val;
             }
@@ -3690,7 +4016,6 @@ int32_t QCamera3HardwareInterface::AddSetParmEntryToBatch(
         parm_buffer_t *p_table, cam_intf_parm_type_t paramType, size_t paramLength,
         void *paramValue)
 {
-    void* dst;
     if ((NULL == p_table) || (NULL == paramValue) ||
         (paramType >= CAM_INTF_PARM_MAX)) {
         ALOGE("%s: Invalid p_table: %p, paramValue: %p, param type: %d",
@@ -3698,17 +4023,14 @@ int32_t QCamera3HardwareInterface::AddSetParmEntryToBatch(
         return BAD_VALUE;
     }
     /*************************************************************************
-    *                   Copy contents into entry                             *
+    *           Copy contents into entry and track it as dirty               *
     *************************************************************************/
-    if (paramLength > get_size_of(paramType)) {
+    if (cam_parm_batch_add(p_table,
+            (p_table == mParameters) ? &mParmDirty : NULL,
+            paramType, (uint32_t)paramLength, paramValue) < 0) {
         ALOGE("%s:Size of input larger than max entry size",__func__);
         return BAD_VALUE;
     }
-    dst = get_pointer_of(paramType, p_table);
-    if(NULL != dst){
-        memcpy(dst, paramValue, paramLength);
-        p_table->is_valid[paramType] = 1;
-    }
     return NO_ERROR;
 }
 
@@ -3719,28 +4041,24 @@ int32_t QCamera3HardwareInterface::AddSetParmEntryToBatch(
  *              make sure the parameter is correctly propogated
  *
  * PARAMETERS  :
- *   @arr      : map between the two enums
- *   @len      : len of the map
+ *   @map      : indexed map between the two enums
  *   @hal_name : name of the hal_parm to map
  *
  * RETURN     : int type of status
  *              fwk_name  -- success
  *              none-zero failure code
  *==========================================================================*/
-int QCamera3HardwareInterface::lookupFwkName(const QCameraMap arr[],
-        size_t len, int hal_name)
+int QCamera3HardwareInterface::lookupFwkName(
+        const QCameraEnumLookup<QCameraMap> &map, int hal_name)
 {
-
-    for (size_t i = 0; i < len; i++) {
-        if (arr[i].hal_name == hal_name)
-            return arr[i].fwk_name;
-    }
-
-    /* Not able to find matching framework type is not necessarily
-     * an error case. This happens when mm-camera supports more attributes
-     * than the frameworks do */
-    CDBG_HIGH("%s: Cannot find matching framework type", __func__);
-    return NAME_NOT_FOUND;
+    int fwk_name = map.toFwk(hal_name);
+    if (fwk_name == NAME_NOT_FOUND) {
+        /* Not able to find matching framework type is not necessarily
+         * an error case. This happens when mm-camera supports more attributes
+         * than the frameworks do */
+        CDBG_HIGH("%s: Cannot find matching framework type", __func__);
+    }
+    return fwk_name;
 }
 
 /*===========================================================================
@@ -3750,23 +4068,21 @@ int QCamera3HardwareInterface::lookupFwkName(const QCameraMap arr[],
  *              make sure the parameter is correctly propogated
  *
  * PARAMETERS  :
- *   @arr      : map between the two enums
- *   @len      : len of the map
+ *   @map      : indexed map between the two enums
  *   @fwk_name : name of the hal_parm to map
  *
  * RETURN     : int32_t type of status
  *              hal_name  -- success
  *              none-zero failure code
  *==========================================================================*/
-int QCamera3HardwareInterface::lookupHalName(const QCameraMap arr[],
-        size_t len, int fwk_name)
+int QCamera3HardwareInterface::lookupHalName(
+        const QCameraEnumLookup<QCameraMap> &map, int fwk_name)
 {
-    for (size_t i = 0; i < len; i++) {
-       if (arr[i].fwk_name == fwk_name)
-           return arr[i].hal_name;
+    int hal_name = map.toHal(fwk_name);
+    if (hal_name == NAME_NOT_FOUND) {
+        ALOGE("%s: Cannot find matching hal type fwk_name=%d", __func__, fwk_name);
     }
-    ALOGE("%s: Cannot find matching hal type fwk_name=%d", __func__, fwk_name);
-    return NAME_NOT_FOUND;
+    return hal_name;
 }
 
 /*===========================================================================
@@ -3775,24 +4091,20 @@ int QCamera3HardwareInterface::lookupHalName(const QCameraMap arr[],
  * DESCRIPTION: lookup a value by its name
  *
  * PARAMETERS :
- *   @attr    : map contains <name, value>
- *   @len     : size of the map
+ *   @map     : indexed map contains <name, value>
  *   @name    : name to be looked up
  *
  * RETURN     : Value if found
  *              CAM_CDS_MODE_MAX if not found
  *==========================================================================*/
-cam_cds_mode_type_t QCamera3HardwareInterface::lookupProp(const QCameraPropMap arr[],
-        size_t len, const char *name)
+cam_cds_mode_type_t QCamera3HardwareInterface::lookupProp(
+        const QCameraNameLookup<QCameraPropMap> &map, const char *name)
 {
-    if (name) {
-        for (size_t i = 0; i < len; i++) {
-            if (!strcmp(arr[i].desc, name)) {
-                return arr[i].val;
-            }
-        }
+    int val = map.lookup(name);
+    if (val == NAME_NOT_FOUND) {
+        return CAM_CDS_MODE_MAX;
     }
-    return CAM_CDS_MODE_MAX;
+    return (cam_cds_mode_type_t)val;
 }
 
 /*===========================================================================
@@ -4080,7 +4392,7 @@ camera_metadata_t* QCamera3HardwareInterface::translateCapabilityToMetadata(int
     memset(prop, 0, sizeof(prop));
     property_get("persist.camera.CDS", prop, "Auto");
     cam_cds_mode_type_t cds_mode = CAM_CDS_MODE_AUTO;
-    cds_mode = lookupProp(CDS_MAP, sizeof(CDS_MAP)/sizeof(QCameraPropMap), prop);
+    cds_mode = lookupProp(CDS_LOOKUP, prop);
     if (CAM_CDS_MODE_MAX == cds_mode) {
         cds_mode = CAM_CDS_MODE_AUTO;
     }
@@ -4118,7 +4430,7 @@ int QCamera3HardwareInterface::setFrameParameters(camera3_capture_request_t *req
 
     int32_t hal_version = CAM_HAL_V3;
 
-    memset(mParameters, 0, sizeof(parm_buffer_t));
+    cam_parm_batch_init(mParameters, &mParmDirty);
     rc = AddSetParmEntryToBatch(mParameters, CAM_INTF_PARM_HAL_VERSION,
                 sizeof(hal_version), &hal_version);
     if (rc < 0) {
@@ -4147,8 +4459,13 @@ int QCamera3HardwareInterface::setFrameParameters(camera3_capture_request_t *req
         rc = translateMetadataToParameters(request);
     }
 
+    CDBG("%s: frame %u: %u params, %u bytes delta vs %zu bytes flat", __func__,
+        request->frame_number, mParmDirty.num_entries,
+        cam_parm_delta_size(&mParmDirty), sizeof(parm_buffer_t));
+
     /*set the parameters to backend*/
-    mCameraHandle->ops->set_parms(mCameraHandle->camera_handle, mParameters);
+    mCameraHandle->ops->set_parms_delta(mCameraHandle->camera_handle,
+        mParameters, &mParmDirty);
     return rc;
 }
 
@@ -4187,8 +4504,7 @@ int QCamera3HardwareInterface::translateMetadataToParameters
                 sizeof(metaMode), &metaMode);
         if (metaMode == ANDROID_CONTROL_MODE_USE_SCENE_MODE) {
             uint8_t fwk_sceneMode = frame_settings.find(ANDROID_CONTROL_SCENE_MODE).data.u8[0];
-            int val = lookupHalName(SCENE_MODES_MAP, METADATA_MAP_SIZE(SCENE_MODES_MAP),
-                    fwk_sceneMode);
+            int val = lookupHalName(SCENE_MODES_LOOKUP, fwk_sceneMode);
             if (NAME_NOT_FOUND != val) {
                 uint8_t sceneMode = (uint8_t)val;
                 rc = AddSetParmEntryToBatch(mParameters, CAM_INTF_PARM_BESTSHOT_MODE,
@@ -4225,8 +4541,7 @@ int QCamera3HardwareInterface::translateMetadataToParameters
         rc = AddSetParmEntryToBatch(mParameters, CAM_INTF_META_AEC_MODE,
                 sizeof(aeMode), &aeMode);
 
-        int val = lookupHalName(AE_FLASH_MODE_MAP, METADATA_MAP_SIZE(AE_FLASH_MODE_MAP),
-                fwk_aeMode);
+        int val = lookupHalName(AE_FLASH_MODE_LOOKUP, fwk_aeMode);
         if (NAME_NOT_FOUND != val) {
             int32_t flashMode = (int32_t)val;
             rc = AddSetParmEntryToBatch(mParameters, CAM_INTF_PARM_LED_MODE,
@@ -4239,8 +4554,7 @@ int QCamera3HardwareInterface::translateMetadataToParameters
 
     if (frame_settings.exists(ANDROID_CONTROL_AWB_MODE)) {
         uint8_t fwk_whiteLevel = frame_settings.find(ANDROID_CONTROL_AWB_MODE).data.u8[0];
-        int val = lookupHalName(WHITE_BALANCE_MODES_MAP, METADATA_MAP_SIZE(WHITE_BALANCE_MODES_MAP),
-                fwk_whiteLevel);
+        int val = lookupHalName(WHITE_BALANCE_MODES_LOOKUP, fwk_whiteLevel);
         if (NAME_NOT_FOUND != val) {
             uint8_t whiteLevel = (uint8_t)val;
             rc = AddSetParmEntryToBatch(mParameters, CAM_INTF_PARM_WHITE_BALANCE,
@@ -4251,8 +4565,7 @@ int QCamera3HardwareInterface::translateMetadataToParameters
 
     if (frame_settings.exists(ANDROID_CONTROL_AF_MODE)) {
         uint8_t fwk_focusMode = frame_settings.find(ANDROID_CONTROL_AF_MODE).data.u8[0];
-        int val = lookupHalName(FOCUS_MODES_MAP, METADATA_MAP_SIZE(FOCUS_MODES_MAP),
-                fwk_focusMode);
+        int val = lookupHalName(FOCUS_MODES_LOOKUP, fwk_focusMode);
         if (NAME_NOT_FOUND != val) {
             uint8_t focusMode = (uint8_t)val;
             rc = AddSetParmEntryToBatch(mParameters, CAM_INTF_PARM_FOCUS_MODE,
@@ -4269,8 +4582,8 @@ int QCamera3HardwareInterface::translateMetadataToParameters
     if (frame_settings.exists(ANDROID_CONTROL_AE_ANTIBANDING_MODE)) {
         uint8_t fwk_antibandingMode =
                 frame_settings.find(ANDROID_CONTROL_AE_ANTIBANDING_MODE).data.u8[0];
-        int val = lookupHalName(ANTIBANDING_MODES_MAP,
-                METADATA_MAP_SIZE(ANTIBANDING_MODES_MAP), fwk_antibandingMode);
+        int val = lookupHalName(ANTIBANDING_MODES_LOOKUP,
+                fwk_antibandingMode);
         if (NAME_NOT_FOUND != val) {
             int32_t hal_antibandingMode = (int)val;
             rc = AddSetParmEntryToBatch(mParameters, CAM_INTF_PARM_ANTIBANDING,
@@ -4312,8 +4625,7 @@ int QCamera3HardwareInterface::translateMetadataToParameters
 
     if (frame_settings.exists(ANDROID_CONTROL_EFFECT_MODE)) {
         uint8_t fwk_effectMode = frame_settings.find(ANDROID_CONTROL_EFFECT_MODE).data.u8[0];
-        int val = lookupHalName(EFFECT_MODES_MAP, METADATA_MAP_SIZE(EFFECT_MODES_MAP),
-                fwk_effectMode);
+        int val = lookupHalName(EFFECT_MODES_LOOKUP, fwk_effectMode);
         if (NAME_NOT_FOUND != val) {
             uint8_t effectMode = (uint8_t)val;
             rc = AddSetParmEntryToBatch(mParameters, CAM_INTF_PARM_EFFECT,
@@ -4416,7 +4728,7 @@ int QCamera3HardwareInterface::translateMetadataToParameters
             }
         }
         if (respectFlashMode) {
-            int val = lookupHalName(FLASH_MODES_MAP, METADATA_MAP_SIZE(FLASH_MODES_MAP),
+            int val = lookupHalName(FLASH_MODES_LOOKUP,
                     (int)frame_settings.find(ANDROID_FLASH_MODE).data.u8[0]);
             CDBG_HIGH("%s: flash mode after mapping %d", __func__, val);
             // To check: CAM_INTF_META_FLASH_MODE usage
@@ -4567,8 +4879,7 @@ int QCamera3HardwareInterface::translateMetadataToParameters
     if (frame_settings.exists(ANDROID_STATISTICS_FACE_DETECT_MODE)) {
         uint8_t fwk_facedetectMode =
                 frame_settings.find(ANDROID_STATISTICS_FACE_DETECT_MODE).data.u8[0];
-        int val = lookupHalName(FACEDETECT_MODES_MAP, METADATA_MAP_SIZE(FACEDETECT_MODES_MAP),
-                fwk_facedetectMode);
+        int val = lookupHalName(FACEDETECT_MODES_LOOKUP, fwk_facedetectMode);
         if (NAME_NOT_FOUND != val) {
             uint8_t facedetectMode = (uint8_t)val;
             rc = AddSetParmEntryToBatch(mParameters, CAM_INTF_META_STATS_FACEDETECT_MODE,
@@ -37,6 +37,9 @@
 #include <camera/CameraMetadata.h>
 #include "QCamera3HALHeader.h"
 #include "QCamera3Channel.h"
+#include "QCamera3InFlight.h"
+#include "QCamera3FrameRing.h"
+#include "QCameraLookupMap.h"
 
 #include <hardware/power.h>
 
@@ -177,12 +180,12 @@ private:
     int closeCamera();
     int AddSetParmEntryToBatch(parm_buffer_t *p_table,
             cam_intf_parm_type_t paramType, size_t paramLength, void *paramValue);
-    static int lookupHalName(const QCameraMap arr[],
-            size_t len, int fwk_name);
-    static int lookupFwkName(const QCameraMap arr[],
-            size_t len, int hal_name);
-    static cam_cds_mode_type_t lookupProp(const QCameraPropMap arr[],
-            size_t len, const char *name);
+    static int lookupHalName(const QCameraEnumLookup<QCameraMap> &map,
+            int fwk_name);
+    static int lookupFwkName(const QCameraEnumLookup<QCameraMap> &map,
+            int hal_name);
+    static cam_cds_mode_type_t lookupProp(
+            const QCameraNameLookup<QCameraPropMap> &map, const char *name);
     static size_t calcMaxJpegSize(uint32_t camera_id);
 
     int validateCaptureRequest(camera3_capture_request_t *request);
@@ -193,6 +196,13 @@ private:
     void handleBufferWithLock(camera3_stream_buffer_t *buffer,
             uint32_t frame_number);
     void unblockRequestIfNecessary();
+    int32_t addPendingBuffer(uint32_t frame_number, camera3_stream_t *stream,
+            buffer_handle_t *buffer);
+    bool removePendingBuffer(uint32_t frame_number, buffer_handle_t *buffer);
+    void updateStreamPendingBuffers(camera3_stream_t *stream, int32_t delta);
+    void resetPendingBuffers();
+    void addFrameDrop(uint32_t frame_number, uint32_t streamID);
+    bool consumeFrameDrop(uint32_t frame_number, uint32_t streamID);
     void dumpMetadataToFile(tuning_params_t &meta, uint32_t &dumpFrameCount,
             bool enabled, const char *type, uint32_t frameNumber);
     static void getLogLevel();
@@ -224,18 +234,21 @@ private:
     bool mFirstRequest;
     QCamera3HeapMemory *mParamHeap;
     parm_buffer_t* mParameters;
+    cam_parm_dirty_t mParmDirty;
     bool m_bWNROn;
 
     /* Data structure to store pending request */
     typedef struct {
         camera3_stream_t *stream;
-        camera3_stream_buffer_t *buffer;
+        // Returned buffer, valid once buffer_ready is set
+        camera3_stream_buffer_t buffer;
+        bool buffer_ready;
     } RequestedBufferInfo;
     typedef struct {
         uint32_t frame_number;
         uint32_t num_buffers;
         int32_t request_id;
-        List<RequestedBufferInfo> buffers;
+        RequestedBufferInfo buffers[MAX_NUM_STREAMS];
         int blob_request;
         jpeg_settings_t input_jpeg_settings;
         nsecs_t timestamp;
@@ -244,7 +257,8 @@ private:
     } PendingRequestInfo;
     typedef struct {
         uint32_t frame_number;
-        uint32_t stream_ID;
+        uint32_t num_streams;
+        uint32_t stream_ID[MAX_NUM_STREAMS];
     } PendingFrameDropInfo;
     /*Data structure to store metadata information*/
     typedef struct {
@@ -262,19 +276,26 @@ private:
         buffer_handle_t *buffer;
     } PendingBufferInfo;
 
+    typedef struct {
+        uint32_t frame_number;
+        uint32_t num_buffers;
+        PendingBufferInfo buffers[MAX_NUM_STREAMS];
+    } PendingFrameBuffers;
+
     typedef struct {
         // Total number of buffer requests pending
         uint32_t num_buffers;
-        // List of pending buffers
-        List<PendingBufferInfo> mPendingBufferList;
+        // Pending buffers indexed by frame number
+        QCamera3FrameRing<PendingFrameBuffers> mPendingBufferList;
     } PendingBuffersMap;
 
     List<MetadataBufferInfo> mStoredMetadataList;
-    List<PendingRequestInfo> mPendingRequestsList;
-    List<PendingFrameDropInfo> mPendingFrameDropList;
+    QCamera3FrameRing<PendingRequestInfo> mPendingRequestsList;
+    QCamera3FrameRing<PendingFrameDropInfo> mPendingFrameDropList;
     PendingBuffersMap mPendingBuffersMap;
     pthread_cond_t mRequestCond;
     int mPendingRequest;
+    QCamera3InFlight mInFlight;
     int32_t mCurrentRequestId;
 
     //mutex for serialized access to camera3_device_ops_t functions
@@ -310,6 +331,19 @@ private:
     static const QCameraMap REFERENCE_ILLUMINANT_MAP[];
     static const QCameraPropMap CDS_MAP[];
 
+    // dense indexes over the maps above, used for all lookups
+    static const QCameraEnumLookup<QCameraMap> EFFECT_MODES_LOOKUP;
+    static const QCameraEnumLookup<QCameraMap> WHITE_BALANCE_MODES_LOOKUP;
+    static const QCameraEnumLookup<QCameraMap> SCENE_MODES_LOOKUP;
+    static const QCameraEnumLookup<QCameraMap> FOCUS_MODES_LOOKUP;
+    static const QCameraEnumLookup<QCameraMap> ANTIBANDING_MODES_LOOKUP;
+    static const QCameraEnumLookup<QCameraMap> LENS_STATE_LOOKUP;
+    static const QCameraEnumLookup<QCameraMap> AE_FLASH_MODE_LOOKUP;
+    static const QCameraEnumLookup<QCameraMap> FLASH_MODES_LOOKUP;
+    static const QCameraEnumLookup<QCameraMap> FACEDETECT_MODES_LOOKUP;
+    static const QCameraEnumLookup<QCameraMap> REFERENCE_ILLUMINANT_LOOKUP;
+    static const QCameraNameLookup<QCameraPropMap> CDS_LOOKUP;
+
     static pthread_mutex_t mCameraSessionLock;
     static unsigned int mCameraSessionActive;
 };
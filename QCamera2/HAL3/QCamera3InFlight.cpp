@@ -0,0 +1,236 @@
+/* Copyright (c) 2014, The Linux Foundataion. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#define LOG_TAG "QCamera3InFlight"
+
+#include <string.h>
+#include <utils/Log.h>
+#include "QCamera3InFlight.h"
+
+namespace qcamera {
+
+/*===========================================================================
+ * FUNCTION   : QCamera3InFlight
+ *
+ * DESCRIPTION: constructor of QCamera3InFlight
+ *
+ * PARAMETERS :
+ *   @defaultDepth : depth used until result latency has been observed
+ *
+ * RETURN     : None
+ *==========================================================================*/
+QCamera3InFlight::QCamera3InFlight(uint32_t defaultDepth)
+    : mDefaultDepth(defaultDepth),
+      mDepth(defaultDepth),
+      mMaxDepth(defaultDepth),
+      mFrameDuration(0),
+      mMinFrameDuration(0),
+      mWindowMinLatency(0),
+      mLastWindowMinLatency(0),
+      mWindowSamples(0),
+      mAvgLatency(0),
+      mStallTime(0),
+      mMaxStallTime(0),
+      mStallCount(0)
+{
+    memset(mHistory, 0, sizeof(mHistory));
+}
+
+/*===========================================================================
+ * FUNCTION   : configure
+ *
+ * DESCRIPTION: reset the depth for a new stream configuration
+ *
+ * PARAMETERS :
+ *   @maxBuffers       : buffers the framework may dequeue per stream
+ *   @minFrameDuration : minimum frame duration of the configuration in ns
+ *
+ * RETURN     : None
+ *==========================================================================*/
+void QCamera3InFlight::configure(uint32_t maxBuffers, int64_t minFrameDuration)
+{
+    mMaxDepth = (maxBuffers > kMinDepth) ? maxBuffers : kMinDepth;
+    mMinFrameDuration = minFrameDuration;
+    mFrameDuration = minFrameDuration;
+    mWindowMinLatency = 0;
+    mLastWindowMinLatency = 0;
+    mWindowSamples = 0;
+    mAvgLatency = 0;
+    mStallTime = 0;
+    mMaxStallTime = 0;
+    mStallCount = 0;
+    memset(mHistory, 0, sizeof(mHistory));
+    updateDepth();
+}
+
+/*===========================================================================
+ * FUNCTION   : requestSubmitted
+ *
+ * DESCRIPTION: remember the submit time of a capture request
+ *
+ * PARAMETERS :
+ *   @frameNumber   : frame number of the request
+ *   @frameDuration : minimum frame duration of the request in ns
+ *   @now           : current time in ns
+ *
+ * RETURN     : None
+ *==========================================================================*/
+void QCamera3InFlight::requestSubmitted(uint32_t frameNumber,
+        int64_t frameDuration, int64_t now)
+{
+    SubmitInfo &info = mHistory[frameNumber % kHistorySize];
+    info.frame_number = frameNumber;
+    info.submit_time = now;
+    info.valid = true;
+
+    if (frameDuration < mMinFrameDuration) {
+        frameDuration = mMinFrameDuration;
+    }
+    if (frameDuration != mFrameDuration) {
+        mFrameDuration = frameDuration;
+        updateDepth();
+    }
+}
+
+/*===========================================================================
+ * FUNCTION   : resultReceived
+ *
+ * DESCRIPTION: account the result latency of a request and resize the depth
+ *
+ * PARAMETERS :
+ *   @frameNumber : frame number of the completed request
+ *   @now         : current time in ns
+ *
+ * RETURN     : None
+ *==========================================================================*/
+void QCamera3InFlight::resultReceived(uint32_t frameNumber, int64_t now)
+{
+    SubmitInfo &info = mHistory[frameNumber % kHistorySize];
+    if (!info.valid || info.frame_number != frameNumber) {
+        return;
+    }
+    info.valid = false;
+
+    int64_t latency = now - info.submit_time;
+    if (latency <= 0) {
+        return;
+    }
+
+    // Queueing behind earlier requests inflates the latency of every
+    // request once the depth is large enough, so only the windowed
+    // minimum is used for sizing. The average is kept for dump.
+    if (mWindowSamples == 0 || latency < mWindowMinLatency) {
+        mWindowMinLatency = latency;
+    }
+    if (++mWindowSamples >= kLatencyWindow) {
+        mLastWindowMinLatency = mWindowMinLatency;
+        mWindowSamples = 0;
+    }
+    mAvgLatency = (mAvgLatency == 0) ? latency :
+            mAvgLatency + (latency - mAvgLatency) / 8;
+
+    updateDepth();
+}
+
+/*===========================================================================
+ * FUNCTION   : stallRecorded
+ *
+ * DESCRIPTION: account time the framework thread was blocked on the depth
+ *
+ * PARAMETERS :
+ *   @stallTime : blocked time in ns
+ *
+ * RETURN     : None
+ *==========================================================================*/
+void QCamera3InFlight::stallRecorded(int64_t stallTime)
+{
+    if (stallTime <= 0) {
+        return;
+    }
+    mStallTime += stallTime;
+    mStallCount++;
+    if (stallTime > mMaxStallTime) {
+        mMaxStallTime = stallTime;
+    }
+}
+
+/*===========================================================================
+ * FUNCTION   : getMinLatency
+ *
+ * DESCRIPTION: minimum result latency over the current and last window
+ *
+ * PARAMETERS : None
+ *
+ * RETURN     : latency in ns, 0 if none observed yet
+ *==========================================================================*/
+int64_t QCamera3InFlight::getMinLatency() const
+{
+    int64_t latency = (mWindowSamples > 0) ? mWindowMinLatency : 0;
+    if (mLastWindowMinLatency > 0 &&
+            (latency == 0 || mLastWindowMinLatency < latency)) {
+        latency = mLastWindowMinLatency;
+    }
+    return latency;
+}
+
+/*===========================================================================
+ * FUNCTION   : updateDepth
+ *
+ * DESCRIPTION: depth = ceil(min latency / frame duration) + 1, bounded by
+ *              kMinDepth and the stream buffers of the configuration
+ *
+ * PARAMETERS : None
+ *
+ * RETURN     : None
+ *==========================================================================*/
+void QCamera3InFlight::updateDepth()
+{
+    int64_t latency = getMinLatency();
+    uint32_t depth;
+
+    if (latency == 0 || mFrameDuration <= 0) {
+        depth = mDefaultDepth;
+    } else {
+        depth = (uint32_t)((latency + mFrameDuration - 1) / mFrameDuration) + 1;
+    }
+
+    if (depth < kMinDepth) {
+        depth = kMinDepth;
+    } else if (depth > mMaxDepth) {
+        depth = mMaxDepth;
+    }
+    if (depth != mDepth) {
+        ALOGV("%s: in flight depth %u -> %u, latency %lld frame duration %lld",
+                __func__, mDepth, depth, (long long)latency,
+                (long long)mFrameDuration);
+        mDepth = depth;
+    }
+}
+
+}; //namespace qcamera
@@ -0,0 +1,97 @@
+/* Copyright (c) 2014, The Linux Foundataion. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef __QCAMERA3_INFLIGHT_H__
+#define __QCAMERA3_INFLIGHT_H__
+
+#include <stdint.h>
+
+namespace qcamera {
+
+/* Sizes how many capture requests may be in flight for the configured
+ * session. The depth covers the pipeline latency at the current frame
+ * duration plus one request of headroom, capped by the stream buffers. */
+class QCamera3InFlight {
+public:
+    QCamera3InFlight(uint32_t defaultDepth);
+    virtual ~QCamera3InFlight() {};
+
+    void configure(uint32_t maxBuffers, int64_t minFrameDuration);
+    void requestSubmitted(uint32_t frameNumber, int64_t frameDuration,
+            int64_t now);
+    void resultReceived(uint32_t frameNumber, int64_t now);
+    void stallRecorded(int64_t stallTime);
+
+    uint32_t getDepth() const { return mDepth; };
+    uint32_t getMaxDepth() const { return mMaxDepth; };
+    int64_t getMinLatency() const;
+    int64_t getAvgLatency() const { return mAvgLatency; };
+    int64_t getFrameDuration() const { return mFrameDuration; };
+    int64_t getStallTime() const { return mStallTime; };
+    int64_t getMaxStallTime() const { return mMaxStallTime; };
+    uint32_t getStallCount() const { return mStallCount; };
+
+private:
+    void updateDepth();
+
+    // floor of the depth, keeps one request queued behind the active one
+    static const uint32_t kMinDepth = 2;
+    // submit times remembered for result latency
+    static const uint32_t kHistorySize = 32;
+    // results per minimum latency window
+    static const uint32_t kLatencyWindow = 64;
+
+    typedef struct {
+        uint32_t frame_number;
+        int64_t submit_time;
+        bool valid;
+    } SubmitInfo;
+
+    uint32_t mDefaultDepth;
+    uint32_t mDepth;
+    uint32_t mMaxDepth;
+    int64_t mFrameDuration;
+    int64_t mMinFrameDuration;
+
+    SubmitInfo mHistory[kHistorySize];
+
+    // windowed minimum latency, the smaller of current and last window
+    int64_t mWindowMinLatency;
+    int64_t mLastWindowMinLatency;
+    uint32_t mWindowSamples;
+    int64_t mAvgLatency;
+
+    int64_t mStallTime;
+    int64_t mMaxStallTime;
+    uint32_t mStallCount;
+};
+
+}; // namespace qcamera
+
+#endif /* __QCAMERA3_INFLIGHT_H__ */
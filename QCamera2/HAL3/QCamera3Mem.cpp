@@ -659,6 +659,7 @@ int QCamera3GrallocMemory::registerBuffer(buffer_handle_t *buffer)
         ret = NO_MEMORY;
     } else {
         mPtr[mBufferCount] = vaddr;
+        mBufIndex.add(buffer, (int)mBufferCount);
         mBufferCount++;
     }
 
@@ -693,6 +694,7 @@ void QCamera3GrallocMemory::unregisterBuffers()
         close(mMemInfo[cnt].main_ion_fd);
         CDBG_HIGH("put buffer %d successfully", cnt);
     }
+    mBufIndex.clear();
     mBufferCount = 0;
     CDBG(" %s : X ",__FUNCTION__);
 }
@@ -799,18 +801,11 @@ int QCamera3GrallocMemory::getRegFlags(uint8_t *regFlags) const
  *==========================================================================*/
 int QCamera3GrallocMemory::getMatchBufIndex(void *object)
 {
-    int index = -1;
     buffer_handle_t *key = (buffer_handle_t*) object;
     if (!key) {
         return BAD_VALUE;
     }
-    for (uint32_t i = 0; i < mBufferCount; i++) {
-        if (mBufferHandle[i] == key) {
-            index = (int)i;
-            break;
-        }
-    }
-    return index;
+    return mBufIndex.find(key);
 }
 
 /*===========================================================================
@@ -31,6 +31,7 @@
 #define __QCAMERA3HWI_MEM_H__
 #include <hardware/camera3.h>
 #include <utils/Mutex.h>
+#include "QCameraPtrIndex.h"
 
 extern "C" {
 #include <sys/types.h>
@@ -40,6 +41,9 @@ extern "C" {
 
 namespace qcamera {
 
+// every buffer of a stream has to fit in the pointer indexes below
+QCAMERA_PTR_INDEX_CHECK_CAPACITY(MM_CAMERA_MAX_NUM_FRAMES);
+
 // Base class for all memory types. Abstract.
 class QCamera3Memory {
 
@@ -84,6 +88,7 @@ protected:
     uint32_t mBufferCount;
     struct QCamera3MemInfo mMemInfo[MM_CAMERA_MAX_NUM_FRAMES];
     void *mPtr[MM_CAMERA_MAX_NUM_FRAMES];
+    QCameraPtrIndex mBufIndex;  // object registered by the framework -> index
 };
 
 // Internal heap memory is used for memories used internally
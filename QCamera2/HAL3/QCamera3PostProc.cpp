@@ -1232,6 +1232,7 @@ QCamera3Exif::QCamera3Exif()
     : m_nNumEntries(0)
 {
     memset(m_Entries, 0, sizeof(m_Entries));
+    cam_exif_arena_init(&m_Arena);
 }
 
 /*===========================================================================
@@ -1245,89 +1246,15 @@ QCamera3Exif::QCamera3Exif()
  *==========================================================================*/
 QCamera3Exif::~QCamera3Exif()
 {
-    for (uint32_t i = 0; i < m_nNumEntries; i++) {
-        switch (m_Entries[i].tag_entry.type) {
-            case EXIF_BYTE:
-                {
-                    if (m_Entries[i].tag_entry.count > 1 &&
-                            m_Entries[i].tag_entry.data._bytes != NULL) {
-                        free(m_Entries[i].tag_entry.data._bytes);
-                        m_Entries[i].tag_entry.data._bytes = NULL;
-                    }
-                }
-                break;
-            case EXIF_ASCII:
-                {
-                    if (m_Entries[i].tag_entry.data._ascii != NULL) {
-                        free(m_Entries[i].tag_entry.data._ascii);
-                        m_Entries[i].tag_entry.data._ascii = NULL;
-                    }
-                }
-                break;
-            case EXIF_SHORT:
-                {
-                    if (m_Entries[i].tag_entry.count > 1 &&
-                            m_Entries[i].tag_entry.data._shorts != NULL) {
-                        free(m_Entries[i].tag_entry.data._shorts);
-                        m_Entries[i].tag_entry.data._shorts = NULL;
-                    }
-                }
-                break;
-            case EXIF_LONG:
-                {
-                    if (m_Entries[i].tag_entry.count > 1 &&
-                            m_Entries[i].tag_entry.data._longs != NULL) {
-                        free(m_Entries[i].tag_entry.data._longs);
-                        m_Entries[i].tag_entry.data._longs = NULL;
-                    }
-                }
-                break;
-            case EXIF_RATIONAL:
-                {
-                    if (m_Entries[i].tag_entry.count > 1 &&
-                            m_Entries[i].tag_entry.data._rats != NULL) {
-                        free(m_Entries[i].tag_entry.data._rats);
-                        m_Entries[i].tag_entry.data._rats = NULL;
-                    }
-                }
-                break;
-            case EXIF_UNDEFINED:
-                {
-                    if (m_Entries[i].tag_entry.data._undefined != NULL) {
-                        free(m_Entries[i].tag_entry.data._undefined);
-                        m_Entries[i].tag_entry.data._undefined = NULL;
-                    }
-                }
-                break;
-            case EXIF_SLONG:
-                {
-                    if (m_Entries[i].tag_entry.count > 1 &&
-                            m_Entries[i].tag_entry.data._slongs != NULL) {
-                        free(m_Entries[i].tag_entry.data._slongs);
-                        m_Entries[i].tag_entry.data._slongs = NULL;
-                    }
-                }
-                break;
-            case EXIF_SRATIONAL:
-                {
-                    if (m_Entries[i].tag_entry.count > 1 &&
-                            m_Entries[i].tag_entry.data._srats != NULL) {
-                        free(m_Entries[i].tag_entry.data._srats);
-                        m_Entries[i].tag_entry.data._srats = NULL;
-                    }
-                }
-                break;
-            default:
-                ALOGE("%s: Error, Unknown type",__func__);
-                break;
-        }
-    }
+    cam_exif_arena_reset(&m_Arena);
 }
 
 /*===========================================================================
  * FUNCTION   : addEntry
  *
- * DESCRIPTION: function to add an entry to exif data
+ * DESCRIPTION: function to add an entry to exif data. Payloads are copied
+ *              into the arena embedded in the object, adding a tag that is
+ *              already present overwrites its value in place.
  *
  * PARAMETERS :
  *   @tagid   : exif tag ID
@@ -1344,156 +1271,12 @@ int32_t QCamera3Exif::addEntry(exif_tag_id_t tagid,
                               uint32_t count,
                               void *data)
 {
-    int32_t rc = NO_ERROR;
-    if(m_nNumEntries >= MAX_HAL3_EXIF_TABLE_ENTRIES) {
-        ALOGE("%s: Number of entries exceeded limit", __func__);
+    if (cam_exif_add_entry(&m_Arena, m_Entries, &m_nNumEntries,
+            MAX_HAL3_EXIF_TABLE_ENTRIES, tagid, type, count, data) != 0) {
+        ALOGE("%s: No room for tag 0x%x", __func__, tagid);
         return NO_MEMORY;
     }
-
-    m_Entries[m_nNumEntries].tag_id = tagid;
-    m_Entries[m_nNumEntries].tag_entry.type = type;
-    m_Entries[m_nNumEntries].tag_entry.count = count;
-    m_Entries[m_nNumEntries].tag_entry.copy = 1;
-    switch (type) {
-        case EXIF_BYTE:
-            {
-                if (count > 1) {
-                    uint8_t *values = (uint8_t *)malloc(count);
-                    if (values == NULL) {
-                        ALOGE("%s: No memory for byte array", __func__);
-                        rc = NO_MEMORY;
-                    } else {
-                        memcpy(values, data, count);
-                        m_Entries[m_nNumEntries].tag_entry.data._bytes = values;
-                    }
-                } else {
-                    m_Entries[m_nNumEntries].tag_entry.data._byte =
-                        *(uint8_t *)data;
-                }
-            }
-            break;
-        case EXIF_ASCII:
-            {
-                char *str = NULL;
-                str = (char *)malloc(count + 1);
-                if (str == NULL) {
-                    ALOGE("%s: No memory for ascii string", __func__);
-                    rc = NO_MEMORY;
-                } else {
-                    memset(str, 0, count + 1);
-                    memcpy(str, data, count);
-                    m_Entries[m_nNumEntries].tag_entry.data._ascii = str;
-                }
-            }
-            break;
-        case EXIF_SHORT:
-            {
-                if (count > 1) {
-                    uint16_t *values =
-                        (uint16_t *)malloc(count * sizeof(uint16_t));
-                    if (values == NULL) {
-                        ALOGE("%s: No memory for short array", __func__);
-                        rc = NO_MEMORY;
-                    } else {
-                        memcpy(values, data, count * sizeof(uint16_t));
-                        m_Entries[m_nNumEntries].tag_entry.data._shorts =values;
-                    }
-                } else {
-                    m_Entries[m_nNumEntries].tag_entry.data._short =
-                        *(uint16_t *)data;
-                }
-            }
-            break;
-        case EXIF_LONG:
-            {
-                if (count > 1) {
-                    uint32_t *values =
-                        (uint32_t *)malloc(count * sizeof(uint32_t));
-                    if (values == NULL) {
-                        ALOGE("%s: No memory for long array", __func__);
-                        rc = NO_MEMORY;
-                    } else {
-                        memcpy(values, data, count * sizeof(uint32_t));
-                        m_Entries[m_nNumEntries].tag_entry.data._longs = values;
-                    }
-                } else {
-                    m_Entries[m_nNumEntries].tag_entry.data._long =
-                        *(uint32_t *)data;
-                }
-            }
-            break;
-        case EXIF_RATIONAL:
-            {
-                if (count > 1) {
-                    rat_t *values = (rat_t *)malloc(count * sizeof(rat_t));
-                    if (values == NULL) {
-                        ALOGE("%s: No memory for rational array", __func__);
-                        rc = NO_MEMORY;
-                    } else {
-                        memcpy(values, data, count * sizeof(rat_t));
-                        m_Entries[m_nNumEntries].tag_entry.data._rats = values;
-                    }
-                } else {
-                    m_Entries[m_nNumEntries].tag_entry.data._rat =
-                        *(rat_t *)data;
-                }
-            }
-            break;
-        case EXIF_UNDEFINED:
-            {
-                uint8_t *values = (uint8_t *)malloc(count);
-                if (values == NULL) {
-                    ALOGE("%s: No memory for undefined array", __func__);
-                    rc = NO_MEMORY;
-                } else {
-                    memcpy(values, data, count);
-                    m_Entries[m_nNumEntries].tag_entry.data._undefined = values;
-                }
-            }
-            break;
-        case EXIF_SLONG:
-            {
-                if (count > 1) {
-                    int32_t *values =
-                        (int32_t *)malloc(count * sizeof(int32_t));
-                    if (values == NULL) {
-                        ALOGE("%s: No memory for signed long array", __func__);
-                        rc = NO_MEMORY;
-                    } else {
-                        memcpy(values, data, count * sizeof(int32_t));
-                        m_Entries[m_nNumEntries].tag_entry.data._slongs =values;
-                    }
-                } else {
-                    m_Entries[m_nNumEntries].tag_entry.data._slong =
-                        *(int32_t *)data;
-                }
-            }
-            break;
-        case EXIF_SRATIONAL:
-            {
-                if (count > 1) {
-                    srat_t *values = (srat_t *)malloc(count * sizeof(srat_t));
-                    if (values == NULL) {
-                        ALOGE("%s: No memory for sign rational array",__func__);
-                        rc = NO_MEMORY;
-                    } else {
-                        memcpy(values, data, count * sizeof(srat_t));
-                        m_Entries[m_nNumEntries].tag_entry.data._srats = values;
-                    }
-                } else {
-                    m_Entries[m_nNumEntries].tag_entry.data._srat =
-                        *(srat_t *)data;
-                }
-            }
-            break;
-        default:
-            ALOGE("%s: Error, Unknown type",__func__);
-            break;
-    }
-
-    // Increase number of entries
-    m_nNumEntries++;
-    return rc;
+    return NO_ERROR;
 }
 
 }; // namespace qcamera
@@ -33,6 +33,7 @@
 extern "C" {
 #include <mm_camera_interface.h>
 #include <mm_jpeg_interface.h>
+#include <cam_exif_arena.h>
 }
 //#include "QCamera3HWI.h"
 #include "QCameraQueue.h"
@@ -79,6 +80,7 @@ public:
 private:
     QEXIF_INFO_DATA m_Entries[MAX_HAL3_EXIF_TABLE_ENTRIES];  // exif tags for JPEG encoder
     uint32_t  m_nNumEntries;                            // number of valid entries
+    cam_exif_arena_t m_Arena;                           // storage of tag payloads
 };
 
 class QCamera3PostProcessor
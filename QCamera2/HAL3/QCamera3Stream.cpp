@@ -32,6 +32,7 @@
 
 #include <utils/Log.h>
 #include <utils/Errors.h>
+#include <cutils/properties.h>
 #include "QCamera3HWI.h"
 #include "QCamera3Stream.h"
 #include "QCamera3Channel.h"
@@ -174,6 +175,8 @@ QCamera3Stream::QCamera3Stream(uint32_t camHandle,
         mDataCB(NULL),
         mUserData(NULL),
         mDataQ(releaseFrameData, this),
+        mExecutor(NULL),
+        mExecLane(-1),
         mStreamInfoBuf(NULL),
         mStreamBufs(NULL),
         mBufDefs(NULL),
@@ -349,9 +352,13 @@ done:
 int32_t QCamera3Stream::start()
 {
     int32_t rc = 0;
-    rc = mProcTh.launch(dataProcRoutine, this);
-    if (rc == NO_ERROR) {
+    if (openExecLane()) {
         m_bActive = true;
+    } else {
+        rc = mProcTh.launch(dataProcRoutine, this);
+        if (rc == NO_ERROR) {
+            m_bActive = true;
+        }
     }
     return rc;
 }
@@ -370,11 +377,71 @@ int32_t QCamera3Stream::start()
 int32_t QCamera3Stream::stop()
 {
     int32_t rc = 0;
-    rc = mProcTh.exit();
-    m_bActive = false;
+    if (mExecLane >= 0) {
+        m_bActive = false;
+        rc = mExecutor->closeLane(mExecLane);
+        mExecLane = -1;
+    } else {
+        rc = mProcTh.exit();
+        m_bActive = false;
+    }
     return rc;
 }
 
+/*===========================================================================
+ * FUNCTION   : openExecLane
+ *
+ * DESCRIPTION: open a lane on the shared stream executor when the stream type
+ *              is set in persist.camera.exec.streams (bit mask of
+ *              cam_stream_type_t). Frames of the stream are then processed
+ *              on the executor workers instead of a dedicated thread.
+ *              persist.camera.exec.cpu.<type> and persist.camera.exec.nice.<type>
+ *              give the cpu and nice value of the lane.
+ *
+ * PARAMETERS : none
+ *
+ * RETURN     : true if the stream uses the shared executor
+ *==========================================================================*/
+bool QCamera3Stream::openExecLane()
+{
+    char prop[PROPERTY_VALUE_MAX];
+    char value[PROPERTY_VALUE_MAX];
+    char name[EXEC_LANE_NAME_LEN];
+    exec_lane_attr_t attr;
+    int type = (int)mStreamInfo->stream_type;
+
+    property_get("persist.camera.exec.streams", value, "0");
+    if (!((uint32_t)strtoul(value, NULL, 0) & (1U << type))) {
+        return false;
+    }
+
+    property_get("persist.camera.exec.workers", value, "2");
+    mExecutor = QCameraExecutor::getInstance((uint32_t)atoi(value));
+    if (NULL == mExecutor) {
+        return false;
+    }
+
+    memset(&attr, 0, sizeof(attr));
+    snprintf(name, sizeof(name), "strm_%d_%u", type, mHandle & 0xFF);
+    attr.name = name;
+    snprintf(prop, sizeof(prop), "persist.camera.exec.cpu.%d", type);
+    property_get(prop, value, "-1");
+    attr.cpu = atoi(value);
+    snprintf(prop, sizeof(prop), "persist.camera.exec.nice.%d", type);
+    property_get(prop, value, "0");
+    attr.nice = atoi(value);
+
+    mExecLane = mExecutor->openLane(dataProcJob, releaseFrameData, this, &attr);
+    if (mExecLane < 0) {
+        ALOGE("%s: No executor lane for stream type %d, using own thread",
+              __func__, type);
+        return false;
+    }
+    CDBG_HIGH("%s: stream type %d on executor lane %d", __func__, type,
+          mExecLane);
+    return true;
+}
+
 /*===========================================================================
  * FUNCTION   : processDataNotify
  *
@@ -391,9 +458,12 @@ int32_t QCamera3Stream::processDataNotify(mm_camera_super_buf_t *frame)
 {
     CDBG("%s: E\n", __func__);
     int32_t rc;
-    if (m_bActive) {
+    if (m_bActive && (mExecLane < 0)) {
         mDataQ.enqueue((void *)frame);
         rc = mProcTh.sendCmd(CAMERA_CMD_TYPE_DO_NEXT_JOB, FALSE, FALSE);
+    } else if (m_bActive &&
+            (NO_ERROR == mExecutor->post(mExecLane, (void *)frame))) {
+        rc = NO_ERROR;
     } else {
         ALOGD("%s: Stream thread is not active, no ops here", __func__);
         bufDone(frame->bufs[0]->buf_idx);
@@ -479,12 +549,7 @@ void *QCamera3Stream::dataProcRoutine(void *data)
                 mm_camera_super_buf_t *frame =
                     (mm_camera_super_buf_t *)pme->mDataQ.dequeue();
                 if (NULL != frame) {
-                    if (pme->mDataCB != NULL) {
-                        pme->mDataCB(frame, pme, pme->mUserData);
-                    } else {
-                        // no data cb routine, return buf here
-                        pme->bufDone(frame->bufs[0]->buf_idx);
-                    }
+                    dataProcJob(frame, pme);
                 }
             }
             break;
@@ -502,6 +567,31 @@ void *QCamera3Stream::dataProcRoutine(void *data)
     return NULL;
 }
 
+/*===========================================================================
+ * FUNCTION   : dataProcJob
+ *
+ * DESCRIPTION: process one frame, from the stream thread or from a lane of
+ *              the shared executor
+ *
+ * PARAMETERS :
+ *   @job     : stream frame
+ *   @data    : user data ptr (stream object)
+ *
+ * RETURN     : none
+ *==========================================================================*/
+void QCamera3Stream::dataProcJob(void *job, void *data)
+{
+    QCamera3Stream *pme = (QCamera3Stream *)data;
+    mm_camera_super_buf_t *frame = (mm_camera_super_buf_t *)job;
+
+    if (pme->mDataCB != NULL) {
+        pme->mDataCB(frame, pme, pme->mUserData);
+    } else {
+        // no data cb routine, return buf here
+        pme->bufDone(frame->bufs[0]->buf_idx);
+    }
+}
+
 /*===========================================================================
  * FUNCTION   : getInternalFormatBuffer
  *
@@ -620,25 +710,17 @@ int32_t QCamera3Stream::getBufs(cam_frame_len_offset_t *offset,
     }
 
     uint32_t registeredBuffers = mStreamBufs->getCnt();
-    for (uint32_t i = 0; i < registeredBuffers; i++) {
-        rc = ops_tbl->map_ops(i, -1, mStreamBufs->getFd(i),
-                (size_t)mStreamBufs->getSize(i), ops_tbl->userdata);
-        if (rc < 0) {
-            ALOGE("%s: map_stream_buf failed: %d", __func__, rc);
-            for (uint32_t j = 0; j < i; j++) {
-                ops_tbl->unmap_ops(j, -1, ops_tbl->userdata);
-            }
-            return INVALID_OPERATION;
-        }
+    rc = mapBufs(registeredBuffers, ops_tbl);
+    if (rc < 0) {
+        ALOGE("%s: map_stream_buf failed: %d", __func__, rc);
+        return INVALID_OPERATION;
     }
 
     //regFlags array is allocated by us, but consumed and freed by mm-camera-interface
     regFlags = (uint8_t *)malloc(sizeof(uint8_t) * mNumBufs);
     if (!regFlags) {
         ALOGE("%s: Out of memory", __func__);
-        for (uint32_t i = 0; i < registeredBuffers; i++) {
-            ops_tbl->unmap_ops(i, -1, ops_tbl->userdata);
-        }
+        unmapBufs(registeredBuffers, ops_tbl);
         return NO_MEMORY;
     }
     memset(regFlags, 0, sizeof(uint8_t) * mNumBufs);
@@ -646,9 +728,7 @@ int32_t QCamera3Stream::getBufs(cam_frame_len_offset_t *offset,
     mBufDefs = (mm_camera_buf_def_t *)malloc(mNumBufs * sizeof(mm_camera_buf_def_t));
     if (mBufDefs == NULL) {
         ALOGE("%s: Failed to allocate mm_camera_buf_def_t %d", __func__, rc);
-        for (uint32_t i = 0; i < registeredBuffers; i++) {
-            ops_tbl->unmap_ops(i, -1, ops_tbl->userdata);
-        }
+        unmapBufs(registeredBuffers, ops_tbl);
         free(regFlags);
         regFlags = NULL;
         return INVALID_OPERATION;
@@ -661,9 +741,7 @@ int32_t QCamera3Stream::getBufs(cam_frame_len_offset_t *offset,
     rc = mStreamBufs->getRegFlags(regFlags);
     if (rc < 0) {
         ALOGE("%s: getRegFlags failed %d", __func__, rc);
-        for (uint32_t i = 0; i < registeredBuffers; i++) {
-            ops_tbl->unmap_ops(i, -1, ops_tbl->userdata);
-        }
+        unmapBufs(registeredBuffers, ops_tbl);
         free(mBufDefs);
         mBufDefs = NULL;
         free(regFlags);
@@ -692,13 +770,9 @@ int32_t QCamera3Stream::getBufs(cam_frame_len_offset_t *offset,
 int32_t QCamera3Stream::putBufs(mm_camera_map_unmap_ops_tbl_t *ops_tbl)
 {
     int rc = NO_ERROR;
-    for (uint32_t i = 0; i < mNumBufs; i++) {
-        if (NULL != mBufDefs[i].mem_info) {
-            rc = ops_tbl->unmap_ops(i, -1, ops_tbl->userdata);
-            if (rc < 0) {
-                ALOGE("%s: map_stream_buf failed: %d", __func__, rc);
-            }
-        }
+    rc = unmapBufs(mNumBufs, ops_tbl);
+    if (rc < 0) {
+        ALOGE("%s: map_stream_buf failed: %d", __func__, rc);
     }
     mBufDefs = NULL; // mBufDefs just keep a ptr to the buffer
                      // mm-camera-interface own the buffer, so no need to free
@@ -708,6 +782,123 @@ int32_t QCamera3Stream::putBufs(mm_camera_map_unmap_ops_tbl_t *ops_tbl)
     return rc;
 }
 
+/*===========================================================================
+ * FUNCTION   : mapBufs
+ *
+ * DESCRIPTION: map the first buffers of the stream to server, batched into
+ *              one domain socket message when bundled mapping is available.
+ *              Falls back to one message per buffer when a bundle fails.
+ *
+ * PARAMETERS :
+ *   @count      : number of buffers to map
+ *   @ops_tbl    : ptr to buf mapping/unmapping ops
+ *
+ * RETURN     : int32_t type of status
+ *              NO_ERROR  -- success
+ *              none-zero failure code, no buffer left mapped
+ *==========================================================================*/
+int32_t QCamera3Stream::mapBufs(uint32_t count,
+        mm_camera_map_unmap_ops_tbl_t *ops_tbl)
+{
+    int32_t rc = NO_ERROR;
+    uint32_t i = 0;
+    cam_buf_map_type_list bufMapList;
+
+    while (i < count) {
+        uint32_t batchStart = i;
+        memset(&bufMapList, 0, sizeof(bufMapList));
+        for (; (i < count) && (bufMapList.length < CAM_MAX_NUM_BUFS_PER_MAP);
+                i++) {
+            cam_buf_map_type *bufMap =
+                    &bufMapList.buf_maps[bufMapList.length++];
+            bufMap->type = CAM_MAPPING_BUF_TYPE_STREAM_BUF;
+            bufMap->frame_idx = i;
+            bufMap->plane_idx = -1;
+            bufMap->fd = mStreamBufs->getFd(i);
+            bufMap->size = (size_t)mStreamBufs->getSize(i);
+        }
+        if ((NULL != ops_tbl->bundled_map_ops) &&
+                (ops_tbl->bundled_map_ops(&bufMapList,
+                        ops_tbl->userdata) >= 0)) {
+            continue;
+        }
+        if (NULL != ops_tbl->bundled_map_ops) {
+            ALOGE("%s: bundled mapping failed, mapping one by one", __func__);
+        }
+        // nothing of the batch reached the server, map one buffer at a time
+        for (i = batchStart; i < batchStart + bufMapList.length; i++) {
+            cam_buf_map_type *bufMap = &bufMapList.buf_maps[i - batchStart];
+            rc = ops_tbl->map_ops(bufMap->frame_idx, -1, bufMap->fd,
+                    bufMap->size, ops_tbl->userdata);
+            if (rc < 0) {
+                if (i > 0) {
+                    unmapBufs(i, ops_tbl);
+                }
+                return rc;
+            }
+        }
+    }
+
+    return NO_ERROR;
+}
+
+/*===========================================================================
+ * FUNCTION   : unmapBufs
+ *
+ * DESCRIPTION: unmap the first buffers of the stream from server, batched
+ *              into one domain socket message when bundled unmapping is
+ *              available. Buffers without memory info are skipped.
+ *
+ * PARAMETERS :
+ *   @count      : number of buffers to unmap
+ *   @ops_tbl    : ptr to buf mapping/unmapping ops
+ *
+ * RETURN     : int32_t type of status
+ *              NO_ERROR  -- success
+ *              none-zero failure code of the last failed unmapping
+ *==========================================================================*/
+int32_t QCamera3Stream::unmapBufs(uint32_t count,
+        mm_camera_map_unmap_ops_tbl_t *ops_tbl)
+{
+    int32_t rc = NO_ERROR;
+    uint32_t i = 0;
+    cam_buf_unmap_type_list bufUnmapList;
+
+    while (i < count) {
+        memset(&bufUnmapList, 0, sizeof(bufUnmapList));
+        for (; (i < count) &&
+                (bufUnmapList.length < CAM_MAX_NUM_BUFS_PER_MAP); i++) {
+            if ((NULL != mBufDefs) && (NULL == mBufDefs[i].mem_info)) {
+                continue;
+            }
+            cam_buf_unmap_type *bufUnmap =
+                    &bufUnmapList.buf_unmaps[bufUnmapList.length++];
+            bufUnmap->type = CAM_MAPPING_BUF_TYPE_STREAM_BUF;
+            bufUnmap->frame_idx = i;
+            bufUnmap->plane_idx = -1;
+        }
+        if (0 == bufUnmapList.length) {
+            continue;
+        }
+        if ((NULL != ops_tbl->bundled_unmap_ops) &&
+                (ops_tbl->bundled_unmap_ops(&bufUnmapList,
+                        ops_tbl->userdata) >= 0)) {
+            continue;
+        }
+        // no bundled unmapping, or the server rejected it
+        for (uint32_t j = 0; j < bufUnmapList.length; j++) {
+            int32_t ret = ops_tbl->unmap_ops(
+                    bufUnmapList.buf_unmaps[j].frame_idx, -1,
+                    ops_tbl->userdata);
+            if (ret < 0) {
+                rc = ret;
+            }
+        }
+    }
+
+    return rc;
+}
+
 /*===========================================================================
  * FUNCTION   : invalidateBuf
  *
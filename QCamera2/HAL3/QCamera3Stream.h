@@ -32,6 +32,7 @@
 
 #include <hardware/camera3.h>
 #include "QCameraCmdThread.h"
+#include "QCameraExecutor.h"
 #include "QCamera3Mem.h"
 
 extern "C" {
@@ -68,6 +69,7 @@ public:
 
     static void dataNotifyCB(mm_camera_super_buf_t *recvd_frame, void *userdata);
     static void *dataProcRoutine(void *data);
+    static void dataProcJob(void *job, void *data);
     uint32_t getMyHandle() const {return mHandle;}
     cam_stream_type_t getMyType() const;
     int32_t getFrameOffset(cam_frame_len_offset_t &offset);
@@ -98,6 +100,8 @@ private:
 
     QCameraQueue     mDataQ;
     QCameraCmdThread mProcTh; // thread for dataCB
+    QCameraExecutor *mExecutor; // shared executor used instead of mProcTh
+    int32_t mExecLane; // lane of the stream on mExecutor, -1 if none
 
     QCamera3HeapMemory *mStreamInfoBuf;
     QCamera3Memory *mStreamBufs;
@@ -126,6 +130,9 @@ private:
                      mm_camera_buf_def_t **bufs,
                      mm_camera_map_unmap_ops_tbl_t *ops_tbl);
     int32_t putBufs(mm_camera_map_unmap_ops_tbl_t *ops_tbl);
+    int32_t mapBufs(uint32_t count, mm_camera_map_unmap_ops_tbl_t *ops_tbl);
+    int32_t unmapBufs(uint32_t count, mm_camera_map_unmap_ops_tbl_t *ops_tbl);
+    bool openExecLane();
     int32_t invalidateBuf(uint32_t index);
     int32_t cleanInvalidateBuf(uint32_t index);
 
@@ -0,0 +1,217 @@
+/* Copyright (c) 2014, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef __CAM_EXIF_ARENA_H__
+#define __CAM_EXIF_ARENA_H__
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "QOMX_JpegExtensions.h"
+
+#define CAM_EXIF_ARENA_SIZE 1024
+#define CAM_EXIF_ARENA_MAX_SPILL 8
+
+/* Backing store for the payloads (strings and arrays) of an exif
+ * entry table. Payloads are carved from buf in the order the tags
+ * are added, so rebuilding the same tag set after a reset lands
+ * every payload at the same offset and needs no heap allocation.
+ * Payloads that do not fit go to the heap and are tracked in spill. */
+typedef struct {
+    uint8_t buf[CAM_EXIF_ARENA_SIZE] __attribute__((aligned(8)));
+    uint32_t used;
+    void *spill[CAM_EXIF_ARENA_MAX_SPILL];
+    uint32_t num_spill;
+} cam_exif_arena_t;
+
+static inline void cam_exif_arena_init(cam_exif_arena_t *arena)
+{
+    arena->used = 0;
+    arena->num_spill = 0;
+}
+
+/* drop all payloads, the entries referring to them become invalid */
+static inline void cam_exif_arena_reset(cam_exif_arena_t *arena)
+{
+    uint32_t i;
+
+    for (i = 0; i < arena->num_spill; i++) {
+        free(arena->spill[i]);
+        arena->spill[i] = NULL;
+    }
+    arena->num_spill = 0;
+    arena->used = 0;
+}
+
+static inline void *cam_exif_arena_alloc(cam_exif_arena_t *arena, uint32_t size)
+{
+    uint32_t offset = (arena->used + 7U) & ~7U;
+    void *p;
+
+    if (offset + size <= CAM_EXIF_ARENA_SIZE) {
+        arena->used = offset + size;
+        return &arena->buf[offset];
+    }
+    if (arena->num_spill >= CAM_EXIF_ARENA_MAX_SPILL) {
+        return NULL;
+    }
+    p = malloc(size);
+    if (p != NULL) {
+        arena->spill[arena->num_spill++] = p;
+    }
+    return p;
+}
+
+/* payload size in bytes, 0 if the value is stored in the entry itself */
+static inline uint32_t cam_exif_payload_size(exif_tag_type_t type,
+        uint32_t count)
+{
+    switch (type) {
+    case EXIF_ASCII:
+        return count + 1;
+    case EXIF_UNDEFINED:
+        return count;
+    case EXIF_BYTE:
+        return (count > 1) ? count : 0;
+    case EXIF_SHORT:
+        return (count > 1) ? count * (uint32_t)sizeof(uint16_t) : 0;
+    case EXIF_LONG:
+    case EXIF_SLONG:
+        return (count > 1) ? count * (uint32_t)sizeof(uint32_t) : 0;
+    case EXIF_RATIONAL:
+    case EXIF_SRATIONAL:
+        return (count > 1) ? count * (uint32_t)sizeof(rat_t) : 0;
+    }
+    return 0;
+}
+
+/* all pointer members of the data union share the same storage */
+static inline void *cam_exif_payload(QEXIF_INFO_DATA *entry)
+{
+    return entry->tag_entry.data._bytes;
+}
+
+/*===========================================================================
+ * FUNCTION   : cam_exif_add_entry
+ *
+ * DESCRIPTION: add a tag to an exif entry table or, if the tag is already
+ *              in the table, patch its value in place. Payloads are stored
+ *              in the arena, the previous payload is reused when the new
+ *              one fits.
+ *
+ * PARAMETERS :
+ *   @arena   : payload store of the table
+ *   @entries : exif entry table
+ *   @num     : number of valid entries, updated
+ *   @max     : size of the table
+ *   @tagid   : exif tag ID
+ *   @type    : data type
+ *   @count   : number of data in uint of its type
+ *   @data    : input data ptr
+ *
+ * RETURN     : 0 on success, -1 if the table or the arena is full
+ *==========================================================================*/
+static inline int32_t cam_exif_add_entry(cam_exif_arena_t *arena,
+        QEXIF_INFO_DATA *entries, uint32_t *num, uint32_t max,
+        exif_tag_id_t tagid, exif_tag_type_t type, uint32_t count,
+        void *data)
+{
+    QEXIF_INFO_DATA *entry = NULL;
+    uint32_t size = cam_exif_payload_size(type, count);
+    uint32_t old_size = 0;
+    uint8_t *payload = NULL;
+    uint32_t i;
+
+    for (i = 0; i < *num; i++) {
+        if (entries[i].tag_id == tagid) {
+            entry = &entries[i];
+            old_size = cam_exif_payload_size(entry->tag_entry.type,
+                    entry->tag_entry.count);
+            break;
+        }
+    }
+    if (entry == NULL) {
+        if (*num >= max) {
+            return -1;
+        }
+        entry = &entries[*num];
+    }
+
+    if (size > 0) {
+        if (size <= old_size) {
+            payload = (uint8_t *)cam_exif_payload(entry);
+        } else {
+            payload = (uint8_t *)cam_exif_arena_alloc(arena, size);
+        }
+        if (payload == NULL) {
+            return -1;
+        }
+        if (type == EXIF_ASCII) {
+            memcpy(payload, data, count);
+            payload[count] = 0;
+        } else {
+            memcpy(payload, data, size);
+        }
+        entry->tag_entry.data._bytes = payload;
+    } else {
+        switch (type) {
+        case EXIF_BYTE:
+            entry->tag_entry.data._byte = *(uint8_t *)data;
+            break;
+        case EXIF_SHORT:
+            entry->tag_entry.data._short = *(uint16_t *)data;
+            break;
+        case EXIF_LONG:
+            entry->tag_entry.data._long = *(uint32_t *)data;
+            break;
+        case EXIF_SLONG:
+            entry->tag_entry.data._slong = *(int32_t *)data;
+            break;
+        case EXIF_RATIONAL:
+            entry->tag_entry.data._rat = *(rat_t *)data;
+            break;
+        case EXIF_SRATIONAL:
+            entry->tag_entry.data._srat = *(srat_t *)data;
+            break;
+        default:
+            break;
+        }
+    }
+
+    entry->tag_id = tagid;
+    entry->tag_entry.type = type;
+    entry->tag_entry.count = count;
+    entry->tag_entry.copy = 1;
+    if (entry == &entries[*num]) {
+        (*num)++;
+    }
+    return 0;
+}
+
+#endif /* __CAM_EXIF_ARENA_H__ */
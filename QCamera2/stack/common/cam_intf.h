@@ -30,6 +30,7 @@
 #ifndef __QCAMERA_INTF_H__
 #define __QCAMERA_INTF_H__
 
+#include <stddef.h>
 #include <media/msmb_isp.h>
 #include "cam_types.h"
 
@@ -421,7 +422,7 @@ typedef struct {
  *                 Code for Domain Socket Based Parameters                   *
  ****************************************************************************/
 #define INCLUDE(PARAM_ID,DATATYPE,COUNT)  \
-        DATATYPE member_variable_##PARAM_ID[ COUNT ]
+        DATATYPE member_variable_##PARAM_ID[ COUNT ];
 
 #define POINTER_OF_META(META_ID, TABLE_PTR) \
         &TABLE_PTR->data.member_variable_##META_ID
@@ -436,172 +437,258 @@ typedef struct {
 #define SIZE_OF_PARAM(META_ID, TABLE_PTR) \
          sizeof(TABLE_PTR->data.member_variable_##META_ID)
 
-typedef struct {
+#ifdef  __cplusplus
+/* Element pointer of an entry, its type is deduced from parm_data_t */
+template <typename T, size_t N>
+inline T *cam_intf_entry_ptr(T (&entry)[N])
+{
+    return entry;
+}
+
+/* Typed POINTER_OF_META for C++ callers, no cast needed */
+#define POINTER_OF_META_TYPED(META_ID, TABLE_PTR) \
+        cam_intf_entry_ptr(TABLE_PTR->data.member_variable_##META_ID)
+#endif
+
+/* Table of all parm_data_t entries, expanded with INCLUDE into the
+ * struct members and with other ENTRY macros into lookup tables.
+ * NO_ID_ENTRY is used for members that have no param id. */
 /**************************************************************************************
  *  ID from (cam_intf_metadata_type_t)                DATATYPE                     COUNT
  **************************************************************************************/
-    /* common between HAL1 and HAL3 */
-    INCLUDE(CAM_INTF_META_HISTOGRAM,                    cam_hist_stats_t,               1);
-    INCLUDE(CAM_INTF_META_FACE_DETECTION,               cam_face_detection_data_t,      1);
-    INCLUDE(CAM_INTF_META_AUTOFOCUS_DATA,               cam_auto_focus_data_t,          1);
-
-    /* Specific to HAl1 */
-    INCLUDE(CAM_INTF_META_CROP_DATA,                    cam_crop_data_t,                1);
-    INCLUDE(CAM_INTF_META_PREP_SNAPSHOT_DONE,           int32_t,                        1);
-    INCLUDE(CAM_INTF_META_GOOD_FRAME_IDX_RANGE,         cam_frame_idx_range_t,          1);
-    INCLUDE(CAM_INTF_META_ASD_HDR_SCENE_DATA,           cam_asd_hdr_scene_data_t,       1);
-    INCLUDE(CAM_INTF_META_ASD_SCENE_TYPE,               int32_t,                        1);
-    INCLUDE(CAM_INTF_META_CURRENT_SCENE,                cam_scene_mode_type,            1);
-    INCLUDE(CAM_INTF_META_CHROMATIX_LITE_ISP,           cam_chromatix_lite_isp_t,       1);
-    INCLUDE(CAM_INTF_META_CHROMATIX_LITE_PP,            cam_chromatix_lite_pp_t,        1);
-    INCLUDE(CAM_INTF_META_CHROMATIX_LITE_AE,            cam_chromatix_lite_ae_stats_t,  1);
-    INCLUDE(CAM_INTF_META_CHROMATIX_LITE_AWB,           cam_chromatix_lite_awb_stats_t, 1);
-    INCLUDE(CAM_INTF_META_CHROMATIX_LITE_AF,            cam_chromatix_lite_af_stats_t,  1);
-    INCLUDE(CAM_INTF_META_CHROMATIX_LITE_ASD,           cam_chromatix_lite_asd_stats_t, 1);
-
-    /* Specific to HAL3 */
-    INCLUDE(CAM_INTF_META_FRAME_NUMBER_VALID,           int32_t,                     1);
-    INCLUDE(CAM_INTF_META_URGENT_FRAME_NUMBER_VALID,    int32_t,                     1);
-    INCLUDE(CAM_INTF_META_FRAME_DROPPED,                cam_frame_dropped_t,         1);
-    INCLUDE(CAM_INTF_META_PENDING_REQUESTS,             uint32_t,                    1);
-    INCLUDE(CAM_INTF_META_FRAME_NUMBER,                 uint32_t,                    1);
-    INCLUDE(CAM_INTF_META_URGENT_FRAME_NUMBER,          uint32_t,                    1);
-    INCLUDE(CAM_INTF_META_COLOR_CORRECT_MODE,           uint32_t,                    1);
-    INCLUDE(CAM_INTF_META_COLOR_CORRECT_TRANSFORM,      cam_color_correct_matrix_t,  1);
-    INCLUDE(CAM_INTF_META_COLOR_CORRECT_GAINS,          cam_color_correct_gains_t,   1);
-    INCLUDE(CAM_INTF_META_PRED_COLOR_CORRECT_TRANSFORM, cam_color_correct_matrix_t,  1);
-    INCLUDE(CAM_INTF_META_PRED_COLOR_CORRECT_GAINS,     cam_color_correct_gains_t,   1);
-    INCLUDE(CAM_INTF_META_AEC_ROI,                      cam_area_t,                  1);
-    INCLUDE(CAM_INTF_META_AEC_STATE,                    uint32_t,                    1);
-    INCLUDE(CAM_INTF_PARM_FOCUS_MODE,                   uint32_t,                    1);
-    INCLUDE(CAM_INTF_META_AF_ROI,                       cam_area_t,                  1);
-    INCLUDE(CAM_INTF_META_AF_STATE,                     uint32_t,                    1);
-    INCLUDE(CAM_INTF_PARM_WHITE_BALANCE,                int32_t,                     1);
-    INCLUDE(CAM_INTF_META_AWB_REGIONS,                  cam_area_t,                  1);
-    INCLUDE(CAM_INTF_META_AWB_STATE,                    uint32_t,                    1);
-    INCLUDE(CAM_INTF_META_BLACK_LEVEL_LOCK,             uint32_t,                    1);
-    INCLUDE(CAM_INTF_META_MODE,                         uint32_t,                    1);
-    INCLUDE(CAM_INTF_META_EDGE_MODE,                    cam_edge_application_t,      1);
-    INCLUDE(CAM_INTF_META_FLASH_POWER,                  uint32_t,                    1);
-    INCLUDE(CAM_INTF_META_FLASH_FIRING_TIME,            int64_t,                     1);
-    INCLUDE(CAM_INTF_META_FLASH_MODE,                   uint32_t,                    1);
-    INCLUDE(CAM_INTF_META_FLASH_STATE,                  int32_t,                     1);
-    INCLUDE(CAM_INTF_META_HOTPIXEL_MODE,                uint32_t,                    1);
-    INCLUDE(CAM_INTF_META_LENS_APERTURE,                float,                       1);
-    INCLUDE(CAM_INTF_META_LENS_FILTERDENSITY,           float,                       1);
-    INCLUDE(CAM_INTF_META_LENS_FOCAL_LENGTH,            float,                       1);
-    INCLUDE(CAM_INTF_META_LENS_FOCUS_DISTANCE,          float,                       1);
-    INCLUDE(CAM_INTF_META_LENS_FOCUS_RANGE,             float,                       2);
-    INCLUDE(CAM_INTF_META_LENS_STATE,                   cam_af_lens_state_t,         1);
-    INCLUDE(CAM_INTF_META_LENS_OPT_STAB_MODE,           uint32_t,                    1);
-    INCLUDE(CAM_INTF_META_LENS_FOCUS_STATE,             uint32_t,                    1);
-    INCLUDE(CAM_INTF_META_NOISE_REDUCTION_MODE,         uint32_t,                    1);
-    INCLUDE(CAM_INTF_META_NOISE_REDUCTION_STRENGTH,     uint32_t,                    1);
-    INCLUDE(CAM_INTF_META_SCALER_CROP_REGION,           cam_crop_region_t,           1);
-    INCLUDE(CAM_INTF_META_SCENE_FLICKER,                uint32_t,                    1);
-    INCLUDE(CAM_INTF_META_SENSOR_EXPOSURE_TIME,         int64_t,                     1);
-    INCLUDE(CAM_INTF_META_SENSOR_FRAME_DURATION,        int64_t,                     1);
-    INCLUDE(CAM_INTF_META_SENSOR_SENSITIVITY,           int32_t,                     1);
-    INCLUDE(CAM_INTF_META_SENSOR_TIMESTAMP,             int64_t,                     1);
-    INCLUDE(CAM_INTF_META_SHADING_MODE,                 uint32_t,                    1);
-    INCLUDE(CAM_INTF_META_STATS_FACEDETECT_MODE,        uint32_t,                    1);
-    INCLUDE(CAM_INTF_META_STATS_HISTOGRAM_MODE,         uint32_t,                    1);
-    INCLUDE(CAM_INTF_META_STATS_SHARPNESS_MAP_MODE,     uint32_t,                    1);
-    INCLUDE(CAM_INTF_META_STATS_SHARPNESS_MAP,          cam_sharpness_map_t,         3);
-    INCLUDE(CAM_INTF_META_TONEMAP_CURVES,               cam_rgb_tonemap_curves,      1);
-    INCLUDE(CAM_INTF_META_LENS_SHADING_MAP,             cam_lens_shading_map_t,      1);
-    INCLUDE(CAM_INTF_META_AEC_INFO,                     cam_3a_params_t,             1);
-    INCLUDE(CAM_INTF_META_SENSOR_INFO,                  cam_sensor_params_t,         1);
-    INCLUDE(CAM_INTF_META_ASD_SCENE_CAPTURE_TYPE,       cam_auto_scene_t,            1);
-    INCLUDE(CAM_INTF_PARM_EFFECT,                       uint32_t,                    1);
-    /* Defining as int32_t so that this array is 4 byte aligned */
-    INCLUDE(CAM_INTF_META_PRIVATE_DATA,                 int32_t,
-            MAX_METADATA_PRIVATE_PAYLOAD_SIZE_IN_BYTES / 4);
-
-    /* Following are Params only and not metadata currently */
-    INCLUDE(CAM_INTF_PARM_HAL_VERSION,                  int32_t,                     1);
-    /* Shared between HAL1 and HAL3 */
-    INCLUDE(CAM_INTF_PARM_ANTIBANDING,                  uint32_t,                    1);
-    INCLUDE(CAM_INTF_PARM_EXPOSURE_COMPENSATION,        int32_t,                     1);
-    INCLUDE(CAM_INTF_PARM_AEC_LOCK,                     uint32_t,                    1);
-    INCLUDE(CAM_INTF_PARM_FPS_RANGE,                    cam_fps_range_t,             1);
-    INCLUDE(CAM_INTF_PARM_AWB_LOCK,                     uint32_t,                    1);
-    INCLUDE(CAM_INTF_PARM_BESTSHOT_MODE,                uint32_t,                    1);
-    INCLUDE(CAM_INTF_PARM_DIS_ENABLE,                   int32_t,                     1);
-    INCLUDE(CAM_INTF_PARM_LED_MODE,                     int32_t,                     1);
-
-    /* HAL1 specific */
-    /* read only */
-    INCLUDE(CAM_INTF_PARM_QUERY_FLASH4SNAP,             int32_t,                     1);
-    INCLUDE(CAM_INTF_PARM_EXPOSURE,                     int32_t,                     1);
-    INCLUDE(CAM_INTF_PARM_SHARPNESS,                    int32_t,                     1);
-    INCLUDE(CAM_INTF_PARM_CONTRAST,                     int32_t,                     1);
-    INCLUDE(CAM_INTF_PARM_SATURATION,                   int32_t,                     1);
-    INCLUDE(CAM_INTF_PARM_BRIGHTNESS,                   int32_t,                     1);
-    INCLUDE(CAM_INTF_PARM_ISO,                          int32_t,                     1);
-    INCLUDE(CAM_INTF_PARM_ZOOM,                         int32_t,                     1);
-    INCLUDE(CAM_INTF_PARM_ROLLOFF,                      int32_t,                     1);
-    INCLUDE(CAM_INTF_PARM_MODE,                         int32_t,                     1);
-    INCLUDE(CAM_INTF_PARM_AEC_ALGO_TYPE,                int32_t,                     1);
-    INCLUDE(CAM_INTF_PARM_FOCUS_ALGO_TYPE,              int32_t,                     1);
-    INCLUDE(CAM_INTF_PARM_AEC_ROI,                      cam_set_aec_roi_t,           1);
-    INCLUDE(CAM_INTF_PARM_AF_ROI,                       cam_roi_info_t,              1);
-    INCLUDE(CAM_INTF_PARM_SCE_FACTOR,                   int32_t,                     1);
-    INCLUDE(CAM_INTF_PARM_FD,                           cam_fd_set_parm_t,           1);
-    INCLUDE(CAM_INTF_PARM_MCE,                          int32_t,                     1);
-    INCLUDE(CAM_INTF_PARM_HFR,                          int32_t,                     1);
-    INCLUDE(CAM_INTF_PARM_REDEYE_REDUCTION,             int32_t,                     1);
-    INCLUDE(CAM_INTF_PARM_WAVELET_DENOISE,              cam_denoise_param_t,         1);
-    INCLUDE(CAM_INTF_PARM_HISTOGRAM,                    int32_t,                     1);
-    INCLUDE(CAM_INTF_PARM_ASD_ENABLE,                   int32_t,                     1);
-    INCLUDE(CAM_INTF_PARM_RECORDING_HINT,               int32_t,                     1);
-    INCLUDE(CAM_INTF_PARM_HDR,                          cam_exp_bracketing_t,        1);
-    INCLUDE(CAM_INTF_PARM_FRAMESKIP,                    int32_t,                     1);
-    INCLUDE(CAM_INTF_PARM_ZSL_MODE,                     int32_t,                     1);
-    INCLUDE(CAM_INTF_PARM_HDR_NEED_1X,                  int32_t,                     1);
-    INCLUDE(CAM_INTF_PARM_LOCK_CAF,                     int32_t,                     1);
-    INCLUDE(CAM_INTF_PARM_VIDEO_HDR,                    int32_t,                     1);
-    INCLUDE(CAM_INTF_PARM_VT,                           int32_t,                     1);
-    INCLUDE(CAM_INTF_PARM_GET_CHROMATIX,                tune_chromatix_t,            1);
-    INCLUDE(CAM_INTF_PARM_SET_RELOAD_CHROMATIX,         tune_chromatix_t,            1);
-    INCLUDE(CAM_INTF_PARM_GET_AFTUNE,                   tune_autofocus_t,            1);
-    INCLUDE(CAM_INTF_PARM_SET_RELOAD_AFTUNE,            tune_autofocus_t,            1);
-    INCLUDE(CAM_INTF_PARM_SET_AUTOFOCUSTUNING,          tune_actuator_t,             1);
-    INCLUDE(CAM_INTF_PARM_SET_VFE_COMMAND,              tune_cmd_t,                  1);
-    INCLUDE(CAM_INTF_PARM_SET_PP_COMMAND,               tune_cmd_t,                  1);
-    INCLUDE(CAM_INTF_PARM_MAX_DIMENSION,                cam_dimension_t,             1);
-    INCLUDE(CAM_INTF_PARM_RAW_DIMENSION,                cam_dimension_t,             1);
-    INCLUDE(CAM_INTF_PARM_TINTLESS,                     int32_t,                     1);
-    INCLUDE(CAM_INTF_PARM_CDS_MODE,                     cam_cds_mode_type_t,         1);
-    INCLUDE(CAM_INTF_PARM_EZTUNE_CMD,                   cam_eztune_cmd_data_t,       1);
-    INCLUDE(CAM_INTF_PARM_RDI_MODE,                     int32_t,                     1);
-    INCLUDE(CAM_INTF_PARM_BURST_NUM,                    uint32_t,                    1);
-    INCLUDE(CAM_INTF_PARM_RETRO_BURST_NUM,              uint32_t,                    1);
-    INCLUDE(CAM_INTF_PARM_BURST_LED_ON_PERIOD,          uint32_t,                    1);
-    INCLUDE(CAM_INTF_PARM_LONGSHOT_ENABLE,              int8_t,                      1);
-
-    /* HAL3 specific */
-    INCLUDE(CAM_INTF_META_STREAM_INFO,                  cam_stream_size_info_t,      1);
-    INCLUDE(CAM_INTF_META_AEC_MODE,                     uint32_t,                    1);
-    INCLUDE(CAM_INTF_META_AEC_PRECAPTURE_TRIGGER,       cam_trigger_t,               1);
-    INCLUDE(CAM_INTF_META_AF_TRIGGER,                   cam_trigger_t,               1);
-    INCLUDE(CAM_INTF_META_CAPTURE_INTENT,               uint32_t,                    1);
-    INCLUDE(CAM_INTF_META_DEMOSAIC,                     int32_t,                     1);
-    INCLUDE(CAM_INTF_META_SHARPNESS_STRENGTH,           int32_t,                     1);
-    INCLUDE(CAM_INTF_META_GEOMETRIC_MODE,               uint32_t,                    1);
-    INCLUDE(CAM_INTF_META_GEOMETRIC_STRENGTH,           uint32_t,                    1);
-    INCLUDE(CAM_INTF_META_LENS_SHADING_MAP_MODE,        uint32_t,                    1);
-    INCLUDE(CAM_INTF_META_SHADING_STRENGTH,             uint32_t,                    1);
-    INCLUDE(CAM_INTF_META_TONEMAP_MODE,                 uint32_t,                    1);
-    INCLUDE(CAM_INTF_META_STREAM_ID,                    cam_stream_ID_t,             1);
-    INCLUDE(CAM_INTF_PARM_STATS_DEBUG_MASK,             uint32_t,                    1);
-    INCLUDE(CAM_INTF_PARM_STATS_AF_PAAF,                uint32_t,                    1);
-    INCLUDE(CAM_INTF_PARM_FOCUS_BRACKETING,             cam_af_bracketing_t,         1);
-    INCLUDE(CAM_INTF_PARM_FLASH_BRACKETING,             cam_flash_bracketing_t,      1);
+#define CAM_INTF_PARM_DATA_TABLE(ENTRY, NO_ID_ENTRY)                                       \
+    /* common between HAL1 and HAL3 */                                                     \
+    ENTRY(CAM_INTF_META_HISTOGRAM,                    cam_hist_stats_t,               1)   \
+    ENTRY(CAM_INTF_META_FACE_DETECTION,               cam_face_detection_data_t,      1)   \
+    ENTRY(CAM_INTF_META_AUTOFOCUS_DATA,               cam_auto_focus_data_t,          1)   \
+                                                                                           \
+    /* Specific to HAl1 */                                                                 \
+    ENTRY(CAM_INTF_META_CROP_DATA,                    cam_crop_data_t,                1)   \
+    ENTRY(CAM_INTF_META_PREP_SNAPSHOT_DONE,           int32_t,                        1)   \
+    ENTRY(CAM_INTF_META_GOOD_FRAME_IDX_RANGE,         cam_frame_idx_range_t,          1)   \
+    ENTRY(CAM_INTF_META_ASD_HDR_SCENE_DATA,           cam_asd_hdr_scene_data_t,       1)   \
+    ENTRY(CAM_INTF_META_ASD_SCENE_TYPE,               int32_t,                        1)   \
+    ENTRY(CAM_INTF_META_CURRENT_SCENE,                cam_scene_mode_type,            1)   \
+    ENTRY(CAM_INTF_META_CHROMATIX_LITE_ISP,           cam_chromatix_lite_isp_t,       1)   \
+    ENTRY(CAM_INTF_META_CHROMATIX_LITE_PP,            cam_chromatix_lite_pp_t,        1)   \
+    ENTRY(CAM_INTF_META_CHROMATIX_LITE_AE,            cam_chromatix_lite_ae_stats_t,  1)   \
+    ENTRY(CAM_INTF_META_CHROMATIX_LITE_AWB,           cam_chromatix_lite_awb_stats_t, 1)   \
+    ENTRY(CAM_INTF_META_CHROMATIX_LITE_AF,            cam_chromatix_lite_af_stats_t,  1)   \
+    ENTRY(CAM_INTF_META_CHROMATIX_LITE_ASD,           cam_chromatix_lite_asd_stats_t, 1)   \
+                                                                                           \
+    /* Specific to HAL3 */                                                                 \
+    ENTRY(CAM_INTF_META_FRAME_NUMBER_VALID,           int32_t,                     1)      \
+    ENTRY(CAM_INTF_META_URGENT_FRAME_NUMBER_VALID,    int32_t,                     1)      \
+    ENTRY(CAM_INTF_META_FRAME_DROPPED,                cam_frame_dropped_t,         1)      \
+    ENTRY(CAM_INTF_META_PENDING_REQUESTS,             uint32_t,                    1)      \
+    ENTRY(CAM_INTF_META_FRAME_NUMBER,                 uint32_t,                    1)      \
+    ENTRY(CAM_INTF_META_URGENT_FRAME_NUMBER,          uint32_t,                    1)      \
+    ENTRY(CAM_INTF_META_COLOR_CORRECT_MODE,           uint32_t,                    1)      \
+    ENTRY(CAM_INTF_META_COLOR_CORRECT_TRANSFORM,      cam_color_correct_matrix_t,  1)      \
+    ENTRY(CAM_INTF_META_COLOR_CORRECT_GAINS,          cam_color_correct_gains_t,   1)      \
+    ENTRY(CAM_INTF_META_PRED_COLOR_CORRECT_TRANSFORM, cam_color_correct_matrix_t,  1)      \
+    ENTRY(CAM_INTF_META_PRED_COLOR_CORRECT_GAINS,     cam_color_correct_gains_t,   1)      \
+    ENTRY(CAM_INTF_META_AEC_ROI,                      cam_area_t,                  1)      \
+    ENTRY(CAM_INTF_META_AEC_STATE,                    uint32_t,                    1)      \
+    ENTRY(CAM_INTF_PARM_FOCUS_MODE,                   uint32_t,                    1)      \
+    ENTRY(CAM_INTF_META_AF_ROI,                       cam_area_t,                  1)      \
+    ENTRY(CAM_INTF_META_AF_STATE,                     uint32_t,                    1)      \
+    ENTRY(CAM_INTF_PARM_WHITE_BALANCE,                int32_t,                     1)      \
+    ENTRY(CAM_INTF_META_AWB_REGIONS,                  cam_area_t,                  1)      \
+    ENTRY(CAM_INTF_META_AWB_STATE,                    uint32_t,                    1)      \
+    ENTRY(CAM_INTF_META_BLACK_LEVEL_LOCK,             uint32_t,                    1)      \
+    ENTRY(CAM_INTF_META_MODE,                         uint32_t,                    1)      \
+    ENTRY(CAM_INTF_META_EDGE_MODE,                    cam_edge_application_t,      1)      \
+    ENTRY(CAM_INTF_META_FLASH_POWER,                  uint32_t,                    1)      \
+    ENTRY(CAM_INTF_META_FLASH_FIRING_TIME,            int64_t,                     1)      \
+    ENTRY(CAM_INTF_META_FLASH_MODE,                   uint32_t,                    1)      \
+    ENTRY(CAM_INTF_META_FLASH_STATE,                  int32_t,                     1)      \
+    ENTRY(CAM_INTF_META_HOTPIXEL_MODE,                uint32_t,                    1)      \
+    ENTRY(CAM_INTF_META_LENS_APERTURE,                float,                       1)      \
+    ENTRY(CAM_INTF_META_LENS_FILTERDENSITY,           float,                       1)      \
+    ENTRY(CAM_INTF_META_LENS_FOCAL_LENGTH,            float,                       1)      \
+    ENTRY(CAM_INTF_META_LENS_FOCUS_DISTANCE,          float,                       1)      \
+    ENTRY(CAM_INTF_META_LENS_FOCUS_RANGE,             float,                       2)      \
+    ENTRY(CAM_INTF_META_LENS_STATE,                   cam_af_lens_state_t,         1)      \
+    ENTRY(CAM_INTF_META_LENS_OPT_STAB_MODE,           uint32_t,                    1)      \
+    /* No cam_intf_parm_type_t id, kept for buffer layout */                               \
+    NO_ID_ENTRY(CAM_INTF_META_LENS_FOCUS_STATE,       uint32_t,                    1)      \
+    ENTRY(CAM_INTF_META_NOISE_REDUCTION_MODE,         uint32_t,                    1)      \
+    ENTRY(CAM_INTF_META_NOISE_REDUCTION_STRENGTH,     uint32_t,                    1)      \
+    ENTRY(CAM_INTF_META_SCALER_CROP_REGION,           cam_crop_region_t,           1)      \
+    ENTRY(CAM_INTF_META_SCENE_FLICKER,                uint32_t,                    1)      \
+    ENTRY(CAM_INTF_META_SENSOR_EXPOSURE_TIME,         int64_t,                     1)      \
+    ENTRY(CAM_INTF_META_SENSOR_FRAME_DURATION,        int64_t,                     1)      \
+    ENTRY(CAM_INTF_META_SENSOR_SENSITIVITY,           int32_t,                     1)      \
+    ENTRY(CAM_INTF_META_SENSOR_TIMESTAMP,             int64_t,                     1)      \
+    ENTRY(CAM_INTF_META_SHADING_MODE,                 uint32_t,                    1)      \
+    ENTRY(CAM_INTF_META_STATS_FACEDETECT_MODE,        uint32_t,                    1)      \
+    ENTRY(CAM_INTF_META_STATS_HISTOGRAM_MODE,         uint32_t,                    1)      \
+    ENTRY(CAM_INTF_META_STATS_SHARPNESS_MAP_MODE,     uint32_t,                    1)      \
+    ENTRY(CAM_INTF_META_STATS_SHARPNESS_MAP,          cam_sharpness_map_t,         3)      \
+    ENTRY(CAM_INTF_META_TONEMAP_CURVES,               cam_rgb_tonemap_curves,      1)      \
+    ENTRY(CAM_INTF_META_LENS_SHADING_MAP,             cam_lens_shading_map_t,      1)      \
+    ENTRY(CAM_INTF_META_AEC_INFO,                     cam_3a_params_t,             1)      \
+    ENTRY(CAM_INTF_META_SENSOR_INFO,                  cam_sensor_params_t,         1)      \
+    ENTRY(CAM_INTF_META_ASD_SCENE_CAPTURE_TYPE,       cam_auto_scene_t,            1)      \
+    ENTRY(CAM_INTF_PARM_EFFECT,                       uint32_t,                    1)      \
+    /* Defining as int32_t so that this array is 4 byte aligned */                         \
+    ENTRY(CAM_INTF_META_PRIVATE_DATA,                 int32_t,                             \
+            MAX_METADATA_PRIVATE_PAYLOAD_SIZE_IN_BYTES / 4)                                \
+                                                                                           \
+    /* Following are Params only and not metadata currently */                             \
+    ENTRY(CAM_INTF_PARM_HAL_VERSION,                  int32_t,                     1)      \
+    /* Shared between HAL1 and HAL3 */                                                     \
+    ENTRY(CAM_INTF_PARM_ANTIBANDING,                  uint32_t,                    1)      \
+    ENTRY(CAM_INTF_PARM_EXPOSURE_COMPENSATION,        int32_t,                     1)      \
+    ENTRY(CAM_INTF_PARM_AEC_LOCK,                     uint32_t,                    1)      \
+    ENTRY(CAM_INTF_PARM_FPS_RANGE,                    cam_fps_range_t,             1)      \
+    ENTRY(CAM_INTF_PARM_AWB_LOCK,                     uint32_t,                    1)      \
+    ENTRY(CAM_INTF_PARM_BESTSHOT_MODE,                uint32_t,                    1)      \
+    ENTRY(CAM_INTF_PARM_DIS_ENABLE,                   int32_t,                     1)      \
+    ENTRY(CAM_INTF_PARM_LED_MODE,                     int32_t,                     1)      \
+                                                                                           \
+    /* HAL1 specific */                                                                    \
+    /* read only */                                                                        \
+    ENTRY(CAM_INTF_PARM_QUERY_FLASH4SNAP,             int32_t,                     1)      \
+    ENTRY(CAM_INTF_PARM_EXPOSURE,                     int32_t,                     1)      \
+    ENTRY(CAM_INTF_PARM_SHARPNESS,                    int32_t,                     1)      \
+    ENTRY(CAM_INTF_PARM_CONTRAST,                     int32_t,                     1)      \
+    ENTRY(CAM_INTF_PARM_SATURATION,                   int32_t,                     1)      \
+    ENTRY(CAM_INTF_PARM_BRIGHTNESS,                   int32_t,                     1)      \
+    ENTRY(CAM_INTF_PARM_ISO,                          int32_t,                     1)      \
+    ENTRY(CAM_INTF_PARM_ZOOM,                         int32_t,                     1)      \
+    ENTRY(CAM_INTF_PARM_ROLLOFF,                      int32_t,                     1)      \
+    ENTRY(CAM_INTF_PARM_MODE,                         int32_t,                     1)      \
+    ENTRY(CAM_INTF_PARM_AEC_ALGO_TYPE,                int32_t,                     1)      \
+    ENTRY(CAM_INTF_PARM_FOCUS_ALGO_TYPE,              int32_t,                     1)      \
+    ENTRY(CAM_INTF_PARM_AEC_ROI,                      cam_set_aec_roi_t,           1)      \
+    ENTRY(CAM_INTF_PARM_AF_ROI,                       cam_roi_info_t,              1)      \
+    ENTRY(CAM_INTF_PARM_SCE_FACTOR,                   int32_t,                     1)      \
+    ENTRY(CAM_INTF_PARM_FD,                           cam_fd_set_parm_t,           1)      \
+    ENTRY(CAM_INTF_PARM_MCE,                          int32_t,                     1)      \
+    ENTRY(CAM_INTF_PARM_HFR,                          int32_t,                     1)      \
+    ENTRY(CAM_INTF_PARM_REDEYE_REDUCTION,             int32_t,                     1)      \
+    ENTRY(CAM_INTF_PARM_WAVELET_DENOISE,              cam_denoise_param_t,         1)      \
+    ENTRY(CAM_INTF_PARM_HISTOGRAM,                    int32_t,                     1)      \
+    ENTRY(CAM_INTF_PARM_ASD_ENABLE,                   int32_t,                     1)      \
+    ENTRY(CAM_INTF_PARM_RECORDING_HINT,               int32_t,                     1)      \
+    ENTRY(CAM_INTF_PARM_HDR,                          cam_exp_bracketing_t,        1)      \
+    ENTRY(CAM_INTF_PARM_FRAMESKIP,                    int32_t,                     1)      \
+    ENTRY(CAM_INTF_PARM_ZSL_MODE,                     int32_t,                     1)      \
+    ENTRY(CAM_INTF_PARM_HDR_NEED_1X,                  int32_t,                     1)      \
+    ENTRY(CAM_INTF_PARM_LOCK_CAF,                     int32_t,                     1)      \
+    ENTRY(CAM_INTF_PARM_VIDEO_HDR,                    int32_t,                     1)      \
+    ENTRY(CAM_INTF_PARM_VT,                           int32_t,                     1)      \
+    ENTRY(CAM_INTF_PARM_GET_CHROMATIX,                tune_chromatix_t,            1)      \
+    ENTRY(CAM_INTF_PARM_SET_RELOAD_CHROMATIX,         tune_chromatix_t,            1)      \
+    ENTRY(CAM_INTF_PARM_GET_AFTUNE,                   tune_autofocus_t,            1)      \
+    ENTRY(CAM_INTF_PARM_SET_RELOAD_AFTUNE,            tune_autofocus_t,            1)      \
+    ENTRY(CAM_INTF_PARM_SET_AUTOFOCUSTUNING,          tune_actuator_t,             1)      \
+    ENTRY(CAM_INTF_PARM_SET_VFE_COMMAND,              tune_cmd_t,                  1)      \
+    ENTRY(CAM_INTF_PARM_SET_PP_COMMAND,               tune_cmd_t,                  1)      \
+    ENTRY(CAM_INTF_PARM_MAX_DIMENSION,                cam_dimension_t,             1)      \
+    ENTRY(CAM_INTF_PARM_RAW_DIMENSION,                cam_dimension_t,             1)      \
+    ENTRY(CAM_INTF_PARM_TINTLESS,                     int32_t,                     1)      \
+    ENTRY(CAM_INTF_PARM_CDS_MODE,                     cam_cds_mode_type_t,         1)      \
+    ENTRY(CAM_INTF_PARM_EZTUNE_CMD,                   cam_eztune_cmd_data_t,       1)      \
+    ENTRY(CAM_INTF_PARM_RDI_MODE,                     int32_t,                     1)      \
+    ENTRY(CAM_INTF_PARM_BURST_NUM,                    uint32_t,                    1)      \
+    ENTRY(CAM_INTF_PARM_RETRO_BURST_NUM,              uint32_t,                    1)      \
+    ENTRY(CAM_INTF_PARM_BURST_LED_ON_PERIOD,          uint32_t,                    1)      \
+    ENTRY(CAM_INTF_PARM_LONGSHOT_ENABLE,              int8_t,                      1)      \
+                                                                                           \
+    /* HAL3 specific */                                                                    \
+    ENTRY(CAM_INTF_META_STREAM_INFO,                  cam_stream_size_info_t,      1)      \
+    ENTRY(CAM_INTF_META_AEC_MODE,                     uint32_t,                    1)      \
+    ENTRY(CAM_INTF_META_AEC_PRECAPTURE_TRIGGER,       cam_trigger_t,               1)      \
+    ENTRY(CAM_INTF_META_AF_TRIGGER,                   cam_trigger_t,               1)      \
+    ENTRY(CAM_INTF_META_CAPTURE_INTENT,               uint32_t,                    1)      \
+    ENTRY(CAM_INTF_META_DEMOSAIC,                     int32_t,                     1)      \
+    ENTRY(CAM_INTF_META_SHARPNESS_STRENGTH,           int32_t,                     1)      \
+    ENTRY(CAM_INTF_META_GEOMETRIC_MODE,               uint32_t,                    1)      \
+    ENTRY(CAM_INTF_META_GEOMETRIC_STRENGTH,           uint32_t,                    1)      \
+    ENTRY(CAM_INTF_META_LENS_SHADING_MAP_MODE,        uint32_t,                    1)      \
+    ENTRY(CAM_INTF_META_SHADING_STRENGTH,             uint32_t,                    1)      \
+    ENTRY(CAM_INTF_META_TONEMAP_MODE,                 uint32_t,                    1)      \
+    ENTRY(CAM_INTF_META_STREAM_ID,                    cam_stream_ID_t,             1)      \
+    ENTRY(CAM_INTF_PARM_STATS_DEBUG_MASK,             uint32_t,                    1)      \
+    ENTRY(CAM_INTF_PARM_STATS_AF_PAAF,                uint32_t,                    1)      \
+    ENTRY(CAM_INTF_PARM_FOCUS_BRACKETING,             cam_af_bracketing_t,         1)      \
+    ENTRY(CAM_INTF_PARM_FLASH_BRACKETING,             cam_flash_bracketing_t,      1)
+
+typedef struct {
+    CAM_INTF_PARM_DATA_TABLE(INCLUDE, INCLUDE)
 } parm_data_t;
 
 typedef parm_data_t metadata_data_t;
 
+/*****************************************************************************
+ *                 Code for Delta Encoded Parameter Batches                  *
+ ****************************************************************************/
+/* Payload of every delta entry is padded to this alignment */
+#define CAM_PARM_DELTA_ALIGN 4
+
+#define CAM_PARM_DELTA_PAD(LEN) \
+        (((LEN) + CAM_PARM_DELTA_ALIGN - 1) & ~(CAM_PARM_DELTA_ALIGN - 1))
+
+/* Largest delta sent in one socket packet, bigger batches go through
+ * the flat parm buffer */
+#define CAM_PARM_DELTA_MAX_SIZE 32768
+
+/* Header of one TLV entry, followed by CAM_PARM_DELTA_PAD(length) bytes
+ * of payload. A zero length entry is a get request for that param. */
+typedef struct {
+    uint32_t param_id;                  /* cam_intf_parm_type_t */
+    uint32_t length;                    /* payload length in bytes */
+} cam_parm_delta_entry_t;
+
+/* Delta batch carrying only the entries changed in one request */
+typedef struct {
+    uint8_t *data;                      /* caller owned TLV storage */
+    uint32_t capacity;                  /* size of data in bytes */
+    uint32_t size;                      /* bytes used in data */
+    uint32_t num_entries;               /* number of TLV entries */
+} cam_parm_delta_t;
+
+/* Packet of CAM_MAPPING_TYPE_PARM_DELTA, only the header and the first
+ * size bytes of data go on the socket */
+typedef struct {
+    cam_mapping_type msg_type;
+    uint32_t size;                      /* bytes used in data */
+    uint32_t num_entries;               /* number of TLV entries */
+    uint8_t data[CAM_PARM_DELTA_MAX_SIZE];
+} cam_sock_parm_delta_packet_t;
+
+#define CAM_PARM_DELTA_PACKET_SIZE(SIZE) \
+        (offsetof(cam_sock_parm_delta_packet_t, data) + (SIZE))
+
+/* Per request dirty tracking of a parm_buffer_t batch */
+typedef struct {
+    uint8_t primed;                     /* table fully cleared once */
+    uint32_t num_entries;               /* number of dirty params */
+    uint16_t ids[CAM_INTF_PARM_MAX];    /* dirty params in set order */
+    uint8_t dirty[CAM_INTF_PARM_MAX];   /* per param dirty flag */
+    uint32_t length[CAM_INTF_PARM_MAX]; /* bytes set per param */
+} cam_parm_dirty_t;
+
+/*****************************************************************************
+ *                 Code for Sparse Metadata Iteration                        *
+ ****************************************************************************/
+#define CAM_INTF_VALID_MAP_WORDS ((CAM_INTF_PARM_MAX + 31) / 32)
+
+/* Packed copy of the is_valid table, one bit per param id */
+typedef struct {
+    uint32_t bits[CAM_INTF_VALID_MAP_WORDS];
+} cam_intf_valid_map_t;
+
+/* Iterator visiting the param ids set in a cam_intf_valid_map_t */
+typedef struct {
+    const cam_intf_valid_map_t *map;
+    uint32_t word;                      /* index of current word */
+    uint32_t pending;                   /* bits of word not visited yet */
+} cam_intf_valid_iter_t;
+
 /****************************DO NOT MODIFY BELOW THIS LINE!!!!*********************/
 
 typedef struct {
@@ -629,6 +716,51 @@ void *get_pointer_of(cam_intf_parm_type_t meta_id,
 
 uint32_t get_size_of(cam_intf_parm_type_t param_id);
 
+void cam_parm_batch_init(parm_buffer_t *p_table, cam_parm_dirty_t *dirty);
+
+int32_t cam_parm_batch_add(parm_buffer_t *p_table, cam_parm_dirty_t *dirty,
+        cam_intf_parm_type_t param_id, uint32_t length, const void *value);
+
+int32_t cam_parm_batch_add_get(parm_buffer_t *p_table,
+        cam_parm_dirty_t *dirty, cam_intf_parm_type_t param_id);
+
+uint32_t cam_parm_dirty_size(const cam_parm_dirty_t *dirty);
+
+uint32_t cam_parm_delta_size(const cam_parm_dirty_t *dirty);
+
+int32_t cam_parm_delta_encode(const parm_buffer_t *p_table,
+        const cam_parm_dirty_t *dirty, cam_parm_delta_t *delta);
+
+int32_t cam_parm_delta_decode(const cam_parm_delta_t *delta,
+        parm_buffer_t *p_table);
+
+uint32_t cam_intf_build_valid_map(const metadata_buffer_t *metadata,
+        cam_intf_valid_map_t *map);
+
+static inline void cam_intf_valid_iter_init(cam_intf_valid_iter_t *iter,
+        const cam_intf_valid_map_t *map)
+{
+    iter->map = map;
+    iter->word = 0;
+    iter->pending = map->bits[0];
+}
+
+/* Returns 1 and the next present param id, 0 once all were visited */
+static inline int cam_intf_valid_iter_next(cam_intf_valid_iter_t *iter,
+        cam_intf_parm_type_t *meta_id)
+{
+    while (iter->pending == 0) {
+        if (++iter->word >= CAM_INTF_VALID_MAP_WORDS) {
+            return 0;
+        }
+        iter->pending = iter->map->bits[iter->word];
+    }
+    *meta_id = (cam_intf_parm_type_t)
+        (iter->word * 32 + (uint32_t)__builtin_ctz(iter->pending));
+    iter->pending &= iter->pending - 1;
+    return 1;
+}
+
 #ifdef  __cplusplus
 }
 #endif
@@ -293,9 +293,26 @@ typedef struct {
     uint32_t cookie;      /* could be job_id(uint32_t) to identify unmapping job */
 } cam_buf_unmap_type;
 
+/* most mappings carried by one bundled message, fds travel in the
+ * same order as the entries */
+#define CAM_MAX_NUM_BUFS_PER_MAP CAM_MAX_NUM_BUFS_PER_STREAM
+
+typedef struct {
+    uint32_t length;      /* number of valid entries */
+    cam_buf_map_type buf_maps[CAM_MAX_NUM_BUFS_PER_MAP];
+} cam_buf_map_type_list;
+
+typedef struct {
+    uint32_t length;      /* number of valid entries */
+    cam_buf_unmap_type buf_unmaps[CAM_MAX_NUM_BUFS_PER_MAP];
+} cam_buf_unmap_type_list;
+
 typedef enum {
     CAM_MAPPING_TYPE_FD_MAPPING,
     CAM_MAPPING_TYPE_FD_UNMAPPING,
+    CAM_MAPPING_TYPE_FD_BUNDLED_MAPPING,   /* one MAP_UNMAP_DONE for the list */
+    CAM_MAPPING_TYPE_FD_BUNDLED_UNMAPPING, /* one MAP_UNMAP_DONE for the list */
+    CAM_MAPPING_TYPE_PARM_DELTA,           /* delta parm batch, no fd */
     CAM_MAPPING_TYPE_MAX
 } cam_mapping_type;
 
@@ -307,6 +324,16 @@ typedef struct {
     } payload;
 } cam_sock_packet_t;
 
+/* packet of CAM_MAPPING_TYPE_FD_BUNDLED_MAPPING/UNMAPPING, kept apart from
+ * cam_sock_packet_t so single mappings keep their size on the socket */
+typedef struct {
+    cam_mapping_type msg_type;
+    union {
+        cam_buf_map_type_list buf_map_list;
+        cam_buf_unmap_type_list buf_unmap_list;
+    } payload;
+} cam_sock_bundled_packet_t;
+
 typedef enum {
     CAM_MODE_2D = (1<<0),
     CAM_MODE_3D = (1<<1)
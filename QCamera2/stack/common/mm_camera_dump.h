@@ -0,0 +1,77 @@
+/* Copyright (c) 2014, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef __MM_CAMERA_DUMP_H__
+#define __MM_CAMERA_DUMP_H__
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Asynchronous frame dump. The caller thread only gathers the plane rows
+ * into a staging buffer, a background writer thread does the file I/O.
+ * Frames are dropped and counted when all staging buffers are in use or
+ * the staging memory budget is exhausted. */
+
+#define MM_CAMERA_DUMP_MAX_PATH     256
+#define MM_CAMERA_DUMP_MAX_PLANES   8
+/* frames that can be queued to the writer at the same time */
+#define MM_CAMERA_DUMP_MAX_JOBS     4
+/* staging memory kept across all queued frames */
+#define MM_CAMERA_DUMP_BUDGET       (64 * 1024 * 1024)
+
+typedef struct {
+    const void *base;   /* address of the first row */
+    size_t width;       /* bytes written per row */
+    size_t stride;      /* bytes between rows in the source */
+    size_t height;      /* number of rows */
+} mm_camera_dump_plane_t;
+
+typedef struct {
+    uint32_t queued;        /* frames accepted */
+    uint32_t written;       /* frames written to file */
+    uint32_t dropped;       /* frames dropped on overflow */
+    uint32_t failed;        /* frames that failed to open or write */
+    uint64_t bytes_written; /* total bytes written */
+} mm_camera_dump_stats_t;
+
+int32_t mm_camera_dump_frame(const char *path,
+                             const mm_camera_dump_plane_t *planes,
+                             uint32_t num_planes);
+void mm_camera_dump_flush(void);
+void mm_camera_dump_get_stats(mm_camera_dump_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __MM_CAMERA_DUMP_H__ */
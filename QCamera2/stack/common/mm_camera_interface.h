@@ -184,16 +184,43 @@ typedef int32_t (*unmap_stream_buf_op_t) (uint32_t frame_idx,
                                           int32_t plane_idx,
                                           void *userdata);
 
+/** bundled_map_stream_buf_op_t: function definition for operation
+*                                of mapping several stream buffers
+*                                via domain socket in one message
+*    @buf_map_list : list of buffers to map, the stream_id field
+*                    is filled in by mm-camera-interface
+*    @userdata : user data pointer
+**/
+typedef int32_t (*bundled_map_stream_buf_op_t) (
+        cam_buf_map_type_list *buf_map_list,
+        void *userdata);
+
+/** bundled_unmap_stream_buf_op_t: function definition for
+*                                  operation of unmapping several
+*                                  stream buffers via domain socket
+*                                  in one message
+*    @buf_unmap_list : list of buffers to unmap, the stream_id
+*                      field is filled in by mm-camera-interface
+*    @userdata : user data pointer
+**/
+typedef int32_t (*bundled_unmap_stream_buf_op_t) (
+        cam_buf_unmap_type_list *buf_unmap_list,
+        void *userdata);
+
 /** mm_camera_map_unmap_ops_tbl_t: virtual table
 *                      for mapping/unmapping stream buffers via
 *                      domain socket
 *    @map_ops : operation for mapping
 *    @unmap_ops : operation for unmapping
+*    @bundled_map_ops : operation for mapping a list of buffers
+*    @bundled_unmap_ops : operation for unmapping a list of buffers
 *    @userdata: user data pointer
 **/
 typedef struct {
     map_stream_buf_op_t map_ops;
     unmap_stream_buf_op_t unmap_ops;
+    bundled_map_stream_buf_op_t bundled_map_ops;
+    bundled_unmap_stream_buf_op_t bundled_unmap_ops;
     void *userdata;
 } mm_camera_map_unmap_ops_tbl_t;
 
@@ -380,6 +407,23 @@ typedef struct {
     int32_t (*set_parms) (uint32_t camera_handle,
                           parm_buffer_t *parms);
 
+    /** set_parms_delta: fucntion definition for setting camera
+     *             based parameters to server, sending only the
+     *             entries changed in the batch
+     *    @camera_handle : camer handler
+     *    @parms : batch for parameters to be set, stored in
+     *               parm_buffer_t
+     *    @dirty : dirty tracker of the batch in parms
+     *  Return value: 0 -- success
+     *                -1 -- failure
+     *  Note: same as set_parms when the server does not handle
+     *       delta batches (persist.camera.parm_delta unset) or the
+     *       delta is larger than CAM_PARM_DELTA_MAX_SIZE
+     **/
+    int32_t (*set_parms_delta) (uint32_t camera_handle,
+                                parm_buffer_t *parms,
+                                const cam_parm_dirty_t *dirty);
+
     /** get_parms: fucntion definition for querying camera
      *             based parameters from server
      *    @camera_handle : camer handler
@@ -559,6 +603,34 @@ typedef struct {
                                  uint32_t buf_idx,
                                  int32_t plane_idx);
 
+    /** map_stream_bufs: fucntion definition for mapping a list of
+     *                 stream buffers via domain socket with one
+     *                 message and one completion event
+     *    @camera_handle : camer handler
+     *    @ch_id : channel handler
+     *    @buf_map_list : buffers to be mapped, stream_id of each
+     *               entry is the stream handler
+     *  Return value: 0 -- success
+     *                -1 -- failure
+     **/
+    int32_t (*map_stream_bufs) (uint32_t camera_handle,
+                                uint32_t ch_id,
+                                const cam_buf_map_type_list *buf_map_list);
+
+    /** unmap_stream_bufs: fucntion definition for unmapping a list
+     *                 of stream buffers via domain socket with one
+     *                 message and one completion event
+     *    @camera_handle : camer handler
+     *    @ch_id : channel handler
+     *    @buf_unmap_list : buffers to be unmapped, stream_id of each
+     *               entry is the stream handler
+     *  Return value: 0 -- success
+     *                -1 -- failure
+     **/
+    int32_t (*unmap_stream_bufs) (uint32_t camera_handle,
+                                  uint32_t ch_id,
+                                  const cam_buf_unmap_type_list *buf_unmap_list);
+
     /** set_stream_parms: fucntion definition for setting stream
      *                    specific parameters to server
      *    @camera_handle : camer handler
@@ -739,4 +811,6 @@ int32_t mm_stream_calc_offset_postproc(cam_stream_info_t *stream_info,
         cam_stream_buf_plane_info_t *buf_planes);
 
 struct camera_info *get_cam_info(uint32_t camera_id);
+
+const char *get_cam_sensor_name(uint32_t camera_id);
 #endif /*__MM_CAMERA_INTERFACE_H__*/
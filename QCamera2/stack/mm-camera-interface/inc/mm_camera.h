@@ -141,6 +141,7 @@ typedef struct {
     mm_camera_poll_notify_t notify_cb;
     uint32_t handler;
     void* user_data;
+    uint32_t gen; /* bumped on every add/del to drop stale events */
 } mm_camera_poll_entry_t;
 
 typedef struct {
@@ -150,12 +151,14 @@ typedef struct {
      * for MM_CAMERA_POLL_TYPE_DATA, depends on valid stream fd */
     mm_camera_poll_entry_t poll_entries[MAX_STREAM_NUM_IN_BUNDLE];
     int32_t pfds[2];
+    int32_t epoll_fd; /* level triggered, notify_cb handles one buf per call */
     pthread_t pid;
     int32_t state;
     int timeoutms;
     uint32_t cmd;
-    struct pollfd poll_fds[MAX_STREAM_NUM_IN_BUNDLE + 1];
-    uint8_t num_fds;
+    /* entry whose notify_cb is running, -1 if none */
+    int32_t dispatch_idx;
+    int32_t dispatch_waiters;
     pthread_mutex_t mutex;
     pthread_cond_t cond_v;
     int32_t status;
@@ -279,6 +282,8 @@ typedef enum {
     MM_CHANNEL_EVT_STOP_ZSL_SNAPSHOT,
     MM_CHANNEL_EVT_MAP_STREAM_BUF,
     MM_CHANNEL_EVT_UNMAP_STREAM_BUF,
+    MM_CHANNEL_EVT_MAP_STREAM_BUFS,
+    MM_CHANNEL_EVT_UNMAP_STREAM_BUFS,
     MM_CHANNEL_EVT_SET_STREAM_PARM,
     MM_CHANNEL_EVT_GET_STREAM_PARM,
     MM_CHANNEL_EVT_DO_STREAM_ACTION,
@@ -320,11 +325,18 @@ typedef struct {
     int32_t plane_idx;
 } mm_evt_paylod_unmap_stream_buf_t;
 
-typedef struct {
+/* number of buckets in the unmatched superbuf index, must be power of 2 */
+#define MM_CHANNEL_SUPERBUF_HASH_SIZE 32
+
+typedef struct mm_channel_queue_node {
     uint8_t num_of_bufs;
     mm_camera_buf_info_t super_buf[MAX_STREAM_NUM_IN_BUNDLE];
     uint8_t matched;
     uint32_t frame_idx;
+    /* bookkeeping for the unmatched superbuf index */
+    cam_node_t *q_node; /* node holding this superbuf in the queue */
+    struct cam_list unmatched; /* link in the unmatched list */
+    struct mm_channel_queue_node *hash_next; /* next in the same bucket */
 } mm_channel_queue_node_t;
 
 typedef struct {
@@ -341,6 +353,11 @@ typedef struct {
     uint32_t led_on_num_frames;
     uint32_t once;
     uint32_t frame_skip_count;
+    /* unmatched superbufs hashed by frame_idx for O(1) matching */
+    mm_channel_queue_node_t *unmatched_hash[MM_CHANNEL_SUPERBUF_HASH_SIZE];
+    /* unmatched superbufs in frame_idx order, oldest first */
+    struct cam_list unmatched_list;
+    uint32_t unmatched_cnt;
 } mm_channel_queue_t;
 
 typedef struct {
@@ -436,11 +453,15 @@ typedef struct mm_camera_obj {
     mm_camera_event_t evt_rcvd;
 
     pthread_mutex_t msg_lock; /* lock for sending msg through socket */
+    uint8_t bundled_map; /* server handles bundled map/unmap packets */
+    uint8_t parm_delta; /* server handles delta parm batch packets */
+    cam_sock_parm_delta_packet_t parm_delta_packet; /* under cam_lock */
 } mm_camera_obj_t;
 
 typedef struct {
     int8_t num_cam;
     char video_dev_name[MM_CAMERA_MAX_NUM_SENSORS][MM_CAMERA_DEV_NAME_LEN];
+    char sensor_name[MM_CAMERA_MAX_NUM_SENSORS][MM_CAMERA_DEV_NAME_LEN];
     mm_camera_obj_t *cam_obj[MM_CAMERA_MAX_NUM_SENSORS];
     struct camera_info info[MM_CAMERA_MAX_NUM_SENSORS];
 } mm_camera_ctrl_t;
@@ -469,6 +490,11 @@ extern int32_t mm_camera_util_sendmsg(mm_camera_obj_t *my_obj,
                                       void *msg,
                                       size_t buf_size,
                                       int sendfd);
+extern int32_t mm_camera_util_bundled_sendmsg(mm_camera_obj_t *my_obj,
+                                              void *msg,
+                                              size_t buf_size,
+                                              int sendfds[CAM_MAX_NUM_BUFS_PER_MAP],
+                                              int numfds);
 /* Check if hardware target is A family */
 uint8_t mm_camera_util_chip_is_a_family(void);
 
@@ -484,6 +510,9 @@ extern int32_t mm_camera_qbuf(mm_camera_obj_t *my_obj,
 extern int32_t mm_camera_query_capability(mm_camera_obj_t *my_obj);
 extern int32_t mm_camera_set_parms(mm_camera_obj_t *my_obj,
                                    parm_buffer_t *parms);
+extern int32_t mm_camera_set_parms_delta(mm_camera_obj_t *my_obj,
+                                         parm_buffer_t *parms,
+                                         const cam_parm_dirty_t *dirty);
 extern int32_t mm_camera_get_parms(mm_camera_obj_t *my_obj,
                                    parm_buffer_t *parms);
 extern int32_t mm_camera_map_buf(mm_camera_obj_t *my_obj,
@@ -561,6 +590,12 @@ extern int32_t mm_camera_unmap_stream_buf(mm_camera_obj_t *my_obj,
                                           uint8_t buf_type,
                                           uint32_t buf_idx,
                                           int32_t plane_idx);
+extern int32_t mm_camera_map_stream_bufs(mm_camera_obj_t *my_obj,
+                                         uint32_t ch_id,
+                                         const cam_buf_map_type_list *buf_map_list);
+extern int32_t mm_camera_unmap_stream_bufs(mm_camera_obj_t *my_obj,
+                                           uint32_t ch_id,
+                                           const cam_buf_unmap_type_list *buf_unmap_list);
 extern int32_t mm_camera_do_stream_action(mm_camera_obj_t *my_obj,
                                           uint32_t ch_id,
                                           uint32_t stream_id,
@@ -603,6 +638,10 @@ extern int32_t mm_stream_unmap_buf(mm_stream_t *my_obj,
                                    uint8_t buf_type,
                                    uint32_t frame_idx,
                                    int32_t plane_idx);
+extern int32_t mm_stream_map_bufs(mm_stream_t *my_obj,
+                                  cam_buf_map_type_list *buf_map_list);
+extern int32_t mm_stream_unmap_bufs(mm_stream_t *my_obj,
+                                    cam_buf_unmap_type_list *buf_unmap_list);
 
 
 /* utiltity fucntion declared in mm-camera-inteface2.c
@@ -27,583 +27,396 @@
  *
  */
 
+#include <stddef.h>
+#include <string.h>
 #include "cam_intf.h"
 
+/* Offset and size of every parm_data_t entry, indexed by param id. Ids
+ * without an entry keep a zero size. */
+typedef struct {
+    uint32_t offset;
+    uint32_t size;
+} cam_intf_entry_info_t;
+
+#define CAM_INTF_ENTRY_INFO(PARAM_ID,DATATYPE,COUNT)                          \
+    [PARAM_ID] = {                                                            \
+        offsetof(metadata_buffer_t, data.member_variable_##PARAM_ID),         \
+        sizeof(DATATYPE) * (COUNT) },
+
+#define CAM_INTF_ENTRY_INFO_NONE(PARAM_ID,DATATYPE,COUNT)
+
+static const cam_intf_entry_info_t cam_intf_entry_info[CAM_INTF_PARM_MAX] = {
+    CAM_INTF_PARM_DATA_TABLE(CAM_INTF_ENTRY_INFO, CAM_INTF_ENTRY_INFO_NONE)
+};
+
 void *get_pointer_of(cam_intf_parm_type_t meta_id,
         const metadata_buffer_t* metadata)
 {
-    switch(meta_id) {
-        case CAM_INTF_META_HISTOGRAM:
-            return POINTER_OF_META(CAM_INTF_META_HISTOGRAM, metadata);
-        case CAM_INTF_META_FACE_DETECTION:
-            return POINTER_OF_META(CAM_INTF_META_FACE_DETECTION, metadata);
-        case CAM_INTF_META_AUTOFOCUS_DATA:
-            return POINTER_OF_META(CAM_INTF_META_AUTOFOCUS_DATA, metadata);
-        case CAM_INTF_META_CROP_DATA:
-            return POINTER_OF_META(CAM_INTF_META_CROP_DATA, metadata);
-        case CAM_INTF_META_PREP_SNAPSHOT_DONE:
-            return POINTER_OF_META(CAM_INTF_META_PREP_SNAPSHOT_DONE, metadata);
-        case CAM_INTF_META_GOOD_FRAME_IDX_RANGE:
-            return POINTER_OF_META(CAM_INTF_META_GOOD_FRAME_IDX_RANGE, metadata);
-        case CAM_INTF_META_ASD_HDR_SCENE_DATA:
-            return POINTER_OF_META(CAM_INTF_META_ASD_HDR_SCENE_DATA, metadata);
-        case CAM_INTF_META_ASD_SCENE_TYPE:
-            return POINTER_OF_META(CAM_INTF_META_ASD_SCENE_TYPE, metadata);
-        case CAM_INTF_META_CHROMATIX_LITE_ISP:
-            return POINTER_OF_META(CAM_INTF_META_CHROMATIX_LITE_ISP, metadata);
-        case CAM_INTF_META_CHROMATIX_LITE_PP:
-            return POINTER_OF_META(CAM_INTF_META_CHROMATIX_LITE_PP, metadata);
-        case CAM_INTF_META_CHROMATIX_LITE_AE:
-            return POINTER_OF_META(CAM_INTF_META_CHROMATIX_LITE_AE, metadata);
-        case CAM_INTF_META_CHROMATIX_LITE_AWB:
-            return POINTER_OF_META(CAM_INTF_META_CHROMATIX_LITE_AWB, metadata);
-        case CAM_INTF_META_CHROMATIX_LITE_AF:
-            return POINTER_OF_META(CAM_INTF_META_CHROMATIX_LITE_AF, metadata);
-        case CAM_INTF_META_CHROMATIX_LITE_ASD:
-            return POINTER_OF_META(CAM_INTF_META_CHROMATIX_LITE_ASD, metadata);
-        case CAM_INTF_META_FRAME_NUMBER_VALID:
-            return POINTER_OF_META(CAM_INTF_META_FRAME_NUMBER_VALID, metadata);
-        case CAM_INTF_META_URGENT_FRAME_NUMBER_VALID:
-            return POINTER_OF_META(CAM_INTF_META_URGENT_FRAME_NUMBER_VALID, metadata);
-        case CAM_INTF_META_FRAME_DROPPED:
-            return POINTER_OF_META(CAM_INTF_META_FRAME_DROPPED, metadata);
-        case CAM_INTF_META_PENDING_REQUESTS:
-            return POINTER_OF_META(CAM_INTF_META_PENDING_REQUESTS, metadata);
-        case CAM_INTF_META_FRAME_NUMBER:
-            return POINTER_OF_META(CAM_INTF_META_FRAME_NUMBER, metadata);
-        case CAM_INTF_META_URGENT_FRAME_NUMBER:
-            return POINTER_OF_META(CAM_INTF_META_URGENT_FRAME_NUMBER, metadata);
-        case CAM_INTF_META_COLOR_CORRECT_MODE:
-            return POINTER_OF_META(CAM_INTF_META_COLOR_CORRECT_MODE, metadata);
-        case CAM_INTF_META_COLOR_CORRECT_TRANSFORM:
-            return POINTER_OF_META(CAM_INTF_META_COLOR_CORRECT_TRANSFORM, metadata);
-        case CAM_INTF_META_COLOR_CORRECT_GAINS:
-            return POINTER_OF_META(CAM_INTF_META_COLOR_CORRECT_GAINS, metadata);
-        case CAM_INTF_META_PRED_COLOR_CORRECT_TRANSFORM:
-            return POINTER_OF_META(CAM_INTF_META_PRED_COLOR_CORRECT_TRANSFORM, metadata);
-        case CAM_INTF_META_PRED_COLOR_CORRECT_GAINS:
-            return POINTER_OF_META(CAM_INTF_META_PRED_COLOR_CORRECT_GAINS, metadata);
-        case CAM_INTF_META_AEC_ROI:
-            return POINTER_OF_META(CAM_INTF_META_AEC_ROI, metadata);
-        case CAM_INTF_META_AEC_STATE:
-            return POINTER_OF_META(CAM_INTF_META_AEC_STATE, metadata);
-        case CAM_INTF_PARM_FOCUS_MODE:
-            return POINTER_OF_META(CAM_INTF_PARM_FOCUS_MODE, metadata);
-        case CAM_INTF_META_AF_ROI:
-            return POINTER_OF_META(CAM_INTF_META_AF_ROI, metadata);
-        case CAM_INTF_META_AF_STATE:
-            return POINTER_OF_META(CAM_INTF_META_AF_STATE, metadata);
-        case CAM_INTF_PARM_WHITE_BALANCE:
-            return POINTER_OF_META(CAM_INTF_PARM_WHITE_BALANCE, metadata);
-        case CAM_INTF_META_AWB_REGIONS:
-            return POINTER_OF_META(CAM_INTF_META_AWB_REGIONS, metadata);
-        case CAM_INTF_META_AWB_STATE:
-            return POINTER_OF_META(CAM_INTF_META_AWB_STATE, metadata);
-        case CAM_INTF_META_BLACK_LEVEL_LOCK:
-            return POINTER_OF_META(CAM_INTF_META_BLACK_LEVEL_LOCK, metadata);
-        case CAM_INTF_META_MODE:
-            return POINTER_OF_META(CAM_INTF_META_MODE, metadata);
-        case CAM_INTF_META_EDGE_MODE:
-            return POINTER_OF_META(CAM_INTF_META_EDGE_MODE, metadata);
-        case CAM_INTF_META_FLASH_POWER:
-            return POINTER_OF_META(CAM_INTF_META_FLASH_POWER, metadata);
-        case CAM_INTF_META_FLASH_FIRING_TIME:
-            return POINTER_OF_META(CAM_INTF_META_FLASH_FIRING_TIME, metadata);
-        case CAM_INTF_META_FLASH_MODE:
-            return POINTER_OF_META(CAM_INTF_META_FLASH_MODE, metadata);
-        case CAM_INTF_META_FLASH_STATE:
-            return POINTER_OF_META(CAM_INTF_META_FLASH_STATE, metadata);
-        case CAM_INTF_META_HOTPIXEL_MODE:
-            return POINTER_OF_META(CAM_INTF_META_HOTPIXEL_MODE, metadata);
-        case CAM_INTF_META_LENS_APERTURE:
-            return POINTER_OF_META(CAM_INTF_META_LENS_APERTURE, metadata);
-        case CAM_INTF_META_LENS_FILTERDENSITY:
-            return POINTER_OF_META(CAM_INTF_META_LENS_FILTERDENSITY, metadata);
-        case CAM_INTF_META_LENS_FOCAL_LENGTH:
-            return POINTER_OF_META(CAM_INTF_META_LENS_FOCAL_LENGTH, metadata);
-        case CAM_INTF_META_LENS_FOCUS_DISTANCE:
-            return POINTER_OF_META(CAM_INTF_META_LENS_FOCUS_DISTANCE, metadata);
-        case CAM_INTF_META_LENS_FOCUS_RANGE:
-            return POINTER_OF_META(CAM_INTF_META_LENS_FOCUS_RANGE, metadata);
-        case CAM_INTF_META_LENS_STATE:
-            return POINTER_OF_META(CAM_INTF_META_LENS_STATE, metadata);
-        case CAM_INTF_META_LENS_OPT_STAB_MODE:
-            return POINTER_OF_META(CAM_INTF_META_LENS_OPT_STAB_MODE, metadata);
-        case CAM_INTF_META_NOISE_REDUCTION_MODE:
-            return POINTER_OF_META(CAM_INTF_META_NOISE_REDUCTION_MODE, metadata);
-        case CAM_INTF_META_NOISE_REDUCTION_STRENGTH:
-            return POINTER_OF_META(CAM_INTF_META_NOISE_REDUCTION_STRENGTH, metadata);
-        case CAM_INTF_META_SCALER_CROP_REGION:
-            return POINTER_OF_META(CAM_INTF_META_SCALER_CROP_REGION, metadata);
-        case CAM_INTF_META_SCENE_FLICKER:
-            return POINTER_OF_META(CAM_INTF_META_SCENE_FLICKER, metadata);
-        case CAM_INTF_META_SENSOR_EXPOSURE_TIME:
-            return POINTER_OF_META(CAM_INTF_META_SENSOR_EXPOSURE_TIME, metadata);
-        case CAM_INTF_META_SENSOR_FRAME_DURATION:
-            return POINTER_OF_META(CAM_INTF_META_SENSOR_FRAME_DURATION, metadata);
-        case CAM_INTF_META_SENSOR_SENSITIVITY:
-            return POINTER_OF_META(CAM_INTF_META_SENSOR_SENSITIVITY, metadata);
-        case CAM_INTF_META_SENSOR_TIMESTAMP:
-            return POINTER_OF_META(CAM_INTF_META_SENSOR_TIMESTAMP, metadata);
-        case CAM_INTF_META_SHADING_MODE:
-            return POINTER_OF_META(CAM_INTF_META_SHADING_MODE, metadata);
-        case CAM_INTF_META_STATS_FACEDETECT_MODE:
-            return POINTER_OF_META(CAM_INTF_META_STATS_FACEDETECT_MODE, metadata);
-        case CAM_INTF_META_STATS_HISTOGRAM_MODE:
-            return POINTER_OF_META(CAM_INTF_META_STATS_HISTOGRAM_MODE, metadata);
-        case CAM_INTF_META_STATS_SHARPNESS_MAP_MODE:
-            return POINTER_OF_META(CAM_INTF_META_STATS_SHARPNESS_MAP_MODE, metadata);
-        case CAM_INTF_META_STATS_SHARPNESS_MAP:
-            return POINTER_OF_META(CAM_INTF_META_STATS_SHARPNESS_MAP, metadata);
-        case CAM_INTF_META_TONEMAP_CURVES:
-            return POINTER_OF_META(CAM_INTF_META_TONEMAP_CURVES, metadata);
-        case CAM_INTF_META_LENS_SHADING_MAP:
-            return POINTER_OF_META(CAM_INTF_META_LENS_SHADING_MAP, metadata);
-        case CAM_INTF_META_AEC_INFO:
-            return POINTER_OF_META(CAM_INTF_META_AEC_INFO, metadata);
-        case CAM_INTF_META_SENSOR_INFO:
-            return POINTER_OF_META(CAM_INTF_META_SENSOR_INFO, metadata);
-        case CAM_INTF_META_ASD_SCENE_CAPTURE_TYPE:
-            return POINTER_OF_META(CAM_INTF_META_ASD_SCENE_CAPTURE_TYPE, metadata);
-        case CAM_INTF_PARM_EFFECT:
-            return POINTER_OF_META(CAM_INTF_PARM_EFFECT, metadata);
-        case CAM_INTF_META_PRIVATE_DATA:
-            return POINTER_OF_META(CAM_INTF_META_PRIVATE_DATA, metadata);
-        case CAM_INTF_PARM_HAL_VERSION:
-            return POINTER_OF_META(CAM_INTF_PARM_HAL_VERSION, metadata);
-        case CAM_INTF_PARM_ANTIBANDING:
-            return POINTER_OF_META(CAM_INTF_PARM_ANTIBANDING, metadata);
-        case CAM_INTF_PARM_EXPOSURE_COMPENSATION:
-            return POINTER_OF_META(CAM_INTF_PARM_EXPOSURE_COMPENSATION, metadata);
-        case CAM_INTF_PARM_AEC_LOCK:
-            return POINTER_OF_META(CAM_INTF_PARM_AEC_LOCK, metadata);
-        case CAM_INTF_PARM_FPS_RANGE:
-            return POINTER_OF_META(CAM_INTF_PARM_FPS_RANGE, metadata);
-        case CAM_INTF_PARM_AWB_LOCK:
-            return POINTER_OF_META(CAM_INTF_PARM_AWB_LOCK, metadata);
-        case CAM_INTF_PARM_BESTSHOT_MODE:
-            return POINTER_OF_META(CAM_INTF_PARM_BESTSHOT_MODE, metadata);
-        case CAM_INTF_PARM_DIS_ENABLE:
-            return POINTER_OF_META(CAM_INTF_PARM_DIS_ENABLE, metadata);
-        case CAM_INTF_PARM_LED_MODE:
-            return POINTER_OF_META(CAM_INTF_PARM_LED_MODE, metadata);
-        case CAM_INTF_PARM_QUERY_FLASH4SNAP:
-            return POINTER_OF_META(CAM_INTF_PARM_QUERY_FLASH4SNAP, metadata);
-        case CAM_INTF_PARM_EXPOSURE:
-            return POINTER_OF_META(CAM_INTF_PARM_EXPOSURE, metadata);
-        case CAM_INTF_PARM_SHARPNESS:
-            return POINTER_OF_META(CAM_INTF_PARM_SHARPNESS, metadata);
-        case CAM_INTF_PARM_CONTRAST:
-            return POINTER_OF_META(CAM_INTF_PARM_CONTRAST, metadata);
-        case CAM_INTF_PARM_SATURATION:
-            return POINTER_OF_META(CAM_INTF_PARM_SATURATION, metadata);
-        case CAM_INTF_PARM_BRIGHTNESS:
-            return POINTER_OF_META(CAM_INTF_PARM_BRIGHTNESS, metadata);
-        case CAM_INTF_PARM_ISO:
-            return POINTER_OF_META(CAM_INTF_PARM_ISO, metadata);
-        case CAM_INTF_PARM_ZOOM:
-            return POINTER_OF_META(CAM_INTF_PARM_ZOOM, metadata);
-        case CAM_INTF_PARM_ROLLOFF:
-            return POINTER_OF_META(CAM_INTF_PARM_ROLLOFF, metadata);
-        case CAM_INTF_PARM_MODE:
-            return POINTER_OF_META(CAM_INTF_PARM_MODE, metadata);
-        case CAM_INTF_PARM_AEC_ALGO_TYPE:
-            return POINTER_OF_META(CAM_INTF_PARM_AEC_ALGO_TYPE, metadata);
-        case CAM_INTF_PARM_FOCUS_ALGO_TYPE:
-            return POINTER_OF_META(CAM_INTF_PARM_FOCUS_ALGO_TYPE, metadata);
-        case CAM_INTF_PARM_AEC_ROI:
-            return POINTER_OF_META(CAM_INTF_PARM_AEC_ROI, metadata);
-        case CAM_INTF_PARM_AF_ROI:
-            return POINTER_OF_META(CAM_INTF_PARM_AF_ROI, metadata);
-        case CAM_INTF_PARM_SCE_FACTOR:
-            return POINTER_OF_META(CAM_INTF_PARM_SCE_FACTOR, metadata);
-        case CAM_INTF_PARM_FD:
-            return POINTER_OF_META(CAM_INTF_PARM_FD, metadata);
-        case CAM_INTF_PARM_MCE:
-            return POINTER_OF_META(CAM_INTF_PARM_MCE, metadata);
-        case CAM_INTF_PARM_HFR:
-            return POINTER_OF_META(CAM_INTF_PARM_HFR, metadata);
-        case CAM_INTF_PARM_REDEYE_REDUCTION:
-            return POINTER_OF_META(CAM_INTF_PARM_REDEYE_REDUCTION, metadata);
-        case CAM_INTF_PARM_WAVELET_DENOISE:
-            return POINTER_OF_META(CAM_INTF_PARM_WAVELET_DENOISE, metadata);
-        case CAM_INTF_PARM_HISTOGRAM:
-            return POINTER_OF_META(CAM_INTF_PARM_HISTOGRAM, metadata);
-        case CAM_INTF_PARM_ASD_ENABLE:
-            return POINTER_OF_META(CAM_INTF_PARM_ASD_ENABLE, metadata);
-        case CAM_INTF_PARM_RECORDING_HINT:
-            return POINTER_OF_META(CAM_INTF_PARM_RECORDING_HINT, metadata);
-        case CAM_INTF_PARM_HDR:
-            return POINTER_OF_META(CAM_INTF_PARM_HDR, metadata);
-        case CAM_INTF_PARM_FRAMESKIP:
-            return POINTER_OF_META(CAM_INTF_PARM_FRAMESKIP, metadata);
-        case CAM_INTF_PARM_ZSL_MODE:
-            return POINTER_OF_META(CAM_INTF_PARM_ZSL_MODE, metadata);
-        case CAM_INTF_PARM_HDR_NEED_1X:
-            return POINTER_OF_META(CAM_INTF_PARM_HDR_NEED_1X, metadata);
-        case CAM_INTF_PARM_LOCK_CAF:
-            return POINTER_OF_META(CAM_INTF_PARM_LOCK_CAF, metadata);
-        case CAM_INTF_PARM_VIDEO_HDR:
-            return POINTER_OF_META(CAM_INTF_PARM_VIDEO_HDR, metadata);
-        case CAM_INTF_PARM_VT:
-            return POINTER_OF_META(CAM_INTF_PARM_VT, metadata);
-        case CAM_INTF_PARM_GET_CHROMATIX:
-            return POINTER_OF_META(CAM_INTF_PARM_GET_CHROMATIX, metadata);
-        case CAM_INTF_PARM_SET_RELOAD_CHROMATIX:
-            return POINTER_OF_META(CAM_INTF_PARM_SET_RELOAD_CHROMATIX, metadata);
-        case CAM_INTF_PARM_GET_AFTUNE:
-            return POINTER_OF_META(CAM_INTF_PARM_GET_AFTUNE, metadata);
-        case CAM_INTF_PARM_SET_RELOAD_AFTUNE:
-            return POINTER_OF_META(CAM_INTF_PARM_SET_RELOAD_AFTUNE, metadata);
-        case CAM_INTF_PARM_SET_AUTOFOCUSTUNING:
-            return POINTER_OF_META(CAM_INTF_PARM_SET_AUTOFOCUSTUNING, metadata);
-        case CAM_INTF_PARM_SET_VFE_COMMAND:
-            return POINTER_OF_META(CAM_INTF_PARM_SET_VFE_COMMAND, metadata);
-        case CAM_INTF_PARM_SET_PP_COMMAND:
-            return POINTER_OF_META(CAM_INTF_PARM_SET_PP_COMMAND, metadata);
-        case CAM_INTF_PARM_MAX_DIMENSION:
-            return POINTER_OF_META(CAM_INTF_PARM_MAX_DIMENSION, metadata);
-        case CAM_INTF_PARM_RAW_DIMENSION:
-            return POINTER_OF_META(CAM_INTF_PARM_RAW_DIMENSION, metadata);
-        case CAM_INTF_PARM_TINTLESS:
-            return POINTER_OF_META(CAM_INTF_PARM_TINTLESS, metadata);
-        case CAM_INTF_PARM_EZTUNE_CMD:
-            return POINTER_OF_META(CAM_INTF_PARM_EZTUNE_CMD, metadata);
-        case CAM_INTF_PARM_RDI_MODE:
-            return POINTER_OF_META(CAM_INTF_PARM_RDI_MODE, metadata);
-        case CAM_INTF_PARM_BURST_NUM:
-            return POINTER_OF_META(CAM_INTF_PARM_BURST_NUM, metadata);
-        case CAM_INTF_PARM_RETRO_BURST_NUM:
-            return POINTER_OF_META(CAM_INTF_PARM_RETRO_BURST_NUM, metadata);
-        case CAM_INTF_PARM_BURST_LED_ON_PERIOD:
-            return POINTER_OF_META(CAM_INTF_PARM_BURST_LED_ON_PERIOD, metadata);
-        case CAM_INTF_META_STREAM_INFO:
-            return POINTER_OF_META(CAM_INTF_META_STREAM_INFO, metadata);
-        case CAM_INTF_META_AEC_MODE:
-            return POINTER_OF_META(CAM_INTF_META_AEC_MODE, metadata);
-        case CAM_INTF_META_AEC_PRECAPTURE_TRIGGER:
-            return POINTER_OF_META(CAM_INTF_META_AEC_PRECAPTURE_TRIGGER, metadata);
-        case CAM_INTF_META_AF_TRIGGER:
-            return POINTER_OF_META(CAM_INTF_META_AF_TRIGGER, metadata);
-        case CAM_INTF_META_CAPTURE_INTENT:
-            return POINTER_OF_META(CAM_INTF_META_CAPTURE_INTENT, metadata);
-        case CAM_INTF_META_DEMOSAIC:
-            return POINTER_OF_META(CAM_INTF_META_DEMOSAIC, metadata);
-        case CAM_INTF_META_SHARPNESS_STRENGTH:
-            return POINTER_OF_META(CAM_INTF_META_SHARPNESS_STRENGTH, metadata);
-        case CAM_INTF_META_GEOMETRIC_MODE:
-            return POINTER_OF_META(CAM_INTF_META_GEOMETRIC_MODE, metadata);
-        case CAM_INTF_META_GEOMETRIC_STRENGTH:
-            return POINTER_OF_META(CAM_INTF_META_GEOMETRIC_STRENGTH, metadata);
-        case CAM_INTF_META_LENS_SHADING_MAP_MODE:
-            return POINTER_OF_META(CAM_INTF_META_LENS_SHADING_MAP_MODE, metadata);
-        case CAM_INTF_META_SHADING_STRENGTH:
-            return POINTER_OF_META(CAM_INTF_META_SHADING_STRENGTH, metadata);
-        case CAM_INTF_META_TONEMAP_MODE:
-            return POINTER_OF_META(CAM_INTF_META_TONEMAP_MODE, metadata);
-        case CAM_INTF_META_STREAM_ID:
-            return POINTER_OF_META(CAM_INTF_META_STREAM_ID, metadata);
-        case CAM_INTF_PARM_STATS_DEBUG_MASK:
-            return POINTER_OF_META(CAM_INTF_PARM_STATS_DEBUG_MASK, metadata);
-        case CAM_INTF_PARM_STATS_AF_PAAF:
-            return POINTER_OF_META(CAM_INTF_PARM_STATS_AF_PAAF, metadata);
-        case CAM_INTF_PARM_FOCUS_BRACKETING:
-            return POINTER_OF_META(CAM_INTF_PARM_FOCUS_BRACKETING, metadata);
-        case CAM_INTF_PARM_FLASH_BRACKETING:
-            return POINTER_OF_META(CAM_INTF_PARM_FLASH_BRACKETING, metadata);
-        case CAM_INTF_PARM_CDS_MODE:
-            return POINTER_OF_META(CAM_INTF_PARM_CDS_MODE, metadata);
-        default:
-            return NULL;
+    if (((uint32_t)meta_id >= CAM_INTF_PARM_MAX) ||
+        (0 == cam_intf_entry_info[meta_id].size)) {
+        return NULL;
     }
+    return (uint8_t *)metadata + cam_intf_entry_info[meta_id].offset;
 }
 
 uint32_t get_size_of(cam_intf_parm_type_t param_id)
 {
-    metadata_buffer_t* metadata = NULL;
-    switch(param_id) {
-        case CAM_INTF_META_HISTOGRAM:
-            return SIZE_OF_PARAM(CAM_INTF_META_HISTOGRAM, metadata);
-        case CAM_INTF_META_FACE_DETECTION:
-            return SIZE_OF_PARAM(CAM_INTF_META_FACE_DETECTION, metadata);
-        case CAM_INTF_META_AUTOFOCUS_DATA:
-            return SIZE_OF_PARAM(CAM_INTF_META_AUTOFOCUS_DATA, metadata);
-        case CAM_INTF_META_CROP_DATA:
-            return SIZE_OF_PARAM(CAM_INTF_META_CROP_DATA, metadata);
-        case CAM_INTF_META_PREP_SNAPSHOT_DONE:
-            return SIZE_OF_PARAM(CAM_INTF_META_PREP_SNAPSHOT_DONE, metadata);
-        case CAM_INTF_META_GOOD_FRAME_IDX_RANGE:
-            return SIZE_OF_PARAM(CAM_INTF_META_GOOD_FRAME_IDX_RANGE, metadata);
-        case CAM_INTF_META_ASD_HDR_SCENE_DATA:
-            return SIZE_OF_PARAM(CAM_INTF_META_ASD_HDR_SCENE_DATA, metadata);
-        case CAM_INTF_META_ASD_SCENE_TYPE:
-            return SIZE_OF_PARAM(CAM_INTF_META_ASD_SCENE_TYPE, metadata);
-        case CAM_INTF_META_CHROMATIX_LITE_ISP:
-            return SIZE_OF_PARAM(CAM_INTF_META_CHROMATIX_LITE_ISP, metadata);
-        case CAM_INTF_META_CHROMATIX_LITE_PP:
-            return SIZE_OF_PARAM(CAM_INTF_META_CHROMATIX_LITE_PP, metadata);
-        case CAM_INTF_META_CHROMATIX_LITE_AE:
-            return SIZE_OF_PARAM(CAM_INTF_META_CHROMATIX_LITE_AE, metadata);
-        case CAM_INTF_META_CHROMATIX_LITE_AWB:
-            return SIZE_OF_PARAM(CAM_INTF_META_CHROMATIX_LITE_AWB, metadata);
-        case CAM_INTF_META_CHROMATIX_LITE_AF:
-            return SIZE_OF_PARAM(CAM_INTF_META_CHROMATIX_LITE_AF, metadata);
-        case CAM_INTF_META_CHROMATIX_LITE_ASD:
-            return SIZE_OF_PARAM(CAM_INTF_META_CHROMATIX_LITE_ASD, metadata);
-        case CAM_INTF_META_FRAME_NUMBER_VALID:
-            return SIZE_OF_PARAM(CAM_INTF_META_FRAME_NUMBER_VALID, metadata);
-        case CAM_INTF_META_URGENT_FRAME_NUMBER_VALID:
-            return SIZE_OF_PARAM(CAM_INTF_META_URGENT_FRAME_NUMBER_VALID, metadata);
-        case CAM_INTF_META_FRAME_DROPPED:
-            return SIZE_OF_PARAM(CAM_INTF_META_FRAME_DROPPED, metadata);
-        case CAM_INTF_META_PENDING_REQUESTS:
-            return SIZE_OF_PARAM(CAM_INTF_META_PENDING_REQUESTS, metadata);
-        case CAM_INTF_META_FRAME_NUMBER:
-            return SIZE_OF_PARAM(CAM_INTF_META_FRAME_NUMBER, metadata);
-        case CAM_INTF_META_URGENT_FRAME_NUMBER:
-            return SIZE_OF_PARAM(CAM_INTF_META_URGENT_FRAME_NUMBER, metadata);
-        case CAM_INTF_META_COLOR_CORRECT_MODE:
-            return SIZE_OF_PARAM(CAM_INTF_META_COLOR_CORRECT_MODE, metadata);
-        case CAM_INTF_META_COLOR_CORRECT_TRANSFORM:
-            return SIZE_OF_PARAM(CAM_INTF_META_COLOR_CORRECT_TRANSFORM, metadata);
-        case CAM_INTF_META_COLOR_CORRECT_GAINS:
-            return SIZE_OF_PARAM(CAM_INTF_META_COLOR_CORRECT_GAINS, metadata);
-        case CAM_INTF_META_PRED_COLOR_CORRECT_TRANSFORM:
-            return SIZE_OF_PARAM(CAM_INTF_META_PRED_COLOR_CORRECT_TRANSFORM, metadata);
-        case CAM_INTF_META_PRED_COLOR_CORRECT_GAINS:
-            return SIZE_OF_PARAM(CAM_INTF_META_PRED_COLOR_CORRECT_GAINS, metadata);
-        case CAM_INTF_META_AEC_ROI:
-            return SIZE_OF_PARAM(CAM_INTF_META_AEC_ROI, metadata);
-        case CAM_INTF_META_AEC_STATE:
-            return SIZE_OF_PARAM(CAM_INTF_META_AEC_STATE, metadata);
-        case CAM_INTF_PARM_FOCUS_MODE:
-            return SIZE_OF_PARAM(CAM_INTF_PARM_FOCUS_MODE, metadata);
-        case CAM_INTF_META_AF_ROI:
-            return SIZE_OF_PARAM(CAM_INTF_META_AF_ROI, metadata);
-        case CAM_INTF_META_AF_STATE:
-            return SIZE_OF_PARAM(CAM_INTF_META_AF_STATE, metadata);
-        case CAM_INTF_PARM_WHITE_BALANCE:
-            return SIZE_OF_PARAM(CAM_INTF_PARM_WHITE_BALANCE, metadata);
-        case CAM_INTF_META_AWB_REGIONS:
-            return SIZE_OF_PARAM(CAM_INTF_META_AWB_REGIONS, metadata);
-        case CAM_INTF_META_AWB_STATE:
-            return SIZE_OF_PARAM(CAM_INTF_META_AWB_STATE, metadata);
-        case CAM_INTF_META_BLACK_LEVEL_LOCK:
-            return SIZE_OF_PARAM(CAM_INTF_META_BLACK_LEVEL_LOCK, metadata);
-        case CAM_INTF_META_MODE:
-            return SIZE_OF_PARAM(CAM_INTF_META_MODE, metadata);
-        case CAM_INTF_META_EDGE_MODE:
-            return SIZE_OF_PARAM(CAM_INTF_META_EDGE_MODE, metadata);
-        case CAM_INTF_META_FLASH_POWER:
-            return SIZE_OF_PARAM(CAM_INTF_META_FLASH_POWER, metadata);
-        case CAM_INTF_META_FLASH_FIRING_TIME:
-            return SIZE_OF_PARAM(CAM_INTF_META_FLASH_FIRING_TIME, metadata);
-        case CAM_INTF_META_FLASH_MODE:
-            return SIZE_OF_PARAM(CAM_INTF_META_FLASH_MODE, metadata);
-        case CAM_INTF_META_FLASH_STATE:
-            return SIZE_OF_PARAM(CAM_INTF_META_FLASH_STATE, metadata);
-        case CAM_INTF_META_HOTPIXEL_MODE:
-            return SIZE_OF_PARAM(CAM_INTF_META_HOTPIXEL_MODE, metadata);
-        case CAM_INTF_META_LENS_APERTURE:
-            return SIZE_OF_PARAM(CAM_INTF_META_LENS_APERTURE, metadata);
-        case CAM_INTF_META_LENS_FILTERDENSITY:
-            return SIZE_OF_PARAM(CAM_INTF_META_LENS_FILTERDENSITY, metadata);
-        case CAM_INTF_META_LENS_FOCAL_LENGTH:
-            return SIZE_OF_PARAM(CAM_INTF_META_LENS_FOCAL_LENGTH, metadata);
-        case CAM_INTF_META_LENS_FOCUS_DISTANCE:
-            return SIZE_OF_PARAM(CAM_INTF_META_LENS_FOCUS_DISTANCE, metadata);
-        case CAM_INTF_META_LENS_FOCUS_RANGE:
-            return SIZE_OF_PARAM(CAM_INTF_META_LENS_FOCUS_RANGE, metadata);
-        case CAM_INTF_META_LENS_STATE:
-            return SIZE_OF_PARAM(CAM_INTF_META_LENS_STATE, metadata);
-        case CAM_INTF_META_LENS_OPT_STAB_MODE:
-            return SIZE_OF_PARAM(CAM_INTF_META_LENS_OPT_STAB_MODE, metadata);
-        case CAM_INTF_META_NOISE_REDUCTION_MODE:
-            return SIZE_OF_PARAM(CAM_INTF_META_NOISE_REDUCTION_MODE, metadata);
-        case CAM_INTF_META_NOISE_REDUCTION_STRENGTH:
-            return SIZE_OF_PARAM(CAM_INTF_META_NOISE_REDUCTION_STRENGTH, metadata);
-        case CAM_INTF_META_SCALER_CROP_REGION:
-            return SIZE_OF_PARAM(CAM_INTF_META_SCALER_CROP_REGION, metadata);
-        case CAM_INTF_META_SCENE_FLICKER:
-            return SIZE_OF_PARAM(CAM_INTF_META_SCENE_FLICKER, metadata);
-        case CAM_INTF_META_SENSOR_EXPOSURE_TIME:
-            return SIZE_OF_PARAM(CAM_INTF_META_SENSOR_EXPOSURE_TIME, metadata);
-        case CAM_INTF_META_SENSOR_FRAME_DURATION:
-            return SIZE_OF_PARAM(CAM_INTF_META_SENSOR_FRAME_DURATION, metadata);
-        case CAM_INTF_META_SENSOR_SENSITIVITY:
-            return SIZE_OF_PARAM(CAM_INTF_META_SENSOR_SENSITIVITY, metadata);
-        case CAM_INTF_META_SENSOR_TIMESTAMP:
-            return SIZE_OF_PARAM(CAM_INTF_META_SENSOR_TIMESTAMP, metadata);
-        case CAM_INTF_META_SHADING_MODE:
-            return SIZE_OF_PARAM(CAM_INTF_META_SHADING_MODE, metadata);
-        case CAM_INTF_META_STATS_FACEDETECT_MODE:
-            return SIZE_OF_PARAM(CAM_INTF_META_STATS_FACEDETECT_MODE, metadata);
-        case CAM_INTF_META_STATS_HISTOGRAM_MODE:
-            return SIZE_OF_PARAM(CAM_INTF_META_STATS_HISTOGRAM_MODE, metadata);
-        case CAM_INTF_META_STATS_SHARPNESS_MAP_MODE:
-            return SIZE_OF_PARAM(CAM_INTF_META_STATS_SHARPNESS_MAP_MODE, metadata);
-        case CAM_INTF_META_STATS_SHARPNESS_MAP:
-            return SIZE_OF_PARAM(CAM_INTF_META_STATS_SHARPNESS_MAP, metadata);
-        case CAM_INTF_META_TONEMAP_CURVES:
-            return SIZE_OF_PARAM(CAM_INTF_META_TONEMAP_CURVES, metadata);
-        case CAM_INTF_META_LENS_SHADING_MAP:
-            return SIZE_OF_PARAM(CAM_INTF_META_LENS_SHADING_MAP, metadata);
-        case CAM_INTF_META_AEC_INFO:
-            return SIZE_OF_PARAM(CAM_INTF_META_AEC_INFO, metadata);
-        case CAM_INTF_META_SENSOR_INFO:
-            return SIZE_OF_PARAM(CAM_INTF_META_SENSOR_INFO, metadata);
-        case CAM_INTF_META_ASD_SCENE_CAPTURE_TYPE:
-            return SIZE_OF_PARAM(CAM_INTF_META_ASD_SCENE_CAPTURE_TYPE, metadata);
-        case CAM_INTF_PARM_EFFECT:
-            return SIZE_OF_PARAM(CAM_INTF_PARM_EFFECT, metadata);
-        case CAM_INTF_META_PRIVATE_DATA:
-            return SIZE_OF_PARAM(CAM_INTF_META_PRIVATE_DATA, metadata);
-        case CAM_INTF_PARM_HAL_VERSION:
-            return SIZE_OF_PARAM(CAM_INTF_PARM_HAL_VERSION, metadata);
-        case CAM_INTF_PARM_ANTIBANDING:
-            return SIZE_OF_PARAM(CAM_INTF_PARM_ANTIBANDING, metadata);
-        case CAM_INTF_PARM_EXPOSURE_COMPENSATION:
-            return SIZE_OF_PARAM(CAM_INTF_PARM_EXPOSURE_COMPENSATION, metadata);
-        case CAM_INTF_PARM_AEC_LOCK:
-            return SIZE_OF_PARAM(CAM_INTF_PARM_AEC_LOCK, metadata);
-        case CAM_INTF_PARM_FPS_RANGE:
-            return SIZE_OF_PARAM(CAM_INTF_PARM_FPS_RANGE, metadata);
-        case CAM_INTF_PARM_AWB_LOCK:
-            return SIZE_OF_PARAM(CAM_INTF_PARM_AWB_LOCK, metadata);
-        case CAM_INTF_PARM_BESTSHOT_MODE:
-            return SIZE_OF_PARAM(CAM_INTF_PARM_BESTSHOT_MODE, metadata);
-        case CAM_INTF_PARM_DIS_ENABLE:
-            return SIZE_OF_PARAM(CAM_INTF_PARM_DIS_ENABLE, metadata);
-        case CAM_INTF_PARM_LED_MODE:
-            return SIZE_OF_PARAM(CAM_INTF_PARM_LED_MODE, metadata);
-        case CAM_INTF_PARM_QUERY_FLASH4SNAP:
-            return SIZE_OF_PARAM(CAM_INTF_PARM_QUERY_FLASH4SNAP, metadata);
-        case CAM_INTF_PARM_EXPOSURE:
-            return SIZE_OF_PARAM(CAM_INTF_PARM_EXPOSURE, metadata);
-        case CAM_INTF_PARM_SHARPNESS:
-            return SIZE_OF_PARAM(CAM_INTF_PARM_SHARPNESS, metadata);
-        case CAM_INTF_PARM_CONTRAST:
-            return SIZE_OF_PARAM(CAM_INTF_PARM_CONTRAST, metadata);
-        case CAM_INTF_PARM_SATURATION:
-            return SIZE_OF_PARAM(CAM_INTF_PARM_SATURATION, metadata);
-        case CAM_INTF_PARM_BRIGHTNESS:
-            return SIZE_OF_PARAM(CAM_INTF_PARM_BRIGHTNESS, metadata);
-        case CAM_INTF_PARM_ISO:
-            return SIZE_OF_PARAM(CAM_INTF_PARM_ISO, metadata);
-        case CAM_INTF_PARM_ZOOM:
-            return SIZE_OF_PARAM(CAM_INTF_PARM_ZOOM, metadata);
-        case CAM_INTF_PARM_ROLLOFF:
-            return SIZE_OF_PARAM(CAM_INTF_PARM_ROLLOFF, metadata);
-        case CAM_INTF_PARM_MODE:
-            return SIZE_OF_PARAM(CAM_INTF_PARM_MODE, metadata);
-        case CAM_INTF_PARM_AEC_ALGO_TYPE:
-            return SIZE_OF_PARAM(CAM_INTF_PARM_AEC_ALGO_TYPE, metadata);
-        case CAM_INTF_PARM_FOCUS_ALGO_TYPE:
-            return SIZE_OF_PARAM(CAM_INTF_PARM_FOCUS_ALGO_TYPE, metadata);
-        case CAM_INTF_PARM_AEC_ROI:
-            return SIZE_OF_PARAM(CAM_INTF_PARM_AEC_ROI, metadata);
-        case CAM_INTF_PARM_AF_ROI:
-            return SIZE_OF_PARAM(CAM_INTF_PARM_AF_ROI, metadata);
-        case CAM_INTF_PARM_SCE_FACTOR:
-            return SIZE_OF_PARAM(CAM_INTF_PARM_SCE_FACTOR, metadata);
-        case CAM_INTF_PARM_FD:
-            return SIZE_OF_PARAM(CAM_INTF_PARM_FD, metadata);
-        case CAM_INTF_PARM_MCE:
-            return SIZE_OF_PARAM(CAM_INTF_PARM_MCE, metadata);
-        case CAM_INTF_PARM_HFR:
-            return SIZE_OF_PARAM(CAM_INTF_PARM_HFR, metadata);
-        case CAM_INTF_PARM_REDEYE_REDUCTION:
-            return SIZE_OF_PARAM(CAM_INTF_PARM_REDEYE_REDUCTION, metadata);
-        case CAM_INTF_PARM_WAVELET_DENOISE:
-            return SIZE_OF_PARAM(CAM_INTF_PARM_WAVELET_DENOISE, metadata);
-        case CAM_INTF_PARM_HISTOGRAM:
-            return SIZE_OF_PARAM(CAM_INTF_PARM_HISTOGRAM, metadata);
-        case CAM_INTF_PARM_ASD_ENABLE:
-            return SIZE_OF_PARAM(CAM_INTF_PARM_ASD_ENABLE, metadata);
-        case CAM_INTF_PARM_RECORDING_HINT:
-            return SIZE_OF_PARAM(CAM_INTF_PARM_RECORDING_HINT, metadata);
-        case CAM_INTF_PARM_HDR:
-            return SIZE_OF_PARAM(CAM_INTF_PARM_HDR, metadata);
-        case CAM_INTF_PARM_FRAMESKIP:
-            return SIZE_OF_PARAM(CAM_INTF_PARM_FRAMESKIP, metadata);
-        case CAM_INTF_PARM_ZSL_MODE:
-            return SIZE_OF_PARAM(CAM_INTF_PARM_ZSL_MODE, metadata);
-        case CAM_INTF_PARM_HDR_NEED_1X:
-            return SIZE_OF_PARAM(CAM_INTF_PARM_HDR_NEED_1X, metadata);
-        case CAM_INTF_PARM_LOCK_CAF:
-            return SIZE_OF_PARAM(CAM_INTF_PARM_LOCK_CAF, metadata);
-        case CAM_INTF_PARM_VIDEO_HDR:
-            return SIZE_OF_PARAM(CAM_INTF_PARM_VIDEO_HDR, metadata);
-        case CAM_INTF_PARM_VT:
-            return SIZE_OF_PARAM(CAM_INTF_PARM_VT, metadata);
-        case CAM_INTF_PARM_GET_CHROMATIX:
-            return SIZE_OF_PARAM(CAM_INTF_PARM_GET_CHROMATIX, metadata);
-        case CAM_INTF_PARM_SET_RELOAD_CHROMATIX:
-            return SIZE_OF_PARAM(CAM_INTF_PARM_SET_RELOAD_CHROMATIX, metadata);
-        case CAM_INTF_PARM_GET_AFTUNE:
-            return SIZE_OF_PARAM(CAM_INTF_PARM_GET_AFTUNE, metadata);
-        case CAM_INTF_PARM_SET_RELOAD_AFTUNE:
-            return SIZE_OF_PARAM(CAM_INTF_PARM_SET_RELOAD_AFTUNE, metadata);
-        case CAM_INTF_PARM_SET_AUTOFOCUSTUNING:
-            return SIZE_OF_PARAM(CAM_INTF_PARM_SET_AUTOFOCUSTUNING, metadata);
-        case CAM_INTF_PARM_SET_VFE_COMMAND:
-            return SIZE_OF_PARAM(CAM_INTF_PARM_SET_VFE_COMMAND, metadata);
-        case CAM_INTF_PARM_SET_PP_COMMAND:
-            return SIZE_OF_PARAM(CAM_INTF_PARM_SET_PP_COMMAND, metadata);
-        case CAM_INTF_PARM_MAX_DIMENSION:
-            return SIZE_OF_PARAM(CAM_INTF_PARM_MAX_DIMENSION, metadata);
-        case CAM_INTF_PARM_RAW_DIMENSION:
-            return SIZE_OF_PARAM(CAM_INTF_PARM_RAW_DIMENSION, metadata);
-        case CAM_INTF_PARM_TINTLESS:
-            return SIZE_OF_PARAM(CAM_INTF_PARM_TINTLESS, metadata);
-        case CAM_INTF_PARM_EZTUNE_CMD:
-            return SIZE_OF_PARAM(CAM_INTF_PARM_EZTUNE_CMD, metadata);
-        case CAM_INTF_PARM_RDI_MODE:
-            return SIZE_OF_PARAM(CAM_INTF_PARM_RDI_MODE, metadata);
-        case CAM_INTF_PARM_BURST_NUM:
-            return SIZE_OF_PARAM(CAM_INTF_PARM_BURST_NUM, metadata);
-        case CAM_INTF_PARM_RETRO_BURST_NUM:
-            return SIZE_OF_PARAM(CAM_INTF_PARM_RETRO_BURST_NUM, metadata);
-        case CAM_INTF_PARM_BURST_LED_ON_PERIOD:
-            return SIZE_OF_PARAM(CAM_INTF_PARM_BURST_LED_ON_PERIOD, metadata);
-        case CAM_INTF_META_STREAM_INFO:
-            return SIZE_OF_PARAM(CAM_INTF_META_STREAM_INFO, metadata);
-        case CAM_INTF_META_AEC_MODE:
-            return SIZE_OF_PARAM(CAM_INTF_META_AEC_MODE, metadata);
-        case CAM_INTF_META_AEC_PRECAPTURE_TRIGGER:
-            return SIZE_OF_PARAM(CAM_INTF_META_AEC_PRECAPTURE_TRIGGER, metadata);
-        case CAM_INTF_META_AF_TRIGGER:
-            return SIZE_OF_PARAM(CAM_INTF_META_AF_TRIGGER, metadata);
-        case CAM_INTF_META_CAPTURE_INTENT:
-            return SIZE_OF_PARAM(CAM_INTF_META_CAPTURE_INTENT, metadata);
-        case CAM_INTF_META_DEMOSAIC:
-            return SIZE_OF_PARAM(CAM_INTF_META_DEMOSAIC, metadata);
-        case CAM_INTF_META_SHARPNESS_STRENGTH:
-            return SIZE_OF_PARAM(CAM_INTF_META_SHARPNESS_STRENGTH, metadata);
-        case CAM_INTF_META_GEOMETRIC_MODE:
-            return SIZE_OF_PARAM(CAM_INTF_META_GEOMETRIC_MODE, metadata);
-        case CAM_INTF_META_GEOMETRIC_STRENGTH:
-            return SIZE_OF_PARAM(CAM_INTF_META_GEOMETRIC_STRENGTH, metadata);
-        case CAM_INTF_META_LENS_SHADING_MAP_MODE:
-            return SIZE_OF_PARAM(CAM_INTF_META_LENS_SHADING_MAP_MODE, metadata);
-        case CAM_INTF_META_SHADING_STRENGTH:
-            return SIZE_OF_PARAM(CAM_INTF_META_SHADING_STRENGTH, metadata);
-        case CAM_INTF_META_TONEMAP_MODE:
-            return SIZE_OF_PARAM(CAM_INTF_META_TONEMAP_MODE, metadata);
-        case CAM_INTF_META_STREAM_ID:
-            return SIZE_OF_PARAM(CAM_INTF_META_STREAM_ID, metadata);
-        case CAM_INTF_PARM_STATS_DEBUG_MASK:
-            return SIZE_OF_PARAM(CAM_INTF_PARM_STATS_DEBUG_MASK, metadata);
-        case CAM_INTF_PARM_STATS_AF_PAAF:
-            return SIZE_OF_PARAM(CAM_INTF_PARM_STATS_AF_PAAF, metadata);
-        case CAM_INTF_PARM_FOCUS_BRACKETING:
-            return SIZE_OF_PARAM(CAM_INTF_PARM_FOCUS_BRACKETING, metadata);
-        case CAM_INTF_PARM_FLASH_BRACKETING:
-            return SIZE_OF_PARAM(CAM_INTF_PARM_FLASH_BRACKETING, metadata);
-        case CAM_INTF_PARM_CDS_MODE:
-            return SIZE_OF_PARAM(CAM_INTF_PARM_CDS_MODE, metadata);
-        default:
-            return 0;
+    if ((uint32_t)param_id >= CAM_INTF_PARM_MAX) {
+        return 0;
+    }
+    return cam_intf_entry_info[param_id].size;
+}
+
+/*===========================================================================
+ * FUNCTION   : cam_parm_mark_dirty
+ *
+ * DESCRIPTION: record a param as changed in the current batch
+ *
+ * PARAMETERS :
+ *   @dirty    : dirty tracker of the batch, may be NULL
+ *   @param_id : param that changed
+ *   @length   : number of bytes set, 0 for a get request
+ *
+ * RETURN     : none
+ *==========================================================================*/
+static void cam_parm_mark_dirty(cam_parm_dirty_t *dirty,
+        cam_intf_parm_type_t param_id, uint32_t length)
+{
+    if (NULL == dirty) {
+        return;
+    }
+    if (!dirty->dirty[param_id]) {
+        dirty->dirty[param_id] = 1;
+        dirty->ids[dirty->num_entries++] = (uint16_t)param_id;
+    }
+    dirty->length[param_id] = length;
+}
+
+/*===========================================================================
+ * FUNCTION   : cam_parm_batch_init
+ *
+ * DESCRIPTION: start a new parameter batch. The first batch clears the whole
+ *              table, later ones only reset the valid flags and the entries
+ *              tracked as dirty, so per request setup does not touch the
+ *              full parm_data_t layout.
+ *
+ * PARAMETERS :
+ *   @p_table : ptr to parameter buffer
+ *   @dirty   : dirty tracker of the batch, NULL to always clear the table
+ *
+ * RETURN     : none
+ *==========================================================================*/
+void cam_parm_batch_init(parm_buffer_t *p_table, cam_parm_dirty_t *dirty)
+{
+    uint32_t i;
+
+    if (NULL == p_table) {
+        return;
+    }
+    if ((NULL == dirty) || !dirty->primed) {
+        memset(p_table, 0, sizeof(parm_buffer_t));
+        if (NULL != dirty) {
+            memset(dirty, 0, sizeof(cam_parm_dirty_t));
+            dirty->primed = 1;
+        }
+        return;
+    }
+
+    memset(p_table->is_valid, 0, sizeof(p_table->is_valid));
+    p_table->is_tuning_params_valid = 0;
+    for (i = 0; i < dirty->num_entries; i++) {
+        /* get requests of the last batch are tracked with the sets */
+        p_table->is_reqd[dirty->ids[i]] = 0;
+        dirty->dirty[dirty->ids[i]] = 0;
+    }
+    dirty->num_entries = 0;
+}
+
+/*===========================================================================
+ * FUNCTION   : cam_parm_batch_add
+ *
+ * DESCRIPTION: copy a set parameter entry into the batch and mark it dirty.
+ *              Bytes of the entry beyond length are zeroed since the table
+ *              is no longer cleared as a whole per batch.
+ *
+ * PARAMETERS :
+ *   @p_table  : ptr to parameter buffer
+ *   @dirty    : dirty tracker of the batch, may be NULL
+ *   @param_id : parameter type
+ *   @length   : length of parameter value
+ *   @value    : ptr to parameter value
+ *
+ * RETURN     : int32_t type of status
+ *              0  -- success
+ *              -1 -- failure
+ *==========================================================================*/
+int32_t cam_parm_batch_add(parm_buffer_t *p_table, cam_parm_dirty_t *dirty,
+        cam_intf_parm_type_t param_id, uint32_t length, const void *value)
+{
+    uint8_t *dst;
+    uint32_t max_size;
+
+    if ((NULL == p_table) || (NULL == value) ||
+        (param_id >= CAM_INTF_PARM_MAX)) {
+        return -1;
+    }
+    max_size = get_size_of(param_id);
+    if (length > max_size) {
+        return -1;
+    }
+
+    dst = (uint8_t *)get_pointer_of(param_id, p_table);
+    if (NULL != dst) {
+        memcpy(dst, value, length);
+        if (length < max_size) {
+            memset(dst + length, 0, max_size - length);
+        }
+        p_table->is_valid[param_id] = 1;
+        cam_parm_mark_dirty(dirty, param_id, length);
     }
     return 0;
 }
+
+/*===========================================================================
+ * FUNCTION   : cam_parm_batch_add_get
+ *
+ * DESCRIPTION: request a parameter to be filled in by the backend
+ *
+ * PARAMETERS :
+ *   @p_table  : ptr to parameter buffer
+ *   @dirty    : dirty tracker of the batch, may be NULL
+ *   @param_id : parameter type
+ *
+ * RETURN     : int32_t type of status
+ *              0  -- success
+ *              -1 -- failure
+ *==========================================================================*/
+int32_t cam_parm_batch_add_get(parm_buffer_t *p_table,
+        cam_parm_dirty_t *dirty, cam_intf_parm_type_t param_id)
+{
+    if ((NULL == p_table) || (param_id >= CAM_INTF_PARM_MAX)) {
+        return -1;
+    }
+    p_table->is_reqd[param_id] = 1;
+    cam_parm_mark_dirty(dirty, param_id, 0);
+    return 0;
+}
+
+/*===========================================================================
+ * FUNCTION   : cam_parm_dirty_size
+ *
+ * DESCRIPTION: number of payload bytes set in the current batch
+ *
+ * PARAMETERS :
+ *   @dirty : dirty tracker of the batch
+ *
+ * RETURN     : size in bytes
+ *==========================================================================*/
+uint32_t cam_parm_dirty_size(const cam_parm_dirty_t *dirty)
+{
+    uint32_t i;
+    uint32_t size = 0;
+
+    if (NULL == dirty) {
+        return 0;
+    }
+    for (i = 0; i < dirty->num_entries; i++) {
+        size += dirty->length[dirty->ids[i]];
+    }
+    return size;
+}
+
+/*===========================================================================
+ * FUNCTION   : cam_parm_delta_size
+ *
+ * DESCRIPTION: number of bytes the delta encoding of a batch occupies
+ *
+ * PARAMETERS :
+ *   @dirty : dirty tracker of the batch
+ *
+ * RETURN     : size in bytes
+ *==========================================================================*/
+uint32_t cam_parm_delta_size(const cam_parm_dirty_t *dirty)
+{
+    uint32_t i;
+    uint32_t size = 0;
+
+    if (NULL == dirty) {
+        return 0;
+    }
+    for (i = 0; i < dirty->num_entries; i++) {
+        size += sizeof(cam_parm_delta_entry_t) +
+            CAM_PARM_DELTA_PAD(dirty->length[dirty->ids[i]]);
+    }
+    return size;
+}
+
+/*===========================================================================
+ * FUNCTION   : cam_parm_delta_encode
+ *
+ * DESCRIPTION: encode the entries of a batch as a TLV delta. With a dirty
+ *              tracker only the changed entries and their set length are
+ *              carried, otherwise every valid entry is encoded at full size.
+ *
+ * PARAMETERS :
+ *   @p_table : ptr to parameter buffer
+ *   @dirty   : dirty tracker of the batch, may be NULL
+ *   @delta   : delta to encode into, data and capacity set by caller
+ *
+ * RETURN     : int32_t type of status
+ *              0  -- success
+ *              -1 -- failure
+ *==========================================================================*/
+int32_t cam_parm_delta_encode(const parm_buffer_t *p_table,
+        const cam_parm_dirty_t *dirty, cam_parm_delta_t *delta)
+{
+    cam_parm_delta_entry_t entry;
+    uint32_t i, count, padded;
+    const void *src;
+
+    if ((NULL == p_table) || (NULL == delta) || (NULL == delta->data)) {
+        return -1;
+    }
+    delta->size = 0;
+    delta->num_entries = 0;
+
+    count = (NULL != dirty) ? dirty->num_entries : CAM_INTF_PARM_MAX;
+    for (i = 0; i < count; i++) {
+        if (NULL != dirty) {
+            entry.param_id = dirty->ids[i];
+            entry.length = dirty->length[entry.param_id];
+        } else {
+            if (!p_table->is_valid[i]) {
+                continue;
+            }
+            entry.param_id = i;
+            entry.length = get_size_of((cam_intf_parm_type_t)i);
+        }
+
+        padded = CAM_PARM_DELTA_PAD(entry.length);
+        if (delta->capacity - delta->size < sizeof(entry) + padded) {
+            return -1;
+        }
+        memcpy(delta->data + delta->size, &entry, sizeof(entry));
+        delta->size += sizeof(entry);
+        if (entry.length > 0) {
+            src = get_pointer_of((cam_intf_parm_type_t)entry.param_id,
+                p_table);
+            if (NULL == src) {
+                return -1;
+            }
+            memcpy(delta->data + delta->size, src, entry.length);
+            memset(delta->data + delta->size + entry.length, 0,
+                padded - entry.length);
+            delta->size += padded;
+        }
+        delta->num_entries++;
+    }
+    return 0;
+}
+
+/*===========================================================================
+ * FUNCTION   : cam_parm_delta_decode
+ *
+ * DESCRIPTION: apply a TLV delta onto a flat parameter table. Valid flags of
+ *              the table are reset so it reflects exactly the delta batch.
+ *
+ * PARAMETERS :
+ *   @delta   : encoded delta batch
+ *   @p_table : ptr to parameter buffer to apply to
+ *
+ * RETURN     : int32_t type of status
+ *              0  -- success
+ *              -1 -- failure, malformed delta
+ *==========================================================================*/
+int32_t cam_parm_delta_decode(const cam_parm_delta_t *delta,
+        parm_buffer_t *p_table)
+{
+    cam_parm_delta_entry_t entry;
+    uint32_t i, offset = 0, padded, max_size;
+    uint8_t *dst;
+
+    if ((NULL == delta) || (NULL == p_table) ||
+        ((NULL == delta->data) && (delta->num_entries > 0))) {
+        return -1;
+    }
+    memset(p_table->is_valid, 0, sizeof(p_table->is_valid));
+    p_table->is_tuning_params_valid = 0;
+
+    for (i = 0; i < delta->num_entries; i++) {
+        if (delta->size - offset < sizeof(entry)) {
+            return -1;
+        }
+        memcpy(&entry, delta->data + offset, sizeof(entry));
+        offset += sizeof(entry);
+        if (entry.param_id >= CAM_INTF_PARM_MAX) {
+            return -1;
+        }
+
+        if (entry.length == 0) {
+            p_table->is_reqd[entry.param_id] = 1;
+            continue;
+        }
+        max_size = get_size_of((cam_intf_parm_type_t)entry.param_id);
+        padded = CAM_PARM_DELTA_PAD(entry.length);
+        if ((entry.length > max_size) || (delta->size - offset < padded)) {
+            return -1;
+        }
+        dst = (uint8_t *)get_pointer_of((cam_intf_parm_type_t)entry.param_id,
+            p_table);
+        if (NULL == dst) {
+            return -1;
+        }
+        memcpy(dst, delta->data + offset, entry.length);
+        if (entry.length < max_size) {
+            memset(dst + entry.length, 0, max_size - entry.length);
+        }
+        p_table->is_valid[entry.param_id] = 1;
+        offset += padded;
+    }
+    return 0;
+}
+
+/*===========================================================================
+ * FUNCTION   : cam_intf_build_valid_map
+ *
+ * DESCRIPTION: pack the is_valid table of a metadata buffer into one bit per
+ *              param id, eight flags per step, so that consumers can visit
+ *              only the entries present in the frame.
+ *
+ * PARAMETERS :
+ *   @metadata : metadata buffer
+ *   @map      : bitmap to fill
+ *
+ * RETURN     : number of valid entries
+ *==========================================================================*/
+uint32_t cam_intf_build_valid_map(const metadata_buffer_t *metadata,
+        cam_intf_valid_map_t *map)
+{
+    const uint64_t low7 = 0x7F7F7F7F7F7F7F7FULL;
+    const uint8_t *flags = metadata->is_valid;
+    uint64_t chunk;
+    uint32_t i, bits, count = 0;
+
+    memset(map, 0, sizeof(cam_intf_valid_map_t));
+    for (i = 0; i + 8 <= CAM_INTF_PARM_MAX; i += 8) {
+        memcpy(&chunk, flags + i, sizeof(chunk));
+        if (chunk == 0) {
+            continue;
+        }
+        /* high bit of every non zero flag byte, then gather the eight
+         * flags of the little endian chunk into the top byte, flag n
+         * landing in bit n */
+        chunk = (((chunk & low7) + low7) | chunk) & ~low7;
+        bits = (uint32_t)(((chunk >> 7) * 0x0102040810204080ULL) >> 56);
+        map->bits[i / 32] |= bits << (i % 32);
+        count += (uint32_t)__builtin_popcount(bits);
+    }
+    for (; i < CAM_INTF_PARM_MAX; i++) {
+        if (flags[i]) {
+            map->bits[i / 32] |= 1U << (i % 32);
+            count++;
+        }
+    }
+    return count;
+}
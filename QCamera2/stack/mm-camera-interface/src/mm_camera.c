@@ -34,6 +34,8 @@
 #include <sys/stat.h>
 #include <fcntl.h>
 #include <poll.h>
+#include <cutils/properties.h>
+#include <stdlib.h>
 
 #include <cam_semaphore.h>
 
@@ -238,6 +240,7 @@ int32_t mm_camera_open(mm_camera_obj_t *my_obj)
     uint8_t sleep_msec=MM_CAMERA_DEV_OPEN_RETRY_SLEEP;
     int cam_idx = 0;
     const char *dev_name_value = NULL;
+    char prop[PROPERTY_VALUE_MAX];
 
     CDBG("%s:  begin\n", __func__);
 
@@ -296,6 +299,20 @@ int32_t mm_camera_open(mm_camera_obj_t *my_obj)
     }
     pthread_mutex_init(&my_obj->msg_lock, NULL);
 
+    /* a server without bundled mapping never answers the bundled packets,
+     * only use them when the daemon is known to handle them */
+    property_get("persist.camera.bundled_map", prop, "0");
+    my_obj->bundled_map = (uint8_t)(atoi(prop) > 0);
+    CDBG_HIGH("%s: bundled buffer mapping %s", __func__,
+            my_obj->bundled_map ? "enabled" : "disabled");
+
+    /* same for delta parm batches, otherwise set_parms_delta sends the
+     * flat parm buffer */
+    property_get("persist.camera.parm_delta", prop, "0");
+    my_obj->parm_delta = (uint8_t)(atoi(prop) > 0);
+    CDBG_HIGH("%s: delta parm batches %s", __func__,
+            my_obj->parm_delta ? "enabled" : "disabled");
+
     pthread_mutex_init(&my_obj->cb_lock, NULL);
     pthread_mutex_init(&my_obj->evt_lock, NULL);
     pthread_cond_init(&my_obj->evt_cond, NULL);
@@ -557,6 +574,53 @@ int32_t mm_camera_set_parms(mm_camera_obj_t *my_obj,
     return rc;
 }
 
+/*===========================================================================
+ * FUNCTION   : mm_camera_set_parms_delta
+ *
+ * DESCRIPTION: set parameters per camera, sending only the entries changed
+ *              in the batch as a TLV delta via domain socket. Falls back to
+ *              mm_camera_set_parms when the server does not handle delta
+ *              batches or the delta does not fit in one packet.
+ *
+ * PARAMETERS :
+ *   @my_obj       : camera object
+ *   @parms        : ptr to a param struct to be set to server
+ *   @dirty        : dirty tracker of the batch in parms
+ *
+ * RETURN     : int32_t type of status
+ *              0  -- success
+ *              -1 -- failure
+ *==========================================================================*/
+int32_t mm_camera_set_parms_delta(mm_camera_obj_t *my_obj,
+                                  parm_buffer_t *parms,
+                                  const cam_parm_dirty_t *dirty)
+{
+    int32_t rc = -1;
+    cam_parm_delta_t delta;
+    cam_sock_parm_delta_packet_t *packet = &my_obj->parm_delta_packet;
+
+    if ((NULL == parms) || (NULL == dirty) || !my_obj->parm_delta ||
+        (cam_parm_delta_size(dirty) > CAM_PARM_DELTA_MAX_SIZE)) {
+        return mm_camera_set_parms(my_obj, parms);
+    }
+
+    memset(&delta, 0, sizeof(cam_parm_delta_t));
+    delta.data = packet->data;
+    delta.capacity = CAM_PARM_DELTA_MAX_SIZE;
+    if (cam_parm_delta_encode(parms, dirty, &delta) < 0) {
+        CDBG_ERROR("%s: failed to encode delta of %u params",
+                   __func__, dirty->num_entries);
+        return mm_camera_set_parms(my_obj, parms);
+    }
+    packet->msg_type = CAM_MAPPING_TYPE_PARM_DELTA;
+    packet->size = delta.size;
+    packet->num_entries = delta.num_entries;
+    rc = mm_camera_util_sendmsg(my_obj, packet,
+                                CAM_PARM_DELTA_PACKET_SIZE(delta.size), -1);
+    pthread_mutex_unlock(&my_obj->cam_lock);
+    return rc;
+}
+
 /*===========================================================================
  * FUNCTION   : mm_camera_get_parms
  *
@@ -1488,6 +1552,84 @@ int32_t mm_camera_unmap_stream_buf(mm_camera_obj_t *my_obj,
     return rc;
 }
 
+/*===========================================================================
+ * FUNCTION   : mm_camera_map_stream_bufs
+ *
+ * DESCRIPTION: mapping a list of stream buffers via domain socket to server
+ *              with a single message
+ *
+ * PARAMETERS :
+ *   @my_obj       : camera object
+ *   @ch_id        : channel handle
+ *   @buf_map_list : buffers to be mapped, stream_id of each entry is the
+ *                   stream handle
+ *
+ * RETURN     : int32_t type of status
+ *              0  -- success
+ *              -1 -- failure
+ *==========================================================================*/
+int32_t mm_camera_map_stream_bufs(mm_camera_obj_t *my_obj,
+                                  uint32_t ch_id,
+                                  const cam_buf_map_type_list *buf_map_list)
+{
+    int32_t rc = -1;
+    mm_channel_t * ch_obj =
+        mm_camera_util_get_channel_by_handler(my_obj, ch_id);
+
+    if (NULL != ch_obj) {
+        pthread_mutex_lock(&ch_obj->ch_lock);
+        pthread_mutex_unlock(&my_obj->cam_lock);
+
+        rc = mm_channel_fsm_fn(ch_obj,
+                               MM_CHANNEL_EVT_MAP_STREAM_BUFS,
+                               (void*)buf_map_list,
+                               NULL);
+    } else {
+        pthread_mutex_unlock(&my_obj->cam_lock);
+    }
+
+    return rc;
+}
+
+/*===========================================================================
+ * FUNCTION   : mm_camera_unmap_stream_bufs
+ *
+ * DESCRIPTION: unmapping a list of stream buffers via domain socket to
+ *              server with a single message
+ *
+ * PARAMETERS :
+ *   @my_obj         : camera object
+ *   @ch_id          : channel handle
+ *   @buf_unmap_list : buffers to be unmapped, stream_id of each entry is
+ *                     the stream handle
+ *
+ * RETURN     : int32_t type of status
+ *              0  -- success
+ *              -1 -- failure
+ *==========================================================================*/
+int32_t mm_camera_unmap_stream_bufs(mm_camera_obj_t *my_obj,
+                                    uint32_t ch_id,
+                                    const cam_buf_unmap_type_list *buf_unmap_list)
+{
+    int32_t rc = -1;
+    mm_channel_t * ch_obj =
+        mm_camera_util_get_channel_by_handler(my_obj, ch_id);
+
+    if (NULL != ch_obj) {
+        pthread_mutex_lock(&ch_obj->ch_lock);
+        pthread_mutex_unlock(&my_obj->cam_lock);
+
+        rc = mm_channel_fsm_fn(ch_obj,
+                               MM_CHANNEL_EVT_UNMAP_STREAM_BUFS,
+                               (void*)buf_unmap_list,
+                               NULL);
+    } else {
+        pthread_mutex_unlock(&my_obj->cam_lock);
+    }
+
+    return rc;
+}
+
 /*===========================================================================
  * FUNCTION   : mm_camera_evt_sub
  *
@@ -1601,6 +1743,53 @@ int32_t mm_camera_util_sendmsg(mm_camera_obj_t *my_obj,
     return rc;
 }
 
+/*===========================================================================
+ * FUNCTION   : mm_camera_util_bundled_sendmsg
+ *
+ * DESCRIPTION: utility function to send a bundled msg carrying several file
+ *              descriptors via domain socket. Server answers the whole
+ *              bundle with one map/unmap done event. Fails without sending
+ *              when bundled mapping is not enabled for the server.
+ *
+ * PARAMETERS :
+ *   @my_obj       : camera object
+ *   @msg          : message to be sent
+ *   @buf_size     : size of the message to be sent
+ *   @sendfds      : file descriptors to be passed across process
+ *   @numfds       : number of file descriptors, 0 for unmapping
+ *
+ * RETURN     : int32_t type of status
+ *              0  -- success
+ *              -1 -- failure
+ *==========================================================================*/
+int32_t mm_camera_util_bundled_sendmsg(mm_camera_obj_t *my_obj,
+                                       void *msg,
+                                       size_t buf_size,
+                                       int sendfds[CAM_MAX_NUM_BUFS_PER_MAP],
+                                       int numfds)
+{
+    int32_t rc = -1;
+    uint32_t status;
+
+    if (!my_obj->bundled_map) {
+        CDBG("%s: bundled mapping not supported by server", __func__);
+        return -1;
+    }
+
+    /* need to lock msg_lock, since sendmsg until reposonse back is deemed as one operation*/
+    pthread_mutex_lock(&my_obj->msg_lock);
+    if(mm_camera_socket_bundle_sendmsg(my_obj->ds_fd, msg, buf_size,
+            sendfds, numfds) > 0) {
+        /* wait for event that mapping/unmapping is done */
+        mm_camera_util_wait_for_event(my_obj, CAM_EVENT_TYPE_MAP_UNMAP_DONE, &status);
+        if (MSM_CAMERA_STATUS_SUCCESS == status) {
+            rc = 0;
+        }
+    }
+    pthread_mutex_unlock(&my_obj->msg_lock);
+    return rc;
+}
+
 /*===========================================================================
  * FUNCTION   : mm_camera_map_buf
  *
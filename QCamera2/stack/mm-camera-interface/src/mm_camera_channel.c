@@ -82,6 +82,10 @@ int32_t mm_channel_map_stream_buf(mm_channel_t *my_obj,
                                   mm_evt_paylod_map_stream_buf_t *payload);
 int32_t mm_channel_unmap_stream_buf(mm_channel_t *my_obj,
                                     mm_evt_paylod_unmap_stream_buf_t *payload);
+int32_t mm_channel_map_stream_bufs(mm_channel_t *my_obj,
+                                   const cam_buf_map_type_list *payload);
+int32_t mm_channel_unmap_stream_bufs(mm_channel_t *my_obj,
+                                     const cam_buf_unmap_type_list *payload);
 
 /* state machine function declare */
 int32_t mm_channel_fsm_fn_notused(mm_channel_t *my_obj,
@@ -609,6 +613,20 @@ int32_t mm_channel_fsm_fn_stopped(mm_channel_t *my_obj,
             rc = mm_channel_unmap_stream_buf(my_obj, payload);
         }
         break;
+    case MM_CHANNEL_EVT_MAP_STREAM_BUFS:
+        {
+            const cam_buf_map_type_list *payload =
+                (const cam_buf_map_type_list *)in_val;
+            rc = mm_channel_map_stream_bufs(my_obj, payload);
+        }
+        break;
+    case MM_CHANNEL_EVT_UNMAP_STREAM_BUFS:
+        {
+            const cam_buf_unmap_type_list *payload =
+                (const cam_buf_unmap_type_list *)in_val;
+            rc = mm_channel_unmap_stream_bufs(my_obj, payload);
+        }
+        break;
     default:
         CDBG_ERROR("%s: invalid state (%d) for evt (%d)",
                    __func__, my_obj->state, evt);
@@ -736,6 +754,50 @@ int32_t mm_channel_fsm_fn_active(mm_channel_t *my_obj,
             }
         }
         break;
+    case MM_CHANNEL_EVT_MAP_STREAM_BUFS:
+        {
+            const cam_buf_map_type_list *payload =
+                (const cam_buf_map_type_list *)in_val;
+            uint32_t i;
+            rc = -1;
+            if (payload != NULL) {
+                for (i = 0; i < payload->length; i++) {
+                    cam_mapping_buf_type type = payload->buf_maps[i].type;
+                    if ((type != CAM_MAPPING_BUF_TYPE_OFFLINE_INPUT_BUF) &&
+                            (type != CAM_MAPPING_BUF_TYPE_OFFLINE_META_BUF)) {
+                        break;
+                    }
+                }
+                if (i == payload->length) {
+                    rc = mm_channel_map_stream_bufs(my_obj, payload);
+                } else {
+                    CDBG_ERROR("%s: cannot map regualr stream buf in active state", __func__);
+                }
+            }
+        }
+        break;
+    case MM_CHANNEL_EVT_UNMAP_STREAM_BUFS:
+        {
+            const cam_buf_unmap_type_list *payload =
+                (const cam_buf_unmap_type_list *)in_val;
+            uint32_t i;
+            rc = -1;
+            if (payload != NULL) {
+                for (i = 0; i < payload->length; i++) {
+                    cam_mapping_buf_type type = payload->buf_unmaps[i].type;
+                    if ((type != CAM_MAPPING_BUF_TYPE_OFFLINE_INPUT_BUF) &&
+                            (type != CAM_MAPPING_BUF_TYPE_OFFLINE_META_BUF)) {
+                        break;
+                    }
+                }
+                if (i == payload->length) {
+                    rc = mm_channel_unmap_stream_bufs(my_obj, payload);
+                } else {
+                    CDBG_ERROR("%s: cannot unmap regualr stream buf in active state", __func__);
+                }
+            }
+        }
+        break;
     case MM_CHANNEL_EVT_AF_BRACKETING:
         {
             CDBG_HIGH("MM_CHANNEL_EVT_AF_BRACKETING");
@@ -1687,6 +1749,104 @@ int32_t mm_channel_unmap_stream_buf(mm_channel_t *my_obj,
     return rc;
 }
 
+/*===========================================================================
+ * FUNCTION   : mm_channel_map_stream_bufs
+ *
+ * DESCRIPTION: mapping a list of stream buffers of this channel via domain
+ *              socket to server in one message
+ *
+ * PARAMETERS :
+ *   @my_obj       : channel object
+ *   @payload      : list of buffers, stream_id is the stream handler
+ *
+ * RETURN     : int32_t type of status
+ *              0  -- success
+ *              -1 -- failure
+ *==========================================================================*/
+int32_t mm_channel_map_stream_bufs(mm_channel_t *my_obj,
+                                   const cam_buf_map_type_list *payload)
+{
+    cam_sock_bundled_packet_t packet;
+    int sendfds[CAM_MAX_NUM_BUFS_PER_MAP];
+    uint32_t i;
+
+    if ((NULL == payload) || (0 == payload->length) ||
+            (payload->length > CAM_MAX_NUM_BUFS_PER_MAP)) {
+        CDBG_ERROR("%s: invalid buf map list", __func__);
+        return -1;
+    }
+
+    memset(&packet, 0, sizeof(cam_sock_bundled_packet_t));
+    packet.msg_type = CAM_MAPPING_TYPE_FD_BUNDLED_MAPPING;
+    packet.payload.buf_map_list = *payload;
+    for (i = 0; i < payload->length; i++) {
+        mm_stream_t* s_obj = mm_channel_util_get_stream_by_handler(my_obj,
+                payload->buf_maps[i].stream_id);
+        if (NULL == s_obj) {
+            CDBG_ERROR("%s: no stream for handle %d", __func__,
+                    payload->buf_maps[i].stream_id);
+            return -1;
+        }
+        packet.payload.buf_map_list.buf_maps[i].stream_id =
+                s_obj->server_stream_id;
+        sendfds[i] = payload->buf_maps[i].fd;
+    }
+
+    return mm_camera_util_bundled_sendmsg(my_obj->cam_obj,
+                                          &packet,
+                                          sizeof(cam_sock_bundled_packet_t),
+                                          sendfds,
+                                          (int)payload->length);
+}
+
+/*===========================================================================
+ * FUNCTION   : mm_channel_unmap_stream_bufs
+ *
+ * DESCRIPTION: unmapping a list of stream buffers of this channel via
+ *              domain socket to server in one message
+ *
+ * PARAMETERS :
+ *   @my_obj       : channel object
+ *   @payload      : list of buffers, stream_id is the stream handler
+ *
+ * RETURN     : int32_t type of status
+ *              0  -- success
+ *              -1 -- failure
+ *==========================================================================*/
+int32_t mm_channel_unmap_stream_bufs(mm_channel_t *my_obj,
+                                     const cam_buf_unmap_type_list *payload)
+{
+    cam_sock_bundled_packet_t packet;
+    uint32_t i;
+
+    if ((NULL == payload) || (0 == payload->length) ||
+            (payload->length > CAM_MAX_NUM_BUFS_PER_MAP)) {
+        CDBG_ERROR("%s: invalid buf unmap list", __func__);
+        return -1;
+    }
+
+    memset(&packet, 0, sizeof(cam_sock_bundled_packet_t));
+    packet.msg_type = CAM_MAPPING_TYPE_FD_BUNDLED_UNMAPPING;
+    packet.payload.buf_unmap_list = *payload;
+    for (i = 0; i < payload->length; i++) {
+        mm_stream_t* s_obj = mm_channel_util_get_stream_by_handler(my_obj,
+                payload->buf_unmaps[i].stream_id);
+        if (NULL == s_obj) {
+            CDBG_ERROR("%s: no stream for handle %d", __func__,
+                    payload->buf_unmaps[i].stream_id);
+            return -1;
+        }
+        packet.payload.buf_unmap_list.buf_unmaps[i].stream_id =
+                s_obj->server_stream_id;
+    }
+
+    return mm_camera_util_bundled_sendmsg(my_obj->cam_obj,
+                                          &packet,
+                                          sizeof(cam_sock_bundled_packet_t),
+                                          NULL,
+                                          0);
+}
+
 /*===========================================================================
  * FUNCTION   : mm_channel_superbuf_queue_init
  *
@@ -1701,6 +1861,9 @@ int32_t mm_channel_unmap_stream_buf(mm_channel_t *my_obj,
  *==========================================================================*/
 int32_t mm_channel_superbuf_queue_init(mm_channel_queue_t * queue)
 {
+    memset(queue->unmatched_hash, 0, sizeof(queue->unmatched_hash));
+    cam_list_init(&queue->unmatched_list);
+    queue->unmatched_cnt = 0;
     return cam_queue_init(&queue->que);
 }
 
@@ -1718,7 +1881,13 @@ int32_t mm_channel_superbuf_queue_init(mm_channel_queue_t * queue)
  *==========================================================================*/
 int32_t mm_channel_superbuf_queue_deinit(mm_channel_queue_t * queue)
 {
-    return cam_queue_deinit(&queue->que);
+    int32_t rc = cam_queue_deinit(&queue->que);
+
+    /* superbufs were freed along with the queue nodes */
+    memset(queue->unmatched_hash, 0, sizeof(queue->unmatched_hash));
+    cam_list_init(&queue->unmatched_list);
+    queue->unmatched_cnt = 0;
+    return rc;
 }
 
 /*===========================================================================
@@ -1958,6 +2127,153 @@ end:
     return rc;
 }
 
+/*===========================================================================
+ * FUNCTION   : mm_channel_superbuf_index_find
+ *
+ * DESCRIPTION: look up an unmatched superbuf by frame idx
+ *
+ * PARAMETERS :
+ *   @queue   : superbuf queue
+ *   @frame_idx : frame idx to look up
+ *
+ * RETURN     : ptr to the unmatched superbuf, NULL if none
+ *==========================================================================*/
+static mm_channel_queue_node_t* mm_channel_superbuf_index_find(
+                        mm_channel_queue_t *queue,
+                        uint32_t frame_idx)
+{
+    mm_channel_queue_node_t *super_buf =
+        queue->unmatched_hash[frame_idx & (MM_CHANNEL_SUPERBUF_HASH_SIZE - 1)];
+
+    while (NULL != super_buf && super_buf->frame_idx != frame_idx) {
+        super_buf = super_buf->hash_next;
+    }
+    return super_buf;
+}
+
+/*===========================================================================
+ * FUNCTION   : mm_channel_superbuf_index_add
+ *
+ * DESCRIPTION: add an unmatched superbuf to the index. The unmatched list is
+ *              kept in frame idx order; frames normally arrive in order, so
+ *              the backward scan from the tail stops right away.
+ *
+ * PARAMETERS :
+ *   @queue   : superbuf queue
+ *   @super_buf : unmatched superbuf
+ *
+ * RETURN     : ptr to the next newer unmatched superbuf, NULL if none
+ *==========================================================================*/
+static mm_channel_queue_node_t* mm_channel_superbuf_index_add(
+                        mm_channel_queue_t *queue,
+                        mm_channel_queue_node_t *super_buf)
+{
+    struct cam_list *head = &queue->unmatched_list;
+    struct cam_list *pos = head->prev;
+    mm_channel_queue_node_t *prev_buf = NULL;
+    uint32_t bucket = super_buf->frame_idx & (MM_CHANNEL_SUPERBUF_HASH_SIZE - 1);
+
+    super_buf->hash_next = queue->unmatched_hash[bucket];
+    queue->unmatched_hash[bucket] = super_buf;
+
+    while (pos != head) {
+        prev_buf = member_of(pos, mm_channel_queue_node_t, unmatched);
+        if (mm_channel_util_seq_comp_w_rollover(prev_buf->frame_idx,
+                                                super_buf->frame_idx) < 0) {
+            break;
+        }
+        pos = pos->prev;
+    }
+    /* insert after pos */
+    cam_list_insert_before_node(&super_buf->unmatched, pos->next);
+    queue->unmatched_cnt++;
+
+    if (super_buf->unmatched.next == head) {
+        return NULL;
+    }
+    return member_of(super_buf->unmatched.next, mm_channel_queue_node_t, unmatched);
+}
+
+/*===========================================================================
+ * FUNCTION   : mm_channel_superbuf_index_del
+ *
+ * DESCRIPTION: remove an unmatched superbuf from the index
+ *
+ * PARAMETERS :
+ *   @queue   : superbuf queue
+ *   @super_buf : unmatched superbuf
+ *
+ * RETURN     : none
+ *==========================================================================*/
+static void mm_channel_superbuf_index_del(mm_channel_queue_t *queue,
+                                          mm_channel_queue_node_t *super_buf)
+{
+    mm_channel_queue_node_t **pp = &queue->unmatched_hash[
+        super_buf->frame_idx & (MM_CHANNEL_SUPERBUF_HASH_SIZE - 1)];
+
+    while (NULL != *pp) {
+        if (*pp == super_buf) {
+            *pp = super_buf->hash_next;
+            break;
+        }
+        pp = &(*pp)->hash_next;
+    }
+    super_buf->hash_next = NULL;
+    cam_list_del_node(&super_buf->unmatched);
+    queue->unmatched_cnt--;
+}
+
+/*===========================================================================
+ * FUNCTION   : mm_channel_superbuf_index_oldest
+ *
+ * DESCRIPTION: get the oldest unmatched superbuf
+ *
+ * PARAMETERS :
+ *   @queue   : superbuf queue
+ *
+ * RETURN     : ptr to the oldest unmatched superbuf, NULL if none
+ *==========================================================================*/
+static mm_channel_queue_node_t* mm_channel_superbuf_index_oldest(
+                        mm_channel_queue_t *queue)
+{
+    if (queue->unmatched_list.next == &queue->unmatched_list) {
+        return NULL;
+    }
+    return member_of(queue->unmatched_list.next,
+                     mm_channel_queue_node_t, unmatched);
+}
+
+/*===========================================================================
+ * FUNCTION   : mm_channel_superbuf_release_unmatched
+ *
+ * DESCRIPTION: return the bufs of an unmatched superbuf to the kernel and
+ *              remove it from the queue. Caller holds queue lock.
+ *
+ * PARAMETERS :
+ *   @ch_obj  : channel object
+ *   @queue   : superbuf queue
+ *   @super_buf : unmatched superbuf to be released
+ *
+ * RETURN     : none
+ *==========================================================================*/
+static void mm_channel_superbuf_release_unmatched(mm_channel_t *ch_obj,
+                                                  mm_channel_queue_t *queue,
+                                                  mm_channel_queue_node_t *super_buf)
+{
+    uint8_t i;
+
+    for (i=0; i<super_buf->num_of_bufs; i++) {
+        if (super_buf->super_buf[i].frame_idx != 0) {
+            mm_channel_qbuf(ch_obj, super_buf->super_buf[i].buf);
+        }
+    }
+    mm_channel_superbuf_index_del(queue, super_buf);
+    cam_list_del_node(&super_buf->q_node->list);
+    queue->que.size--;
+    free(super_buf->q_node);
+    free(super_buf);
+}
+
 /*===========================================================================
  * FUNCTION   : mm_channel_superbuf_comp_and_enqueue
  *
@@ -1977,12 +2293,10 @@ int32_t mm_channel_superbuf_comp_and_enqueue(
                         mm_channel_queue_t *queue,
                         mm_camera_buf_info_t *buf_info)
 {
-    cam_node_t* node = NULL;
-    struct cam_list *head = NULL;
-    struct cam_list *pos = NULL;
     mm_channel_queue_node_t* super_buf = NULL;
-    uint8_t buf_s_idx, i, found_super_buf, unmatched_bundles;
-    struct cam_list *last_buf, *insert_before_buf;
+    mm_channel_queue_node_t* oldest_buf = NULL;
+    mm_channel_queue_node_t* next_buf = NULL;
+    uint8_t buf_s_idx, i;
 
     CDBG("%s: E", __func__);
     for (buf_s_idx = 0; buf_s_idx < queue->num_streams; buf_s_idx++) {
@@ -2029,44 +2343,17 @@ int32_t mm_channel_superbuf_comp_and_enqueue(
 
     /* comp */
     pthread_mutex_lock(&queue->que.lock);
-    head = &queue->que.head.list;
-    /* get the last one in the queue which is possibly having no matching */
-    pos = head->next;
-
-    found_super_buf = 0;
-    unmatched_bundles = 0;
-    last_buf = NULL;
-    insert_before_buf = NULL;
-    while (pos != head) {
-        node = member_of(pos, cam_node_t, list);
-        super_buf = (mm_channel_queue_node_t*)node->data;
-        if (NULL != super_buf) {
-            if (super_buf->matched) {
-                /* find a matched super buf, move to next one */
-                pos = pos->next;
-                continue;
-            } else if ( buf_info->frame_idx == super_buf->frame_idx ) {
-                /* have an unmatched super buf that matches our frame idx,
-                 *  break the loop */
-                found_super_buf = 1;
-                break;
-            } else {
-                unmatched_bundles++;
-                if ( NULL == last_buf ) {
-                    if ( super_buf->frame_idx < buf_info->frame_idx ) {
-                        last_buf = pos;
-                    }
-                }
-                if ( NULL == insert_before_buf ) {
-                    if ( super_buf->frame_idx > buf_info->frame_idx ) {
-                        insert_before_buf = pos;
-                    }
-                }
-                pos = pos->next;
-            }
-        }
+    super_buf = mm_channel_superbuf_index_find(queue, buf_info->frame_idx);
+
+    /* oldest unmatched superbuf, if it is older than the incoming frame */
+    oldest_buf = mm_channel_superbuf_index_oldest(queue);
+    if ((NULL != oldest_buf) &&
+        (mm_channel_util_seq_comp_w_rollover(oldest_buf->frame_idx,
+                                             buf_info->frame_idx) >= 0)) {
+        oldest_buf = NULL;
     }
-    if ( found_super_buf ) {
+
+    if (NULL != super_buf) {
             super_buf->super_buf[buf_s_idx] = *buf_info;
 
             /* check if superbuf is all matched */
@@ -2079,6 +2366,7 @@ int32_t mm_channel_superbuf_comp_and_enqueue(
             }
 
             if (super_buf->matched) {
+                mm_channel_superbuf_index_del(queue, super_buf);
                 if(ch_obj->isFlashBracketingEnabled) {
                    queue->expected_frame_id =
                        queue->expected_frame_id_without_led;
@@ -2096,48 +2384,25 @@ int32_t mm_channel_superbuf_comp_and_enqueue(
 
                 queue->match_cnt++;
                 /* Any older unmatched buffer need to be released */
-                if ( last_buf ) {
-                    while ( last_buf != pos ) {
-                        node = member_of(last_buf, cam_node_t, list);
-                        super_buf = (mm_channel_queue_node_t*)node->data;
-                        if (NULL != super_buf) {
-                            for (i=0; i<super_buf->num_of_bufs; i++) {
-                                if (super_buf->super_buf[i].frame_idx != 0) {
-                                        mm_channel_qbuf(ch_obj, super_buf->super_buf[i].buf);
-                                }
-                            }
-                            queue->que.size--;
-                            last_buf = last_buf->next;
-                            cam_list_del_node(&node->list);
-                            free(node);
-                            free(super_buf);
-                        } else {
-                            CDBG_ERROR(" %s : Invalid superbuf in queue!", __func__);
-                            break;
-                        }
+                while (NULL != oldest_buf) {
+                    mm_channel_superbuf_release_unmatched(ch_obj, queue, oldest_buf);
+                    oldest_buf = mm_channel_superbuf_index_oldest(queue);
+                    if ((NULL != oldest_buf) &&
+                        (mm_channel_util_seq_comp_w_rollover(oldest_buf->frame_idx,
+                                                             buf_info->frame_idx) >= 0)) {
+                        oldest_buf = NULL;
                     }
                 }
             }
     } else {
-        if (  ( queue->attr.max_unmatched_frames < unmatched_bundles ) &&
-              ( NULL == last_buf ) ) {
+        if (  ( queue->attr.max_unmatched_frames < queue->unmatched_cnt ) &&
+              ( NULL == oldest_buf ) ) {
             /* incoming frame is older than the last bundled one */
             mm_channel_qbuf(ch_obj, buf_info->buf);
         } else {
-            if ( queue->attr.max_unmatched_frames < unmatched_bundles ) {
+            if ( queue->attr.max_unmatched_frames < queue->unmatched_cnt ) {
                 /* release the oldest bundled superbuf */
-                node = member_of(last_buf, cam_node_t, list);
-                super_buf = (mm_channel_queue_node_t*)node->data;
-                for (i=0; i<super_buf->num_of_bufs; i++) {
-                    if (super_buf->super_buf[i].frame_idx != 0) {
-                            mm_channel_qbuf(ch_obj, super_buf->super_buf[i].buf);
-                    }
-                }
-                queue->que.size--;
-                node = member_of(last_buf, cam_node_t, list);
-                cam_list_del_node(&node->list);
-                free(node);
-                free(super_buf);
+                mm_channel_superbuf_release_unmatched(ch_obj, queue, oldest_buf);
             }
             /* insert the new frame at the appropriate position. */
 
@@ -2150,23 +2415,29 @@ int32_t mm_channel_superbuf_comp_and_enqueue(
                 memset(new_buf, 0, sizeof(mm_channel_queue_node_t));
                 memset(new_node, 0, sizeof(cam_node_t));
                 new_node->data = (void *)new_buf;
+                new_buf->q_node = new_node;
+                cam_list_init(&new_buf->unmatched);
                 new_buf->num_of_bufs = queue->num_streams;
                 new_buf->super_buf[buf_s_idx] = *buf_info;
                 new_buf->frame_idx = buf_info->frame_idx;
-                /* enqueue */
-                if ( insert_before_buf ) {
-                    cam_list_insert_before_node(&new_node->list, insert_before_buf);
-                } else {
-                    cam_list_add_tail_node(&new_node->list, &queue->que.head.list);
-                }
-                queue->que.size++;
 
                 if(queue->num_streams == 1) {
                     new_buf->matched = 1;
+                    cam_list_add_tail_node(&new_node->list, &queue->que.head.list);
 
                     queue->expected_frame_id = buf_info->frame_idx + queue->attr.post_frame_skip;
                     queue->match_cnt++;
+                } else {
+                    /* enqueue ahead of the next newer unmatched superbuf */
+                    next_buf = mm_channel_superbuf_index_add(queue, new_buf);
+                    if ( NULL != next_buf ) {
+                        cam_list_insert_before_node(&new_node->list,
+                                                    &next_buf->q_node->list);
+                    } else {
+                        cam_list_add_tail_node(&new_node->list, &queue->que.head.list);
+                    }
                 }
+                queue->que.size++;
             } else {
                 /* No memory */
                 if (NULL != new_buf) {
@@ -2220,6 +2491,9 @@ mm_channel_queue_node_t* mm_channel_superbuf_dequeue_internal(mm_channel_queue_t
         }
         if (NULL != super_buf) {
             /* remove from the queue */
+            if (super_buf->matched == FALSE) {
+                mm_channel_superbuf_index_del(queue, super_buf);
+            }
             cam_list_del_node(&node->list);
             queue->que.size--;
             if (super_buf->matched == TRUE) {
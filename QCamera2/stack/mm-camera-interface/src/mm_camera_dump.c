@@ -0,0 +1,397 @@
+/* Copyright (c) 2014, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include <pthread.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/prctl.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <cam_list.h>
+
+#include "mm_camera_dbg.h"
+#include "mm_camera_dump.h"
+
+typedef struct {
+    struct cam_list list;
+    char path[MM_CAMERA_DUMP_MAX_PATH];
+    uint8_t *data;      /* staging buffer, kept for reuse */
+    size_t capacity;    /* allocated size of data */
+    size_t size;        /* bytes to write */
+} mm_camera_dump_job_t;
+
+typedef struct {
+    pthread_mutex_t lock;
+    pthread_cond_t job_cond;    /* pending job queued */
+    pthread_cond_t idle_cond;   /* writer went idle */
+    pthread_t pid;
+    struct cam_list free_jobs;
+    struct cam_list pending_jobs;
+    uint32_t busy;              /* job being written */
+    uint32_t copying;           /* jobs being staged, not queued yet */
+    size_t staged_bytes;        /* staging memory of all jobs */
+    mm_camera_dump_stats_t stats;
+    mm_camera_dump_job_t jobs[MM_CAMERA_DUMP_MAX_JOBS];
+} mm_camera_dump_t;
+
+static mm_camera_dump_t g_dump;
+static pthread_once_t g_dump_once = PTHREAD_ONCE_INIT;
+static int g_dump_started = 0;
+
+/*===========================================================================
+ * FUNCTION   : mm_camera_dump_write
+ *
+ * DESCRIPTION: write one staged frame into its file
+ *
+ * PARAMETERS :
+ *   @job     : job to be written
+ *
+ * RETURN     : int32_t type of status
+ *              0  -- success
+ *              -1 -- failure
+ *==========================================================================*/
+static int32_t mm_camera_dump_write(mm_camera_dump_job_t *job)
+{
+    size_t written = 0;
+    int fd = open(job->path, O_RDWR | O_CREAT | O_TRUNC, 0777);
+    if (fd < 0) {
+        CDBG_ERROR("%s: cannot open file %s for dumping", __func__, job->path);
+        return -1;
+    }
+
+    while (written < job->size) {
+        ssize_t len = write(fd, job->data + written, job->size - written);
+        if (len < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            CDBG_ERROR("%s: write to %s failed %d", __func__, job->path, errno);
+            break;
+        }
+        written += (size_t)len;
+    }
+    close(fd);
+
+    CDBG("%s: written %zu bytes to %s", __func__, written, job->path);
+    return (written == job->size) ? 0 : -1;
+}
+
+/*===========================================================================
+ * FUNCTION   : mm_camera_dump_thread
+ *
+ * DESCRIPTION: writer thread, writes queued frames in order
+ *
+ * PARAMETERS :
+ *   @data    : ptr to dump object
+ *
+ * RETURN     : none
+ *==========================================================================*/
+static void *mm_camera_dump_thread(void *data)
+{
+    mm_camera_dump_t *dump = (mm_camera_dump_t *)data;
+    mm_camera_dump_job_t *job = NULL;
+    int32_t rc = 0;
+
+    prctl(PR_SET_NAME, (unsigned long)"mm_cam_dump", 0, 0, 0);
+
+    pthread_mutex_lock(&dump->lock);
+    while (1) {
+        while (dump->pending_jobs.next == &dump->pending_jobs) {
+            pthread_cond_wait(&dump->job_cond, &dump->lock);
+        }
+        job = member_of(dump->pending_jobs.next, mm_camera_dump_job_t, list);
+        cam_list_del_node(&job->list);
+        dump->busy = 1;
+        pthread_mutex_unlock(&dump->lock);
+
+        rc = mm_camera_dump_write(job);
+
+        pthread_mutex_lock(&dump->lock);
+        if (0 == rc) {
+            dump->stats.written++;
+            dump->stats.bytes_written += job->size;
+        } else {
+            dump->stats.failed++;
+        }
+        cam_list_add_tail_node(&job->list, &dump->free_jobs);
+        dump->busy = 0;
+        if (dump->pending_jobs.next == &dump->pending_jobs) {
+            pthread_cond_broadcast(&dump->idle_cond);
+        }
+    }
+    pthread_mutex_unlock(&dump->lock);
+    return NULL;
+}
+
+/*===========================================================================
+ * FUNCTION   : mm_camera_dump_init
+ *
+ * DESCRIPTION: set up the dump object and launch the writer thread
+ *
+ * PARAMETERS : none
+ *
+ * RETURN     : none
+ *==========================================================================*/
+static void mm_camera_dump_init(void)
+{
+    mm_camera_dump_t *dump = &g_dump;
+    uint32_t i;
+
+    memset(dump, 0, sizeof(mm_camera_dump_t));
+    pthread_mutex_init(&dump->lock, NULL);
+    pthread_cond_init(&dump->job_cond, NULL);
+    pthread_cond_init(&dump->idle_cond, NULL);
+    cam_list_init(&dump->free_jobs);
+    cam_list_init(&dump->pending_jobs);
+    for (i = 0; i < MM_CAMERA_DUMP_MAX_JOBS; i++) {
+        cam_list_add_tail_node(&dump->jobs[i].list, &dump->free_jobs);
+    }
+
+    if (pthread_create(&dump->pid, NULL, mm_camera_dump_thread,
+            (void *)dump) != 0) {
+        CDBG_ERROR("%s: cannot launch dump thread", __func__);
+        return;
+    }
+    pthread_detach(dump->pid);
+    g_dump_started = 1;
+}
+
+/*===========================================================================
+ * FUNCTION   : mm_camera_dump_get_job
+ *
+ * DESCRIPTION: pick a free job for a frame, preferring one whose staging
+ *              buffer is already large enough. Staging buffers of other
+ *              free jobs are released if needed to stay within budget.
+ *              Called with dump lock held.
+ *
+ * PARAMETERS :
+ *   @dump    : ptr to dump object
+ *   @size    : bytes to be staged
+ *
+ * RETURN     : ptr to job, NULL if the frame has to be dropped
+ *==========================================================================*/
+static mm_camera_dump_job_t *mm_camera_dump_get_job(mm_camera_dump_t *dump,
+                                                    size_t size)
+{
+    mm_camera_dump_job_t *job = NULL;
+    mm_camera_dump_job_t *other = NULL;
+    struct cam_list *pos = NULL;
+
+    if (dump->free_jobs.next == &dump->free_jobs) {
+        return NULL;
+    }
+
+    for (pos = dump->free_jobs.next; pos != &dump->free_jobs; pos = pos->next) {
+        job = member_of(pos, mm_camera_dump_job_t, list);
+        if (job->capacity >= size) {
+            return job;
+        }
+    }
+
+    job = member_of(dump->free_jobs.next, mm_camera_dump_job_t, list);
+    for (pos = dump->free_jobs.next->next;
+            pos != &dump->free_jobs &&
+            dump->staged_bytes - job->capacity + size > MM_CAMERA_DUMP_BUDGET;
+            pos = pos->next) {
+        other = member_of(pos, mm_camera_dump_job_t, list);
+        dump->staged_bytes -= other->capacity;
+        free(other->data);
+        other->data = NULL;
+        other->capacity = 0;
+    }
+
+    /* A single frame larger than the budget is still staged */
+    if (dump->staged_bytes - job->capacity + size > MM_CAMERA_DUMP_BUDGET &&
+            dump->staged_bytes != job->capacity) {
+        return NULL;
+    }
+    return job;
+}
+
+/*===========================================================================
+ * FUNCTION   : mm_camera_dump_frame
+ *
+ * DESCRIPTION: queue a frame to be dumped into a file. Plane rows are
+ *              copied without their stride padding, the file is written
+ *              by the writer thread. The frame is dropped if no staging
+ *              buffer is free or the staging budget would be exceeded.
+ *
+ * PARAMETERS :
+ *   @path       : file path
+ *   @planes     : planes of the frame
+ *   @num_planes : number of planes
+ *
+ * RETURN     : int32_t type of status
+ *              0  -- success
+ *              -1 -- failure, frame dropped
+ *==========================================================================*/
+int32_t mm_camera_dump_frame(const char *path,
+                             const mm_camera_dump_plane_t *planes,
+                             uint32_t num_planes)
+{
+    mm_camera_dump_t *dump = &g_dump;
+    mm_camera_dump_job_t *job = NULL;
+    size_t size = 0;
+    uint8_t *dst = NULL;
+    uint32_t dropped;
+    uint32_t i;
+    size_t j;
+
+    if (NULL == path || NULL == planes || 0 == num_planes ||
+            num_planes > MM_CAMERA_DUMP_MAX_PLANES) {
+        CDBG_ERROR("%s: invalid dump request", __func__);
+        return -1;
+    }
+
+    pthread_once(&g_dump_once, mm_camera_dump_init);
+    if (!g_dump_started) {
+        return -1;
+    }
+
+    for (i = 0; i < num_planes; i++) {
+        size += planes[i].width * planes[i].height;
+    }
+
+    pthread_mutex_lock(&dump->lock);
+    if (dump->free_jobs.next == &dump->free_jobs) {
+        dropped = ++dump->stats.dropped;
+        pthread_mutex_unlock(&dump->lock);
+        CDBG_ERROR("%s: dump queue full, dropped %s (%u dropped)",
+            __func__, path, dropped);
+        return -1;
+    }
+    job = mm_camera_dump_get_job(dump, size);
+    if (NULL == job) {
+        dropped = ++dump->stats.dropped;
+        pthread_mutex_unlock(&dump->lock);
+        CDBG_ERROR("%s: dump budget exceeded, dropped %s (%u dropped)",
+            __func__, path, dropped);
+        return -1;
+    }
+    /* Grow the staging buffer while the budget check still holds. The
+     * old contents are not needed, so free and allocate without a copy. */
+    if (job->capacity < size) {
+        free(job->data);
+        dump->staged_bytes -= job->capacity;
+        job->capacity = 0;
+        job->data = (uint8_t *)malloc(size);
+        if (NULL == job->data) {
+            dump->stats.dropped++;
+            pthread_mutex_unlock(&dump->lock);
+            CDBG_ERROR("%s: no memory to stage %zu bytes", __func__, size);
+            return -1;
+        }
+        dump->staged_bytes += size;
+        job->capacity = size;
+    }
+    /* The job is owned by this thread until it is queued */
+    cam_list_del_node(&job->list);
+    dump->copying++;
+    pthread_mutex_unlock(&dump->lock);
+
+    snprintf(job->path, sizeof(job->path), "%s", path);
+    job->size = size;
+    dst = job->data;
+    for (i = 0; i < num_planes; i++) {
+        const uint8_t *src = (const uint8_t *)planes[i].base;
+        if (planes[i].width == planes[i].stride) {
+            memcpy(dst, src, planes[i].width * planes[i].height);
+            dst += planes[i].width * planes[i].height;
+            continue;
+        }
+        for (j = 0; j < planes[i].height; j++) {
+            memcpy(dst, src, planes[i].width);
+            dst += planes[i].width;
+            src += planes[i].stride;
+        }
+    }
+
+    pthread_mutex_lock(&dump->lock);
+    cam_list_add_tail_node(&job->list, &dump->pending_jobs);
+    dump->copying--;
+    dump->stats.queued++;
+    pthread_cond_signal(&dump->job_cond);
+    pthread_mutex_unlock(&dump->lock);
+    return 0;
+}
+
+/*===========================================================================
+ * FUNCTION   : mm_camera_dump_flush
+ *
+ * DESCRIPTION: wait until all frames queued or still being staged by
+ *              mm_camera_dump_frame are written
+ *
+ * PARAMETERS : none
+ *
+ * RETURN     : none
+ *==========================================================================*/
+void mm_camera_dump_flush(void)
+{
+    mm_camera_dump_t *dump = &g_dump;
+
+    if (!g_dump_started) {
+        return;
+    }
+
+    pthread_mutex_lock(&dump->lock);
+    while (dump->busy || dump->copying ||
+            dump->pending_jobs.next != &dump->pending_jobs) {
+        pthread_cond_wait(&dump->idle_cond, &dump->lock);
+    }
+    pthread_mutex_unlock(&dump->lock);
+}
+
+/*===========================================================================
+ * FUNCTION   : mm_camera_dump_get_stats
+ *
+ * DESCRIPTION: get frame dump counters
+ *
+ * PARAMETERS :
+ *   @stats   : ptr to stats to be filled
+ *
+ * RETURN     : none
+ *==========================================================================*/
+void mm_camera_dump_get_stats(mm_camera_dump_stats_t *stats)
+{
+    mm_camera_dump_t *dump = &g_dump;
+
+    if (!g_dump_started) {
+        memset(stats, 0, sizeof(mm_camera_dump_stats_t));
+        return;
+    }
+
+    pthread_mutex_lock(&dump->lock);
+    *stats = dump->stats;
+    pthread_mutex_unlock(&dump->lock);
+}
@@ -205,6 +205,44 @@ static int32_t mm_camera_intf_set_parms(uint32_t camera_handle,
     return rc;
 }
 
+/*===========================================================================
+ * FUNCTION   : mm_camera_intf_set_parms_delta
+ *
+ * DESCRIPTION: set parameters per camera, sending only the entries changed
+ *              in the batch
+ *
+ * PARAMETERS :
+ *   @camera_handle: camera handle
+ *   @parms        : ptr to a param struct to be set to server
+ *   @dirty        : dirty tracker of the batch in parms
+ *
+ * RETURN     : int32_t type of status
+ *              0  -- success
+ *              -1 -- failure
+ * NOTE       : Assume the parms struct buf is already mapped to server via
+ *              domain socket. Corresponding fields of parameters to be set
+ *              are already filled in by upper layer caller.
+ *==========================================================================*/
+static int32_t mm_camera_intf_set_parms_delta(uint32_t camera_handle,
+                                              parm_buffer_t *parms,
+                                              const cam_parm_dirty_t *dirty)
+{
+    int32_t rc = -1;
+    mm_camera_obj_t * my_obj = NULL;
+
+    pthread_mutex_lock(&g_intf_lock);
+    my_obj = mm_camera_util_get_camera_by_handler(camera_handle);
+
+    if(my_obj) {
+        pthread_mutex_lock(&my_obj->cam_lock);
+        pthread_mutex_unlock(&g_intf_lock);
+        rc = mm_camera_set_parms_delta(my_obj, parms, dirty);
+    } else {
+        pthread_mutex_unlock(&g_intf_lock);
+    }
+    return rc;
+}
+
 /*===========================================================================
  * FUNCTION   : mm_camera_intf_get_parms
  *
@@ -1250,6 +1288,90 @@ static int32_t mm_camera_intf_unmap_stream_buf(uint32_t camera_handle,
     return rc;
 }
 
+/*===========================================================================
+ * FUNCTION   : mm_camera_intf_map_stream_bufs
+ *
+ * DESCRIPTION: mapping a list of stream buffers via domain socket to server
+ *              with a single message and a single completion event
+ *
+ * PARAMETERS :
+ *   @camera_handle: camera handle
+ *   @ch_id        : channel handle
+ *   @buf_map_list : buffers to be mapped, stream_id of each entry is the
+ *                   stream handle
+ *
+ * RETURN     : int32_t type of status
+ *              0  -- success
+ *              -1 -- failure
+ *==========================================================================*/
+static int32_t mm_camera_intf_map_stream_bufs(uint32_t camera_handle,
+                                              uint32_t ch_id,
+                                              const cam_buf_map_type_list *buf_map_list)
+{
+    int32_t rc = -1;
+    mm_camera_obj_t * my_obj = NULL;
+
+    pthread_mutex_lock(&g_intf_lock);
+    my_obj = mm_camera_util_get_camera_by_handler(camera_handle);
+
+    CDBG("%s :E camera_handle = %d, ch_id = %d, num_bufs = %d",
+         __func__, camera_handle, ch_id,
+         (NULL != buf_map_list) ? buf_map_list->length : 0);
+
+    if(my_obj) {
+        pthread_mutex_lock(&my_obj->cam_lock);
+        pthread_mutex_unlock(&g_intf_lock);
+        rc = mm_camera_map_stream_bufs(my_obj, ch_id, buf_map_list);
+    }else{
+        pthread_mutex_unlock(&g_intf_lock);
+    }
+
+    CDBG("%s :X rc = %d", __func__, rc);
+    return rc;
+}
+
+/*===========================================================================
+ * FUNCTION   : mm_camera_intf_unmap_stream_bufs
+ *
+ * DESCRIPTION: unmapping a list of stream buffers via domain socket to server
+ *              with a single message and a single completion event
+ *
+ * PARAMETERS :
+ *   @camera_handle : camera handle
+ *   @ch_id         : channel handle
+ *   @buf_unmap_list: buffers to be unmapped, stream_id of each entry is the
+ *                    stream handle
+ *
+ * RETURN     : int32_t type of status
+ *              0  -- success
+ *              -1 -- failure
+ *==========================================================================*/
+static int32_t mm_camera_intf_unmap_stream_bufs(uint32_t camera_handle,
+                                                uint32_t ch_id,
+                                                const cam_buf_unmap_type_list *buf_unmap_list)
+{
+    int32_t rc = -1;
+    mm_camera_obj_t * my_obj = NULL;
+
+    pthread_mutex_lock(&g_intf_lock);
+    my_obj = mm_camera_util_get_camera_by_handler(camera_handle);
+
+    CDBG("%s :E camera_handle = %d, ch_id = %d, num_bufs = %d",
+         __func__, camera_handle, ch_id,
+         (NULL != buf_unmap_list) ? buf_unmap_list->length : 0);
+
+    if(my_obj) {
+        pthread_mutex_lock(&my_obj->cam_lock);
+        pthread_mutex_unlock(&g_intf_lock);
+        rc = mm_camera_unmap_stream_bufs(my_obj, ch_id, buf_unmap_list);
+    }else{
+        pthread_mutex_unlock(&g_intf_lock);
+    }
+
+    CDBG("%s :X rc = %d", __func__, rc);
+    return rc;
+}
+
 /*===========================================================================
  * FUNCTION   : get_sensor_info
  *
@@ -1318,6 +1440,8 @@ void get_sensor_info()
                     (unsigned int)mount_angle, (unsigned int)facing);
                 g_cam_ctrl.info[num_cameras].facing = (int)facing;
                 g_cam_ctrl.info[num_cameras].orientation = (int)mount_angle;
+                strlcpy(g_cam_ctrl.sensor_name[num_cameras], entity.name,
+                    sizeof(g_cam_ctrl.sensor_name[num_cameras]));
                 num_cameras++;
                 continue;
             }
@@ -1539,12 +1663,29 @@ struct camera_info *get_cam_info(uint32_t camera_id)
     return &g_cam_ctrl.info[camera_id];
 }
 
+/*===========================================================================
+ * FUNCTION   : get_cam_sensor_name
+ *
+ * DESCRIPTION: get the name of the sensor subdevice behind a camera, found
+ *              while discovering the cameras
+ *
+ * PARAMETERS :
+ *   @camera_id : camera index
+ *
+ * RETURN     : sensor name, empty if unknown
+ *==========================================================================*/
+const char *get_cam_sensor_name(uint32_t camera_id)
+{
+    return g_cam_ctrl.sensor_name[camera_id];
+}
+
 /* camera ops v-table */
 static mm_camera_ops_t mm_camera_ops = {
     .query_capability = mm_camera_intf_query_capability,
     .register_event_notify = mm_camera_intf_register_event_notify,
     .close_camera = mm_camera_intf_close,
     .set_parms = mm_camera_intf_set_parms,
+    .set_parms_delta = mm_camera_intf_set_parms_delta,
     .get_parms = mm_camera_intf_get_parms,
     .do_auto_focus = mm_camera_intf_do_auto_focus,
     .cancel_auto_focus = mm_camera_intf_cancel_auto_focus,
@@ -1562,6 +1703,8 @@ static mm_camera_ops_t mm_camera_ops = {
     .qbuf = mm_camera_intf_qbuf,
     .map_stream_buf = mm_camera_intf_map_stream_buf,
     .unmap_stream_buf = mm_camera_intf_unmap_stream_buf,
+    .map_stream_bufs = mm_camera_intf_map_stream_bufs,
+    .unmap_stream_bufs = mm_camera_intf_unmap_stream_bufs,
     .set_stream_parms = mm_camera_intf_set_stream_parms,
     .get_stream_parms = mm_camera_intf_get_stream_parms,
     .start_channel = mm_camera_intf_start_channel,
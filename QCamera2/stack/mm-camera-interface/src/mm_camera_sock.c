@@ -160,6 +160,73 @@ int mm_camera_socket_sendmsg(
     return sendmsg(fd, &(msgh), 0);
 }
 
+/*===========================================================================
+ * FUNCTION   : mm_camera_socket_bundle_sendmsg
+ *
+ * DESCRIPTION:  send msg carrying several file descriptors through domain
+ *               socket in a single SCM_RIGHTS control message
+ *   @fd      : socket fd
+ *   @msg     : pointer to msg to be sent over domain socket
+ *   @buf_size: size of the msg
+ *   @sendfds : file descriptors to be sent
+ *   @numfds  : number of file descriptors, at most CAM_MAX_NUM_BUFS_PER_MAP
+ *
+ * RETURN     : the total bytes of sent msg
+ *==========================================================================*/
+int mm_camera_socket_bundle_sendmsg(
+  int fd,
+  void *msg,
+  size_t buf_size,
+  int sendfds[CAM_MAX_NUM_BUFS_PER_MAP],
+  int numfds)
+{
+    struct msghdr msgh;
+    struct iovec iov[1];
+    struct cmsghdr * cmsghp = NULL;
+    char control[CMSG_SPACE(sizeof(int) * CAM_MAX_NUM_BUFS_PER_MAP)];
+    int *fds_ptr = NULL;
+
+    if (msg == NULL) {
+      CDBG("%s: msg is NULL", __func__);
+      return -1;
+    }
+    if ((numfds < 0) || (numfds > CAM_MAX_NUM_BUFS_PER_MAP)) {
+      CDBG_ERROR("%s: invalid number of fds %d", __func__, numfds);
+      return -1;
+    }
+    memset(&msgh, 0, sizeof(msgh));
+    msgh.msg_name = NULL;
+    msgh.msg_namelen = 0;
+
+    iov[0].iov_base = msg;
+    iov[0].iov_len = buf_size;
+    msgh.msg_iov = iov;
+    msgh.msg_iovlen = 1;
+    CDBG("%s: iov_len=%zd numfds=%d", __func__, iov[0].iov_len, numfds);
+
+    msgh.msg_control = NULL;
+    msgh.msg_controllen = 0;
+
+    if (numfds > 0) {
+      memset(control, 0, sizeof(control));
+      msgh.msg_control = control;
+      msgh.msg_controllen = CMSG_SPACE(sizeof(int) * (size_t)numfds);
+      cmsghp = CMSG_FIRSTHDR(&msgh);
+      if (cmsghp != NULL) {
+        cmsghp->cmsg_level = SOL_SOCKET;
+        cmsghp->cmsg_type = SCM_RIGHTS;
+        cmsghp->cmsg_len = CMSG_LEN(sizeof(int) * (size_t)numfds);
+        fds_ptr = (int *) CMSG_DATA(cmsghp);
+        memcpy(fds_ptr, sendfds, sizeof(int) * (size_t)numfds);
+      } else {
+        CDBG("%s: ctrl msg NULL", __func__);
+        return -1;
+      }
+    }
+
+    return sendmsg(fd, &(msgh), 0);
+}
+
 /*===========================================================================
  * FUNCTION   : mm_camera_socket_recvmsg
  *
@@ -1371,6 +1371,100 @@ int32_t mm_stream_unmap_buf(mm_stream_t * my_obj,
                                   0);
 }
 
+/*===========================================================================
+ * FUNCTION   : mm_stream_map_bufs
+ *
+ * DESCRIPTION: mapping a list of stream buffers via domain socket to server
+ *              in one message, waiting for a single completion event
+ *
+ * PARAMETERS :
+ *   @my_obj       : stream object
+ *   @buf_map_list : list of buffers to be mapped. stream_id of every entry
+ *                   is overwritten with the server stream id
+ *
+ * RETURN     : int32_t type of status
+ *              0  -- success
+ *              -1 -- failure
+ *==========================================================================*/
+int32_t mm_stream_map_bufs(mm_stream_t * my_obj,
+                           cam_buf_map_type_list *buf_map_list)
+{
+    if (NULL == my_obj || NULL == my_obj->ch_obj || NULL == my_obj->ch_obj->cam_obj) {
+        CDBG_ERROR("%s: NULL obj of stream/channel/camera", __func__);
+        return -1;
+    }
+
+    if ((NULL == buf_map_list) || (0 == buf_map_list->length) ||
+            (buf_map_list->length > CAM_MAX_NUM_BUFS_PER_MAP)) {
+        CDBG_ERROR("%s: invalid buf map list", __func__);
+        return -1;
+    }
+
+    cam_sock_bundled_packet_t packet;
+    int sendfds[CAM_MAX_NUM_BUFS_PER_MAP];
+    uint32_t i;
+
+    for (i = 0; i < buf_map_list->length; i++) {
+        buf_map_list->buf_maps[i].stream_id = my_obj->server_stream_id;
+        sendfds[i] = buf_map_list->buf_maps[i].fd;
+    }
+
+    memset(&packet, 0, sizeof(cam_sock_bundled_packet_t));
+    packet.msg_type = CAM_MAPPING_TYPE_FD_BUNDLED_MAPPING;
+    packet.payload.buf_map_list = *buf_map_list;
+    return mm_camera_util_bundled_sendmsg(my_obj->ch_obj->cam_obj,
+                                          &packet,
+                                          sizeof(cam_sock_bundled_packet_t),
+                                          sendfds,
+                                          (int)buf_map_list->length);
+}
+
+/*===========================================================================
+ * FUNCTION   : mm_stream_unmap_bufs
+ *
+ * DESCRIPTION: unmapping a list of stream buffers via domain socket to server
+ *              in one message, waiting for a single completion event
+ *
+ * PARAMETERS :
+ *   @my_obj         : stream object
+ *   @buf_unmap_list : list of buffers to be unmapped. stream_id of every
+ *                     entry is overwritten with the server stream id
+ *
+ * RETURN     : int32_t type of status
+ *              0  -- success
+ *              -1 -- failure
+ *==========================================================================*/
+int32_t mm_stream_unmap_bufs(mm_stream_t * my_obj,
+                             cam_buf_unmap_type_list *buf_unmap_list)
+{
+    if (NULL == my_obj || NULL == my_obj->ch_obj || NULL == my_obj->ch_obj->cam_obj) {
+        CDBG_ERROR("%s: NULL obj of stream/channel/camera", __func__);
+        return -1;
+    }
+
+    if ((NULL == buf_unmap_list) || (0 == buf_unmap_list->length) ||
+            (buf_unmap_list->length > CAM_MAX_NUM_BUFS_PER_MAP)) {
+        CDBG_ERROR("%s: invalid buf unmap list", __func__);
+        return -1;
+    }
+
+    cam_sock_bundled_packet_t packet;
+    uint32_t i;
+
+    for (i = 0; i < buf_unmap_list->length; i++) {
+        buf_unmap_list->buf_unmaps[i].stream_id = my_obj->server_stream_id;
+    }
+
+    memset(&packet, 0, sizeof(cam_sock_bundled_packet_t));
+    packet.msg_type = CAM_MAPPING_TYPE_FD_BUNDLED_UNMAPPING;
+    packet.payload.buf_unmap_list = *buf_unmap_list;
+    return mm_camera_util_bundled_sendmsg(my_obj->ch_obj->cam_obj,
+                                          &packet,
+                                          sizeof(cam_sock_bundled_packet_t),
+                                          NULL,
+                                          0);
+}
+
 /*===========================================================================
  * FUNCTION   : mm_stream_map_buf_ops
  *
@@ -1438,6 +1532,50 @@ static int32_t mm_stream_unmap_buf_ops(uint32_t frame_idx,
                                plane_idx);
 }
 
+/*===========================================================================
+ * FUNCTION   : mm_stream_bundled_map_buf_ops
+ *
+ * DESCRIPTION: ops for mapping a list of stream buffers via domain socket to
+ *              server in one message. Passed to upper layer as part of ops
+ *              table together with mm_stream_map_buf_ops.
+ *
+ * PARAMETERS :
+ *   @buf_map_list : list of buffers to be mapped
+ *   @userdata     : user data ptr (stream object)
+ *
+ * RETURN     : int32_t type of status
+ *              0  -- success
+ *              -1 -- failure
+ *==========================================================================*/
+static int32_t mm_stream_bundled_map_buf_ops(cam_buf_map_type_list *buf_map_list,
+                                             void *userdata)
+{
+    mm_stream_t *my_obj = (mm_stream_t *)userdata;
+    return mm_stream_map_bufs(my_obj, buf_map_list);
+}
+
+/*===========================================================================
+ * FUNCTION   : mm_stream_bundled_unmap_buf_ops
+ *
+ * DESCRIPTION: ops for unmapping a list of stream buffers via domain socket
+ *              to server in one message. Passed to upper layer as part of
+ *              ops table together with mm_stream_unmap_buf_ops.
+ *
+ * PARAMETERS :
+ *   @buf_unmap_list : list of buffers to be unmapped
+ *   @userdata       : user data ptr (stream object)
+ *
+ * RETURN     : int32_t type of status
+ *              0  -- success
+ *              -1 -- failure
+ *==========================================================================*/
+static int32_t mm_stream_bundled_unmap_buf_ops(cam_buf_unmap_type_list *buf_unmap_list,
+                                               void *userdata)
+{
+    mm_stream_t *my_obj = (mm_stream_t *)userdata;
+    return mm_stream_unmap_bufs(my_obj, buf_unmap_list);
+}
+
 /*===========================================================================
  * FUNCTION   : mm_stream_init_bufs
  *
@@ -1466,6 +1604,14 @@ int32_t mm_stream_init_bufs(mm_stream_t * my_obj)
 
     my_obj->map_ops.map_ops = mm_stream_map_buf_ops;
     my_obj->map_ops.unmap_ops = mm_stream_unmap_buf_ops;
+    /* upper layer falls back to per-buffer mapping without bundled ops */
+    if (my_obj->ch_obj->cam_obj->bundled_map) {
+        my_obj->map_ops.bundled_map_ops = mm_stream_bundled_map_buf_ops;
+        my_obj->map_ops.bundled_unmap_ops = mm_stream_bundled_unmap_buf_ops;
+    } else {
+        my_obj->map_ops.bundled_map_ops = NULL;
+        my_obj->map_ops.bundled_unmap_ops = NULL;
+    }
     my_obj->map_ops.userdata = my_obj;
 
     rc = my_obj->mem_vtbl.get_bufs(&my_obj->frame_offset,
@@ -1534,6 +1680,13 @@ int32_t mm_stream_deinit_bufs(mm_stream_t * my_obj)
     /* release bufs */
     ops_tbl.map_ops = mm_stream_map_buf_ops;
     ops_tbl.unmap_ops = mm_stream_unmap_buf_ops;
+    if (my_obj->ch_obj->cam_obj->bundled_map) {
+        ops_tbl.bundled_map_ops = mm_stream_bundled_map_buf_ops;
+        ops_tbl.bundled_unmap_ops = mm_stream_bundled_unmap_buf_ops;
+    } else {
+        ops_tbl.bundled_map_ops = NULL;
+        ops_tbl.bundled_unmap_ops = NULL;
+    }
     ops_tbl.userdata = my_obj;
 
     rc = my_obj->mem_vtbl.put_bufs(&ops_tbl,
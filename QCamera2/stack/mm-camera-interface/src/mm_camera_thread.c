@@ -34,6 +34,7 @@
 #include <sys/stat.h>
 #include <sys/prctl.h>
 #include <fcntl.h>
+#include <sys/epoll.h>
 #include <poll.h>
 #include <cam_semaphore.h>
 
@@ -42,12 +43,6 @@
 #include "mm_camera.h"
 
 typedef enum {
-    /* poll entries updated */
-    MM_CAMERA_PIPE_CMD_POLL_ENTRIES_UPDATED,
-    /* poll entries updated */
-    MM_CAMERA_PIPE_CMD_POLL_ENTRIES_UPDATED_ASYNC,
-    /* commit updates */
-    MM_CAMERA_PIPE_CMD_COMMIT,
     /* exit */
     MM_CAMERA_PIPE_CMD_EXIT,
     /* max count */
@@ -65,50 +60,14 @@ typedef struct {
     mm_camera_event_t event;
 } mm_camera_sig_evt_t;
 
-
-/*===========================================================================
- * FUNCTION   : mm_camera_poll_sig_async
- *
- * DESCRIPTION: Asynchoronous call to send a command through pipe.
- *
- * PARAMETERS :
- *   @poll_cb      : ptr to poll thread object
- *   @cmd          : command to be sent
- *
- * RETURN     : int32_t type of status
- *              0  -- success
- *              -1 -- failure
- *==========================================================================*/
-static int32_t mm_camera_poll_sig_async(mm_camera_poll_thread_t *poll_cb,
-                                  uint32_t cmd)
-{
-    /* send through pipe */
-    /* get the mutex */
-    mm_camera_sig_evt_t cmd_evt;
-
-    CDBG("%s: E cmd = %d", __func__,cmd);
-    memset(&cmd_evt, 0, sizeof(cmd_evt));
-    cmd_evt.cmd = cmd;
-    pthread_mutex_lock(&poll_cb->mutex);
-    /* reset the statue to false */
-    poll_cb->status = FALSE;
-    /* send cmd to worker */
-
-    ssize_t len = write(poll_cb->pfds[1], &cmd_evt, sizeof(cmd_evt));
-    if(len < 1) {
-        CDBG_ERROR("%s: len = %zd, errno = %d", __func__, len, errno);
-        /* Avoid waiting for the signal */
-        pthread_mutex_unlock(&poll_cb->mutex);
-        return 0;
-    }
-    CDBG("%s: begin IN mutex write done, len = %zd", __func__, len);
-    pthread_mutex_unlock(&poll_cb->mutex);
-    CDBG("%s: X", __func__);
-    return 0;
-}
-
-
-
+/* epoll user data: entry index in the low word, entry generation in the
+ * high word. The pipe uses an index no entry can have. */
+#define MM_CAMERA_POLL_PIPE_IDX         0xFFFFFFFF
+#define MM_CAMERA_POLL_EVT_DATA(idx, gen) \
+    (((uint64_t)(gen) << 32) | (uint32_t)(idx))
+#define MM_CAMERA_POLL_MAX_EVENTS       (MAX_STREAM_NUM_IN_BUNDLE + 1)
+/* wait between attempts to recreate a failed epoll set */
+#define MM_CAMERA_POLL_RETRY_MS         10
 
 /*===========================================================================
  * FUNCTION   : mm_camera_poll_sig
@@ -147,7 +106,7 @@ static int32_t mm_camera_poll_sig(mm_camera_poll_thread_t *poll_cb,
     }
     CDBG("%s: begin IN mutex write done, len = %zd", __func__, len);
     /* wait till worker task gives positive signal */
-    if (FALSE == poll_cb->status) {
+    while (FALSE == poll_cb->status) {
         CDBG("%s: wait", __func__);
         pthread_cond_wait(&poll_cb->cond_v, &poll_cb->mutex);
     }
@@ -158,7 +117,7 @@ static int32_t mm_camera_poll_sig(mm_camera_poll_thread_t *poll_cb,
 }
 
 /*===========================================================================
- * FUNCTION   : mm_camera_poll_sig
+ * FUNCTION   : mm_camera_poll_sig_done
  *
  * DESCRIPTION: signal the status of done
  *
@@ -171,7 +130,7 @@ static void mm_camera_poll_sig_done(mm_camera_poll_thread_t *poll_cb)
 {
     pthread_mutex_lock(&poll_cb->mutex);
     poll_cb->status = TRUE;
-    pthread_cond_signal(&poll_cb->cond_v);
+    pthread_cond_broadcast(&poll_cb->cond_v);
     CDBG("%s: done, in mutex", __func__);
     pthread_mutex_unlock(&poll_cb->mutex);
 }
@@ -206,57 +165,13 @@ static void mm_camera_poll_set_state(mm_camera_poll_thread_t *poll_cb,
 static void mm_camera_poll_proc_pipe(mm_camera_poll_thread_t *poll_cb)
 {
     ssize_t read_len;
-    int i;
     mm_camera_sig_evt_t cmd_evt;
+
+    memset(&cmd_evt, 0, sizeof(cmd_evt));
     read_len = read(poll_cb->pfds[0], &cmd_evt, sizeof(cmd_evt));
     CDBG("%s: read_fd = %d, read_len = %d, expect_len = %d cmd = %d",
          __func__, poll_cb->pfds[0], (int)read_len, (int)sizeof(cmd_evt), cmd_evt.cmd);
     switch (cmd_evt.cmd) {
-    case MM_CAMERA_PIPE_CMD_POLL_ENTRIES_UPDATED:
-    case MM_CAMERA_PIPE_CMD_POLL_ENTRIES_UPDATED_ASYNC:
-        /* we always have index 0 for pipe read */
-        poll_cb->num_fds = 0;
-        poll_cb->poll_fds[poll_cb->num_fds].fd = poll_cb->pfds[0];
-        poll_cb->poll_fds[poll_cb->num_fds].events = POLLIN|POLLRDNORM|POLLPRI;
-        poll_cb->num_fds++;
-
-        if (MM_CAMERA_POLL_TYPE_EVT == poll_cb->poll_type &&
-                poll_cb->num_fds < MAX_STREAM_NUM_IN_BUNDLE) {
-            if (poll_cb->poll_entries[0].fd > 0) {
-                /* fd is valid, we update poll_fds */
-                poll_cb->poll_fds[poll_cb->num_fds].fd = poll_cb->poll_entries[0].fd;
-                poll_cb->poll_fds[poll_cb->num_fds].events = POLLIN|POLLRDNORM|POLLPRI;
-                poll_cb->num_fds++;
-            }
-        } else if (MM_CAMERA_POLL_TYPE_DATA == poll_cb->poll_type &&
-                poll_cb->num_fds <= MAX_STREAM_NUM_IN_BUNDLE) {
-            for(i = 0; i < MAX_STREAM_NUM_IN_BUNDLE; i++) {
-                if(poll_cb->poll_entries[i].fd > 0) {
-                    /* fd is valid, we update poll_fds to this fd */
-                    poll_cb->poll_fds[poll_cb->num_fds].fd = poll_cb->poll_entries[i].fd;
-                    poll_cb->poll_fds[poll_cb->num_fds].events = POLLIN|POLLRDNORM|POLLPRI;
-                    poll_cb->num_fds++;
-                } else {
-                    /* fd is invalid, we set the entry to -1 to prevent polling.
-                     * According to spec, polling will not poll on entry with fd=-1.
-                     * If this is not the case, we need to skip these invalid fds
-                     * when updating this array.
-                     * We still keep fd=-1 in this array because this makes easier to
-                     * map cb associated with this fd once incoming data avail by directly
-                     * using the index-1(0 is reserved for pipe read, so need to reduce index by 1) */
-                    poll_cb->poll_fds[poll_cb->num_fds].fd = -1;
-                    poll_cb->poll_fds[poll_cb->num_fds].events = 0;
-                    poll_cb->num_fds++;
-                }
-            }
-        }
-        if (cmd_evt.cmd != MM_CAMERA_PIPE_CMD_POLL_ENTRIES_UPDATED_ASYNC)
-            mm_camera_poll_sig_done(poll_cb);
-        break;
-
-    case MM_CAMERA_PIPE_CMD_COMMIT:
-        mm_camera_poll_sig_done(poll_cb);
-        break;
     case MM_CAMERA_PIPE_CMD_EXIT:
     default:
         mm_camera_poll_set_state(poll_cb, MM_CAMERA_POLL_TASK_STATE_STOPPED);
@@ -265,10 +180,208 @@ static void mm_camera_poll_proc_pipe(mm_camera_poll_thread_t *poll_cb)
     }
 }
 
+/*===========================================================================
+ * FUNCTION   : mm_camera_poll_get_events
+ *
+ * DESCRIPTION: epoll event mask for fds of the polling thread
+ *
+ * PARAMETERS :
+ *   @poll_cb : ptr to poll thread object
+ *
+ * RETURN     : epoll event mask
+ *==========================================================================*/
+static uint32_t mm_camera_poll_get_events(mm_camera_poll_thread_t *poll_cb)
+{
+    uint32_t events;
+
+    if (MM_CAMERA_POLL_TYPE_EVT == poll_cb->poll_type) {
+        /* ctrl events are signaled as priority data */
+        events = EPOLLPRI;
+    } else {
+        events = EPOLLIN | EPOLLRDNORM;
+    }
+    return events;
+}
+
+/*===========================================================================
+ * FUNCTION   : mm_camera_poll_create_epoll
+ *
+ * DESCRIPTION: create the epoll set of the polling thread and add the pipe
+ *              and every registered fd to it. Used at launch and to recover
+ *              when epoll_wait fails on the current set. Caller holds
+ *              poll_cb->mutex once the thread is running.
+ *
+ * PARAMETERS :
+ *   @poll_cb : ptr to poll thread object
+ *
+ * RETURN     : int32_t type of status
+ *              0  -- success
+ *              -1 -- failure, poll_cb->epoll_fd is left at -1
+ *==========================================================================*/
+static int32_t mm_camera_poll_create_epoll(mm_camera_poll_thread_t *poll_cb)
+{
+    struct epoll_event evt;
+    int32_t rc;
+    int i;
+
+    poll_cb->epoll_fd = epoll_create(MM_CAMERA_POLL_MAX_EVENTS);
+    if (poll_cb->epoll_fd < 0) {
+        CDBG_ERROR("%s: epoll_create failed: %s\n", __func__, strerror(errno));
+        poll_cb->epoll_fd = -1;
+        return -1;
+    }
+
+    /* pipe read fd is always polled */
+    memset(&evt, 0, sizeof(evt));
+    evt.events = EPOLLIN;
+    evt.data.u64 = MM_CAMERA_POLL_PIPE_IDX;
+    rc = epoll_ctl(poll_cb->epoll_fd, EPOLL_CTL_ADD, poll_cb->pfds[0], &evt);
+    if (rc < 0) {
+        CDBG_ERROR("%s: epoll add pipe failed: %s\n", __func__, strerror(errno));
+        close(poll_cb->epoll_fd);
+        poll_cb->epoll_fd = -1;
+        return -1;
+    }
+
+    for (i = 0; i < MAX_STREAM_NUM_IN_BUNDLE; i++) {
+        mm_camera_poll_entry_t *entry = &poll_cb->poll_entries[i];
+        if (entry->fd <= 0) {
+            continue;
+        }
+        memset(&evt, 0, sizeof(evt));
+        evt.events = mm_camera_poll_get_events(poll_cb);
+        evt.data.u64 = MM_CAMERA_POLL_EVT_DATA(i, entry->gen);
+        if (epoll_ctl(poll_cb->epoll_fd, EPOLL_CTL_ADD, entry->fd, &evt) < 0) {
+            CDBG_ERROR("%s: epoll re-add fd %d failed: %s\n",
+                       __func__, entry->fd, strerror(errno));
+        }
+    }
+    return 0;
+}
+
+/*===========================================================================
+ * FUNCTION   : mm_camera_poll_recover
+ *
+ * DESCRIPTION: epoll_wait failed on the current set. Replace the set; while
+ *              that fails keep serving the pipe so the exit command still
+ *              gets through.
+ *
+ * PARAMETERS :
+ *   @poll_cb : ptr to poll thread object
+ *
+ * RETURN     : none
+ *==========================================================================*/
+static void mm_camera_poll_recover(mm_camera_poll_thread_t *poll_cb)
+{
+    struct pollfd pfd;
+    int32_t rc;
+
+    pthread_mutex_lock(&poll_cb->mutex);
+    if (poll_cb->epoll_fd >= 0) {
+        close(poll_cb->epoll_fd);
+    }
+    rc = mm_camera_poll_create_epoll(poll_cb);
+    pthread_mutex_unlock(&poll_cb->mutex);
+    if (0 == rc) {
+        CDBG_ERROR("%s: epoll set recreated, fd = %d",
+                   __func__, poll_cb->epoll_fd);
+        return;
+    }
+
+    memset(&pfd, 0, sizeof(pfd));
+    pfd.fd = poll_cb->pfds[0];
+    pfd.events = POLLIN;
+    if ((poll(&pfd, 1, MM_CAMERA_POLL_RETRY_MS) > 0) &&
+        (pfd.revents & POLLIN)) {
+        mm_camera_poll_proc_pipe(poll_cb);
+    }
+}
+
+/*===========================================================================
+ * FUNCTION   : mm_camera_poll_wait_dispatch
+ *
+ * DESCRIPTION: wait until the polling thread is out of the notify_cb of an
+ *              entry. Must be called with poll_cb->mutex held, and never
+ *              from the polling thread itself.
+ *
+ * PARAMETERS :
+ *   @poll_cb : ptr to poll thread object
+ *   @idx     : entry index, -1 to wait for any entry
+ *
+ * RETURN     : none
+ *==========================================================================*/
+static void mm_camera_poll_wait_dispatch(mm_camera_poll_thread_t *poll_cb,
+                                         int32_t idx)
+{
+    if (pthread_equal(pthread_self(), poll_cb->pid)) {
+        return;
+    }
+    while ((-1 != poll_cb->dispatch_idx) &&
+           ((-1 == idx) || (idx == poll_cb->dispatch_idx))) {
+        poll_cb->dispatch_waiters++;
+        pthread_cond_wait(&poll_cb->cond_v, &poll_cb->mutex);
+        poll_cb->dispatch_waiters--;
+    }
+}
+
+/*===========================================================================
+ * FUNCTION   : mm_camera_poll_dispatch
+ *
+ * DESCRIPTION: call notify_cb of the entry an epoll event belongs to. Events
+ *              of entries deleted or re-added since epoll_wait returned are
+ *              dropped.
+ *
+ * PARAMETERS :
+ *   @poll_cb : ptr to poll thread object
+ *   @evt     : ready event
+ *
+ * RETURN     : none
+ *==========================================================================*/
+static void mm_camera_poll_dispatch(mm_camera_poll_thread_t *poll_cb,
+                                    struct epoll_event *evt)
+{
+    uint32_t idx = (uint32_t)(evt->data.u64 & 0xFFFFFFFF);
+    uint32_t gen = (uint32_t)(evt->data.u64 >> 32);
+    mm_camera_poll_notify_t notify_cb = NULL;
+    void *user_data = NULL;
+
+    if ((MM_CAMERA_POLL_TYPE_EVT == poll_cb->poll_type) &&
+        !(evt->events & EPOLLPRI)) {
+        return;
+    }
+    if ((MM_CAMERA_POLL_TYPE_DATA == poll_cb->poll_type) &&
+        !((evt->events & EPOLLIN) && (evt->events & EPOLLRDNORM))) {
+        return;
+    }
+
+    pthread_mutex_lock(&poll_cb->mutex);
+    if ((MAX_STREAM_NUM_IN_BUNDLE > idx) &&
+        (poll_cb->poll_entries[idx].fd > 0) &&
+        (poll_cb->poll_entries[idx].gen == gen)) {
+        notify_cb = poll_cb->poll_entries[idx].notify_cb;
+        user_data = poll_cb->poll_entries[idx].user_data;
+        poll_cb->dispatch_idx = (int32_t)idx;
+    }
+    pthread_mutex_unlock(&poll_cb->mutex);
+
+    if (NULL != notify_cb) {
+        CDBG("%s: notify entry %d\n", __func__, idx);
+        notify_cb(user_data);
+
+        pthread_mutex_lock(&poll_cb->mutex);
+        poll_cb->dispatch_idx = -1;
+        if (poll_cb->dispatch_waiters > 0) {
+            pthread_cond_broadcast(&poll_cb->cond_v);
+        }
+        pthread_mutex_unlock(&poll_cb->mutex);
+    }
+}
+
 /*===========================================================================
  * FUNCTION   : mm_camera_poll_fn
  *
- * DESCRIPTION: polling thread routine
+ * DESCRIPTION: polling thread routine. All fds reported ready by one
+ *              epoll_wait are served before pipe commands are processed.
  *
  * PARAMETERS :
  *   @poll_cb : ptr to poll thread object
@@ -277,53 +390,41 @@ static void mm_camera_poll_proc_pipe(mm_camera_poll_thread_t *poll_cb)
  *==========================================================================*/
 static void *mm_camera_poll_fn(mm_camera_poll_thread_t *poll_cb)
 {
+    struct epoll_event events[MM_CAMERA_POLL_MAX_EVENTS];
+    uint8_t pipe_ready;
     int rc = 0, i;
 
     if (NULL == poll_cb) {
         CDBG_ERROR("%s: poll_cb is NULL!\n", __func__);
         return NULL;
     }
-    CDBG("%s: poll type = %d, num_fd = %d poll_cb = %p\n",
-         __func__, poll_cb->poll_type, poll_cb->num_fds,poll_cb);
+    CDBG("%s: poll type = %d, epoll fd = %d poll_cb = %p\n",
+         __func__, poll_cb->poll_type, poll_cb->epoll_fd, poll_cb);
     do {
-         for(i = 0; i < poll_cb->num_fds; i++) {
-            poll_cb->poll_fds[i].events = POLLIN|POLLRDNORM|POLLPRI;
-         }
-
-         rc = poll(poll_cb->poll_fds, poll_cb->num_fds, poll_cb->timeoutms);
-         if(rc > 0) {
-            if ((poll_cb->poll_fds[0].revents & POLLIN) &&
-                (poll_cb->poll_fds[0].revents & POLLRDNORM)) {
-                /* if we have data on pipe, we only process pipe in this iteration */
-                CDBG("%s: cmd received on pipe\n", __func__);
-                mm_camera_poll_proc_pipe(poll_cb);
-            } else {
-                for(i=1; i<poll_cb->num_fds; i++) {
-                    /* Checking for ctrl events */
-                    if ((poll_cb->poll_type == MM_CAMERA_POLL_TYPE_EVT) &&
-                        (poll_cb->poll_fds[i].revents & POLLPRI)) {
-                        CDBG("%s: mm_camera_evt_notify\n", __func__);
-                        if (NULL != poll_cb->poll_entries[i-1].notify_cb) {
-                            poll_cb->poll_entries[i-1].notify_cb(poll_cb->poll_entries[i-1].user_data);
-                        }
-                    }
-
-                    if ((MM_CAMERA_POLL_TYPE_DATA == poll_cb->poll_type) &&
-                        (poll_cb->poll_fds[i].revents & POLLIN) &&
-                        (poll_cb->poll_fds[i].revents & POLLRDNORM)) {
-                        CDBG("%s: mm_stream_data_notify\n", __func__);
-                        if (NULL != poll_cb->poll_entries[i-1].notify_cb) {
-                            poll_cb->poll_entries[i-1].notify_cb(poll_cb->poll_entries[i-1].user_data);
-                        }
-                    }
-                }
+        rc = epoll_wait(poll_cb->epoll_fd, events,
+                        MM_CAMERA_POLL_MAX_EVENTS, poll_cb->timeoutms);
+        if (rc < 0) {
+            if (EINTR == errno) {
+                continue;
             }
-        } else {
-            /* in error case sleep 10 us and then continue. hard coded here */
-            usleep(10);
+            CDBG_ERROR("%s: epoll_wait failed: %s", __func__, strerror(errno));
+            mm_camera_poll_recover(poll_cb);
             continue;
         }
-    } while ((poll_cb != NULL) && (poll_cb->state == MM_CAMERA_POLL_TASK_STATE_POLL));
+
+        pipe_ready = FALSE;
+        for (i = 0; i < rc; i++) {
+            if (MM_CAMERA_POLL_PIPE_IDX == events[i].data.u64) {
+                pipe_ready = TRUE;
+            } else {
+                mm_camera_poll_dispatch(poll_cb, &events[i]);
+            }
+        }
+        if (pipe_ready) {
+            CDBG("%s: cmd received on pipe\n", __func__);
+            mm_camera_poll_proc_pipe(poll_cb);
+        }
+    } while (poll_cb->state == MM_CAMERA_POLL_TASK_STATE_POLL);
     return NULL;
 }
 
@@ -342,35 +443,17 @@ static void *mm_camera_poll_thread(void *data)
     prctl(PR_SET_NAME, (unsigned long)"mm_cam_poll_th", 0, 0, 0);
     mm_camera_poll_thread_t *poll_cb = (mm_camera_poll_thread_t *)data;
 
-    /* add pipe read fd into poll first */
-    poll_cb->poll_fds[poll_cb->num_fds++].fd = poll_cb->pfds[0];
-
-    mm_camera_poll_sig_done(poll_cb);
     mm_camera_poll_set_state(poll_cb, MM_CAMERA_POLL_TASK_STATE_POLL);
+    mm_camera_poll_sig_done(poll_cb);
     return mm_camera_poll_fn(poll_cb);
 }
 
-/*===========================================================================
- * FUNCTION   : mm_camera_poll_thread
- *
- * DESCRIPTION: notify the polling thread that entries for polling fd have
- *              been updated
- *
- * PARAMETERS :
- *   @poll_cb : ptr to poll thread object
- *
- * RETURN     : none
- *==========================================================================*/
-int32_t mm_camera_poll_thread_notify_entries_updated(mm_camera_poll_thread_t * poll_cb)
-{
-    /* send poll entries updated signal to poll thread */
-    return mm_camera_poll_sig(poll_cb, MM_CAMERA_PIPE_CMD_POLL_ENTRIES_UPDATED);
-}
-
 /*===========================================================================
  * FUNCTION   : mm_camera_poll_thread_commit_updates
  *
- * DESCRIPTION: sync with all previously pending async updates
+ * DESCRIPTION: sync with all previously pending async updates. fds are
+ *              added to and removed from epoll right away, so this only
+ *              waits for a running notify_cb to return.
  *
  * PARAMETERS :
  *   @poll_cb : ptr to poll thread object
@@ -381,7 +464,10 @@ int32_t mm_camera_poll_thread_notify_entries_updated(mm_camera_poll_thread_t * p
  *==========================================================================*/
 int32_t mm_camera_poll_thread_commit_updates(mm_camera_poll_thread_t * poll_cb)
 {
-    return mm_camera_poll_sig(poll_cb, MM_CAMERA_PIPE_CMD_COMMIT);
+    pthread_mutex_lock(&poll_cb->mutex);
+    mm_camera_poll_wait_dispatch(poll_cb, -1);
+    pthread_mutex_unlock(&poll_cb->mutex);
+    return 0;
 }
 
 /*===========================================================================
@@ -396,7 +482,8 @@ int32_t mm_camera_poll_thread_commit_updates(mm_camera_poll_thread_t * poll_cb)
  *   @fd        : file descriptor need to be added into polling thread
  *   @notify_cb : callback function to handle if any notify from fd
  *   @userdata  : user data ptr
- *   @call_type : Whether its Synchronous or Asynchronous call
+ *   @call_type : Whether its Synchronous or Asynchronous call. fd is polled
+ *                as soon as this returns in both cases.
  *
  * RETURN     : none
  *==========================================================================*/
@@ -409,6 +496,8 @@ int32_t mm_camera_poll_thread_add_poll_fd(mm_camera_poll_thread_t * poll_cb,
 {
     int32_t rc = -1;
     uint8_t idx = 0;
+    mm_camera_poll_entry_t *entry = NULL;
+    struct epoll_event evt;
 
     if (MM_CAMERA_POLL_TYPE_DATA == poll_cb->poll_type) {
         /* get stream idx from handler if CH type */
@@ -419,16 +508,30 @@ int32_t mm_camera_poll_thread_add_poll_fd(mm_camera_poll_thread_t * poll_cb,
     }
 
     if (MAX_STREAM_NUM_IN_BUNDLE > idx) {
-        poll_cb->poll_entries[idx].fd = fd;
-        poll_cb->poll_entries[idx].handler = handler;
-        poll_cb->poll_entries[idx].notify_cb = notify_cb;
-        poll_cb->poll_entries[idx].user_data = userdata;
-        /* send poll entries updated signal to poll thread */
-        if (call_type == mm_camera_sync_call ) {
-            rc = mm_camera_poll_sig(poll_cb, MM_CAMERA_PIPE_CMD_POLL_ENTRIES_UPDATED);
-        } else {
-            rc = mm_camera_poll_sig_async(poll_cb, MM_CAMERA_PIPE_CMD_POLL_ENTRIES_UPDATED_ASYNC );
+        pthread_mutex_lock(&poll_cb->mutex);
+        entry = &poll_cb->poll_entries[idx];
+        if (entry->fd > 0) {
+            /* replace the old fd of this entry */
+            epoll_ctl(poll_cb->epoll_fd, EPOLL_CTL_DEL, entry->fd, NULL);
+        }
+        entry->fd = fd;
+        entry->handler = handler;
+        entry->notify_cb = notify_cb;
+        entry->user_data = userdata;
+        entry->gen++;
+
+        memset(&evt, 0, sizeof(evt));
+        evt.events = mm_camera_poll_get_events(poll_cb);
+        evt.data.u64 = MM_CAMERA_POLL_EVT_DATA(idx, entry->gen);
+        rc = epoll_ctl(poll_cb->epoll_fd, EPOLL_CTL_ADD, fd, &evt);
+        if (rc < 0) {
+            CDBG_ERROR("%s: epoll add fd %d failed: %s (call type %d)",
+                       __func__, fd, strerror(errno), call_type);
+            entry->fd = -1;
+            entry->handler = 0;
+            entry->notify_cb = NULL;
         }
+        pthread_mutex_unlock(&poll_cb->mutex);
     } else {
         CDBG_ERROR("%s: invalid handler %d (%d)",
                    __func__, handler, idx);
@@ -445,6 +548,8 @@ int32_t mm_camera_poll_thread_add_poll_fd(mm_camera_poll_thread_t * poll_cb,
  *   @poll_cb   : ptr to poll thread object
  *   @handler   : stream handle if channel data polling thread,
  *                0 if event polling thread
+ *   @call_type : mm_camera_sync_call also waits for a running notify_cb
+ *                of this fd to return
  *
  * RETURN     : int32_t type of status
  *              0  -- success
@@ -456,6 +561,7 @@ int32_t mm_camera_poll_thread_del_poll_fd(mm_camera_poll_thread_t * poll_cb,
 {
     int32_t rc = -1;
     uint8_t idx = 0;
+    mm_camera_poll_entry_t *entry = NULL;
 
     if (MM_CAMERA_POLL_TYPE_DATA == poll_cb->poll_type) {
         /* get stream idx from handler if CH type */
@@ -465,24 +571,28 @@ int32_t mm_camera_poll_thread_del_poll_fd(mm_camera_poll_thread_t * poll_cb,
         idx = 0;
     }
 
+    pthread_mutex_lock(&poll_cb->mutex);
     if ((MAX_STREAM_NUM_IN_BUNDLE > idx) &&
         (handler == poll_cb->poll_entries[idx].handler)) {
+        entry = &poll_cb->poll_entries[idx];
+        if (entry->fd > 0) {
+            epoll_ctl(poll_cb->epoll_fd, EPOLL_CTL_DEL, entry->fd, NULL);
+        }
         /* reset poll entry */
-        poll_cb->poll_entries[idx].fd = -1; /* set fd to invalid */
-        poll_cb->poll_entries[idx].handler = 0;
-        poll_cb->poll_entries[idx].notify_cb = NULL;
-
-        /* send poll entries updated signal to poll thread */
-        if (call_type == mm_camera_sync_call ) {
-            rc = mm_camera_poll_sig(poll_cb, MM_CAMERA_PIPE_CMD_POLL_ENTRIES_UPDATED);
-        } else {
-            rc = mm_camera_poll_sig_async(poll_cb, MM_CAMERA_PIPE_CMD_POLL_ENTRIES_UPDATED_ASYNC );
+        entry->fd = -1; /* set fd to invalid */
+        entry->handler = 0;
+        entry->notify_cb = NULL;
+        entry->gen++;
+
+        if (call_type == mm_camera_sync_call) {
+            mm_camera_poll_wait_dispatch(poll_cb, idx);
         }
+        rc = 0;
     } else {
         CDBG_ERROR("%s: invalid handler %d (%d)",
                    __func__, handler, idx);
-        return -1;
     }
+    pthread_mutex_unlock(&poll_cb->mutex);
 
     return rc;
 }
@@ -501,7 +611,16 @@ int32_t mm_camera_poll_thread_launch(mm_camera_poll_thread_t * poll_cb,
         return -1;
     }
 
+    rc = mm_camera_poll_create_epoll(poll_cb);
+    if (rc < 0) {
+        close(poll_cb->pfds[0]);
+        close(poll_cb->pfds[1]);
+        return -1;
+    }
+
     poll_cb->timeoutms = -1;  /* Infinite seconds */
+    poll_cb->dispatch_idx = -1;
+    poll_cb->dispatch_waiters = 0;
 
     CDBG("%s: poll_type = %d, read fd = %d, write fd = %d timeout = %d",
         __func__, poll_cb->poll_type,
@@ -514,7 +633,7 @@ int32_t mm_camera_poll_thread_launch(mm_camera_poll_thread_t * poll_cb,
     pthread_mutex_lock(&poll_cb->mutex);
     poll_cb->status = 0;
     pthread_create(&poll_cb->pid, NULL, mm_camera_poll_thread, (void *)poll_cb);
-    if(!poll_cb->status) {
+    while(!poll_cb->status) {
         pthread_cond_wait(&poll_cb->cond_v, &poll_cb->mutex);
     }
     if (!poll_cb->threadName) {
@@ -542,13 +661,16 @@ int32_t mm_camera_poll_thread_release(mm_camera_poll_thread_t *poll_cb)
         CDBG_ERROR("%s: pthread dead already\n", __func__);
     }
 
-    /* close pipe */
+    /* close pipe and epoll fd */
     if(poll_cb->pfds[0]) {
         close(poll_cb->pfds[0]);
     }
     if(poll_cb->pfds[1]) {
         close(poll_cb->pfds[1]);
     }
+    if(poll_cb->epoll_fd > 0) {
+        close(poll_cb->epoll_fd);
+    }
 
     pthread_mutex_destroy(&poll_cb->mutex);
     pthread_cond_destroy(&poll_cb->cond_v);
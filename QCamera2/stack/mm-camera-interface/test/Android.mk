@@ -0,0 +1,162 @@
+#stream buffer mapping bench
+OLD_LOCAL_PATH := $(LOCAL_PATH)
+MM_CAMERA_INTF_TEST_PATH := $(call my-dir)
+
+include $(MM_CAMERA_INTF_TEST_PATH)/../../../../common.mk
+include $(CLEAR_VARS)
+LOCAL_PATH := $(MM_CAMERA_INTF_TEST_PATH)
+LOCAL_MODULE_TAGS := optional
+
+LOCAL_CFLAGS := -Wall -Wextra -Werror -Wno-unused-parameter
+LOCAL_CFLAGS += -D_ANDROID_
+
+LOCAL_C_INCLUDES := $(MM_CAMERA_INTF_TEST_PATH)
+LOCAL_C_INCLUDES += $(MM_CAMERA_INTF_TEST_PATH)/../inc
+LOCAL_C_INCLUDES += $(MM_CAMERA_INTF_TEST_PATH)/../../common
+LOCAL_C_INCLUDES += $(kernel_includes)
+LOCAL_ADDITIONAL_DEPENDENCIES := $(common_deps)
+
+LOCAL_SRC_FILES := mm_camera_map_bench.c ../src/mm_camera_sock.c
+
+LOCAL_SHARED_LIBRARIES := libcutils liblog
+
+LOCAL_MODULE           := mm-camera-map-bench
+LOCAL_PRELINK_MODULE   := false
+
+include $(BUILD_EXECUTABLE)
+
+LOCAL_PATH := $(OLD_LOCAL_PATH)
+
+#superbuf matcher bench
+OLD_LOCAL_PATH := $(LOCAL_PATH)
+MM_CAMERA_INTF_TEST_PATH := $(call my-dir)
+
+include $(CLEAR_VARS)
+LOCAL_PATH := $(MM_CAMERA_INTF_TEST_PATH)
+LOCAL_MODULE_TAGS := optional
+
+LOCAL_CFLAGS := -Wall -Wextra -Werror -Wno-unused-parameter
+LOCAL_CFLAGS += -D_ANDROID_
+
+LOCAL_C_INCLUDES := $(MM_CAMERA_INTF_TEST_PATH)
+LOCAL_C_INCLUDES += $(MM_CAMERA_INTF_TEST_PATH)/../inc
+LOCAL_C_INCLUDES += $(MM_CAMERA_INTF_TEST_PATH)/../../common
+LOCAL_C_INCLUDES += $(kernel_includes)
+LOCAL_ADDITIONAL_DEPENDENCIES := $(common_deps)
+
+LOCAL_SRC_FILES := mm_camera_superbuf_bench.c ../src/mm_camera_channel.c
+
+LOCAL_SHARED_LIBRARIES := libcutils liblog
+
+LOCAL_MODULE           := mm-camera-superbuf-bench
+LOCAL_PRELINK_MODULE   := false
+
+include $(BUILD_EXECUTABLE)
+
+LOCAL_PATH := $(OLD_LOCAL_PATH)
+
+#poll thread harness
+OLD_LOCAL_PATH := $(LOCAL_PATH)
+MM_CAMERA_INTF_TEST_PATH := $(call my-dir)
+
+include $(CLEAR_VARS)
+LOCAL_PATH := $(MM_CAMERA_INTF_TEST_PATH)
+LOCAL_MODULE_TAGS := optional
+
+LOCAL_CFLAGS := -Wall -Wextra -Werror -Wno-unused-parameter
+LOCAL_CFLAGS += -D_ANDROID_
+
+LOCAL_C_INCLUDES := $(MM_CAMERA_INTF_TEST_PATH)
+LOCAL_C_INCLUDES += $(MM_CAMERA_INTF_TEST_PATH)/../inc
+LOCAL_C_INCLUDES += $(MM_CAMERA_INTF_TEST_PATH)/../../common
+LOCAL_C_INCLUDES += $(kernel_includes)
+LOCAL_ADDITIONAL_DEPENDENCIES := $(common_deps)
+
+LOCAL_SRC_FILES := mm_camera_poll_test.c ../src/mm_camera_thread.c
+
+LOCAL_SHARED_LIBRARIES := libcutils liblog
+
+LOCAL_MODULE           := mm-camera-poll-test
+LOCAL_PRELINK_MODULE   := false
+
+include $(BUILD_EXECUTABLE)
+
+LOCAL_PATH := $(OLD_LOCAL_PATH)
+
+#metadata lookup table bench
+OLD_LOCAL_PATH := $(LOCAL_PATH)
+MM_CAMERA_INTF_TEST_PATH := $(call my-dir)
+
+include $(CLEAR_VARS)
+LOCAL_PATH := $(MM_CAMERA_INTF_TEST_PATH)
+LOCAL_MODULE_TAGS := optional
+
+LOCAL_CFLAGS := -Wall -Wextra -Werror -Wno-unused-parameter
+LOCAL_CFLAGS += -D_ANDROID_
+
+LOCAL_C_INCLUDES := $(MM_CAMERA_INTF_TEST_PATH)
+LOCAL_C_INCLUDES += $(MM_CAMERA_INTF_TEST_PATH)/../inc
+LOCAL_C_INCLUDES += $(MM_CAMERA_INTF_TEST_PATH)/../../common
+LOCAL_C_INCLUDES += $(kernel_includes)
+LOCAL_ADDITIONAL_DEPENDENCIES := $(common_deps)
+
+LOCAL_SRC_FILES := mm_camera_intf_bench.c ../src/cam_intf.c
+
+LOCAL_MODULE           := mm-camera-intf-bench
+LOCAL_PRELINK_MODULE   := false
+
+include $(BUILD_EXECUTABLE)
+
+LOCAL_PATH := $(OLD_LOCAL_PATH)
+
+#sparse metadata iteration bench
+OLD_LOCAL_PATH := $(LOCAL_PATH)
+MM_CAMERA_INTF_TEST_PATH := $(call my-dir)
+
+include $(CLEAR_VARS)
+LOCAL_PATH := $(MM_CAMERA_INTF_TEST_PATH)
+LOCAL_MODULE_TAGS := optional
+
+LOCAL_CFLAGS := -Wall -Wextra -Werror -Wno-unused-parameter
+LOCAL_CFLAGS += -D_ANDROID_
+
+LOCAL_C_INCLUDES := $(MM_CAMERA_INTF_TEST_PATH)
+LOCAL_C_INCLUDES += $(MM_CAMERA_INTF_TEST_PATH)/../inc
+LOCAL_C_INCLUDES += $(MM_CAMERA_INTF_TEST_PATH)/../../common
+LOCAL_C_INCLUDES += $(kernel_includes)
+LOCAL_ADDITIONAL_DEPENDENCIES := $(common_deps)
+
+LOCAL_SRC_FILES := mm_camera_meta_iter_bench.c ../src/cam_intf.c
+
+LOCAL_MODULE           := mm-camera-meta-iter-bench
+LOCAL_PRELINK_MODULE   := false
+
+include $(BUILD_EXECUTABLE)
+
+LOCAL_PATH := $(OLD_LOCAL_PATH)
+
+#delta parameter batch test
+OLD_LOCAL_PATH := $(LOCAL_PATH)
+MM_CAMERA_INTF_TEST_PATH := $(call my-dir)
+
+include $(CLEAR_VARS)
+LOCAL_PATH := $(MM_CAMERA_INTF_TEST_PATH)
+LOCAL_MODULE_TAGS := optional
+
+LOCAL_CFLAGS := -Wall -Wextra -Werror -Wno-unused-parameter
+LOCAL_CFLAGS += -D_ANDROID_
+
+LOCAL_C_INCLUDES := $(MM_CAMERA_INTF_TEST_PATH)
+LOCAL_C_INCLUDES += $(MM_CAMERA_INTF_TEST_PATH)/../inc
+LOCAL_C_INCLUDES += $(MM_CAMERA_INTF_TEST_PATH)/../../common
+LOCAL_C_INCLUDES += $(kernel_includes)
+LOCAL_ADDITIONAL_DEPENDENCIES := $(common_deps)
+
+LOCAL_SRC_FILES := mm_camera_parm_delta_test.c ../src/cam_intf.c
+
+LOCAL_MODULE           := mm-camera-parm-delta-test
+LOCAL_PRELINK_MODULE   := false
+
+include $(BUILD_EXECUTABLE)
+
+LOCAL_PATH := $(OLD_LOCAL_PATH)
@@ -0,0 +1,222 @@
+/* Copyright (c) 2014, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+/* Metadata lookup benchmark for the cam_intf.c offset table.
+ *
+ * The reference is the switch form get_pointer_of/get_size_of had
+ * before the table, generated here from CAM_INTF_PARM_DATA_TABLE so it
+ * covers exactly the same entries.
+ *
+ * Correctness: for every param id, including ids without an entry and
+ * out of range ids, the table and the switch return the same pointer
+ * and size.
+ *
+ * Throughput: parses a metadata buffer with every entry valid, fetching
+ * pointer and size of each entry and folding its first byte into a
+ * checksum, once through the table and once through the switch.
+ *
+ * usage: mm-camera-intf-bench [-i iterations]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <time.h>
+#include "cam_intf.h"
+
+#define BENCH_DEFAULT_ITERATIONS 20000
+
+static int g_failures = 0;
+
+#define TEST_CHECK(cond) do { \
+    if (!(cond)) { \
+        printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+        g_failures++; \
+    } \
+} while (0)
+
+/* keeps the compiler from hoisting a parse out of the timing loop */
+#define BENCH_BARRIER(ptr) __asm__ __volatile__("" : : "r"(ptr) : "memory")
+
+#define BENCH_POINTER_CASE(PARAM_ID,DATATYPE,COUNT) \
+    case PARAM_ID: return (void *)&metadata->data.member_variable_##PARAM_ID;
+
+#define BENCH_SIZE_CASE(PARAM_ID,DATATYPE,COUNT) \
+    case PARAM_ID: return sizeof(DATATYPE) * (COUNT);
+
+#define BENCH_NO_CASE(PARAM_ID,DATATYPE,COUNT)
+
+static __attribute__((noinline)) void *bench_switch_pointer_of(
+        cam_intf_parm_type_t meta_id, const metadata_buffer_t *metadata)
+{
+    switch (meta_id) {
+    CAM_INTF_PARM_DATA_TABLE(BENCH_POINTER_CASE, BENCH_NO_CASE)
+    default:
+        return NULL;
+    }
+}
+
+static __attribute__((noinline)) uint32_t bench_switch_size_of(
+        cam_intf_parm_type_t param_id)
+{
+    switch (param_id) {
+    CAM_INTF_PARM_DATA_TABLE(BENCH_SIZE_CASE, BENCH_NO_CASE)
+    default:
+        return 0;
+    }
+}
+
+static int64_t benchNowNs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static void benchCheck(const metadata_buffer_t *metadata)
+{
+    uint32_t i;
+
+    for (i = 0; i < CAM_INTF_PARM_MAX + 4; i++) {
+        cam_intf_parm_type_t id = (cam_intf_parm_type_t)i;
+        TEST_CHECK(get_pointer_of(id, metadata) ==
+                   bench_switch_pointer_of(id, metadata));
+        TEST_CHECK(get_size_of(id) == bench_switch_size_of(id));
+    }
+    TEST_CHECK(NULL == get_pointer_of((cam_intf_parm_type_t)-1, metadata));
+    TEST_CHECK(0 == get_size_of((cam_intf_parm_type_t)-1));
+}
+
+static uint32_t benchParseTable(const metadata_buffer_t *metadata)
+{
+    uint32_t i, sum = 0;
+
+    for (i = 0; i < CAM_INTF_PARM_MAX; i++) {
+        cam_intf_parm_type_t id = (cam_intf_parm_type_t)i;
+        const uint8_t *entry;
+        if (!metadata->is_valid[i]) {
+            continue;
+        }
+        entry = (const uint8_t *)get_pointer_of(id, metadata);
+        if (NULL != entry) {
+            sum += entry[0] + get_size_of(id);
+        }
+    }
+    return sum;
+}
+
+static uint32_t benchParseSwitch(const metadata_buffer_t *metadata)
+{
+    uint32_t i, sum = 0;
+
+    for (i = 0; i < CAM_INTF_PARM_MAX; i++) {
+        cam_intf_parm_type_t id = (cam_intf_parm_type_t)i;
+        const uint8_t *entry;
+        if (!metadata->is_valid[i]) {
+            continue;
+        }
+        entry = (const uint8_t *)bench_switch_pointer_of(id, metadata);
+        if (NULL != entry) {
+            sum += entry[0] + bench_switch_size_of(id);
+        }
+    }
+    return sum;
+}
+
+int main(int argc, char **argv)
+{
+    metadata_buffer_t *metadata;
+    uint32_t iterations = BENCH_DEFAULT_ITERATIONS;
+    uint32_t i, entries = 0, sum_table = 0, sum_switch = 0;
+    int64_t t0, t_table, t_switch;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "i:")) != -1) {
+        switch (opt) {
+        case 'i':
+            iterations = (uint32_t)atoi(optarg);
+            break;
+        default:
+            printf("usage: %s [-i iterations]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (iterations == 0) {
+        iterations = 1;
+    }
+
+    metadata = (metadata_buffer_t *)malloc(sizeof(metadata_buffer_t));
+    if (NULL == metadata) {
+        printf("no memory for metadata buffer\n");
+        return 1;
+    }
+    memset(metadata, 0, sizeof(metadata_buffer_t));
+    for (i = 0; i < CAM_INTF_PARM_MAX; i++) {
+        uint8_t *entry = (uint8_t *)get_pointer_of((cam_intf_parm_type_t)i,
+                                                   metadata);
+        if (NULL != entry) {
+            memset(entry, (int)(i & 0xFF), get_size_of((cam_intf_parm_type_t)i));
+            metadata->is_valid[i] = 1;
+            entries++;
+        }
+    }
+
+    benchCheck(metadata);
+    TEST_CHECK(benchParseTable(metadata) == benchParseSwitch(metadata));
+
+    t0 = benchNowNs();
+    for (i = 0; i < iterations; i++) {
+        BENCH_BARRIER(metadata);
+        sum_table += benchParseTable(metadata);
+    }
+    t_table = benchNowNs() - t0;
+
+    t0 = benchNowNs();
+    for (i = 0; i < iterations; i++) {
+        BENCH_BARRIER(metadata);
+        sum_switch += benchParseSwitch(metadata);
+    }
+    t_switch = benchNowNs() - t0;
+    TEST_CHECK(sum_table == sum_switch);
+
+    printf("%u of %d ids have an entry, %u iterations\n",
+           entries, CAM_INTF_PARM_MAX, iterations);
+    printf("table : %8.1f ns/frame %6.2f ns/entry\n",
+           (double)t_table / iterations,
+           (double)t_table / iterations / entries);
+    printf("switch: %8.1f ns/frame %6.2f ns/entry\n",
+           (double)t_switch / iterations,
+           (double)t_switch / iterations / entries);
+
+    free(metadata);
+    printf("%s: %d failures\n", g_failures ? "FAIL" : "PASS", g_failures);
+    return g_failures ? 1 : 0;
+}
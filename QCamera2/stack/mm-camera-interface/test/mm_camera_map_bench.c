@@ -0,0 +1,434 @@
+/* Copyright (c) 2014, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+/* Stream buffer mapping benchmark.
+ *
+ * A server thread on the other end of a socketpair stands in for
+ * the camera daemon: it receives mapping packets, checks that every
+ * mapping entry came with a valid file descriptor, optionally waits
+ * a fixed time per message to model the daemon and kernel event
+ * round trip, and answers with a status word in place of the
+ * CAM_EVENT_TYPE_MAP_UNMAP_DONE event.
+ *
+ * The same set of buffers is mapped and unmapped one packet per
+ * buffer, as the HAL did through map_ops, and as a single bundled
+ * packet per direction.
+ *
+ * usage: mm-camera-map-bench [-n num_bufs] [-i iterations] [-d delay_us]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <time.h>
+#include <sys/stat.h>
+#include "mm_camera_sock.h"
+
+#define BENCH_DEFAULT_BUFS 16
+#define BENCH_DEFAULT_ITERATIONS 200
+#define BENCH_BUF_SIZE (1920 * 1088 * 3 / 2)
+
+volatile uint32_t gMmCameraIntfLogLevel = 0;
+
+/** bench_server_t
+*  @fd: server end of the socketpair
+*  @delay_us: processing time per message
+*  @mapped: number of buffers currently mapped
+*  @errors: number of malformed messages
+**/
+typedef struct {
+    int fd;
+    int64_t delay_us;
+    int32_t mapped;
+    int32_t errors;
+} bench_server_t;
+
+static int64_t bench_now_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+/*===========================================================================
+ * FUNCTION   : bench_recv_packet
+ *
+ * DESCRIPTION: receive one packet and all file descriptors attached to it
+ *
+ * PARAMETERS :
+ *   @fd      : socket fd
+ *   @packet  : packet to fill
+ *   @fds     : received file descriptors
+ *
+ * RETURN     : number of file descriptors received, -1 on socket error
+ *==========================================================================*/
+static int bench_recv_packet(int fd, cam_sock_bundled_packet_t *packet,
+                             int fds[CAM_MAX_NUM_BUFS_PER_MAP])
+{
+    struct msghdr msgh;
+    struct iovec iov[1];
+    struct cmsghdr *cmsghp;
+    char control[CMSG_SPACE(sizeof(int) * CAM_MAX_NUM_BUFS_PER_MAP)];
+    int numfds = 0;
+
+    memset(&msgh, 0, sizeof(msgh));
+    iov[0].iov_base = packet;
+    iov[0].iov_len = sizeof(cam_sock_bundled_packet_t);
+    msgh.msg_iov = iov;
+    msgh.msg_iovlen = 1;
+    msgh.msg_control = control;
+    msgh.msg_controllen = sizeof(control);
+
+    if (recvmsg(fd, &msgh, 0) <= 0) {
+        return -1;
+    }
+
+    for (cmsghp = CMSG_FIRSTHDR(&msgh); cmsghp != NULL;
+            cmsghp = CMSG_NXTHDR(&msgh, cmsghp)) {
+        if ((cmsghp->cmsg_level == SOL_SOCKET) &&
+                (cmsghp->cmsg_type == SCM_RIGHTS)) {
+            int n = (int)((cmsghp->cmsg_len - CMSG_LEN(0)) / sizeof(int));
+            memcpy(&fds[numfds], CMSG_DATA(cmsghp), sizeof(int) * (size_t)n);
+            numfds += n;
+        }
+    }
+    return numfds;
+}
+
+/*===========================================================================
+ * FUNCTION   : bench_server_thread
+ *
+ * DESCRIPTION: stand-in for the daemon side of the mapping protocol
+ *
+ * PARAMETERS :
+ *   @data    : server state
+ *
+ * RETURN     : NULL
+ *==========================================================================*/
+static void *bench_server_thread(void *data)
+{
+    bench_server_t *server = (bench_server_t *)data;
+    cam_sock_bundled_packet_t packet;
+    int fds[CAM_MAX_NUM_BUFS_PER_MAP];
+    int numfds, expected, i;
+    int32_t status;
+    struct stat st;
+
+    while ((numfds = bench_recv_packet(server->fd, &packet, fds)) >= 0) {
+        switch (packet.msg_type) {
+        case CAM_MAPPING_TYPE_FD_MAPPING:
+            expected = 1;
+            break;
+        case CAM_MAPPING_TYPE_FD_BUNDLED_MAPPING:
+            expected = (int)packet.payload.buf_map_list.length;
+            break;
+        case CAM_MAPPING_TYPE_FD_UNMAPPING:
+        case CAM_MAPPING_TYPE_FD_BUNDLED_UNMAPPING:
+            expected = 0;
+            break;
+        default:
+            /* shutdown request */
+            return NULL;
+        }
+
+        status = 0;
+        if (numfds != expected) {
+            status = -1;
+        }
+        for (i = 0; i < numfds; i++) {
+            if (fstat(fds[i], &st) != 0) {
+                status = -1;
+            }
+            close(fds[i]);
+        }
+        if (status == 0) {
+            if (packet.msg_type == CAM_MAPPING_TYPE_FD_MAPPING) {
+                server->mapped++;
+            } else if (packet.msg_type == CAM_MAPPING_TYPE_FD_BUNDLED_MAPPING) {
+                server->mapped += (int32_t)packet.payload.buf_map_list.length;
+            } else if (packet.msg_type == CAM_MAPPING_TYPE_FD_UNMAPPING) {
+                server->mapped--;
+            } else {
+                server->mapped -= (int32_t)packet.payload.buf_unmap_list.length;
+            }
+        } else {
+            server->errors++;
+        }
+
+        if (server->delay_us > 0) {
+            usleep((useconds_t)server->delay_us);
+        }
+        if (write(server->fd, &status, sizeof(status)) != sizeof(status)) {
+            return NULL;
+        }
+    }
+    return NULL;
+}
+
+/*===========================================================================
+ * FUNCTION   : bench_wait_done
+ *
+ * DESCRIPTION: wait for the server answer, like mm_camera_util_wait_for_event
+ *              waiting for CAM_EVENT_TYPE_MAP_UNMAP_DONE
+ *
+ * PARAMETERS :
+ *   @fd      : client end of the socketpair
+ *
+ * RETURN     : 0 on success, -1 on failure
+ *==========================================================================*/
+static int bench_wait_done(int fd)
+{
+    int32_t status;
+
+    if (read(fd, &status, sizeof(status)) != sizeof(status)) {
+        return -1;
+    }
+    return status;
+}
+
+static int bench_map_single(int fd, int *buf_fds, int num_bufs)
+{
+    cam_sock_packet_t packet;
+    int i;
+
+    for (i = 0; i < num_bufs; i++) {
+        memset(&packet, 0, sizeof(packet));
+        packet.msg_type = CAM_MAPPING_TYPE_FD_MAPPING;
+        packet.payload.buf_map.type = CAM_MAPPING_BUF_TYPE_STREAM_BUF;
+        packet.payload.buf_map.frame_idx = (uint32_t)i;
+        packet.payload.buf_map.plane_idx = -1;
+        packet.payload.buf_map.fd = buf_fds[i];
+        packet.payload.buf_map.size = BENCH_BUF_SIZE;
+        if ((mm_camera_socket_sendmsg(fd, &packet, sizeof(packet),
+                buf_fds[i]) <= 0) || (bench_wait_done(fd) != 0)) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+static int bench_unmap_single(int fd, int num_bufs)
+{
+    cam_sock_packet_t packet;
+    int i;
+
+    for (i = 0; i < num_bufs; i++) {
+        memset(&packet, 0, sizeof(packet));
+        packet.msg_type = CAM_MAPPING_TYPE_FD_UNMAPPING;
+        packet.payload.buf_unmap.type = CAM_MAPPING_BUF_TYPE_STREAM_BUF;
+        packet.payload.buf_unmap.frame_idx = (uint32_t)i;
+        packet.payload.buf_unmap.plane_idx = -1;
+        if ((mm_camera_socket_sendmsg(fd, &packet, sizeof(packet), 0) <= 0) ||
+                (bench_wait_done(fd) != 0)) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+static int bench_map_bundled(int fd, int *buf_fds, int num_bufs)
+{
+    cam_sock_bundled_packet_t packet;
+    cam_buf_map_type *buf_map;
+    int i;
+
+    memset(&packet, 0, sizeof(packet));
+    packet.msg_type = CAM_MAPPING_TYPE_FD_BUNDLED_MAPPING;
+    packet.payload.buf_map_list.length = (uint32_t)num_bufs;
+    for (i = 0; i < num_bufs; i++) {
+        buf_map = &packet.payload.buf_map_list.buf_maps[i];
+        buf_map->type = CAM_MAPPING_BUF_TYPE_STREAM_BUF;
+        buf_map->frame_idx = (uint32_t)i;
+        buf_map->plane_idx = -1;
+        buf_map->fd = buf_fds[i];
+        buf_map->size = BENCH_BUF_SIZE;
+    }
+    if ((mm_camera_socket_bundle_sendmsg(fd, &packet, sizeof(packet),
+            buf_fds, num_bufs) <= 0) || (bench_wait_done(fd) != 0)) {
+        return -1;
+    }
+    return 0;
+}
+
+static int bench_unmap_bundled(int fd, int num_bufs)
+{
+    cam_sock_bundled_packet_t packet;
+    cam_buf_unmap_type *buf_unmap;
+    int i;
+
+    memset(&packet, 0, sizeof(packet));
+    packet.msg_type = CAM_MAPPING_TYPE_FD_BUNDLED_UNMAPPING;
+    packet.payload.buf_unmap_list.length = (uint32_t)num_bufs;
+    for (i = 0; i < num_bufs; i++) {
+        buf_unmap = &packet.payload.buf_unmap_list.buf_unmaps[i];
+        buf_unmap->type = CAM_MAPPING_BUF_TYPE_STREAM_BUF;
+        buf_unmap->frame_idx = (uint32_t)i;
+        buf_unmap->plane_idx = -1;
+    }
+    if ((mm_camera_socket_bundle_sendmsg(fd, &packet, sizeof(packet),
+            NULL, 0) <= 0) || (bench_wait_done(fd) != 0)) {
+        return -1;
+    }
+    return 0;
+}
+
+static int bench_cmp(const void *a, const void *b)
+{
+    int64_t x = *(const int64_t *)a, y = *(const int64_t *)b;
+    return (x > y) - (x < y);
+}
+
+static void bench_report(const char *name, int64_t *lat, int n)
+{
+    int64_t sum = 0;
+    int i;
+
+    qsort(lat, (size_t)n, sizeof(int64_t), bench_cmp);
+    for (i = 0; i < n; i++) {
+        sum += lat[i];
+    }
+    printf("  %-18s avg %7lld us  p50 %7lld us  p99 %7lld us\n", name,
+           (long long)(sum / n), (long long)lat[n / 2],
+           (long long)lat[(n * 99) / 100]);
+}
+
+int main(int argc, char **argv)
+{
+    int sv[2];
+    int buf_fds[CAM_MAX_NUM_BUFS_PER_MAP];
+    int num_bufs = BENCH_DEFAULT_BUFS;
+    int iterations = BENCH_DEFAULT_ITERATIONS;
+    bench_server_t server;
+    pthread_t server_pid;
+    cam_sock_packet_t packet;
+    int64_t *lat[4];
+    int64_t t;
+    int opt, i, mode, rc = 0;
+    static const char *names[4] =
+        { "map single", "unmap single", "map bundled", "unmap bundled" };
+
+    memset(&server, 0, sizeof(server));
+    while ((opt = getopt(argc, argv, "n:i:d:")) != -1) {
+        switch (opt) {
+        case 'n':
+            num_bufs = atoi(optarg);
+            break;
+        case 'i':
+            iterations = atoi(optarg);
+            break;
+        case 'd':
+            server.delay_us = atoi(optarg);
+            break;
+        default:
+            printf("usage: %s [-n num_bufs] [-i iterations] [-d delay_us]\n",
+                   argv[0]);
+            return 1;
+        }
+    }
+    if ((num_bufs < 1) || (num_bufs > CAM_MAX_NUM_BUFS_PER_MAP) ||
+            (iterations < 1)) {
+        printf("num_bufs must be 1..%d, iterations at least 1\n",
+               CAM_MAX_NUM_BUFS_PER_MAP);
+        return 1;
+    }
+
+    if (socketpair(AF_UNIX, SOCK_DGRAM, 0, sv) != 0) {
+        perror("socketpair");
+        return 1;
+    }
+    for (i = 0; i < num_bufs; i++) {
+        buf_fds[i] = open("/dev/zero", O_RDWR);
+        if (buf_fds[i] < 0) {
+            perror("open");
+            return 1;
+        }
+    }
+    for (mode = 0; mode < 4; mode++) {
+        lat[mode] = (int64_t *)malloc(sizeof(int64_t) * (size_t)iterations);
+        if (lat[mode] == NULL) {
+            return 1;
+        }
+    }
+
+    server.fd = sv[1];
+    pthread_create(&server_pid, NULL, bench_server_thread, &server);
+
+    for (i = 0; (i < iterations) && (rc == 0); i++) {
+        t = bench_now_us();
+        rc |= bench_map_single(sv[0], buf_fds, num_bufs);
+        lat[0][i] = bench_now_us() - t;
+        rc |= (server.mapped != num_bufs);
+
+        t = bench_now_us();
+        rc |= bench_unmap_single(sv[0], num_bufs);
+        lat[1][i] = bench_now_us() - t;
+        rc |= (server.mapped != 0);
+
+        t = bench_now_us();
+        rc |= bench_map_bundled(sv[0], buf_fds, num_bufs);
+        lat[2][i] = bench_now_us() - t;
+        rc |= (server.mapped != num_bufs);
+
+        t = bench_now_us();
+        rc |= bench_unmap_bundled(sv[0], num_bufs);
+        lat[3][i] = bench_now_us() - t;
+        rc |= (server.mapped != 0);
+    }
+
+    /* unknown message type stops the server */
+    memset(&packet, 0, sizeof(packet));
+    packet.msg_type = CAM_MAPPING_TYPE_MAX;
+    mm_camera_socket_sendmsg(sv[0], &packet, sizeof(packet), 0);
+    pthread_join(server_pid, NULL);
+
+    if ((rc != 0) || (server.errors != 0)) {
+        printf("FAILED: mapping protocol error after %d iterations, "
+               "%d malformed messages\n", i, server.errors);
+        return 1;
+    }
+
+    printf("%d buffers, %d iterations, %lld us per daemon round trip, "
+           "packet %zu bytes, bundled packet %zu bytes\n", num_bufs,
+           iterations, (long long)server.delay_us, sizeof(cam_sock_packet_t),
+           sizeof(cam_sock_bundled_packet_t));
+    for (mode = 0; mode < 4; mode++) {
+        bench_report(names[mode], lat[mode], iterations);
+        free(lat[mode]);
+    }
+    for (i = 0; i < num_bufs; i++) {
+        close(buf_fds[i]);
+    }
+    close(sv[0]);
+    close(sv[1]);
+    return 0;
+}
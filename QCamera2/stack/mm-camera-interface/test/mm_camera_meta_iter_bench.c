@@ -0,0 +1,247 @@
+/* Copyright (c) 2014, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+/* Sparse metadata iteration benchmark.
+ *
+ * Builds random metadata frames with a given number of valid entries,
+ * the way the daemon fills only the results of the current frame, and
+ * visits every valid entry two ways: probing every is_valid flag up to
+ * CAM_INTF_PARM_MAX, and cam_intf_build_valid_map plus the
+ * cam_intf_valid_iter_* helpers. Each visit reads the first byte of the
+ * entry, like a translate routine would.
+ *
+ * Correctness: for every frame the iterator visits exactly the ids whose
+ * flag is set, in increasing order, and build_valid_map returns their
+ * count. Frames with no entries and with every entry are included.
+ *
+ * usage: mm-camera-meta-iter-bench [-f frames] [-n entries_per_frame]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <time.h>
+#include "cam_intf.h"
+
+#define BENCH_DEFAULT_FRAMES 2000
+#define BENCH_REPEAT 20
+
+static int g_failures = 0;
+
+#define TEST_CHECK(cond) do { \
+    if (!(cond)) { \
+        printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+        g_failures++; \
+    } \
+} while (0)
+
+/* keeps the compiler from hoisting a visit out of the timing loop */
+#define BENCH_BARRIER(ptr) __asm__ __volatile__("" : : "r"(ptr) : "memory")
+
+static int64_t benchNowNs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+/* ids that have a parm_data_t entry, the only ones the daemon sets */
+static cam_intf_parm_type_t g_ids[CAM_INTF_PARM_MAX];
+static uint32_t g_num_ids;
+
+static void benchFillFrame(metadata_buffer_t *metadata, uint32_t entries)
+{
+    uint32_t i;
+
+    memset(metadata->is_valid, 0, sizeof(metadata->is_valid));
+    if (entries >= g_num_ids) {
+        for (i = 0; i < g_num_ids; i++) {
+            metadata->is_valid[g_ids[i]] = 1;
+        }
+        return;
+    }
+    for (i = 0; i < entries; ) {
+        cam_intf_parm_type_t id = g_ids[rand() % g_num_ids];
+        if (!metadata->is_valid[id]) {
+            metadata->is_valid[id] = 1;
+            i++;
+        }
+    }
+}
+
+static uint32_t benchVisit(const metadata_buffer_t *metadata,
+                           cam_intf_parm_type_t id)
+{
+    const uint8_t *entry = (const uint8_t *)get_pointer_of(id, metadata);
+    return (NULL != entry) ? (uint32_t)entry[0] + id : 0;
+}
+
+static uint32_t benchProbe(const metadata_buffer_t *metadata)
+{
+    uint32_t i, sum = 0;
+
+    for (i = 0; i < CAM_INTF_PARM_MAX; i++) {
+        if (metadata->is_valid[i]) {
+            sum += benchVisit(metadata, (cam_intf_parm_type_t)i);
+        }
+    }
+    return sum;
+}
+
+static uint32_t benchIterate(const metadata_buffer_t *metadata)
+{
+    cam_intf_valid_map_t map;
+    cam_intf_valid_iter_t iter;
+    cam_intf_parm_type_t id;
+    uint32_t sum = 0;
+
+    cam_intf_build_valid_map(metadata, &map);
+    cam_intf_valid_iter_init(&iter, &map);
+    while (cam_intf_valid_iter_next(&iter, &id)) {
+        sum += benchVisit(metadata, id);
+    }
+    return sum;
+}
+
+static void benchCheckFrame(const metadata_buffer_t *metadata)
+{
+    cam_intf_valid_map_t map;
+    cam_intf_valid_iter_t iter;
+    cam_intf_parm_type_t id;
+    uint32_t i, count, visited = 0, expected = 0;
+    int32_t last = -1;
+
+    count = cam_intf_build_valid_map(metadata, &map);
+    cam_intf_valid_iter_init(&iter, &map);
+    while (cam_intf_valid_iter_next(&iter, &id)) {
+        TEST_CHECK((uint32_t)id < CAM_INTF_PARM_MAX);
+        TEST_CHECK((int32_t)id > last);
+        TEST_CHECK(metadata->is_valid[id]);
+        last = (int32_t)id;
+        visited++;
+    }
+    for (i = 0; i < CAM_INTF_PARM_MAX; i++) {
+        if (metadata->is_valid[i]) {
+            expected++;
+        }
+    }
+    TEST_CHECK(visited == expected);
+    TEST_CHECK(count == expected);
+    TEST_CHECK(benchProbe(metadata) == benchIterate(metadata));
+}
+
+static void benchRun(metadata_buffer_t *metadata, uint32_t frames,
+                     uint32_t entries)
+{
+    uint32_t f, r, sum_probe = 0, sum_iter = 0;
+    int64_t t0, t_probe = 0, t_iter = 0;
+
+    srand(entries + 1);
+    for (f = 0; f < frames; f++) {
+        benchFillFrame(metadata, entries);
+        benchCheckFrame(metadata);
+
+        t0 = benchNowNs();
+        for (r = 0; r < BENCH_REPEAT; r++) {
+            BENCH_BARRIER(metadata);
+            sum_probe += benchProbe(metadata);
+        }
+        t_probe += benchNowNs() - t0;
+
+        t0 = benchNowNs();
+        for (r = 0; r < BENCH_REPEAT; r++) {
+            BENCH_BARRIER(metadata);
+            sum_iter += benchIterate(metadata);
+        }
+        t_iter += benchNowNs() - t0;
+    }
+    TEST_CHECK(sum_probe == sum_iter);
+
+    printf("%3u of %3u entries: probe %7.1f ns/frame, bitmap+iter %7.1f ns/frame\n",
+           entries < g_num_ids ? entries : g_num_ids, g_num_ids,
+           (double)t_probe / (frames * BENCH_REPEAT),
+           (double)t_iter / (frames * BENCH_REPEAT));
+}
+
+int main(int argc, char **argv)
+{
+    static const uint32_t loads[] = { 0, 5, 15, 30, 60 };
+    metadata_buffer_t *metadata;
+    uint32_t frames = BENCH_DEFAULT_FRAMES;
+    uint32_t entries = 0;
+    uint32_t i;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "f:n:")) != -1) {
+        switch (opt) {
+        case 'f':
+            frames = (uint32_t)atoi(optarg);
+            break;
+        case 'n':
+            entries = (uint32_t)atoi(optarg);
+            break;
+        default:
+            printf("usage: %s [-f frames] [-n entries_per_frame]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (frames == 0) {
+        frames = 1;
+    }
+
+    metadata = (metadata_buffer_t *)malloc(sizeof(metadata_buffer_t));
+    if (NULL == metadata) {
+        printf("no memory for metadata buffer\n");
+        return 1;
+    }
+    memset(metadata, 0, sizeof(metadata_buffer_t));
+    for (i = 0; i < CAM_INTF_PARM_MAX; i++) {
+        uint8_t *entry = (uint8_t *)get_pointer_of((cam_intf_parm_type_t)i,
+                                                   metadata);
+        if (NULL != entry) {
+            memset(entry, (int)(i & 0xFF), get_size_of((cam_intf_parm_type_t)i));
+            g_ids[g_num_ids++] = (cam_intf_parm_type_t)i;
+        }
+    }
+
+    if (entries > 0) {
+        benchRun(metadata, frames, entries);
+    } else {
+        for (i = 0; i < sizeof(loads) / sizeof(loads[0]); i++) {
+            benchRun(metadata, frames, loads[i]);
+        }
+        benchRun(metadata, frames, g_num_ids);
+    }
+
+    free(metadata);
+    printf("%s: %d failures\n", g_failures ? "FAIL" : "PASS", g_failures);
+    return g_failures ? 1 : 0;
+}
@@ -0,0 +1,370 @@
+/* Copyright (c) 2014, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+/* Delta parameter batch round trip test.
+ *
+ * Builds random set_parms batches the way the HAL does, with
+ * cam_parm_batch_init/cam_parm_batch_add/cam_parm_batch_add_get on a flat
+ * parm_buffer_t, and sends each one the way mm_camera_set_parms_delta does:
+ * TLV encoded into a cam_sock_parm_delta_packet_t over a datagram socket.
+ * A stand-in backend on the other end of the socket decodes the packet into
+ * its own parm_buffer_t.
+ *
+ * Correctness: after every request the backend table has the same valid and
+ * get flags as the HAL table and the same bytes for every entry set in the
+ * request. A full table encoded without dirty tracker round trips as well,
+ * and truncated or out of range deltas are rejected.
+ *
+ * Bytes per request: bytes received by the backend per request, against
+ * the flat parm_buffer_t the daemon reads on the set_parms path. Batches
+ * whose delta does not fit in one packet are counted at the flat size, as
+ * set_parms_delta falls back to set_parms for them.
+ *
+ * usage: mm-camera-parm-delta-test [-r requests] [-n max params] [-s seed]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <time.h>
+#include <sys/socket.h>
+#include "cam_intf.h"
+
+#define TEST_DEFAULT_REQUESTS 2000
+#define TEST_DEFAULT_MAX_PARAMS 32
+
+static int g_failures = 0;
+
+#define TEST_CHECK(cond) do { \
+    if (!(cond)) { \
+        printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+        g_failures++; \
+    } \
+} while (0)
+
+typedef struct {
+    int fd;                             /* backend end of the socket */
+    parm_buffer_t *table;               /* backend copy of the parameters */
+    cam_sock_parm_delta_packet_t packet;
+} test_backend_t;
+
+static uint32_t g_ids[CAM_INTF_PARM_MAX];  /* param ids having an entry */
+static uint32_t g_num_ids = 0;
+
+static int64_t testNowNs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+/* stand-in for the daemon: receive one delta packet and apply it */
+static ssize_t testBackendReceive(test_backend_t *backend)
+{
+    cam_parm_delta_t delta;
+    ssize_t len;
+
+    len = recv(backend->fd, &backend->packet, sizeof(backend->packet), 0);
+    if (len < (ssize_t)CAM_PARM_DELTA_PACKET_SIZE(0)) {
+        return -1;
+    }
+    if ((backend->packet.msg_type != CAM_MAPPING_TYPE_PARM_DELTA) ||
+        ((size_t)len != CAM_PARM_DELTA_PACKET_SIZE(backend->packet.size))) {
+        return -1;
+    }
+    delta.data = backend->packet.data;
+    delta.capacity = CAM_PARM_DELTA_MAX_SIZE;
+    delta.size = backend->packet.size;
+    delta.num_entries = backend->packet.num_entries;
+    if (cam_parm_delta_decode(&delta, backend->table) < 0) {
+        return -1;
+    }
+    return len;
+}
+
+/* HAL side of mm_camera_set_parms_delta, returns bytes sent or -1 */
+static ssize_t testSendDelta(int fd, const parm_buffer_t *table,
+        const cam_parm_dirty_t *dirty, cam_sock_parm_delta_packet_t *packet)
+{
+    cam_parm_delta_t delta;
+
+    delta.data = packet->data;
+    delta.capacity = CAM_PARM_DELTA_MAX_SIZE;
+    if (cam_parm_delta_encode(table, dirty, &delta) < 0) {
+        return -1;
+    }
+    packet->msg_type = CAM_MAPPING_TYPE_PARM_DELTA;
+    packet->size = delta.size;
+    packet->num_entries = delta.num_entries;
+    return send(fd, packet, CAM_PARM_DELTA_PACKET_SIZE(delta.size), 0);
+}
+
+/* every entry of the request reached the backend, nothing else did */
+static void testCompare(const parm_buffer_t *hal, const parm_buffer_t *backend,
+        const cam_parm_dirty_t *dirty)
+{
+    uint32_t i;
+
+    TEST_CHECK(0 == memcmp(hal->is_valid, backend->is_valid,
+                           sizeof(hal->is_valid)));
+    for (i = 0; i < dirty->num_entries; i++) {
+        cam_intf_parm_type_t id = (cam_intf_parm_type_t)dirty->ids[i];
+        if (dirty->length[id] == 0) {
+            TEST_CHECK(backend->is_reqd[id]);
+            continue;
+        }
+        TEST_CHECK(0 == memcmp(get_pointer_of(id, hal),
+                               get_pointer_of(id, backend), get_size_of(id)));
+    }
+}
+
+static void testFillRequest(parm_buffer_t *table, cam_parm_dirty_t *dirty,
+        uint32_t num_params)
+{
+    uint8_t value[4096];
+    uint32_t i, j, id, size, length;
+
+    cam_parm_batch_init(table, dirty);
+    for (i = 0; i < num_params; i++) {
+        id = g_ids[(uint32_t)rand() % g_num_ids];
+        if (dirty->dirty[id]) {
+            continue;
+        }
+        if (((uint32_t)rand() % 8) == 0) {
+            TEST_CHECK(0 == cam_parm_batch_add_get(table, dirty,
+                                                   (cam_intf_parm_type_t)id));
+            continue;
+        }
+        size = get_size_of((cam_intf_parm_type_t)id);
+        if (size > sizeof(value)) {
+            size = sizeof(value);
+        }
+        /* most entries are set in full, some only partially */
+        length = (((uint32_t)rand() % 4) == 0) ?
+            1 + (uint32_t)rand() % size : size;
+        for (j = 0; j < length; j++) {
+            value[j] = (uint8_t)rand();
+        }
+        TEST_CHECK(0 == cam_parm_batch_add(table, dirty,
+                                           (cam_intf_parm_type_t)id,
+                                           length, value));
+    }
+}
+
+static void testFullTable(int fd, test_backend_t *backend,
+        parm_buffer_t *hal, cam_sock_parm_delta_packet_t *packet)
+{
+    uint8_t data[sizeof(cam_parm_delta_entry_t) + 4];
+    cam_parm_delta_entry_t entry;
+    cam_parm_delta_t delta;
+    uint8_t *storage;
+    uint32_t i;
+
+    /* without dirty tracker every valid entry is carried in full */
+    memset(hal, 0, sizeof(parm_buffer_t));
+    for (i = 0; i < g_num_ids; i++) {
+        cam_intf_parm_type_t id = (cam_intf_parm_type_t)g_ids[i];
+        if ((i % 3) == 0) {
+            memset(get_pointer_of(id, hal), (int)(i & 0xFF), get_size_of(id));
+            hal->is_valid[id] = 1;
+        }
+    }
+    storage = (uint8_t *)malloc(sizeof(parm_buffer_t) * 2);
+    TEST_CHECK(NULL != storage);
+    if (NULL == storage) {
+        return;
+    }
+    delta.data = storage;
+    delta.capacity = sizeof(parm_buffer_t) * 2;
+    TEST_CHECK(0 == cam_parm_delta_encode(hal, NULL, &delta));
+    TEST_CHECK(0 == cam_parm_delta_decode(&delta, backend->table));
+    for (i = 0; i < g_num_ids; i++) {
+        cam_intf_parm_type_t id = (cam_intf_parm_type_t)g_ids[i];
+        TEST_CHECK(hal->is_valid[id] == backend->table->is_valid[id]);
+        if (hal->is_valid[id]) {
+            TEST_CHECK(0 == memcmp(get_pointer_of(id, hal),
+                                   get_pointer_of(id, backend->table),
+                                   get_size_of(id)));
+        }
+    }
+
+    /* a delta larger than its storage is not encoded */
+    delta.capacity = delta.size - 1;
+    TEST_CHECK(cam_parm_delta_encode(hal, NULL, &delta) < 0);
+    free(storage);
+
+    /* truncated payload, unknown id and oversized entry are rejected */
+    entry.param_id = g_ids[0];
+    entry.length = 4;
+    memcpy(data, &entry, sizeof(entry));
+    memset(data + sizeof(entry), 0, 4);
+    delta.data = data;
+    delta.capacity = sizeof(data);
+    delta.num_entries = 1;
+    delta.size = sizeof(entry) + 2;
+    TEST_CHECK(cam_parm_delta_decode(&delta, backend->table) < 0);
+    delta.size = sizeof(data);
+    entry.param_id = CAM_INTF_PARM_MAX;
+    memcpy(data, &entry, sizeof(entry));
+    TEST_CHECK(cam_parm_delta_decode(&delta, backend->table) < 0);
+    entry.param_id = g_ids[0];
+    entry.length = get_size_of((cam_intf_parm_type_t)g_ids[0]) + 1;
+    memcpy(data, &entry, sizeof(entry));
+    TEST_CHECK(cam_parm_delta_decode(&delta, backend->table) < 0);
+
+    /* and a packet the backend cannot account for is dropped */
+    packet->msg_type = CAM_MAPPING_TYPE_PARM_DELTA;
+    packet->size = 8;
+    packet->num_entries = 0;
+    TEST_CHECK(send(fd, packet, CAM_PARM_DELTA_PACKET_SIZE(4), 0) > 0);
+    TEST_CHECK(testBackendReceive(backend) < 0);
+}
+
+int main(int argc, char **argv)
+{
+    parm_buffer_t *hal_table;
+    cam_parm_dirty_t *dirty;
+    cam_sock_parm_delta_packet_t *packet;
+    test_backend_t *backend;
+    uint32_t requests = TEST_DEFAULT_REQUESTS;
+    uint32_t max_params = TEST_DEFAULT_MAX_PARAMS;
+    uint32_t i, seed = 1, num_delta = 0, num_flat = 0;
+    uint64_t bytes_delta = 0, bytes_payload = 0;
+    int64_t t0, t_delta = 0;
+    int fds[2];
+    int opt;
+
+    while ((opt = getopt(argc, argv, "r:n:s:")) != -1) {
+        switch (opt) {
+        case 'r':
+            requests = (uint32_t)atoi(optarg);
+            break;
+        case 'n':
+            max_params = (uint32_t)atoi(optarg);
+            break;
+        case 's':
+            seed = (uint32_t)atoi(optarg);
+            break;
+        default:
+            printf("usage: %s [-r requests] [-n max params] [-s seed]\n",
+                   argv[0]);
+            return 1;
+        }
+    }
+    if (requests == 0) {
+        requests = 1;
+    }
+    if (max_params == 0) {
+        max_params = 1;
+    }
+    srand(seed);
+
+    for (i = 0; i < CAM_INTF_PARM_MAX; i++) {
+        if (get_size_of((cam_intf_parm_type_t)i) > 0) {
+            g_ids[g_num_ids++] = i;
+        }
+    }
+
+    hal_table = (parm_buffer_t *)malloc(sizeof(parm_buffer_t));
+    dirty = (cam_parm_dirty_t *)malloc(sizeof(cam_parm_dirty_t));
+    packet = (cam_sock_parm_delta_packet_t *)
+        malloc(sizeof(cam_sock_parm_delta_packet_t));
+    backend = (test_backend_t *)malloc(sizeof(test_backend_t));
+    if ((NULL == hal_table) || (NULL == dirty) || (NULL == packet) ||
+        (NULL == backend)) {
+        printf("no memory for parm buffers\n");
+        return 1;
+    }
+    backend->table = (parm_buffer_t *)malloc(sizeof(parm_buffer_t));
+    if (NULL == backend->table) {
+        printf("no memory for backend parm buffer\n");
+        return 1;
+    }
+    if (socketpair(AF_UNIX, SOCK_DGRAM, 0, fds) < 0) {
+        printf("cannot create socket pair\n");
+        return 1;
+    }
+    backend->fd = fds[1];
+    memset(dirty, 0, sizeof(cam_parm_dirty_t));
+    memset(backend->table, 0, sizeof(parm_buffer_t));
+
+    for (i = 0; i < requests; i++) {
+        ssize_t sent, received;
+
+        testFillRequest(hal_table, dirty,
+                        1 + (uint32_t)rand() % max_params);
+        bytes_payload += cam_parm_dirty_size(dirty);
+        if (cam_parm_delta_size(dirty) > CAM_PARM_DELTA_MAX_SIZE) {
+            /* set_parms_delta sends these through the flat buffer */
+            num_flat++;
+            continue;
+        }
+        t0 = testNowNs();
+        sent = testSendDelta(fds[0], hal_table, dirty, packet);
+        received = testBackendReceive(backend);
+        t_delta += testNowNs() - t0;
+        TEST_CHECK(sent > 0);
+        TEST_CHECK(received == sent);
+        TEST_CHECK((size_t)sent ==
+                   CAM_PARM_DELTA_PACKET_SIZE(cam_parm_delta_size(dirty)));
+        if ((sent <= 0) || (received != sent)) {
+            continue;
+        }
+        testCompare(hal_table, backend->table, dirty);
+        bytes_delta += (uint64_t)sent;
+        num_delta++;
+    }
+
+    testFullTable(fds[0], backend, hal_table, packet);
+
+    printf("%u requests of up to %u params, %u param ids with an entry\n",
+           requests, max_params, g_num_ids);
+    printf("delta : %u requests, %8.1f bytes/request, %6.1f ns/request\n",
+           num_delta, num_delta ? (double)bytes_delta / num_delta : 0.0,
+           num_delta ? (double)t_delta / num_delta : 0.0);
+    printf("payload:%8.1f bytes/request set by the HAL\n",
+           (double)bytes_payload / requests);
+    printf("flat  : %zu bytes/request, %u requests over %u delta bytes\n",
+           sizeof(parm_buffer_t), num_flat, CAM_PARM_DELTA_MAX_SIZE);
+    printf("avg   : %8.1f bytes/request with fallback\n",
+           (double)(bytes_delta + (uint64_t)num_flat * sizeof(parm_buffer_t)) /
+           requests);
+
+    close(fds[0]);
+    close(fds[1]);
+    free(backend->table);
+    free(backend);
+    free(packet);
+    free(dirty);
+    free(hal_table);
+    printf("%s: %d failures\n", g_failures ? "FAIL" : "PASS", g_failures);
+    return g_failures ? 1 : 0;
+}
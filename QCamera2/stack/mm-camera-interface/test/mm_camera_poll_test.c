@@ -0,0 +1,369 @@
+/* Copyright (c) 2014, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+/* Poll thread harness.
+ *
+ * Runs the polling threads of mm_camera_thread.c on pipes standing in
+ * for the V4L2 stream fds. Every notify_cb reads exactly one token, the
+ * way mm_stream_data_notify dequeues one buffer per call.
+ *
+ * Correctness: bursts written to all streams are all delivered, none
+ * twice; a synchronously deleted fd gets no callback after del returns
+ * even with tokens still pending; when epoll_wait fails on the current
+ * epoll set the thread rebuilds it, keeps delivering and still exits.
+ *
+ * Latency: one writer thread stamps tokens into the pipes of up to
+ * MAX_STREAM_NUM_IN_BUNDLE streams on several channel poll threads at
+ * 30 fps per stream; prints wakeup to callback latency per load.
+ *
+ * usage: mm-camera-poll-test [-f frames]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <time.h>
+#include "mm_camera_dbg.h"
+#include "mm_camera.h"
+
+#define TEST_MAX_CHANNELS 4
+#define TEST_BURST 16
+#define TEST_DEFAULT_FRAMES 120
+#define TEST_FRAME_US 33333
+#define TEST_MAX_SAMPLES (TEST_MAX_CHANNELS * MAX_STREAM_NUM_IN_BUNDLE * 2048)
+
+volatile uint32_t gMmCameraIntfLogLevel = 0;
+
+static int g_failures = 0;
+
+#define TEST_CHECK(cond) do { \
+    if (!(cond)) { \
+        printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+        g_failures++; \
+    } \
+} while (0)
+
+uint8_t mm_camera_util_get_index_by_handler(uint32_t handler)
+{
+    return (handler&0x000000ff);
+}
+
+typedef struct {
+    int fds[2];
+    uint32_t handler;
+    uint32_t received;   /* tokens read by notify_cb */
+    uint32_t bad;        /* tokens out of order */
+    uint64_t next;       /* expected sequence token, correctness runs */
+    uint8_t stamped;     /* tokens carry a send time, latency runs */
+} test_stream_t;
+
+static int64_t g_lat_ns[TEST_MAX_SAMPLES];
+static uint32_t g_lat_cnt;
+static pthread_mutex_t g_lat_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static int64_t testNowNs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static void testNotify(void *user_data)
+{
+    test_stream_t *s = (test_stream_t *)user_data;
+    uint64_t token;
+
+    if (read(s->fds[0], &token, sizeof(token)) != sizeof(token)) {
+        __sync_fetch_and_add(&s->bad, 1);
+        return;
+    }
+    if (s->stamped) {
+        int64_t lat = testNowNs() - (int64_t)token;
+        pthread_mutex_lock(&g_lat_lock);
+        if (g_lat_cnt < TEST_MAX_SAMPLES) {
+            g_lat_ns[g_lat_cnt++] = lat;
+        }
+        pthread_mutex_unlock(&g_lat_lock);
+    } else if (token != s->next) {
+        __sync_fetch_and_add(&s->bad, 1);
+    }
+    s->next = token + 1;
+    __sync_fetch_and_add(&s->received, 1);
+}
+
+static int testOpen(test_stream_t *s, uint32_t idx, uint8_t stamped)
+{
+    memset(s, 0, sizeof(*s));
+    if (pipe(s->fds) < 0) {
+        return -1;
+    }
+    s->handler = (0x100 * (idx + 1)) | idx;
+    s->stamped = stamped;
+    return 0;
+}
+
+static void testClose(test_stream_t *s)
+{
+    close(s->fds[0]);
+    close(s->fds[1]);
+}
+
+static void testWrite(test_stream_t *s, uint64_t token)
+{
+    if (write(s->fds[1], &token, sizeof(token)) != sizeof(token)) {
+        printf("write to stream pipe failed\n");
+        exit(1);
+    }
+}
+
+static uint32_t testReceived(test_stream_t *s)
+{
+    return __sync_fetch_and_add(&s->received, 0);
+}
+
+/* wait until a stream got cnt tokens, give up after a second */
+static int testWaitFor(test_stream_t *s, uint32_t cnt)
+{
+    int i;
+    for (i = 0; i < 1000 && testReceived(s) < cnt; i++) {
+        usleep(1000);
+    }
+    return testReceived(s) >= cnt;
+}
+
+static void testLaunch(mm_camera_poll_thread_t *poll_cb)
+{
+    memset(poll_cb, 0, sizeof(*poll_cb));
+    strlcpy(poll_cb->threadName, "CAM_pollTest", sizeof(poll_cb->threadName));
+    TEST_CHECK(0 == mm_camera_poll_thread_launch(poll_cb,
+                                                 MM_CAMERA_POLL_TYPE_DATA));
+}
+
+static void testBurst()
+{
+    mm_camera_poll_thread_t poll_cb;
+    test_stream_t streams[MAX_STREAM_NUM_IN_BUNDLE];
+    uint32_t i, n;
+
+    testLaunch(&poll_cb);
+    for (i = 0; i < MAX_STREAM_NUM_IN_BUNDLE; i++) {
+        TEST_CHECK(0 == testOpen(&streams[i], i, FALSE));
+        TEST_CHECK(0 == mm_camera_poll_thread_add_poll_fd(&poll_cb,
+                streams[i].handler, streams[i].fds[0], testNotify,
+                &streams[i], mm_camera_async_call));
+    }
+    for (n = 0; n < TEST_BURST; n++) {
+        for (i = 0; i < MAX_STREAM_NUM_IN_BUNDLE; i++) {
+            testWrite(&streams[i], n);
+        }
+    }
+    for (i = 0; i < MAX_STREAM_NUM_IN_BUNDLE; i++) {
+        TEST_CHECK(testWaitFor(&streams[i], TEST_BURST));
+    }
+    usleep(10000);
+    for (i = 0; i < MAX_STREAM_NUM_IN_BUNDLE; i++) {
+        TEST_CHECK(TEST_BURST == testReceived(&streams[i]));
+        TEST_CHECK(0 == streams[i].bad);
+        TEST_CHECK(0 == mm_camera_poll_thread_del_poll_fd(&poll_cb,
+                streams[i].handler, mm_camera_sync_call));
+    }
+    mm_camera_poll_thread_release(&poll_cb);
+    for (i = 0; i < MAX_STREAM_NUM_IN_BUNDLE; i++) {
+        testClose(&streams[i]);
+    }
+}
+
+static void testDelete()
+{
+    mm_camera_poll_thread_t poll_cb;
+    test_stream_t s;
+    uint32_t got;
+
+    testLaunch(&poll_cb);
+    TEST_CHECK(0 == testOpen(&s, 1, FALSE));
+    TEST_CHECK(0 == mm_camera_poll_thread_add_poll_fd(&poll_cb, s.handler,
+            s.fds[0], testNotify, &s, mm_camera_async_call));
+    testWrite(&s, 0);
+    TEST_CHECK(testWaitFor(&s, 1));
+
+    /* tokens still queued when the fd goes away must not be served */
+    testWrite(&s, 1);
+    testWrite(&s, 2);
+    TEST_CHECK(0 == mm_camera_poll_thread_del_poll_fd(&poll_cb, s.handler,
+                                                      mm_camera_sync_call));
+    got = testReceived(&s);
+    usleep(20000);
+    TEST_CHECK(got == testReceived(&s));
+    TEST_CHECK(0 == s.bad);
+
+    mm_camera_poll_thread_release(&poll_cb);
+    testClose(&s);
+}
+
+static void testEpollFailure()
+{
+    mm_camera_poll_thread_t poll_cb;
+    test_stream_t s, s2;
+    int null_fd;
+
+    testLaunch(&poll_cb);
+    TEST_CHECK(0 == testOpen(&s, 2, FALSE));
+    TEST_CHECK(0 == mm_camera_poll_thread_add_poll_fd(&poll_cb, s.handler,
+            s.fds[0], testNotify, &s, mm_camera_async_call));
+    testWrite(&s, 0);
+    TEST_CHECK(testWaitFor(&s, 1));
+
+    /* swap the epoll fd for a plain file behind the thread's back, the
+     * next epoll_wait fails with EINVAL and the set has to be rebuilt */
+    null_fd = open("/dev/null", O_RDONLY);
+    TEST_CHECK(null_fd >= 0);
+    TEST_CHECK(dup2(null_fd, poll_cb.epoll_fd) == poll_cb.epoll_fd);
+    close(null_fd);
+
+    testWrite(&s, 1);
+    testWrite(&s, 2);
+    TEST_CHECK(testWaitFor(&s, 3));
+    testWrite(&s, 3);
+    TEST_CHECK(testWaitFor(&s, 4));
+    TEST_CHECK(0 == s.bad);
+
+    /* fds added after the rebuild go to the new set */
+    TEST_CHECK(0 == testOpen(&s2, 3, FALSE));
+    TEST_CHECK(0 == mm_camera_poll_thread_add_poll_fd(&poll_cb, s2.handler,
+            s2.fds[0], testNotify, &s2, mm_camera_async_call));
+    testWrite(&s2, 0);
+    TEST_CHECK(testWaitFor(&s2, 1));
+
+    mm_camera_poll_thread_del_poll_fd(&poll_cb, s.handler, mm_camera_sync_call);
+    mm_camera_poll_thread_del_poll_fd(&poll_cb, s2.handler, mm_camera_sync_call);
+    mm_camera_poll_thread_release(&poll_cb);
+    testClose(&s);
+    testClose(&s2);
+}
+
+static int testCmpNs(const void *a, const void *b)
+{
+    int64_t x = *(const int64_t *)a, y = *(const int64_t *)b;
+    return (x > y) - (x < y);
+}
+
+static void testLatency(uint32_t channels, uint32_t frames)
+{
+    mm_camera_poll_thread_t poll_cb[TEST_MAX_CHANNELS];
+    test_stream_t streams[TEST_MAX_CHANNELS][MAX_STREAM_NUM_IN_BUNDLE];
+    uint32_t c, i, f, total;
+    int64_t sum = 0;
+
+    g_lat_cnt = 0;
+    for (c = 0; c < channels; c++) {
+        testLaunch(&poll_cb[c]);
+        for (i = 0; i < MAX_STREAM_NUM_IN_BUNDLE; i++) {
+            TEST_CHECK(0 == testOpen(&streams[c][i], i, TRUE));
+            TEST_CHECK(0 == mm_camera_poll_thread_add_poll_fd(&poll_cb[c],
+                    streams[c][i].handler, streams[c][i].fds[0], testNotify,
+                    &streams[c][i], mm_camera_async_call));
+        }
+    }
+
+    for (f = 0; f < frames; f++) {
+        for (c = 0; c < channels; c++) {
+            for (i = 0; i < MAX_STREAM_NUM_IN_BUNDLE; i++) {
+                testWrite(&streams[c][i], (uint64_t)testNowNs());
+            }
+        }
+        usleep(TEST_FRAME_US);
+    }
+
+    total = 0;
+    for (c = 0; c < channels; c++) {
+        for (i = 0; i < MAX_STREAM_NUM_IN_BUNDLE; i++) {
+            TEST_CHECK(testWaitFor(&streams[c][i], frames));
+            TEST_CHECK(0 == streams[c][i].bad);
+            total += testReceived(&streams[c][i]);
+            mm_camera_poll_thread_del_poll_fd(&poll_cb[c],
+                    streams[c][i].handler, mm_camera_sync_call);
+        }
+        mm_camera_poll_thread_release(&poll_cb[c]);
+        for (i = 0; i < MAX_STREAM_NUM_IN_BUNDLE; i++) {
+            testClose(&streams[c][i]);
+        }
+    }
+    TEST_CHECK(total == channels * MAX_STREAM_NUM_IN_BUNDLE * frames);
+
+    if (g_lat_cnt == 0) {
+        return;
+    }
+    qsort(g_lat_ns, g_lat_cnt, sizeof(g_lat_ns[0]), testCmpNs);
+    for (i = 0; i < g_lat_cnt; i++) {
+        sum += g_lat_ns[i];
+    }
+    printf("%u channels x %d streams: %5u callbacks, latency avg %6.1f us,"
+           " p50 %6.1f us, p99 %6.1f us, max %7.1f us\n",
+           channels, MAX_STREAM_NUM_IN_BUNDLE, g_lat_cnt,
+           (double)sum / g_lat_cnt / 1000.0,
+           (double)g_lat_ns[g_lat_cnt / 2] / 1000.0,
+           (double)g_lat_ns[(g_lat_cnt * 99) / 100] / 1000.0,
+           (double)g_lat_ns[g_lat_cnt - 1] / 1000.0);
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t frames = TEST_DEFAULT_FRAMES;
+    uint32_t c;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "f:")) != -1) {
+        switch (opt) {
+        case 'f':
+            frames = (uint32_t)atoi(optarg);
+            break;
+        default:
+            printf("usage: %s [-f frames]\n", argv[0]);
+            return 1;
+        }
+    }
+    if ((frames == 0) || (frames > 2048)) {
+        printf("frames must be 1..2048\n");
+        return 1;
+    }
+
+    testBurst();
+    testDelete();
+    testEpollFailure();
+    for (c = 1; c <= TEST_MAX_CHANNELS; c *= 2) {
+        testLatency(c, frames);
+    }
+
+    printf("%s: %d failures\n", g_failures ? "FAIL" : "PASS", g_failures);
+    return g_failures ? 1 : 0;
+}
@@ -0,0 +1,393 @@
+/* Copyright (c) 2014, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+/* Superbuf matcher microbenchmark.
+ *
+ * Feeds stream buffers straight into mm_channel_superbuf_comp_and_enqueue
+ * of mm_camera_channel.c. The stream layer below is stubbed: a buffer
+ * returned to the kernel just bumps a counter, the cmd/poll threads are
+ * never started.
+ *
+ * Correctness: for in order, lagging, dropping, reordering and evicting
+ * arrival patterns every buffer fed must come back exactly once, either
+ * in a matched superbuf whose buffers all carry the same frame_idx, or
+ * through qbuf. Matched superbufs must come out in frame_idx order.
+ *
+ * Throughput: ns per stream buffer with a bundle of three streams, for a
+ * growing number of unmatched superbufs (one stream lags behind the
+ * others) and matched superbufs held back like a ZSL look-back queue.
+ * The "scan" column is the cost of walking the queue once per buffer,
+ * which is what the matcher did before the frame_idx index.
+ *
+ * usage: mm-camera-superbuf-bench [-f frames]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <time.h>
+#include "mm_camera_dbg.h"
+#include "mm_camera.h"
+
+#define BENCH_STREAMS 3
+#define BENCH_DEFAULT_FRAMES 20000
+#define BENCH_MAX_LAG 64
+
+volatile uint32_t gMmCameraIntfLogLevel = 0;
+
+extern int32_t mm_channel_superbuf_queue_init(mm_channel_queue_t *queue);
+extern int32_t mm_channel_superbuf_queue_deinit(mm_channel_queue_t *queue);
+extern int32_t mm_channel_superbuf_comp_and_enqueue(mm_channel_t *ch_obj,
+        mm_channel_queue_t *queue, mm_camera_buf_info_t *buf_info);
+extern mm_channel_queue_node_t *mm_channel_superbuf_dequeue(
+        mm_channel_queue_t *queue);
+extern mm_channel_queue_node_t *mm_channel_superbuf_dequeue_internal(
+        mm_channel_queue_t *queue, uint8_t matched_only);
+
+static uint32_t g_qbuf_cnt;
+
+/* stream layer stubs, only QBUF is reached by the matcher */
+int32_t mm_stream_fsm_fn(mm_stream_t *my_obj, mm_stream_evt_type_t evt,
+                         void *in_val, void *out_val)
+{
+    (void)my_obj; (void)in_val; (void)out_val;
+    if (MM_STREAM_EVT_QBUF == evt) {
+        g_qbuf_cnt++;
+        return 0;
+    }
+    return -1;
+}
+
+/* never reached by the matcher, linked for the rest of mm_camera_channel.c */
+int32_t mm_stream_map_buf(mm_stream_t *my_obj, uint8_t buf_type,
+        uint32_t frame_idx, int32_t plane_idx, int fd, size_t size)
+{ (void)my_obj; (void)buf_type; (void)frame_idx; (void)plane_idx;
+  (void)fd; (void)size; return -1; }
+int32_t mm_stream_unmap_buf(mm_stream_t *my_obj, uint8_t buf_type,
+        uint32_t frame_idx, int32_t plane_idx)
+{ (void)my_obj; (void)buf_type; (void)frame_idx; (void)plane_idx; return -1; }
+int32_t mm_camera_util_bundled_sendmsg(mm_camera_obj_t *my_obj, void *msg,
+        size_t buf_size, int sendfds[CAM_MAX_NUM_BUFS_PER_MAP], int numfds)
+{ (void)my_obj; (void)msg; (void)buf_size; (void)sendfds; (void)numfds;
+  return -1; }
+int32_t mm_camera_start_zsl_snapshot(mm_camera_obj_t *my_obj)
+{ (void)my_obj; return -1; }
+int32_t mm_camera_stop_zsl_snapshot(mm_camera_obj_t *my_obj)
+{ (void)my_obj; return -1; }
+uint32_t mm_camera_util_generate_handler(uint8_t index)
+{ return index; }
+int32_t mm_camera_poll_thread_launch(mm_camera_poll_thread_t *poll_cb,
+        mm_camera_poll_thread_type_t poll_type)
+{ (void)poll_cb; (void)poll_type; return -1; }
+int32_t mm_camera_poll_thread_release(mm_camera_poll_thread_t *poll_cb)
+{ (void)poll_cb; return -1; }
+int32_t mm_camera_cmd_thread_launch(mm_camera_cmd_thread_t *cmd_thread,
+        mm_camera_cmd_cb_t cb, void *user_data)
+{ (void)cmd_thread; (void)cb; (void)user_data; return -1; }
+int32_t mm_camera_cmd_thread_name(const char *name)
+{ (void)name; return -1; }
+int32_t mm_camera_cmd_thread_release(mm_camera_cmd_thread_t *cmd_thread)
+{ (void)cmd_thread; return -1; }
+
+/** bench_ctx_t
+*  @ch: channel holding the bundle and the streams
+*  @stream_info: stream info of the bundled streams
+*  @bufs: stream buffers, one per stream and frame slot
+*  @fed: buffers handed to the matcher
+*  @delivered: buffers dequeued in matched superbufs
+*  @last_frame: frame_idx of the last matched superbuf
+*  @errors: inconsistent superbufs seen
+**/
+typedef struct {
+    mm_channel_t ch;
+    cam_stream_info_t stream_info[BENCH_STREAMS];
+    mm_camera_buf_def_t bufs[BENCH_STREAMS][BENCH_MAX_LAG * 2];
+    uint32_t fed;
+    uint32_t delivered;
+    uint32_t last_frame;
+    uint32_t errors;
+} bench_ctx_t;
+
+static int64_t bench_now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static void bench_init(bench_ctx_t *ctx, uint8_t max_unmatched)
+{
+    mm_channel_queue_t *queue = &ctx->ch.bundle.superbuf_queue;
+    int i;
+
+    memset(ctx, 0, sizeof(*ctx));
+    for (i = 0; i < BENCH_STREAMS; i++) {
+        ctx->stream_info[i].stream_type = CAM_STREAM_TYPE_PREVIEW;
+        ctx->ch.streams[i].state = MM_STREAM_STATE_ACTIVE;
+        ctx->ch.streams[i].my_hdl = 0x100 + (uint32_t)i;
+        ctx->ch.streams[i].stream_info = &ctx->stream_info[i];
+        queue->bundled_streams[i] = 0x100 + (uint32_t)i;
+    }
+    queue->num_streams = BENCH_STREAMS;
+    queue->attr.notify_mode = MM_CAMERA_SUPER_BUF_NOTIFY_BURST;
+    queue->attr.max_unmatched_frames = max_unmatched;
+    queue->attr.priority = MM_CAMERA_SUPER_BUF_PRIORITY_NORMAL;
+    mm_channel_superbuf_queue_init(queue);
+    g_qbuf_cnt = 0;
+}
+
+static void bench_feed(bench_ctx_t *ctx, int stream, uint32_t frame_idx)
+{
+    mm_camera_buf_info_t buf_info;
+    mm_camera_buf_def_t *buf =
+        &ctx->bufs[stream][frame_idx % (BENCH_MAX_LAG * 2)];
+
+    buf->stream_id = 0x100 + (uint32_t)stream;
+    buf->frame_idx = frame_idx;
+    memset(&buf_info, 0, sizeof(buf_info));
+    buf_info.stream_id = buf->stream_id;
+    buf_info.frame_idx = frame_idx;
+    buf_info.buf = buf;
+    ctx->fed++;
+    mm_channel_superbuf_comp_and_enqueue(&ctx->ch,
+        &ctx->ch.bundle.superbuf_queue, &buf_info);
+}
+
+static void bench_check_super_buf(bench_ctx_t *ctx,
+                                  mm_channel_queue_node_t *super_buf)
+{
+    uint8_t i;
+
+    for (i = 0; i < super_buf->num_of_bufs; i++) {
+        if ((super_buf->super_buf[i].frame_idx != super_buf->frame_idx) ||
+            (super_buf->super_buf[i].buf->frame_idx != super_buf->frame_idx)) {
+            ctx->errors++;
+        }
+    }
+    if (super_buf->frame_idx <= ctx->last_frame) {
+        ctx->errors++;
+    }
+    ctx->last_frame = super_buf->frame_idx;
+    ctx->delivered += super_buf->num_of_bufs;
+    free(super_buf);
+}
+
+/* dequeue matched superbufs, keeping hold_back of them in the queue */
+static void bench_consume(bench_ctx_t *ctx, uint32_t hold_back)
+{
+    mm_channel_queue_t *queue = &ctx->ch.bundle.superbuf_queue;
+    mm_channel_queue_node_t *super_buf;
+
+    while (queue->match_cnt > hold_back) {
+        super_buf = mm_channel_superbuf_dequeue(queue);
+        if (NULL == super_buf) {
+            break;
+        }
+        bench_check_super_buf(ctx, super_buf);
+    }
+}
+
+/* empty the queue and check every buffer fed came back exactly once */
+static int bench_finish(bench_ctx_t *ctx, const char *name)
+{
+    mm_channel_queue_t *queue = &ctx->ch.bundle.superbuf_queue;
+    mm_channel_queue_node_t *super_buf;
+    uint32_t unmatched = 0;
+    uint8_t i;
+
+    bench_consume(ctx, 0);
+    while (NULL != (super_buf =
+            mm_channel_superbuf_dequeue_internal(queue, FALSE))) {
+        for (i = 0; i < super_buf->num_of_bufs; i++) {
+            if (super_buf->super_buf[i].frame_idx != 0) {
+                unmatched++;
+            }
+        }
+        free(super_buf);
+    }
+    mm_channel_superbuf_queue_deinit(queue);
+
+    if ((ctx->errors != 0) || (queue->unmatched_cnt != 0) ||
+        (ctx->delivered + g_qbuf_cnt + unmatched != ctx->fed)) {
+        printf("FAILED %-12s fed %u delivered %u qbuf %u left %u errors %u\n",
+               name, ctx->fed, ctx->delivered, g_qbuf_cnt, unmatched,
+               ctx->errors);
+        return 1;
+    }
+    return 0;
+}
+
+/* stream s delivers frame f at step f + lag[s], frames in drop are lost */
+static int bench_pattern(const char *name, uint32_t frames,
+                         const uint32_t lag[BENCH_STREAMS],
+                         uint32_t drop_every, uint32_t swap_stream,
+                         uint8_t max_unmatched, uint32_t hold_back,
+                         int64_t *ns_per_buf)
+{
+    static bench_ctx_t ctx;
+    uint32_t max_lag = 0, step, f;
+    int s;
+    int64_t t;
+
+    bench_init(&ctx, max_unmatched);
+    for (s = 0; s < BENCH_STREAMS; s++) {
+        if (lag[s] > max_lag) {
+            max_lag = lag[s];
+        }
+    }
+
+    t = bench_now_ns();
+    for (step = 1; step <= frames + max_lag; step++) {
+        for (s = 0; s < BENCH_STREAMS; s++) {
+            if ((step <= lag[s]) || (step - lag[s] > frames)) {
+                continue;
+            }
+            f = step - lag[s];
+            /* swap_stream delivers frame pairs in reverse order */
+            if ((uint32_t)s == swap_stream) {
+                f = (f & 1) ? f + 1 : f - 1;
+                if (f > frames) {
+                    f = frames;
+                }
+            }
+            if ((drop_every != 0) && (s == 1) && (f % drop_every == 0)) {
+                continue;
+            }
+            bench_feed(&ctx, s, f);
+        }
+        bench_consume(&ctx, hold_back);
+    }
+    t = bench_now_ns() - t;
+    if (NULL != ns_per_buf) {
+        *ns_per_buf = t / (int64_t)ctx.fed;
+    }
+    return bench_finish(&ctx, name);
+}
+
+/* walk the whole queue once, as the matcher did before the index */
+static int64_t bench_scan_cost(uint32_t frames, uint32_t unmatched,
+                               uint32_t matched)
+{
+    static bench_ctx_t ctx;
+    mm_channel_queue_t *queue = &ctx.ch.bundle.superbuf_queue;
+    const uint32_t lag[BENCH_STREAMS] = { 0, 0, unmatched };
+    volatile uint32_t sink = 0;
+    mm_channel_queue_node_t *super_buf;
+    struct cam_list *pos;
+    uint32_t step;
+    int s;
+    int64_t t;
+
+    /* build the queue state once, then time the walks alone */
+    bench_init(&ctx, (uint8_t)(unmatched + 2));
+    for (step = 1; step <= matched + unmatched + 1; step++) {
+        for (s = 0; s < BENCH_STREAMS; s++) {
+            if (step > lag[s]) {
+                bench_feed(&ctx, s, step - lag[s]);
+            }
+        }
+    }
+    t = bench_now_ns();
+    for (step = 0; step < frames * BENCH_STREAMS; step++) {
+        for (pos = queue->que.head.list.next; pos != &queue->que.head.list;
+                pos = pos->next) {
+            mm_channel_queue_node_t *node = (mm_channel_queue_node_t *)
+                member_of(pos, cam_node_t, list)->data;
+            sink += node->frame_idx;
+        }
+    }
+    t = bench_now_ns() - t;
+    (void)sink;
+    while (NULL != (super_buf =
+            mm_channel_superbuf_dequeue_internal(queue, FALSE))) {
+        free(super_buf);
+    }
+    mm_channel_superbuf_queue_deinit(queue);
+    return t / (int64_t)(frames * BENCH_STREAMS);
+}
+
+int main(int argc, char **argv)
+{
+    static const uint32_t lags[] = { 0, 2, 8, 16, 32 };
+    static const uint32_t holds[] = { 0, 8, 32 };
+    const uint32_t in_order[BENCH_STREAMS] = { 0, 0, 0 };
+    const uint32_t lagging[BENCH_STREAMS] = { 0, 3, 7 };
+    uint32_t frames = BENCH_DEFAULT_FRAMES;
+    uint32_t lag[BENCH_STREAMS];
+    int64_t ns;
+    size_t i, j;
+    int opt, rc = 0;
+
+    while ((opt = getopt(argc, argv, "f:")) != -1) {
+        switch (opt) {
+        case 'f':
+            frames = (uint32_t)atoi(optarg);
+            break;
+        default:
+            printf("usage: %s [-f frames]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (frames < 100) {
+        printf("frames must be at least 100\n");
+        return 1;
+    }
+
+    rc |= bench_pattern("in order", 1000, in_order, 0, BENCH_STREAMS, 8, 0, NULL);
+    rc |= bench_pattern("lagging", 1000, lagging, 0, BENCH_STREAMS, 8, 0, NULL);
+    rc |= bench_pattern("dropping", 1000, lagging, 5, BENCH_STREAMS, 8, 4, NULL);
+    rc |= bench_pattern("reordered", 1000, lagging, 0, 2, 8, 0, NULL);
+    rc |= bench_pattern("evicting", 1000, lagging, 0, BENCH_STREAMS, 2, 0, NULL);
+    if (rc != 0) {
+        return 1;
+    }
+
+    printf("%u frames, %d streams, ns per stream buffer\n",
+           frames, BENCH_STREAMS);
+    printf("  unmatched  matched   enqueue     scan\n");
+    for (i = 0; i < sizeof(lags) / sizeof(lags[0]); i++) {
+        for (j = 0; j < sizeof(holds) / sizeof(holds[0]); j++) {
+            lag[0] = 0;
+            lag[1] = 0;
+            lag[2] = lags[i];
+            if (bench_pattern("bench", frames, lag, 0, BENCH_STREAMS,
+                    (uint8_t)(lags[i] + 2), holds[j], &ns) != 0) {
+                return 1;
+            }
+            printf("  %9u  %7u  %8lld  %7lld\n", lags[i], holds[j],
+                   (long long)ns,
+                   (long long)bench_scan_cost(frames, lags[i], holds[j]));
+        }
+    }
+    printf("PASS\n");
+    return 0;
+}
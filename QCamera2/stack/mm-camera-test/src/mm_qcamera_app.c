@@ -36,6 +36,7 @@
 
 #include "mm_qcamera_dbg.h"
 #include "mm_qcamera_app.h"
+#include "mm_camera_dump.h"
 
 static pthread_mutex_t app_mutex;
 static int thread_status = 0;
@@ -239,26 +240,28 @@ void mm_app_dump_frame(mm_camera_buf_def_t *frame,
                        uint32_t frame_idx)
 {
     char file_name[64];
-    int file_fd;
+    mm_camera_dump_plane_t planes[MM_CAMERA_DUMP_MAX_PLANES];
+    uint32_t num_planes = 0;
     int i;
     int offset = 0;
     if ( frame != NULL) {
         snprintf(file_name, sizeof(file_name), "/data/test/%s_%04d.%s", name, frame_idx, ext);
-        file_fd = open(file_name, O_RDWR | O_CREAT, 0777);
-        if (file_fd < 0) {
-            CDBG_ERROR("%s: cannot open file %s \n", __func__, file_name);
-        } else {
-            for (i = 0; i < frame->num_planes; i++) {
-                CDBG("%s: saving file from address: %p, data offset: %d, "
-                     "length: %d \n", __func__, frame->buffer,
-                    frame->planes[i].data_offset, frame->planes[i].length);
-                write(file_fd,
-                      (uint8_t *)frame->buffer + offset,
-                      frame->planes[i].length);
-                offset += (int)frame->planes[i].length;
-            }
+        for (i = 0; i < frame->num_planes &&
+                num_planes < MM_CAMERA_DUMP_MAX_PLANES; i++) {
+            CDBG("%s: saving file from address: %p, data offset: %d, "
+                 "length: %d \n", __func__, frame->buffer,
+                frame->planes[i].data_offset, frame->planes[i].length);
+            planes[num_planes].base = (uint8_t *)frame->buffer + offset;
+            planes[num_planes].width = frame->planes[i].length;
+            planes[num_planes].stride = frame->planes[i].length;
+            planes[num_planes].height = 1;
+            num_planes++;
+            offset += (int)frame->planes[i].length;
+        }
 
-            close(file_fd);
+        if (mm_camera_dump_frame(file_name, planes, num_planes) != 0) {
+            CDBG_ERROR("%s: cannot queue file %s \n", __func__, file_name);
+        } else {
             CDBG("dump %s", file_name);
         }
     }
@@ -684,6 +687,9 @@ int mm_app_close(mm_camera_test_obj_t *test_obj)
         return -MM_CAMERA_E_GENERAL;
     }
 
+    /* finish pending frame dumps */
+    mm_camera_dump_flush();
+
     /* unmap capability buf */
     rc = test_obj->cam->ops->unmap_buf(test_obj->cam->camera_handle,
                                        CAM_MAPPING_BUF_TYPE_CAPABILITY);
@@ -33,12 +33,14 @@
 #include <cam_semaphore.h>
 #include "mm_jpeg_interface.h"
 #include "cam_list.h"
+#include "cam_exif_arena.h"
 #include "OMX_Types.h"
 #include "OMX_Index.h"
 #include "OMX_Core.h"
 #include "OMX_Component.h"
 #include "QOMX_JpegExtensions.h"
 #include "mm_jpeg_ionbuf.h"
+#include "mm_jpeg_sched.h"
 
 #define MM_JPEG_MAX_THREADS 30
 #define MM_JPEG_CIRQ_SIZE 30
@@ -300,6 +302,7 @@ typedef struct mm_jpeg_job_session {
 
   QEXIF_INFO_DATA exif_info_local[MAX_EXIF_TABLE_ENTRIES];  //all exif tags for JPEG encoder
   int exif_count_local;
+  cam_exif_arena_t exif_arena; //payloads of exif_info_local
 
   mm_jpeg_cirq_t cb_q;
   int32_t ebd_count;
@@ -316,6 +319,13 @@ typedef struct mm_jpeg_job_session {
 
   OMX_BOOL encoding;
 
+  /* number of job manager threads starting a job on this session */
+  uint32_t dispatching;
+
+  /* the omx handle is kept loaded in the warm pool */
+  OMX_BOOL parked;
+  uint32_t pool_seq;             /* warm pool LRU stamp */
+
   buffer_t work_buffer;
 
   OMX_EVENTTYPE omxEvent;
@@ -363,11 +373,37 @@ typedef struct {
 } mm_jpeg_client_t;
 
 typedef struct {
-  pthread_t pid;                  /* job cmd thread ID */
+  pthread_t pid[MM_JPEG_MAX_JOB_THREADS]; /* job cmd thread IDs */
+  uint32_t num_threads;           /* number of job cmd threads */
   cam_semaphore_t job_sem;        /* semaphore for job cmd thread */
   mm_jpeg_queue_t job_queue;      /* queue for job to do */
+  mm_jpeg_sched_t sched;          /* session round robin state */
+  pthread_cond_t dispatch_cond;   /* signalled when a job start completes */
 } mm_jpeg_job_cmd_thread_t;
 
+/** mm_jpeg_pool_t:
+ *  @enabled: park destroyed encode sessions instead of freeing them
+ *  @seq: LRU stamp of the most recently parked session
+ *  @num_parked: number of parked omx handles
+ *  @hits: sessions created from a parked handle
+ *  @misses: sessions created from scratch
+ *  @evictions: parked sessions freed to make room
+ *  @cold_us: total time spent creating sessions from scratch
+ *  @warm_us: total time spent reusing parked sessions
+ *
+ *  Warm pool of configured encode sessions
+ **/
+typedef struct {
+  int enabled;
+  uint32_t seq;
+  uint32_t num_parked;
+  uint32_t hits;
+  uint32_t misses;
+  uint32_t evictions;
+  uint64_t cold_us;
+  uint64_t warm_us;
+} mm_jpeg_pool_t;
+
 #define MAX_JPEG_CLIENT_NUM 8
 typedef struct mm_jpeg_obj_t {
   /* ClientMgr */
@@ -392,6 +428,7 @@ typedef struct mm_jpeg_obj_t {
 
   uint32_t num_sessions;
 
+  mm_jpeg_pool_t pool;                            /* warm session pool */
 } mm_jpeg_obj;
 
 /** mm_jpeg_pending_func_t:
@@ -455,12 +492,12 @@ extern int32_t mm_jpeg_queue_deinit(mm_jpeg_queue_t* queue);
 extern int32_t mm_jpeg_queue_flush(mm_jpeg_queue_t* queue);
 extern uint32_t mm_jpeg_queue_get_size(mm_jpeg_queue_t* queue);
 extern mm_jpeg_q_data_t mm_jpeg_queue_peek(mm_jpeg_queue_t* queue);
-extern int32_t addExifEntry(QOMX_EXIF_INFO *p_exif_info, exif_tag_id_t tagid,
-  exif_tag_type_t type, uint32_t count, void *data);
-extern int32_t releaseExifEntry(QEXIF_INFO_DATA *p_exif_data);
+extern int32_t addExifEntry(QOMX_EXIF_INFO *p_exif_info,
+  cam_exif_arena_t *exif_arena, exif_tag_id_t tagid, exif_tag_type_t type,
+  uint32_t count, void *data);
 extern int process_meta_data(metadata_buffer_t *p_meta,
-  QOMX_EXIF_INFO *exif_info, mm_jpeg_exif_params_t *p_cam3a_params,
-  cam_hal_version_t hal_version);
+  QOMX_EXIF_INFO *exif_info, cam_exif_arena_t *exif_arena,
+  mm_jpeg_exif_params_t *p_cam3a_params, cam_hal_version_t hal_version);
 
 OMX_ERRORTYPE mm_jpeg_session_change_state(mm_jpeg_job_session_t* p_session,
   OMX_STATETYPE new_state,
@@ -85,7 +85,8 @@ static inline int mm_jpeg_get_new_session_idx(mm_jpeg_obj *my_obj, int client_id
   int index = -1;
   for (i = 0; i < MM_JPEG_MAX_SESSION; i++) {
     pthread_mutex_lock(&my_obj->clnt_mgr[client_idx].lock);
-    if (!my_obj->clnt_mgr[client_idx].session[i].active) {
+    if (!my_obj->clnt_mgr[client_idx].session[i].active &&
+      !my_obj->clnt_mgr[client_idx].session[i].parked) {
       *pp_session = &my_obj->clnt_mgr[client_idx].session[i];
       my_obj->clnt_mgr[client_idx].session[i].active = OMX_TRUE;
       index = i;
@@ -0,0 +1,89 @@
+/* Copyright (c) 2014, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef MM_JPEG_SCHED_H_
+#define MM_JPEG_SCHED_H_
+
+#include <stdint.h>
+
+/* max number of job manager worker threads */
+#define MM_JPEG_MAX_JOB_THREADS 4
+
+/* jobs up to this size (thumbnail/preview sized) are scheduled first */
+#define MM_JPEG_SCHED_PRIO_PIXELS (1920 * 1080)
+
+/* max consecutive priority picks that bypass the round robin order */
+#define MM_JPEG_SCHED_MAX_PRIO_SKIPS 4
+
+/** mm_jpeg_sched_slot_t:
+ *  @MM_JPEG_SCHED_SLOT_IDLE: no job can be dispatched from the slot
+ *  @MM_JPEG_SCHED_SLOT_READY: the head job of the slot can be dispatched
+ *  @MM_JPEG_SCHED_SLOT_PRIO: the head job is ready and small
+ *
+ *  State of one session slot as seen by the scheduler
+ **/
+typedef enum {
+  MM_JPEG_SCHED_SLOT_IDLE,
+  MM_JPEG_SCHED_SLOT_READY,
+  MM_JPEG_SCHED_SLOT_PRIO,
+} mm_jpeg_sched_slot_t;
+
+/** mm_jpeg_sched_t:
+ *  @last_slot: slot served by the previous pick
+ *  @prio_skips: consecutive picks that bypassed the round robin
+ *             order in favour of a small job
+ *
+ *  Round robin scheduler state
+ **/
+typedef struct {
+  uint32_t last_slot;
+  uint32_t prio_skips;
+} mm_jpeg_sched_t;
+
+extern void mm_jpeg_sched_init(mm_jpeg_sched_t *p_sched);
+extern int32_t mm_jpeg_sched_pick(mm_jpeg_sched_t *p_sched,
+  const uint8_t *p_slots, uint32_t num_slots);
+
+/** mm_jpeg_sched_is_prio:
+ *
+ *  Arguments:
+ *    @width: output width of the job
+ *    @height: output height of the job
+ *
+ *  Return:
+ *       1 if the job is scheduled with priority
+ *
+ **/
+static inline int mm_jpeg_sched_is_prio(int32_t width, int32_t height)
+{
+  return ((width > 0) && (height > 0) &&
+    ((int64_t)width * height <= MM_JPEG_SCHED_PRIO_PIXELS));
+}
+
+#endif /* MM_JPEG_SCHED_H_ */
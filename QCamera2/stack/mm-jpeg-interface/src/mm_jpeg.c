@@ -35,6 +35,8 @@
 #include <sys/prctl.h>
 #include <fcntl.h>
 #include <poll.h>
+#include <time.h>
+#include <cutils/properties.h>
 
 #include "mm_jpeg_dbg.h"
 #include "mm_jpeg_interface.h"
@@ -258,25 +260,21 @@ OMX_ERRORTYPE mm_jpeg_session_change_state(mm_jpeg_job_session_t* p_session,
   return ret;
 }
 
-/** mm_jpeg_session_create:
+/** mm_jpeg_session_reset:
  *
  *  Arguments:
  *    @p_session: job session
  *
  *  Return:
- *       OMX error types
+ *       none
  *
  *  Description:
- *       Create a jpeg encode session
+ *       Reset the per session job state before the session is
+ *       (re)configured
  *
  **/
-OMX_ERRORTYPE mm_jpeg_session_create(mm_jpeg_job_session_t* p_session)
+static void mm_jpeg_session_reset(mm_jpeg_job_session_t* p_session)
 {
-  OMX_ERRORTYPE rc = OMX_ErrorNone;
-  mm_jpeg_obj *my_obj = (mm_jpeg_obj *) p_session->jpeg_obj;
-
-  pthread_mutex_init(&p_session->lock, NULL);
-  pthread_cond_init(&p_session->cond, NULL);
   cirq_reset(&p_session->cb_q);
   p_session->state_change_pending = OMX_FALSE;
   p_session->abort_state = MM_JPEG_ABORT_NONE;
@@ -286,17 +284,53 @@ OMX_ERRORTYPE mm_jpeg_session_create(mm_jpeg_job_session_t* p_session)
   p_session->encode_pid = -1;
   p_session->config = OMX_FALSE;
   p_session->exif_count_local = 0;
+  cam_exif_arena_reset(&p_session->exif_arena);
   p_session->auto_out_buf = OMX_FALSE;
+  p_session->encoding = OMX_FALSE;
+}
+
+/** mm_jpeg_session_create:
+ *
+ *  Arguments:
+ *    @p_session: job session
+ *
+ *  Return:
+ *       OMX error types
+ *
+ *  Description:
+ *       Create a jpeg encode session
+ *
+ **/
+OMX_ERRORTYPE mm_jpeg_session_create(mm_jpeg_job_session_t* p_session)
+{
+  OMX_ERRORTYPE rc = OMX_ErrorNone;
+  mm_jpeg_obj *my_obj = (mm_jpeg_obj *) p_session->jpeg_obj;
+  char prop[PROPERTY_VALUE_MAX];
+
+  pthread_mutex_init(&p_session->lock, NULL);
+  pthread_cond_init(&p_session->cond, NULL);
+  mm_jpeg_session_reset(p_session);
 
   p_session->omx_callbacks.EmptyBufferDone = mm_jpeg_ebd;
   p_session->omx_callbacks.FillBufferDone = mm_jpeg_fbd;
   p_session->omx_callbacks.EventHandler = mm_jpeg_event_handler;
 
 
-  rc = OMX_GetHandle(&p_session->omx_handle,
-      "OMX.qcom.image.jpeg.encoder",
-      (void *)p_session,
-      &p_session->omx_callbacks);
+  property_get("persist.camera.jpeg.sw", prop, "0");
+  if (!atoi(prop)) {
+    rc = OMX_GetHandle(&p_session->omx_handle,
+        "OMX.qcom.image.jpeg.encoder",
+        (void *)p_session,
+        &p_session->omx_callbacks);
+  }
+  if (atoi(prop) || (OMX_ErrorNone != rc)) {
+    /* hardware encoder unavailable or disabled, use the software one */
+    CDBG_HIGH("%s:%d] using software encoder (%d)", __func__, __LINE__, rc);
+    rc = OMX_GetHandle(&p_session->omx_handle,
+        "OMX.qcom.image.jpeg.encoder_sw",
+        (void *)p_session,
+        &p_session->omx_callbacks);
+  }
   if (OMX_ErrorNone != rc) {
     CDBG_ERROR("%s:%d] OMX_GetHandle failed (%d)", __func__, __LINE__, rc);
     return rc;
@@ -309,29 +343,23 @@ OMX_ERRORTYPE mm_jpeg_session_create(mm_jpeg_job_session_t* p_session)
 
 
 
-/** mm_jpeg_session_destroy:
+/** mm_jpeg_session_unload:
  *
  *  Arguments:
  *    @p_session: job session
  *
  *  Return:
- *       none
+ *       OMX error types
  *
  *  Description:
- *       Destroy a jpeg encode session
+ *       Move the session back to the loaded state and release
+ *       its buffers. The omx handle stays valid.
  *
  **/
-void mm_jpeg_session_destroy(mm_jpeg_job_session_t* p_session)
+static OMX_ERRORTYPE mm_jpeg_session_unload(mm_jpeg_job_session_t* p_session)
 {
   OMX_ERRORTYPE rc = OMX_ErrorNone;
   OMX_STATETYPE state;
-  mm_jpeg_obj *my_obj = (mm_jpeg_obj *) p_session->jpeg_obj;
-
-  CDBG("%s:%d] E", __func__, __LINE__);
-  if (NULL == p_session->omx_handle) {
-    CDBG_ERROR("%s:%d] invalid handle", __func__, __LINE__);
-    return;
-  }
 
   rc = OMX_GetState(p_session->omx_handle, &state);
 
@@ -353,11 +381,40 @@ void mm_jpeg_session_destroy(mm_jpeg_job_session_t* p_session)
     }
   }
 
+  return rc;
+}
+
+/** mm_jpeg_session_destroy:
+ *
+ *  Arguments:
+ *    @p_session: job session
+ *
+ *  Return:
+ *       none
+ *
+ *  Description:
+ *       Destroy a jpeg encode session
+ *
+ **/
+void mm_jpeg_session_destroy(mm_jpeg_job_session_t* p_session)
+{
+  OMX_ERRORTYPE rc = OMX_ErrorNone;
+  mm_jpeg_obj *my_obj = (mm_jpeg_obj *) p_session->jpeg_obj;
+
+  CDBG("%s:%d] E", __func__, __LINE__);
+  if (NULL == p_session->omx_handle) {
+    CDBG_ERROR("%s:%d] invalid handle", __func__, __LINE__);
+    return;
+  }
+
+  mm_jpeg_session_unload(p_session);
+
   rc = OMX_FreeHandle(p_session->omx_handle);
   if (0 != rc) {
     CDBG_ERROR("%s:%d] OMX_FreeHandle failed (%d)", __func__, __LINE__, rc);
   }
   p_session->omx_handle = NULL;
+  p_session->work_buffer.addr = NULL;
 
   pthread_mutex_destroy(&p_session->lock);
   pthread_cond_destroy(&p_session->cond);
@@ -1128,7 +1185,8 @@ OMX_ERRORTYPE mm_jpeg_session_config_common(mm_jpeg_job_session_t *p_session)
     exif_info.numOfEntries = 0;
     exif_info.exif_data = &p_session->exif_info_local[0];
     process_meta_data(p_jobparams->p_metadata, &exif_info,
-      &p_jobparams->cam_exif_params, p_jobparams->hal_version);
+      &p_session->exif_arena, &p_jobparams->cam_exif_params,
+      p_jobparams->hal_version);
     /* After Parse metadata */
     p_session->exif_count_local = (int)exif_info.numOfEntries;
 
@@ -1472,7 +1530,9 @@ error:
  *       0 for success -1 otherwise
  *
  *  Description:
- *       Start the encoding job
+ *       Start the encoding job. Called with job_lock held; the
+ *       lock is dropped while the OMX session is configured and
+ *       started so other workers can start jobs on other sessions.
  *
  **/
 int32_t mm_jpeg_process_encoding_job(mm_jpeg_obj *my_obj, mm_jpeg_job_q_node_t* job_node)
@@ -1482,12 +1542,15 @@ int32_t mm_jpeg_process_encoding_job(mm_jpeg_obj *my_obj, mm_jpeg_job_q_node_t*
   OMX_ERRORTYPE ret = OMX_ErrorNone;
   mm_jpeg_job_session_t *p_session = NULL;
   uint32_t buf_idx;
+  /* job_lock is dropped exactly while this thread is dispatching */
+  OMX_BOOL locked = OMX_TRUE;
 
   /* check if valid session */
   p_session = mm_jpeg_get_session(my_obj, job_node->enc_info.job_id);
   if (NULL == p_session) {
     CDBG_ERROR("%s:%d] invalid job id %x", __func__, __LINE__,
         job_node->enc_info.job_id);
+    free(job_node);
     return -1;
   }
 
@@ -1520,7 +1583,12 @@ int32_t mm_jpeg_process_encoding_job(mm_jpeg_obj *my_obj, mm_jpeg_job_q_node_t*
     if (0U == buf_idx) {
       CDBG_ERROR("%s:%d] No available output buffers %d",
           __func__, __LINE__, ret);
-      return OMX_ErrorUndefined;
+      /* give the handle back and retry once a buffer is returned */
+      qdata.p = p_session;
+      mm_jpeg_queue_enq_head(p_session->session_handle_q, qdata);
+      qdata.p = job_node;
+      mm_jpeg_queue_enq_head(&my_obj->job_mgr.job_queue, qdata);
+      return rc;
     }
 
     buf_idx--;
@@ -1530,27 +1598,42 @@ int32_t mm_jpeg_process_encoding_job(mm_jpeg_obj *my_obj, mm_jpeg_job_q_node_t*
   }
 
   /* sent encode cmd to OMX, queue job into ongoing queue */
+  p_session->encode_job = job_node->enc_info.encode_job;
+  p_session->jobId = job_node->enc_info.job_id;
   qdata.p = job_node;
   rc = mm_jpeg_queue_enq(&my_obj->ongoing_job_q, qdata);
   if (rc) {
     CDBG_ERROR("%s:%d] jpeg enqueue failed %d",
       __func__, __LINE__, ret);
+    free(job_node);
+    ret = OMX_ErrorInsufficientResources;
     goto error;
   }
 
-  p_session->encode_job = job_node->enc_info.encode_job;
-  p_session->jobId = job_node->enc_info.job_id;
+  /* aborts and session destroys wait for the start to complete */
+  p_session->dispatching++;
+  locked = OMX_FALSE;
+  pthread_mutex_unlock(&my_obj->job_lock);
+
   ret = mm_jpeg_session_encode(p_session);
   if (ret) {
     CDBG_ERROR("%s:%d] encode session failed", __func__, __LINE__);
     goto error;
   }
 
+  pthread_mutex_lock(&my_obj->job_lock);
+  p_session->dispatching--;
+  pthread_cond_broadcast(&my_obj->job_mgr.dispatch_cond);
+
   CDBG("%s:%d] Success X ", __func__, __LINE__);
   return rc;
 
 error:
 
+  if (OMX_TRUE == locked) {
+    pthread_mutex_unlock(&my_obj->job_lock);
+  }
+
   if ((OMX_ErrorNone != ret) &&
     (NULL != p_session->params.jpeg_cb)) {
     p_session->job_status = JPEG_JOB_STATUS_ERROR;
@@ -1567,10 +1650,179 @@ error:
   mm_jpegenc_job_done(p_session);
   CDBG("%s:%d] Error X ", __func__, __LINE__);
 
+  pthread_mutex_lock(&my_obj->job_lock);
+  if (OMX_FALSE == locked) {
+    p_session->dispatching--;
+    pthread_cond_broadcast(&my_obj->job_mgr.dispatch_cond);
+  }
+
   return rc;
 }
 
+/** mm_jpeg_wait_dispatch:
+ *
+ *  Arguments:
+ *    @my_obj: jpeg object
+ *    @p_session: session, followed through next_session
+ *
+ *  Return:
+ *       none
+ *
+ *  Description:
+ *       Wait until no job manager thread is starting a job on
+ *       the session. Must be called with job_lock held.
+ *
+ **/
+static void mm_jpeg_wait_dispatch(mm_jpeg_obj *my_obj,
+  mm_jpeg_job_session_t *p_session)
+{
+  mm_jpeg_job_session_t *p_cur = p_session;
+
+  while (NULL != p_cur) {
+    if (p_cur->dispatching > 0) {
+      pthread_cond_wait(&my_obj->job_mgr.dispatch_cond, &my_obj->job_lock);
+      p_cur = p_session;
+      continue;
+    }
+    p_cur = p_cur->next_session;
+  }
+}
+
+/** mm_jpeg_session_dispatching:
+ *
+ *  Arguments:
+ *    @p_session: session, followed through next_session
+ *
+ *  Return:
+ *       OMX_TRUE if a job manager thread is starting a job on the
+ *       session or one of its extra handles
+ *
+ *  Description:
+ *       A handle is requeued by mm_jpegenc_job_done as soon as
+ *       its job completes, which can happen before the thread
+ *       that started it retakes job_lock. Must be called with
+ *       job_lock held.
+ *
+ **/
+static OMX_BOOL mm_jpeg_session_dispatching(mm_jpeg_job_session_t *p_session)
+{
+  mm_jpeg_job_session_t *p_cur;
+
+  for (p_cur = p_session; NULL != p_cur; p_cur = p_cur->next_session) {
+    if (p_cur->dispatching > 0) {
+      return OMX_TRUE;
+    }
+  }
+  return OMX_FALSE;
+}
+
+/** mm_jpeg_jobmgr_next_job:
+ *
+ *  Arguments:
+ *    @my_obj: jpeg object
+ *
+ *  Return:
+ *       job node removed from the todo queue, NULL if nothing can
+ *       be dispatched now
+ *
+ *  Description:
+ *       Pick the next job. Exit and decode commands are served
+ *       first. Encode jobs keep their order within a session; the
+ *       head job of each session whose OMX handle and output
+ *       buffer are available and which no other thread is
+ *       starting a job on competes in the round robin
+ *       scheduler, where thumbnail/preview sized jobs get
+ *       priority. Must be called with job_lock held.
+ *
+ **/
+static mm_jpeg_job_q_node_t *mm_jpeg_jobmgr_next_job(mm_jpeg_obj *my_obj)
+{
+  mm_jpeg_queue_t *queue = &my_obj->job_mgr.job_queue;
+  mm_jpeg_q_node_t *heads[MAX_JPEG_CLIENT_NUM * MM_JPEG_MAX_SESSION];
+  uint8_t slots[MAX_JPEG_CLIENT_NUM * MM_JPEG_MAX_SESSION];
+  mm_jpeg_q_node_t *node = NULL;
+  mm_jpeg_q_node_t *picked = NULL;
+  mm_jpeg_job_q_node_t *job = NULL;
+  mm_jpeg_job_session_t *p_session = NULL;
+  mm_jpeg_encode_job_t *p_job = NULL;
+  struct cam_list *head = NULL;
+  struct cam_list *pos = NULL;
+  uint32_t client_idx, session_idx, slot;
+  int32_t pick;
+  OMX_BOOL can_start;
+
+  can_start = (mm_jpeg_queue_get_size(&my_obj->ongoing_job_q) <
+    NUM_MAX_JPEG_CNCURRENT_JOBS) ? OMX_TRUE : OMX_FALSE;
+
+  memset(heads, 0, sizeof(heads));
+  memset(slots, 0, sizeof(slots));
+
+  pthread_mutex_lock(&queue->lock);
+  head = &queue->head.list;
+  for (pos = head->next; pos != head; pos = pos->next) {
+    node = member_of(pos, mm_jpeg_q_node_t, list);
+    job = (mm_jpeg_job_q_node_t *)node->data.p;
+    if (NULL == job) {
+      continue;
+    }
+
+    if (MM_JPEG_CMD_TYPE_JOB != job->type) {
+      if ((MM_JPEG_CMD_TYPE_DECODE_JOB != job->type) || can_start) {
+        picked = node;
+        break;
+      }
+      continue;
+    }
+
+    client_idx = GET_CLIENT_IDX(job->enc_info.job_id);
+    session_idx = GET_SESSION_IDX(job->enc_info.job_id);
+    if ((client_idx >= MAX_JPEG_CLIENT_NUM) ||
+      (session_idx >= MM_JPEG_MAX_SESSION)) {
+      /* let the dispatch report the invalid job */
+      picked = node;
+      break;
+    }
+
+    /* only the oldest job of each session can start */
+    slot = client_idx * MM_JPEG_MAX_SESSION + session_idx;
+    if (NULL != heads[slot]) {
+      continue;
+    }
+    heads[slot] = node;
+
+    p_session = &my_obj->clnt_mgr[client_idx].session[session_idx];
+    p_job = &job->enc_info.encode_job;
+    if (!can_start || mm_jpeg_session_dispatching(p_session) ||
+      (NULL == p_session->session_handle_q) ||
+      (0 == mm_jpeg_queue_get_size(p_session->session_handle_q)) ||
+      ((p_job->dst_index < 0) && ((NULL == p_session->out_buf_q) ||
+      (0 == mm_jpeg_queue_get_size(p_session->out_buf_q))))) {
+      continue;
+    }
+    slots[slot] = mm_jpeg_sched_is_prio(p_job->main_dim.dst_dim.width,
+      p_job->main_dim.dst_dim.height) ?
+      MM_JPEG_SCHED_SLOT_PRIO : MM_JPEG_SCHED_SLOT_READY;
+  }
+
+  if (NULL == picked) {
+    pick = mm_jpeg_sched_pick(&my_obj->job_mgr.sched, slots,
+      MAX_JPEG_CLIENT_NUM * MM_JPEG_MAX_SESSION);
+    if (pick >= 0) {
+      picked = heads[pick];
+    }
+  }
 
+  job = NULL;
+  if (NULL != picked) {
+    job = (mm_jpeg_job_q_node_t *)picked->data.p;
+    cam_list_del_node(&picked->list);
+    queue->size--;
+    free(picked);
+  }
+  pthread_mutex_unlock(&queue->lock);
+
+  return job;
+}
 
 /** mm_jpeg_jobmgr_thread:
  *
@@ -1581,15 +1833,14 @@ error:
  *       0 for success else failure
  *
  *  Description:
- *       job manager thread main function
+ *       job manager thread main function. Several instances run
+ *       as a worker pool, each starting one job at a time.
  *
  **/
 static void *mm_jpeg_jobmgr_thread(void *data)
 {
-  mm_jpeg_q_data_t qdata;
   int rc = 0;
   int running = 1;
-  uint32_t num_ongoing_jobs = 0;
   mm_jpeg_obj *my_obj = (mm_jpeg_obj*)data;
   mm_jpeg_job_cmd_thread_t *cmd_thread = &my_obj->job_mgr;
   mm_jpeg_job_q_node_t* node = NULL;
@@ -1605,21 +1856,15 @@ static void *mm_jpeg_jobmgr_thread(void *data)
       }
     } while (rc != 0);
 
-    /* check ongoing q size */
-    num_ongoing_jobs = mm_jpeg_queue_get_size(&my_obj->ongoing_job_q);
-    if (num_ongoing_jobs >= NUM_MAX_JPEG_CNCURRENT_JOBS) {
-      CDBG("%s:%d] ongoing job already reach max %d", __func__,
-        __LINE__, num_ongoing_jobs);
-      continue;
-    }
-
     pthread_mutex_lock(&my_obj->job_lock);
-    /* can go ahead with new work */
-    qdata = mm_jpeg_queue_deq(&cmd_thread->job_queue);
-    node = (mm_jpeg_job_q_node_t*)qdata.p;
-    if (node != NULL) {
+    /* start every job that can go ahead, one at a time */
+    while (running && (NULL != (node = mm_jpeg_jobmgr_next_job(my_obj)))) {
       switch (node->type) {
       case MM_JPEG_CMD_TYPE_JOB:
+        /* let an idle worker look for more work meanwhile */
+        if (cmd_thread->num_threads > 1) {
+          cam_sem_post(&cmd_thread->job_sem);
+        }
         rc = mm_jpeg_process_encoding_job(my_obj, node);
         break;
       case MM_JPEG_CMD_TYPE_DECODE_JOB:
@@ -1649,22 +1894,49 @@ static void *mm_jpeg_jobmgr_thread(void *data)
  *       0 for success else failure
  *
  *  Description:
- *       launches the job manager thread
+ *       launches the job manager threads. The number of workers
+ *       is read from persist.camera.jpeg.workers.
  *
  **/
 int32_t mm_jpeg_jobmgr_thread_launch(mm_jpeg_obj *my_obj)
 {
   int32_t rc = 0;
+  uint32_t i;
+  int num_threads;
+  char prop[PROPERTY_VALUE_MAX];
   mm_jpeg_job_cmd_thread_t *job_mgr = &my_obj->job_mgr;
 
   cam_sem_init(&job_mgr->job_sem, 0);
   mm_jpeg_queue_init(&job_mgr->job_queue);
+  pthread_cond_init(&job_mgr->dispatch_cond, NULL);
+  mm_jpeg_sched_init(&job_mgr->sched);
+
+  property_get("persist.camera.jpeg.workers", prop, "0");
+  num_threads = atoi(prop);
+  if (num_threads <= 0) {
+    num_threads = NUM_MAX_JPEG_CNCURRENT_JOBS;
+  }
+  if (num_threads > MM_JPEG_MAX_JOB_THREADS) {
+    num_threads = MM_JPEG_MAX_JOB_THREADS;
+  }
 
-  /* launch the thread */
-  pthread_create(&job_mgr->pid,
-    NULL,
-    mm_jpeg_jobmgr_thread,
-    (void *)my_obj);
+  /* launch the threads */
+  job_mgr->num_threads = 0;
+  for (i = 0; i < (uint32_t)num_threads; i++) {
+    if (pthread_create(&job_mgr->pid[i],
+      NULL,
+      mm_jpeg_jobmgr_thread,
+      (void *)my_obj)) {
+      CDBG_ERROR("%s:%d] cannot create worker %d", __func__, __LINE__, i);
+      break;
+    }
+    job_mgr->num_threads++;
+  }
+  if (0 == job_mgr->num_threads) {
+    rc = -1;
+  }
+  CDBG_HIGH("%s:%d] %d job workers", __func__, __LINE__,
+    job_mgr->num_threads);
   return rc;
 }
 
@@ -1677,35 +1949,43 @@ int32_t mm_jpeg_jobmgr_thread_launch(mm_jpeg_obj *my_obj)
  *       0 for success else failure
  *
  *  Description:
- *       Releases the job manager thread
+ *       Releases the job manager threads
  *
  **/
 int32_t mm_jpeg_jobmgr_thread_release(mm_jpeg_obj * my_obj)
 {
   mm_jpeg_q_data_t qdata;
   int32_t rc = 0;
+  uint32_t i;
   mm_jpeg_job_cmd_thread_t * cmd_thread = &my_obj->job_mgr;
-  mm_jpeg_job_q_node_t* node =
-    (mm_jpeg_job_q_node_t *)malloc(sizeof(mm_jpeg_job_q_node_t));
-  if (NULL == node) {
-    CDBG_ERROR("%s: No memory for mm_jpeg_job_q_node_t", __func__);
-    return -1;
-  }
+  mm_jpeg_job_q_node_t* node = NULL;
 
-  memset(node, 0, sizeof(mm_jpeg_job_q_node_t));
-  node->type = MM_JPEG_CMD_TYPE_EXIT;
+  /* one exit command per worker */
+  for (i = 0; i < cmd_thread->num_threads; i++) {
+    node = (mm_jpeg_job_q_node_t *)malloc(sizeof(mm_jpeg_job_q_node_t));
+    if (NULL == node) {
+      CDBG_ERROR("%s: No memory for mm_jpeg_job_q_node_t", __func__);
+      return -1;
+    }
 
-  qdata.p = node;
-  mm_jpeg_queue_enq(&cmd_thread->job_queue, qdata);
-  cam_sem_post(&cmd_thread->job_sem);
+    memset(node, 0, sizeof(mm_jpeg_job_q_node_t));
+    node->type = MM_JPEG_CMD_TYPE_EXIT;
 
-  /* wait until cmd thread exits */
-  if (pthread_join(cmd_thread->pid, NULL) != 0) {
-    CDBG("%s: pthread dead already", __func__);
+    qdata.p = node;
+    mm_jpeg_queue_enq(&cmd_thread->job_queue, qdata);
+    cam_sem_post(&cmd_thread->job_sem);
+  }
+
+  /* wait until cmd threads exit */
+  for (i = 0; i < cmd_thread->num_threads; i++) {
+    if (pthread_join(cmd_thread->pid[i], NULL) != 0) {
+      CDBG("%s: pthread dead already", __func__);
+    }
   }
   mm_jpeg_queue_deinit(&cmd_thread->job_queue);
 
   cam_sem_destroy(&cmd_thread->job_sem);
+  pthread_cond_destroy(&cmd_thread->dispatch_cond);
   memset(cmd_thread, 0, sizeof(mm_jpeg_job_cmd_thread_t));
   return rc;
 }
@@ -1728,6 +2008,7 @@ int32_t mm_jpeg_init(mm_jpeg_obj *my_obj)
   uint32_t work_buf_size;
   unsigned int i = 0;
   unsigned int initial_workbufs_cnt = 1;
+  char prop[PROPERTY_VALUE_MAX];
 
   /* init locks */
   pthread_mutex_init(&my_obj->job_lock, NULL);
@@ -1748,6 +2029,9 @@ int32_t mm_jpeg_init(mm_jpeg_obj *my_obj)
     return -1;
   }
 
+  property_get("persist.camera.jpeg.pool", prop, "1");
+  my_obj->pool.enabled = atoi(prop);
+
   /* set work buf size from max picture size */
   if (my_obj->max_pic_w <= 0 || my_obj->max_pic_h <= 0) {
     CDBG_ERROR("%s:%d] Width and height are not valid "
@@ -2019,6 +2303,7 @@ int32_t mm_jpeg_abort_job(mm_jpeg_obj *my_obj,
     /* find job that is OMX ongoing, ask OMX to abort the job */
     p_session = mm_jpeg_get_session(my_obj, node->enc_info.job_id);
     if (p_session) {
+      mm_jpeg_wait_dispatch(my_obj, p_session);
       mm_jpeg_session_abort(p_session);
     } else {
       CDBG_ERROR("%s:%d] Invalid job id 0x%x", __func__, __LINE__,
@@ -2067,6 +2352,294 @@ static int32_t mm_jpeg_read_meta_keyfile(mm_jpeg_job_session_t *p_session,
 }
 #endif // MM_JPEG_READ_META_KEYFILE
 
+/** mm_jpeg_time_us:
+ *
+ *  Arguments:
+ *    none
+ *
+ *  Return:
+ *       monotonic time in microseconds
+ *
+ **/
+static uint64_t mm_jpeg_time_us(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000ULL + (uint64_t)ts.tv_nsec / 1000ULL;
+}
+
+/** mm_jpeg_pool_key_match:
+ *
+ *  Arguments:
+ *    @p_a: encode params of a parked session
+ *    @p_b: requested encode params
+ *
+ *  Return:
+ *       OMX_TRUE if the session can be reused for the request
+ *
+ *  Description:
+ *       Compare the encode configuration. Buffers are not part
+ *       of the key, they are rebound when the session is reused.
+ *
+ **/
+static OMX_BOOL mm_jpeg_pool_key_match(mm_jpeg_encode_params_t *p_a,
+  mm_jpeg_encode_params_t *p_b)
+{
+  if ((p_a->color_format != p_b->color_format) ||
+    (p_a->thumb_color_format != p_b->thumb_color_format) ||
+    (p_a->quality != p_b->quality) ||
+    (p_a->thumb_quality != p_b->thumb_quality) ||
+    (p_a->encode_thumbnail != p_b->encode_thumbnail) ||
+    (p_a->rotation != p_b->rotation) ||
+    (p_a->thumb_rotation != p_b->thumb_rotation) ||
+    (p_a->burst_mode != p_b->burst_mode)) {
+    return OMX_FALSE;
+  }
+  if (memcmp(&p_a->main_dim, &p_b->main_dim, sizeof(p_a->main_dim)) ||
+    memcmp(&p_a->thumb_dim, &p_b->thumb_dim, sizeof(p_a->thumb_dim))) {
+    return OMX_FALSE;
+  }
+  return OMX_TRUE;
+}
+
+/** mm_jpeg_get_free_work_buf:
+ *
+ *  Arguments:
+ *    @my_obj: jpeg object
+ *
+ *  Return:
+ *       index of a work buffer not held by an active session,
+ *       -1 if there is none
+ *
+ *  Description:
+ *       Parked sessions do not encode and hold no work buffer
+ *
+ **/
+static int mm_jpeg_get_free_work_buf(mm_jpeg_obj *my_obj)
+{
+  mm_jpeg_job_session_t *p_session;
+  uint32_t i, c, s;
+  OMX_BOOL held;
+
+  for (i = 0; i < my_obj->work_buf_cnt; i++) {
+    held = OMX_FALSE;
+    for (c = 0; (c < MAX_JPEG_CLIENT_NUM) && !held; c++) {
+      for (s = 0; (s < MM_JPEG_MAX_SESSION) && !held; s++) {
+        p_session = &my_obj->clnt_mgr[c].session[s];
+        held = p_session->active &&
+          (p_session->work_buffer.addr == my_obj->ionBuffer[i].addr);
+      }
+    }
+    if (!held) {
+      return (int)i;
+    }
+  }
+  return -1;
+}
+
+/** mm_jpeg_pool_evict:
+ *
+ *  Arguments:
+ *    @my_obj: jpeg object
+ *    @p_session: head of a parked session chain
+ *
+ *  Return:
+ *       none
+ *
+ *  Description:
+ *       Free the omx handles of a parked session. Called with
+ *       job_lock held.
+ *
+ **/
+static void mm_jpeg_pool_evict(mm_jpeg_obj *my_obj,
+  mm_jpeg_job_session_t *p_session)
+{
+  mm_jpeg_job_session_t *p_cur;
+
+  CDBG_HIGH("%s:%d] evict session %x", __func__, __LINE__,
+    p_session->sessionId);
+  mm_jpeg_session_destroy(p_session);
+  for (p_cur = p_session; NULL != p_cur; p_cur = p_cur->next_session) {
+    p_cur->parked = OMX_FALSE;
+    p_cur->pool_seq = 0;
+    my_obj->pool.num_parked--;
+  }
+}
+
+/** mm_jpeg_pool_lru:
+ *
+ *  Arguments:
+ *    @my_obj: jpeg object
+ *
+ *  Return:
+ *       least recently parked session chain, NULL if none
+ *
+ **/
+static mm_jpeg_job_session_t *mm_jpeg_pool_lru(mm_jpeg_obj *my_obj)
+{
+  mm_jpeg_job_session_t *p_session, *p_lru = NULL;
+  uint32_t c, s;
+
+  for (c = 0; c < MAX_JPEG_CLIENT_NUM; c++) {
+    for (s = 0; s < MM_JPEG_MAX_SESSION; s++) {
+      p_session = &my_obj->clnt_mgr[c].session[s];
+      /* only the head of a chain carries the stamp */
+      if (p_session->parked && p_session->pool_seq &&
+        ((NULL == p_lru) || (p_session->pool_seq < p_lru->pool_seq))) {
+        p_lru = p_session;
+      }
+    }
+  }
+  return p_lru;
+}
+
+/** mm_jpeg_pool_make_room:
+ *
+ *  Arguments:
+ *    @my_obj: jpeg object
+ *    @num_omx_sessions: number of omx handles about to be created
+ *
+ *  Return:
+ *       none
+ *
+ *  Description:
+ *       Evict parked sessions, least recently used first, until
+ *       the new handles fit under MAX_OMX_HANDLES. Called with
+ *       job_lock held.
+ *
+ **/
+static void mm_jpeg_pool_make_room(mm_jpeg_obj *my_obj,
+  uint32_t num_omx_sessions)
+{
+  mm_jpeg_job_session_t *p_lru;
+
+  while (my_obj->pool.num_parked &&
+    (my_obj->num_sessions + num_omx_sessions > MAX_OMX_HANDLES)) {
+    p_lru = mm_jpeg_pool_lru(my_obj);
+    if (NULL == p_lru) {
+      break;
+    }
+    mm_jpeg_pool_evict(my_obj, p_lru);
+    my_obj->pool.evictions++;
+  }
+}
+
+/** mm_jpeg_pool_get:
+ *
+ *  Arguments:
+ *    @my_obj: jpeg object
+ *    @clnt_idx: client index
+ *    @p_params: requested encode params
+ *    @num_omx_sessions: number of omx handles requested
+ *
+ *  Return:
+ *       head of the reactivated session chain, NULL on a miss
+ *
+ *  Description:
+ *       Look up a parked session of the client with the same
+ *       encode configuration. The omx callbacks carry the session
+ *       pointer, so only sessions of the same client can be
+ *       reused. Called with job_lock held.
+ *
+ **/
+static mm_jpeg_job_session_t *mm_jpeg_pool_get(mm_jpeg_obj *my_obj,
+  uint8_t clnt_idx, mm_jpeg_encode_params_t *p_params,
+  uint32_t num_omx_sessions)
+{
+  mm_jpeg_client_t *p_client = &my_obj->clnt_mgr[clnt_idx];
+  mm_jpeg_job_session_t *p_session = NULL, *p_cur;
+  uint32_t s;
+
+  if (!my_obj->pool.enabled) {
+    return NULL;
+  }
+
+  for (s = 0; s < MM_JPEG_MAX_SESSION; s++) {
+    p_cur = &p_client->session[s];
+    if (p_cur->parked && p_cur->pool_seq &&
+      (p_cur->num_omx_sessions == num_omx_sessions) &&
+      mm_jpeg_pool_key_match(&p_cur->params, p_params) &&
+      ((NULL == p_session) || (p_cur->pool_seq > p_session->pool_seq))) {
+      p_session = p_cur;
+    }
+  }
+  if (NULL == p_session) {
+    return NULL;
+  }
+
+  pthread_mutex_lock(&p_client->lock);
+  for (p_cur = p_session; NULL != p_cur; p_cur = p_cur->next_session) {
+    p_cur->parked = OMX_FALSE;
+    p_cur->pool_seq = 0;
+    p_cur->active = OMX_TRUE;
+    my_obj->pool.num_parked--;
+  }
+  pthread_mutex_unlock(&p_client->lock);
+  return p_session;
+}
+
+/** mm_jpeg_pool_put:
+ *
+ *  Arguments:
+ *    @my_obj: jpeg object
+ *    @p_session: head of the session chain being destroyed
+ *
+ *  Return:
+ *       OMX_TRUE if the session was parked, OMX_FALSE if it has to
+ *       be destroyed
+ *
+ *  Description:
+ *       Keep the omx handles of an aborted session in the loaded
+ *       state so a later session with the same configuration
+ *       skips OMX_GetHandle. Called with job_lock held.
+ *
+ **/
+static OMX_BOOL mm_jpeg_pool_put(mm_jpeg_obj *my_obj,
+  mm_jpeg_job_session_t *p_session)
+{
+  mm_jpeg_job_session_t *p_cur, *p_lru;
+
+  if (!my_obj->pool.enabled) {
+    return OMX_FALSE;
+  }
+
+  for (p_cur = p_session; NULL != p_cur; p_cur = p_cur->next_session) {
+    if ((NULL == p_cur->omx_handle) ||
+      (OMX_ErrorNone != p_cur->error_flag)) {
+      return OMX_FALSE;
+    }
+  }
+  for (p_cur = p_session; NULL != p_cur; p_cur = p_cur->next_session) {
+    if (OMX_ErrorNone != mm_jpeg_session_unload(p_cur)) {
+      return OMX_FALSE;
+    }
+  }
+
+  for (p_cur = p_session; NULL != p_cur; p_cur = p_cur->next_session) {
+    p_cur->parked = OMX_TRUE;
+    if (NULL != p_cur->meta_enc_key) {
+      free(p_cur->meta_enc_key);
+      p_cur->meta_enc_key = NULL;
+    }
+    my_obj->pool.num_parked++;
+  }
+  p_session->pool_seq = ++my_obj->pool.seq;
+
+  while (my_obj->num_sessions > MAX_OMX_HANDLES) {
+    p_lru = mm_jpeg_pool_lru(my_obj);
+    if ((NULL == p_lru) || (p_lru == p_session)) {
+      break;
+    }
+    mm_jpeg_pool_evict(my_obj, p_lru);
+    my_obj->pool.evictions++;
+  }
+
+  CDBG_HIGH("%s:%d] parked session %x, %d handles parked", __func__,
+    __LINE__, p_session->sessionId, my_obj->pool.num_parked);
+  return OMX_TRUE;
+}
+
 /** mm_jpeg_create_session:
  *
  *  Arguments:
@@ -2100,6 +2673,10 @@ int32_t mm_jpeg_create_session(mm_jpeg_obj *my_obj,
   uint32_t work_buf_size;
   mm_jpeg_queue_t *p_session_handle_q, *p_out_buf_q;
   uint32_t work_bufs_need;
+  mm_jpeg_job_session_t *p_warm = NULL;
+  OMX_BOOL warm = OMX_FALSE;
+  uint64_t start_us, create_us, cold_avg_us, warm_avg_us;
+  int work_buf_idx;
 
   /* validate the parameters */
   if ((p_params->num_src_bufs > MM_JPEG_MAX_BUF)
@@ -2115,11 +2692,24 @@ int32_t mm_jpeg_create_session(mm_jpeg_obj *my_obj,
     return -1;
   }
 
+  start_us = mm_jpeg_time_us();
   num_omx_sessions = 1;
   if (p_params->burst_mode) {
     num_omx_sessions = MM_JPEG_CONCURRENT_SESSIONS_COUNT;
   }
-  work_bufs_need = my_obj->num_sessions + num_omx_sessions;
+
+  /* reuse a parked session with the same configuration if any */
+  pthread_mutex_lock(&my_obj->job_lock);
+  p_warm = mm_jpeg_pool_get(my_obj, clnt_idx, p_params, num_omx_sessions);
+  if (NULL == p_warm) {
+    mm_jpeg_pool_make_room(my_obj, num_omx_sessions);
+  } else {
+    warm = OMX_TRUE;
+  }
+  pthread_mutex_unlock(&my_obj->job_lock);
+
+  work_bufs_need = my_obj->num_sessions - my_obj->pool.num_parked +
+    (warm ? 0 : num_omx_sessions);
   if (work_bufs_need > MM_JPEG_CONCURRENT_SESSIONS_COUNT) {
     work_bufs_need = MM_JPEG_CONCURRENT_SESSIONS_COUNT;
   }
@@ -2170,11 +2760,16 @@ int32_t mm_jpeg_create_session(mm_jpeg_obj *my_obj,
   }
 
   for (i = 0; i < num_omx_sessions; i++) {
-    uint32_t buf_idx = 0U;
-    session_idx = mm_jpeg_get_new_session_idx(my_obj, clnt_idx, &p_session);
-    if (session_idx < 0) {
-      CDBG_ERROR("%s:%d] invalid session id (%d)", __func__, __LINE__, session_idx);
-      return rc;
+    if (NULL != p_warm) {
+      p_session = p_warm;
+      p_warm = p_warm->next_session;
+      session_idx = (int)(p_session - my_obj->clnt_mgr[clnt_idx].session);
+    } else {
+      session_idx = mm_jpeg_get_new_session_idx(my_obj, clnt_idx, &p_session);
+      if (session_idx < 0) {
+        CDBG_ERROR("%s:%d] invalid session id (%d)", __func__, __LINE__, session_idx);
+        return rc;
+      }
     }
 
     p_session->next_session = NULL;
@@ -2184,22 +2779,27 @@ int32_t mm_jpeg_create_session(mm_jpeg_obj *my_obj,
     }
     p_prev_session = p_session;
 
-    buf_idx = my_obj->num_sessions + i;
-    if (buf_idx < MM_JPEG_CONCURRENT_SESSIONS_COUNT) {
-      p_session->work_buffer = my_obj->ionBuffer[buf_idx];
+    p_session->work_buffer.addr = NULL;
+    work_buf_idx = mm_jpeg_get_free_work_buf(my_obj);
+    if (work_buf_idx >= 0) {
+      p_session->work_buffer = my_obj->ionBuffer[work_buf_idx];
     } else {
-      p_session->work_buffer.addr = NULL;
       p_session->work_buffer.ion_fd = -1;
       p_session->work_buffer.p_pmem_fd = -1;
     }
 
-    p_session->jpeg_obj = (void*)my_obj; /* save a ptr to jpeg_obj */
+    if (warm) {
+      /* the omx handle is kept from the parked session */
+      mm_jpeg_session_reset(p_session);
+    } else {
+      p_session->jpeg_obj = (void*)my_obj; /* save a ptr to jpeg_obj */
 
-    ret = mm_jpeg_session_create(p_session);
-    if (OMX_ErrorNone != ret) {
-      p_session->active = OMX_FALSE;
-      CDBG_ERROR("%s:%d] jpeg session create failed", __func__, __LINE__);
-      return rc;
+      ret = mm_jpeg_session_create(p_session);
+      if (OMX_ErrorNone != ret) {
+        p_session->active = OMX_FALSE;
+        CDBG_ERROR("%s:%d] jpeg session create failed", __func__, __LINE__);
+        return rc;
+      }
     }
 
     uint32_t session_id = (JOB_ID_MAGICVAL << 24) |
@@ -2245,6 +2845,28 @@ int32_t mm_jpeg_create_session(mm_jpeg_obj *my_obj,
     mm_jpeg_queue_enq(p_out_buf_q, qdata);
   }
 
+  create_us = mm_jpeg_time_us() - start_us;
+  if (warm) {
+    my_obj->pool.hits++;
+    my_obj->pool.warm_us += create_us;
+  } else {
+    my_obj->pool.misses++;
+    my_obj->pool.cold_us += create_us;
+  }
+  if (my_obj->pool.hits && my_obj->pool.misses) {
+    cold_avg_us = my_obj->pool.cold_us / my_obj->pool.misses;
+    warm_avg_us = my_obj->pool.warm_us / my_obj->pool.hits;
+    CDBG_HIGH("%s:%d] %s create %llu us, pool hit rate %u/%u, "
+      "saved %llu us per hit", __func__, __LINE__, warm ? "warm" : "cold",
+      (unsigned long long)create_us, my_obj->pool.hits,
+      my_obj->pool.hits + my_obj->pool.misses,
+      (unsigned long long)((cold_avg_us > warm_avg_us) ?
+      (cold_avg_us - warm_avg_us) : 0));
+  } else {
+    CDBG_HIGH("%s:%d] %s create %llu us", __func__, __LINE__,
+      warm ? "warm" : "cold", (unsigned long long)create_us);
+  }
+
   return rc;
 }
 
@@ -2263,20 +2885,16 @@ int32_t mm_jpeg_create_session(mm_jpeg_obj *my_obj,
 static int32_t mm_jpegenc_destroy_job(mm_jpeg_job_session_t *p_session)
 {
   mm_jpeg_encode_job_t *p_jobparams = &p_session->encode_job;
-  int i = 0, rc = 0;
 
-  CDBG_HIGH("%s:%d] Exif entry count %d %d", __func__, __LINE__,
+  CDBG_HIGH("%s:%d] Exif entry count %d %d, payload %u bytes %u spilled",
+    __func__, __LINE__,
     (int)p_jobparams->exif_info.numOfEntries,
-    (int)p_session->exif_count_local);
-  for (i = 0; i < p_session->exif_count_local; i++) {
-    rc = releaseExifEntry(&p_session->exif_info_local[i]);
-    if (rc) {
-      CDBG_ERROR("%s:%d] Exif release failed (%d)", __func__, __LINE__, rc);
-    }
-  }
+    (int)p_session->exif_count_local,
+    p_session->exif_arena.used, p_session->exif_arena.num_spill);
+  cam_exif_arena_reset(&p_session->exif_arena);
   p_session->exif_count_local = 0;
 
-  return rc;
+  return 0;
 }
 
 /** mm_jpeg_session_encode:
@@ -2352,6 +2970,7 @@ int32_t mm_jpeg_destroy_session(mm_jpeg_obj *my_obj,
   session_id = p_session->sessionId;
 
   pthread_mutex_lock(&my_obj->job_lock);
+  mm_jpeg_wait_dispatch(my_obj, p_session);
 
   /* abort job if in todo queue */
   CDBG("%s:%d] abort todo jobs", __func__, __LINE__);
@@ -2369,9 +2988,11 @@ int32_t mm_jpeg_destroy_session(mm_jpeg_obj *my_obj,
     node = mm_jpeg_queue_remove_job_by_session_id(&my_obj->ongoing_job_q, session_id);
   }
 
-  /* abort the current session */
+  /* abort the current session, keep it warm if possible */
   mm_jpeg_session_abort(p_session);
-  mm_jpeg_session_destroy(p_session);
+  if (!mm_jpeg_pool_put(my_obj, p_session)) {
+    mm_jpeg_session_destroy(p_session);
+  }
 
   p_cur_sess = p_session;
 
@@ -2438,6 +3059,7 @@ int32_t mm_jpeg_destroy_session_unlocked(mm_jpeg_obj *my_obj,
   }
 
   session_id = p_session->sessionId;
+  mm_jpeg_wait_dispatch(my_obj, p_session);
 
   /* abort job if in todo queue */
   CDBG("%s:%d] abort todo jobs", __func__, __LINE__);
@@ -2523,6 +3145,13 @@ int32_t mm_jpeg_close(mm_jpeg_obj *my_obj, uint32_t client_hdl)
         &my_obj->clnt_mgr[clnt_idx].session[i]);
   }
 
+  /* release the parked sessions of the client */
+  for (i = 0; i < MM_JPEG_MAX_SESSION; i++) {
+    if (my_obj->clnt_mgr[clnt_idx].session[i].parked &&
+      my_obj->clnt_mgr[clnt_idx].session[i].pool_seq)
+      mm_jpeg_pool_evict(my_obj, &my_obj->clnt_mgr[clnt_idx].session[i]);
+  }
+
   CDBG("%s:%d] ", __func__, __LINE__);
 
 #ifdef LOAD_ADSP_RPC_LIB
@@ -0,0 +1,110 @@
+/* Copyright (c) 2014, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include <stddef.h>
+#include "mm_jpeg_sched.h"
+
+/** mm_jpeg_sched_init:
+ *
+ *  Arguments:
+ *    @p_sched: scheduler
+ *
+ *  Return:
+ *       none
+ *
+ *  Description:
+ *       Reset the scheduler state
+ *
+ **/
+void mm_jpeg_sched_init(mm_jpeg_sched_t *p_sched)
+{
+  p_sched->last_slot = 0;
+  p_sched->prio_skips = 0;
+}
+
+/** mm_jpeg_sched_pick:
+ *
+ *  Arguments:
+ *    @p_sched: scheduler
+ *    @p_slots: state of each slot, see mm_jpeg_sched_slot_t
+ *    @num_slots: number of slots
+ *
+ *  Return:
+ *       index of the slot to serve, -1 if no slot is ready
+ *
+ *  Description:
+ *       Serve the ready slots in round robin order, starting after
+ *       the slot served last. A small job further down the order
+ *       is served first, but only MM_JPEG_SCHED_MAX_PRIO_SKIPS
+ *       times in a row so large jobs are never starved.
+ *
+ **/
+int32_t mm_jpeg_sched_pick(mm_jpeg_sched_t *p_sched,
+  const uint8_t *p_slots, uint32_t num_slots)
+{
+  int32_t first_ready = -1;
+  int32_t first_prio = -1;
+  int32_t pick;
+  uint32_t i, slot;
+
+  if ((NULL == p_slots) || (0 == num_slots)) {
+    return -1;
+  }
+
+  for (i = 1; i <= num_slots; i++) {
+    slot = (p_sched->last_slot + i) % num_slots;
+    if (MM_JPEG_SCHED_SLOT_IDLE == p_slots[slot]) {
+      continue;
+    }
+    if (first_ready < 0) {
+      first_ready = (int32_t)slot;
+    }
+    if (MM_JPEG_SCHED_SLOT_PRIO == p_slots[slot]) {
+      first_prio = (int32_t)slot;
+      break;
+    }
+  }
+
+  if (first_ready < 0) {
+    return -1;
+  }
+
+  if ((first_prio >= 0) && (first_prio != first_ready) &&
+    (p_sched->prio_skips < MM_JPEG_SCHED_MAX_PRIO_SKIPS)) {
+    /* keep the round robin position so the bypassed slot stays first */
+    pick = first_prio;
+    p_sched->prio_skips++;
+  } else {
+    pick = first_ready;
+    p_sched->prio_skips = 0;
+    p_sched->last_slot = (uint32_t)pick;
+  }
+
+  return pick;
+}
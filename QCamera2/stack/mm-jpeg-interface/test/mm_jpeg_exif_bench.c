@@ -0,0 +1,262 @@
+/* Copyright (c) 2014, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+/* Allocation benchmark for the exif tag table.
+ *
+ * Builds the tag set of a typical snapshot (the HAL tags followed
+ * by the tags parsed from the metadata) once per shot, the same way
+ * the legacy code did with one heap allocation per string or array
+ * payload, and with the payload arena used by the HAL and the jpeg
+ * session. Reports heap allocations and time per shot.
+ *
+ * usage: mm-jpeg-exif-bench [shots]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+
+static uint32_t g_num_alloc;
+
+static void *bench_malloc(size_t size)
+{
+  g_num_alloc++;
+  return malloc(size);
+}
+
+/* count the heap allocations made by the arena as well */
+#define malloc(s) bench_malloc(s)
+#include "cam_exif_arena.h"
+#undef malloc
+
+#define BENCH_MAX_TAGS 50
+
+/** bench_table_t
+*  @entries: tag table as handed to the encoder
+*  @num: number of valid entries
+*  @arena: payload storage, used by the arena variant only
+**/
+typedef struct {
+  QEXIF_INFO_DATA entries[BENCH_MAX_TAGS];
+  uint32_t num;
+  cam_exif_arena_t arena;
+} bench_table_t;
+
+typedef int32_t (*bench_add_fn)(bench_table_t *p_table, exif_tag_id_t tagid,
+  exif_tag_type_t type, uint32_t count, void *data);
+
+/* legacy addEntry: one allocation per string or array payload */
+static int32_t bench_legacy_add(bench_table_t *p_table, exif_tag_id_t tagid,
+  exif_tag_type_t type, uint32_t count, void *data)
+{
+  QEXIF_INFO_DATA *p_entry;
+  uint32_t size = cam_exif_payload_size(type, count);
+
+  if (p_table->num >= BENCH_MAX_TAGS) {
+    return -1;
+  }
+  p_entry = &p_table->entries[p_table->num];
+  p_entry->tag_id = tagid;
+  p_entry->tag_entry.type = type;
+  p_entry->tag_entry.count = count;
+  p_entry->tag_entry.copy = 1;
+  if (size > 0) {
+    uint8_t *values = (uint8_t *)bench_malloc(size);
+    if (values == NULL) {
+      return -1;
+    }
+    memset(values, 0, size);
+    memcpy(values, data, (type == EXIF_ASCII) ? count : size);
+    p_entry->tag_entry.data._bytes = values;
+  } else if (type == EXIF_BYTE) {
+    p_entry->tag_entry.data._byte = *(uint8_t *)data;
+  } else if (type == EXIF_SHORT) {
+    p_entry->tag_entry.data._short = *(uint16_t *)data;
+  } else if ((type == EXIF_RATIONAL) || (type == EXIF_SRATIONAL)) {
+    p_entry->tag_entry.data._rat = *(rat_t *)data;
+  } else {
+    p_entry->tag_entry.data._long = *(uint32_t *)data;
+  }
+  p_table->num++;
+  return 0;
+}
+
+static void bench_legacy_release(bench_table_t *p_table)
+{
+  uint32_t i;
+
+  for (i = 0; i < p_table->num; i++) {
+    if (cam_exif_payload_size(p_table->entries[i].tag_entry.type,
+      p_table->entries[i].tag_entry.count) > 0) {
+      free(p_table->entries[i].tag_entry.data._bytes);
+    }
+  }
+  p_table->num = 0;
+}
+
+static int32_t bench_arena_add(bench_table_t *p_table, exif_tag_id_t tagid,
+  exif_tag_type_t type, uint32_t count, void *data)
+{
+  return cam_exif_add_entry(&p_table->arena, p_table->entries, &p_table->num,
+    BENCH_MAX_TAGS, tagid, type, count, data);
+}
+
+static void bench_arena_release(bench_table_t *p_table)
+{
+  cam_exif_arena_reset(&p_table->arena);
+  p_table->num = 0;
+}
+
+/* tag set of one snapshot, values change from shot to shot */
+static int bench_build(bench_table_t *p_table, bench_add_fn add, uint32_t shot)
+{
+  char dt[20], subsec[7], gps_date[11];
+  char method[] = "ASCII\0\0\0" "GPS";
+  char make[] = "QCOM-AA", model[] = "QCAM-AA", lat_ref[] = "N";
+  char lon_ref[] = "E";
+  rat_t focal = { 4200, 1000 };
+  rat_t lat[3] = { { 37, 1 }, { 25, 1 }, { 1234, 100 } };
+  rat_t lon[3] = { { 122, 1 }, { 5, 1 }, { 4321, 100 } };
+  rat_t alt = { 30, 1 };
+  rat_t gps_time[3] = { { 12, 1 }, { 34, 1 }, { 56, 1 } };
+  rat_t exposure = { 1, 30 + shot % 90 };
+  srat_t shutter = { 4907, 1000 };
+  srat_t brightness = { 320, 100 };
+  uint8_t altref = 0;
+  uint8_t scene_type = 1;
+  uint16_t orientation = 1, iso = (uint16_t)(100 + shot % 700);
+  uint16_t flash = 0, wb = 0, metering = 2, program = 2, mode = 0;
+  uint16_t sensing = 2, focal_35mm = 28, capture_type = 0;
+  int rc = 0;
+
+  snprintf(dt, sizeof(dt), "2014:06:01 12:%02u:%02u", (shot / 60) % 60,
+    shot % 60);
+  snprintf(subsec, sizeof(subsec), "%06u", (shot * 33333U) % 1000000U);
+  snprintf(gps_date, sizeof(gps_date), "2014:06:01");
+
+  /* HAL tags */
+  rc |= add(p_table, EXIFTAGID_DATE_TIME, EXIF_ASCII, 20, dt);
+  rc |= add(p_table, EXIFTAGID_EXIF_DATE_TIME_ORIGINAL, EXIF_ASCII, 20, dt);
+  rc |= add(p_table, EXIFTAGID_EXIF_DATE_TIME_DIGITIZED, EXIF_ASCII, 20, dt);
+  rc |= add(p_table, EXIFTAGID_SUBSEC_TIME, EXIF_ASCII, 7, subsec);
+  rc |= add(p_table, EXIFTAGID_SUBSEC_TIME_ORIGINAL, EXIF_ASCII, 7, subsec);
+  rc |= add(p_table, EXIFTAGID_SUBSEC_TIME_DIGITIZED, EXIF_ASCII, 7, subsec);
+  rc |= add(p_table, EXIFTAGID_FOCAL_LENGTH, EXIF_RATIONAL, 1, &focal);
+  rc |= add(p_table, EXIFTAGID_ISO_SPEED_RATING, EXIF_SHORT, 1, &iso);
+  rc |= add(p_table, EXIFTAGID_GPS_PROCESSINGMETHOD, EXIF_UNDEFINED,
+    sizeof(method), method);
+  rc |= add(p_table, EXIFTAGID_GPS_LATITUDE, EXIF_RATIONAL, 3, lat);
+  rc |= add(p_table, EXIFTAGID_GPS_LATITUDE_REF, EXIF_ASCII, 2, lat_ref);
+  rc |= add(p_table, EXIFTAGID_GPS_LONGITUDE, EXIF_RATIONAL, 3, lon);
+  rc |= add(p_table, EXIFTAGID_GPS_LONGITUDE_REF, EXIF_ASCII, 2, lon_ref);
+  rc |= add(p_table, EXIFTAGID_GPS_ALTITUDE, EXIF_RATIONAL, 1, &alt);
+  rc |= add(p_table, EXIFTAGID_GPS_ALTITUDE_REF, EXIF_BYTE, 1, &altref);
+  rc |= add(p_table, EXIFTAGID_GPS_DATESTAMP, EXIF_ASCII, 11, gps_date);
+  rc |= add(p_table, EXIFTAGID_GPS_TIMESTAMP, EXIF_RATIONAL, 3, gps_time);
+  rc |= add(p_table, EXIFTAGID_MAKE, EXIF_ASCII, sizeof(make), make);
+  rc |= add(p_table, EXIFTAGID_MODEL, EXIF_ASCII, sizeof(model), model);
+  rc |= add(p_table, EXIFTAGID_ORIENTATION, EXIF_SHORT, 1, &orientation);
+
+  /* tags parsed from the metadata by the jpeg session */
+  rc |= add(p_table, EXIFTAGID_EXPOSURE_TIME, EXIF_RATIONAL, 1, &exposure);
+  rc |= add(p_table, EXIFTAGID_SHUTTER_SPEED, EXIF_SRATIONAL, 1, &shutter);
+  rc |= add(p_table, EXIFTAGID_WHITE_BALANCE, EXIF_SHORT, 1, &wb);
+  rc |= add(p_table, EXIFTAGID_METERING_MODE, EXIF_SHORT, 1, &metering);
+  rc |= add(p_table, EXIFTAGID_EXPOSURE_PROGRAM, EXIF_SHORT, 1, &program);
+  rc |= add(p_table, EXIFTAGID_EXPOSURE_MODE, EXIF_SHORT, 1, &mode);
+  rc |= add(p_table, EXIFTAGID_SCENE_TYPE, EXIF_UNDEFINED, 1, &scene_type);
+  rc |= add(p_table, EXIFTAGID_BRIGHTNESS, EXIF_SRATIONAL, 1, &brightness);
+  rc |= add(p_table, EXIFTAGID_FLASH, EXIF_SHORT, 1, &flash);
+  rc |= add(p_table, EXIFTAGID_SENSING_METHOD, EXIF_SHORT, 1, &sensing);
+  rc |= add(p_table, EXIFTAGID_FOCAL_LENGTH_35MM, EXIF_SHORT, 1, &focal_35mm);
+  rc |= add(p_table, EXIFTAGID_SCENE_CAPTURE_TYPE, EXIF_SHORT, 1,
+    &capture_type);
+  return rc;
+}
+
+static int64_t bench_now_ns(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static int bench_run(const char *name, bench_table_t *p_table,
+  bench_add_fn add, void (*release)(bench_table_t *), int shots)
+{
+  int64_t start;
+  uint32_t tags = 0, payload = 0;
+  uint32_t i, shot;
+
+  g_num_alloc = 0;
+  start = bench_now_ns();
+  for (shot = 0; shot < (uint32_t)shots; shot++) {
+    if (bench_build(p_table, add, shot) != 0) {
+      printf("%s: tag table full\n", name);
+      return -1;
+    }
+    tags = p_table->num;
+    release(p_table);
+  }
+  printf("%-8s %2u tags  %5.2f allocs/shot  %7.1f ns/shot\n", name, tags,
+    (double)g_num_alloc / shots,
+    (double)(bench_now_ns() - start) / shots);
+
+  bench_build(p_table, add, 0);
+  for (i = 0; i < p_table->num; i++) {
+    payload += cam_exif_payload_size(p_table->entries[i].tag_entry.type,
+      p_table->entries[i].tag_entry.count);
+  }
+  release(p_table);
+  printf("         %u payload bytes\n", payload);
+  return 0;
+}
+
+int main(int argc, char **argv)
+{
+  int shots = (argc > 1) ? atoi(argv[1]) : 100000;
+  bench_table_t *p_table = (bench_table_t *)calloc(1, sizeof(bench_table_t));
+  int rc;
+
+  if (p_table == NULL) {
+    return 1;
+  }
+  if (shots < 1) {
+    shots = 100000;
+  }
+  cam_exif_arena_init(&p_table->arena);
+  rc = bench_run("legacy", p_table, bench_legacy_add, bench_legacy_release,
+    shots);
+  rc |= bench_run("arena", p_table, bench_arena_add, bench_arena_release,
+    shots);
+  free(p_table);
+  return rc ? 1 : 0;
+}
@@ -0,0 +1,797 @@
+/* Copyright (c) 2014, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+/* Queueing benchmark for the jpeg job scheduler.
+ *
+ * Runs the real job manager (mm_jpeg.c) against a stub OMX core:
+ * every component takes a fixed setup time in EmptyThisBuffer and
+ * completes the encode asynchronously after a time proportional to
+ * the picture size, so jobs go through the same dispatch, lock
+ * drop and mm_jpegenc_job_done requeue as on target. The same job
+ * mix (a longshot burst, preview sized snapshots and a video
+ * snapshot stream) is run with a single job manager thread and
+ * with the worker pool.
+ *
+ * A stress pass then completes every encode from inside
+ * FillThisBuffer, so the handle is requeued while its worker is
+ * still dispatching, and destroys the session with jobs pending.
+ * The stub core counts calls that enter one component from two
+ * threads at once.
+ *
+ * usage: mm-jpeg-sched-bench [workers]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <time.h>
+#include <cutils/properties.h>
+#include "mm_jpeg_interface.h"
+#include "mm_jpeg.h"
+
+#define BENCH_MAX_SESSIONS 3
+#define BENCH_MAX_JOBS 256
+#define BENCH_SETUP_US 8000
+#define BENCH_PIXELS_PER_MS 200000
+#define BENCH_MAX_W 4160
+#define BENCH_MAX_H 3120
+#define BENCH_NUM_DST_BUFS 2
+#define BENCH_BUF_SIZE 4096
+#define BENCH_TIMEOUT_S 30
+#define BENCH_STRESS_JOBS 200
+#define BENCH_STRESS_DROP_JOBS 40
+#define BENCH_STRESS_HOLD_US 2000
+
+#define TEST_CHECK(cond) do { \
+  if (!(cond)) { \
+    printf("FAIL %s:%d %s\n", __func__, __LINE__, #cond); \
+    g_failures++; \
+  } \
+} while (0)
+
+/** bench_comp_t
+*  Stub OMX component
+*  @omx: handle returned by OMX_GetHandle
+*  @cb: mm_jpeg callbacks
+*  @app_data: session passed back with the callbacks
+*  @lock: protects the fields below
+*  @state: OMX state
+*  @ports: input, output and thumbnail port definitions
+*  @p_in: input buffer of the current job
+*  @tid: thread completing the current encode
+*  @tid_valid: @tid has to be joined
+*  @cancel: the current encode was flushed
+*  @in_call: number of threads inside the component
+**/
+typedef struct {
+  OMX_COMPONENTTYPE omx;
+  OMX_CALLBACKTYPE cb;
+  OMX_PTR app_data;
+  pthread_mutex_t lock;
+  OMX_STATETYPE state;
+  OMX_PARAM_PORTDEFINITIONTYPE ports[3];
+  OMX_BUFFERHEADERTYPE *p_in;
+  OMX_BUFFERHEADERTYPE *p_out;
+  pthread_t tid;
+  int tid_valid;
+  int cancel;
+  int in_call;
+} bench_comp_t;
+
+/** bench_job_t
+*  @session: session the job belongs to
+*  @width: picture width
+*  @height: picture height
+*  @delay_us: arrival time relative to the start of the run
+*  @job_id: id returned by start_job
+*  @submit_us: time the job was queued
+*  @done_us: time the encode completed
+**/
+typedef struct {
+  int session;
+  int width;
+  int height;
+  int64_t delay_us;
+  uint32_t job_id;
+  int64_t submit_us;
+  int64_t done_us;
+} bench_job_t;
+
+static bench_job_t g_jobs[BENCH_MAX_JOBS];
+static int g_num_jobs;
+/* completions in callback order, matched to the jobs after a run */
+static uint32_t g_done_ids[BENCH_MAX_JOBS * 2];
+static int64_t g_done_us[BENCH_MAX_JOBS * 2];
+static int g_num_done;
+static int g_num_errors;
+static pthread_mutex_t g_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t g_cond = PTHREAD_COND_INITIALIZER;
+
+/* complete encodes from inside FillThisBuffer */
+static int g_inline_done;
+static int g_overlaps;
+static int g_failures;
+
+static int64_t bench_now_us(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static bench_comp_t *bench_comp(OMX_HANDLETYPE handle)
+{
+  return (bench_comp_t *)((OMX_COMPONENTTYPE *)handle)->pComponentPrivate;
+}
+
+/* mm_jpeg serializes all calls into one handle */
+static void bench_comp_enter(bench_comp_t *p_comp)
+{
+  pthread_mutex_lock(&p_comp->lock);
+  if (p_comp->in_call++) {
+    pthread_mutex_lock(&g_lock);
+    g_overlaps++;
+    pthread_mutex_unlock(&g_lock);
+  }
+  pthread_mutex_unlock(&p_comp->lock);
+}
+
+static void bench_comp_leave(bench_comp_t *p_comp)
+{
+  pthread_mutex_lock(&p_comp->lock);
+  p_comp->in_call--;
+  pthread_mutex_unlock(&p_comp->lock);
+}
+
+static void bench_comp_done(bench_comp_t *p_comp)
+{
+  OMX_BUFFERHEADERTYPE *p_out = p_comp->p_out;
+
+  p_comp->cb.EmptyBufferDone(&p_comp->omx, p_comp->app_data, p_comp->p_in);
+  p_out->nFilledLen = p_out->nAllocLen / 2;
+  p_comp->cb.FillBufferDone(&p_comp->omx, p_comp->app_data, p_out);
+}
+
+static void *bench_comp_encode_thread(void *data)
+{
+  bench_comp_t *p_comp = (bench_comp_t *)data;
+  OMX_IMAGE_PORTDEFINITIONTYPE *p_img = &p_comp->ports[0].format.image;
+  int cancel;
+
+  usleep((useconds_t)((int64_t)p_img->nFrameWidth * p_img->nFrameHeight *
+    1000 / BENCH_PIXELS_PER_MS));
+  pthread_mutex_lock(&p_comp->lock);
+  cancel = p_comp->cancel;
+  pthread_mutex_unlock(&p_comp->lock);
+  if (!cancel) {
+    bench_comp_done(p_comp);
+  }
+  return NULL;
+}
+
+/* waits for the previous encode, flushing it if @cancel is set */
+static void bench_comp_join(bench_comp_t *p_comp, int cancel)
+{
+  pthread_mutex_lock(&p_comp->lock);
+  p_comp->cancel = cancel;
+  pthread_mutex_unlock(&p_comp->lock);
+  if (p_comp->tid_valid) {
+    pthread_join(p_comp->tid, NULL);
+    p_comp->tid_valid = 0;
+  }
+  p_comp->cancel = 0;
+}
+
+static OMX_ERRORTYPE bench_comp_send_command(OMX_HANDLETYPE handle,
+  OMX_COMMANDTYPE cmd, OMX_U32 param, OMX_PTR data)
+{
+  bench_comp_t *p_comp = bench_comp(handle);
+
+  bench_comp_enter(p_comp);
+  if (OMX_CommandStateSet == cmd) {
+    if (OMX_StateExecuting != param) {
+      bench_comp_join(p_comp, 1);
+    }
+    pthread_mutex_lock(&p_comp->lock);
+    p_comp->state = (OMX_STATETYPE)param;
+    pthread_mutex_unlock(&p_comp->lock);
+  }
+  p_comp->cb.EventHandler(handle, p_comp->app_data, OMX_EventCmdComplete,
+    cmd, param, NULL);
+  bench_comp_leave(p_comp);
+  return OMX_ErrorNone;
+}
+
+static OMX_ERRORTYPE bench_comp_get_parameter(OMX_HANDLETYPE handle,
+  OMX_INDEXTYPE index, OMX_PTR data)
+{
+  bench_comp_t *p_comp = bench_comp(handle);
+  OMX_PARAM_PORTDEFINITIONTYPE *p_def = (OMX_PARAM_PORTDEFINITIONTYPE *)data;
+
+  bench_comp_enter(p_comp);
+  if ((OMX_IndexParamPortDefinition == index) && (p_def->nPortIndex < 3)) {
+    *p_def = p_comp->ports[p_def->nPortIndex];
+  }
+  bench_comp_leave(p_comp);
+  return OMX_ErrorNone;
+}
+
+static OMX_ERRORTYPE bench_comp_set_parameter(OMX_HANDLETYPE handle,
+  OMX_INDEXTYPE index, OMX_PTR data)
+{
+  bench_comp_t *p_comp = bench_comp(handle);
+  OMX_PARAM_PORTDEFINITIONTYPE *p_def = (OMX_PARAM_PORTDEFINITIONTYPE *)data;
+
+  bench_comp_enter(p_comp);
+  if ((OMX_IndexParamPortDefinition == index) && (p_def->nPortIndex < 3)) {
+    p_comp->ports[p_def->nPortIndex] = *p_def;
+  }
+  bench_comp_leave(p_comp);
+  return OMX_ErrorNone;
+}
+
+static OMX_ERRORTYPE bench_comp_config(OMX_HANDLETYPE handle,
+  OMX_INDEXTYPE index, OMX_PTR data)
+{
+  bench_comp_t *p_comp = bench_comp(handle);
+
+  bench_comp_enter(p_comp);
+  bench_comp_leave(p_comp);
+  return OMX_ErrorNone;
+}
+
+static OMX_ERRORTYPE bench_comp_get_extension_index(OMX_HANDLETYPE handle,
+  OMX_STRING name, OMX_INDEXTYPE *p_index)
+{
+  bench_comp_t *p_comp = bench_comp(handle);
+
+  bench_comp_enter(p_comp);
+  *p_index = OMX_IndexVendorStartUnused;
+  bench_comp_leave(p_comp);
+  return OMX_ErrorNone;
+}
+
+static OMX_ERRORTYPE bench_comp_get_state(OMX_HANDLETYPE handle,
+  OMX_STATETYPE *p_state)
+{
+  bench_comp_t *p_comp = bench_comp(handle);
+
+  pthread_mutex_lock(&p_comp->lock);
+  *p_state = p_comp->state;
+  pthread_mutex_unlock(&p_comp->lock);
+  return OMX_ErrorNone;
+}
+
+static OMX_ERRORTYPE bench_comp_use_buffer(OMX_HANDLETYPE handle,
+  OMX_BUFFERHEADERTYPE **pp_buf, OMX_U32 port, OMX_PTR app_private,
+  OMX_U32 size, OMX_U8 *p_data)
+{
+  bench_comp_t *p_comp = bench_comp(handle);
+  OMX_BUFFERHEADERTYPE *p_buf;
+
+  bench_comp_enter(p_comp);
+  p_buf = (OMX_BUFFERHEADERTYPE *)calloc(1, sizeof(*p_buf));
+  if (NULL != p_buf) {
+    p_buf->nSize = sizeof(*p_buf);
+    p_buf->pBuffer = p_data;
+    p_buf->nAllocLen = size;
+    p_buf->pAppPrivate = app_private;
+    p_buf->nInputPortIndex = port;
+    p_buf->nOutputPortIndex = port;
+  }
+  *pp_buf = p_buf;
+  bench_comp_leave(p_comp);
+  return p_buf ? OMX_ErrorNone : OMX_ErrorInsufficientResources;
+}
+
+static OMX_ERRORTYPE bench_comp_free_buffer(OMX_HANDLETYPE handle,
+  OMX_U32 port, OMX_BUFFERHEADERTYPE *p_buf)
+{
+  bench_comp_t *p_comp = bench_comp(handle);
+
+  bench_comp_enter(p_comp);
+  free(p_buf);
+  bench_comp_leave(p_comp);
+  return OMX_ErrorNone;
+}
+
+static OMX_ERRORTYPE bench_comp_empty_this_buffer(OMX_HANDLETYPE handle,
+  OMX_BUFFERHEADERTYPE *p_buf)
+{
+  bench_comp_t *p_comp = bench_comp(handle);
+
+  bench_comp_enter(p_comp);
+  p_comp->p_in = p_buf;
+  usleep(BENCH_SETUP_US);
+  bench_comp_leave(p_comp);
+  return OMX_ErrorNone;
+}
+
+static OMX_ERRORTYPE bench_comp_fill_this_buffer(OMX_HANDLETYPE handle,
+  OMX_BUFFERHEADERTYPE *p_buf)
+{
+  bench_comp_t *p_comp = bench_comp(handle);
+  OMX_ERRORTYPE ret = OMX_ErrorNone;
+
+  bench_comp_enter(p_comp);
+  bench_comp_join(p_comp, 0);
+  p_comp->p_out = p_buf;
+  if (g_inline_done) {
+    /* the handle is requeued before this worker retakes job_lock */
+    bench_comp_done(p_comp);
+    usleep(BENCH_STRESS_HOLD_US);
+  } else if (pthread_create(&p_comp->tid, NULL, bench_comp_encode_thread,
+    p_comp)) {
+    ret = OMX_ErrorInsufficientResources;
+  } else {
+    p_comp->tid_valid = 1;
+  }
+  bench_comp_leave(p_comp);
+  return ret;
+}
+
+static OMX_ERRORTYPE bench_comp_set_callbacks(OMX_HANDLETYPE handle,
+  OMX_CALLBACKTYPE *p_cb, OMX_PTR app_data)
+{
+  bench_comp_t *p_comp = bench_comp(handle);
+
+  p_comp->cb = *p_cb;
+  p_comp->app_data = app_data;
+  return OMX_ErrorNone;
+}
+
+OMX_API OMX_ERRORTYPE OMX_APIENTRY OMX_Init()
+{
+  return OMX_ErrorNone;
+}
+
+OMX_API OMX_ERRORTYPE OMX_APIENTRY OMX_Deinit()
+{
+  return OMX_ErrorNone;
+}
+
+OMX_API OMX_ERRORTYPE OMX_APIENTRY OMX_GetHandle(
+  OMX_OUT OMX_HANDLETYPE* handle,
+  OMX_IN OMX_STRING componentName,
+  OMX_IN OMX_PTR appData,
+  OMX_IN OMX_CALLBACKTYPE* callBacks)
+{
+  bench_comp_t *p_comp = (bench_comp_t *)calloc(1, sizeof(*p_comp));
+  OMX_COMPONENTTYPE *p_omx;
+  uint32_t i;
+
+  if (NULL == p_comp) {
+    return OMX_ErrorInsufficientResources;
+  }
+  pthread_mutex_init(&p_comp->lock, NULL);
+  p_comp->state = OMX_StateLoaded;
+  for (i = 0; i < 3; i++) {
+    p_comp->ports[i].nSize = sizeof(p_comp->ports[i]);
+    p_comp->ports[i].nPortIndex = i;
+    p_comp->ports[i].nBufferCountActual = 1;
+    p_comp->ports[i].bEnabled = OMX_TRUE;
+  }
+
+  p_omx = &p_comp->omx;
+  p_omx->nSize = sizeof(*p_omx);
+  p_omx->pComponentPrivate = p_comp;
+  p_omx->SendCommand = bench_comp_send_command;
+  p_omx->GetParameter = bench_comp_get_parameter;
+  p_omx->SetParameter = bench_comp_set_parameter;
+  p_omx->GetConfig = bench_comp_config;
+  p_omx->SetConfig = bench_comp_config;
+  p_omx->GetExtensionIndex = bench_comp_get_extension_index;
+  p_omx->GetState = bench_comp_get_state;
+  p_omx->UseBuffer = bench_comp_use_buffer;
+  p_omx->FreeBuffer = bench_comp_free_buffer;
+  p_omx->EmptyThisBuffer = bench_comp_empty_this_buffer;
+  p_omx->FillThisBuffer = bench_comp_fill_this_buffer;
+  p_omx->SetCallbacks = bench_comp_set_callbacks;
+  bench_comp_set_callbacks(p_omx, callBacks, appData);
+
+  *handle = p_omx;
+  return OMX_ErrorNone;
+}
+
+OMX_API OMX_ERRORTYPE OMX_APIENTRY OMX_FreeHandle(
+  OMX_IN OMX_HANDLETYPE hComp)
+{
+  bench_comp_t *p_comp = bench_comp(hComp);
+
+  bench_comp_enter(p_comp);
+  bench_comp_join(p_comp, 1);
+  bench_comp_leave(p_comp);
+  pthread_mutex_destroy(&p_comp->lock);
+  free(p_comp);
+  return OMX_ErrorNone;
+}
+
+/* work buffers come from the heap instead of ion */
+void *buffer_allocate(buffer_t *p_buffer, int cached)
+{
+  p_buffer->ion_fd = -1;
+  p_buffer->p_pmem_fd = -1;
+  p_buffer->addr = (uint8_t *)malloc(p_buffer->size);
+  return p_buffer->addr;
+}
+
+int buffer_deallocate(buffer_t *p_buffer)
+{
+  free(p_buffer->addr);
+  p_buffer->addr = NULL;
+  return 0;
+}
+
+int buffer_invalidate(buffer_t *p_buffer)
+{
+  return 0;
+}
+
+int32_t mm_jpegdec_process_decoding_job(mm_jpeg_obj *my_obj,
+  mm_jpeg_job_q_node_t* job_node)
+{
+  free(job_node);
+  return -1;
+}
+
+static void bench_jpeg_cb(jpeg_job_status_t status, uint32_t client_hdl,
+  uint32_t jobId, mm_jpeg_output_t *p_output, void *userData)
+{
+  pthread_mutex_lock(&g_lock);
+  if (g_num_done < BENCH_MAX_JOBS * 2) {
+    g_done_ids[g_num_done] = jobId;
+    g_done_us[g_num_done] = bench_now_us();
+  }
+  g_num_done++;
+  if (JPEG_JOB_STATUS_DONE != status) {
+    g_num_errors++;
+  }
+  pthread_cond_broadcast(&g_cond);
+  pthread_mutex_unlock(&g_lock);
+}
+
+static void bench_add(int session, int width, int height, int64_t delay_us)
+{
+  bench_job_t *p_job = &g_jobs[g_num_jobs++];
+
+  memset(p_job, 0, sizeof(*p_job));
+  p_job->session = session;
+  p_job->width = width;
+  p_job->height = height;
+  p_job->delay_us = delay_us;
+}
+
+/** bench_create_session:
+ *
+ *  Arguments:
+ *    @p_ops: jpeg ops
+ *    @client: client handle
+ *    @width: picture width
+ *    @height: picture height
+ *    @burst: use MM_JPEG_CONCURRENT_SESSIONS_COUNT handles
+ *    @p_bufs: backing store for the session buffers
+ *
+ *  Return:
+ *       session id, 0 on failure
+ *
+ **/
+static uint32_t bench_create_session(mm_jpeg_ops_t *p_ops, uint32_t client,
+  int width, int height, int burst, uint8_t *p_bufs)
+{
+  mm_jpeg_encode_params_t params;
+  uint32_t session_id = 0;
+  int i;
+
+  memset(&params, 0, sizeof(params));
+  params.num_src_bufs = 1;
+  params.src_main_buf[0].buf_vaddr = p_bufs;
+  params.src_main_buf[0].buf_size = BENCH_BUF_SIZE;
+  params.src_main_buf[0].offset.mp[0].stride = width;
+  params.src_main_buf[0].offset.mp[0].scanline = height;
+  params.num_dst_bufs = BENCH_NUM_DST_BUFS;
+  for (i = 0; i < BENCH_NUM_DST_BUFS; i++) {
+    params.dest_buf[i].buf_vaddr = p_bufs + (i + 1) * BENCH_BUF_SIZE;
+    params.dest_buf[i].buf_size = BENCH_BUF_SIZE;
+  }
+  params.color_format = MM_JPEG_COLOR_FORMAT_YCRCBLP_H2V2;
+  params.quality = 85;
+  params.jpeg_cb = bench_jpeg_cb;
+  params.main_dim.src_dim.width = width;
+  params.main_dim.src_dim.height = height;
+  params.main_dim.dst_dim = params.main_dim.src_dim;
+  params.burst_mode = (int8_t)burst;
+
+  if (p_ops->create_session(client, &params, &session_id)) {
+    return 0;
+  }
+  return session_id;
+}
+
+/* queues @p_job on @session_id */
+static int bench_start_job(mm_jpeg_ops_t *p_ops, uint32_t session_id,
+  bench_job_t *p_job)
+{
+  mm_jpeg_job_t job;
+
+  memset(&job, 0, sizeof(job));
+  job.job_type = JPEG_JOB_TYPE_ENCODE;
+  job.encode_job.session_id = session_id;
+  job.encode_job.src_index = 0;
+  job.encode_job.dst_index = -1;
+  job.encode_job.main_dim.src_dim.width = p_job->width;
+  job.encode_job.main_dim.src_dim.height = p_job->height;
+  job.encode_job.main_dim.dst_dim = job.encode_job.main_dim.src_dim;
+
+  p_job->submit_us = bench_now_us();
+  p_job->done_us = 0;
+  return p_ops->start_job(&job, &p_job->job_id);
+}
+
+/* fills in the completion time of every finished job */
+static void bench_match_done(void)
+{
+  int i, j;
+
+  pthread_mutex_lock(&g_lock);
+  for (i = 0; i < g_num_jobs; i++) {
+    for (j = 0; j < g_num_done; j++) {
+      if (g_done_ids[j] == g_jobs[i].job_id) {
+        g_jobs[i].done_us = g_done_us[j];
+        break;
+      }
+    }
+  }
+  pthread_mutex_unlock(&g_lock);
+}
+
+/* waits until @count jobs completed, returns 0 on timeout */
+static int bench_wait_done(int count)
+{
+  struct timespec ts;
+  int rc = 0;
+
+  clock_gettime(CLOCK_REALTIME, &ts);
+  ts.tv_sec += BENCH_TIMEOUT_S;
+  pthread_mutex_lock(&g_lock);
+  while ((g_num_done < count) && !rc) {
+    rc = pthread_cond_timedwait(&g_cond, &g_lock, &ts);
+  }
+  rc = (g_num_done >= count);
+  pthread_mutex_unlock(&g_lock);
+  return rc;
+}
+
+static uint32_t bench_open(mm_jpeg_ops_t *p_ops, int num_workers)
+{
+  mm_dimension max_size;
+  char prop[PROPERTY_VALUE_MAX];
+
+  /* the worker count is read when the first client opens */
+  snprintf(prop, sizeof(prop), "%d", num_workers);
+  property_set("persist.camera.jpeg.workers", prop);
+  max_size.w = BENCH_MAX_W;
+  max_size.h = BENCH_MAX_H;
+  memset(p_ops, 0, sizeof(*p_ops));
+  return jpeg_open(p_ops, max_size);
+}
+
+static int bench_cmp(const void *a, const void *b)
+{
+  int64_t x = *(const int64_t *)a, y = *(const int64_t *)b;
+  return (x > y) - (x < y);
+}
+
+/** bench_run:
+ *
+ *  Arguments:
+ *    @num_workers: job manager threads
+ *
+ *  Return:
+ *       none
+ *
+ *  Description:
+ *       Submit the job mix on time, wait for completion and print
+ *       the makespan and per session latencies
+ *
+ **/
+static void bench_run(int num_workers)
+{
+  static const char *names[BENCH_MAX_SESSIONS] =
+    { "longshot 13MP", "snapshot 1080p", "video snap 720p" };
+  static const int dims[BENCH_MAX_SESSIONS][2] =
+    { { 4160, 3120 }, { 1920, 1080 }, { 1280, 720 } };
+  static uint8_t bufs[BENCH_MAX_SESSIONS][(BENCH_NUM_DST_BUFS + 1) *
+    BENCH_BUF_SIZE];
+  uint32_t sessions[BENCH_MAX_SESSIONS];
+  int64_t lat[BENCH_MAX_JOBS], sum, end = 0, t0;
+  mm_jpeg_ops_t ops;
+  uint32_t client;
+  bench_job_t *p_job;
+  int i, s, n;
+
+  client = bench_open(&ops, num_workers);
+  TEST_CHECK(client > 0);
+  if (0 == client) {
+    return;
+  }
+  for (s = 0; s < BENCH_MAX_SESSIONS; s++) {
+    sessions[s] = bench_create_session(&ops, client, dims[s][0], dims[s][1],
+      0 == s, bufs[s]);
+    TEST_CHECK(sessions[s] > 0);
+  }
+
+  g_num_done = 0;
+  g_num_errors = 0;
+  t0 = bench_now_us();
+  for (i = 0; i < g_num_jobs; i++) {
+    p_job = &g_jobs[i];
+    while (bench_now_us() - t0 < p_job->delay_us) {
+      usleep((useconds_t)(p_job->delay_us - (bench_now_us() - t0)));
+    }
+    TEST_CHECK(0 == bench_start_job(&ops, sessions[p_job->session], p_job));
+  }
+  TEST_CHECK(bench_wait_done(g_num_jobs));
+  TEST_CHECK(0 == g_num_errors);
+  bench_match_done();
+
+  printf("%d worker%s\n", num_workers, (num_workers > 1) ? "s" : "");
+  for (s = 0; s < BENCH_MAX_SESSIONS; s++) {
+    n = 0;
+    sum = 0;
+    for (i = 0; i < g_num_jobs; i++) {
+      if (g_jobs[i].session == s) {
+        lat[n] = g_jobs[i].done_us - g_jobs[i].submit_us;
+        sum += lat[n++];
+      }
+      if (g_jobs[i].done_us - t0 > end) {
+        end = g_jobs[i].done_us - t0;
+      }
+    }
+    qsort(lat, (size_t)n, sizeof(lat[0]), bench_cmp);
+    printf("  %-16s %3d jobs  mean %6.1f ms  p95 %6.1f ms  max %6.1f ms\n",
+      names[s], n, (double)sum / n / 1000.0,
+      (double)lat[(n * 95) / 100 < n ? (n * 95) / 100 : n - 1] / 1000.0,
+      (double)lat[n - 1] / 1000.0);
+  }
+  printf("  makespan %.1f ms\n", (double)end / 1000.0);
+
+  for (s = 0; s < BENCH_MAX_SESSIONS; s++) {
+    ops.destroy_session(sessions[s]);
+  }
+  ops.close(client);
+}
+
+/** bench_stress:
+ *
+ *  Arguments:
+ *    @num_workers: job manager threads
+ *
+ *  Return:
+ *       none
+ *
+ *  Description:
+ *       Complete every encode before FillThisBuffer returns, so
+ *       mm_jpegenc_job_done requeues the handle while its worker
+ *       still dispatches, then destroy the session with jobs
+ *       queued and in flight. No component may be entered by two
+ *       threads.
+ *
+ **/
+static void bench_stress(int num_workers)
+{
+  static uint8_t bufs[(BENCH_NUM_DST_BUFS + 1) * BENCH_BUF_SIZE];
+  mm_jpeg_ops_t ops;
+  uint32_t client, session;
+  int i;
+
+  client = bench_open(&ops, num_workers);
+  TEST_CHECK(client > 0);
+  if (0 == client) {
+    return;
+  }
+  session = bench_create_session(&ops, client, 640, 480, 0, bufs);
+  TEST_CHECK(session > 0);
+
+  g_inline_done = 1;
+  g_overlaps = 0;
+  g_num_done = 0;
+  g_num_errors = 0;
+  g_num_jobs = 0;
+  for (i = 0; i < BENCH_STRESS_JOBS; i++) {
+    bench_add(0, 640, 480, 0);
+  }
+  for (i = 0; i < g_num_jobs; i++) {
+    TEST_CHECK(0 == bench_start_job(&ops, session, &g_jobs[i]));
+  }
+  TEST_CHECK(bench_wait_done(BENCH_STRESS_JOBS));
+  TEST_CHECK(0 == g_num_errors);
+
+  /* destroy while jobs are queued, dispatched and encoding; the
+   * encodes complete asynchronously again so that the worker
+   * leaves the session between jobs */
+  g_inline_done = 0;
+  g_num_jobs = 0;
+  for (i = 0; i < BENCH_STRESS_DROP_JOBS; i++) {
+    bench_add(0, 640, 480, 0);
+  }
+  for (i = 0; i < g_num_jobs; i++) {
+    TEST_CHECK(0 == bench_start_job(&ops, session, &g_jobs[i]));
+  }
+  usleep(BENCH_STRESS_HOLD_US * 4);
+  ops.destroy_session(session);
+  ops.close(client);
+
+  printf("requeue stress (%d workers): %d jobs, %d dropped on destroy, "
+    "%d overlapping calls\n", num_workers, BENCH_STRESS_JOBS,
+    BENCH_STRESS_JOBS + BENCH_STRESS_DROP_JOBS - g_num_done, g_overlaps);
+  TEST_CHECK(0 == g_overlaps);
+}
+
+int main(int argc, char **argv)
+{
+  int workers = (argc > 1) ? atoi(argv[1]) : 2;
+  int i;
+
+  if ((workers < 1) || (workers > MM_JPEG_MAX_JOB_THREADS)) {
+    workers = 2;
+  }
+
+  /* longshot burst, 12 shots 30 ms apart */
+  for (i = 0; i < 12; i++) {
+    bench_add(0, 4160, 3120, i * 30000);
+  }
+  /* preview sized snapshots every 40 ms */
+  for (i = 0; i < 16; i++) {
+    bench_add(1, 1920, 1080, 5000 + i * 40000);
+  }
+  /* video snapshots */
+  for (i = 0; i < 6; i++) {
+    bench_add(2, 1280, 720, 10000 + i * 100000);
+  }
+  /* submit in arrival order */
+  for (i = 1; i < g_num_jobs; i++) {
+    bench_job_t t = g_jobs[i];
+    int j = i - 1;
+    while ((j >= 0) && (g_jobs[j].delay_us > t.delay_us)) {
+      g_jobs[j + 1] = g_jobs[j];
+      j--;
+    }
+    g_jobs[j + 1] = t;
+  }
+
+  bench_run(1);
+  bench_run(workers);
+  bench_stress((workers > 1) ? workers : 2);
+
+  printf("%s: %d failures\n", g_failures ? "FAIL" : "PASS", g_failures);
+  return g_failures ? 1 : 0;
+}
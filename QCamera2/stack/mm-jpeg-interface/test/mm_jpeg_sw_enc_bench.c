@@ -0,0 +1,339 @@
+/* Copyright (c) 2014, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+/* Encode throughput benchmark for the software jpeg encoder.
+ *
+ * Loads "OMX.qcom.image.jpeg.encoder_sw" through qomx_core the same
+ * way mm_jpeg_session_create does, and encodes a synthetic NV21
+ * frame at preview, 1080p and 13MP sizes with 1, 2 and 4 slice
+ * threads. Every output is checked for SOI/EOI and, when more than
+ * one thread is used, for restart markers between the slices.
+ * Reports the time per frame and the throughput in MPix/s.
+ *
+ * usage: mm-jpeg-sw-enc-bench [frames] [max_threads]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <time.h>
+#include <cutils/properties.h>
+#include "OMX_Types.h"
+#include "OMX_Index.h"
+#include "OMX_Core.h"
+#include "OMX_Component.h"
+#include "QOMX_JpegExtensions.h"
+
+#define BENCH_COMP_NAME "OMX.qcom.image.jpeg.encoder_sw"
+#define BENCH_THREADS_PROP "persist.camera.jpeg.sw_threads"
+#define BENCH_QUALITY 85
+#define BENCH_TIMEOUT_S 10
+
+#define TEST_CHECK(cond) do { \
+  if (!(cond)) { \
+    printf("FAIL %s:%d %s\n", __func__, __LINE__, #cond); \
+    g_failures++; \
+  } \
+} while (0)
+
+static int g_failures;
+
+/** bench_ctx_t
+*  Client side of one component instance
+*  @lock: protects the fields below
+*  @cond: signalled on every callback
+*  @cmd_done: number of completed commands
+*  @fbd: number of filled output buffers
+*  @error: last error reported by the component
+*  @filled: length of the last output
+**/
+typedef struct {
+  pthread_mutex_t lock;
+  pthread_cond_t cond;
+  int cmd_done;
+  int fbd;
+  OMX_U32 error;
+  OMX_U32 filled;
+} bench_ctx_t;
+
+static int64_t bench_now_us(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static OMX_ERRORTYPE bench_event(OMX_HANDLETYPE handle, OMX_PTR app_data,
+  OMX_EVENTTYPE event, OMX_U32 data1, OMX_U32 data2, OMX_PTR event_data)
+{
+  bench_ctx_t *p_ctx = (bench_ctx_t *)app_data;
+
+  pthread_mutex_lock(&p_ctx->lock);
+  if (OMX_EventCmdComplete == event) {
+    p_ctx->cmd_done++;
+  } else if (OMX_EventError == event) {
+    p_ctx->error = data1;
+  }
+  pthread_cond_broadcast(&p_ctx->cond);
+  pthread_mutex_unlock(&p_ctx->lock);
+  return OMX_ErrorNone;
+}
+
+static OMX_ERRORTYPE bench_ebd(OMX_HANDLETYPE handle, OMX_PTR app_data,
+  OMX_BUFFERHEADERTYPE *p_buf)
+{
+  return OMX_ErrorNone;
+}
+
+static OMX_ERRORTYPE bench_fbd(OMX_HANDLETYPE handle, OMX_PTR app_data,
+  OMX_BUFFERHEADERTYPE *p_buf)
+{
+  bench_ctx_t *p_ctx = (bench_ctx_t *)app_data;
+
+  pthread_mutex_lock(&p_ctx->lock);
+  p_ctx->fbd++;
+  p_ctx->filled = p_buf->nFilledLen;
+  pthread_cond_broadcast(&p_ctx->cond);
+  pthread_mutex_unlock(&p_ctx->lock);
+  return OMX_ErrorNone;
+}
+
+/* waits until *p_count reaches target, returns 0 on error or timeout */
+static int bench_wait(bench_ctx_t *p_ctx, int *p_count, int target)
+{
+  struct timespec ts;
+  int rc = 0;
+
+  clock_gettime(CLOCK_REALTIME, &ts);
+  ts.tv_sec += BENCH_TIMEOUT_S;
+  pthread_mutex_lock(&p_ctx->lock);
+  while ((*p_count < target) && !p_ctx->error && !rc) {
+    rc = pthread_cond_timedwait(&p_ctx->cond, &p_ctx->lock, &ts);
+  }
+  rc = (*p_count >= target) && !p_ctx->error;
+  pthread_mutex_unlock(&p_ctx->lock);
+  return rc;
+}
+
+/* gradient with a checker pattern, roughly the entropy of a photo */
+static void bench_fill(uint8_t *p_buf, uint32_t width, uint32_t height,
+  uint32_t stride, uint32_t scanline)
+{
+  uint8_t *p_uv = p_buf + stride * scanline;
+  uint32_t x, y;
+
+  for (y = 0; y < height; y++) {
+    for (x = 0; x < width; x++) {
+      uint32_t v = (x * 255 / width + y * 128 / height) & 0xff;
+      if (((x >> 6) + (y >> 6)) & 1) {
+        v = 255 - v;
+      }
+      if ((x > width / 2) && (y > height / 2)) {
+        v = ((x ^ y) & 8) ? 230 : 30;
+      }
+      p_buf[y * stride + x] = (uint8_t)v;
+    }
+  }
+  for (y = 0; y < height / 2; y++) {
+    for (x = 0; x < width / 2; x++) {
+      p_uv[y * stride + 2 * x] = (uint8_t)(78 + y * 200 / height);
+      p_uv[y * stride + 2 * x + 1] = (uint8_t)(78 + x * 200 / width);
+    }
+  }
+}
+
+static uint32_t bench_count_rst(const uint8_t *p_buf, uint32_t len)
+{
+  uint32_t i, cnt = 0;
+
+  for (i = 0; i + 1 < len; i++) {
+    if ((0xff == p_buf[i]) && (p_buf[i + 1] >= 0xd0) &&
+      (p_buf[i + 1] <= 0xd7)) {
+      cnt++;
+    }
+  }
+  return cnt;
+}
+
+/** bench_run:
+*  Encodes @frames frames of @width x @height with @threads slice
+*  threads and prints the throughput
+**/
+static void bench_run(uint32_t width, uint32_t height, int threads,
+  int frames)
+{
+  bench_ctx_t ctx;
+  OMX_CALLBACKTYPE callbacks = { bench_event, bench_ebd, bench_fbd };
+  OMX_HANDLETYPE handle = NULL;
+  OMX_PARAM_PORTDEFINITIONTYPE def;
+  OMX_IMAGE_PARAM_QFACTORTYPE qfactor;
+  OMX_INDEXTYPE offset_idx;
+  QOMX_YUV_FRAME_INFO offset;
+  QOMX_BUFFER_INFO buf_info;
+  OMX_BUFFERHEADERTYPE *p_in = NULL, *p_out = NULL;
+  uint32_t stride = (width + 31) & ~31U;
+  uint32_t scanline = (height + 15) & ~15U;
+  uint32_t in_size = stride * scanline * 3 / 2;
+  uint32_t out_size = width * height * 3 / 2 + 4096;
+  uint8_t *p_in_buf = malloc(in_size);
+  uint8_t *p_out_buf = malloc(out_size);
+  char prop[PROPERTY_VALUE_MAX];
+  int64_t start, elapsed;
+  uint32_t p, rst;
+  int i;
+
+  if (!p_in_buf || !p_out_buf) {
+    TEST_CHECK(0);
+    goto out;
+  }
+  bench_fill(p_in_buf, width, height, stride, scanline);
+  memset(&ctx, 0, sizeof(ctx));
+  pthread_mutex_init(&ctx.lock, NULL);
+  pthread_cond_init(&ctx.cond, NULL);
+
+  /* the component reads its thread count when it is created */
+  snprintf(prop, sizeof(prop), "%d", threads);
+  property_set(BENCH_THREADS_PROP, prop);
+  if (OMX_GetHandle(&handle, (OMX_STRING)BENCH_COMP_NAME, &ctx,
+    &callbacks) || !handle) {
+    printf("cannot load %s\n", BENCH_COMP_NAME);
+    TEST_CHECK(0);
+    goto destroy;
+  }
+
+  for (p = 0; p < 2; p++) {
+    memset(&def, 0, sizeof(def));
+    def.nPortIndex = p;
+    OMX_GetParameter(handle, OMX_IndexParamPortDefinition, &def);
+    def.format.image.nFrameWidth = width;
+    def.format.image.nFrameHeight = height;
+    def.format.image.nStride = (OMX_S32)stride;
+    def.format.image.nSliceHeight = scanline;
+    def.format.image.eColorFormat =
+      (OMX_COLOR_FORMATTYPE)OMX_QCOM_IMG_COLOR_FormatYVU420SemiPlanar;
+    def.nBufferSize = p ? out_size : in_size;
+    def.nBufferCountActual = 1;
+    TEST_CHECK(OMX_ErrorNone == OMX_SetParameter(handle,
+      OMX_IndexParamPortDefinition, &def));
+  }
+  memset(&offset, 0, sizeof(offset));
+  offset.cbcrStartOffset[0] = stride * scanline;
+  OMX_GetExtensionIndex(handle, (OMX_STRING)QOMX_IMAGE_EXT_BUFFER_OFFSET_NAME,
+    &offset_idx);
+  OMX_SetParameter(handle, offset_idx, &offset);
+  memset(&qfactor, 0, sizeof(qfactor));
+  qfactor.nPortIndex = 0;
+  qfactor.nQFactor = BENCH_QUALITY;
+  OMX_SetParameter(handle, OMX_IndexParamQFactor, &qfactor);
+
+  OMX_SendCommand(handle, OMX_CommandPortDisable, 2, NULL);
+  OMX_SendCommand(handle, OMX_CommandStateSet, OMX_StateIdle, NULL);
+  memset(&buf_info, 0, sizeof(buf_info));
+  OMX_UseBuffer(handle, &p_in, 0, &buf_info, in_size, p_in_buf);
+  OMX_UseBuffer(handle, &p_out, 1, &buf_info, out_size, p_out_buf);
+  TEST_CHECK(bench_wait(&ctx, &ctx.cmd_done, 2));
+  OMX_SendCommand(handle, OMX_CommandStateSet, OMX_StateExecuting, NULL);
+  TEST_CHECK(bench_wait(&ctx, &ctx.cmd_done, 3));
+
+  /* the first frame warms up the caches and the slice buffers */
+  start = 0;
+  for (i = 0; i <= frames; i++) {
+    if (1 == i) {
+      start = bench_now_us();
+    }
+    OMX_EmptyThisBuffer(handle, p_in);
+    OMX_FillThisBuffer(handle, p_out);
+    if (!bench_wait(&ctx, &ctx.fbd, i + 1)) {
+      printf("encode failed, error 0x%x\n", ctx.error);
+      TEST_CHECK(0);
+      break;
+    }
+  }
+  elapsed = bench_now_us() - start;
+
+  if (i > frames) {
+    TEST_CHECK(ctx.filled > 4);
+    TEST_CHECK((0xff == p_out_buf[0]) && (0xd8 == p_out_buf[1]));
+    TEST_CHECK((0xff == p_out_buf[ctx.filled - 2]) &&
+      (0xd9 == p_out_buf[ctx.filled - 1]));
+    rst = bench_count_rst(p_out_buf, ctx.filled);
+    if (threads > 1) {
+      TEST_CHECK(rst > 0);
+    }
+    printf("  %4ux%-4u %d thread%s  %7.2f ms/frame  %6.1f MPix/s  "
+      "%7u bytes  %3u RST\n", width, height, threads,
+      (threads > 1) ? "s" : " ", (double)elapsed / 1000.0 / frames,
+      (double)width * height * frames / (double)elapsed, ctx.filled, rst);
+  }
+
+  OMX_SendCommand(handle, OMX_CommandStateSet, OMX_StateIdle, NULL);
+  TEST_CHECK(bench_wait(&ctx, &ctx.cmd_done, 4));
+  OMX_SendCommand(handle, OMX_CommandStateSet, OMX_StateLoaded, NULL);
+  OMX_FreeBuffer(handle, 0, p_in);
+  OMX_FreeBuffer(handle, 1, p_out);
+  TEST_CHECK(bench_wait(&ctx, &ctx.cmd_done, 5));
+  OMX_FreeHandle(handle);
+
+destroy:
+  pthread_mutex_destroy(&ctx.lock);
+  pthread_cond_destroy(&ctx.cond);
+out:
+  free(p_in_buf);
+  free(p_out_buf);
+}
+
+int main(int argc, char *argv[])
+{
+  static const uint32_t sizes[][2] = {
+    { 640, 480 }, { 1920, 1080 }, { 4160, 3120 },
+  };
+  int frames = (argc > 1) ? atoi(argv[1]) : 10;
+  int max_threads = (argc > 2) ? atoi(argv[2]) : 4;
+  uint32_t s;
+  int t;
+
+  if (frames <= 0) {
+    frames = 10;
+  }
+  if (OMX_ErrorNone != OMX_Init()) {
+    printf("OMX_Init failed\n");
+    return 1;
+  }
+  for (s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+    for (t = 1; t <= max_threads; t *= 2) {
+      bench_run(sizes[s][0], sizes[s][1], t, frames);
+    }
+  }
+  OMX_Deinit();
+
+  printf("%s: %d failures\n", g_failures ? "FAIL" : "PASS", g_failures);
+  return g_failures ? 1 : 0;
+}
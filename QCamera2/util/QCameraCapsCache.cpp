@@ -0,0 +1,382 @@
+/* Copyright (c) 2014, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <dlfcn.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <cutils/properties.h>
+#include <utils/Errors.h>
+#include <utils/Log.h>
+#include "QCameraCapsCache.h"
+
+using namespace android;
+
+namespace qcamera {
+
+#define QCAMERA_CACHE_MAGIC     0x51434343  /* "QCCC" */
+#define QCAMERA_CACHE_HASH_SEED 2166136261U
+#define QCAMERA_CACHE_MAX_SIZE  (16 * 1024 * 1024)
+
+// file header, followed by the blob itself. 32 bytes so the blob stays
+// 8 byte aligned in the mapping
+typedef struct {
+    uint32_t magic;
+    uint32_t version;     // QCAMERA_CACHE_VERSION
+    uint32_t type;        // qcamera_cache_blob_t
+    uint32_t camera_id;
+    uint32_t build_hash;  // build fingerprint and HAL library
+    uint32_t sensor_hash; // sensor name, facing and mount angle
+    uint32_t size;        // blob size in bytes
+    uint32_t checksum;    // hash of the blob
+} qcamera_cache_header_t;
+
+static const char *s_blobNames[QCAMERA_CACHE_MAX] =
+    { "hal1_caps", "hal3_caps", "hal3_meta" };
+
+/*===========================================================================
+ * FUNCTION   : QCameraCapsCache
+ *
+ * DESCRIPTION: constructor of QCameraCapsCache. Computes the keys every
+ *              cached blob of the camera is checked against.
+ *
+ * PARAMETERS :
+ *   @cameraId    : camera Id
+ *   @sensorName  : name of the sensor behind the camera, may be NULL
+ *   @facing      : camera facing reported by the backend
+ *   @orientation : sensor mount angle
+ *   @dir         : cache directory, NULL for QCAMERA_CACHE_DIR
+ *
+ * RETURN     : None
+ *==========================================================================*/
+QCameraCapsCache::QCameraCapsCache(uint32_t cameraId, const char *sensorName,
+        int32_t facing, int32_t orientation, const char *dir) :
+    m_cameraId(cameraId),
+    m_buildHash(0),
+    m_sensorHash(0),
+    m_bEnabled(false)
+{
+    char prop[PROPERTY_VALUE_MAX];
+    Dl_info info;
+    struct stat st;
+
+    strlcpy(m_dir, (dir != NULL) ? dir : QCAMERA_CACHE_DIR, sizeof(m_dir));
+
+    memset(prop, 0, sizeof(prop));
+    property_get("persist.camera.caps.cache", prop, "1");
+    m_bEnabled = (atoi(prop) != 0);
+
+    memset(prop, 0, sizeof(prop));
+    property_get("ro.build.fingerprint", prop, "");
+    m_buildHash = hash(prop, strlen(prop), QCAMERA_CACHE_HASH_SEED);
+    // a HAL pushed on top of a build keeps the fingerprint, key on the
+    // library file as well
+    memset(&info, 0, sizeof(info));
+    if ((dladdr((void *)s_blobNames, &info) != 0) &&
+            (info.dli_fname != NULL) && (stat(info.dli_fname, &st) == 0)) {
+        int64_t stamp[2];
+        stamp[0] = (int64_t)st.st_mtime;
+        stamp[1] = (int64_t)st.st_size;
+        m_buildHash = hash(stamp, sizeof(stamp), m_buildHash);
+    }
+
+    m_sensorHash = QCAMERA_CACHE_HASH_SEED;
+    if (sensorName != NULL) {
+        m_sensorHash = hash(sensorName, strlen(sensorName), m_sensorHash);
+    }
+    m_sensorHash = hash(&facing, sizeof(facing), m_sensorHash);
+    m_sensorHash = hash(&orientation, sizeof(orientation), m_sensorHash);
+}
+
+/*===========================================================================
+ * FUNCTION   : hash
+ *
+ * DESCRIPTION: 32 bit FNV-1a hash, used for the keys and as blob checksum
+ *
+ * PARAMETERS :
+ *   @data    : data to hash
+ *   @size    : size of data in bytes
+ *   @seed    : initial value, or the result of a previous call to chain
+ *
+ * RETURN     : hash value
+ *==========================================================================*/
+uint32_t QCameraCapsCache::hash(const void *data, size_t size, uint32_t seed)
+{
+    const uint8_t *p = (const uint8_t *)data;
+    uint32_t h = seed;
+
+    for (size_t i = 0; i < size; i++) {
+        h ^= p[i];
+        h *= 16777619U;
+    }
+    return h;
+}
+
+/*===========================================================================
+ * FUNCTION   : getPath
+ *
+ * DESCRIPTION: file holding a blob of this camera
+ *
+ * PARAMETERS :
+ *   @type    : blob type
+ *   @path    : buffer for the path
+ *   @len     : size of path
+ *
+ * RETURN     : None
+ *==========================================================================*/
+void QCameraCapsCache::getPath(qcamera_cache_blob_t type, char *path,
+        size_t len) const
+{
+    snprintf(path, len, "%s/%s_%u.bin", m_dir, s_blobNames[type], m_cameraId);
+}
+
+/*===========================================================================
+ * FUNCTION   : map
+ *
+ * DESCRIPTION: map a cached blob read only. A file that does not match
+ *              this build, sensor or its own checksum is deleted.
+ *
+ * PARAMETERS :
+ *   @type    : blob type
+ *   @size    : filled with the blob size
+ *
+ * RETURN     : blob to release with unmap, NULL if none is cached
+ *==========================================================================*/
+const void *QCameraCapsCache::map(qcamera_cache_blob_t type, size_t *size)
+{
+    char path[QCAMERA_CACHE_PATH_LEN];
+    const qcamera_cache_header_t *hdr;
+    struct stat st;
+    size_t fileSize;
+    void *base;
+    int fd;
+
+    if (!m_bEnabled || (type >= QCAMERA_CACHE_MAX) || (size == NULL)) {
+        return NULL;
+    }
+    getPath(type, path, sizeof(path));
+    fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return NULL;
+    }
+    if ((fstat(fd, &st) != 0) ||
+            (st.st_size < (off_t)sizeof(qcamera_cache_header_t)) ||
+            (st.st_size > (off_t)QCAMERA_CACHE_MAX_SIZE)) {
+        close(fd);
+        ALOGD("%s: Dropping %s, bad size", __func__, path);
+        unlink(path);
+        return NULL;
+    }
+    fileSize = (size_t)st.st_size;
+    base = mmap(NULL, fileSize, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED) {
+        ALOGE("%s: Cannot map %s: %s", __func__, path, strerror(errno));
+        return NULL;
+    }
+
+    hdr = (const qcamera_cache_header_t *)base;
+    if ((hdr->magic != QCAMERA_CACHE_MAGIC) ||
+            (hdr->version != QCAMERA_CACHE_VERSION) ||
+            (hdr->type != (uint32_t)type) ||
+            (hdr->camera_id != m_cameraId) ||
+            (hdr->build_hash != m_buildHash) ||
+            (hdr->sensor_hash != m_sensorHash) ||
+            (hdr->size != fileSize - sizeof(qcamera_cache_header_t)) ||
+            (hdr->checksum !=
+                hash(hdr + 1, hdr->size, QCAMERA_CACHE_HASH_SEED))) {
+        ALOGD("%s: Dropping stale %s", __func__, path);
+        munmap(base, fileSize);
+        unlink(path);
+        return NULL;
+    }
+
+    *size = hdr->size;
+    return hdr + 1;
+}
+
+/*===========================================================================
+ * FUNCTION   : unmap
+ *
+ * DESCRIPTION: release a blob returned by map
+ *
+ * PARAMETERS :
+ *   @data    : blob returned by map
+ *   @size    : blob size returned by map
+ *
+ * RETURN     : None
+ *==========================================================================*/
+void QCameraCapsCache::unmap(const void *data, size_t size)
+{
+    if (data != NULL) {
+        munmap((void *)((const qcamera_cache_header_t *)data - 1),
+               size + sizeof(qcamera_cache_header_t));
+    }
+}
+
+/*===========================================================================
+ * FUNCTION   : load
+ *
+ * DESCRIPTION: copy a fixed size cached blob. A blob of another size, left
+ *              by a build with a different structure layout, is deleted.
+ *
+ * PARAMETERS :
+ *   @type    : blob type
+ *   @dst     : buffer to copy the blob to
+ *   @size    : expected blob size
+ *
+ * RETURN     : int32_t type of status
+ *              NO_ERROR  -- success
+ *              none-zero failure code
+ *==========================================================================*/
+int32_t QCameraCapsCache::load(qcamera_cache_blob_t type, void *dst,
+        size_t size)
+{
+    const void *data;
+    size_t len = 0;
+
+    if (dst == NULL) {
+        return BAD_VALUE;
+    }
+    data = map(type, &len);
+    if (data == NULL) {
+        return NAME_NOT_FOUND;
+    }
+    if (len != size) {
+        char path[QCAMERA_CACHE_PATH_LEN];
+        unmap(data, len);
+        getPath(type, path, sizeof(path));
+        ALOGD("%s: Dropping %s, size %zu expected %zu",
+              __func__, path, len, size);
+        unlink(path);
+        return BAD_VALUE;
+    }
+    memcpy(dst, data, size);
+    unmap(data, len);
+    return NO_ERROR;
+}
+
+/*===========================================================================
+ * FUNCTION   : store
+ *
+ * DESCRIPTION: write a blob to the cache. The file is written under a
+ *              temporary name and renamed, a reader sees either the old
+ *              or the complete new blob.
+ *
+ * PARAMETERS :
+ *   @type    : blob type
+ *   @data    : blob to store
+ *   @size    : blob size
+ *
+ * RETURN     : int32_t type of status
+ *              NO_ERROR  -- success
+ *              none-zero failure code
+ *==========================================================================*/
+int32_t QCameraCapsCache::store(qcamera_cache_blob_t type, const void *data,
+        size_t size)
+{
+    char path[QCAMERA_CACHE_PATH_LEN];
+    char tmpPath[QCAMERA_CACHE_PATH_LEN + 4];
+    qcamera_cache_header_t hdr;
+    struct iovec iov[2];
+    ssize_t total;
+    int fd;
+
+    if (!m_bEnabled) {
+        return INVALID_OPERATION;
+    }
+    if ((type >= QCAMERA_CACHE_MAX) || (data == NULL) || (size == 0) ||
+            (size > QCAMERA_CACHE_MAX_SIZE - sizeof(hdr))) {
+        return BAD_VALUE;
+    }
+
+    memset(&hdr, 0, sizeof(hdr));
+    hdr.magic = QCAMERA_CACHE_MAGIC;
+    hdr.version = QCAMERA_CACHE_VERSION;
+    hdr.type = (uint32_t)type;
+    hdr.camera_id = m_cameraId;
+    hdr.build_hash = m_buildHash;
+    hdr.sensor_hash = m_sensorHash;
+    hdr.size = (uint32_t)size;
+    hdr.checksum = hash(data, size, QCAMERA_CACHE_HASH_SEED);
+
+    getPath(type, path, sizeof(path));
+    snprintf(tmpPath, sizeof(tmpPath), "%s.tmp", path);
+    fd = open(tmpPath, O_WRONLY | O_CREAT | O_TRUNC, 0660);
+    if (fd < 0) {
+        ALOGE("%s: Cannot create %s: %s", __func__, tmpPath, strerror(errno));
+        return UNKNOWN_ERROR;
+    }
+    iov[0].iov_base = &hdr;
+    iov[0].iov_len = sizeof(hdr);
+    iov[1].iov_base = (void *)data;
+    iov[1].iov_len = size;
+    total = writev(fd, iov, 2);
+    if ((total != (ssize_t)(sizeof(hdr) + size)) || (fsync(fd) != 0)) {
+        ALOGE("%s: Cannot write %s: %s", __func__, tmpPath, strerror(errno));
+        close(fd);
+        unlink(tmpPath);
+        return UNKNOWN_ERROR;
+    }
+    close(fd);
+    if (rename(tmpPath, path) != 0) {
+        ALOGE("%s: Cannot rename %s: %s", __func__, tmpPath, strerror(errno));
+        unlink(tmpPath);
+        return UNKNOWN_ERROR;
+    }
+    return NO_ERROR;
+}
+
+/*===========================================================================
+ * FUNCTION   : invalidate
+ *
+ * DESCRIPTION: delete all cached blobs of this camera
+ *
+ * PARAMETERS : None
+ *
+ * RETURN     : None
+ *==========================================================================*/
+void QCameraCapsCache::invalidate()
+{
+    char path[QCAMERA_CACHE_PATH_LEN];
+
+    for (int i = 0; i < QCAMERA_CACHE_MAX; i++) {
+        getPath((qcamera_cache_blob_t)i, path, sizeof(path));
+        unlink(path);
+    }
+}
+
+}; // namespace qcamera
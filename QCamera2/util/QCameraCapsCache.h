@@ -0,0 +1,86 @@
+/* Copyright (c) 2014, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#ifndef __QCAMERA_CAPS_CACHE_H__
+#define __QCAMERA_CAPS_CACHE_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace qcamera {
+
+#define QCAMERA_CACHE_DIR        "/data/misc/camera"
+#define QCAMERA_CACHE_VERSION    1
+#define QCAMERA_CACHE_DIR_LEN    96
+#define QCAMERA_CACHE_PATH_LEN   128
+
+// blobs kept in the cache, one file per camera and type
+typedef enum {
+    QCAMERA_CACHE_HAL1_CAPABILITY,   // cam_capability_t as queried by HAL1
+    QCAMERA_CACHE_HAL3_CAPABILITY,   // cam_capability_t as queried by HAL3
+    QCAMERA_CACHE_HAL3_STATIC_META,  // camera_metadata_t built from it
+    QCAMERA_CACHE_MAX
+} qcamera_cache_blob_t;
+
+// On-disk cache of what the HAL learns from the backend at first open
+// of a camera. Every file carries a header with the cache version, the
+// camera, a hash of the build fingerprint and a hash of the sensor
+// identity, so a blob written by another build or for another sensor
+// is dropped instead of used. Blobs are mapped read only straight from
+// the file.
+class QCameraCapsCache {
+public:
+    QCameraCapsCache(uint32_t cameraId, const char *sensorName,
+                     int32_t facing, int32_t orientation,
+                     const char *dir = NULL);
+    virtual ~QCameraCapsCache() {};
+
+    bool isEnabled() const { return m_bEnabled; }
+    int32_t load(qcamera_cache_blob_t type, void *dst, size_t size);
+    const void *map(qcamera_cache_blob_t type, size_t *size);
+    static void unmap(const void *data, size_t size);
+    int32_t store(qcamera_cache_blob_t type, const void *data, size_t size);
+    void invalidate();
+
+    static uint32_t hash(const void *data, size_t size, uint32_t seed);
+
+private:
+    void getPath(qcamera_cache_blob_t type, char *path, size_t len) const;
+
+    uint32_t m_cameraId;
+    uint32_t m_buildHash;
+    uint32_t m_sensorHash;
+    bool m_bEnabled;
+    char m_dir[QCAMERA_CACHE_DIR_LEN];
+};
+
+}; // namespace qcamera
+
+#endif /* __QCAMERA_CAPS_CACHE_H__ */
@@ -27,6 +27,12 @@
 *
 */
 
+#include <errno.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <linux/futex.h>
+#include <sys/syscall.h>
 #include <utils/Errors.h>
 #include <utils/Log.h>
 #include <sys/prctl.h>
@@ -36,6 +42,55 @@ using namespace android;
 
 namespace qcamera {
 
+static const uint32_t s_waitHistBounds[CMD_THREAD_WAIT_HIST_BUCKETS - 1] =
+    { 100, 500, 1000, 5000, 10000 };
+
+/*===========================================================================
+ * FUNCTION   : post
+ *
+ * DESCRIPTION: increment the semaphore and wake one waiter if any sleeps
+ *
+ * PARAMETERS : None
+ *
+ * RETURN     : None
+ *==========================================================================*/
+void QCameraCmdSem::post()
+{
+    __sync_fetch_and_add(&m_val, 1);
+    if (__sync_fetch_and_add(&m_waiters, 0) > 0) {
+        syscall(__NR_futex, &m_val, FUTEX_WAKE_PRIVATE, 1, NULL, NULL, 0);
+    }
+}
+
+/*===========================================================================
+ * FUNCTION   : wait
+ *
+ * DESCRIPTION: decrement the semaphore, sleeping while it is zero
+ *
+ * PARAMETERS : None
+ *
+ * RETURN     : 0, the wait can not fail
+ *==========================================================================*/
+int QCameraCmdSem::wait()
+{
+    while (true) {
+        int32_t val = __sync_fetch_and_add(&m_val, 0);
+        while (val > 0) {
+            if (__sync_bool_compare_and_swap(&m_val, val, val - 1)) {
+                return 0;
+            }
+            val = __sync_fetch_and_add(&m_val, 0);
+        }
+        // the kernel only puts us to sleep if no post landed since the
+        // value was read, a post that misses the waiter count is caught
+        // by the futex value check
+        __sync_fetch_and_add(&m_waiters, 1);
+        syscall(__NR_futex, &m_val, FUTEX_WAIT_PRIVATE, 0, NULL, NULL, 0);
+        __sync_fetch_and_sub(&m_waiters, 1);
+    }
+    return 0;
+}
+
 /*===========================================================================
  * FUNCTION   : QCameraCmdThread
  *
@@ -46,11 +101,14 @@ namespace qcamera {
  * RETURN     : None
  *==========================================================================*/
 QCameraCmdThread::QCameraCmdThread() :
-    cmd_queue()
+    m_head(0),
+    m_count(0)
 {
     cmd_pid = 0;
-    cam_sem_init(&sync_sem, 0);
-    cam_sem_init(&cmd_sem, 0);
+    pthread_mutex_init(&m_lock, NULL);
+    memset(m_ring, 0, sizeof(m_ring));
+    memset(&m_stats, 0, sizeof(m_stats));
+    strlcpy(m_name, "CAM_cmdThread", sizeof(m_name));
 }
 
 /*===========================================================================
@@ -64,8 +122,7 @@ QCameraCmdThread::QCameraCmdThread() :
  *==========================================================================*/
 QCameraCmdThread::~QCameraCmdThread()
 {
-    cam_sem_destroy(&sync_sem);
-    cam_sem_destroy(&cmd_sem);
+    pthread_mutex_destroy(&m_lock);
 }
 
 /*===========================================================================
@@ -108,13 +165,20 @@ int32_t QCameraCmdThread::setName(const char* name)
 {
     /* name the thread */
     prctl(PR_SET_NAME, (unsigned long)name, 0, 0, 0);
+    pthread_mutex_lock(&m_lock);
+    strlcpy(m_name, name, sizeof(m_name));
+    pthread_mutex_unlock(&m_lock);
     return NO_ERROR;
 }
 
 /*===========================================================================
  * FUNCTION   : sendCmd
  *
- * DESCRIPTION: send a command to the Cmd Thread
+ * DESCRIPTION: send a command to the Cmd Thread. Commands are stored in a
+ *              fixed ring, a DO_NEXT_JOB posted behind a DO_NEXT_JOB that
+ *              is still pending is folded into it. cmd_sem is still posted
+ *              once per command, so the thread routine dequeues as many
+ *              commands as were sent.
  *
  * PARAMETERS :
  *   @cmd     : command to be executed.
@@ -129,19 +193,51 @@ int32_t QCameraCmdThread::setName(const char* name)
  *==========================================================================*/
 int32_t QCameraCmdThread::sendCmd(camera_cmd_type_t cmd, uint8_t sync_cmd, uint8_t priority)
 {
-    camera_cmd_t *node = (camera_cmd_t *)malloc(sizeof(camera_cmd_t));
-    if (NULL == node) {
-        ALOGE("%s: No memory for camera_cmd_t", __func__);
-        return NO_MEMORY;
-    }
-    memset(node, 0, sizeof(camera_cmd_t));
-    node->cmd = cmd;
+    camera_cmd_t *node = NULL;
+    int64_t now = nowUs();
 
-    if (priority) {
-        cmd_queue.enqueueWithPriority((void *)node);
-    } else {
-        cmd_queue.enqueue((void *)node);
+    pthread_mutex_lock(&m_lock);
+    if (!priority && (CAMERA_CMD_TYPE_DO_NEXT_JOB == cmd) && (m_count > 0)) {
+        node = &m_ring[(m_head + m_count - 1) % CMD_THREAD_RING_SIZE];
+        if (node->cmd == cmd) {
+            if (node->slots < CMD_THREAD_FOLD_SLOTS) {
+                uint32_t slot =
+                        (node->first + node->slots) % CMD_THREAD_FOLD_SLOTS;
+                node->post_us[slot] = now;
+                node->posts[slot] = 1;
+                node->slots++;
+            } else {
+                node->posts[(node->first + CMD_THREAD_FOLD_SLOTS - 1) %
+                        CMD_THREAD_FOLD_SLOTS]++;
+            }
+            node->count++;
+            m_stats.coalesced++;
+        } else {
+            node = NULL;
+        }
+    }
+    if (NULL == node) {
+        if (m_count == CMD_THREAD_RING_SIZE) {
+            m_stats.ring_full++;
+            pthread_mutex_unlock(&m_lock);
+            ALOGE("%s: No room for cmd %d in %s", __func__, cmd, m_name);
+            return NO_MEMORY;
+        }
+        if (priority) {
+            m_head = (m_head + CMD_THREAD_RING_SIZE - 1) % CMD_THREAD_RING_SIZE;
+            node = &m_ring[m_head];
+        } else {
+            node = &m_ring[(m_head + m_count) % CMD_THREAD_RING_SIZE];
+        }
+        m_count++;
+        node->cmd = cmd;
+        node->count = 1;
+        node->first = 0;
+        node->slots = 1;
+        node->post_us[0] = now;
+        node->posts[0] = 1;
     }
+    pthread_mutex_unlock(&m_lock);
     cam_sem_post(&cmd_sem);
 
     /* if is a sync call, need to wait until it returns */
@@ -154,7 +250,9 @@ int32_t QCameraCmdThread::sendCmd(camera_cmd_type_t cmd, uint8_t sync_cmd, uint8
 /*===========================================================================
  * FUNCTION   : getCmd
  *
- * DESCRIPTION: dequeue a cmommand from cmd queue
+ * DESCRIPTION: dequeue a cmommand from cmd queue. The post to dequeue time
+ *              is added to the stats, for folded DO_NEXT_JOB posts it is
+ *              counted from the post being dequeued.
  *
  * PARAMETERS : None
  *
@@ -163,17 +261,60 @@ int32_t QCameraCmdThread::sendCmd(camera_cmd_type_t cmd, uint8_t sync_cmd, uint8
 camera_cmd_type_t QCameraCmdThread::getCmd()
 {
     camera_cmd_type_t cmd = CAMERA_CMD_TYPE_NONE;
-    camera_cmd_t *node = (camera_cmd_t *)cmd_queue.dequeue();
-    if (NULL == node) {
+
+    pthread_mutex_lock(&m_lock);
+    if (m_count == 0) {
+        pthread_mutex_unlock(&m_lock);
         ALOGD("%s: No notify avail", __func__);
         return CAMERA_CMD_TYPE_NONE;
+    }
+
+    camera_cmd_t *node = &m_ring[m_head];
+    cmd = node->cmd;
+    uint32_t wait = (uint32_t)(nowUs() - node->post_us[node->first]);
+    if (node->count > 1) {
+        node->count--;
+        if (--node->posts[node->first] == 0) {
+            node->first = (node->first + 1) % CMD_THREAD_FOLD_SLOTS;
+            node->slots--;
+        }
     } else {
-        cmd = node->cmd;
-        free(node);
+        m_head = (m_head + 1) % CMD_THREAD_RING_SIZE;
+        m_count--;
+    }
+
+    uint32_t bucket = 0;
+    while ((bucket < CMD_THREAD_WAIT_HIST_BUCKETS - 1) &&
+            (wait >= s_waitHistBounds[bucket])) {
+        bucket++;
+    }
+    m_stats.wait_hist[bucket]++;
+    m_stats.wait_total_us += wait;
+    if (wait > m_stats.wait_max_us) {
+        m_stats.wait_max_us = wait;
     }
+    m_stats.cmds++;
+    pthread_mutex_unlock(&m_lock);
     return cmd;
 }
 
+/*===========================================================================
+ * FUNCTION   : getStats
+ *
+ * DESCRIPTION: copy the command statistics of the thread
+ *
+ * PARAMETERS :
+ *   @stats   : output statistics
+ *
+ * RETURN     : None
+ *==========================================================================*/
+void QCameraCmdThread::getStats(camera_cmd_stats_t *stats)
+{
+    pthread_mutex_lock(&m_lock);
+    *stats = m_stats;
+    pthread_mutex_unlock(&m_lock);
+}
+
 /*===========================================================================
  * FUNCTION   : exit
  *
@@ -204,7 +345,49 @@ int32_t QCameraCmdThread::exit()
         ALOGD("%s: pthread dead already\n", __func__);
     }
     cmd_pid = 0;
+    logStats();
     return rc;
 }
 
+/*===========================================================================
+ * FUNCTION   : nowUs
+ *
+ * DESCRIPTION: monotonic time in microseconds
+ *
+ * PARAMETERS : None
+ *
+ * RETURN     : current time
+ *==========================================================================*/
+int64_t QCameraCmdThread::nowUs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+/*===========================================================================
+ * FUNCTION   : logStats
+ *
+ * DESCRIPTION: log post to dequeue statistics of the thread
+ *
+ * PARAMETERS : None
+ *
+ * RETURN     : None
+ *==========================================================================*/
+void QCameraCmdThread::logStats()
+{
+    camera_cmd_stats_t stats;
+
+    getStats(&stats);
+    ALOGD("%s: %s cmds %u coalesced %u ring full %u "
+          "wait avg %llu us max %u us, "
+          "wait <100us %u <500us %u <1ms %u <5ms %u <10ms %u >=10ms %u",
+          __func__, m_name, stats.cmds, stats.coalesced, stats.ring_full,
+          (unsigned long long)(stats.cmds ?
+              stats.wait_total_us / stats.cmds : 0),
+          stats.wait_max_us,
+          stats.wait_hist[0], stats.wait_hist[1], stats.wait_hist[2],
+          stats.wait_hist[3], stats.wait_hist[4], stats.wait_hist[5]);
+}
+
 }; // namespace qcamera
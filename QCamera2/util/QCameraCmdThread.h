@@ -31,6 +31,7 @@
 #define __QCAMERA_CMD_THREAD_H__
 
 #include <pthread.h>
+#include <stdint.h>
 #include <cam_semaphore.h>
 
 #include "cam_types.h"
@@ -38,6 +39,11 @@
 
 namespace qcamera {
 
+#define CMD_THREAD_RING_SIZE       32
+#define CMD_THREAD_NAME_LEN        16
+#define CMD_THREAD_WAIT_HIST_BUCKETS 6
+#define CMD_THREAD_FOLD_SLOTS      8
+
 typedef enum
 {
     CAMERA_CMD_TYPE_NONE,
@@ -50,8 +56,44 @@ typedef enum
 
 typedef struct {
     camera_cmd_type_t cmd;
+    uint32_t count;         // posts folded into this node still pending
+    // circular post times of the pending posts, oldest at slot first.
+    // With more posts pending than slots the newest slot is shared.
+    uint32_t first;
+    uint32_t slots;         // slots in use
+    int64_t post_us[CMD_THREAD_FOLD_SLOTS];
+    uint32_t posts[CMD_THREAD_FOLD_SLOTS]; // posts sharing each slot
 } camera_cmd_t;
 
+typedef struct {
+    uint32_t cmds;          // commands dequeued
+    uint32_t coalesced;     // DO_NEXT_JOB posts folded into a pending node
+    uint32_t ring_full;     // posts rejected because the ring was full
+    uint64_t wait_total_us; // post to dequeue time of all commands
+    uint32_t wait_max_us;   // longest post to dequeue time
+    // post to dequeue histogram: <100us, <500us, <1ms, <5ms, <10ms, >=10ms
+    uint32_t wait_hist[CMD_THREAD_WAIT_HIST_BUCKETS];
+} camera_cmd_stats_t;
+
+// Counting semaphore on a futex. Posting with no thread asleep is a
+// single atomic add, the kernel is only entered to wake or to sleep.
+class QCameraCmdSem {
+public:
+    QCameraCmdSem() : m_val(0), m_waiters(0) {}
+    void post();
+    int wait();
+private:
+    volatile int32_t m_val;
+    volatile int32_t m_waiters;
+};
+
+// cmd_sem and sync_sem keep being waited and posted through the
+// cam_sem_* calls used by all the command thread routines
+inline void cam_sem_post(QCameraCmdSem *s) { s->post(); }
+inline int cam_sem_wait(QCameraCmdSem *s) { return s->wait(); }
+using ::cam_sem_post;
+using ::cam_sem_wait;
+
 class QCameraCmdThread {
 public:
     QCameraCmdThread();
@@ -62,11 +104,22 @@ public:
     int32_t exit();
     int32_t sendCmd(camera_cmd_type_t cmd, uint8_t sync_cmd, uint8_t priority);
     camera_cmd_type_t getCmd();
+    void getStats(camera_cmd_stats_t *stats);
 
-    QCameraQueue cmd_queue;      /* cmd queue */
     pthread_t cmd_pid;           /* cmd thread ID */
-    cam_semaphore_t cmd_sem;               /* semaphore for cmd thread */
-    cam_semaphore_t sync_sem;              /* semaphore for synchronized call signal */
+    QCameraCmdSem cmd_sem;       /* semaphore for cmd thread */
+    QCameraCmdSem sync_sem;      /* semaphore for synchronized call signal */
+
+private:
+    static int64_t nowUs();
+    void logStats();
+
+    pthread_mutex_t m_lock;      /* guards the ring and the stats */
+    camera_cmd_t m_ring[CMD_THREAD_RING_SIZE];
+    uint32_t m_head;             /* oldest pending node */
+    uint32_t m_count;            /* pending nodes */
+    camera_cmd_stats_t m_stats;
+    char m_name[CMD_THREAD_NAME_LEN];
 };
 
 }; // namespace qcamera
@@ -0,0 +1,618 @@
+/* Copyright (c) 2014, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <sched.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/prctl.h>
+#include <sys/resource.h>
+#include <utils/Errors.h>
+#include <utils/Log.h>
+#include "QCameraExecutor.h"
+
+using namespace android;
+
+namespace qcamera {
+
+static const uint32_t s_waitHistBounds[EXEC_WAIT_HIST_BUCKETS - 1] =
+    { 100, 500, 1000, 5000, 10000 };
+
+/*===========================================================================
+ * FUNCTION   : QCameraExecutor
+ *
+ * DESCRIPTION: constructor of QCameraExecutor, starts the worker threads
+ *
+ * PARAMETERS :
+ *   @numWorkers : number of worker threads, capped to EXEC_MAX_WORKERS
+ *
+ * RETURN     : None
+ *==========================================================================*/
+QCameraExecutor::QCameraExecutor(uint32_t numWorkers) :
+    m_numWorkers(0),
+    m_bExit(false)
+{
+    pthread_mutex_init(&m_lock, NULL);
+    pthread_cond_init(&m_workCond, NULL);
+    pthread_cond_init(&m_idleCond, NULL);
+    cam_list_init(&m_ready);
+    cam_list_init(&m_freeNodes);
+    memset(m_nodes, 0, sizeof(m_nodes));
+    for (uint32_t i = 0; i < EXEC_NUM_NODES; i++) {
+        cam_list_add_tail_node(&m_nodes[i].list, &m_freeNodes);
+    }
+    memset(m_lanes, 0, sizeof(m_lanes));
+
+    if (numWorkers == 0) {
+        numWorkers = EXEC_DEFAULT_WORKERS;
+    } else if (numWorkers > EXEC_MAX_WORKERS) {
+        numWorkers = EXEC_MAX_WORKERS;
+    }
+    for (uint32_t i = 0; i < numWorkers; i++) {
+        if (pthread_create(&m_workers[m_numWorkers], NULL,
+                workerRoutine, this) == 0) {
+            m_numWorkers++;
+        } else {
+            ALOGE("%s: Failed to start worker %d", __func__, i);
+        }
+    }
+}
+
+/*===========================================================================
+ * FUNCTION   : ~QCameraExecutor
+ *
+ * DESCRIPTION: deconstructor of QCameraExecutor. All lanes are expected to
+ *              be closed; pending jobs left are released without running.
+ *
+ * PARAMETERS : None
+ *
+ * RETURN     : None
+ *==========================================================================*/
+QCameraExecutor::~QCameraExecutor()
+{
+    pthread_mutex_lock(&m_lock);
+    m_bExit = true;
+    pthread_cond_broadcast(&m_workCond);
+    pthread_mutex_unlock(&m_lock);
+
+    for (uint32_t i = 0; i < m_numWorkers; i++) {
+        pthread_join(m_workers[i], NULL);
+    }
+
+    for (uint32_t i = 0; i < EXEC_MAX_LANES; i++) {
+        if (m_lanes[i].used) {
+            struct cam_list dropped;
+            cam_list_init(&dropped);
+            pthread_mutex_lock(&m_lock);
+            flushLane(&m_lanes[i], &dropped);
+            pthread_mutex_unlock(&m_lock);
+            releaseJobs(&dropped, m_lanes[i].rel_fn, m_lanes[i].user_data);
+        }
+    }
+    pthread_cond_destroy(&m_idleCond);
+    pthread_cond_destroy(&m_workCond);
+    pthread_mutex_destroy(&m_lock);
+}
+
+/*===========================================================================
+ * FUNCTION   : getInstance
+ *
+ * DESCRIPTION: get the executor shared by all streams of the process. It is
+ *              created on first use and lives as long as the process, so
+ *              lanes can be closed from any thread including its workers.
+ *
+ * PARAMETERS :
+ *   @numWorkers : number of worker threads if the executor gets created
+ *
+ * RETURN     : ptr to the shared executor, NULL if no worker could start
+ *==========================================================================*/
+QCameraExecutor *QCameraExecutor::getInstance(uint32_t numWorkers)
+{
+    static pthread_mutex_t s_lock = PTHREAD_MUTEX_INITIALIZER;
+    static QCameraExecutor *s_instance = NULL;
+
+    pthread_mutex_lock(&s_lock);
+    if (NULL == s_instance) {
+        QCameraExecutor *executor = new QCameraExecutor(numWorkers);
+        if (executor->getNumWorkers() > 0) {
+            s_instance = executor;
+        } else {
+            delete executor;
+        }
+    }
+    pthread_mutex_unlock(&s_lock);
+    return s_instance;
+}
+
+/*===========================================================================
+ * FUNCTION   : openLane
+ *
+ * DESCRIPTION: open a serial lane. Jobs posted to a lane run one at a time,
+ *              in posting order, on any of the workers.
+ *
+ * PARAMETERS :
+ *   @job_fn    : function running one job
+ *   @rel_fn    : function releasing resources of a job dropped without
+ *                running, can be NULL. The job data is freed after it.
+ *   @user_data : user data ptr passed to job_fn and rel_fn
+ *   @attr      : scheduling hints, NULL for defaults
+ *
+ * RETURN     : lane id, negative if no lane is available
+ *==========================================================================*/
+int32_t QCameraExecutor::openLane(exec_job_fn job_fn, release_data_fn rel_fn,
+        void *user_data, const exec_lane_attr_t *attr)
+{
+    int32_t id = -1;
+
+    if (NULL == job_fn) {
+        return BAD_VALUE;
+    }
+
+    pthread_mutex_lock(&m_lock);
+    for (int32_t i = 0; i < EXEC_MAX_LANES; i++) {
+        if (!m_lanes[i].used) {
+            id = i;
+            break;
+        }
+    }
+    if (id >= 0) {
+        exec_lane_t *lane = &m_lanes[id];
+        memset(lane, 0, sizeof(exec_lane_t));
+        cam_list_init(&lane->list);
+        cam_list_init(&lane->jobs);
+        lane->used = true;
+        lane->job_fn = job_fn;
+        lane->rel_fn = rel_fn;
+        lane->user_data = user_data;
+        lane->cpu = -1;
+        if (NULL != attr) {
+            lane->cpu = attr->cpu;
+            lane->nice = attr->nice;
+            if (NULL != attr->name) {
+                strlcpy(lane->name, attr->name, sizeof(lane->name));
+            }
+        }
+    } else {
+        ALOGE("%s: No free lane", __func__);
+    }
+    pthread_mutex_unlock(&m_lock);
+    return id;
+}
+
+/*===========================================================================
+ * FUNCTION   : post
+ *
+ * DESCRIPTION: queue a job to a lane
+ *
+ * PARAMETERS :
+ *   @lane    : lane id
+ *   @job     : job data passed to the lane job function
+ *
+ * RETURN     : int32_t type of status
+ *              NO_ERROR  -- success
+ *              none-zero failure code, job is not queued and still
+ *              belongs to the caller
+ *==========================================================================*/
+int32_t QCameraExecutor::post(int32_t lane, void *job)
+{
+    int32_t rc = NO_ERROR;
+
+    if ((lane < 0) || (lane >= EXEC_MAX_LANES)) {
+        return BAD_VALUE;
+    }
+
+    pthread_mutex_lock(&m_lock);
+    exec_lane_t *p_lane = &m_lanes[lane];
+    if (!p_lane->used || p_lane->closing) {
+        rc = INVALID_OPERATION;
+    } else {
+        exec_node_t *node = getNode(p_lane);
+        if (NULL == node) {
+            rc = NO_MEMORY;
+        } else {
+            node->job = job;
+            node->enq_us = nowUs();
+            cam_list_add_tail_node(&node->list, &p_lane->jobs);
+            p_lane->stats.pending++;
+            if (!p_lane->running && !p_lane->queued) {
+                cam_list_add_tail_node(&p_lane->list, &m_ready);
+                p_lane->queued = true;
+                pthread_cond_signal(&m_workCond);
+            }
+        }
+    }
+    pthread_mutex_unlock(&m_lock);
+    return rc;
+}
+
+/*===========================================================================
+ * FUNCTION   : closeLane
+ *
+ * DESCRIPTION: close a lane. Pending jobs are released without running and
+ *              the call waits for a running job of the lane to return,
+ *              unless it is made from that job.
+ *
+ * PARAMETERS :
+ *   @lane    : lane id
+ *
+ * RETURN     : int32_t type of status
+ *              NO_ERROR  -- success
+ *              none-zero failure code
+ *==========================================================================*/
+int32_t QCameraExecutor::closeLane(int32_t lane)
+{
+    if ((lane < 0) || (lane >= EXEC_MAX_LANES)) {
+        return BAD_VALUE;
+    }
+
+    struct cam_list dropped;
+    cam_list_init(&dropped);
+
+    pthread_mutex_lock(&m_lock);
+    exec_lane_t *p_lane = &m_lanes[lane];
+    if (!p_lane->used || p_lane->closing) {
+        pthread_mutex_unlock(&m_lock);
+        return INVALID_OPERATION;
+    }
+    p_lane->closing = true;
+    if (p_lane->queued) {
+        cam_list_del_node(&p_lane->list);
+        p_lane->queued = false;
+    }
+    flushLane(p_lane, &dropped);
+    logStats(p_lane);
+    release_data_fn rel_fn = p_lane->rel_fn;
+    void *user_data = p_lane->user_data;
+
+    if (p_lane->running && pthread_equal(p_lane->runner, pthread_self())) {
+        // the worker frees the lane once the job returns
+        p_lane->self_closed = true;
+    } else {
+        while (p_lane->running) {
+            pthread_cond_wait(&m_idleCond, &m_lock);
+        }
+        p_lane->used = false;
+    }
+    pthread_mutex_unlock(&m_lock);
+
+    releaseJobs(&dropped, rel_fn, user_data);
+    return NO_ERROR;
+}
+
+/*===========================================================================
+ * FUNCTION   : getStats
+ *
+ * DESCRIPTION: get queue wait statistics of a lane
+ *
+ * PARAMETERS :
+ *   @lane    : lane id
+ *   @stats   : output statistics
+ *
+ * RETURN     : int32_t type of status
+ *              NO_ERROR  -- success
+ *              none-zero failure code
+ *==========================================================================*/
+int32_t QCameraExecutor::getStats(int32_t lane, exec_lane_stats_t *stats)
+{
+    int32_t rc = NO_ERROR;
+
+    if ((lane < 0) || (lane >= EXEC_MAX_LANES) || (NULL == stats)) {
+        return BAD_VALUE;
+    }
+
+    pthread_mutex_lock(&m_lock);
+    if (m_lanes[lane].used) {
+        *stats = m_lanes[lane].stats;
+    } else {
+        rc = INVALID_OPERATION;
+    }
+    pthread_mutex_unlock(&m_lock);
+    return rc;
+}
+
+/*===========================================================================
+ * FUNCTION   : workerRoutine
+ *
+ * DESCRIPTION: worker thread taking one job of the first ready lane at a
+ *              time. The lane goes back to the end of the ready list after
+ *              the job if it has more pending.
+ *
+ * PARAMETERS :
+ *   @data    : executor
+ *
+ * RETURN     : NULL
+ *==========================================================================*/
+void *QCameraExecutor::workerRoutine(void *data)
+{
+    QCameraExecutor *pme = (QCameraExecutor *)data;
+    int32_t curCpu = -1;
+    int32_t curNice = 0;
+
+    prctl(PR_SET_NAME, (unsigned long)"CAM_execWorker", 0, 0, 0);
+
+    pthread_mutex_lock(&pme->m_lock);
+    while (true) {
+        while (!pme->m_bExit && (pme->m_ready.next == &pme->m_ready)) {
+            pthread_cond_wait(&pme->m_workCond, &pme->m_lock);
+        }
+        if (pme->m_bExit) {
+            break;
+        }
+
+        exec_lane_t *lane = member_of(pme->m_ready.next, exec_lane_t, list);
+        cam_list_del_node(&lane->list);
+        lane->queued = false;
+
+        exec_node_t *node = member_of(lane->jobs.next, exec_node_t, list);
+        cam_list_del_node(&node->list);
+        void *job = node->job;
+        uint32_t wait = (uint32_t)(nowUs() - node->enq_us);
+        pme->putNode(node);
+
+        exec_lane_stats_t *stats = &lane->stats;
+        uint32_t bucket = 0;
+        while ((bucket < EXEC_WAIT_HIST_BUCKETS - 1) &&
+                (wait >= s_waitHistBounds[bucket])) {
+            bucket++;
+        }
+        stats->wait_hist[bucket]++;
+        stats->wait_total_us += wait;
+        if (wait > stats->wait_max_us) {
+            stats->wait_max_us = wait;
+        }
+        stats->pending--;
+        stats->jobs++;
+
+        lane->running = true;
+        lane->runner = pthread_self();
+        pthread_mutex_unlock(&pme->m_lock);
+
+        applyAttr(lane, curCpu, curNice);
+        lane->job_fn(job, lane->user_data);
+
+        pthread_mutex_lock(&pme->m_lock);
+        lane->running = false;
+        if (lane->self_closed) {
+            // closed from its own job, nobody waits for it
+            lane->used = false;
+        } else if (lane->closing) {
+            pthread_cond_broadcast(&pme->m_idleCond);
+        } else if (lane->jobs.next != &lane->jobs) {
+            cam_list_add_tail_node(&lane->list, &pme->m_ready);
+            lane->queued = true;
+        }
+    }
+    pthread_mutex_unlock(&pme->m_lock);
+    return NULL;
+}
+
+/*===========================================================================
+ * FUNCTION   : nowUs
+ *
+ * DESCRIPTION: monotonic time in microseconds
+ *
+ * PARAMETERS : None
+ *
+ * RETURN     : current time
+ *==========================================================================*/
+int64_t QCameraExecutor::nowUs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+/*===========================================================================
+ * FUNCTION   : applyAttr
+ *
+ * DESCRIPTION: move the calling worker to the cpu and priority of a lane.
+ *              Settings are only changed when they differ from what the
+ *              worker last applied.
+ *
+ * PARAMETERS :
+ *   @lane    : lane about to run
+ *   @curCpu  : cpu the worker is bound to, updated
+ *   @curNice : nice value of the worker, updated
+ *
+ * RETURN     : None
+ *==========================================================================*/
+void QCameraExecutor::applyAttr(const exec_lane_t *lane, int32_t &curCpu,
+        int32_t &curNice)
+{
+    if (lane->cpu != curCpu) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        if (lane->cpu >= 0) {
+            CPU_SET(lane->cpu, &set);
+        } else {
+            long numCpus = sysconf(_SC_NPROCESSORS_CONF);
+            for (long i = 0; (i < numCpus) && (i < CPU_SETSIZE); i++) {
+                CPU_SET(i, &set);
+            }
+        }
+        if (sched_setaffinity(0, sizeof(set), &set) != 0) {
+            ALOGE("%s: Failed to move %s to cpu %d", __func__,
+                  lane->name, lane->cpu);
+        }
+        curCpu = lane->cpu;
+    }
+    if (lane->nice != curNice) {
+        // with who == 0 only the calling thread is changed
+        if (setpriority(PRIO_PROCESS, 0, lane->nice) != 0) {
+            ALOGE("%s: Failed to set nice %d for %s", __func__,
+                  lane->nice, lane->name);
+        }
+        curNice = lane->nice;
+    }
+}
+
+/*===========================================================================
+ * FUNCTION   : getNode
+ *
+ * DESCRIPTION: take a job node from the pool, or from the heap when the
+ *              pool is empty. Called with m_lock held.
+ *
+ * PARAMETERS :
+ *   @lane    : lane the node is for, counts heap allocations
+ *
+ * RETURN     : job node, NULL if out of memory
+ *==========================================================================*/
+QCameraExecutor::exec_node_t *QCameraExecutor::getNode(exec_lane_t *lane)
+{
+    exec_node_t *node = NULL;
+
+    if (m_freeNodes.next != &m_freeNodes) {
+        node = member_of(m_freeNodes.next, exec_node_t, list);
+        cam_list_del_node(&node->list);
+        node->heap = false;
+    } else {
+        node = (exec_node_t *)malloc(sizeof(exec_node_t));
+        if (NULL == node) {
+            ALOGE("%s: No memory for exec_node_t", __func__);
+            return NULL;
+        }
+        cam_list_init(&node->list);
+        node->heap = true;
+        lane->stats.heap_nodes++;
+    }
+    return node;
+}
+
+/*===========================================================================
+ * FUNCTION   : putNode
+ *
+ * DESCRIPTION: return a job node. Called with m_lock held.
+ *
+ * PARAMETERS :
+ *   @node    : node to be returned
+ *
+ * RETURN     : None
+ *==========================================================================*/
+void QCameraExecutor::putNode(exec_node_t *node)
+{
+    if (node->heap) {
+        free(node);
+    } else {
+        node->job = NULL;
+        cam_list_add_tail_node(&node->list, &m_freeNodes);
+    }
+}
+
+/*===========================================================================
+ * FUNCTION   : flushLane
+ *
+ * DESCRIPTION: unlink all pending jobs of a lane, to be released with
+ *              releaseJobs once m_lock is dropped. Called with m_lock held.
+ *
+ * PARAMETERS :
+ *   @lane    : lane to be flushed
+ *   @dropped : list receiving the job nodes
+ *
+ * RETURN     : None
+ *==========================================================================*/
+void QCameraExecutor::flushLane(exec_lane_t *lane, struct cam_list *dropped)
+{
+    while (lane->jobs.next != &lane->jobs) {
+        exec_node_t *node = member_of(lane->jobs.next, exec_node_t, list);
+        cam_list_del_node(&node->list);
+        cam_list_add_tail_node(&node->list, dropped);
+    }
+    lane->stats.pending = 0;
+}
+
+/*===========================================================================
+ * FUNCTION   : releaseJobs
+ *
+ * DESCRIPTION: release jobs unlinked by flushLane. Like QCameraQueue::flush
+ *              job data is passed to the release function, then freed.
+ *              Called without m_lock, so the release function may use the
+ *              executor; the lock is only taken to return the nodes.
+ *
+ * PARAMETERS :
+ *   @dropped   : job nodes to be released
+ *   @rel_fn    : release function of the lane
+ *   @user_data : user data ptr passed to rel_fn
+ *
+ * RETURN     : None
+ *==========================================================================*/
+void QCameraExecutor::releaseJobs(struct cam_list *dropped,
+        release_data_fn rel_fn, void *user_data)
+{
+    if (dropped->next == dropped) {
+        return;
+    }
+
+    for (struct cam_list *pos = dropped->next; pos != dropped;
+            pos = pos->next) {
+        exec_node_t *node = member_of(pos, exec_node_t, list);
+        if (NULL != node->job) {
+            if (NULL != rel_fn) {
+                rel_fn(node->job, user_data);
+            }
+            free(node->job);
+            node->job = NULL;
+        }
+    }
+
+    pthread_mutex_lock(&m_lock);
+    while (dropped->next != dropped) {
+        exec_node_t *node = member_of(dropped->next, exec_node_t, list);
+        cam_list_del_node(&node->list);
+        putNode(node);
+    }
+    pthread_mutex_unlock(&m_lock);
+}
+
+/*===========================================================================
+ * FUNCTION   : logStats
+ *
+ * DESCRIPTION: log queue wait statistics of a lane
+ *
+ * PARAMETERS :
+ *   @lane    : lane
+ *
+ * RETURN     : None
+ *==========================================================================*/
+void QCameraExecutor::logStats(const exec_lane_t *lane)
+{
+    const exec_lane_stats_t *stats = &lane->stats;
+
+    ALOGD("%s: lane %s jobs %u wait avg %llu us max %u us heap nodes %u, "
+          "wait <100us %u <500us %u <1ms %u <5ms %u <10ms %u >=10ms %u",
+          __func__, lane->name, stats->jobs,
+          (unsigned long long)(stats->jobs ?
+              stats->wait_total_us / stats->jobs : 0),
+          stats->wait_max_us, stats->heap_nodes,
+          stats->wait_hist[0], stats->wait_hist[1], stats->wait_hist[2],
+          stats->wait_hist[3], stats->wait_hist[4], stats->wait_hist[5]);
+}
+
+}; // namespace qcamera
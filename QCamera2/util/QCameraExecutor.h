@@ -0,0 +1,133 @@
+/* Copyright (c) 2014, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef __QCAMERA_EXECUTOR_H__
+#define __QCAMERA_EXECUTOR_H__
+
+#include <pthread.h>
+#include <stdint.h>
+#include "cam_list.h"
+#include "QCameraQueue.h"
+
+namespace qcamera {
+
+#define EXEC_MAX_WORKERS       4
+#define EXEC_DEFAULT_WORKERS   2
+#define EXEC_MAX_LANES         16
+#define EXEC_NUM_NODES         128
+#define EXEC_LANE_NAME_LEN     16
+#define EXEC_WAIT_HIST_BUCKETS 6
+
+typedef void (*exec_job_fn)(void *job, void *user_data);
+
+// scheduling hints applied to the worker while it runs jobs of a lane
+typedef struct {
+    const char *name;   // lane name used in stats
+    int32_t cpu;        // cpu to run on, -1 for any
+    int32_t nice;       // nice value, 0 for default priority
+} exec_lane_attr_t;
+
+typedef struct {
+    uint32_t jobs;          // jobs run
+    uint32_t pending;       // jobs waiting in the lane
+    uint32_t heap_nodes;    // jobs posted while the node pool was empty
+    uint64_t wait_total_us; // queue wait of all jobs run
+    uint32_t wait_max_us;   // longest queue wait
+    // queue wait histogram: <100us, <500us, <1ms, <5ms, <10ms, >=10ms
+    uint32_t wait_hist[EXEC_WAIT_HIST_BUCKETS];
+} exec_lane_stats_t;
+
+// Fixed pool of worker threads shared by streams in place of one
+// QCameraCmdThread each. Jobs of a lane run one at a time in posting
+// order, lanes with pending jobs are served round robin.
+class QCameraExecutor {
+public:
+    QCameraExecutor(uint32_t numWorkers);
+    virtual ~QCameraExecutor();
+    static QCameraExecutor *getInstance(uint32_t numWorkers);
+
+    int32_t openLane(exec_job_fn job_fn, release_data_fn rel_fn,
+                     void *user_data, const exec_lane_attr_t *attr);
+    int32_t post(int32_t lane, void *job);
+    int32_t closeLane(int32_t lane);
+    int32_t getStats(int32_t lane, exec_lane_stats_t *stats);
+    uint32_t getNumWorkers() const { return m_numWorkers; }
+
+private:
+    typedef struct {
+        struct cam_list list;
+        void *job;
+        int64_t enq_us;     // time the job was posted
+        bool heap;          // allocated past the node pool
+    } exec_node_t;
+
+    typedef struct {
+        struct cam_list list;   // link in the ready list
+        struct cam_list jobs;   // pending jobs in posting order
+        bool used;
+        bool closing;
+        bool self_closed;       // closed from one of its own jobs
+        bool running;           // a worker is running a job of the lane
+        bool queued;            // lane is in the ready list
+        pthread_t runner;       // worker running the lane
+        exec_job_fn job_fn;
+        release_data_fn rel_fn;
+        void *user_data;
+        char name[EXEC_LANE_NAME_LEN];
+        int32_t cpu;
+        int32_t nice;
+        exec_lane_stats_t stats;
+    } exec_lane_t;
+
+    static void *workerRoutine(void *data);
+    static int64_t nowUs();
+    static void applyAttr(const exec_lane_t *lane, int32_t &curCpu,
+                          int32_t &curNice);
+    exec_node_t *getNode(exec_lane_t *lane);
+    void putNode(exec_node_t *node);
+    void flushLane(exec_lane_t *lane, struct cam_list *dropped);
+    void releaseJobs(struct cam_list *dropped, release_data_fn rel_fn,
+                     void *user_data);
+    void logStats(const exec_lane_t *lane);
+
+    pthread_mutex_t m_lock;
+    pthread_cond_t m_workCond;   // signaled when a lane becomes ready
+    pthread_cond_t m_idleCond;   // signaled when a lane stops running
+    struct cam_list m_ready;     // lanes with pending jobs, not running
+    struct cam_list m_freeNodes;
+    exec_node_t m_nodes[EXEC_NUM_NODES];
+    exec_lane_t m_lanes[EXEC_MAX_LANES];
+    pthread_t m_workers[EXEC_MAX_WORKERS];
+    uint32_t m_numWorkers;
+    bool m_bExit;
+};
+
+}; // namespace qcamera
+
+#endif /* __QCAMERA_EXECUTOR_H__ */
@@ -0,0 +1,303 @@
+/* Copyright (c) 2014, The Linux Foundataion. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef __QCAMERA_LOOKUP_MAP_H__
+#define __QCAMERA_LOOKUP_MAP_H__
+
+#include <stdint.h>
+#include <string.h>
+#include <utils/Errors.h>
+
+namespace qcamera {
+
+#define QCAMERA_LOOKUP_MAX_ENTRIES  64   // larger tables fall back to a scan
+#define QCAMERA_LOOKUP_HASH_SIZE    256  // max hash slots, power of 2
+#define QCAMERA_LOOKUP_DENSE_SIZE   128  // max value range of a dense index
+#define QCAMERA_LOOKUP_MAX_SEEDS    64   // seeds tried per hash table size
+
+// Dense value -> entry index. The first entry holding a value wins, the
+// same way a linear scan of the table would resolve duplicates.
+class QCameraValueIndex {
+public:
+    QCameraValueIndex() : mMin(0), mRange(0) {}
+
+    bool init(int minVal, int maxVal)
+    {
+        mRange = 0;
+        if (maxVal < minVal ||
+                (int64_t)maxVal - minVal >= QCAMERA_LOOKUP_DENSE_SIZE) {
+            return false;
+        }
+        mMin = minVal;
+        mRange = maxVal - minVal + 1;
+        memset(mEntry, 0, sizeof(mEntry));
+        return true;
+    }
+
+    void add(int value, size_t entry)
+    {
+        uint8_t *slot = &mEntry[value - mMin];
+        if (*slot == 0) {
+            *slot = (uint8_t)(entry + 1);
+        }
+    }
+
+    bool isValid() const { return mRange != 0; }
+
+    // entry holding the value, -1 if there is none
+    int find(int value) const
+    {
+        if (value < mMin || value - mMin >= mRange) {
+            return -1;
+        }
+        return (int)mEntry[value - mMin] - 1;
+    }
+
+private:
+    int mMin;
+    int mRange;
+    uint8_t mEntry[QCAMERA_LOOKUP_DENSE_SIZE];  // entry + 1, 0 if unused
+};
+
+// Collision free name -> entry hash. build() searches for a table size
+// and seed that place every distinct name in its own slot, so a lookup
+// costs one hash and at most one strcmp.
+class QCameraNameIndex {
+public:
+    QCameraNameIndex() : mMask(0), mSeed(0) {}
+
+    static uint32_t hash(const char *name, uint32_t seed)
+    {
+        uint32_t h = 2166136261U ^ seed;
+        while (*name) {
+            h ^= (uint8_t)*name++;
+            h *= 16777619U;
+        }
+        return h ^ (h >> 15);
+    }
+
+    // @names holds @len entries; duplicate names keep their first entry
+    bool build(const char *const *names, size_t len)
+    {
+        mMask = 0;
+        if (len == 0 || len > QCAMERA_LOOKUP_MAX_ENTRIES) {
+            return false;
+        }
+        uint32_t size = 1;
+        while (size < 2 * len) {
+            size <<= 1;
+        }
+        for (; size <= QCAMERA_LOOKUP_HASH_SIZE; size <<= 1) {
+            for (uint32_t seed = 0; seed < QCAMERA_LOOKUP_MAX_SEEDS; seed++) {
+                if (tryBuild(names, len, size - 1, seed)) {
+                    mMask = size - 1;
+                    mSeed = seed;
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+
+    bool isValid() const { return mMask != 0; }
+
+    // only candidate entry for the name, -1 if there is none. The caller
+    // compares the entry name since unknown names can hash anywhere.
+    int find(const char *name) const
+    {
+        return (int)mSlot[hash(name, mSeed) & mMask] - 1;
+    }
+
+private:
+    bool tryBuild(const char *const *names, size_t len, uint32_t mask,
+            uint32_t seed)
+    {
+        memset(mSlot, 0, sizeof(mSlot));
+        for (size_t i = 0; i < len; i++) {
+            uint8_t *slot = &mSlot[hash(names[i], seed) & mask];
+            if (*slot != 0) {
+                if (strcmp(names[*slot - 1], names[i]) == 0) {
+                    continue;
+                }
+                return false;
+            }
+            *slot = (uint8_t)(i + 1);
+        }
+        return true;
+    }
+
+    uint32_t mMask;
+    uint32_t mSeed;
+    uint8_t mSlot[QCAMERA_LOOKUP_HASH_SIZE];  // entry + 1, 0 if unused
+};
+
+// Name <-> value translation over a constant { desc, val } map table.
+// The table is not copied, only indexed, and stays the source of truth
+// for code that walks it. Indexes are built once by the constructor;
+// tables that do not fit them are scanned linearly as before.
+template <class mapType>
+class QCameraNameLookup {
+public:
+    QCameraNameLookup(const mapType *arr, size_t len)
+        : mArr(arr), mLen(len)
+    {
+        if (len > 0 && len <= QCAMERA_LOOKUP_MAX_ENTRIES) {
+            const char *names[QCAMERA_LOOKUP_MAX_ENTRIES];
+            int minVal = (int)arr[0].val;
+            int maxVal = (int)arr[0].val;
+            for (size_t i = 0; i < len; i++) {
+                names[i] = arr[i].desc;
+                if ((int)arr[i].val < minVal) minVal = (int)arr[i].val;
+                if ((int)arr[i].val > maxVal) maxVal = (int)arr[i].val;
+            }
+            mNames.build(names, len);
+            if (mValues.init(minVal, maxVal)) {
+                for (size_t i = 0; i < len; i++) {
+                    mValues.add((int)arr[i].val, i);
+                }
+            }
+        }
+    }
+
+    // value of the name, NAME_NOT_FOUND if it is not in the table
+    int lookup(const char *name) const
+    {
+        if (name == NULL) {
+            return android::NAME_NOT_FOUND;
+        }
+        if (mNames.isValid()) {
+            int i = mNames.find(name);
+            if (i >= 0 && !strcmp(mArr[i].desc, name)) {
+                return (int)mArr[i].val;
+            }
+            return android::NAME_NOT_FOUND;
+        }
+        for (size_t i = 0; i < mLen; i++) {
+            if (!strcmp(mArr[i].desc, name)) {
+                return (int)mArr[i].val;
+            }
+        }
+        return android::NAME_NOT_FOUND;
+    }
+
+    // first name of the value, NULL if it is not in the table
+    const char *lookupName(int value) const
+    {
+        if (mValues.isValid()) {
+            int i = mValues.find(value);
+            return (i >= 0) ? mArr[i].desc : NULL;
+        }
+        for (size_t i = 0; i < mLen; i++) {
+            if ((int)mArr[i].val == value) {
+                return mArr[i].desc;
+            }
+        }
+        return NULL;
+    }
+
+    const mapType *table() const { return mArr; }
+    size_t size() const { return mLen; }
+
+private:
+    const mapType *mArr;
+    size_t mLen;
+    QCameraNameIndex mNames;
+    QCameraValueIndex mValues;
+};
+
+// Framework <-> HAL enum translation over a constant
+// { fwk_name, hal_name } map table, indexed in both directions.
+template <class mapType>
+class QCameraEnumLookup {
+public:
+    QCameraEnumLookup(const mapType *arr, size_t len)
+        : mArr(arr), mLen(len)
+    {
+        if (len > 0 && len <= QCAMERA_LOOKUP_MAX_ENTRIES) {
+            int fwkMin = arr[0].fwk_name, fwkMax = arr[0].fwk_name;
+            int halMin = arr[0].hal_name, halMax = arr[0].hal_name;
+            for (size_t i = 0; i < len; i++) {
+                if (arr[i].fwk_name < fwkMin) fwkMin = arr[i].fwk_name;
+                if (arr[i].fwk_name > fwkMax) fwkMax = arr[i].fwk_name;
+                if (arr[i].hal_name < halMin) halMin = arr[i].hal_name;
+                if (arr[i].hal_name > halMax) halMax = arr[i].hal_name;
+            }
+            if (mFwk.init(fwkMin, fwkMax)) {
+                for (size_t i = 0; i < len; i++) {
+                    mFwk.add(arr[i].fwk_name, i);
+                }
+            }
+            if (mHal.init(halMin, halMax)) {
+                for (size_t i = 0; i < len; i++) {
+                    mHal.add(arr[i].hal_name, i);
+                }
+            }
+        }
+    }
+
+    // HAL value of a framework value, NAME_NOT_FOUND if not mapped
+    int toHal(int fwk_name) const
+    {
+        if (mFwk.isValid()) {
+            int i = mFwk.find(fwk_name);
+            return (i >= 0) ? mArr[i].hal_name : android::NAME_NOT_FOUND;
+        }
+        for (size_t i = 0; i < mLen; i++) {
+            if (mArr[i].fwk_name == fwk_name) {
+                return mArr[i].hal_name;
+            }
+        }
+        return android::NAME_NOT_FOUND;
+    }
+
+    // framework value of a HAL value, NAME_NOT_FOUND if not mapped
+    int toFwk(int hal_name) const
+    {
+        if (mHal.isValid()) {
+            int i = mHal.find(hal_name);
+            return (i >= 0) ? mArr[i].fwk_name : android::NAME_NOT_FOUND;
+        }
+        for (size_t i = 0; i < mLen; i++) {
+            if (mArr[i].hal_name == hal_name) {
+                return mArr[i].fwk_name;
+            }
+        }
+        return android::NAME_NOT_FOUND;
+    }
+
+private:
+    const mapType *mArr;
+    size_t mLen;
+    QCameraValueIndex mFwk;
+    QCameraValueIndex mHal;
+};
+
+}; // namespace qcamera
+
+#endif /* __QCAMERA_LOOKUP_MAP_H__ */
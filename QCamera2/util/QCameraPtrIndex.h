@@ -0,0 +1,151 @@
+/* Copyright (c) 2014, The Linux Foundataion. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef __QCAMERA_PTR_INDEX_H__
+#define __QCAMERA_PTR_INDEX_H__
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+namespace qcamera {
+
+#define QCAMERA_PTR_INDEX_BITS      6
+#define QCAMERA_PTR_INDEX_SIZE      (1 << QCAMERA_PTR_INDEX_BITS)
+
+// fails to compile when @n buffers do not fit in a QCameraPtrIndex
+#define QCAMERA_PTR_INDEX_CHECK_CAPACITY(n) \
+    typedef char qcamera_ptr_index_capacity_check \
+        [((n) <= QCAMERA_PTR_INDEX_SIZE / 2) ? 1 : -1]
+
+// Open addressing pointer -> buffer index map, kept next to the buffer
+// arrays of the memory classes so a pointer coming back from the
+// framework is resolved without scanning them. Holds up to half of
+// QCAMERA_PTR_INDEX_SIZE entries; users check their largest buffer array
+// against it with QCAMERA_PTR_INDEX_CHECK_CAPACITY.
+// The first index added for a pointer wins, the same way a scan of the
+// array from its start would resolve duplicates.
+class QCameraPtrIndex {
+public:
+    QCameraPtrIndex() { clear(); }
+
+    void clear()
+    {
+        memset(mKey, 0, sizeof(mKey));
+        mCount = 0;
+    }
+
+    // false for NULL or when the map is full
+    bool add(const void *ptr, int index)
+    {
+        if (ptr == NULL || mCount >= QCAMERA_PTR_INDEX_SIZE / 2) {
+            return false;
+        }
+        uint32_t slot = hash(ptr);
+        while (mKey[slot] != NULL) {
+            if (mKey[slot] == ptr) {
+                return true;
+            }
+            slot = (slot + 1) & (QCAMERA_PTR_INDEX_SIZE - 1);
+        }
+        mKey[slot] = ptr;
+        mIndex[slot] = (int16_t)index;
+        mCount++;
+        return true;
+    }
+
+    // drops the pointer, entries behind it move back so their probe
+    // sequence stays unbroken
+    void remove(const void *ptr)
+    {
+        if (ptr == NULL) {
+            return;
+        }
+        uint32_t slot = hash(ptr);
+        while (mKey[slot] != ptr) {
+            if (mKey[slot] == NULL) {
+                return;
+            }
+            slot = (slot + 1) & (QCAMERA_PTR_INDEX_SIZE - 1);
+        }
+        uint32_t next = slot;
+        while (true) {
+            next = (next + 1) & (QCAMERA_PTR_INDEX_SIZE - 1);
+            if (mKey[next] == NULL) {
+                break;
+            }
+            // keep the entry unless its home slot lies in (slot, next]
+            uint32_t home = hash(mKey[next]);
+            if (((next - home) & (QCAMERA_PTR_INDEX_SIZE - 1)) >=
+                    ((next - slot) & (QCAMERA_PTR_INDEX_SIZE - 1))) {
+                mKey[slot] = mKey[next];
+                mIndex[slot] = mIndex[next];
+                slot = next;
+            }
+        }
+        mKey[slot] = NULL;
+        mCount--;
+    }
+
+    // buffer index of the pointer, -1 if it is not in the map
+    int find(const void *ptr) const
+    {
+        if (ptr == NULL) {
+            return -1;
+        }
+        uint32_t slot = hash(ptr);
+        while (mKey[slot] != NULL) {
+            if (mKey[slot] == ptr) {
+                return (int)mIndex[slot];
+            }
+            slot = (slot + 1) & (QCAMERA_PTR_INDEX_SIZE - 1);
+        }
+        return -1;
+    }
+
+    uint32_t size() const { return mCount; }
+
+private:
+    // buffers are page or allocator aligned, so the low bits carry
+    // little; fibonacci hashing takes the slot from the top bits
+    static uint32_t hash(const void *ptr)
+    {
+        uint64_t v = (uint64_t)(uintptr_t)ptr;
+        v = (v ^ (v >> 32)) * 0x9E3779B97F4A7C15ULL;
+        return (uint32_t)(v >> (64 - QCAMERA_PTR_INDEX_BITS));
+    }
+
+    const void *mKey[QCAMERA_PTR_INDEX_SIZE];   // NULL if unused
+    int16_t mIndex[QCAMERA_PTR_INDEX_SIZE];
+    uint32_t mCount;
+};
+
+}; // namespace qcamera
+
+#endif /* __QCAMERA_PTR_INDEX_H__ */
@@ -0,0 +1,465 @@
+/* Copyright (c) 2014, The Linux Foundataion. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <utils/Errors.h>
+#include <utils/Log.h>
+#include "QCameraRingQueue.h"
+
+namespace qcamera {
+
+/*===========================================================================
+ * FUNCTION   : QCameraRingQueue
+ *
+ * DESCRIPTION: constructor of QCameraRingQueue
+ *
+ * PARAMETERS :
+ *   @capacity : max number of nodes, rounded up to power of 2
+ *   @mode     : single or multiple producer mode
+ *
+ * RETURN     : None
+ *==========================================================================*/
+QCameraRingQueue::QCameraRingQueue(uint32_t capacity, ring_queue_mode_t mode)
+{
+    init(capacity, mode, NULL, NULL);
+}
+
+/*===========================================================================
+ * FUNCTION   : QCameraRingQueue
+ *
+ * DESCRIPTION: constructor of QCameraRingQueue
+ *
+ * PARAMETERS :
+ *   @capacity    : max number of nodes, rounded up to power of 2
+ *   @mode        : single or multiple producer mode
+ *   @data_rel_fn : function ptr to release node data internal resource
+ *   @user_data   : user data ptr
+ *
+ * RETURN     : None
+ *==========================================================================*/
+QCameraRingQueue::QCameraRingQueue(uint32_t capacity, ring_queue_mode_t mode,
+                                   release_data_fn data_rel_fn, void *user_data)
+{
+    init(capacity, mode, data_rel_fn, user_data);
+}
+
+/*===========================================================================
+ * FUNCTION   : ~QCameraRingQueue
+ *
+ * DESCRIPTION: deconstructor of QCameraRingQueue
+ *
+ * PARAMETERS : None
+ *
+ * RETURN     : None
+ *==========================================================================*/
+QCameraRingQueue::~QCameraRingQueue()
+{
+    flush();
+    ringDeinit(&m_prioRing);
+    ringDeinit(&m_ring);
+}
+
+/*===========================================================================
+ * FUNCTION   : init
+ *
+ * DESCRIPTION: allocate slots of both rings
+ *
+ * PARAMETERS :
+ *   @capacity    : max number of nodes, rounded up to power of 2
+ *   @mode        : single or multiple producer mode
+ *   @data_rel_fn : function ptr to release node data internal resource
+ *   @user_data   : user data ptr
+ *
+ * RETURN     : None
+ *==========================================================================*/
+void QCameraRingQueue::init(uint32_t capacity, ring_queue_mode_t mode,
+                            release_data_fn data_rel_fn, void *user_data)
+{
+    m_mode = mode;
+    m_size = 0;
+    m_dropCnt = 0;
+    m_dataFn = data_rel_fn;
+    m_userData = user_data;
+    if (!ringInit(&m_ring, capacity) || !ringInit(&m_prioRing, capacity)) {
+        ALOGE("%s: No memory for %d ring slots", __func__, capacity);
+    }
+}
+
+/*===========================================================================
+ * FUNCTION   : ringInit
+ *
+ * DESCRIPTION: allocate and initialize slots of one ring
+ *
+ * PARAMETERS :
+ *   @ring     : ring to be initialized
+ *   @capacity : requested number of slots
+ *
+ * RETURN     : true -- success; false -- failed
+ *==========================================================================*/
+bool QCameraRingQueue::ringInit(ring_t *ring, uint32_t capacity)
+{
+    uint32_t size = 2;
+    while (size < capacity) {
+        size <<= 1;
+    }
+
+    memset(ring, 0, sizeof(ring_t));
+    ring->slots = (ring_slot_t *)malloc(sizeof(ring_slot_t) * size);
+    if (NULL == ring->slots) {
+        return false;
+    }
+    for (uint32_t i = 0; i < size; i++) {
+        ring->slots[i].seq = i;
+        ring->slots[i].data = NULL;
+    }
+    ring->mask = size - 1;
+    return true;
+}
+
+/*===========================================================================
+ * FUNCTION   : ringDeinit
+ *
+ * DESCRIPTION: free slots of one ring
+ *
+ * PARAMETERS :
+ *   @ring    : ring to be released
+ *
+ * RETURN     : None
+ *==========================================================================*/
+void QCameraRingQueue::ringDeinit(ring_t *ring)
+{
+    if (NULL != ring->slots) {
+        free(ring->slots);
+        ring->slots = NULL;
+    }
+}
+
+/*===========================================================================
+ * FUNCTION   : ringPush
+ *
+ * DESCRIPTION: claim the next free slot and publish data in it. A slot is
+ *              free for position pos when its sequence equals pos, and
+ *              ready for the consumer when it equals pos + 1.
+ *
+ * PARAMETERS :
+ *   @ring    : ring to push into
+ *   @data    : data to be pushed
+ *
+ * RETURN     : true -- success; false -- ring is full
+ *==========================================================================*/
+bool QCameraRingQueue::ringPush(ring_t *ring, void *data)
+{
+    ring_slot_t *slot = NULL;
+    uint32_t pos = __atomic_load_n(&ring->enq_pos, __ATOMIC_RELAXED);
+
+    if (NULL == ring->slots) {
+        return false;
+    }
+
+    for (;;) {
+        slot = &ring->slots[pos & ring->mask];
+        uint32_t seq = __atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE);
+        int32_t diff = (int32_t)(seq - pos);
+        if (diff == 0) {
+            if (RING_QUEUE_SPSC == m_mode) {
+                __atomic_store_n(&ring->enq_pos, pos + 1, __ATOMIC_RELAXED);
+                break;
+            }
+            if (__atomic_compare_exchange_n(&ring->enq_pos, &pos, pos + 1,
+                    true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                break;
+            }
+        } else if (diff < 0) {
+            return false;
+        } else {
+            pos = __atomic_load_n(&ring->enq_pos, __ATOMIC_RELAXED);
+        }
+    }
+
+    slot->data = data;
+    __atomic_add_fetch(&m_size, 1, __ATOMIC_RELAXED);
+    __atomic_store_n(&slot->seq, pos + 1, __ATOMIC_RELEASE);
+    return true;
+}
+
+/*===========================================================================
+ * FUNCTION   : ringPop
+ *
+ * DESCRIPTION: take the oldest ready node out of one ring, skipping nodes
+ *              that were already flushed
+ *
+ * PARAMETERS :
+ *   @ring    : ring to pop from
+ *
+ * RETURN     : data ptr. NULL if not any data in the ring.
+ *==========================================================================*/
+void *QCameraRingQueue::ringPop(ring_t *ring)
+{
+    void *data = NULL;
+
+    if (NULL == ring->slots) {
+        return NULL;
+    }
+
+    while (NULL == data) {
+        uint32_t pos = ring->deq_pos;
+        ring_slot_t *slot = &ring->slots[pos & ring->mask];
+        uint32_t seq = __atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE);
+        if (seq != pos + 1) {
+            break;
+        }
+        data = slot->data;
+        slot->data = NULL;
+        __atomic_store_n(&slot->seq, pos + ring->mask + 1, __ATOMIC_RELEASE);
+        ring->deq_pos = pos + 1;
+    }
+
+    if (NULL != data) {
+        __atomic_sub_fetch(&m_size, 1, __ATOMIC_RELAXED);
+    }
+    return data;
+}
+
+/*===========================================================================
+ * FUNCTION   : ringFlush
+ *
+ * DESCRIPTION: release ready nodes of one ring in place. Released slots keep
+ *              their position and are skipped by ringPop, so the order of
+ *              the remaining nodes is unchanged.
+ *
+ * PARAMETERS :
+ *   @ring       : ring to be flushed
+ *   @match      : matching function, NULL to flush all nodes
+ *   @match_data : matching function with data, used if match is NULL
+ *   @spec_data  : data passed to match_data
+ *
+ * RETURN     : None
+ *==========================================================================*/
+void QCameraRingQueue::ringFlush(ring_t *ring, match_fn match,
+                                 match_fn_data match_data, void *spec_data)
+{
+    if (NULL == ring->slots) {
+        return;
+    }
+
+    for (uint32_t pos = ring->deq_pos; ; pos++) {
+        ring_slot_t *slot = &ring->slots[pos & ring->mask];
+        if (__atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE) != pos + 1) {
+            break;
+        }
+        void *data = slot->data;
+        if (NULL == data) {
+            continue;
+        }
+        if ((NULL != match && !match(data, m_userData)) ||
+            (NULL != match_data && !match_data(data, m_userData, spec_data))) {
+            continue;
+        }
+        slot->data = NULL;
+        __atomic_sub_fetch(&m_size, 1, __ATOMIC_RELAXED);
+        releaseData(data);
+    }
+}
+
+/*===========================================================================
+ * FUNCTION   : releaseData
+ *
+ * DESCRIPTION: release node data the same way QCameraQueue does
+ *
+ * PARAMETERS :
+ *   @data    : node data
+ *
+ * RETURN     : None
+ *==========================================================================*/
+void QCameraRingQueue::releaseData(void *data)
+{
+    if (m_dataFn) {
+        m_dataFn(data, m_userData);
+    }
+    free(data);
+}
+
+/*===========================================================================
+ * FUNCTION   : isEmpty
+ *
+ * DESCRIPTION: return if the queue is empty or not
+ *
+ * PARAMETERS : None
+ *
+ * RETURN     : true -- queue is empty; false -- not empty
+ *==========================================================================*/
+bool QCameraRingQueue::isEmpty()
+{
+    return __atomic_load_n(&m_size, __ATOMIC_RELAXED) <= 0;
+}
+
+/*===========================================================================
+ * FUNCTION   : getDropCount
+ *
+ * DESCRIPTION: number of enqueue requests rejected because the queue was full
+ *
+ * PARAMETERS : None
+ *
+ * RETURN     : drop count
+ *==========================================================================*/
+uint32_t QCameraRingQueue::getDropCount()
+{
+    return __atomic_load_n(&m_dropCnt, __ATOMIC_RELAXED);
+}
+
+/*===========================================================================
+ * FUNCTION   : enqueue
+ *
+ * DESCRIPTION: enqueue data into the queue
+ *
+ * PARAMETERS :
+ *   @data    : data to be enqueued, must not be NULL
+ *
+ * RETURN     : true -- success; false -- queue is full
+ *==========================================================================*/
+bool QCameraRingQueue::enqueue(void *data)
+{
+    if (NULL == data) {
+        return false;
+    }
+    if (!ringPush(&m_ring, data)) {
+        __atomic_add_fetch(&m_dropCnt, 1, __ATOMIC_RELAXED);
+        ALOGE("%s: Ring queue full", __func__);
+        return false;
+    }
+    return true;
+}
+
+/*===========================================================================
+ * FUNCTION   : enqueueWithPriority
+ *
+ * DESCRIPTION: enqueue data into queue with priority, it will be dequeued
+ *              ahead of all normal priority nodes. Priority nodes are
+ *              dequeued in the order they were enqueued; QCameraQueue
+ *              inserts them at the head, so its newest priority node
+ *              comes out first.
+ *
+ * PARAMETERS :
+ *   @data    : data to be enqueued, must not be NULL
+ *
+ * RETURN     : true -- success; false -- queue is full
+ *==========================================================================*/
+bool QCameraRingQueue::enqueueWithPriority(void *data)
+{
+    if (NULL == data) {
+        return false;
+    }
+    if (!ringPush(&m_prioRing, data)) {
+        __atomic_add_fetch(&m_dropCnt, 1, __ATOMIC_RELAXED);
+        ALOGE("%s: Priority ring queue full", __func__);
+        return false;
+    }
+    return true;
+}
+
+/*===========================================================================
+ * FUNCTION   : dequeue
+ *
+ * DESCRIPTION: dequeue data from the head of the queue
+ *
+ * PARAMETERS : None
+ *
+ * RETURN     : data ptr. NULL if not any data in the queue.
+ *==========================================================================*/
+void* QCameraRingQueue::dequeue()
+{
+    void *data = ringPop(&m_prioRing);
+    if (NULL == data) {
+        data = ringPop(&m_ring);
+    }
+    return data;
+}
+
+/*===========================================================================
+ * FUNCTION   : flush
+ *
+ * DESCRIPTION: flush all nodes from the queue, queue will be empty after this
+ *              operation.
+ *
+ * PARAMETERS : None
+ *
+ * RETURN     : None
+ *==========================================================================*/
+void QCameraRingQueue::flush()
+{
+    void *data = dequeue();
+    while (NULL != data) {
+        releaseData(data);
+        data = dequeue();
+    }
+}
+
+/*===========================================================================
+ * FUNCTION   : flushNodes
+ *
+ * DESCRIPTION: flush only specific nodes, depending on
+ *              the given matching function.
+ *
+ * PARAMETERS :
+ *   @match   : matching function
+ *
+ * RETURN     : None
+ *==========================================================================*/
+void QCameraRingQueue::flushNodes(match_fn match)
+{
+    if ( NULL == match ) {
+        return;
+    }
+    ringFlush(&m_prioRing, match, NULL, NULL);
+    ringFlush(&m_ring, match, NULL, NULL);
+}
+
+/*===========================================================================
+ * FUNCTION   : flushNodes
+ *
+ * DESCRIPTION: flush only specific nodes, depending on
+ *              the given matching function.
+ *
+ * PARAMETERS :
+ *   @match     : matching function
+ *   @spec_data : data passed to matching function
+ *
+ * RETURN     : None
+ *==========================================================================*/
+void QCameraRingQueue::flushNodes(match_fn_data match, void *spec_data)
+{
+    if ( NULL == match ) {
+        return;
+    }
+    ringFlush(&m_prioRing, NULL, match, spec_data);
+    ringFlush(&m_ring, NULL, match, spec_data);
+}
+
+}; // namespace qcamera
@@ -0,0 +1,97 @@
+/* Copyright (c) 2014, The Linux Foundataion. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef __QCAMERA_RING_QUEUE_H__
+#define __QCAMERA_RING_QUEUE_H__
+
+#include <stdint.h>
+#include "QCameraQueue.h"
+
+namespace qcamera {
+
+typedef enum {
+    RING_QUEUE_SPSC,    // single producer, single consumer
+    RING_QUEUE_MPSC,    // multiple producers, single consumer
+} ring_queue_mode_t;
+
+// Bounded, allocation free alternative to QCameraQueue. Producers never
+// block or take a lock. dequeue, flush and flushNodes belong to the
+// consumer and must only be called from a single thread at a time.
+// Unlike QCameraQueue, nodes enqueued with priority keep FIFO order
+// among themselves.
+class QCameraRingQueue {
+public:
+    QCameraRingQueue(uint32_t capacity, ring_queue_mode_t mode);
+    QCameraRingQueue(uint32_t capacity, ring_queue_mode_t mode,
+                     release_data_fn data_rel_fn, void *user_data);
+    virtual ~QCameraRingQueue();
+    bool enqueue(void *data);
+    bool enqueueWithPriority(void *data);
+    void flush();
+    void flushNodes(match_fn match);
+    void flushNodes(match_fn_data match, void *spec_data);
+    void* dequeue();
+    bool isEmpty();
+    uint32_t getDropCount();
+private:
+    typedef struct {
+        uint32_t seq;   // slot sequence, tells producers/consumer who owns it
+        void *data;     // NULL once the node has been flushed
+    } ring_slot_t;
+
+    typedef struct {
+        ring_slot_t *slots;
+        uint32_t mask;
+        uint32_t enq_pos;
+        uint8_t pad[60];  // keep producer and consumer indexes apart
+        uint32_t deq_pos;
+    } ring_t;
+
+    void init(uint32_t capacity, ring_queue_mode_t mode,
+              release_data_fn data_rel_fn, void *user_data);
+    bool ringInit(ring_t *ring, uint32_t capacity);
+    void ringDeinit(ring_t *ring);
+    bool ringPush(ring_t *ring, void *data);
+    void *ringPop(ring_t *ring);
+    void ringFlush(ring_t *ring, match_fn match,
+                   match_fn_data match_data, void *spec_data);
+    void releaseData(void *data);
+
+    ring_t m_ring;          // normal priority nodes
+    ring_t m_prioRing;      // nodes enqueued with priority
+    ring_queue_mode_t m_mode;
+    int32_t m_size;
+    uint32_t m_dropCnt;
+    release_data_fn m_dataFn;
+    void * m_userData;
+};
+
+}; // namespace qcamera
+
+#endif /* __QCAMERA_RING_QUEUE_H__ */
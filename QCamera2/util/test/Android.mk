@@ -0,0 +1,109 @@
+LOCAL_PATH:= $(call my-dir)
+
+#lookup map translation bench
+
+include $(CLEAR_VARS)
+LOCAL_MODULE_TAGS := optional
+
+LOCAL_CFLAGS := -Wall -Wextra -Werror
+
+LOCAL_C_INCLUDES := $(LOCAL_PATH)/..
+
+LOCAL_SRC_FILES := qcamera_lookup_bench.cpp
+
+LOCAL_MODULE           := qcamera-lookup-bench
+LOCAL_PRELINK_MODULE   := false
+
+include $(BUILD_EXECUTABLE)
+
+#shared stream executor test
+
+include $(CLEAR_VARS)
+LOCAL_MODULE_TAGS := optional
+
+LOCAL_CFLAGS := -Wall -Wextra -Werror
+
+LOCAL_C_INCLUDES := $(LOCAL_PATH)/..
+LOCAL_C_INCLUDES += $(LOCAL_PATH)/../../stack/common
+
+LOCAL_SRC_FILES := qcamera_executor_test.cpp ../QCameraExecutor.cpp
+
+LOCAL_SHARED_LIBRARIES := liblog libutils
+
+LOCAL_MODULE           := qcamera-executor-test
+LOCAL_PRELINK_MODULE   := false
+
+include $(BUILD_EXECUTABLE)
+
+#command thread test
+
+include $(CLEAR_VARS)
+LOCAL_MODULE_TAGS := optional
+
+LOCAL_CFLAGS := -Wall -Wextra -Werror
+
+LOCAL_C_INCLUDES := $(LOCAL_PATH)/..
+LOCAL_C_INCLUDES += $(LOCAL_PATH)/../../stack/common
+
+LOCAL_SRC_FILES := qcamera_cmdthread_test.cpp ../QCameraCmdThread.cpp ../QCameraQueue.cpp
+
+LOCAL_SHARED_LIBRARIES := liblog libutils
+
+LOCAL_MODULE           := qcamera-cmdthread-test
+LOCAL_PRELINK_MODULE   := false
+
+include $(BUILD_EXECUTABLE)
+
+#buffer pointer index test and bench
+
+include $(CLEAR_VARS)
+LOCAL_MODULE_TAGS := optional
+
+LOCAL_CFLAGS := -Wall -Wextra -Werror
+
+LOCAL_C_INCLUDES := $(LOCAL_PATH)/..
+
+LOCAL_SRC_FILES := qcamera_ptrindex_test.cpp
+
+LOCAL_MODULE           := qcamera-ptrindex-test
+LOCAL_PRELINK_MODULE   := false
+
+include $(BUILD_EXECUTABLE)
+
+#capability cache test
+
+include $(CLEAR_VARS)
+LOCAL_MODULE_TAGS := optional
+
+LOCAL_CFLAGS := -Wall -Wextra -Werror
+
+LOCAL_C_INCLUDES := $(LOCAL_PATH)/..
+LOCAL_C_INCLUDES += $(LOCAL_PATH)/../../stack/common
+
+LOCAL_SRC_FILES := qcamera_capscache_test.cpp ../QCameraCapsCache.cpp
+
+LOCAL_SHARED_LIBRARIES := liblog libutils libcutils libdl
+
+LOCAL_MODULE           := qcamera-capscache-test
+LOCAL_PRELINK_MODULE   := false
+
+include $(BUILD_EXECUTABLE)
+
+#ring queue contention bench
+
+include $(CLEAR_VARS)
+LOCAL_MODULE_TAGS := optional
+
+LOCAL_CFLAGS := -Wall -Wextra -Werror
+
+LOCAL_C_INCLUDES := $(LOCAL_PATH)/..
+LOCAL_C_INCLUDES += $(LOCAL_PATH)/../../stack/common
+
+LOCAL_SRC_FILES := qcamera_ringqueue_bench.cpp ../QCameraRingQueue.cpp ../QCameraQueue.cpp
+
+LOCAL_SHARED_LIBRARIES := liblog libutils
+
+LOCAL_MODULE           := qcamera-ringqueue-bench
+LOCAL_PRELINK_MODULE   := false
+
+include $(BUILD_EXECUTABLE)
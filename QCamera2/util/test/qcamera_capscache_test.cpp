@@ -0,0 +1,274 @@
+/* Copyright (c) 2014, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+/* Unit test and microbenchmark for QCameraCapsCache.
+ *
+ * Stores a capability sized blob and reads it back, then checks that a
+ * cache built for another sensor, a file with a bad checksum, version
+ * or length, and a blob of another size are all refused and deleted,
+ * and that invalidate removes every blob of the camera.
+ *
+ * Then reports how long loading the capability from the cache takes.
+ * This is what camera open pays in place of the backend round trip.
+ *
+ * usage: qcamera-capscache-test [cache dir] [iterations]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <utils/Errors.h>
+#include "cam_intf.h"
+#include "QCameraCapsCache.h"
+
+using namespace android;
+using namespace qcamera;
+
+#define TEST_DEFAULT_DIR "/data/local/tmp"
+#define TEST_BENCH_ITER 1000
+#define TEST_CAMERA_ID 7
+#define TEST_BLOB_SIZE sizeof(cam_capability_t)
+
+static int g_failures = 0;
+
+#define TEST_CHECK(cond) do { \
+    if (!(cond)) { \
+        printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+        g_failures++; \
+    } \
+} while (0)
+
+static int64_t testNowNs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static void fillBlob(uint8_t *blob, size_t size, uint32_t seed)
+{
+    for (size_t i = 0; i < size; i++) {
+        blob[i] = (uint8_t)((i * 31 + seed) >> 3);
+    }
+}
+
+static bool fileExists(const char *dir, const char *name, const char *ext)
+{
+    char path[QCAMERA_CACHE_PATH_LEN];
+    snprintf(path, sizeof(path), "%s/%s_%d.%s", dir, name, TEST_CAMERA_ID, ext);
+    return access(path, F_OK) == 0;
+}
+
+/* overwrite one byte of the stored capability blob file */
+static void patchFile(const char *dir, off_t offset, uint8_t val)
+{
+    char path[QCAMERA_CACHE_PATH_LEN];
+    snprintf(path, sizeof(path), "%s/hal3_caps_%d.bin", dir, TEST_CAMERA_ID);
+    int fd = open(path, O_WRONLY);
+    TEST_CHECK(fd >= 0);
+    if (fd >= 0) {
+        TEST_CHECK(pwrite(fd, &val, 1, offset) == 1);
+        close(fd);
+    }
+}
+
+static void truncateFile(const char *dir, off_t len)
+{
+    char path[QCAMERA_CACHE_PATH_LEN];
+    snprintf(path, sizeof(path), "%s/hal3_caps_%d.bin", dir, TEST_CAMERA_ID);
+    TEST_CHECK(truncate(path, len) == 0);
+}
+
+static void testRoundTrip(const char *dir, uint8_t *blob, uint8_t *out)
+{
+    QCameraCapsCache cache(TEST_CAMERA_ID, "imx135", 0, 90, dir);
+    const void *data;
+    size_t size = 0;
+
+    TEST_CHECK(cache.isEnabled());
+    cache.invalidate();
+    TEST_CHECK(cache.load(QCAMERA_CACHE_HAL3_CAPABILITY, out, TEST_BLOB_SIZE)
+            == NAME_NOT_FOUND);
+    TEST_CHECK(cache.store(QCAMERA_CACHE_HAL3_CAPABILITY, NULL, 16)
+            == BAD_VALUE);
+
+    fillBlob(blob, TEST_BLOB_SIZE, 1);
+    TEST_CHECK(cache.store(QCAMERA_CACHE_HAL3_CAPABILITY, blob,
+            TEST_BLOB_SIZE) == NO_ERROR);
+    TEST_CHECK(fileExists(dir, "hal3_caps", "bin"));
+    TEST_CHECK(!fileExists(dir, "hal3_caps", "bin.tmp"));
+    memset(out, 0, TEST_BLOB_SIZE);
+    TEST_CHECK(cache.load(QCAMERA_CACHE_HAL3_CAPABILITY, out, TEST_BLOB_SIZE)
+            == NO_ERROR);
+    TEST_CHECK(memcmp(blob, out, TEST_BLOB_SIZE) == 0);
+
+    /* blobs of another type are kept apart */
+    TEST_CHECK(cache.load(QCAMERA_CACHE_HAL1_CAPABILITY, out, TEST_BLOB_SIZE)
+            == NAME_NOT_FOUND);
+
+    /* mapped blobs are aligned for camera_metadata_t */
+    TEST_CHECK(cache.store(QCAMERA_CACHE_HAL3_STATIC_META, blob, 1000)
+            == NO_ERROR);
+    data = cache.map(QCAMERA_CACHE_HAL3_STATIC_META, &size);
+    TEST_CHECK(data != NULL);
+    if (data != NULL) {
+        TEST_CHECK(size == 1000);
+        TEST_CHECK(((uintptr_t)data & 7) == 0);
+        TEST_CHECK(memcmp(data, blob, size) == 0);
+        QCameraCapsCache::unmap(data, size);
+    }
+
+    /* rewriting replaces the blob */
+    fillBlob(blob, TEST_BLOB_SIZE, 2);
+    TEST_CHECK(cache.store(QCAMERA_CACHE_HAL3_CAPABILITY, blob,
+            TEST_BLOB_SIZE) == NO_ERROR);
+    TEST_CHECK(cache.load(QCAMERA_CACHE_HAL3_CAPABILITY, out, TEST_BLOB_SIZE)
+            == NO_ERROR);
+    TEST_CHECK(memcmp(blob, out, TEST_BLOB_SIZE) == 0);
+}
+
+static void testReject(const char *dir, uint8_t *blob, uint8_t *out)
+{
+    QCameraCapsCache cache(TEST_CAMERA_ID, "imx135", 0, 90, dir);
+
+    /* another sensor, or the same one mounted differently */
+    fillBlob(blob, TEST_BLOB_SIZE, 3);
+    TEST_CHECK(cache.store(QCAMERA_CACHE_HAL3_CAPABILITY, blob,
+            TEST_BLOB_SIZE) == NO_ERROR);
+    {
+        QCameraCapsCache other(TEST_CAMERA_ID, "ov2720", 0, 90, dir);
+        TEST_CHECK(other.load(QCAMERA_CACHE_HAL3_CAPABILITY, out,
+                TEST_BLOB_SIZE) == NAME_NOT_FOUND);
+    }
+    TEST_CHECK(!fileExists(dir, "hal3_caps", "bin"));
+    TEST_CHECK(cache.store(QCAMERA_CACHE_HAL3_CAPABILITY, blob,
+            TEST_BLOB_SIZE) == NO_ERROR);
+    {
+        QCameraCapsCache other(TEST_CAMERA_ID, "imx135", 0, 270, dir);
+        TEST_CHECK(other.load(QCAMERA_CACHE_HAL3_CAPABILITY, out,
+                TEST_BLOB_SIZE) == NAME_NOT_FOUND);
+    }
+
+    /* corrupted blob */
+    TEST_CHECK(cache.store(QCAMERA_CACHE_HAL3_CAPABILITY, blob,
+            TEST_BLOB_SIZE) == NO_ERROR);
+    patchFile(dir, 32 + TEST_BLOB_SIZE / 2, (uint8_t)~blob[TEST_BLOB_SIZE / 2]);
+    TEST_CHECK(cache.load(QCAMERA_CACHE_HAL3_CAPABILITY, out, TEST_BLOB_SIZE)
+            == NAME_NOT_FOUND);
+    TEST_CHECK(!fileExists(dir, "hal3_caps", "bin"));
+
+    /* older cache version */
+    TEST_CHECK(cache.store(QCAMERA_CACHE_HAL3_CAPABILITY, blob,
+            TEST_BLOB_SIZE) == NO_ERROR);
+    patchFile(dir, 4, QCAMERA_CACHE_VERSION + 1);
+    TEST_CHECK(cache.load(QCAMERA_CACHE_HAL3_CAPABILITY, out, TEST_BLOB_SIZE)
+            == NAME_NOT_FOUND);
+
+    /* cut short while written by an old build */
+    TEST_CHECK(cache.store(QCAMERA_CACHE_HAL3_CAPABILITY, blob,
+            TEST_BLOB_SIZE) == NO_ERROR);
+    truncateFile(dir, 32 + TEST_BLOB_SIZE - 8);
+    TEST_CHECK(cache.load(QCAMERA_CACHE_HAL3_CAPABILITY, out, TEST_BLOB_SIZE)
+            == NAME_NOT_FOUND);
+    TEST_CHECK(cache.store(QCAMERA_CACHE_HAL3_CAPABILITY, blob,
+            TEST_BLOB_SIZE) == NO_ERROR);
+    truncateFile(dir, 10);
+    TEST_CHECK(cache.load(QCAMERA_CACHE_HAL3_CAPABILITY, out, TEST_BLOB_SIZE)
+            == NAME_NOT_FOUND);
+
+    /* structure layout changed */
+    TEST_CHECK(cache.store(QCAMERA_CACHE_HAL3_CAPABILITY, blob,
+            TEST_BLOB_SIZE - 4) == NO_ERROR);
+    TEST_CHECK(cache.load(QCAMERA_CACHE_HAL3_CAPABILITY, out, TEST_BLOB_SIZE)
+            == BAD_VALUE);
+    TEST_CHECK(!fileExists(dir, "hal3_caps", "bin"));
+
+    /* invalidate drops every blob of the camera */
+    TEST_CHECK(cache.store(QCAMERA_CACHE_HAL1_CAPABILITY, blob,
+            TEST_BLOB_SIZE) == NO_ERROR);
+    TEST_CHECK(cache.store(QCAMERA_CACHE_HAL3_STATIC_META, blob, 64)
+            == NO_ERROR);
+    cache.invalidate();
+    TEST_CHECK(!fileExists(dir, "hal1_caps", "bin"));
+    TEST_CHECK(!fileExists(dir, "hal3_meta", "bin"));
+}
+
+static void bench(const char *dir, uint8_t *blob, uint8_t *out, int iter)
+{
+    QCameraCapsCache cache(TEST_CAMERA_ID, "imx135", 0, 90, dir);
+    int64_t t;
+    int i;
+
+    fillBlob(blob, TEST_BLOB_SIZE, 4);
+    t = testNowNs();
+    TEST_CHECK(cache.store(QCAMERA_CACHE_HAL3_CAPABILITY, blob,
+            TEST_BLOB_SIZE) == NO_ERROR);
+    t = testNowNs() - t;
+    printf("capability %zu bytes, store %lld us\n", TEST_BLOB_SIZE,
+           (long long)(t / 1000));
+
+    t = testNowNs();
+    for (i = 0; i < iter; i++) {
+        if (cache.load(QCAMERA_CACHE_HAL3_CAPABILITY, out, TEST_BLOB_SIZE)
+                != NO_ERROR) {
+            g_failures++;
+            break;
+        }
+    }
+    t = testNowNs() - t;
+    printf("load %lld us avg over %d iterations\n",
+           (long long)(t / 1000 / iter), iter);
+    cache.invalidate();
+}
+
+int main(int argc, char **argv)
+{
+    const char *dir = (argc > 1) ? argv[1] : TEST_DEFAULT_DIR;
+    int iter = (argc > 2) ? atoi(argv[2]) : TEST_BENCH_ITER;
+    uint8_t *blob = (uint8_t *)malloc(TEST_BLOB_SIZE);
+    uint8_t *out = (uint8_t *)malloc(TEST_BLOB_SIZE);
+
+    if ((blob == NULL) || (out == NULL) || (iter < 1)) {
+        printf("usage: %s [cache dir] [iterations]\n", argv[0]);
+        return 1;
+    }
+
+    testRoundTrip(dir, blob, out);
+    testReject(dir, blob, out);
+    bench(dir, blob, out, iter);
+
+    free(blob);
+    free(out);
+    printf("%s: %d failures\n", (g_failures == 0) ? "PASS" : "FAIL", g_failures);
+    return (g_failures == 0) ? 0 : 1;
+}
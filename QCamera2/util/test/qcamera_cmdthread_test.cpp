@@ -0,0 +1,422 @@
+/* Copyright (c) 2014, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+/* Functional test and benchmark for QCameraCmdThread.
+ *
+ * Runs a thread routine shaped like the stream and postproc ones
+ * (cam_sem_wait on cmd_sem, then getCmd) and checks that every
+ * DO_NEXT_JOB sent is dequeued once even when posts are folded, that
+ * commands keep their order around folded posts, that priority
+ * commands go first, that sync commands return once the routine
+ * posted sync_sem, that a full ring rejects new commands and that the
+ * wait of a folded post is counted from its own post time.
+ *
+ * Then times a stream of DO_NEXT_JOB and sync round trips, once on
+ * the command thread and once on the malloc + QCameraQueue +
+ * cam_semaphore_t path it replaced.
+ *
+ * usage: qcamera-cmdthread-test [iterations]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <utils/Errors.h>
+#include "QCameraCmdThread.h"
+
+using namespace android;
+using namespace qcamera;
+
+#define TEST_PRODUCERS 4
+#define TEST_JOBS 5000
+#define TEST_BENCH_ITER 100000
+#define TEST_SYNC_ITER 10000
+
+static int g_failures = 0;
+
+#define TEST_CHECK(cond) do { \
+    if (!(cond)) { \
+        printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+        g_failures++; \
+    } \
+} while (0)
+
+static int64_t testNowUs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+typedef struct {
+    QCameraCmdThread thread;
+    uint32_t cmds[CAMERA_CMD_TYPE_MAX];
+    bool started;           // START_DATA_PROC seen
+    bool jobOutsideRun;     // DO_NEXT_JOB seen before START or after STOP
+    pthread_mutex_t gate;   // held by the test to block the routine
+    bool useGate;
+    volatile int32_t inJob;
+} test_ctx_t;
+
+static void *testRoutine(void *data)
+{
+    test_ctx_t *t = (test_ctx_t *)data;
+    QCameraCmdThread *cmdThread = &t->thread;
+    bool running = true;
+
+    cmdThread->setName("CAM_cmdTest");
+    while (running) {
+        cam_sem_wait(&cmdThread->cmd_sem);
+        camera_cmd_type_t cmd = cmdThread->getCmd();
+        t->cmds[cmd]++;
+        switch (cmd) {
+        case CAMERA_CMD_TYPE_START_DATA_PROC:
+            t->started = true;
+            cam_sem_post(&cmdThread->sync_sem);
+            break;
+        case CAMERA_CMD_TYPE_STOP_DATA_PROC:
+            t->started = false;
+            cam_sem_post(&cmdThread->sync_sem);
+            break;
+        case CAMERA_CMD_TYPE_DO_NEXT_JOB:
+            if (!t->started) {
+                t->jobOutsideRun = true;
+            }
+            if (t->useGate) {
+                __sync_fetch_and_add(&t->inJob, 1);
+                pthread_mutex_lock(&t->gate);
+                pthread_mutex_unlock(&t->gate);
+            }
+            break;
+        case CAMERA_CMD_TYPE_EXIT:
+            running = false;
+            break;
+        default:
+            break;
+        }
+    }
+    return NULL;
+}
+
+static void testInit(test_ctx_t *t)
+{
+    memset(t->cmds, 0, sizeof(t->cmds));
+    t->started = false;
+    t->jobOutsideRun = false;
+    t->useGate = false;
+    t->inJob = 0;
+    pthread_mutex_init(&t->gate, NULL);
+}
+
+static void *testProducer(void *data)
+{
+    test_ctx_t *t = (test_ctx_t *)data;
+    for (uint32_t i = 0; i < TEST_JOBS; i++) {
+        while (t->thread.sendCmd(CAMERA_CMD_TYPE_DO_NEXT_JOB, 0, 0) !=
+                NO_ERROR) {
+            usleep(100);
+        }
+    }
+    return NULL;
+}
+
+static void testJobs()
+{
+    test_ctx_t *t = new test_ctx_t;
+    pthread_t producers[TEST_PRODUCERS];
+    camera_cmd_stats_t stats;
+
+    testInit(t);
+    t->thread.launch(testRoutine, t);
+    TEST_CHECK(t->thread.sendCmd(CAMERA_CMD_TYPE_START_DATA_PROC, 1, 0) ==
+            NO_ERROR);
+    for (int i = 0; i < TEST_PRODUCERS; i++) {
+        pthread_create(&producers[i], NULL, testProducer, t);
+    }
+    for (int i = 0; i < TEST_PRODUCERS; i++) {
+        pthread_join(producers[i], NULL);
+    }
+    TEST_CHECK(t->thread.sendCmd(CAMERA_CMD_TYPE_STOP_DATA_PROC, 1, 0) ==
+            NO_ERROR);
+    TEST_CHECK(t->cmds[CAMERA_CMD_TYPE_DO_NEXT_JOB] ==
+            TEST_PRODUCERS * TEST_JOBS);
+    TEST_CHECK(!t->jobOutsideRun);
+    TEST_CHECK(t->thread.exit() == NO_ERROR);
+    TEST_CHECK(t->cmds[CAMERA_CMD_TYPE_EXIT] == 1);
+    TEST_CHECK(t->cmds[CAMERA_CMD_TYPE_NONE] == 0);
+
+    t->thread.getStats(&stats);
+    uint32_t histSum = 0;
+    for (int b = 0; b < CMD_THREAD_WAIT_HIST_BUCKETS; b++) {
+        histSum += stats.wait_hist[b];
+    }
+    TEST_CHECK(stats.cmds == TEST_PRODUCERS * TEST_JOBS + 3);
+    TEST_CHECK(histSum == stats.cmds);
+    printf("  %u cmds, %u folded, %u ring full\n",
+           stats.cmds, stats.coalesced, stats.ring_full);
+    delete t;
+}
+
+static void testPriority()
+{
+    test_ctx_t *t = new test_ctx_t;
+
+    testInit(t);
+    t->useGate = true;
+    pthread_mutex_lock(&t->gate);
+    t->thread.launch(testRoutine, t);
+    t->thread.sendCmd(CAMERA_CMD_TYPE_START_DATA_PROC, 1, 0);
+    for (int i = 0; i < 10; i++) {
+        TEST_CHECK(t->thread.sendCmd(CAMERA_CMD_TYPE_DO_NEXT_JOB, 0, 0) ==
+                NO_ERROR);
+    }
+    while (__sync_fetch_and_add(&t->inJob, 0) == 0) {
+        usleep(100);
+    }
+    // EXIT goes ahead of the 9 jobs still pending
+    TEST_CHECK(t->thread.sendCmd(CAMERA_CMD_TYPE_EXIT, 0, 1) == NO_ERROR);
+    pthread_mutex_unlock(&t->gate);
+    pthread_join(t->thread.cmd_pid, NULL);
+    t->thread.cmd_pid = 0;
+    TEST_CHECK(t->cmds[CAMERA_CMD_TYPE_DO_NEXT_JOB] == 1);
+    TEST_CHECK(t->cmds[CAMERA_CMD_TYPE_EXIT] == 1);
+    delete t;
+}
+
+static void testRingFull()
+{
+    QCameraCmdThread *thread = new QCameraCmdThread();
+    camera_cmd_stats_t stats;
+
+    // no routine running, fill the ring with commands that do not fold
+    for (int i = 0; i < CMD_THREAD_RING_SIZE; i++) {
+        camera_cmd_type_t cmd = (i & 1) ? CAMERA_CMD_TYPE_DO_NEXT_JOB :
+                CAMERA_CMD_TYPE_START_DATA_PROC;
+        TEST_CHECK(thread->sendCmd(cmd, 0, 0) == NO_ERROR);
+    }
+    TEST_CHECK(thread->sendCmd(CAMERA_CMD_TYPE_STOP_DATA_PROC, 0, 0) ==
+            NO_MEMORY);
+    TEST_CHECK(thread->sendCmd(CAMERA_CMD_TYPE_EXIT, 0, 1) == NO_MEMORY);
+    // folds into the DO_NEXT_JOB at the tail
+    TEST_CHECK(thread->sendCmd(CAMERA_CMD_TYPE_DO_NEXT_JOB, 0, 0) ==
+            NO_ERROR);
+
+    uint32_t jobs = 0;
+    for (int i = 0; i < CMD_THREAD_RING_SIZE + 1; i++) {
+        TEST_CHECK(cam_sem_wait(&thread->cmd_sem) == 0);
+        camera_cmd_type_t cmd = thread->getCmd();
+        if (cmd == CAMERA_CMD_TYPE_DO_NEXT_JOB) {
+            jobs++;
+        } else {
+            TEST_CHECK(cmd == CAMERA_CMD_TYPE_START_DATA_PROC);
+        }
+    }
+    TEST_CHECK(jobs == CMD_THREAD_RING_SIZE / 2 + 1);
+    TEST_CHECK(thread->getCmd() == CAMERA_CMD_TYPE_NONE);
+
+    thread->getStats(&stats);
+    TEST_CHECK(stats.ring_full == 2);
+    TEST_CHECK(stats.coalesced == 1);
+    delete thread;
+}
+
+static void testFoldWait()
+{
+    QCameraCmdThread *thread = new QCameraCmdThread();
+    camera_cmd_stats_t stats;
+
+    // the folded post has waited far less than the one it is folded into
+    TEST_CHECK(thread->sendCmd(CAMERA_CMD_TYPE_DO_NEXT_JOB, 0, 0) ==
+            NO_ERROR);
+    usleep(20000);
+    TEST_CHECK(thread->sendCmd(CAMERA_CMD_TYPE_DO_NEXT_JOB, 0, 0) ==
+            NO_ERROR);
+    for (int i = 0; i < 2; i++) {
+        TEST_CHECK(cam_sem_wait(&thread->cmd_sem) == 0);
+        TEST_CHECK(thread->getCmd() == CAMERA_CMD_TYPE_DO_NEXT_JOB);
+    }
+
+    thread->getStats(&stats);
+    TEST_CHECK(stats.coalesced == 1);
+    TEST_CHECK(stats.wait_max_us >= 20000);
+    TEST_CHECK(stats.wait_hist[CMD_THREAD_WAIT_HIST_BUCKETS - 1] == 1);
+    TEST_CHECK(stats.wait_total_us < 30000);
+
+    // posts past the time slots of a node still fold into it
+    for (int i = 0; i < 2 * CMD_THREAD_FOLD_SLOTS; i++) {
+        TEST_CHECK(thread->sendCmd(CAMERA_CMD_TYPE_DO_NEXT_JOB, 0, 0) ==
+                NO_ERROR);
+    }
+    for (int i = 0; i < 2 * CMD_THREAD_FOLD_SLOTS; i++) {
+        TEST_CHECK(cam_sem_wait(&thread->cmd_sem) == 0);
+        TEST_CHECK(thread->getCmd() == CAMERA_CMD_TYPE_DO_NEXT_JOB);
+    }
+    TEST_CHECK(thread->getCmd() == CAMERA_CMD_TYPE_NONE);
+    thread->getStats(&stats);
+    TEST_CHECK(stats.coalesced == 2 * CMD_THREAD_FOLD_SLOTS);
+    TEST_CHECK(stats.ring_full == 0);
+    delete thread;
+}
+
+/* replaced path: one malloc'd node per command in a QCameraQueue */
+
+typedef struct {
+    QCameraQueue queue;
+    cam_semaphore_t cmd_sem;
+    cam_semaphore_t sync_sem;
+    uint32_t jobs;
+} legacy_ctx_t;
+
+static void legacySend(legacy_ctx_t *l, camera_cmd_type_t cmd, bool sync)
+{
+    camera_cmd_t *node = (camera_cmd_t *)malloc(sizeof(camera_cmd_t));
+    memset(node, 0, sizeof(camera_cmd_t));
+    node->cmd = cmd;
+    l->queue.enqueue((void *)node);
+    cam_sem_post(&l->cmd_sem);
+    if (sync) {
+        cam_sem_wait(&l->sync_sem);
+    }
+}
+
+static void *legacyRoutine(void *data)
+{
+    legacy_ctx_t *l = (legacy_ctx_t *)data;
+    bool running = true;
+
+    while (running) {
+        cam_sem_wait(&l->cmd_sem);
+        camera_cmd_t *node = (camera_cmd_t *)l->queue.dequeue();
+        if (node == NULL) {
+            continue;
+        }
+        switch (node->cmd) {
+        case CAMERA_CMD_TYPE_DO_NEXT_JOB:
+            l->jobs++;
+            break;
+        case CAMERA_CMD_TYPE_STOP_DATA_PROC:
+            cam_sem_post(&l->sync_sem);
+            break;
+        case CAMERA_CMD_TYPE_EXIT:
+            running = false;
+            break;
+        default:
+            break;
+        }
+        free(node);
+    }
+    return NULL;
+}
+
+static void benchLegacy(uint32_t iter)
+{
+    legacy_ctx_t *l = new legacy_ctx_t;
+    pthread_t pid;
+    int64_t t0, t1, t2;
+
+    cam_sem_init(&l->cmd_sem, 0);
+    cam_sem_init(&l->sync_sem, 0);
+    l->jobs = 0;
+    pthread_create(&pid, NULL, legacyRoutine, l);
+
+    t0 = testNowUs();
+    for (uint32_t i = 0; i < iter; i++) {
+        legacySend(l, CAMERA_CMD_TYPE_DO_NEXT_JOB, false);
+    }
+    legacySend(l, CAMERA_CMD_TYPE_STOP_DATA_PROC, true);
+    t1 = testNowUs();
+    for (uint32_t i = 0; i < TEST_SYNC_ITER; i++) {
+        legacySend(l, CAMERA_CMD_TYPE_STOP_DATA_PROC, true);
+    }
+    t2 = testNowUs();
+    legacySend(l, CAMERA_CMD_TYPE_EXIT, false);
+    pthread_join(pid, NULL);
+    TEST_CHECK(l->jobs == iter);
+
+    printf("  %-16s jobs %7.1f ns/cmd  sync round trip %6.2f us\n",
+           "queue + malloc", (double)(t1 - t0) * 1000.0 / iter,
+           (double)(t2 - t1) / TEST_SYNC_ITER);
+    cam_sem_destroy(&l->cmd_sem);
+    cam_sem_destroy(&l->sync_sem);
+    delete l;
+}
+
+static void benchCmdThread(uint32_t iter)
+{
+    test_ctx_t *t = new test_ctx_t;
+    camera_cmd_stats_t stats;
+    int64_t t0, t1, t2;
+
+    testInit(t);
+    t->thread.launch(testRoutine, t);
+    t->thread.sendCmd(CAMERA_CMD_TYPE_START_DATA_PROC, 1, 0);
+
+    t0 = testNowUs();
+    for (uint32_t i = 0; i < iter; i++) {
+        t->thread.sendCmd(CAMERA_CMD_TYPE_DO_NEXT_JOB, 0, 0);
+    }
+    t->thread.sendCmd(CAMERA_CMD_TYPE_STOP_DATA_PROC, 1, 0);
+    t1 = testNowUs();
+    for (uint32_t i = 0; i < TEST_SYNC_ITER; i++) {
+        t->thread.sendCmd(CAMERA_CMD_TYPE_STOP_DATA_PROC, 1, 0);
+    }
+    t2 = testNowUs();
+    t->thread.exit();
+    TEST_CHECK(t->cmds[CAMERA_CMD_TYPE_DO_NEXT_JOB] == iter);
+
+    t->thread.getStats(&stats);
+    printf("  %-16s jobs %7.1f ns/cmd  sync round trip %6.2f us  "
+           "folded %u\n",
+           "cmd thread", (double)(t1 - t0) * 1000.0 / iter,
+           (double)(t2 - t1) / TEST_SYNC_ITER, stats.coalesced);
+    printf("  wait <100us %u <500us %u <1ms %u <5ms %u <10ms %u >=10ms %u\n",
+           stats.wait_hist[0], stats.wait_hist[1], stats.wait_hist[2],
+           stats.wait_hist[3], stats.wait_hist[4], stats.wait_hist[5]);
+    delete t;
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t iter = (argc > 1) ? (uint32_t)atoi(argv[1]) : TEST_BENCH_ITER;
+
+    testJobs();
+    testPriority();
+    testRingFull();
+    testFoldWait();
+
+    printf("%u DO_NEXT_JOB, %d sync commands\n", iter, TEST_SYNC_ITER);
+    benchLegacy(iter);
+    benchCmdThread(iter);
+
+    printf("%s: %d failures\n", (g_failures == 0) ? "PASS" : "FAIL", g_failures);
+    return (g_failures == 0) ? 0 : 1;
+}
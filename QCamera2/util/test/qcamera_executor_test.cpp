@@ -0,0 +1,444 @@
+/* Copyright (c) 2014, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+/* Functional test and benchmark for QCameraExecutor.
+ *
+ * Checks that jobs of a lane run in posting order and never
+ * concurrently, that closing a lane releases its pending jobs and
+ * waits for the running one, that the release function may call into
+ * the executor, that a lane can be closed from its own job and that
+ * jobs posted past the node pool still run.
+ *
+ * Then replays a camera like load, a few 30 fps streams with short
+ * callbacks, once with one dedicated thread per stream and once on
+ * the shared pool, and prints the thread count and the queue wait.
+ *
+ * usage: qcamera-executor-test [workers]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <utils/Errors.h>
+#include "QCameraExecutor.h"
+
+using namespace android;
+using namespace qcamera;
+
+#define TEST_LANES 6
+#define TEST_JOBS 2000
+#define TEST_STREAMS 8
+#define TEST_FRAMES 90
+#define TEST_FRAME_US 33333
+#define TEST_CB_US 1500
+
+static int g_failures = 0;
+
+#define TEST_CHECK(cond) do { \
+    if (!(cond)) { \
+        printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+        g_failures++; \
+    } \
+} while (0)
+
+static int64_t testNowUs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+typedef struct {
+    QCameraExecutor *executor;
+    int32_t lane;
+    uint32_t next;          // next expected job sequence
+    uint32_t run;
+    uint32_t released;
+    int32_t inFlight;
+    bool outOfOrder;
+    bool overlap;
+    pthread_mutex_t gate;   // held by the test to block the lane
+    bool useGate;
+    bool closeSelf;
+    bool statsOnRelease;    // call into the executor from testRelease
+} test_lane_t;
+
+static void testJob(void *job, void *user_data)
+{
+    test_lane_t *t = (test_lane_t *)user_data;
+    uint32_t seq = *(uint32_t *)job;
+
+    free(job);
+
+    if (__sync_add_and_fetch(&t->inFlight, 1) != 1) {
+        t->overlap = true;
+    }
+    if (t->useGate) {
+        pthread_mutex_lock(&t->gate);
+        pthread_mutex_unlock(&t->gate);
+    }
+    if (seq != t->next) {
+        t->outOfOrder = true;
+    }
+    t->next = seq + 1;
+    t->run++;
+    if (t->closeSelf) {
+        t->executor->closeLane(t->lane);
+    }
+    __sync_sub_and_fetch(&t->inFlight, 1);
+}
+
+static void testRelease(void *job, void *user_data)
+{
+    test_lane_t *t = (test_lane_t *)user_data;
+    (void)job;
+    if (t->statsOnRelease) {
+        // deadlocks if pending jobs are released under the executor lock
+        exec_lane_stats_t stats;
+        t->executor->getStats(t->lane, &stats);
+    }
+    t->released++;
+}
+
+static void *testNewJob(uint32_t seq)
+{
+    uint32_t *job = (uint32_t *)malloc(sizeof(uint32_t));
+    *job = seq;
+    return job;
+}
+
+static void testLaneInit(test_lane_t *t, QCameraExecutor *executor)
+{
+    memset(t, 0, sizeof(*t));
+    t->executor = executor;
+    pthread_mutex_init(&t->gate, NULL);
+    t->lane = executor->openLane(testJob, testRelease, t, NULL);
+}
+
+static void *testProducer(void *data)
+{
+    test_lane_t *t = (test_lane_t *)data;
+    for (uint32_t i = 0; i < TEST_JOBS; i++) {
+        void *job = testNewJob(i);
+        while (t->executor->post(t->lane, job) != NO_ERROR) {
+            usleep(100);
+        }
+    }
+    return NULL;
+}
+
+static void testOrdering(QCameraExecutor *executor)
+{
+    test_lane_t lanes[TEST_LANES];
+    pthread_t producers[TEST_LANES];
+    exec_lane_stats_t stats;
+
+    for (int i = 0; i < TEST_LANES; i++) {
+        testLaneInit(&lanes[i], executor);
+        TEST_CHECK(lanes[i].lane >= 0);
+    }
+    for (int i = 0; i < TEST_LANES; i++) {
+        pthread_create(&producers[i], NULL, testProducer, &lanes[i]);
+    }
+    for (int i = 0; i < TEST_LANES; i++) {
+        pthread_join(producers[i], NULL);
+    }
+    for (int i = 0; i < TEST_LANES; i++) {
+        while (__sync_fetch_and_add(&lanes[i].run, 0) < TEST_JOBS) {
+            usleep(1000);
+        }
+        TEST_CHECK(executor->getStats(lanes[i].lane, &stats) == NO_ERROR);
+        uint32_t histSum = 0;
+        for (int b = 0; b < EXEC_WAIT_HIST_BUCKETS; b++) {
+            histSum += stats.wait_hist[b];
+        }
+        TEST_CHECK(stats.jobs == TEST_JOBS);
+        TEST_CHECK(histSum == TEST_JOBS);
+        TEST_CHECK(stats.pending == 0);
+        TEST_CHECK(!lanes[i].outOfOrder);
+        TEST_CHECK(!lanes[i].overlap);
+        TEST_CHECK(executor->closeLane(lanes[i].lane) == NO_ERROR);
+        TEST_CHECK(lanes[i].released == 0);
+    }
+}
+
+static void testCloseFlush(QCameraExecutor *executor)
+{
+    test_lane_t t;
+    exec_lane_stats_t stats;
+    const uint32_t num = EXEC_NUM_NODES + 16;
+
+    testLaneInit(&t, executor);
+    t.useGate = true;
+    pthread_mutex_lock(&t.gate);
+    for (uint32_t i = 0; i < num; i++) {
+        TEST_CHECK(executor->post(t.lane, testNewJob(i)) == NO_ERROR);
+    }
+    TEST_CHECK(executor->getStats(t.lane, &stats) == NO_ERROR);
+    // one node may already be back in the pool for the running job
+    TEST_CHECK(stats.heap_nodes >= 15);
+
+    // let the first job block, then close while it runs
+    while (__sync_fetch_and_add(&t.inFlight, 0) == 0) {
+        usleep(100);
+    }
+    pthread_mutex_unlock(&t.gate);
+    TEST_CHECK(executor->closeLane(t.lane) == NO_ERROR);
+    TEST_CHECK(t.inFlight == 0);
+    TEST_CHECK(t.run + t.released == num);
+    TEST_CHECK(t.run >= 1);
+    TEST_CHECK(executor->post(t.lane, NULL) != NO_ERROR);
+}
+
+static void *testCloser(void *data)
+{
+    test_lane_t *t = (test_lane_t *)data;
+    TEST_CHECK(t->executor->closeLane(t->lane) == NO_ERROR);
+    return NULL;
+}
+
+static void testReleaseUnlocked(QCameraExecutor *executor)
+{
+    test_lane_t t;
+    pthread_t closer;
+    const uint32_t num = 8;
+
+    testLaneInit(&t, executor);
+    t.useGate = true;
+    t.statsOnRelease = true;
+    pthread_mutex_lock(&t.gate);
+    for (uint32_t i = 0; i < num; i++) {
+        TEST_CHECK(executor->post(t.lane, testNewJob(i)) == NO_ERROR);
+    }
+    while (__sync_fetch_and_add(&t.inFlight, 0) == 0) {
+        usleep(100);
+    }
+    // close while the first job is blocked, the rest gets released
+    pthread_create(&closer, NULL, testCloser, &t);
+    usleep(10000);
+    pthread_mutex_unlock(&t.gate);
+    pthread_join(closer, NULL);
+    TEST_CHECK(t.run == 1);
+    TEST_CHECK(t.released == num - 1);
+}
+
+static void testCloseSelf(QCameraExecutor *executor)
+{
+    test_lane_t t;
+
+    testLaneInit(&t, executor);
+    t.closeSelf = true;
+    TEST_CHECK(executor->post(t.lane, testNewJob(0)) == NO_ERROR);
+    for (int i = 0; i < 1000; i++) {
+        void *job = testNewJob(1);
+        if (executor->post(t.lane, job) != NO_ERROR) {
+            free(job);
+            break;
+        }
+        usleep(1000);
+    }
+    // lane slot must come back once the closing job returned
+    int32_t lanes[EXEC_MAX_LANES];
+    int n = 0;
+    for (int retry = 0; (retry < 100) && (n < EXEC_MAX_LANES); retry++) {
+        n = 0;
+        for (int i = 0; i < EXEC_MAX_LANES; i++) {
+            lanes[n] = executor->openLane(testJob, testRelease, &t, NULL);
+            if (lanes[n] >= 0) {
+                n++;
+            }
+        }
+        for (int i = 0; i < n; i++) {
+            executor->closeLane(lanes[i]);
+        }
+        usleep(1000);
+    }
+    TEST_CHECK(n == EXEC_MAX_LANES);
+    TEST_CHECK(t.run + t.released >= 1);
+}
+
+/* camera like load */
+
+typedef struct {
+    int64_t waitTotal;
+    int64_t waitMax;
+    uint32_t frames;
+} load_stream_t;
+
+typedef struct {
+    load_stream_t *stream;
+    int64_t postUs;
+} load_frame_t;
+
+static void loadJob(void *job, void *user_data)
+{
+    load_frame_t *frame = (load_frame_t *)job;
+    load_stream_t *stream = (load_stream_t *)user_data;
+    int64_t wait = testNowUs() - frame->postUs;
+
+    stream->waitTotal += wait;
+    if (wait > stream->waitMax) {
+        stream->waitMax = wait;
+    }
+    stream->frames++;
+    free(frame);
+    // busy callback, like a copy or a format conversion
+    int64_t end = testNowUs() + TEST_CB_US;
+    while (testNowUs() < end) {
+    }
+}
+
+typedef struct {
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    load_frame_t *q[TEST_FRAMES];
+    int head;
+    int tail;
+    bool exit;
+    load_stream_t *stream;
+} load_thread_t;
+
+static void *loadThread(void *data)
+{
+    load_thread_t *th = (load_thread_t *)data;
+    pthread_mutex_lock(&th->lock);
+    while (true) {
+        while (!th->exit && (th->head == th->tail)) {
+            pthread_cond_wait(&th->cond, &th->lock);
+        }
+        if (th->head == th->tail) {
+            break;
+        }
+        load_frame_t *frame = th->q[th->head++];
+        pthread_mutex_unlock(&th->lock);
+        loadJob(frame, th->stream);
+        pthread_mutex_lock(&th->lock);
+    }
+    pthread_mutex_unlock(&th->lock);
+    return NULL;
+}
+
+static void loadRun(QCameraExecutor *executor)
+{
+    load_stream_t streams[TEST_STREAMS];
+    load_thread_t threads[TEST_STREAMS];
+    pthread_t pids[TEST_STREAMS];
+    int32_t lanes[TEST_STREAMS];
+    int64_t t0, waitTotal = 0, waitMax = 0;
+    uint32_t frames = 0;
+
+    memset(streams, 0, sizeof(streams));
+    memset(threads, 0, sizeof(threads));
+    for (int s = 0; s < TEST_STREAMS; s++) {
+        if (executor != NULL) {
+            lanes[s] = executor->openLane(loadJob, NULL, &streams[s], NULL);
+        } else {
+            pthread_mutex_init(&threads[s].lock, NULL);
+            pthread_cond_init(&threads[s].cond, NULL);
+            threads[s].stream = &streams[s];
+            pthread_create(&pids[s], NULL, loadThread, &threads[s]);
+        }
+    }
+
+    // all streams get a frame per period with a small skew between them
+    t0 = testNowUs();
+    for (int f = 0; f < TEST_FRAMES; f++) {
+        for (int s = 0; s < TEST_STREAMS; s++) {
+            int64_t due = t0 + (int64_t)f * TEST_FRAME_US + s * 200;
+            int64_t now = testNowUs();
+            if (due > now) {
+                usleep((useconds_t)(due - now));
+            }
+            load_frame_t *frame = (load_frame_t *)malloc(sizeof(load_frame_t));
+            frame->stream = &streams[s];
+            frame->postUs = testNowUs();
+            if (executor != NULL) {
+                executor->post(lanes[s], frame);
+            } else {
+                pthread_mutex_lock(&threads[s].lock);
+                threads[s].q[threads[s].tail++] = frame;
+                pthread_cond_signal(&threads[s].cond);
+                pthread_mutex_unlock(&threads[s].lock);
+            }
+        }
+    }
+
+    for (int s = 0; s < TEST_STREAMS; s++) {
+        if (executor != NULL) {
+            while (__sync_fetch_and_add(&streams[s].frames, 0) < TEST_FRAMES) {
+                usleep(1000);
+            }
+            executor->closeLane(lanes[s]);
+        } else {
+            pthread_mutex_lock(&threads[s].lock);
+            threads[s].exit = true;
+            pthread_cond_signal(&threads[s].cond);
+            pthread_mutex_unlock(&threads[s].lock);
+            pthread_join(pids[s], NULL);
+        }
+        waitTotal += streams[s].waitTotal;
+        frames += streams[s].frames;
+        if (streams[s].waitMax > waitMax) {
+            waitMax = streams[s].waitMax;
+        }
+    }
+    TEST_CHECK(frames == TEST_STREAMS * TEST_FRAMES);
+
+    printf("  %-18s threads %2u  wait avg %5lld us  max %6lld us\n",
+           (executor != NULL) ? "shared executor" : "thread per stream",
+           (executor != NULL) ? executor->getNumWorkers() : TEST_STREAMS,
+           (long long)(frames ? waitTotal / frames : 0),
+           (long long)waitMax);
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t workers = (argc > 1) ? (uint32_t)atoi(argv[1]) :
+            EXEC_DEFAULT_WORKERS;
+    QCameraExecutor *executor = new QCameraExecutor(workers);
+
+    testOrdering(executor);
+    testCloseFlush(executor);
+    testReleaseUnlocked(executor);
+    testCloseSelf(executor);
+
+    printf("%d streams at 30 fps, %d us callbacks\n", TEST_STREAMS, TEST_CB_US);
+    loadRun(NULL);
+    loadRun(executor);
+    delete executor;
+
+    TEST_CHECK(QCameraExecutor::getInstance(workers) ==
+            QCameraExecutor::getInstance(workers + 1));
+
+    printf("%s: %d failures\n", (g_failures == 0) ? "PASS" : "FAIL", g_failures);
+    return (g_failures == 0) ? 0 : 1;
+}
@@ -0,0 +1,246 @@
+/* Copyright (c) 2014, The Linux Foundataion. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+/* Microbenchmark for the framework <-> HAL translation maps.
+ *
+ * Replays the lookups one capture request and its result make in
+ * translateMetadataToParameters / translateCbMetadataToResultMetadata,
+ * plus the string lookups of a HAL1 setParameters, once with the
+ * linear scans the HALs used before and once with QCameraEnumLookup /
+ * QCameraNameLookup. Tables have the same shape and size as the HAL
+ * ones. Reports ns per request for both.
+ *
+ * usage: qcamera-lookup-bench [iterations]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "QCameraLookupMap.h"
+
+using namespace android;
+using namespace qcamera;
+
+#define BENCH_MAP_SIZE(MAP) (sizeof(MAP)/sizeof(MAP[0]))
+
+typedef struct {
+    int fwk_name;
+    int hal_name;
+} bench_enum_map_t;
+
+typedef struct {
+    const char *const desc;
+    int val;
+} bench_name_map_t;
+
+/* fwk/hal enum pairs, ordered like the HAL3 tables */
+static const bench_enum_map_t EFFECT_MAP[] = {
+    {0, 0}, {1, 1}, {2, 2}, {3, 3}, {4, 4}, {5, 5}, {6, 6}, {7, 7}, {8, 8}
+};
+static const bench_enum_map_t WB_MAP[] = {
+    {0, 0}, {1, 1}, {2, 2}, {3, 3}, {4, 4}, {5, 5}, {6, 6}, {7, 7}, {8, 8}
+};
+static const bench_enum_map_t SCENE_MAP[] = {
+    {1, 0}, {2, 8}, {3, 4}, {4, 1}, {5, 6}, {6, 7}, {7, 13}, {8, 3},
+    {9, 2}, {10, 5}, {11, 9}, {12, 10}, {13, 11}, {14, 12}, {15, 14},
+    {16, 15}
+};
+static const bench_enum_map_t AF_MAP[] = {
+    {0, 5}, {0, 6}, {1, 0}, {2, 2}, {5, 3}, {4, 4}, {3, 1}
+};
+static const bench_enum_map_t AB_MAP[] = {
+    {0, 0}, {1, 2}, {2, 3}, {3, 1}
+};
+static const bench_enum_map_t AE_FLASH_MAP[] = {
+    {0, 0}, {1, 0}, {2, 1}, {3, 2}, {4, 1}
+};
+static const bench_enum_map_t FLASH_MAP[] = {
+    {0, 0}, {1, 4}, {2, 3}
+};
+static const bench_enum_map_t FD_MAP[] = {
+    {0, 0}, {2, 2}
+};
+
+/* HAL1 style name tables */
+static const bench_name_map_t SCENE_NAMES[] = {
+    {"auto", 0}, {"asd", 19}, {"landscape", 1}, {"snow", 2}, {"beach", 3},
+    {"sunset", 4}, {"night", 5}, {"portrait", 6}, {"backlight", 7},
+    {"sports", 8}, {"steadyphoto", 9}, {"flowers", 10},
+    {"candlelight", 11}, {"fireworks", 12}, {"party", 13},
+    {"night-portrait", 14}, {"theatre", 15}, {"action", 16}, {"AR", 17},
+    {"hdr", 20}
+};
+static const bench_name_map_t FOCUS_NAMES[] = {
+    {"auto", 0}, {"infinity", 1}, {"macro", 2}, {"fixed", 3}, {"edof", 4},
+    {"continuous-picture", 5}, {"continuous-video", 6},
+    {"manual", 7}
+};
+static const bench_name_map_t WB_NAMES[] = {
+    {"auto", 1}, {"incandescent", 2}, {"fluorescent", 3},
+    {"warm-fluorescent", 4}, {"daylight", 5}, {"cloudy-daylight", 6},
+    {"twilight", 7}, {"shade", 8}
+};
+static const bench_name_map_t ISO_NAMES[] = {
+    {"auto", 0}, {"ISO_HJR", 1}, {"ISO100", 2}, {"ISO200", 3},
+    {"ISO400", 4}, {"ISO800", 5}, {"ISO1600", 6}, {"ISO3200", 7}
+};
+static const bench_name_map_t ON_OFF_NAMES[] = {
+    {"off", 0}, {"on", 1}
+};
+
+static int legacyToHal(const bench_enum_map_t *arr, size_t len, int fwk)
+{
+    for (size_t i = 0; i < len; i++) {
+        if (arr[i].fwk_name == fwk)
+            return arr[i].hal_name;
+    }
+    return NAME_NOT_FOUND;
+}
+
+static int legacyToFwk(const bench_enum_map_t *arr, size_t len, int hal)
+{
+    for (size_t i = 0; i < len; i++) {
+        if (arr[i].hal_name == hal)
+            return arr[i].fwk_name;
+    }
+    return NAME_NOT_FOUND;
+}
+
+static int legacyAttr(const bench_name_map_t *arr, size_t len,
+        const char *name)
+{
+    for (size_t i = 0; i < len; i++) {
+        if (!strcmp(arr[i].desc, name))
+            return arr[i].val;
+    }
+    return NAME_NOT_FOUND;
+}
+
+static double nowNs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+#define LEGACY_RT(MAP, fwk) \
+    legacyToFwk(MAP, BENCH_MAP_SIZE(MAP), \
+            legacyToHal(MAP, BENCH_MAP_SIZE(MAP), (fwk)))
+
+int main(int argc, char **argv)
+{
+    int iterations = (argc > 1) ? atoi(argv[1]) : 1000000;
+    const QCameraEnumLookup<bench_enum_map_t>
+            effect(EFFECT_MAP, BENCH_MAP_SIZE(EFFECT_MAP)),
+            wb(WB_MAP, BENCH_MAP_SIZE(WB_MAP)),
+            scene(SCENE_MAP, BENCH_MAP_SIZE(SCENE_MAP)),
+            af(AF_MAP, BENCH_MAP_SIZE(AF_MAP)),
+            ab(AB_MAP, BENCH_MAP_SIZE(AB_MAP)),
+            aeFlash(AE_FLASH_MAP, BENCH_MAP_SIZE(AE_FLASH_MAP)),
+            flash(FLASH_MAP, BENCH_MAP_SIZE(FLASH_MAP)),
+            fd(FD_MAP, BENCH_MAP_SIZE(FD_MAP));
+    const QCameraNameLookup<bench_name_map_t>
+            sceneNames(SCENE_NAMES, BENCH_MAP_SIZE(SCENE_NAMES)),
+            focusNames(FOCUS_NAMES, BENCH_MAP_SIZE(FOCUS_NAMES)),
+            wbNames(WB_NAMES, BENCH_MAP_SIZE(WB_NAMES)),
+            isoNames(ISO_NAMES, BENCH_MAP_SIZE(ISO_NAMES)),
+            onOffNames(ON_OFF_NAMES, BENCH_MAP_SIZE(ON_OFF_NAMES));
+    volatile int sink = 0;
+    int mismatch = 0;
+
+    if (iterations <= 0) {
+        iterations = 1000000;
+    }
+
+    /* both paths must agree before they are timed */
+    for (int v = -1; v < 24; v++) {
+        mismatch += LEGACY_RT(SCENE_MAP, v) != scene.toFwk(scene.toHal(v));
+        mismatch += LEGACY_RT(AF_MAP, v) != af.toFwk(af.toHal(v));
+        mismatch += LEGACY_RT(AE_FLASH_MAP, v) !=
+                aeFlash.toFwk(aeFlash.toHal(v));
+    }
+    for (size_t i = 0; i < BENCH_MAP_SIZE(SCENE_NAMES); i++) {
+        mismatch += legacyAttr(SCENE_NAMES, BENCH_MAP_SIZE(SCENE_NAMES),
+                SCENE_NAMES[i].desc) != sceneNames.lookup(SCENE_NAMES[i].desc);
+    }
+    mismatch += sceneNames.lookup("no-such-scene") != NAME_NOT_FOUND;
+    if (mismatch) {
+        printf("lookup mismatch %d\n", mismatch);
+        return 1;
+    }
+
+    /* request settings cycle through the tables so every entry is hit */
+    double start = nowNs();
+    for (int i = 0; i < iterations; i++) {
+        int k = i & 15;
+        sink += LEGACY_RT(EFFECT_MAP, k % 9);
+        sink += LEGACY_RT(WB_MAP, k % 9);
+        sink += LEGACY_RT(SCENE_MAP, k + 1);
+        sink += LEGACY_RT(AF_MAP, k % 6);
+        sink += LEGACY_RT(AB_MAP, k & 3);
+        sink += LEGACY_RT(AE_FLASH_MAP, k % 5);
+        sink += LEGACY_RT(FLASH_MAP, k % 3);
+        sink += LEGACY_RT(FD_MAP, (k & 1) << 1);
+        sink += legacyAttr(SCENE_NAMES, BENCH_MAP_SIZE(SCENE_NAMES),
+                SCENE_NAMES[k].desc);
+        sink += legacyAttr(FOCUS_NAMES, BENCH_MAP_SIZE(FOCUS_NAMES),
+                FOCUS_NAMES[k & 7].desc);
+        sink += legacyAttr(WB_NAMES, BENCH_MAP_SIZE(WB_NAMES),
+                WB_NAMES[k & 7].desc);
+        sink += legacyAttr(ISO_NAMES, BENCH_MAP_SIZE(ISO_NAMES),
+                ISO_NAMES[k & 7].desc);
+        sink += legacyAttr(ON_OFF_NAMES, BENCH_MAP_SIZE(ON_OFF_NAMES),
+                ON_OFF_NAMES[k & 1].desc);
+    }
+    double legacyNs = (nowNs() - start) / iterations;
+
+    start = nowNs();
+    for (int i = 0; i < iterations; i++) {
+        int k = i & 15;
+        sink += effect.toFwk(effect.toHal(k % 9));
+        sink += wb.toFwk(wb.toHal(k % 9));
+        sink += scene.toFwk(scene.toHal(k + 1));
+        sink += af.toFwk(af.toHal(k % 6));
+        sink += ab.toFwk(ab.toHal(k & 3));
+        sink += aeFlash.toFwk(aeFlash.toHal(k % 5));
+        sink += flash.toFwk(flash.toHal(k % 3));
+        sink += fd.toFwk(fd.toHal((k & 1) << 1));
+        sink += sceneNames.lookup(SCENE_NAMES[k].desc);
+        sink += focusNames.lookup(FOCUS_NAMES[k & 7].desc);
+        sink += wbNames.lookup(WB_NAMES[k & 7].desc);
+        sink += isoNames.lookup(ISO_NAMES[k & 7].desc);
+        sink += onOffNames.lookup(ON_OFF_NAMES[k & 1].desc);
+    }
+    double indexedNs = (nowNs() - start) / iterations;
+
+    printf("request translation: linear %.1f ns, indexed %.1f ns (%.2fx)\n",
+            legacyNs, indexedNs, legacyNs / indexedNs);
+    return 0;
+}
@@ -0,0 +1,231 @@
+/* Copyright (c) 2014, The Linux Foundataion. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+/* Unit test and microbenchmark for QCameraPtrIndex.
+ *
+ * Checks lookups of page aligned and heap pointers, duplicate and NULL
+ * keys, the capacity limit and removal against a plain array kept
+ * alongside, through random add / remove churn.
+ *
+ * Then resolves buffer pointers the way releaseRecordingFrame and the
+ * gralloc dequeue path do, once by scanning the camera_memory_t array
+ * like the memory classes used to and once through the index, for
+ * 8, 16 and 24 buffers. Reports ns per lookup for both.
+ *
+ * usage: qcamera-ptrindex-test [iterations]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "QCameraPtrIndex.h"
+
+using namespace qcamera;
+
+#define TEST_MAX_BUFS 24
+#define TEST_PAGE 4096
+#define TEST_CHURN 20000
+#define TEST_BENCH_ITER 2000000
+
+static int g_failures = 0;
+
+#define TEST_CHECK(cond) do { \
+    if (!(cond)) { \
+        printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+        g_failures++; \
+    } \
+} while (0)
+
+/* stand-in for camera_memory_t, lookups used to chase ->data */
+typedef struct {
+    void *data;
+    size_t size;
+} test_memory_t;
+
+static int64_t testNowNs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+/* buffers mapped back to back, like ion allocations of one stream */
+static void *testPagePtr(uint32_t i)
+{
+    return (void *)(uintptr_t)(0x70000000UL + (uintptr_t)i * 0x5f000);
+}
+
+static void testBasic()
+{
+    QCameraPtrIndex index;
+    void *heap[TEST_MAX_BUFS];
+
+    TEST_CHECK(index.find(NULL) == -1);
+    TEST_CHECK(!index.add(NULL, 0));
+    for (int i = 0; i < TEST_MAX_BUFS; i++) {
+        TEST_CHECK(index.add(testPagePtr(i), i));
+    }
+    for (int i = 0; i < TEST_MAX_BUFS; i++) {
+        TEST_CHECK(index.find(testPagePtr(i)) == i);
+    }
+    TEST_CHECK(index.find(testPagePtr(TEST_MAX_BUFS)) == -1);
+    TEST_CHECK(index.find((char *)testPagePtr(0) + TEST_PAGE) == -1);
+
+    // a second index for a pointer is ignored, the first one wins
+    TEST_CHECK(index.add(testPagePtr(3), 7));
+    TEST_CHECK(index.find(testPagePtr(3)) == 3);
+    TEST_CHECK(index.size() == TEST_MAX_BUFS);
+
+    index.clear();
+    TEST_CHECK(index.size() == 0);
+    TEST_CHECK(index.find(testPagePtr(0)) == -1);
+
+    for (int i = 0; i < TEST_MAX_BUFS; i++) {
+        heap[i] = malloc(sizeof(void *));
+        TEST_CHECK(index.add(heap[i], i));
+    }
+    for (int i = 0; i < TEST_MAX_BUFS; i++) {
+        TEST_CHECK(index.find(heap[i]) == i);
+        free(heap[i]);
+    }
+
+    // fills up at half the slots
+    index.clear();
+    for (int i = 0; i < QCAMERA_PTR_INDEX_SIZE / 2; i++) {
+        TEST_CHECK(index.add(testPagePtr(i), i));
+    }
+    TEST_CHECK(!index.add(testPagePtr(QCAMERA_PTR_INDEX_SIZE), 0));
+    TEST_CHECK(index.find(testPagePtr(QCAMERA_PTR_INDEX_SIZE)) == -1);
+}
+
+static void testChurn()
+{
+    QCameraPtrIndex index;
+    void *keys[QCAMERA_PTR_INDEX_SIZE / 2];
+    bool used[QCAMERA_PTR_INDEX_SIZE / 2];
+    const int num = QCAMERA_PTR_INDEX_SIZE / 2;
+
+    memset(used, 0, sizeof(used));
+    srand(1);
+    for (int i = 0; i < num; i++) {
+        // page aligned keys from a wide range, many share a home slot
+        keys[i] = (void *)(uintptr_t)(((uintptr_t)rand() % 4096) * TEST_PAGE);
+        for (int j = 0; j < i; j++) {
+            if (keys[j] == keys[i]) {
+                keys[i] = (void *)((uintptr_t)keys[i] + 0x10000000UL);
+                j = -1;
+            }
+        }
+    }
+    for (int n = 0; n < TEST_CHURN; n++) {
+        int i = rand() % num;
+        if (used[i]) {
+            index.remove(keys[i]);
+        } else {
+            TEST_CHECK(index.add(keys[i], i));
+        }
+        used[i] = !used[i];
+
+        uint32_t count = 0;
+        for (int j = 0; j < num; j++) {
+            TEST_CHECK(index.find(keys[j]) == (used[j] ? j : -1));
+            count += used[j] ? 1 : 0;
+        }
+        TEST_CHECK(index.size() == count);
+        if (g_failures) {
+            break;
+        }
+    }
+}
+
+static int legacyMatch(test_memory_t *const *mem, int count,
+        const void *opaque)
+{
+    for (int i = 0; i < count; i++) {
+        if (mem[i]->data == opaque) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static void bench(int count, uint32_t iter)
+{
+    test_memory_t *mem[TEST_MAX_BUFS];
+    QCameraPtrIndex index;
+    volatile int sink = 0;
+    int64_t t0, t1, t2;
+
+    for (int i = 0; i < count; i++) {
+        mem[i] = (test_memory_t *)malloc(sizeof(test_memory_t));
+        mem[i]->data = testPagePtr(i);
+        mem[i]->size = TEST_PAGE;
+        index.add(mem[i]->data, i);
+    }
+
+    // buffers come back in queue order, then a few unknown pointers
+    t0 = testNowNs();
+    for (uint32_t n = 0; n < iter; n++) {
+        sink += legacyMatch(mem, count, testPagePtr(n % (count + 1)));
+    }
+    t1 = testNowNs();
+    for (uint32_t n = 0; n < iter; n++) {
+        sink += index.find(testPagePtr(n % (count + 1)));
+    }
+    t2 = testNowNs();
+
+    for (uint32_t n = 0; n < (uint32_t)count + 1; n++) {
+        TEST_CHECK(legacyMatch(mem, count, testPagePtr(n)) ==
+                index.find(testPagePtr(n)));
+    }
+    printf("  %2d buffers: scan %6.2f ns, index %6.2f ns (%.2fx)\n", count,
+           (double)(t1 - t0) / iter, (double)(t2 - t1) / iter,
+           (t2 > t1) ? (double)(t1 - t0) / (double)(t2 - t1) : 0.0);
+    for (int i = 0; i < count; i++) {
+        free(mem[i]);
+    }
+    (void)sink;
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t iter = (argc > 1) ? (uint32_t)atoi(argv[1]) : TEST_BENCH_ITER;
+
+    testBasic();
+    testChurn();
+
+    printf("buffer pointer lookup, %u iterations\n", iter);
+    bench(8, iter);
+    bench(16, iter);
+    bench(24, iter);
+
+    printf("%s: %d failures\n", (g_failures == 0) ? "PASS" : "FAIL", g_failures);
+    return (g_failures == 0) ? 0 : 1;
+}
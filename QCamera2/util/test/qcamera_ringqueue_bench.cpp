@@ -0,0 +1,256 @@
+/* Copyright (c) 2014, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+/* Contention benchmark for QCameraRingQueue against QCameraQueue.
+ *
+ * One consumer thread drains the queue while 1, 2 and 4 producer
+ * threads enqueue tagged items, the way several jpeg callback threads
+ * feed the postproc save queue. Checks that every item comes out
+ * exactly once and in per producer order, that a full ring rejects
+ * and counts the drop, and that priority nodes keep FIFO order among
+ * themselves. Prints the average enqueue cost and the drain rate.
+ *
+ * usage: qcamera-ringqueue-bench [items_per_producer]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <sched.h>
+#include <pthread.h>
+#include "QCameraQueue.h"
+#include "QCameraRingQueue.h"
+
+using namespace qcamera;
+
+#define TEST_MAX_PRODUCERS 4
+#define TEST_RING_DEPTH 64
+#define TEST_DEFAULT_ITEMS 200000
+
+static int g_failures = 0;
+
+#define TEST_CHECK(cond) do { \
+    if (!(cond)) { \
+        printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+        g_failures++; \
+    } \
+} while (0)
+
+static int64_t testNowNs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+// items are never dereferenced, producer id and sequence ride in the
+// pointer value; +1 keeps them away from NULL
+static void *testItem(uint32_t producer, uint32_t seq)
+{
+    return (void *)(uintptr_t)(((uintptr_t)producer << 24) + seq + 1);
+}
+
+static void testSplit(void *item, uint32_t *producer, uint32_t *seq)
+{
+    uintptr_t v = (uintptr_t)item - 1;
+    *producer = (uint32_t)(v >> 24);
+    *seq = (uint32_t)(v & 0xFFFFFF);
+}
+
+class TestQueue {
+public:
+    virtual ~TestQueue() {}
+    virtual bool put(void *data) = 0;
+    virtual void *get() = 0;
+};
+
+class TestListQueue : public TestQueue {
+public:
+    bool put(void *data) { return m_q.enqueue(data); }
+    void *get() { return m_q.dequeue(); }
+private:
+    QCameraQueue m_q;
+};
+
+class TestRingQueue : public TestQueue {
+public:
+    TestRingQueue(ring_queue_mode_t mode) : m_q(TEST_RING_DEPTH, mode) {}
+    bool put(void *data) { return m_q.enqueue(data); }
+    void *get() { return m_q.dequeue(); }
+private:
+    QCameraRingQueue m_q;
+};
+
+typedef struct {
+    TestQueue *queue;
+    uint32_t id;
+    uint32_t items;
+    uint32_t full;        // enqueue attempts rejected by a full queue
+    int64_t put_ns;       // time spent inside enqueue
+    pthread_barrier_t *start;
+} test_producer_t;
+
+static void *testProducer(void *arg)
+{
+    test_producer_t *p = (test_producer_t *)arg;
+    pthread_barrier_wait(p->start);
+    for (uint32_t seq = 0; seq < p->items; seq++) {
+        void *item = testItem(p->id, seq);
+        for (;;) {
+            int64_t t0 = testNowNs();
+            bool ok = p->queue->put(item);
+            p->put_ns += testNowNs() - t0;
+            if (ok) {
+                break;
+            }
+            p->full++;
+            sched_yield();
+        }
+    }
+    return NULL;
+}
+
+static void testRun(const char *name, TestQueue *queue,
+                    uint32_t producers, uint32_t items)
+{
+    pthread_t tids[TEST_MAX_PRODUCERS];
+    test_producer_t prod[TEST_MAX_PRODUCERS];
+    uint32_t next[TEST_MAX_PRODUCERS];
+    pthread_barrier_t start;
+    uint32_t total = producers * items;
+    uint32_t received = 0;
+    uint32_t bad = 0;
+    uint32_t empty = 0;
+
+    pthread_barrier_init(&start, NULL, producers + 1);
+    memset(prod, 0, sizeof(prod));
+    memset(next, 0, sizeof(next));
+    for (uint32_t i = 0; i < producers; i++) {
+        prod[i].queue = queue;
+        prod[i].id = i;
+        prod[i].items = items;
+        prod[i].start = &start;
+        pthread_create(&tids[i], NULL, testProducer, &prod[i]);
+    }
+
+    pthread_barrier_wait(&start);
+    int64_t t0 = testNowNs();
+    while (received < total) {
+        void *item = queue->get();
+        if (NULL == item) {
+            empty++;
+            sched_yield();
+            continue;
+        }
+        uint32_t producer, seq;
+        testSplit(item, &producer, &seq);
+        if (producer >= producers || seq != next[producer]) {
+            bad++;
+        } else {
+            next[producer]++;
+        }
+        received++;
+    }
+    int64_t elapsed = testNowNs() - t0;
+
+    int64_t put_ns = 0;
+    uint32_t full = 0;
+    for (uint32_t i = 0; i < producers; i++) {
+        pthread_join(tids[i], NULL);
+        put_ns += prod[i].put_ns;
+        full += prod[i].full;
+    }
+    pthread_barrier_destroy(&start);
+
+    TEST_CHECK(bad == 0);
+    TEST_CHECK(NULL == queue->get());
+    for (uint32_t i = 0; i < producers; i++) {
+        TEST_CHECK(next[i] == items);
+    }
+
+    printf("%-12s producers %u: enqueue %6.1f ns, drain %7.2f Mitems/s,"
+           " full %u, empty polls %u\n",
+           name, producers,
+           (double)put_ns / (total + full),
+           (double)total * 1000.0 / (double)elapsed,
+           full, empty);
+}
+
+static void testFullAndPriority()
+{
+    QCameraRingQueue q(4, RING_QUEUE_MPSC);
+    for (uint32_t i = 0; i < 4; i++) {
+        TEST_CHECK(q.enqueue(testItem(0, i)));
+    }
+    TEST_CHECK(!q.enqueue(testItem(0, 4)));
+    TEST_CHECK(1 == q.getDropCount());
+    for (uint32_t i = 0; i < 4; i++) {
+        TEST_CHECK(testItem(0, i) == q.dequeue());
+    }
+    TEST_CHECK(q.isEmpty());
+
+    TEST_CHECK(q.enqueue(testItem(0, 0)));
+    TEST_CHECK(q.enqueueWithPriority(testItem(1, 0)));
+    TEST_CHECK(q.enqueueWithPriority(testItem(1, 1)));
+    TEST_CHECK(testItem(1, 0) == q.dequeue());
+    TEST_CHECK(testItem(1, 1) == q.dequeue());
+    TEST_CHECK(testItem(0, 0) == q.dequeue());
+    TEST_CHECK(NULL == q.dequeue());
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t items = TEST_DEFAULT_ITEMS;
+    if (argc > 1) {
+        items = (uint32_t)atoi(argv[1]);
+    }
+    if (items == 0 || items > 0xFFFFFF) {
+        printf("usage: %s [items_per_producer]\n", argv[0]);
+        return 1;
+    }
+
+    testFullAndPriority();
+
+    for (uint32_t producers = 1; producers <= TEST_MAX_PRODUCERS;
+         producers *= 2) {
+        TestListQueue list;
+        testRun("QCameraQueue", &list, producers, items);
+        if (producers == 1) {
+            TestRingQueue spsc(RING_QUEUE_SPSC);
+            testRun("ring SPSC", &spsc, producers, items);
+        }
+        TestRingQueue mpsc(RING_QUEUE_MPSC);
+        testRun("ring MPSC", &mpsc, producers, items);
+    }
+
+    printf("%s: %d failures\n", g_failures ? "FAIL" : "PASS", g_failures);
+    return g_failures ? 1 : 0;
+}
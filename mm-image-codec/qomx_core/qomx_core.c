@@ -42,7 +42,8 @@ static int g_omxcore_cnt = 0;
 static const comp_info_t g_comp_info[] =
 {
   { "OMX.qcom.image.jpeg.encoder", "libqomx_jpegenc.so" },
-  { "OMX.qcom.image.jpeg.decoder", "libqomx_jpegdec.so" }
+  { "OMX.qcom.image.jpeg.decoder", "libqomx_jpegdec.so" },
+  { "OMX.qcom.image.jpeg.encoder_sw", "libqomx_jpegenc_sw.so" }
 };
 
 static int get_idx_from_handle(OMX_IN OMX_HANDLETYPE *ahComp, int *acompIndex,
@@ -265,6 +266,7 @@ error:
   if (OMX_TRUE == close_handle) {
     dlclose(p_core_comp->lib_handle);
     p_core_comp->lib_handle = NULL;
+    p_core_comp->open = FALSE;
   }
   pthread_mutex_unlock(&g_omxcore_lock);
   ALOGE("%s:%d] Error %d", __func__, __LINE__, rc);
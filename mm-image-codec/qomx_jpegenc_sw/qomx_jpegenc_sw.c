@@ -0,0 +1,1264 @@
+/* Copyright (c) 2014, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#define LOG_TAG "qomx_jpegenc_sw"
+#include <utils/Log.h>
+#include <cutils/properties.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <sys/prctl.h>
+
+#include "qomx_jpegenc_sw.h"
+
+#define QOMX_SW_SPEC_VERSION 0x00000101
+#define QOMX_SW_ROLE "image_encoder.jpeg"
+#define QOMX_SW_DEFAULT_QUALITY 85
+#define QOMX_SW_THREADS_PROP "persist.camera.jpeg.sw_threads"
+
+/** qomx_sw_ext_t
+*  Mapping of the qcom extension names to their indices
+**/
+typedef struct {
+  const char *name;
+  OMX_INDEXTYPE index;
+} qomx_sw_ext_t;
+
+static const qomx_sw_ext_t g_ext_index[] = {
+  { QOMX_IMAGE_EXT_EXIF_NAME, (OMX_INDEXTYPE)QOMX_IMAGE_EXT_EXIF },
+  { QOMX_IMAGE_EXT_THUMBNAIL_NAME, (OMX_INDEXTYPE)QOMX_IMAGE_EXT_THUMBNAIL },
+  { QOMX_IMAGE_EXT_BUFFER_OFFSET_NAME,
+    (OMX_INDEXTYPE)QOMX_IMAGE_EXT_BUFFER_OFFSET },
+  { QOMX_IMAGE_EXT_MOBICAT_NAME, (OMX_INDEXTYPE)QOMX_IMAGE_EXT_MOBICAT },
+  { QOMX_IMAGE_EXT_ENCODING_MODE_NAME,
+    (OMX_INDEXTYPE)QOMX_IMAGE_EXT_ENCODING_MODE },
+  { QOMX_IMAGE_EXT_WORK_BUFFER_NAME,
+    (OMX_INDEXTYPE)QOMX_IMAGE_EXT_WORK_BUFFER },
+  { QOMX_IMAGE_EXT_METADATA_NAME, (OMX_INDEXTYPE)QOMX_IMAGE_EXT_METADATA },
+  { QOMX_IMAGE_EXT_META_ENC_KEY_NAME,
+    (OMX_INDEXTYPE)QOMX_IMAGE_EXT_META_ENC_KEY },
+  { QOMX_IMAGE_EXT_MEM_OPS_NAME, (OMX_INDEXTYPE)QOMX_IMAGE_EXT_MEM_OPS },
+  { QOMX_IMAGE_EXT_JPEG_SPEED_NAME, (OMX_INDEXTYPE)QOMX_IMAGE_EXT_JPEG_SPEED },
+};
+
+static inline qomx_jpegenc_sw_t *qomx_sw_get(OMX_HANDLETYPE hComp)
+{
+  if (NULL == hComp) {
+    return NULL;
+  }
+  return (qomx_jpegenc_sw_t *)((OMX_COMPONENTTYPE *)hComp)->pComponentPrivate;
+}
+
+/** qomx_sw_post:
+ *
+ *  Arguments:
+ *    @p_comp: component
+ *    @type: message type
+ *    @cmd: OMX command for QOMX_SW_MSG_CMD
+ *    @param: command parameter
+ *
+ *  Return:
+ *       OMX error values
+ *
+ *  Description:
+ *       Queue a message for the component thread
+ *
+ **/
+static OMX_ERRORTYPE qomx_sw_post(qomx_jpegenc_sw_t *p_comp,
+  qomx_sw_msg_type_t type, OMX_COMMANDTYPE cmd, OMX_U32 param)
+{
+  qomx_sw_msg_t *p_msg;
+
+  pthread_mutex_lock(&p_comp->lock);
+  if (p_comp->msg_cnt >= QOMX_SW_MSG_Q_SIZE) {
+    pthread_mutex_unlock(&p_comp->lock);
+    ALOGE("%s:%d] message queue full", __func__, __LINE__);
+    return OMX_ErrorInsufficientResources;
+  }
+  p_msg = &p_comp->msg_q[(p_comp->msg_head + p_comp->msg_cnt) %
+    QOMX_SW_MSG_Q_SIZE];
+  p_msg->type = type;
+  p_msg->cmd = cmd;
+  p_msg->param = param;
+  p_comp->msg_cnt++;
+  pthread_cond_signal(&p_comp->cond);
+  pthread_mutex_unlock(&p_comp->lock);
+  return OMX_ErrorNone;
+}
+
+static inline void qomx_sw_event(qomx_jpegenc_sw_t *p_comp,
+  OMX_EVENTTYPE event, OMX_U32 data1, OMX_U32 data2)
+{
+  if (p_comp->callbacks.EventHandler) {
+    p_comp->callbacks.EventHandler(&p_comp->omx_comp, p_comp->app_data,
+      event, data1, data2, NULL);
+  }
+}
+
+static inline void qomx_sw_ebd(qomx_jpegenc_sw_t *p_comp,
+  OMX_BUFFERHEADERTYPE *p_buf)
+{
+  if (p_comp->callbacks.EmptyBufferDone) {
+    p_comp->callbacks.EmptyBufferDone(&p_comp->omx_comp, p_comp->app_data,
+      p_buf);
+  }
+}
+
+static inline void qomx_sw_fbd(qomx_jpegenc_sw_t *p_comp,
+  OMX_BUFFERHEADERTYPE *p_buf)
+{
+  if (p_comp->callbacks.FillBufferDone) {
+    p_comp->callbacks.FillBufferDone(&p_comp->omx_comp, p_comp->app_data,
+      p_buf);
+  }
+}
+
+/** qomx_sw_port_populated:
+ *
+ *  Arguments:
+ *    @p_port: port
+ *
+ *  Return:
+ *       OMX_TRUE if the port has all its buffers
+ *
+ **/
+static OMX_BOOL qomx_sw_port_populated(const qomx_sw_port_t *p_port)
+{
+  if (!p_port->def.bEnabled) {
+    return OMX_TRUE;
+  }
+  return (p_port->num_hdr && (p_port->num_hdr >=
+    p_port->def.nBufferCountActual)) ? OMX_TRUE : OMX_FALSE;
+}
+
+/** qomx_sw_return_buffers:
+ *
+ *  Arguments:
+ *    @p_comp: component
+ *    @port: port index, OMX_ALL for every port
+ *
+ *  Return:
+ *       none
+ *
+ *  Description:
+ *       Hand back every queued buffer of the port unprocessed
+ *
+ **/
+static void qomx_sw_return_buffers(qomx_jpegenc_sw_t *p_comp, OMX_U32 port)
+{
+  OMX_BUFFERHEADERTYPE *bufs[QOMX_SW_MAX_BUFS];
+  uint32_t i, j, cnt;
+
+  for (i = 0; i < QOMX_SW_MAX_PORTS; i++) {
+    if ((port != OMX_ALL) && (port != i)) {
+      continue;
+    }
+    pthread_mutex_lock(&p_comp->lock);
+    cnt = p_comp->ports[i].q_cnt;
+    memcpy(bufs, p_comp->ports[i].queue, cnt * sizeof(bufs[0]));
+    p_comp->ports[i].q_cnt = 0;
+    pthread_mutex_unlock(&p_comp->lock);
+
+    for (j = 0; j < cnt; j++) {
+      if (i == QOMX_SW_PORT_OUT) {
+        bufs[j]->nFilledLen = 0;
+        qomx_sw_fbd(p_comp, bufs[j]);
+      } else {
+        qomx_sw_ebd(p_comp, bufs[j]);
+      }
+    }
+  }
+}
+
+/** qomx_sw_check_transition:
+ *
+ *  Arguments:
+ *    @p_comp: component
+ *
+ *  Return:
+ *       none
+ *
+ *  Description:
+ *       Complete a pending Loaded<->Idle transition once the
+ *       buffers are populated or released
+ *
+ **/
+static void qomx_sw_check_transition(qomx_jpegenc_sw_t *p_comp)
+{
+  OMX_STATETYPE done = OMX_StateInvalid;
+  uint32_t i;
+  OMX_BOOL ready = OMX_TRUE;
+
+  pthread_mutex_lock(&p_comp->lock);
+  if ((p_comp->target_state == OMX_StateIdle) &&
+    (p_comp->state == OMX_StateLoaded)) {
+    for (i = 0; i < QOMX_SW_MAX_PORTS; i++) {
+      if (!qomx_sw_port_populated(&p_comp->ports[i])) {
+        ready = OMX_FALSE;
+      }
+    }
+  } else if ((p_comp->target_state == OMX_StateLoaded) &&
+    (p_comp->state == OMX_StateIdle)) {
+    for (i = 0; i < QOMX_SW_MAX_PORTS; i++) {
+      if (p_comp->ports[i].num_hdr) {
+        ready = OMX_FALSE;
+      }
+    }
+  } else {
+    ready = OMX_FALSE;
+  }
+  if (ready) {
+    p_comp->state = p_comp->target_state;
+    done = p_comp->state;
+  }
+  pthread_mutex_unlock(&p_comp->lock);
+
+  if (done != OMX_StateInvalid) {
+    ALOGD("%s:%d] state %d", __func__, __LINE__, done);
+    qomx_sw_event(p_comp, OMX_EventCmdComplete, OMX_CommandStateSet, done);
+  }
+}
+
+/** qomx_sw_handle_cmd:
+ *
+ *  Arguments:
+ *    @p_comp: component
+ *    @cmd: OMX command
+ *    @param: command parameter
+ *
+ *  Return:
+ *       none
+ *
+ *  Description:
+ *       Execute a command on the component thread
+ *
+ **/
+static void qomx_sw_handle_cmd(qomx_jpegenc_sw_t *p_comp, OMX_COMMANDTYPE cmd,
+  OMX_U32 param)
+{
+  OMX_STATETYPE cur;
+  OMX_STATETYPE target = (OMX_STATETYPE)param;
+
+  switch (cmd) {
+  case OMX_CommandStateSet:
+    pthread_mutex_lock(&p_comp->lock);
+    cur = p_comp->state;
+    pthread_mutex_unlock(&p_comp->lock);
+
+    if (cur == target) {
+      qomx_sw_event(p_comp, OMX_EventError, OMX_ErrorSameState, 0);
+    } else if (((cur == OMX_StateLoaded) && (target == OMX_StateIdle)) ||
+      ((cur == OMX_StateIdle) && (target == OMX_StateLoaded))) {
+      pthread_mutex_lock(&p_comp->lock);
+      p_comp->target_state = target;
+      pthread_mutex_unlock(&p_comp->lock);
+      qomx_sw_check_transition(p_comp);
+    } else if ((cur == OMX_StateIdle) && (target == OMX_StateExecuting)) {
+      pthread_mutex_lock(&p_comp->lock);
+      p_comp->state = OMX_StateExecuting;
+      pthread_mutex_unlock(&p_comp->lock);
+      qomx_sw_event(p_comp, OMX_EventCmdComplete, OMX_CommandStateSet,
+        target);
+    } else if (((cur == OMX_StateExecuting) || (cur == OMX_StatePause)) &&
+      (target == OMX_StateIdle)) {
+      qomx_sw_return_buffers(p_comp, OMX_ALL);
+      pthread_mutex_lock(&p_comp->lock);
+      p_comp->state = OMX_StateIdle;
+      p_comp->enc.abort = 0;
+      pthread_mutex_unlock(&p_comp->lock);
+      qomx_sw_event(p_comp, OMX_EventCmdComplete, OMX_CommandStateSet,
+        target);
+    } else {
+      ALOGE("%s:%d] invalid transition %d -> %d", __func__, __LINE__,
+        cur, target);
+      qomx_sw_event(p_comp, OMX_EventError,
+        OMX_ErrorIncorrectStateTransition, 0);
+    }
+    break;
+  case OMX_CommandFlush:
+    qomx_sw_return_buffers(p_comp, param);
+    qomx_sw_event(p_comp, OMX_EventCmdComplete, cmd, param);
+    break;
+  case OMX_CommandPortEnable:
+  case OMX_CommandPortDisable:
+    if (param >= QOMX_SW_MAX_PORTS) {
+      qomx_sw_event(p_comp, OMX_EventError, OMX_ErrorBadPortIndex, param);
+      break;
+    }
+    pthread_mutex_lock(&p_comp->lock);
+    p_comp->ports[param].def.bEnabled =
+      (cmd == OMX_CommandPortEnable) ? OMX_TRUE : OMX_FALSE;
+    pthread_mutex_unlock(&p_comp->lock);
+    if (cmd == OMX_CommandPortDisable) {
+      qomx_sw_return_buffers(p_comp, param);
+    }
+    qomx_sw_event(p_comp, OMX_EventCmdComplete, cmd, param);
+    break;
+  default:
+    qomx_sw_event(p_comp, OMX_EventError, OMX_ErrorNotImplemented, cmd);
+    break;
+  }
+}
+
+/** qomx_sw_plane_view:
+ *
+ *  Arguments:
+ *    @p_def: port definition
+ *    @p_offset: plane offsets
+ *    @p_buf: buffer
+ *    @p_img: resulting image view
+ *
+ *  Return:
+ *       OMX error values
+ *
+ *  Description:
+ *       Describe the NV12/NV21 image held by the buffer
+ *
+ **/
+static OMX_ERRORTYPE qomx_sw_plane_view(const OMX_PARAM_PORTDEFINITIONTYPE *p_def,
+  const QOMX_YUV_FRAME_INFO *p_offset, const OMX_BUFFERHEADERTYPE *p_buf,
+  qomx_sw_yuv_t *p_img)
+{
+  const OMX_IMAGE_PORTDEFINITIONTYPE *p_fmt = &p_def->format.image;
+  uint32_t stride, scanline, cbcr_start;
+
+  stride = (p_fmt->nStride > 0) ? (uint32_t)p_fmt->nStride :
+    p_fmt->nFrameWidth;
+  scanline = p_fmt->nSliceHeight ? p_fmt->nSliceHeight : p_fmt->nFrameHeight;
+  cbcr_start = p_offset->cbcrStartOffset[0] ? p_offset->cbcrStartOffset[0] :
+    stride * scanline;
+
+  if (!p_fmt->nFrameWidth || !p_fmt->nFrameHeight ||
+    (cbcr_start + p_offset->cbcrOffset[0] +
+    stride * ((p_fmt->nFrameHeight + 1) >> 1) > p_buf->nAllocLen)) {
+    ALOGE("%s:%d] invalid frame %dx%d stride %d in %d bytes", __func__,
+      __LINE__, (int)p_fmt->nFrameWidth, (int)p_fmt->nFrameHeight,
+      (int)stride, (int)p_buf->nAllocLen);
+    return OMX_ErrorBadParameter;
+  }
+
+  p_img->y = p_buf->pBuffer + p_offset->yOffset;
+  p_img->uv = p_buf->pBuffer + cbcr_start + p_offset->cbcrOffset[0];
+  p_img->width = p_fmt->nFrameWidth;
+  p_img->height = p_fmt->nFrameHeight;
+  p_img->y_stride = stride;
+  p_img->uv_stride = stride;
+  p_img->cr_first = ((int)p_fmt->eColorFormat ==
+    (int)OMX_QCOM_IMG_COLOR_FormatYVU420SemiPlanar);
+  return OMX_ErrorNone;
+}
+
+/** qomx_sw_encode_thumbnail:
+ *
+ *  Arguments:
+ *    @p_comp: component
+ *    @p_buf: thumbnail input buffer
+ *    @p_len: length of the thumbnail JPEG
+ *
+ *  Return:
+ *       OMX error values
+ *
+ *  Description:
+ *       Encode the thumbnail into a standalone JPEG that is then
+ *       embedded in IFD1
+ *
+ **/
+static OMX_ERRORTYPE qomx_sw_encode_thumbnail(qomx_jpegenc_sw_t *p_comp,
+  OMX_BUFFERHEADERTYPE *p_buf, uint32_t *p_len)
+{
+  QOMX_THUMBNAIL_INFO *p_info = &p_comp->thumb;
+  qomx_sw_quant_t quant[2];
+  qomx_sw_yuv_t src, img;
+  qomx_sw_rect_t crop;
+  uint32_t quality, hdr, size, len;
+  uint8_t *buf;
+  OMX_ERRORTYPE ret;
+
+  *p_len = 0;
+  ret = qomx_sw_plane_view(&p_comp->ports[QOMX_SW_PORT_TMB].def,
+    &p_info->tmbOffset, p_buf, &src);
+  if (ret) {
+    return ret;
+  }
+
+  crop.left = (uint32_t)p_info->crop_info.nLeft;
+  crop.top = (uint32_t)p_info->crop_info.nTop;
+  crop.width = p_info->crop_info.nWidth;
+  crop.height = p_info->crop_info.nHeight;
+  if (qomx_sw_transform(&src, &crop, p_info->output_width,
+    p_info->output_height, (int)p_info->rotation, &p_comp->tmb_scratch,
+    &p_comp->tmb_scratch_size, &img)) {
+    return OMX_ErrorBadParameter;
+  }
+
+  quality = p_info->quality ? p_info->quality : QOMX_SW_DEFAULT_QUALITY;
+  qomx_sw_quant_init(&quant[0], 0, quality, NULL);
+  qomx_sw_quant_init(&quant[1], 1, quality, NULL);
+  if (qomx_sw_encode_scan_single(&p_comp->enc, &img, quant,
+    &p_comp->tmb_bits)) {
+    return OMX_ErrorInsufficientResources;
+  }
+
+  size = 2 + 1024 + p_comp->tmb_bits.len + 2;
+  if (size > p_comp->tmb_jpeg_size) {
+    buf = realloc(p_comp->tmb_jpeg, size);
+    if (NULL == buf) {
+      return OMX_ErrorInsufficientResources;
+    }
+    p_comp->tmb_jpeg = buf;
+    p_comp->tmb_jpeg_size = size;
+  }
+  buf = p_comp->tmb_jpeg;
+
+  buf[0] = 0xFF;
+  buf[1] = 0xD8;
+  len = 2;
+  hdr = qomx_sw_write_tables(buf + len, size - len, quant, img.width,
+    img.height, 0);
+  len += hdr;
+  memcpy(buf + len, p_comp->tmb_bits.buf, p_comp->tmb_bits.len);
+  len += p_comp->tmb_bits.len;
+  buf[len++] = 0xFF;
+  buf[len++] = 0xD9;
+  *p_len = len;
+  return OMX_ErrorNone;
+}
+
+/** qomx_sw_encode_job:
+ *
+ *  Arguments:
+ *    @p_comp: component
+ *    @p_in: main image buffer
+ *    @p_tmb: thumbnail buffer, NULL if disabled
+ *    @p_out: output buffer
+ *    @p_tmb_dropped: set if the thumbnail did not fit the exif
+ *
+ *  Return:
+ *       OMX error values
+ *
+ *  Description:
+ *       Encode one picture: transform, parallel scan, thumbnail,
+ *       then assemble SOI, APP1, tables, slices and EOI in the
+ *       output buffer
+ *
+ **/
+static OMX_ERRORTYPE qomx_sw_encode_job(qomx_jpegenc_sw_t *p_comp,
+  OMX_BUFFERHEADERTYPE *p_in, OMX_BUFFERHEADERTYPE *p_tmb,
+  OMX_BUFFERHEADERTYPE *p_out, int *p_tmb_dropped)
+{
+  qomx_sw_encoder_t *p_enc = &p_comp->enc;
+  qomx_sw_yuv_t src, img;
+  qomx_sw_rect_t crop;
+  uint32_t quality, tmb_len = 0, len, n, cap;
+  uint8_t *p;
+  struct timespec t0, t1;
+  OMX_ERRORTYPE ret;
+
+  clock_gettime(CLOCK_MONOTONIC, &t0);
+  *p_tmb_dropped = 0;
+
+  ret = qomx_sw_plane_view(&p_comp->ports[QOMX_SW_PORT_IN].def,
+    &p_comp->main_offset, p_in, &src);
+  if (ret) {
+    return ret;
+  }
+
+  crop.left = (uint32_t)p_comp->in_crop.nLeft;
+  crop.top = (uint32_t)p_comp->in_crop.nTop;
+  crop.width = p_comp->in_crop.nWidth;
+  crop.height = p_comp->in_crop.nHeight;
+  if (qomx_sw_transform(&src, &crop, p_comp->out_crop.nWidth,
+    p_comp->out_crop.nHeight, (int)p_comp->rotation, &p_comp->scratch,
+    &p_comp->scratch_size, &img)) {
+    return OMX_ErrorBadParameter;
+  }
+
+  quality = p_comp->quality ? p_comp->quality : QOMX_SW_DEFAULT_QUALITY;
+  qomx_sw_quant_init(&p_enc->quant[0], 0, quality,
+    p_comp->qtbl_set[0] ? p_comp->qtbl[0].nQuantizationMatrix : NULL);
+  qomx_sw_quant_init(&p_enc->quant[1], 1, quality,
+    p_comp->qtbl_set[1] ? p_comp->qtbl[1].nQuantizationMatrix : NULL);
+
+  if (qomx_sw_encode_scan(p_enc, &img)) {
+    return p_enc->abort ? OMX_ErrorNone : OMX_ErrorInsufficientResources;
+  }
+
+  if (p_tmb && p_comp->thumb_set) {
+    ret = qomx_sw_encode_thumbnail(p_comp, p_tmb, &tmb_len);
+    if (ret) {
+      ALOGE("%s:%d] thumbnail failed %d, dropping it", __func__, __LINE__,
+        ret);
+      tmb_len = 0;
+      *p_tmb_dropped = 1;
+    }
+  }
+
+  p = p_out->pBuffer;
+  cap = p_out->nAllocLen;
+  if (cap < 4) {
+    return OMX_ErrorOverflow;
+  }
+  p[0] = 0xFF;
+  p[1] = 0xD8;
+  len = 2;
+
+  n = qomx_sw_exif_write(p_comp, p + len, cap - len,
+    tmb_len ? p_comp->tmb_jpeg : NULL, tmb_len);
+  if (!n && tmb_len) {
+    ALOGE("%s:%d] thumbnail of %d bytes does not fit the exif", __func__,
+      __LINE__, tmb_len);
+    *p_tmb_dropped = 1;
+    n = qomx_sw_exif_write(p_comp, p + len, cap - len, NULL, 0);
+  }
+  if (!n) {
+    return OMX_ErrorOverflow;
+  }
+  len += n;
+
+  n = qomx_sw_write_tables(p + len, cap - len, p_enc->quant, img.width,
+    img.height, qomx_sw_restart_interval(p_enc, &img));
+  if (!n) {
+    return OMX_ErrorOverflow;
+  }
+  len += n;
+
+  n = qomx_sw_write_scan(p_enc, p + len, cap - len);
+  if (!n || (len + n + 2 > cap)) {
+    return OMX_ErrorOverflow;
+  }
+  len += n;
+  p[len++] = 0xFF;
+  p[len++] = 0xD9;
+
+  p_out->nFilledLen = len;
+  p_out->nOffset = 0;
+
+  clock_gettime(CLOCK_MONOTONIC, &t1);
+  ALOGI("%s:%d] %dx%d -> %d bytes, %d slices on %d threads, %ld ms",
+    __func__, __LINE__, img.width, img.height, len, p_enc->num_slices,
+    p_enc->num_threads, (long)((t1.tv_sec - t0.tv_sec) * 1000 +
+    (t1.tv_nsec - t0.tv_nsec) / 1000000));
+  return OMX_ErrorNone;
+}
+
+/** qomx_sw_process:
+ *
+ *  Arguments:
+ *    @p_comp: component
+ *
+ *  Return:
+ *       none
+ *
+ *  Description:
+ *       Run every job for which the main input, the thumbnail
+ *       input (if enabled) and an output buffer are queued
+ *
+ **/
+static void qomx_sw_process(qomx_jpegenc_sw_t *p_comp)
+{
+  OMX_BUFFERHEADERTYPE *p_in, *p_tmb, *p_out;
+  qomx_sw_port_t *in, *tmb, *out;
+  OMX_ERRORTYPE ret;
+  int dropped, aborted;
+
+  in = &p_comp->ports[QOMX_SW_PORT_IN];
+  tmb = &p_comp->ports[QOMX_SW_PORT_TMB];
+  out = &p_comp->ports[QOMX_SW_PORT_OUT];
+
+  while (1) {
+    pthread_mutex_lock(&p_comp->lock);
+    if ((p_comp->state != OMX_StateExecuting) || !in->q_cnt ||
+      !out->q_cnt || (tmb->def.bEnabled && !tmb->q_cnt)) {
+      pthread_mutex_unlock(&p_comp->lock);
+      return;
+    }
+    p_in = in->queue[0];
+    memmove(&in->queue[0], &in->queue[1], --in->q_cnt * sizeof(in->queue[0]));
+    p_out = out->queue[0];
+    memmove(&out->queue[0], &out->queue[1],
+      --out->q_cnt * sizeof(out->queue[0]));
+    p_tmb = NULL;
+    if (tmb->def.bEnabled) {
+      p_tmb = tmb->queue[0];
+      memmove(&tmb->queue[0], &tmb->queue[1],
+        --tmb->q_cnt * sizeof(tmb->queue[0]));
+    }
+    pthread_mutex_unlock(&p_comp->lock);
+
+    p_out->nFilledLen = 0;
+    ret = qomx_sw_encode_job(p_comp, p_in, p_tmb, p_out, &dropped);
+
+    /* the next job may be configured from within the callbacks */
+    pthread_mutex_lock(&p_comp->lock);
+    qomx_sw_exif_reset(p_comp);
+    p_comp->thumb_set = 0;
+    aborted = p_comp->enc.abort;
+    pthread_mutex_unlock(&p_comp->lock);
+
+    qomx_sw_ebd(p_comp, p_in);
+    if (p_tmb) {
+      qomx_sw_ebd(p_comp, p_tmb);
+    }
+    if (aborted) {
+      p_out->nFilledLen = 0;
+      qomx_sw_fbd(p_comp, p_out);
+    } else if (ret) {
+      ALOGE("%s:%d] encode failed %d", __func__, __LINE__, ret);
+      qomx_sw_event(p_comp, OMX_EventError, ret, 0);
+    } else {
+      if (dropped) {
+        qomx_sw_event(p_comp,
+          (OMX_EVENTTYPE)OMX_EVENT_THUMBNAIL_DROPPED, 0, 0);
+      }
+      qomx_sw_fbd(p_comp, p_out);
+    }
+  }
+}
+
+/** qomx_sw_thread:
+ *
+ *  Arguments:
+ *    @data: component
+ *
+ *  Return:
+ *       NULL
+ *
+ *  Description:
+ *       Component thread. Commands, transitions and encodes are
+ *       serialized here and every callback is issued from here.
+ *
+ **/
+static void *qomx_sw_thread(void *data)
+{
+  qomx_jpegenc_sw_t *p_comp = (qomx_jpegenc_sw_t *)data;
+  qomx_sw_msg_t msg;
+
+  prctl(PR_SET_NAME, (unsigned long)"qomx_jpeg_sw", 0, 0, 0);
+  pthread_mutex_lock(&p_comp->lock);
+  while (1) {
+    while (!p_comp->msg_cnt) {
+      pthread_cond_wait(&p_comp->cond, &p_comp->lock);
+    }
+    msg = p_comp->msg_q[p_comp->msg_head];
+    p_comp->msg_head = (p_comp->msg_head + 1) % QOMX_SW_MSG_Q_SIZE;
+    p_comp->msg_cnt--;
+    if (msg.type == QOMX_SW_MSG_EXIT) {
+      break;
+    }
+    pthread_mutex_unlock(&p_comp->lock);
+
+    switch (msg.type) {
+    case QOMX_SW_MSG_CMD:
+      qomx_sw_handle_cmd(p_comp, msg.cmd, msg.param);
+      break;
+    case QOMX_SW_MSG_CHECK:
+      qomx_sw_check_transition(p_comp);
+      break;
+    case QOMX_SW_MSG_PROCESS:
+      qomx_sw_process(p_comp);
+      break;
+    default:
+      break;
+    }
+    pthread_mutex_lock(&p_comp->lock);
+  }
+  pthread_mutex_unlock(&p_comp->lock);
+  return NULL;
+}
+
+static OMX_ERRORTYPE qomx_sw_get_component_version(OMX_HANDLETYPE hComp,
+  OMX_STRING componentName, OMX_VERSIONTYPE *componentVersion,
+  OMX_VERSIONTYPE *specVersion, OMX_UUIDTYPE *componentUUID)
+{
+  if (!qomx_sw_get(hComp) || !componentName || !componentVersion ||
+    !specVersion) {
+    return OMX_ErrorBadParameter;
+  }
+  strncpy(componentName, QOMX_SW_COMP_NAME, OMX_MAX_STRINGNAME_SIZE - 1);
+  componentName[OMX_MAX_STRINGNAME_SIZE - 1] = '\0';
+  componentVersion->nVersion = QOMX_SW_SPEC_VERSION;
+  specVersion->nVersion = QOMX_SW_SPEC_VERSION;
+  if (componentUUID) {
+    memset(componentUUID, 0, sizeof(*componentUUID));
+  }
+  return OMX_ErrorNone;
+}
+
+static OMX_ERRORTYPE qomx_sw_send_command(OMX_HANDLETYPE hComp,
+  OMX_COMMANDTYPE cmd, OMX_U32 param, OMX_PTR cmdData)
+{
+  qomx_jpegenc_sw_t *p_comp = qomx_sw_get(hComp);
+
+  if (NULL == p_comp) {
+    return OMX_ErrorBadParameter;
+  }
+  if ((cmd == OMX_CommandStateSet) && (param == OMX_StateIdle)) {
+    /* stop an ongoing encode at the next MCU row */
+    pthread_mutex_lock(&p_comp->lock);
+    if (p_comp->state == OMX_StateExecuting) {
+      p_comp->enc.abort = 1;
+    }
+    pthread_mutex_unlock(&p_comp->lock);
+  }
+  return qomx_sw_post(p_comp, QOMX_SW_MSG_CMD, cmd, param);
+}
+
+static OMX_ERRORTYPE qomx_sw_get_parameter(OMX_HANDLETYPE hComp,
+  OMX_INDEXTYPE index, OMX_PTR param)
+{
+  qomx_jpegenc_sw_t *p_comp = qomx_sw_get(hComp);
+  OMX_PARAM_PORTDEFINITIONTYPE *p_def = (OMX_PARAM_PORTDEFINITIONTYPE *)param;
+  qomx_sw_port_t *p_port;
+
+  if (!p_comp || !param) {
+    return OMX_ErrorBadParameter;
+  }
+  if (index != OMX_IndexParamPortDefinition) {
+    return OMX_ErrorUnsupportedIndex;
+  }
+  if (p_def->nPortIndex >= QOMX_SW_MAX_PORTS) {
+    return OMX_ErrorBadPortIndex;
+  }
+  pthread_mutex_lock(&p_comp->lock);
+  p_port = &p_comp->ports[p_def->nPortIndex];
+  p_port->def.bPopulated = (p_port->def.bEnabled &&
+    qomx_sw_port_populated(p_port)) ? OMX_TRUE : OMX_FALSE;
+  *p_def = p_port->def;
+  pthread_mutex_unlock(&p_comp->lock);
+  return OMX_ErrorNone;
+}
+
+static OMX_ERRORTYPE qomx_sw_set_parameter(OMX_HANDLETYPE hComp,
+  OMX_INDEXTYPE index, OMX_PTR param)
+{
+  qomx_jpegenc_sw_t *p_comp = qomx_sw_get(hComp);
+  OMX_PARAM_PORTDEFINITIONTYPE *p_def = (OMX_PARAM_PORTDEFINITIONTYPE *)param;
+  qomx_sw_port_t *p_port;
+  int fmt;
+  OMX_ERRORTYPE ret = OMX_ErrorNone;
+
+  if (!p_comp || !param) {
+    return OMX_ErrorBadParameter;
+  }
+
+  pthread_mutex_lock(&p_comp->lock);
+  switch ((int)index) {
+  case OMX_IndexParamPortDefinition:
+    if (p_def->nPortIndex >= QOMX_SW_MAX_PORTS) {
+      ret = OMX_ErrorBadPortIndex;
+      break;
+    }
+    p_port = &p_comp->ports[p_def->nPortIndex];
+    if (p_def->nPortIndex != QOMX_SW_PORT_OUT) {
+      fmt = (int)p_def->format.image.eColorFormat;
+      if ((fmt != (int)OMX_COLOR_FormatYUV420SemiPlanar) &&
+        (fmt != (int)OMX_QCOM_IMG_COLOR_FormatYVU420SemiPlanar)) {
+        ALOGE("%s:%d] unsupported color format %x on port %d", __func__,
+          __LINE__, fmt, (int)p_def->nPortIndex);
+        ret = OMX_ErrorUnsupportedSetting;
+        break;
+      }
+    }
+    if (p_def->nBufferCountActual > QOMX_SW_MAX_BUFS) {
+      ret = OMX_ErrorBadParameter;
+      break;
+    }
+    p_port->def.format.image.nFrameWidth = p_def->format.image.nFrameWidth;
+    p_port->def.format.image.nFrameHeight = p_def->format.image.nFrameHeight;
+    p_port->def.format.image.nStride = p_def->format.image.nStride;
+    p_port->def.format.image.nSliceHeight = p_def->format.image.nSliceHeight;
+    p_port->def.format.image.eColorFormat = p_def->format.image.eColorFormat;
+    p_port->def.nBufferCountActual = p_def->nBufferCountActual;
+    p_port->def.nBufferSize = p_def->nBufferSize;
+    break;
+  case QOMX_IMAGE_EXT_BUFFER_OFFSET:
+    p_comp->main_offset = *(QOMX_YUV_FRAME_INFO *)param;
+    break;
+  case QOMX_IMAGE_EXT_ENCODING_MODE:
+  case QOMX_IMAGE_EXT_JPEG_SPEED:
+  case QOMX_IMAGE_EXT_MEM_OPS:
+    /* the output is always written to the client buffer */
+    break;
+  default:
+    ret = OMX_ErrorUnsupportedIndex;
+    break;
+  }
+  pthread_mutex_unlock(&p_comp->lock);
+  return ret;
+}
+
+static OMX_ERRORTYPE qomx_sw_get_config(OMX_HANDLETYPE hComp,
+  OMX_INDEXTYPE index, OMX_PTR config)
+{
+  qomx_jpegenc_sw_t *p_comp = qomx_sw_get(hComp);
+  OMX_ERRORTYPE ret = OMX_ErrorNone;
+
+  if (!p_comp || !config) {
+    return OMX_ErrorBadParameter;
+  }
+  pthread_mutex_lock(&p_comp->lock);
+  switch ((int)index) {
+  case OMX_IndexConfigCommonRotate:
+    ((OMX_CONFIG_ROTATIONTYPE *)config)->nRotation = p_comp->rotation;
+    break;
+  case OMX_IndexConfigCommonInputCrop:
+    *(OMX_CONFIG_RECTTYPE *)config = p_comp->in_crop;
+    break;
+  case OMX_IndexConfigCommonOutputCrop:
+    *(OMX_CONFIG_RECTTYPE *)config = p_comp->out_crop;
+    break;
+  case OMX_IndexParamQFactor:
+    ((OMX_IMAGE_PARAM_QFACTORTYPE *)config)->nQFactor = p_comp->quality;
+    break;
+  default:
+    ret = OMX_ErrorUnsupportedIndex;
+    break;
+  }
+  pthread_mutex_unlock(&p_comp->lock);
+  return ret;
+}
+
+static OMX_ERRORTYPE qomx_sw_set_config(OMX_HANDLETYPE hComp,
+  OMX_INDEXTYPE index, OMX_PTR config)
+{
+  qomx_jpegenc_sw_t *p_comp = qomx_sw_get(hComp);
+  OMX_IMAGE_PARAM_QUANTIZATIONTABLETYPE *p_qtbl;
+  OMX_ERRORTYPE ret = OMX_ErrorNone;
+  int t;
+
+  if (!p_comp || !config) {
+    return OMX_ErrorBadParameter;
+  }
+  pthread_mutex_lock(&p_comp->lock);
+  switch ((int)index) {
+  case OMX_IndexConfigCommonRotate:
+    p_comp->rotation = ((OMX_CONFIG_ROTATIONTYPE *)config)->nRotation;
+    if (p_comp->rotation % 90) {
+      ret = OMX_ErrorUnsupportedSetting;
+    }
+    break;
+  case OMX_IndexConfigCommonInputCrop:
+    p_comp->in_crop = *(OMX_CONFIG_RECTTYPE *)config;
+    break;
+  case OMX_IndexConfigCommonOutputCrop:
+    p_comp->out_crop = *(OMX_CONFIG_RECTTYPE *)config;
+    break;
+  case OMX_IndexParamQFactor:
+    p_comp->quality = ((OMX_IMAGE_PARAM_QFACTORTYPE *)config)->nQFactor;
+    p_comp->qtbl_set[0] = p_comp->qtbl_set[1] = 0;
+    break;
+  case OMX_IndexParamQuantizationTable:
+    p_qtbl = (OMX_IMAGE_PARAM_QUANTIZATIONTABLETYPE *)config;
+    t = (p_qtbl->eQuantizationTable == OMX_IMAGE_QuantizationTableLuma) ?
+      0 : 1;
+    p_comp->qtbl[t] = *p_qtbl;
+    p_comp->qtbl_set[t] = 1;
+    break;
+  case QOMX_IMAGE_EXT_EXIF:
+    if (qomx_sw_exif_add(p_comp, (QOMX_EXIF_INFO *)config)) {
+      ret = OMX_ErrorInsufficientResources;
+    }
+    break;
+  case QOMX_IMAGE_EXT_THUMBNAIL:
+    p_comp->thumb = *(QOMX_THUMBNAIL_INFO *)config;
+    p_comp->thumb_set = 1;
+    break;
+  case QOMX_IMAGE_EXT_WORK_BUFFER:
+  case QOMX_IMAGE_EXT_METADATA:
+  case QOMX_IMAGE_EXT_META_ENC_KEY:
+  case QOMX_IMAGE_EXT_MOBICAT:
+    /* hardware and makernote specific, not used by this encoder */
+    break;
+  default:
+    ret = OMX_ErrorUnsupportedIndex;
+    break;
+  }
+  pthread_mutex_unlock(&p_comp->lock);
+  return ret;
+}
+
+static OMX_ERRORTYPE qomx_sw_get_extension_index(OMX_HANDLETYPE hComp,
+  OMX_STRING paramName, OMX_INDEXTYPE *indexType)
+{
+  uint32_t i;
+
+  if (!qomx_sw_get(hComp) || !paramName || !indexType) {
+    return OMX_ErrorBadParameter;
+  }
+  for (i = 0; i < sizeof(g_ext_index) / sizeof(g_ext_index[0]); i++) {
+    if (!strcmp(paramName, g_ext_index[i].name)) {
+      *indexType = g_ext_index[i].index;
+      return OMX_ErrorNone;
+    }
+  }
+  return OMX_ErrorUnsupportedIndex;
+}
+
+static OMX_ERRORTYPE qomx_sw_get_state(OMX_HANDLETYPE hComp,
+  OMX_STATETYPE *state)
+{
+  qomx_jpegenc_sw_t *p_comp = qomx_sw_get(hComp);
+
+  if (!p_comp || !state) {
+    return OMX_ErrorBadParameter;
+  }
+  pthread_mutex_lock(&p_comp->lock);
+  *state = p_comp->state;
+  pthread_mutex_unlock(&p_comp->lock);
+  return OMX_ErrorNone;
+}
+
+static OMX_ERRORTYPE qomx_sw_tunnel_request(OMX_HANDLETYPE hComp,
+  OMX_U32 port, OMX_HANDLETYPE hTunneledComp, OMX_U32 tunneledPort,
+  OMX_TUNNELSETUPTYPE *tunnelSetup)
+{
+  return OMX_ErrorNotImplemented;
+}
+
+static OMX_ERRORTYPE qomx_sw_use_buffer(OMX_HANDLETYPE hComp,
+  OMX_BUFFERHEADERTYPE **ppBufferHdr, OMX_U32 port, OMX_PTR appPrivate,
+  OMX_U32 bytes, OMX_U8 *buffer)
+{
+  qomx_jpegenc_sw_t *p_comp = qomx_sw_get(hComp);
+  OMX_BUFFERHEADERTYPE *p_hdr;
+  qomx_sw_port_t *p_port;
+
+  if (!p_comp || !ppBufferHdr || !buffer || (port >= QOMX_SW_MAX_PORTS)) {
+    return OMX_ErrorBadParameter;
+  }
+  p_hdr = calloc(1, sizeof(*p_hdr));
+  if (NULL == p_hdr) {
+    return OMX_ErrorInsufficientResources;
+  }
+  p_hdr->nSize = sizeof(*p_hdr);
+  p_hdr->nVersion.nVersion = QOMX_SW_SPEC_VERSION;
+  p_hdr->pBuffer = buffer;
+  p_hdr->nAllocLen = bytes;
+  p_hdr->pAppPrivate = appPrivate;
+  if (port == QOMX_SW_PORT_OUT) {
+    p_hdr->nOutputPortIndex = port;
+  } else {
+    p_hdr->nInputPortIndex = port;
+  }
+
+  pthread_mutex_lock(&p_comp->lock);
+  p_port = &p_comp->ports[port];
+  if (p_port->num_hdr >= QOMX_SW_MAX_BUFS) {
+    pthread_mutex_unlock(&p_comp->lock);
+    free(p_hdr);
+    return OMX_ErrorInsufficientResources;
+  }
+  p_port->hdr[p_port->num_hdr++] = p_hdr;
+  pthread_mutex_unlock(&p_comp->lock);
+
+  *ppBufferHdr = p_hdr;
+  return qomx_sw_post(p_comp, QOMX_SW_MSG_CHECK, OMX_CommandMax, 0);
+}
+
+static OMX_ERRORTYPE qomx_sw_allocate_buffer(OMX_HANDLETYPE hComp,
+  OMX_BUFFERHEADERTYPE **ppBuffer, OMX_U32 port, OMX_PTR appPrivate,
+  OMX_U32 bytes)
+{
+  return OMX_ErrorNotImplemented;
+}
+
+static OMX_ERRORTYPE qomx_sw_free_buffer(OMX_HANDLETYPE hComp, OMX_U32 port,
+  OMX_BUFFERHEADERTYPE *pBuffer)
+{
+  qomx_jpegenc_sw_t *p_comp = qomx_sw_get(hComp);
+  qomx_sw_port_t *p_port;
+  uint32_t i;
+
+  if (!p_comp || !pBuffer || (port >= QOMX_SW_MAX_PORTS)) {
+    return OMX_ErrorBadParameter;
+  }
+  pthread_mutex_lock(&p_comp->lock);
+  p_port = &p_comp->ports[port];
+  for (i = 0; i < p_port->num_hdr; i++) {
+    if (p_port->hdr[i] == pBuffer) {
+      break;
+    }
+  }
+  if (i == p_port->num_hdr) {
+    pthread_mutex_unlock(&p_comp->lock);
+    return OMX_ErrorBadParameter;
+  }
+  p_port->hdr[i] = p_port->hdr[--p_port->num_hdr];
+  pthread_mutex_unlock(&p_comp->lock);
+
+  free(pBuffer);
+  return qomx_sw_post(p_comp, QOMX_SW_MSG_CHECK, OMX_CommandMax, 0);
+}
+
+/** qomx_sw_queue_buffer:
+ *
+ *  Arguments:
+ *    @p_comp: component
+ *    @port: port index
+ *    @p_buf: buffer
+ *
+ *  Return:
+ *       OMX error values
+ *
+ *  Description:
+ *       Queue a buffer on a port and kick the component thread
+ *
+ **/
+static OMX_ERRORTYPE qomx_sw_queue_buffer(qomx_jpegenc_sw_t *p_comp,
+  OMX_U32 port, OMX_BUFFERHEADERTYPE *p_buf)
+{
+  qomx_sw_port_t *p_port;
+
+  if (!p_comp || !p_buf || (port >= QOMX_SW_MAX_PORTS)) {
+    return OMX_ErrorBadParameter;
+  }
+  pthread_mutex_lock(&p_comp->lock);
+  if ((p_comp->state != OMX_StateExecuting) &&
+    (p_comp->state != OMX_StateIdle)) {
+    pthread_mutex_unlock(&p_comp->lock);
+    return OMX_ErrorIncorrectStateOperation;
+  }
+  p_port = &p_comp->ports[port];
+  if (p_port->q_cnt >= QOMX_SW_MAX_BUFS) {
+    pthread_mutex_unlock(&p_comp->lock);
+    return OMX_ErrorInsufficientResources;
+  }
+  p_port->queue[p_port->q_cnt++] = p_buf;
+  pthread_mutex_unlock(&p_comp->lock);
+  return qomx_sw_post(p_comp, QOMX_SW_MSG_PROCESS, OMX_CommandMax, 0);
+}
+
+static OMX_ERRORTYPE qomx_sw_empty_this_buffer(OMX_HANDLETYPE hComp,
+  OMX_BUFFERHEADERTYPE *pBuffer)
+{
+  if (!pBuffer || (pBuffer->nInputPortIndex == QOMX_SW_PORT_OUT)) {
+    return OMX_ErrorBadPortIndex;
+  }
+  return qomx_sw_queue_buffer(qomx_sw_get(hComp), pBuffer->nInputPortIndex,
+    pBuffer);
+}
+
+static OMX_ERRORTYPE qomx_sw_fill_this_buffer(OMX_HANDLETYPE hComp,
+  OMX_BUFFERHEADERTYPE *pBuffer)
+{
+  if (!pBuffer || (pBuffer->nOutputPortIndex != QOMX_SW_PORT_OUT)) {
+    return OMX_ErrorBadPortIndex;
+  }
+  return qomx_sw_queue_buffer(qomx_sw_get(hComp), QOMX_SW_PORT_OUT, pBuffer);
+}
+
+static OMX_ERRORTYPE qomx_sw_set_callbacks(OMX_HANDLETYPE hComp,
+  OMX_CALLBACKTYPE *callbacks, OMX_PTR appData)
+{
+  qomx_jpegenc_sw_t *p_comp = qomx_sw_get(hComp);
+
+  if (!p_comp || !callbacks) {
+    return OMX_ErrorBadParameter;
+  }
+  pthread_mutex_lock(&p_comp->lock);
+  p_comp->callbacks = *callbacks;
+  p_comp->app_data = appData;
+  p_comp->omx_comp.pApplicationPrivate = appData;
+  pthread_mutex_unlock(&p_comp->lock);
+  return OMX_ErrorNone;
+}
+
+static OMX_ERRORTYPE qomx_sw_component_deinit(OMX_HANDLETYPE hComp)
+{
+  qomx_jpegenc_sw_t *p_comp = qomx_sw_get(hComp);
+  uint32_t i, j;
+
+  if (NULL == p_comp) {
+    return OMX_ErrorBadParameter;
+  }
+
+  /* the exit message is delivered even with a full queue */
+  pthread_mutex_lock(&p_comp->lock);
+  p_comp->msg_head = 0;
+  p_comp->msg_cnt = 1;
+  p_comp->msg_q[0].type = QOMX_SW_MSG_EXIT;
+  p_comp->enc.abort = 1;
+  pthread_cond_signal(&p_comp->cond);
+  pthread_mutex_unlock(&p_comp->lock);
+  pthread_join(p_comp->thread, NULL);
+
+  qomx_sw_encoder_deinit(&p_comp->enc);
+  for (i = 0; i < QOMX_SW_MAX_PORTS; i++) {
+    for (j = 0; j < p_comp->ports[i].num_hdr; j++) {
+      free(p_comp->ports[i].hdr[j]);
+    }
+  }
+  qomx_sw_exif_reset(p_comp);
+  qomx_sw_bitbuf_free(&p_comp->tmb_bits);
+  free(p_comp->scratch);
+  free(p_comp->tmb_scratch);
+  free(p_comp->tmb_jpeg);
+  pthread_mutex_destroy(&p_comp->lock);
+  pthread_cond_destroy(&p_comp->cond);
+  free(p_comp);
+  return OMX_ErrorNone;
+}
+
+static OMX_ERRORTYPE qomx_sw_use_egl_image(OMX_HANDLETYPE hComp,
+  OMX_BUFFERHEADERTYPE **ppBufferHdr, OMX_U32 port, OMX_PTR appPrivate,
+  void *eglImage)
+{
+  return OMX_ErrorNotImplemented;
+}
+
+static OMX_ERRORTYPE qomx_sw_component_role_enum(OMX_HANDLETYPE hComp,
+  OMX_U8 *role, OMX_U32 index)
+{
+  if (!role) {
+    return OMX_ErrorBadParameter;
+  }
+  if (index) {
+    return OMX_ErrorNoMore;
+  }
+  strncpy((char *)role, QOMX_SW_ROLE, OMX_MAX_STRINGNAME_SIZE - 1);
+  role[OMX_MAX_STRINGNAME_SIZE - 1] = '\0';
+  return OMX_ErrorNone;
+}
+
+/** qomx_sw_init_port:
+ *
+ *  Arguments:
+ *    @p_port: port
+ *    @index: port index
+ *
+ *  Return:
+ *       none
+ *
+ *  Description:
+ *       Default port definition
+ *
+ **/
+static void qomx_sw_init_port(qomx_sw_port_t *p_port, OMX_U32 index)
+{
+  OMX_PARAM_PORTDEFINITIONTYPE *p_def = &p_port->def;
+
+  memset(p_port, 0, sizeof(*p_port));
+  p_def->nSize = sizeof(*p_def);
+  p_def->nVersion.nVersion = QOMX_SW_SPEC_VERSION;
+  p_def->nPortIndex = index;
+  p_def->eDir = (index == QOMX_SW_PORT_OUT) ? OMX_DirOutput : OMX_DirInput;
+  p_def->nBufferCountActual = 1;
+  p_def->nBufferCountMin = 1;
+  p_def->bEnabled = OMX_TRUE;
+  p_def->eDomain = OMX_PortDomainImage;
+  p_def->format.image.eCompressionFormat = (index == QOMX_SW_PORT_OUT) ?
+    OMX_IMAGE_CodingJPEG : OMX_IMAGE_CodingUnused;
+  p_def->format.image.eColorFormat = (index == QOMX_SW_PORT_OUT) ?
+    OMX_COLOR_FormatUnused :
+    (OMX_COLOR_FORMATTYPE)OMX_QCOM_IMG_COLOR_FormatYVU420SemiPlanar;
+}
+
+/*==============================================================================
+* Function : getInstance
+* Parameters: None
+* Return Value : component object
+* Description: Allocate a new encoder component, called by qomx_core
+==============================================================================*/
+void *getInstance(void)
+{
+  return calloc(1, sizeof(qomx_jpegenc_sw_t));
+}
+
+/*==============================================================================
+* Function : create_component_fns
+* Parameters: obj - object returned by getInstance
+* Return Value : OMX component handle, NULL on failure
+* Description: Initialize the component, start its threads and fill in the
+* OMX function table
+==============================================================================*/
+void *create_component_fns(OMX_PTR obj)
+{
+  qomx_jpegenc_sw_t *p_comp = (qomx_jpegenc_sw_t *)obj;
+  OMX_COMPONENTTYPE *p_omx;
+  char prop[PROPERTY_VALUE_MAX];
+  int num_threads;
+  uint32_t i;
+
+  if (NULL == p_comp) {
+    return NULL;
+  }
+
+  pthread_mutex_init(&p_comp->lock, NULL);
+  pthread_cond_init(&p_comp->cond, NULL);
+  p_comp->state = OMX_StateLoaded;
+  p_comp->target_state = OMX_StateLoaded;
+  for (i = 0; i < QOMX_SW_MAX_PORTS; i++) {
+    qomx_sw_init_port(&p_comp->ports[i], i);
+  }
+  p_comp->quality = QOMX_SW_DEFAULT_QUALITY;
+
+  property_get(QOMX_SW_THREADS_PROP, prop, "0");
+  num_threads = atoi(prop);
+  if (num_threads <= 0) {
+    num_threads = (int)sysconf(_SC_NPROCESSORS_CONF);
+  }
+  qomx_sw_encoder_init(&p_comp->enc, num_threads);
+
+  if (pthread_create(&p_comp->thread, NULL, qomx_sw_thread, p_comp)) {
+    ALOGE("%s:%d] cannot create component thread", __func__, __LINE__);
+    qomx_sw_encoder_deinit(&p_comp->enc);
+    pthread_mutex_destroy(&p_comp->lock);
+    pthread_cond_destroy(&p_comp->cond);
+    free(p_comp);
+    return NULL;
+  }
+
+  p_omx = &p_comp->omx_comp;
+  p_omx->nSize = sizeof(*p_omx);
+  p_omx->nVersion.nVersion = QOMX_SW_SPEC_VERSION;
+  p_omx->pComponentPrivate = p_comp;
+  p_omx->GetComponentVersion = qomx_sw_get_component_version;
+  p_omx->SendCommand = qomx_sw_send_command;
+  p_omx->GetParameter = qomx_sw_get_parameter;
+  p_omx->SetParameter = qomx_sw_set_parameter;
+  p_omx->GetConfig = qomx_sw_get_config;
+  p_omx->SetConfig = qomx_sw_set_config;
+  p_omx->GetExtensionIndex = qomx_sw_get_extension_index;
+  p_omx->GetState = qomx_sw_get_state;
+  p_omx->ComponentTunnelRequest = qomx_sw_tunnel_request;
+  p_omx->UseBuffer = qomx_sw_use_buffer;
+  p_omx->AllocateBuffer = qomx_sw_allocate_buffer;
+  p_omx->FreeBuffer = qomx_sw_free_buffer;
+  p_omx->EmptyThisBuffer = qomx_sw_empty_this_buffer;
+  p_omx->FillThisBuffer = qomx_sw_fill_this_buffer;
+  p_omx->SetCallbacks = qomx_sw_set_callbacks;
+  p_omx->ComponentDeInit = qomx_sw_component_deinit;
+  p_omx->UseEGLImage = qomx_sw_use_egl_image;
+  p_omx->ComponentRoleEnum = qomx_sw_component_role_enum;
+
+  ALOGI("%s:%d] %s with %d threads", __func__, __LINE__, QOMX_SW_COMP_NAME,
+    p_comp->enc.num_threads);
+  return p_omx;
+}
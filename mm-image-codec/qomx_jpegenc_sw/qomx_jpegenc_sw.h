@@ -0,0 +1,297 @@
+/* Copyright (c) 2014, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef QOMX_JPEGENC_SW_H
+#define QOMX_JPEGENC_SW_H
+
+#include <stdint.h>
+#include <pthread.h>
+#include "OMX_Types.h"
+#include "OMX_Index.h"
+#include "OMX_Core.h"
+#include "OMX_Component.h"
+#include "QOMX_JpegExtensions.h"
+
+#define QOMX_SW_COMP_NAME "OMX.qcom.image.jpeg.encoder_sw"
+
+#define QOMX_SW_PORT_IN 0
+#define QOMX_SW_PORT_OUT 1
+#define QOMX_SW_PORT_TMB 2
+#define QOMX_SW_MAX_PORTS 3
+#define QOMX_SW_MAX_BUFS 8
+
+#define QOMX_SW_MAX_THREADS 4
+#define QOMX_SW_SLICES_PER_THREAD 2
+#define QOMX_SW_MAX_EXIF_TAGS 128
+#define QOMX_SW_MSG_Q_SIZE 64
+
+/** qomx_sw_yuv_t
+*  View of a 4:2:0 pseudo planar image
+*  @y: luma plane
+*  @uv: interleaved chroma plane
+*  @width: image width in pixels
+*  @height: image height in pixels
+*  @y_stride: luma stride in bytes
+*  @uv_stride: chroma stride in bytes
+*  @cr_first: chroma is interleaved as CrCb (NV21)
+**/
+typedef struct {
+  const uint8_t *y;
+  const uint8_t *uv;
+  uint32_t width;
+  uint32_t height;
+  uint32_t y_stride;
+  uint32_t uv_stride;
+  int cr_first;
+} qomx_sw_yuv_t;
+
+/** qomx_sw_rect_t
+*  Crop rectangle in luma coordinates
+**/
+typedef struct {
+  uint32_t left;
+  uint32_t top;
+  uint32_t width;
+  uint32_t height;
+} qomx_sw_rect_t;
+
+/** qomx_sw_quant_t
+*  Quantization state of one table
+*  @qtbl: table in natural order, as written to DQT
+*  @recip: reciprocal of each divisor, transposed to match the
+*        lane order of the vector DCT output
+*  @bias: rounding bias of each divisor, transposed
+*  @shift: reciprocal shift of each divisor, transposed
+**/
+typedef struct {
+  uint16_t qtbl[64];
+  int32_t recip[64];
+  int32_t bias[64];
+  int32_t shift[64];
+} qomx_sw_quant_t;
+
+/** qomx_sw_bitbuf_t
+*  Growable entropy coded segment
+*  @buf: output bytes
+*  @len: number of bytes written
+*  @cap: capacity of the buffer
+*  @acc: bit accumulator
+*  @bits: number of valid bits in the accumulator
+*  @error: set when the buffer could not be grown
+**/
+typedef struct {
+  uint8_t *buf;
+  uint32_t len;
+  uint32_t cap;
+  uint64_t acc;
+  int bits;
+  int error;
+} qomx_sw_bitbuf_t;
+
+/** qomx_sw_encoder_t
+*  Slice parallel encoder state, owned by one component
+*  @num_threads: total number of encoding threads including the
+*             component thread
+*  @workers: helper threads
+*  @lock: protects the slice dispatch state
+*  @cond: signalled when a new frame is posted or a slice completes
+*  @generation: frame counter the workers wait on
+*  @exit: set to stop the helper threads
+*  @img: image being encoded
+*  @quant: luma and chroma quantization state
+*  @rows_per_slice: MCU rows per slice (restart interval rows)
+*  @num_slices: number of slices of the current frame
+*  @next_slice: next slice to be picked up
+*  @slices_done: number of finished slices
+*  @slices: per slice entropy coded segments
+*  @slice_cap: number of entries allocated in @slices
+*  @abort: checked between MCU rows to cancel an encode
+**/
+typedef struct {
+  int num_threads;
+  pthread_t workers[QOMX_SW_MAX_THREADS];
+  pthread_mutex_t lock;
+  pthread_cond_t cond;
+  uint32_t generation;
+  int exit;
+  const qomx_sw_yuv_t *img;
+  qomx_sw_quant_t quant[2];
+  uint32_t rows_per_slice;
+  uint32_t num_slices;
+  uint32_t next_slice;
+  uint32_t slices_done;
+  qomx_sw_bitbuf_t *slices;
+  uint32_t slice_cap;
+  volatile int abort;
+} qomx_sw_encoder_t;
+
+/** qomx_sw_exif_tag_t
+*  Component owned copy of one exif tag
+*  @id: qexif tag id (ifd offset and tiff tag)
+*  @type: exif data type
+*  @count: number of elements
+*  @size: payload size in bytes
+*  @data: little endian payload
+**/
+typedef struct {
+  exif_tag_id_t id;
+  uint16_t type;
+  uint32_t count;
+  uint32_t size;
+  uint8_t *data;
+} qomx_sw_exif_tag_t;
+
+/** qomx_sw_port_t
+*  Port state
+*  @def: OMX port definition
+*  @hdr: buffer headers handed out by UseBuffer
+*  @num_hdr: number of buffers in @hdr
+*  @queue: buffers queued by the client, in order
+*  @q_cnt: number of queued buffers
+**/
+typedef struct {
+  OMX_PARAM_PORTDEFINITIONTYPE def;
+  OMX_BUFFERHEADERTYPE *hdr[QOMX_SW_MAX_BUFS];
+  uint32_t num_hdr;
+  OMX_BUFFERHEADERTYPE *queue[QOMX_SW_MAX_BUFS];
+  uint32_t q_cnt;
+} qomx_sw_port_t;
+
+/** qomx_sw_msg_type_t
+*  Messages processed by the component thread
+**/
+typedef enum {
+  QOMX_SW_MSG_CMD,
+  QOMX_SW_MSG_CHECK,
+  QOMX_SW_MSG_PROCESS,
+  QOMX_SW_MSG_EXIT,
+} qomx_sw_msg_type_t;
+
+typedef struct {
+  qomx_sw_msg_type_t type;
+  OMX_COMMANDTYPE cmd;
+  OMX_U32 param;
+} qomx_sw_msg_t;
+
+/** qomx_jpegenc_sw_t
+*  Software JPEG encoder component
+*  @omx_comp: OMX component handle returned to the core
+*  @callbacks: client callbacks
+*  @app_data: client data passed back with the callbacks
+*  @lock: protects the component state
+*  @cond: signals new messages
+*  @thread: component thread
+*  @msg_q: message ring
+*  @state: current OMX state
+*  @target_state: state of a pending transition
+*  @ports: input, output and thumbnail ports
+*  @main_offset: main image plane offsets
+*  @rotation: main image rotation in degrees
+*  @in_crop: main image input crop
+*  @out_crop: main image output size
+*  @quality: main image quality
+*  @qtbl: client quantization tables
+*  @qtbl_set: client quantization tables override the quality
+*  @thumb: thumbnail configuration
+*  @thumb_set: thumbnail configuration is valid
+*  @exif: exif tags of the current job
+*  @num_exif: number of tags in @exif
+*  @enc: slice encoder
+*  @scratch: scaled/rotated main image
+*  @tmb_scratch: scaled/rotated thumbnail image
+*  @tmb_bits: thumbnail entropy coded segment
+*  @tmb_jpeg: thumbnail JPEG embedded in the exif
+**/
+typedef struct {
+  OMX_COMPONENTTYPE omx_comp;
+  OMX_CALLBACKTYPE callbacks;
+  OMX_PTR app_data;
+
+  pthread_mutex_t lock;
+  pthread_cond_t cond;
+  pthread_t thread;
+  qomx_sw_msg_t msg_q[QOMX_SW_MSG_Q_SIZE];
+  uint32_t msg_head;
+  uint32_t msg_cnt;
+
+  OMX_STATETYPE state;
+  OMX_STATETYPE target_state;
+  qomx_sw_port_t ports[QOMX_SW_MAX_PORTS];
+
+  QOMX_YUV_FRAME_INFO main_offset;
+  OMX_S32 rotation;
+  OMX_CONFIG_RECTTYPE in_crop;
+  OMX_CONFIG_RECTTYPE out_crop;
+  OMX_U32 quality;
+  OMX_IMAGE_PARAM_QUANTIZATIONTABLETYPE qtbl[2];
+  int qtbl_set[2];
+  QOMX_THUMBNAIL_INFO thumb;
+  int thumb_set;
+
+  qomx_sw_exif_tag_t exif[QOMX_SW_MAX_EXIF_TAGS];
+  uint32_t num_exif;
+
+  qomx_sw_encoder_t enc;
+  uint8_t *scratch;
+  uint32_t scratch_size;
+  uint8_t *tmb_scratch;
+  uint32_t tmb_scratch_size;
+  qomx_sw_bitbuf_t tmb_bits;
+  uint8_t *tmb_jpeg;
+  uint32_t tmb_jpeg_size;
+} qomx_jpegenc_sw_t;
+
+/* encoder */
+int qomx_sw_encoder_init(qomx_sw_encoder_t *p_enc, int num_threads);
+void qomx_sw_encoder_deinit(qomx_sw_encoder_t *p_enc);
+void qomx_sw_quant_init(qomx_sw_quant_t *p_quant, int chroma,
+  uint32_t quality, const uint8_t *p_custom);
+int qomx_sw_encode_scan(qomx_sw_encoder_t *p_enc, const qomx_sw_yuv_t *p_img);
+int qomx_sw_encode_scan_single(qomx_sw_encoder_t *p_enc,
+  const qomx_sw_yuv_t *p_img, const qomx_sw_quant_t *p_quant,
+  qomx_sw_bitbuf_t *p_bits);
+uint32_t qomx_sw_write_tables(uint8_t *p_out, uint32_t size,
+  const qomx_sw_quant_t *p_quant, uint32_t width, uint32_t height,
+  uint32_t restart_interval);
+uint32_t qomx_sw_write_scan(const qomx_sw_encoder_t *p_enc, uint8_t *p_out,
+  uint32_t size);
+uint32_t qomx_sw_restart_interval(const qomx_sw_encoder_t *p_enc,
+  const qomx_sw_yuv_t *p_img);
+int qomx_sw_transform(const qomx_sw_yuv_t *p_src, const qomx_sw_rect_t *p_crop,
+  uint32_t out_w, uint32_t out_h, int rotation, uint8_t **pp_scratch,
+  uint32_t *p_scratch_size, qomx_sw_yuv_t *p_dst);
+void qomx_sw_bitbuf_free(qomx_sw_bitbuf_t *p_bits);
+
+/* exif */
+int qomx_sw_exif_add(qomx_jpegenc_sw_t *p_comp, QOMX_EXIF_INFO *p_info);
+void qomx_sw_exif_reset(qomx_jpegenc_sw_t *p_comp);
+uint32_t qomx_sw_exif_write(qomx_jpegenc_sw_t *p_comp, uint8_t *p_out,
+  uint32_t size, const uint8_t *p_thumb, uint32_t thumb_len);
+
+#endif /* QOMX_JPEGENC_SW_H */
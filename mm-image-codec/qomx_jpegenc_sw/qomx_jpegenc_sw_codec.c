@@ -0,0 +1,1351 @@
+/* Copyright (c) 2014, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#define LOG_TAG "qomx_jpegenc_sw"
+#include <utils/Log.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "qomx_jpegenc_sw.h"
+
+/* 8 lane vector used by the DCT and the quantizer. The compiler maps it
+ * onto NEON (or SSE on the host) registers. */
+typedef int32_t qomx_sw_v8 __attribute__((vector_size(32)));
+
+#define QOMX_SW_SPLAT(x) ((qomx_sw_v8){x, x, x, x, x, x, x, x})
+
+/* islow DCT constants, scaled by 2^CONST_BITS */
+#define CONST_BITS 13
+#define PASS1_BITS 2
+#define FIX_0_298631336 2446
+#define FIX_0_390180644 3196
+#define FIX_0_541196100 4433
+#define FIX_0_765366865 6270
+#define FIX_0_899976223 7373
+#define FIX_1_175875602 9633
+#define FIX_1_501321110 12299
+#define FIX_1_847759065 15137
+#define FIX_1_961570560 16069
+#define FIX_2_053119869 16819
+#define FIX_2_562915447 20995
+#define FIX_3_072711026 25172
+
+/* worst case bytes a single MCU can produce including 0xFF stuffing */
+#define QOMX_SW_MCU_MAX_BYTES 4096
+#define QOMX_SW_BITBUF_MIN (64 * 1024)
+#define QOMX_SW_MAX_RESTART 65535
+
+/** qomx_sw_huff_t
+*  Derived huffman code table
+*  @code: code of each symbol
+*  @size: code length of each symbol
+**/
+typedef struct {
+  uint16_t code[256];
+  uint8_t size[256];
+} qomx_sw_huff_t;
+
+/* zigzag index to natural index */
+static const uint8_t qomx_sw_natural[64] = {
+   0,  1,  8, 16,  9,  2,  3, 10,
+  17, 24, 32, 25, 18, 11,  4,  5,
+  12, 19, 26, 33, 40, 48, 41, 34,
+  27, 20, 13,  6,  7, 14, 21, 28,
+  35, 42, 49, 56, 57, 50, 43, 36,
+  29, 22, 15, 23, 30, 37, 44, 51,
+  58, 59, 52, 45, 38, 31, 39, 46,
+  53, 60, 61, 54, 47, 55, 62, 63,
+};
+
+/* Annex K quantization tables, natural order */
+static const uint8_t qomx_sw_std_qtbl[2][64] = {
+  {
+    16,  11,  10,  16,  24,  40,  51,  61,
+    12,  12,  14,  19,  26,  58,  60,  55,
+    14,  13,  16,  24,  40,  57,  69,  56,
+    14,  17,  22,  29,  51,  87,  80,  62,
+    18,  22,  37,  56,  68, 109, 103,  77,
+    24,  35,  55,  64,  81, 104, 113,  92,
+    49,  64,  78,  87, 103, 121, 120, 101,
+    72,  92,  95,  98, 112, 100, 103,  99,
+  },
+  {
+    17,  18,  24,  47,  99,  99,  99,  99,
+    18,  21,  26,  66,  99,  99,  99,  99,
+    24,  26,  56,  99,  99,  99,  99,  99,
+    47,  66,  99,  99,  99,  99,  99,  99,
+    99,  99,  99,  99,  99,  99,  99,  99,
+    99,  99,  99,  99,  99,  99,  99,  99,
+    99,  99,  99,  99,  99,  99,  99,  99,
+    99,  99,  99,  99,  99,  99,  99,  99,
+  },
+};
+
+/* Annex K huffman tables: dc luma, ac luma, dc chroma, ac chroma */
+static const uint8_t qomx_sw_dc_bits[2][16] = {
+  { 0, 1, 5, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0 },
+  { 0, 3, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0 },
+};
+
+static const uint8_t qomx_sw_dc_vals[12] = {
+  0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11,
+};
+
+static const uint8_t qomx_sw_ac_bits[2][16] = {
+  { 0, 2, 1, 3, 3, 2, 4, 3, 5, 5, 4, 4, 0, 0, 1, 0x7d },
+  { 0, 2, 1, 2, 4, 4, 3, 4, 7, 5, 4, 4, 0, 1, 2, 0x77 },
+};
+
+static const uint8_t qomx_sw_ac_vals[2][162] = {
+  {
+    0x01, 0x02, 0x03, 0x00, 0x04, 0x11, 0x05, 0x12,
+    0x21, 0x31, 0x41, 0x06, 0x13, 0x51, 0x61, 0x07,
+    0x22, 0x71, 0x14, 0x32, 0x81, 0x91, 0xa1, 0x08,
+    0x23, 0x42, 0xb1, 0xc1, 0x15, 0x52, 0xd1, 0xf0,
+    0x24, 0x33, 0x62, 0x72, 0x82, 0x09, 0x0a, 0x16,
+    0x17, 0x18, 0x19, 0x1a, 0x25, 0x26, 0x27, 0x28,
+    0x29, 0x2a, 0x34, 0x35, 0x36, 0x37, 0x38, 0x39,
+    0x3a, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48, 0x49,
+    0x4a, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59,
+    0x5a, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68, 0x69,
+    0x6a, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78, 0x79,
+    0x7a, 0x83, 0x84, 0x85, 0x86, 0x87, 0x88, 0x89,
+    0x8a, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97, 0x98,
+    0x99, 0x9a, 0xa2, 0xa3, 0xa4, 0xa5, 0xa6, 0xa7,
+    0xa8, 0xa9, 0xaa, 0xb2, 0xb3, 0xb4, 0xb5, 0xb6,
+    0xb7, 0xb8, 0xb9, 0xba, 0xc2, 0xc3, 0xc4, 0xc5,
+    0xc6, 0xc7, 0xc8, 0xc9, 0xca, 0xd2, 0xd3, 0xd4,
+    0xd5, 0xd6, 0xd7, 0xd8, 0xd9, 0xda, 0xe1, 0xe2,
+    0xe3, 0xe4, 0xe5, 0xe6, 0xe7, 0xe8, 0xe9, 0xea,
+    0xf1, 0xf2, 0xf3, 0xf4, 0xf5, 0xf6, 0xf7, 0xf8,
+    0xf9, 0xfa,
+  },
+  {
+    0x00, 0x01, 0x02, 0x03, 0x11, 0x04, 0x05, 0x21,
+    0x31, 0x06, 0x12, 0x41, 0x51, 0x07, 0x61, 0x71,
+    0x13, 0x22, 0x32, 0x81, 0x08, 0x14, 0x42, 0x91,
+    0xa1, 0xb1, 0xc1, 0x09, 0x23, 0x33, 0x52, 0xf0,
+    0x15, 0x62, 0x72, 0xd1, 0x0a, 0x16, 0x24, 0x34,
+    0xe1, 0x25, 0xf1, 0x17, 0x18, 0x19, 0x1a, 0x26,
+    0x27, 0x28, 0x29, 0x2a, 0x35, 0x36, 0x37, 0x38,
+    0x39, 0x3a, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48,
+    0x49, 0x4a, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58,
+    0x59, 0x5a, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68,
+    0x69, 0x6a, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78,
+    0x79, 0x7a, 0x82, 0x83, 0x84, 0x85, 0x86, 0x87,
+    0x88, 0x89, 0x8a, 0x92, 0x93, 0x94, 0x95, 0x96,
+    0x97, 0x98, 0x99, 0x9a, 0xa2, 0xa3, 0xa4, 0xa5,
+    0xa6, 0xa7, 0xa8, 0xa9, 0xaa, 0xb2, 0xb3, 0xb4,
+    0xb5, 0xb6, 0xb7, 0xb8, 0xb9, 0xba, 0xc2, 0xc3,
+    0xc4, 0xc5, 0xc6, 0xc7, 0xc8, 0xc9, 0xca, 0xd2,
+    0xd3, 0xd4, 0xd5, 0xd6, 0xd7, 0xd8, 0xd9, 0xda,
+    0xe2, 0xe3, 0xe4, 0xe5, 0xe6, 0xe7, 0xe8, 0xe9,
+    0xea, 0xf2, 0xf3, 0xf4, 0xf5, 0xf6, 0xf7, 0xf8,
+    0xf9, 0xfa,
+  },
+};
+
+/* derived tables: [0] luma, [1] chroma */
+static qomx_sw_huff_t g_dc_huff[2];
+static qomx_sw_huff_t g_ac_huff[2];
+/* zigzag index to transposed (lane order) index */
+static uint8_t g_zigzag_t[64];
+static pthread_once_t g_tables_once = PTHREAD_ONCE_INIT;
+
+/** qomx_sw_derive_huff:
+ *
+ *  Arguments:
+ *    @p_bits: number of codes of each length
+ *    @p_vals: symbols in code order
+ *    @p_huff: derived table
+ *
+ *  Return:
+ *       none
+ *
+ *  Description:
+ *       Generate the code of each symbol (JPEG Annex C)
+ *
+ **/
+static void qomx_sw_derive_huff(const uint8_t *p_bits, const uint8_t *p_vals,
+  qomx_sw_huff_t *p_huff)
+{
+  uint32_t code = 0;
+  int len, i, k = 0;
+
+  memset(p_huff, 0, sizeof(*p_huff));
+  for (len = 1; len <= 16; len++) {
+    for (i = 0; i < p_bits[len - 1]; i++) {
+      p_huff->code[p_vals[k]] = (uint16_t)code;
+      p_huff->size[p_vals[k]] = (uint8_t)len;
+      code++;
+      k++;
+    }
+    code <<= 1;
+  }
+}
+
+/** qomx_sw_init_tables:
+ *
+ *  Arguments:
+ *    none
+ *
+ *  Return:
+ *       none
+ *
+ *  Description:
+ *       Build the process wide constant tables
+ *
+ **/
+static void qomx_sw_init_tables(void)
+{
+  int i, n;
+
+  for (i = 0; i < 2; i++) {
+    qomx_sw_derive_huff(qomx_sw_dc_bits[i], qomx_sw_dc_vals, &g_dc_huff[i]);
+    qomx_sw_derive_huff(qomx_sw_ac_bits[i], qomx_sw_ac_vals[i], &g_ac_huff[i]);
+  }
+  for (i = 0; i < 64; i++) {
+    n = qomx_sw_natural[i];
+    g_zigzag_t[i] = (uint8_t)(((n & 7) << 3) | (n >> 3));
+  }
+}
+
+/** qomx_sw_quant_init:
+ *
+ *  Arguments:
+ *    @p_quant: quantization state
+ *    @chroma: build the chroma table
+ *    @quality: quality in the range 1-100
+ *    @p_custom: client table in natural order, NULL to use the
+ *             scaled standard table
+ *
+ *  Return:
+ *       none
+ *
+ *  Description:
+ *       Scale the quantization table (IJG quality scaling) and
+ *       precompute the reciprocals used by the vector quantizer.
+ *       floor((x + d/2) * ceil(2^s/d) >> s) with d = 8q and
+ *       s = 16 + log2(d) is exact for every DCT output, so no
+ *       division is needed.
+ *
+ **/
+void qomx_sw_quant_init(qomx_sw_quant_t *p_quant, int chroma,
+  uint32_t quality, const uint8_t *p_custom)
+{
+  uint32_t scale, q, d, b, s;
+  int n, t;
+
+  if (quality < 1) {
+    quality = 1;
+  } else if (quality > 100) {
+    quality = 100;
+  }
+  scale = (quality < 50) ? (5000 / quality) : (200 - quality * 2);
+
+  for (n = 0; n < 64; n++) {
+    if (p_custom) {
+      q = p_custom[n];
+    } else {
+      q = (qomx_sw_std_qtbl[chroma ? 1 : 0][n] * scale + 50) / 100;
+    }
+    if (q < 1) {
+      q = 1;
+    } else if (q > 255) {
+      q = 255;
+    }
+    p_quant->qtbl[n] = (uint16_t)q;
+
+    /* the DCT output keeps the factor of 8 */
+    d = q << 3;
+    for (b = 0; (2U << b) <= d; b++);
+    s = 16 + b;
+    t = ((n & 7) << 3) | (n >> 3);
+    p_quant->recip[t] = (int32_t)(((1U << s) + d - 1) / d);
+    p_quant->bias[t] = (int32_t)(d >> 1);
+    p_quant->shift[t] = (int32_t)s;
+  }
+}
+
+/** qomx_sw_bitbuf_reserve:
+ *
+ *  Arguments:
+ *    @p_bits: entropy coded segment
+ *    @n: number of bytes needed
+ *
+ *  Return:
+ *       0 on success, -1 if the buffer cannot grow
+ *
+ *  Description:
+ *       Make sure @n bytes can be appended
+ *
+ **/
+static int qomx_sw_bitbuf_reserve(qomx_sw_bitbuf_t *p_bits, uint32_t n)
+{
+  uint32_t cap;
+  uint8_t *buf;
+
+  if (p_bits->cap - p_bits->len >= n) {
+    return 0;
+  }
+  cap = p_bits->cap ? p_bits->cap * 2 : QOMX_SW_BITBUF_MIN;
+  while (cap - p_bits->len < n) {
+    cap *= 2;
+  }
+  buf = realloc(p_bits->buf, cap);
+  if (NULL == buf) {
+    p_bits->error = 1;
+    return -1;
+  }
+  p_bits->buf = buf;
+  p_bits->cap = cap;
+  return 0;
+}
+
+/** qomx_sw_bitbuf_free:
+ *
+ *  Arguments:
+ *    @p_bits: entropy coded segment
+ *
+ *  Return:
+ *       none
+ *
+ *  Description:
+ *       Release the segment memory
+ *
+ **/
+void qomx_sw_bitbuf_free(qomx_sw_bitbuf_t *p_bits)
+{
+  free(p_bits->buf);
+  memset(p_bits, 0, sizeof(*p_bits));
+}
+
+/** qomx_sw_put_bits:
+ *
+ *  Arguments:
+ *    @p_bits: entropy coded segment
+ *    @code: right aligned bits
+ *    @size: number of bits, at most 32
+ *
+ *  Return:
+ *       none
+ *
+ *  Description:
+ *       Append bits, stuffing a zero after every 0xFF byte. The
+ *       caller reserves the space once per MCU.
+ *
+ **/
+static inline void qomx_sw_put_bits(qomx_sw_bitbuf_t *p_bits, uint32_t code,
+  int size)
+{
+  uint8_t byte;
+
+  p_bits->acc = (p_bits->acc << size) | code;
+  p_bits->bits += size;
+  while (p_bits->bits >= 8) {
+    p_bits->bits -= 8;
+    byte = (uint8_t)(p_bits->acc >> p_bits->bits);
+    p_bits->buf[p_bits->len++] = byte;
+    if (byte == 0xFF) {
+      p_bits->buf[p_bits->len++] = 0;
+    }
+  }
+}
+
+/** qomx_sw_flush_bits:
+ *
+ *  Arguments:
+ *    @p_bits: entropy coded segment
+ *
+ *  Return:
+ *       none
+ *
+ *  Description:
+ *       Pad the last byte with one bits
+ *
+ **/
+static void qomx_sw_flush_bits(qomx_sw_bitbuf_t *p_bits)
+{
+  int pad = (8 - (p_bits->bits & 7)) & 7;
+
+  if (pad) {
+    qomx_sw_put_bits(p_bits, (1U << pad) - 1, pad);
+  }
+  p_bits->acc = 0;
+}
+
+/** qomx_sw_fdct_1d:
+ *
+ *  Arguments:
+ *    @d: 8 rows, each lane is an independent column
+ *    @pass: 0 for the first pass, 1 for the second
+ *
+ *  Return:
+ *       none
+ *
+ *  Description:
+ *       Vertical 8 point LLM forward DCT on 8 columns at once.
+ *       As in the islow DCT the outputs of the second pass are
+ *       scaled up by 8, which the quantizer divides out.
+ *
+ **/
+static inline void qomx_sw_fdct_1d(qomx_sw_v8 d[8], int pass)
+{
+  qomx_sw_v8 tmp0, tmp1, tmp2, tmp3, tmp4, tmp5, tmp6, tmp7;
+  qomx_sw_v8 tmp10, tmp11, tmp12, tmp13;
+  qomx_sw_v8 z1, z2, z3, z4, z5;
+  const int sh_even = pass ? PASS1_BITS : 0;
+  const int sh_odd = pass ? (CONST_BITS + PASS1_BITS) :
+    (CONST_BITS - PASS1_BITS);
+  const qomx_sw_v8 rnd_even = QOMX_SW_SPLAT(pass ? (1 << (sh_even - 1)) : 0);
+  const qomx_sw_v8 rnd_odd = QOMX_SW_SPLAT(1 << (sh_odd - 1));
+
+  tmp0 = d[0] + d[7];
+  tmp7 = d[0] - d[7];
+  tmp1 = d[1] + d[6];
+  tmp6 = d[1] - d[6];
+  tmp2 = d[2] + d[5];
+  tmp5 = d[2] - d[5];
+  tmp3 = d[3] + d[4];
+  tmp4 = d[3] - d[4];
+
+  tmp10 = tmp0 + tmp3;
+  tmp13 = tmp0 - tmp3;
+  tmp11 = tmp1 + tmp2;
+  tmp12 = tmp1 - tmp2;
+
+  if (pass) {
+    d[0] = (tmp10 + tmp11 + rnd_even) >> sh_even;
+    d[4] = (tmp10 - tmp11 + rnd_even) >> sh_even;
+  } else {
+    d[0] = (tmp10 + tmp11) << PASS1_BITS;
+    d[4] = (tmp10 - tmp11) << PASS1_BITS;
+  }
+
+  z1 = (tmp12 + tmp13) * QOMX_SW_SPLAT(FIX_0_541196100);
+  d[2] = (z1 + tmp13 * QOMX_SW_SPLAT(FIX_0_765366865) + rnd_odd) >> sh_odd;
+  d[6] = (z1 - tmp12 * QOMX_SW_SPLAT(FIX_1_847759065) + rnd_odd) >> sh_odd;
+
+  z1 = tmp4 + tmp7;
+  z2 = tmp5 + tmp6;
+  z3 = tmp4 + tmp6;
+  z4 = tmp5 + tmp7;
+  z5 = (z3 + z4) * QOMX_SW_SPLAT(FIX_1_175875602);
+
+  tmp4 = tmp4 * QOMX_SW_SPLAT(FIX_0_298631336);
+  tmp5 = tmp5 * QOMX_SW_SPLAT(FIX_2_053119869);
+  tmp6 = tmp6 * QOMX_SW_SPLAT(FIX_3_072711026);
+  tmp7 = tmp7 * QOMX_SW_SPLAT(FIX_1_501321110);
+  z1 = z1 * QOMX_SW_SPLAT(-FIX_0_899976223);
+  z2 = z2 * QOMX_SW_SPLAT(-FIX_2_562915447);
+  z3 = z3 * QOMX_SW_SPLAT(-FIX_1_961570560) + z5;
+  z4 = z4 * QOMX_SW_SPLAT(-FIX_0_390180644) + z5;
+
+  d[7] = (tmp4 + z1 + z3 + rnd_odd) >> sh_odd;
+  d[5] = (tmp5 + z2 + z4 + rnd_odd) >> sh_odd;
+  d[3] = (tmp6 + z2 + z3 + rnd_odd) >> sh_odd;
+  d[1] = (tmp7 + z1 + z4 + rnd_odd) >> sh_odd;
+}
+
+/** qomx_sw_quant_vec_t
+*  Quantization state loaded into vector registers
+**/
+typedef struct {
+  qomx_sw_v8 recip[8];
+  qomx_sw_v8 bias[8];
+  qomx_sw_v8 shift[8];
+} qomx_sw_quant_vec_t;
+
+typedef union {
+  qomx_sw_v8 v[8];
+  int32_t s[8][8];
+} qomx_sw_block_t;
+
+/** qomx_sw_fdct_quant:
+ *
+ *  Arguments:
+ *    @p_blk: level shifted samples in, quantized coefficients out
+ *           (transposed, see g_zigzag_t)
+ *    @p_qv: quantization vectors
+ *
+ *  Return:
+ *       none
+ *
+ *  Description:
+ *       2D forward DCT and quantization of one block
+ *
+ **/
+static inline void qomx_sw_fdct_quant(qomx_sw_block_t *p_blk,
+  const qomx_sw_quant_vec_t *p_qv)
+{
+  qomx_sw_block_t t;
+  qomx_sw_v8 x, s;
+  int r, c;
+
+  qomx_sw_fdct_1d(p_blk->v, 0);
+  for (r = 0; r < 8; r++) {
+    for (c = 0; c < 8; c++) {
+      t.s[c][r] = p_blk->s[r][c];
+    }
+  }
+  qomx_sw_fdct_1d(t.v, 1);
+
+  for (r = 0; r < 8; r++) {
+    x = t.v[r];
+    s = x >> 31;
+    x = (x ^ s) - s;
+    x = ((x + p_qv->bias[r]) * p_qv->recip[r]) >> p_qv->shift[r];
+    p_blk->v[r] = (x ^ s) - s;
+  }
+}
+
+/** qomx_sw_encode_block:
+ *
+ *  Arguments:
+ *    @p_bits: entropy coded segment
+ *    @p_coef: quantized coefficients in transposed order
+ *    @p_last_dc: DC predictor of the component
+ *    @p_dc: DC huffman table
+ *    @p_ac: AC huffman table
+ *
+ *  Return:
+ *       none
+ *
+ *  Description:
+ *       Huffman code one block (baseline sequential)
+ *
+ **/
+static inline void qomx_sw_encode_block(qomx_sw_bitbuf_t *p_bits,
+  const int32_t *p_coef, int32_t *p_last_dc, const qomx_sw_huff_t *p_dc,
+  const qomx_sw_huff_t *p_ac)
+{
+  int32_t v, a;
+  int k, run = 0, nbits, sym;
+
+  v = p_coef[0] - *p_last_dc;
+  *p_last_dc = p_coef[0];
+  a = v < 0 ? -v : v;
+  nbits = a ? (32 - __builtin_clz((uint32_t)a)) : 0;
+  if (nbits > 11) {
+    nbits = 11;
+    a = 2047;
+    v = v < 0 ? -2047 : 2047;
+  }
+  qomx_sw_put_bits(p_bits, p_dc->code[nbits], p_dc->size[nbits]);
+  if (nbits) {
+    if (v < 0) {
+      v--;
+    }
+    qomx_sw_put_bits(p_bits, (uint32_t)v & ((1U << nbits) - 1), nbits);
+  }
+
+  for (k = 1; k < 64; k++) {
+    v = p_coef[g_zigzag_t[k]];
+    if (0 == v) {
+      run++;
+      continue;
+    }
+    while (run > 15) {
+      qomx_sw_put_bits(p_bits, p_ac->code[0xF0], p_ac->size[0xF0]);
+      run -= 16;
+    }
+    a = v < 0 ? -v : v;
+    if (a > 1023) {
+      a = 1023;
+      v = v < 0 ? -1023 : 1023;
+    }
+    nbits = 32 - __builtin_clz((uint32_t)a);
+    sym = (run << 4) | nbits;
+    if (v < 0) {
+      v--;
+    }
+    qomx_sw_put_bits(p_bits,
+      ((uint32_t)p_ac->code[sym] << nbits) | ((uint32_t)v & ((1U << nbits) - 1)),
+      p_ac->size[sym] + nbits);
+    run = 0;
+  }
+  if (run) {
+    qomx_sw_put_bits(p_bits, p_ac->code[0], p_ac->size[0]);
+  }
+}
+
+/** qomx_sw_load_block:
+ *
+ *  Arguments:
+ *    @p_blk: output block
+ *    @p_plane: plane base
+ *    @stride: plane stride
+ *    @x: block column in samples
+ *    @y: block row in samples
+ *    @w: plane width in samples
+ *    @h: plane height in samples
+ *    @step: distance between samples (2 for interleaved chroma)
+ *
+ *  Return:
+ *       none
+ *
+ *  Description:
+ *       Load and level shift an 8x8 block, replicating the last
+ *       column/row for blocks crossing the image edge
+ *
+ **/
+static inline void qomx_sw_load_block(qomx_sw_block_t *p_blk,
+  const uint8_t *p_plane, uint32_t stride, uint32_t x, uint32_t y,
+  uint32_t w, uint32_t h, uint32_t step)
+{
+  const qomx_sw_v8 center = QOMX_SW_SPLAT(128);
+  const uint8_t *s;
+  uint32_t r, c, xx, yy;
+
+  if ((x + 8 <= w) && (y + 8 <= h)) {
+    s = p_plane + y * stride + x * step;
+    for (r = 0; r < 8; r++, s += stride) {
+      if (step == 1) {
+        p_blk->v[r] = (qomx_sw_v8){s[0], s[1], s[2], s[3],
+          s[4], s[5], s[6], s[7]} - center;
+      } else {
+        p_blk->v[r] = (qomx_sw_v8){s[0], s[2], s[4], s[6],
+          s[8], s[10], s[12], s[14]} - center;
+      }
+    }
+    return;
+  }
+
+  for (r = 0; r < 8; r++) {
+    yy = (y + r < h) ? (y + r) : (h - 1);
+    s = p_plane + yy * stride;
+    for (c = 0; c < 8; c++) {
+      xx = (x + c < w) ? (x + c) : (w - 1);
+      p_blk->s[r][c] = (int32_t)s[xx * step] - 128;
+    }
+  }
+}
+
+/** qomx_sw_encode_rows:
+ *
+ *  Arguments:
+ *    @p_img: source image
+ *    @p_quant: luma and chroma quantization state
+ *    @row0: first MCU row
+ *    @row1: MCU row after the last one
+ *    @p_bits: entropy coded segment
+ *    @p_abort: optional cancel flag
+ *
+ *  Return:
+ *       0 on success, -1 on failure or abort
+ *
+ *  Description:
+ *       Encode a run of MCU rows as one restart interval. The
+ *       segment is reset and DC predictors start from zero, so
+ *       independent intervals can be encoded concurrently.
+ *
+ **/
+static int qomx_sw_encode_rows(const qomx_sw_yuv_t *p_img,
+  const qomx_sw_quant_t *p_quant, uint32_t row0, uint32_t row1,
+  qomx_sw_bitbuf_t *p_bits, volatile int *p_abort)
+{
+  qomx_sw_quant_vec_t qv[2];
+  qomx_sw_block_t blk;
+  int32_t dc[3] = { 0, 0, 0 };
+  uint32_t mx, my, i, bx, by;
+  uint32_t mcus_x = (p_img->width + 15) >> 4;
+  uint32_t cw = (p_img->width + 1) >> 1;
+  uint32_t ch = (p_img->height + 1) >> 1;
+  const uint8_t *cb = p_img->uv + (p_img->cr_first ? 1 : 0);
+  const uint8_t *cr = p_img->uv + (p_img->cr_first ? 0 : 1);
+
+  for (i = 0; i < 2; i++) {
+    memcpy(qv[i].recip, p_quant[i].recip, sizeof(qv[i].recip));
+    memcpy(qv[i].bias, p_quant[i].bias, sizeof(qv[i].bias));
+    memcpy(qv[i].shift, p_quant[i].shift, sizeof(qv[i].shift));
+  }
+
+  p_bits->len = 0;
+  p_bits->acc = 0;
+  p_bits->bits = 0;
+  p_bits->error = 0;
+
+  for (my = row0; my < row1; my++) {
+    if (p_abort && *p_abort) {
+      return -1;
+    }
+    for (mx = 0; mx < mcus_x; mx++) {
+      if (qomx_sw_bitbuf_reserve(p_bits, QOMX_SW_MCU_MAX_BYTES)) {
+        ALOGE("%s:%d] cannot grow slice buffer", __func__, __LINE__);
+        return -1;
+      }
+      for (i = 0; i < 4; i++) {
+        bx = (mx << 4) + ((i & 1) << 3);
+        by = (my << 4) + ((i >> 1) << 3);
+        qomx_sw_load_block(&blk, p_img->y, p_img->y_stride, bx, by,
+          p_img->width, p_img->height, 1);
+        qomx_sw_fdct_quant(&blk, &qv[0]);
+        qomx_sw_encode_block(p_bits, &blk.s[0][0], &dc[0], &g_dc_huff[0],
+          &g_ac_huff[0]);
+      }
+      bx = mx << 3;
+      by = my << 3;
+      qomx_sw_load_block(&blk, cb, p_img->uv_stride, bx, by, cw, ch, 2);
+      qomx_sw_fdct_quant(&blk, &qv[1]);
+      qomx_sw_encode_block(p_bits, &blk.s[0][0], &dc[1], &g_dc_huff[1],
+        &g_ac_huff[1]);
+      qomx_sw_load_block(&blk, cr, p_img->uv_stride, bx, by, cw, ch, 2);
+      qomx_sw_fdct_quant(&blk, &qv[1]);
+      qomx_sw_encode_block(p_bits, &blk.s[0][0], &dc[2], &g_dc_huff[1],
+        &g_ac_huff[1]);
+    }
+  }
+  qomx_sw_flush_bits(p_bits);
+  return 0;
+}
+
+/** qomx_sw_run_slices:
+ *
+ *  Arguments:
+ *    @p_enc: encoder
+ *
+ *  Return:
+ *       none
+ *
+ *  Description:
+ *       Pick up slices of the current frame until none is left
+ *
+ **/
+static void qomx_sw_run_slices(qomx_sw_encoder_t *p_enc)
+{
+  uint32_t idx, row0, row1, mcu_rows;
+
+  mcu_rows = (p_enc->img->height + 15) >> 4;
+  while (1) {
+    pthread_mutex_lock(&p_enc->lock);
+    if (p_enc->next_slice >= p_enc->num_slices) {
+      pthread_mutex_unlock(&p_enc->lock);
+      break;
+    }
+    idx = p_enc->next_slice++;
+    pthread_mutex_unlock(&p_enc->lock);
+
+    row0 = idx * p_enc->rows_per_slice;
+    row1 = row0 + p_enc->rows_per_slice;
+    if (row1 > mcu_rows) {
+      row1 = mcu_rows;
+    }
+    if (qomx_sw_encode_rows(p_enc->img, p_enc->quant, row0, row1,
+      &p_enc->slices[idx], &p_enc->abort)) {
+      p_enc->slices[idx].error = 1;
+    }
+
+    pthread_mutex_lock(&p_enc->lock);
+    p_enc->slices_done++;
+    if (p_enc->slices_done == p_enc->num_slices) {
+      pthread_cond_broadcast(&p_enc->cond);
+    }
+    pthread_mutex_unlock(&p_enc->lock);
+  }
+}
+
+/** qomx_sw_worker:
+ *
+ *  Arguments:
+ *    @data: encoder
+ *
+ *  Return:
+ *       NULL
+ *
+ *  Description:
+ *       Helper thread, joins each posted frame
+ *
+ **/
+static void *qomx_sw_worker(void *data)
+{
+  qomx_sw_encoder_t *p_enc = (qomx_sw_encoder_t *)data;
+  uint32_t seen;
+
+  pthread_mutex_lock(&p_enc->lock);
+  seen = p_enc->generation;
+  while (1) {
+    while (!p_enc->exit && (seen == p_enc->generation)) {
+      pthread_cond_wait(&p_enc->cond, &p_enc->lock);
+    }
+    if (p_enc->exit) {
+      break;
+    }
+    seen = p_enc->generation;
+    pthread_mutex_unlock(&p_enc->lock);
+    qomx_sw_run_slices(p_enc);
+    pthread_mutex_lock(&p_enc->lock);
+  }
+  pthread_mutex_unlock(&p_enc->lock);
+  return NULL;
+}
+
+/** qomx_sw_encoder_init:
+ *
+ *  Arguments:
+ *    @p_enc: encoder
+ *    @num_threads: number of encoding threads including the caller
+ *
+ *  Return:
+ *       0 on success
+ *
+ *  Description:
+ *       Initialize the encoder and start the helper threads
+ *
+ **/
+int qomx_sw_encoder_init(qomx_sw_encoder_t *p_enc, int num_threads)
+{
+  int i;
+
+  pthread_once(&g_tables_once, qomx_sw_init_tables);
+
+  memset(p_enc, 0, sizeof(*p_enc));
+  if (num_threads < 1) {
+    num_threads = 1;
+  } else if (num_threads > QOMX_SW_MAX_THREADS) {
+    num_threads = QOMX_SW_MAX_THREADS;
+  }
+  pthread_mutex_init(&p_enc->lock, NULL);
+  pthread_cond_init(&p_enc->cond, NULL);
+
+  p_enc->num_threads = 1;
+  for (i = 1; i < num_threads; i++) {
+    if (pthread_create(&p_enc->workers[i], NULL, qomx_sw_worker, p_enc)) {
+      ALOGE("%s:%d] cannot create worker %d", __func__, __LINE__, i);
+      break;
+    }
+    p_enc->num_threads++;
+  }
+  return 0;
+}
+
+/** qomx_sw_encoder_deinit:
+ *
+ *  Arguments:
+ *    @p_enc: encoder
+ *
+ *  Return:
+ *       none
+ *
+ *  Description:
+ *       Stop the helper threads and release the slice buffers
+ *
+ **/
+void qomx_sw_encoder_deinit(qomx_sw_encoder_t *p_enc)
+{
+  uint32_t i;
+
+  pthread_mutex_lock(&p_enc->lock);
+  p_enc->exit = 1;
+  pthread_cond_broadcast(&p_enc->cond);
+  pthread_mutex_unlock(&p_enc->lock);
+  for (i = 1; i < (uint32_t)p_enc->num_threads; i++) {
+    pthread_join(p_enc->workers[i], NULL);
+  }
+
+  for (i = 0; i < p_enc->slice_cap; i++) {
+    qomx_sw_bitbuf_free(&p_enc->slices[i]);
+  }
+  free(p_enc->slices);
+  p_enc->slices = NULL;
+  p_enc->slice_cap = 0;
+  pthread_mutex_destroy(&p_enc->lock);
+  pthread_cond_destroy(&p_enc->cond);
+}
+
+/** qomx_sw_encode_scan:
+ *
+ *  Arguments:
+ *    @p_enc: encoder, quantization state already set
+ *    @p_img: image to encode
+ *
+ *  Return:
+ *       0 on success, -1 on failure
+ *
+ *  Description:
+ *       Split the image in horizontal slices of whole MCU rows and
+ *       encode them in parallel. Every slice but the last has the
+ *       same number of MCUs, which becomes the restart interval.
+ *
+ **/
+int qomx_sw_encode_scan(qomx_sw_encoder_t *p_enc, const qomx_sw_yuv_t *p_img)
+{
+  uint32_t mcus_x = (p_img->width + 15) >> 4;
+  uint32_t mcu_rows = (p_img->height + 15) >> 4;
+  uint32_t target, rps, num_slices, i;
+  qomx_sw_bitbuf_t *slices;
+
+  if (!mcus_x || !mcu_rows || (mcus_x > QOMX_SW_MAX_RESTART)) {
+    ALOGE("%s:%d] invalid dimension %dx%d", __func__, __LINE__,
+      p_img->width, p_img->height);
+    return -1;
+  }
+
+  if (p_enc->num_threads > 1) {
+    target = (uint32_t)p_enc->num_threads * QOMX_SW_SLICES_PER_THREAD;
+    rps = (mcu_rows + target - 1) / target;
+    if (rps * mcus_x > QOMX_SW_MAX_RESTART) {
+      rps = QOMX_SW_MAX_RESTART / mcus_x;
+    }
+  } else {
+    rps = mcu_rows;
+  }
+  num_slices = (mcu_rows + rps - 1) / rps;
+
+  if (num_slices > p_enc->slice_cap) {
+    slices = realloc(p_enc->slices, num_slices * sizeof(*slices));
+    if (NULL == slices) {
+      ALOGE("%s:%d] no memory for %d slices", __func__, __LINE__, num_slices);
+      return -1;
+    }
+    memset(&slices[p_enc->slice_cap], 0,
+      (num_slices - p_enc->slice_cap) * sizeof(*slices));
+    p_enc->slices = slices;
+    p_enc->slice_cap = num_slices;
+  }
+
+  pthread_mutex_lock(&p_enc->lock);
+  p_enc->img = p_img;
+  p_enc->rows_per_slice = rps;
+  p_enc->num_slices = num_slices;
+  p_enc->next_slice = 0;
+  p_enc->slices_done = 0;
+  p_enc->generation++;
+  pthread_cond_broadcast(&p_enc->cond);
+  pthread_mutex_unlock(&p_enc->lock);
+
+  qomx_sw_run_slices(p_enc);
+
+  pthread_mutex_lock(&p_enc->lock);
+  while (p_enc->slices_done < p_enc->num_slices) {
+    pthread_cond_wait(&p_enc->cond, &p_enc->lock);
+  }
+  pthread_mutex_unlock(&p_enc->lock);
+
+  for (i = 0; i < num_slices; i++) {
+    if (p_enc->slices[i].error) {
+      return -1;
+    }
+  }
+  return 0;
+}
+
+/** qomx_sw_encode_scan_single:
+ *
+ *  Arguments:
+ *    @p_enc: encoder (for the abort flag)
+ *    @p_img: image to encode
+ *    @p_quant: luma and chroma quantization state
+ *    @p_bits: entropy coded segment
+ *
+ *  Return:
+ *       0 on success, -1 on failure
+ *
+ *  Description:
+ *       Encode a small image (thumbnail) on the calling thread
+ *
+ **/
+int qomx_sw_encode_scan_single(qomx_sw_encoder_t *p_enc,
+  const qomx_sw_yuv_t *p_img, const qomx_sw_quant_t *p_quant,
+  qomx_sw_bitbuf_t *p_bits)
+{
+  pthread_once(&g_tables_once, qomx_sw_init_tables);
+  return qomx_sw_encode_rows(p_img, p_quant, 0, (p_img->height + 15) >> 4,
+    p_bits, &p_enc->abort);
+}
+
+#define QOMX_SW_PUT16(p, v) do { \
+  *(p)++ = (uint8_t)((v) >> 8); \
+  *(p)++ = (uint8_t)(v); \
+} while (0)
+
+/** qomx_sw_write_tables:
+ *
+ *  Arguments:
+ *    @p_out: output
+ *    @size: output space
+ *    @p_quant: luma and chroma quantization state
+ *    @width: image width
+ *    @height: image height
+ *    @restart_interval: MCUs per restart interval, 0 for none
+ *
+ *  Return:
+ *       number of bytes written, 0 if @size is too small
+ *
+ *  Description:
+ *       Write DQT, SOF0, DHT, DRI and SOS for a 4:2:0 image
+ *
+ **/
+uint32_t qomx_sw_write_tables(uint8_t *p_out, uint32_t size,
+  const qomx_sw_quant_t *p_quant, uint32_t width, uint32_t height,
+  uint32_t restart_interval)
+{
+  uint8_t *p = p_out;
+  int i, k, n;
+
+  if (size < 2 + 132 + 2 + 17 + 2 + 418 + 6 + 2 + 12) {
+    return 0;
+  }
+
+  /* DQT */
+  *p++ = 0xFF;
+  *p++ = 0xDB;
+  QOMX_SW_PUT16(p, 2 + 2 * 65);
+  for (i = 0; i < 2; i++) {
+    *p++ = (uint8_t)i;
+    for (k = 0; k < 64; k++) {
+      *p++ = (uint8_t)p_quant[i].qtbl[qomx_sw_natural[k]];
+    }
+  }
+
+  /* SOF0 */
+  *p++ = 0xFF;
+  *p++ = 0xC0;
+  QOMX_SW_PUT16(p, 17);
+  *p++ = 8;
+  QOMX_SW_PUT16(p, height);
+  QOMX_SW_PUT16(p, width);
+  *p++ = 3;
+  *p++ = 1; *p++ = 0x22; *p++ = 0;
+  *p++ = 2; *p++ = 0x11; *p++ = 1;
+  *p++ = 3; *p++ = 0x11; *p++ = 1;
+
+  /* DHT */
+  *p++ = 0xFF;
+  *p++ = 0xC4;
+  QOMX_SW_PUT16(p, 2 + 4 * 17 + 2 * 12 + 2 * 162);
+  for (i = 0; i < 2; i++) {
+    *p++ = (uint8_t)(0x00 | i);
+    memcpy(p, qomx_sw_dc_bits[i], 16);
+    p += 16;
+    for (k = 0, n = 0; k < 16; k++) {
+      n += qomx_sw_dc_bits[i][k];
+    }
+    memcpy(p, qomx_sw_dc_vals, (size_t)n);
+    p += n;
+
+    *p++ = (uint8_t)(0x10 | i);
+    memcpy(p, qomx_sw_ac_bits[i], 16);
+    p += 16;
+    for (k = 0, n = 0; k < 16; k++) {
+      n += qomx_sw_ac_bits[i][k];
+    }
+    memcpy(p, qomx_sw_ac_vals[i], (size_t)n);
+    p += n;
+  }
+
+  /* DRI */
+  if (restart_interval) {
+    *p++ = 0xFF;
+    *p++ = 0xDD;
+    QOMX_SW_PUT16(p, 4);
+    QOMX_SW_PUT16(p, restart_interval);
+  }
+
+  /* SOS */
+  *p++ = 0xFF;
+  *p++ = 0xDA;
+  QOMX_SW_PUT16(p, 12);
+  *p++ = 3;
+  *p++ = 1; *p++ = 0x00;
+  *p++ = 2; *p++ = 0x11;
+  *p++ = 3; *p++ = 0x11;
+  *p++ = 0;
+  *p++ = 63;
+  *p++ = 0;
+
+  return (uint32_t)(p - p_out);
+}
+
+/** qomx_sw_write_scan:
+ *
+ *  Arguments:
+ *    @p_enc: encoder holding the slices of the last frame
+ *    @p_out: output
+ *    @size: output space
+ *
+ *  Return:
+ *       number of bytes written, 0 if @size is too small
+ *
+ *  Description:
+ *       Concatenate the slices separated by RSTn markers
+ *
+ **/
+uint32_t qomx_sw_write_scan(const qomx_sw_encoder_t *p_enc, uint8_t *p_out,
+  uint32_t size)
+{
+  uint32_t i, len = 0;
+  const qomx_sw_bitbuf_t *s;
+
+  for (i = 0; i < p_enc->num_slices; i++) {
+    s = &p_enc->slices[i];
+    if (len + s->len + 2 > size) {
+      return 0;
+    }
+    memcpy(p_out + len, s->buf, s->len);
+    len += s->len;
+    if (i + 1 < p_enc->num_slices) {
+      p_out[len++] = 0xFF;
+      p_out[len++] = (uint8_t)(0xD0 + (i & 7));
+    }
+  }
+  return len;
+}
+
+/** qomx_sw_restart_interval:
+ *
+ *  Arguments:
+ *    @p_enc: encoder
+ *    @p_img: image of the last frame
+ *
+ *  Return:
+ *       restart interval in MCUs, 0 if the frame is a single slice
+ *
+ **/
+uint32_t qomx_sw_restart_interval(const qomx_sw_encoder_t *p_enc,
+  const qomx_sw_yuv_t *p_img)
+{
+  if (p_enc->num_slices < 2) {
+    return 0;
+  }
+  return p_enc->rows_per_slice * ((p_img->width + 15) >> 4);
+}
+
+/** qomx_sw_resample:
+ *
+ *  Arguments:
+ *    @p_src: source plane
+ *    @sstride: source stride
+ *    @p_crop: source window in plane samples
+ *    @p_dst: destination plane
+ *    @dstride: destination stride
+ *    @w: width before rotation
+ *    @h: height before rotation
+ *    @rotation: clockwise rotation 0/90/180/270
+ *    @bpp: samples per pixel (1 luma, 2 interleaved chroma)
+ *
+ *  Return:
+ *       0 on success
+ *
+ *  Description:
+ *       Bilinear scale of the window to w x h followed by the
+ *       rotation, in a single pass
+ *
+ **/
+static int qomx_sw_resample(const uint8_t *p_src, uint32_t sstride,
+  const qomx_sw_rect_t *p_crop, uint8_t *p_dst, uint32_t dstride,
+  uint32_t w, uint32_t h, int rotation, uint32_t bpp)
+{
+  uint32_t *xt, *yt;
+  uint32_t ox, oy, ux, uy, ow, oh, k, i;
+  uint32_t x0, x1, y0, y1, wx, wy, top, bot;
+  int64_t f;
+  const uint8_t *r0, *r1;
+  uint8_t *d;
+
+  xt = malloc((w + h) * 2 * sizeof(uint32_t));
+  if (NULL == xt) {
+    return -1;
+  }
+  yt = xt + w * 2;
+
+  /* source position of each output column/row: index and 8 bit weight */
+  for (i = 0; i < w; i++) {
+    f = (((int64_t)(2 * i + 1) * p_crop->width << 15) / w) - 32768;
+    if (f < 0) {
+      f = 0;
+    }
+    xt[2 * i] = p_crop->left + (uint32_t)(f >> 16);
+    xt[2 * i + 1] = (uint32_t)(f >> 8) & 0xFF;
+    if (xt[2 * i] >= p_crop->left + p_crop->width - 1) {
+      xt[2 * i] = p_crop->left + p_crop->width - 1;
+      xt[2 * i + 1] = 0;
+    }
+  }
+  for (i = 0; i < h; i++) {
+    f = (((int64_t)(2 * i + 1) * p_crop->height << 15) / h) - 32768;
+    if (f < 0) {
+      f = 0;
+    }
+    yt[2 * i] = p_crop->top + (uint32_t)(f >> 16);
+    yt[2 * i + 1] = (uint32_t)(f >> 8) & 0xFF;
+    if (yt[2 * i] >= p_crop->top + p_crop->height - 1) {
+      yt[2 * i] = p_crop->top + p_crop->height - 1;
+      yt[2 * i + 1] = 0;
+    }
+  }
+
+  ow = (rotation == 90 || rotation == 270) ? h : w;
+  oh = (rotation == 90 || rotation == 270) ? w : h;
+  for (oy = 0; oy < oh; oy++) {
+    d = p_dst + oy * dstride;
+    for (ox = 0; ox < ow; ox++) {
+      switch (rotation) {
+      case 90:
+        ux = oy;
+        uy = h - 1 - ox;
+        break;
+      case 180:
+        ux = w - 1 - ox;
+        uy = h - 1 - oy;
+        break;
+      case 270:
+        ux = w - 1 - oy;
+        uy = ox;
+        break;
+      default:
+        ux = ox;
+        uy = oy;
+        break;
+      }
+      x0 = xt[2 * ux];
+      wx = xt[2 * ux + 1];
+      x1 = wx ? x0 + 1 : x0;
+      y0 = yt[2 * uy];
+      wy = yt[2 * uy + 1];
+      y1 = wy ? y0 + 1 : y0;
+      r0 = p_src + y0 * sstride;
+      r1 = p_src + y1 * sstride;
+      for (k = 0; k < bpp; k++) {
+        top = r0[x0 * bpp + k] * (256 - wx) + r0[x1 * bpp + k] * wx;
+        bot = r1[x0 * bpp + k] * (256 - wx) + r1[x1 * bpp + k] * wx;
+        *d++ = (uint8_t)((top * (256 - wy) + bot * wy + 32768) >> 16);
+      }
+    }
+  }
+  free(xt);
+  return 0;
+}
+
+/** qomx_sw_transform:
+ *
+ *  Arguments:
+ *    @p_src: source image
+ *    @p_crop: crop window in luma samples
+ *    @out_w: scaled width, before rotation
+ *    @out_h: scaled height, before rotation
+ *    @rotation: clockwise rotation 0/90/180/270
+ *    @pp_scratch: scratch buffer, grown as needed
+ *    @p_scratch_size: size of the scratch buffer
+ *    @p_dst: resulting image
+ *
+ *  Return:
+ *       0 on success, -1 on failure
+ *
+ *  Description:
+ *       Apply crop, scale and rotation. A plain even aligned crop
+ *       only adjusts the plane pointers; anything else goes
+ *       through the scratch buffer.
+ *
+ **/
+int qomx_sw_transform(const qomx_sw_yuv_t *p_src, const qomx_sw_rect_t *p_crop,
+  uint32_t out_w, uint32_t out_h, int rotation, uint8_t **pp_scratch,
+  uint32_t *p_scratch_size, qomx_sw_yuv_t *p_dst)
+{
+  qomx_sw_rect_t crop = *p_crop;
+  qomx_sw_rect_t c_crop;
+  uint32_t ow, oh, y_stride, uv_stride, size;
+  uint8_t *buf;
+
+  rotation = ((rotation % 360) + 360) % 360;
+  if (rotation % 90) {
+    ALOGE("%s:%d] unsupported rotation %d", __func__, __LINE__, rotation);
+    return -1;
+  }
+
+  if (!crop.width || !crop.height) {
+    crop.left = crop.top = 0;
+    crop.width = p_src->width;
+    crop.height = p_src->height;
+  }
+  if ((crop.left + crop.width > p_src->width) ||
+    (crop.top + crop.height > p_src->height)) {
+    ALOGE("%s:%d] invalid crop", __func__, __LINE__);
+    return -1;
+  }
+  if (!out_w || !out_h) {
+    out_w = crop.width;
+    out_h = crop.height;
+  }
+
+  if (!rotation && (out_w == crop.width) && (out_h == crop.height) &&
+    !(crop.left & 1) && !(crop.top & 1)) {
+    *p_dst = *p_src;
+    p_dst->y = p_src->y + crop.top * p_src->y_stride + crop.left;
+    p_dst->uv = p_src->uv + (crop.top >> 1) * p_src->uv_stride + crop.left;
+    p_dst->width = out_w;
+    p_dst->height = out_h;
+    return 0;
+  }
+
+  ow = (rotation == 90 || rotation == 270) ? out_h : out_w;
+  oh = (rotation == 90 || rotation == 270) ? out_w : out_h;
+  y_stride = (ow + 15) & ~15U;
+  uv_stride = y_stride;
+  size = y_stride * oh + uv_stride * ((oh + 1) >> 1);
+  if (size > *p_scratch_size) {
+    buf = realloc(*pp_scratch, size);
+    if (NULL == buf) {
+      ALOGE("%s:%d] no memory for %d bytes", __func__, __LINE__, size);
+      return -1;
+    }
+    *pp_scratch = buf;
+    *p_scratch_size = size;
+  }
+  buf = *pp_scratch;
+
+  if (qomx_sw_resample(p_src->y, p_src->y_stride, &crop, buf, y_stride,
+    out_w, out_h, rotation, 1)) {
+    return -1;
+  }
+
+  c_crop.left = crop.left >> 1;
+  c_crop.top = crop.top >> 1;
+  c_crop.width = (crop.width + (crop.left & 1) + 1) >> 1;
+  c_crop.height = (crop.height + (crop.top & 1) + 1) >> 1;
+  if (c_crop.left + c_crop.width > (p_src->width + 1) >> 1) {
+    c_crop.width = ((p_src->width + 1) >> 1) - c_crop.left;
+  }
+  if (c_crop.top + c_crop.height > (p_src->height + 1) >> 1) {
+    c_crop.height = ((p_src->height + 1) >> 1) - c_crop.top;
+  }
+  if (qomx_sw_resample(p_src->uv, p_src->uv_stride, &c_crop,
+    buf + y_stride * oh, uv_stride, (out_w + 1) >> 1, (out_h + 1) >> 1,
+    rotation, 2)) {
+    return -1;
+  }
+
+  p_dst->y = buf;
+  p_dst->uv = buf + y_stride * oh;
+  p_dst->width = ow;
+  p_dst->height = oh;
+  p_dst->y_stride = y_stride;
+  p_dst->uv_stride = uv_stride;
+  p_dst->cr_first = p_src->cr_first;
+  return 0;
+}
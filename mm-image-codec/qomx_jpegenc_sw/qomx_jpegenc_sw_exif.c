@@ -0,0 +1,440 @@
+/* Copyright (c) 2014, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#define LOG_TAG "qomx_jpegenc_sw"
+#include <utils/Log.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "qomx_jpegenc_sw.h"
+
+/* APP1 payload must fit the 16 bit segment length */
+#define QOMX_SW_APP1_MAX 65533
+#define QOMX_SW_IFD_MAX_TAGS (QOMX_SW_MAX_EXIF_TAGS + 8)
+
+#define TIFF_TAG(id) ((uint16_t)((id) & 0xFFFF))
+#define TIFF_IFD_IDX(id) ((id) >> 16)
+
+#define TAG_EXIF_IFD_PTR 0x8769
+#define TAG_GPS_IFD_PTR 0x8825
+#define TAG_COMPRESSION 0x0103
+#define TAG_X_RESOLUTION 0x011A
+#define TAG_Y_RESOLUTION 0x011B
+#define TAG_RESOLUTION_UNIT 0x0128
+#define TAG_JPEG_IF_OFFSET 0x0201
+#define TAG_JPEG_IF_LENGTH 0x0202
+
+/** qomx_sw_ifd_entry_t
+*  Entry of an IFD being written
+*  @tag: tiff tag
+*  @type: exif data type
+*  @count: number of elements
+*  @size: payload size
+*  @data: payload
+**/
+typedef struct {
+  uint16_t tag;
+  uint16_t type;
+  uint32_t count;
+  uint32_t size;
+  const uint8_t *data;
+} qomx_sw_ifd_entry_t;
+
+typedef struct {
+  qomx_sw_ifd_entry_t e[QOMX_SW_IFD_MAX_TAGS];
+  uint32_t n;
+} qomx_sw_ifd_t;
+
+/** qomx_sw_exif_type_size:
+ *
+ *  Arguments:
+ *    @type: exif data type
+ *
+ *  Return:
+ *       size of one element, 0 for an unknown type
+ *
+ **/
+static uint32_t qomx_sw_exif_type_size(uint32_t type)
+{
+  switch (type) {
+  case EXIF_BYTE:
+  case EXIF_ASCII:
+  case EXIF_UNDEFINED:
+    return 1;
+  case EXIF_SHORT:
+    return 2;
+  case EXIF_LONG:
+  case EXIF_SLONG:
+    return 4;
+  case EXIF_RATIONAL:
+  case EXIF_SRATIONAL:
+    return 8;
+  default:
+    return 0;
+  }
+}
+
+/** qomx_sw_exif_reset:
+ *
+ *  Arguments:
+ *    @p_comp: component
+ *
+ *  Return:
+ *       none
+ *
+ *  Description:
+ *       Drop the exif tags of the last job
+ *
+ **/
+void qomx_sw_exif_reset(qomx_jpegenc_sw_t *p_comp)
+{
+  uint32_t i;
+
+  for (i = 0; i < p_comp->num_exif; i++) {
+    free(p_comp->exif[i].data);
+  }
+  memset(p_comp->exif, 0, sizeof(p_comp->exif));
+  p_comp->num_exif = 0;
+}
+
+/** qomx_sw_exif_add:
+ *
+ *  Arguments:
+ *    @p_comp: component
+ *    @p_info: tags passed by the client
+ *
+ *  Return:
+ *       0 on success, -1 on failure
+ *
+ *  Description:
+ *       Copy the tags into the component. A tag set twice keeps
+ *       the last value, matching the order the client sets them.
+ *
+ **/
+int qomx_sw_exif_add(qomx_jpegenc_sw_t *p_comp, QOMX_EXIF_INFO *p_info)
+{
+  uint32_t i, j, elem, size;
+  const exif_tag_entry_t *p_entry;
+  const void *p_src;
+  qomx_sw_exif_tag_t *p_tag;
+  uint8_t *data;
+
+  for (i = 0; i < p_info->numOfEntries; i++) {
+    p_entry = &p_info->exif_data[i].tag_entry;
+    elem = qomx_sw_exif_type_size(p_entry->type);
+    if (!elem || !p_entry->count) {
+      continue;
+    }
+    size = elem * p_entry->count;
+
+    if ((p_entry->type == EXIF_ASCII) || (p_entry->type == EXIF_UNDEFINED) ||
+      (p_entry->count > 1)) {
+      p_src = p_entry->data._bytes;
+    } else {
+      p_src = &p_entry->data;
+    }
+    if (NULL == p_src) {
+      continue;
+    }
+
+    data = malloc(size);
+    if (NULL == data) {
+      ALOGE("%s:%d] no memory for tag %x", __func__, __LINE__,
+        p_info->exif_data[i].tag_id);
+      return -1;
+    }
+    memcpy(data, p_src, size);
+
+    p_tag = NULL;
+    for (j = 0; j < p_comp->num_exif; j++) {
+      if (p_comp->exif[j].id == p_info->exif_data[i].tag_id) {
+        p_tag = &p_comp->exif[j];
+        free(p_tag->data);
+        break;
+      }
+    }
+    if (NULL == p_tag) {
+      if (p_comp->num_exif >= QOMX_SW_MAX_EXIF_TAGS) {
+        ALOGE("%s:%d] too many tags", __func__, __LINE__);
+        free(data);
+        return -1;
+      }
+      p_tag = &p_comp->exif[p_comp->num_exif++];
+    }
+    p_tag->id = p_info->exif_data[i].tag_id;
+    p_tag->type = (uint16_t)p_entry->type;
+    p_tag->count = p_entry->count;
+    p_tag->size = size;
+    p_tag->data = data;
+  }
+  return 0;
+}
+
+/** qomx_sw_ifd_add:
+ *
+ *  Arguments:
+ *    @p_ifd: IFD
+ *    @tag: tiff tag
+ *    @type: exif data type
+ *    @count: number of elements
+ *    @size: payload size
+ *    @data: payload
+ *
+ *  Return:
+ *       pointer to the entry
+ *
+ *  Description:
+ *       Insert an entry keeping the IFD sorted by tag
+ *
+ **/
+static qomx_sw_ifd_entry_t *qomx_sw_ifd_add(qomx_sw_ifd_t *p_ifd,
+  uint16_t tag, uint16_t type, uint32_t count, uint32_t size,
+  const uint8_t *data)
+{
+  uint32_t i = p_ifd->n;
+
+  while ((i > 0) && (p_ifd->e[i - 1].tag > tag)) {
+    p_ifd->e[i] = p_ifd->e[i - 1];
+    i--;
+  }
+  p_ifd->e[i].tag = tag;
+  p_ifd->e[i].type = type;
+  p_ifd->e[i].count = count;
+  p_ifd->e[i].size = size;
+  p_ifd->e[i].data = data;
+  p_ifd->n++;
+  return &p_ifd->e[i];
+}
+
+/** qomx_sw_ifd_size:
+ *
+ *  Arguments:
+ *    @p_ifd: IFD
+ *
+ *  Return:
+ *       bytes taken by the IFD and its out of line values
+ *
+ **/
+static uint32_t qomx_sw_ifd_size(const qomx_sw_ifd_t *p_ifd)
+{
+  uint32_t i, size = 2 + 12 * p_ifd->n + 4;
+
+  for (i = 0; i < p_ifd->n; i++) {
+    if (p_ifd->e[i].size > 4) {
+      size += (p_ifd->e[i].size + 1) & ~1U;
+    }
+  }
+  return size;
+}
+
+static inline void qomx_sw_le16(uint8_t *p, uint32_t v)
+{
+  p[0] = (uint8_t)v;
+  p[1] = (uint8_t)(v >> 8);
+}
+
+static inline void qomx_sw_le32(uint8_t *p, uint32_t v)
+{
+  p[0] = (uint8_t)v;
+  p[1] = (uint8_t)(v >> 8);
+  p[2] = (uint8_t)(v >> 16);
+  p[3] = (uint8_t)(v >> 24);
+}
+
+/** qomx_sw_ifd_write:
+ *
+ *  Arguments:
+ *    @p_tiff: start of the TIFF header
+ *    @off: offset of the IFD from @p_tiff
+ *    @p_ifd: IFD
+ *    @next: offset of the next IFD, 0 for none
+ *
+ *  Return:
+ *       none
+ *
+ *  Description:
+ *       Write the IFD followed by its out of line values
+ *
+ **/
+static void qomx_sw_ifd_write(uint8_t *p_tiff, uint32_t off,
+  const qomx_sw_ifd_t *p_ifd, uint32_t next)
+{
+  uint8_t *p = p_tiff + off;
+  uint32_t data_off = off + 2 + 12 * p_ifd->n + 4;
+  const qomx_sw_ifd_entry_t *e;
+  uint32_t i;
+
+  qomx_sw_le16(p, p_ifd->n);
+  p += 2;
+  for (i = 0; i < p_ifd->n; i++, p += 12) {
+    e = &p_ifd->e[i];
+    qomx_sw_le16(p, e->tag);
+    qomx_sw_le16(p + 2, e->type);
+    qomx_sw_le32(p + 4, e->count);
+    if (e->size <= 4) {
+      memset(p + 8, 0, 4);
+      memcpy(p + 8, e->data, e->size);
+    } else {
+      qomx_sw_le32(p + 8, data_off);
+      memcpy(p_tiff + data_off, e->data, e->size);
+      if (e->size & 1) {
+        p_tiff[data_off + e->size] = 0;
+      }
+      data_off += (e->size + 1) & ~1U;
+    }
+  }
+  qomx_sw_le32(p, next);
+}
+
+/** qomx_sw_exif_write:
+ *
+ *  Arguments:
+ *    @p_comp: component
+ *    @p_out: output, positioned after SOI
+ *    @size: output space
+ *    @p_thumb: thumbnail JPEG, NULL for none
+ *    @thumb_len: thumbnail length
+ *
+ *  Return:
+ *       number of bytes written, 0 if the segment does not fit
+ *
+ *  Description:
+ *       Write the APP1 segment: IFD0, Exif IFD, GPS IFD and, with
+ *       a thumbnail, IFD1 followed by the thumbnail JPEG
+ *
+ **/
+uint32_t qomx_sw_exif_write(qomx_jpegenc_sw_t *p_comp, uint8_t *p_out,
+  uint32_t size, const uint8_t *p_thumb, uint32_t thumb_len)
+{
+  qomx_sw_ifd_t ifd[4];
+  qomx_sw_ifd_t *ifd0 = &ifd[0], *exif = &ifd[1], *gps = &ifd[2];
+  qomx_sw_ifd_t *ifd1 = &ifd[3];
+  qomx_sw_ifd_entry_t *exif_ptr = NULL, *gps_ptr = NULL, *tmb_ptr = NULL;
+  uint8_t exif_off[4], gps_off[4], tmb_off[4], tmb_len[4];
+  uint8_t compression[2], res_unit[2], res[8];
+  uint32_t i, idx, off0, off_exif, off_gps, off1, off_tmb, tiff_size;
+  uint8_t *p_tiff;
+  const qomx_sw_exif_tag_t *t;
+
+  memset(ifd, 0, sizeof(ifd));
+
+  for (i = 0; i < p_comp->num_exif; i++) {
+    t = &p_comp->exif[i];
+    idx = TIFF_IFD_IDX(t->id);
+    if (idx <= GPS_DIFFERENTIAL) {
+      qomx_sw_ifd_add(gps, TIFF_TAG(t->id), t->type, t->count, t->size,
+        t->data);
+    } else if ((idx >= NEW_SUBFILE_TYPE) && (idx <= GPS_IFD)) {
+      if ((idx == EXIF_IFD) || (idx == GPS_IFD) ||
+        (idx == JPEG_INTERCHANGE_FORMAT) ||
+        (idx == JPEG_INTERCHANGE_FORMAT_LENGTH)) {
+        continue;
+      }
+      qomx_sw_ifd_add(ifd0, TIFF_TAG(t->id), t->type, t->count, t->size,
+        t->data);
+    } else if ((idx >= EXPOSURE_TIME) && (idx < EXIF_TAG_MAX_OFFSET)) {
+      if (idx == INTEROP) {
+        continue;
+      }
+      qomx_sw_ifd_add(exif, TIFF_TAG(t->id), t->type, t->count, t->size,
+        t->data);
+    }
+    /* thumbnail IFD tags are generated below */
+  }
+
+  if (exif->n) {
+    exif_ptr = qomx_sw_ifd_add(ifd0, TAG_EXIF_IFD_PTR, EXIF_LONG, 1, 4,
+      exif_off);
+  }
+  if (gps->n) {
+    gps_ptr = qomx_sw_ifd_add(ifd0, TAG_GPS_IFD_PTR, EXIF_LONG, 1, 4,
+      gps_off);
+  }
+  if (p_thumb && thumb_len) {
+    qomx_sw_le16(compression, 6);
+    qomx_sw_le16(res_unit, 2);
+    qomx_sw_le32(res, 72);
+    qomx_sw_le32(res + 4, 1);
+    qomx_sw_ifd_add(ifd1, TAG_COMPRESSION, EXIF_SHORT, 1, 2, compression);
+    qomx_sw_ifd_add(ifd1, TAG_X_RESOLUTION, EXIF_RATIONAL, 1, 8, res);
+    qomx_sw_ifd_add(ifd1, TAG_Y_RESOLUTION, EXIF_RATIONAL, 1, 8, res);
+    qomx_sw_ifd_add(ifd1, TAG_RESOLUTION_UNIT, EXIF_SHORT, 1, 2, res_unit);
+    tmb_ptr = qomx_sw_ifd_add(ifd1, TAG_JPEG_IF_OFFSET, EXIF_LONG, 1, 4,
+      tmb_off);
+    qomx_sw_ifd_add(ifd1, TAG_JPEG_IF_LENGTH, EXIF_LONG, 1, 4, tmb_len);
+  }
+
+  /* layout: header, IFD0, Exif IFD, GPS IFD, IFD1, thumbnail */
+  off0 = 8;
+  off_exif = off0 + qomx_sw_ifd_size(ifd0);
+  off_gps = off_exif + (exif->n ? qomx_sw_ifd_size(exif) : 0);
+  off1 = off_gps + (gps->n ? qomx_sw_ifd_size(gps) : 0);
+  off_tmb = off1 + (tmb_ptr ? qomx_sw_ifd_size(ifd1) : 0);
+  tiff_size = off_tmb + (tmb_ptr ? thumb_len : 0);
+
+  if ((6 + tiff_size > QOMX_SW_APP1_MAX) || (4 + 6 + tiff_size > size)) {
+    return 0;
+  }
+
+  if (exif_ptr) {
+    qomx_sw_le32(exif_off, off_exif);
+  }
+  if (gps_ptr) {
+    qomx_sw_le32(gps_off, off_gps);
+  }
+  if (tmb_ptr) {
+    qomx_sw_le32(tmb_off, off_tmb);
+    qomx_sw_le32(tmb_len, thumb_len);
+  }
+
+  p_out[0] = 0xFF;
+  p_out[1] = 0xE1;
+  p_out[2] = (uint8_t)((2 + 6 + tiff_size) >> 8);
+  p_out[3] = (uint8_t)(2 + 6 + tiff_size);
+  memcpy(p_out + 4, "Exif\0\0", 6);
+  p_tiff = p_out + 10;
+  p_tiff[0] = 'I';
+  p_tiff[1] = 'I';
+  qomx_sw_le16(p_tiff + 2, 0x2A);
+  qomx_sw_le32(p_tiff + 4, off0);
+
+  qomx_sw_ifd_write(p_tiff, off0, ifd0, tmb_ptr ? off1 : 0);
+  if (exif->n) {
+    qomx_sw_ifd_write(p_tiff, off_exif, exif, 0);
+  }
+  if (gps->n) {
+    qomx_sw_ifd_write(p_tiff, off_gps, gps, 0);
+  }
+  if (tmb_ptr) {
+    qomx_sw_ifd_write(p_tiff, off1, ifd1, 0);
+    memcpy(p_tiff + off_tmb, p_thumb, thumb_len);
+  }
+
+  return 4 + 6 + tiff_size;
+}
@@ -0,0 +1,28 @@
+QYUVSCALE_PATH := $(call my-dir)
+
+# ------------------------------------------------------------------------------
+#                Make the shared library (libqyuvscale)
+# ------------------------------------------------------------------------------
+
+include $(CLEAR_VARS)
+LOCAL_PATH := $(QYUVSCALE_PATH)
+LOCAL_MODULE_TAGS := optional
+
+qyuvscale_defines:= -Wall -Wextra -Werror -Wno-unused-parameter \
+                    -O2
+
+ifeq ($(TARGET_ARCH),arm)
+LOCAL_ARM_MODE := arm
+LOCAL_ARM_NEON := true
+endif
+
+LOCAL_CFLAGS := $(qyuvscale_defines)
+
+LOCAL_SRC_FILES := qyuvscale.c
+
+LOCAL_MODULE           := libqyuvscale
+LOCAL_PRELINK_MODULE   := false
+
+include $(BUILD_SHARED_LIBRARY)
+
+include $(QYUVSCALE_PATH)/test/Android.mk
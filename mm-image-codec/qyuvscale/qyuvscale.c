@@ -0,0 +1,693 @@
+/* Copyright (c) 2014, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+#include <arm_neon.h>
+#define QYUV_NEON 1
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define QYUV_SSE2 1
+#endif
+
+#include "qyuvscale.h"
+
+/* Both filters are separable. Each output row is produced by a
+ * vertical pass over the crop width into a 16 bit accumulator row,
+ * which is the part done with SIMD, followed by a horizontal pass
+ * over the accumulator. The vertical pass is exact, so the SIMD and
+ * the C code produce the same result. */
+
+/* box height summed into the 16 bit accumulator at most */
+#define QYUV_MAX_BOX_ROWS 256
+
+/* luma rows a slice gets at least */
+#define QYUV_MIN_SLICE_ROWS 16
+
+/* precision of the box filter reciprocals */
+#define QYUV_RECIP_BITS 24
+
+/** qyuv_plane_t
+*  Scaling job for one plane
+*  @src: source plane
+*  @sstride: source stride
+*  @dst: destination plane
+*  @dstride: destination stride
+*  @bpp: bytes per sample (1 luma, 2 interleaved chroma)
+*  @crop: source window in plane samples
+*  @w: scaled width before rotation
+*  @h: scaled height before rotation
+*  @rotation: clockwise rotation 0/90/180/270
+*  @box: box filter, bilinear otherwise
+*  @xt: column table, relative to the crop
+*  @yt: row table, relative to the crop
+**/
+typedef struct {
+  const uint8_t *src;
+  uint32_t sstride;
+  uint8_t *dst;
+  uint32_t dstride;
+  uint32_t bpp;
+  qyuv_rect_t crop;
+  uint32_t w;
+  uint32_t h;
+  int rotation;
+  int box;
+  uint32_t *xt;
+  uint32_t *yt;
+} qyuv_plane_t;
+
+/** qyuv_slice_t
+*  Band of output rows handled by one thread
+*  @planes: luma and chroma jobs
+*  @first: first scaled row per plane
+*  @last: end of the scaled rows per plane
+*  @acc: accumulator row
+*  @row: scaled row before rotation
+*  @thread: thread running the slice
+*  @started: the slice runs on its own thread
+**/
+typedef struct {
+  const qyuv_plane_t *planes;
+  uint32_t first[2];
+  uint32_t last[2];
+  uint16_t *acc;
+  uint8_t *row;
+  pthread_t thread;
+  int started;
+} qyuv_slice_t;
+
+/** qyuv_acc_set:
+ *
+ *  Arguments:
+ *    @acc: accumulator row
+ *    @s: source row
+ *    @n: number of samples
+ *
+ *  Return:
+ *       none
+ *
+ *  Description:
+ *       Widen a source row into the accumulator
+ *
+ **/
+static void qyuv_acc_set(uint16_t *acc, const uint8_t *s, uint32_t n)
+{
+  uint32_t i = 0;
+
+#if QYUV_NEON
+  for (; i + 16 <= n; i += 16) {
+    uint8x16_t v = vld1q_u8(s + i);
+    vst1q_u16(acc + i, vmovl_u8(vget_low_u8(v)));
+    vst1q_u16(acc + i + 8, vmovl_u8(vget_high_u8(v)));
+  }
+#elif QYUV_SSE2
+  const __m128i zero = _mm_setzero_si128();
+  for (; i + 16 <= n; i += 16) {
+    __m128i v = _mm_loadu_si128((const __m128i *)(s + i));
+    _mm_storeu_si128((__m128i *)(acc + i), _mm_unpacklo_epi8(v, zero));
+    _mm_storeu_si128((__m128i *)(acc + i + 8), _mm_unpackhi_epi8(v, zero));
+  }
+#endif
+  for (; i < n; i++) {
+    acc[i] = s[i];
+  }
+}
+
+/** qyuv_acc_add:
+ *
+ *  Arguments:
+ *    @acc: accumulator row
+ *    @s: source row
+ *    @n: number of samples
+ *
+ *  Return:
+ *       none
+ *
+ *  Description:
+ *       Add a source row to the accumulator
+ *
+ **/
+static void qyuv_acc_add(uint16_t *acc, const uint8_t *s, uint32_t n)
+{
+  uint32_t i = 0;
+
+#if QYUV_NEON
+  for (; i + 16 <= n; i += 16) {
+    uint8x16_t v = vld1q_u8(s + i);
+    vst1q_u16(acc + i, vaddw_u8(vld1q_u16(acc + i), vget_low_u8(v)));
+    vst1q_u16(acc + i + 8, vaddw_u8(vld1q_u16(acc + i + 8),
+      vget_high_u8(v)));
+  }
+#elif QYUV_SSE2
+  const __m128i zero = _mm_setzero_si128();
+  for (; i + 16 <= n; i += 16) {
+    __m128i v = _mm_loadu_si128((const __m128i *)(s + i));
+    __m128i lo = _mm_loadu_si128((const __m128i *)(acc + i));
+    __m128i hi = _mm_loadu_si128((const __m128i *)(acc + i + 8));
+    _mm_storeu_si128((__m128i *)(acc + i),
+      _mm_add_epi16(lo, _mm_unpacklo_epi8(v, zero)));
+    _mm_storeu_si128((__m128i *)(acc + i + 8),
+      _mm_add_epi16(hi, _mm_unpackhi_epi8(v, zero)));
+  }
+#endif
+  for (; i < n; i++) {
+    acc[i] = (uint16_t)(acc[i] + s[i]);
+  }
+}
+
+/** qyuv_acc_blend:
+ *
+ *  Arguments:
+ *    @acc: accumulator row
+ *    @a: upper source row
+ *    @b: lower source row
+ *    @wt: weight of the lower row, 1..255
+ *    @n: number of samples
+ *
+ *  Return:
+ *       none
+ *
+ *  Description:
+ *       acc = a * (256 - wt) + b * wt, at most 255 * 256
+ *
+ **/
+static void qyuv_acc_blend(uint16_t *acc, const uint8_t *a, const uint8_t *b,
+  uint32_t wt, uint32_t n)
+{
+  uint32_t i = 0;
+
+#if QYUV_NEON
+  uint8x8_t wa = vdup_n_u8((uint8_t)(256 - wt));
+  uint8x8_t wb = vdup_n_u8((uint8_t)wt);
+  for (; i + 16 <= n; i += 16) {
+    uint8x16_t va = vld1q_u8(a + i);
+    uint8x16_t vb = vld1q_u8(b + i);
+    vst1q_u16(acc + i, vmlal_u8(vmull_u8(vget_low_u8(va), wa),
+      vget_low_u8(vb), wb));
+    vst1q_u16(acc + i + 8, vmlal_u8(vmull_u8(vget_high_u8(va), wa),
+      vget_high_u8(vb), wb));
+  }
+#elif QYUV_SSE2
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i wa = _mm_set1_epi16((short)(256 - wt));
+  const __m128i wb = _mm_set1_epi16((short)wt);
+  for (; i + 16 <= n; i += 16) {
+    __m128i va = _mm_loadu_si128((const __m128i *)(a + i));
+    __m128i vb = _mm_loadu_si128((const __m128i *)(b + i));
+    _mm_storeu_si128((__m128i *)(acc + i), _mm_add_epi16(
+      _mm_mullo_epi16(_mm_unpacklo_epi8(va, zero), wa),
+      _mm_mullo_epi16(_mm_unpacklo_epi8(vb, zero), wb)));
+    _mm_storeu_si128((__m128i *)(acc + i + 8), _mm_add_epi16(
+      _mm_mullo_epi16(_mm_unpackhi_epi8(va, zero), wa),
+      _mm_mullo_epi16(_mm_unpackhi_epi8(vb, zero), wb)));
+  }
+#endif
+  for (; i < n; i++) {
+    acc[i] = (uint16_t)(a[i] * (256 - wt) + b[i] * wt);
+  }
+}
+
+/** qyuv_box_row:
+ *
+ *  Arguments:
+ *    @p: plane job
+ *    @r: scaled row
+ *    @acc: accumulator row
+ *    @out: scaled row
+ *
+ *  Return:
+ *       none
+ *
+ *  Description:
+ *       Average of the source samples covered by each output
+ *       sample. Box heights above QYUV_MAX_BOX_ROWS are
+ *       subsampled to keep the accumulator in 16 bit.
+ *
+ **/
+static void qyuv_box_row(const qyuv_plane_t *p, uint32_t r, uint16_t *acc,
+  uint8_t *out)
+{
+  uint32_t bpp = p->bpp;
+  uint32_t y0 = p->crop.top + p->yt[r];
+  uint32_t y1 = p->crop.top + p->yt[r + 1];
+  uint32_t step = (y1 - y0 + QYUV_MAX_BOX_ROWS - 1) / QYUV_MAX_BOX_ROWS;
+  uint32_t len = p->crop.width * bpp;
+  uint32_t hmin = p->crop.width / p->w;
+  const uint8_t *s = p->src + p->crop.left * bpp;
+  uint32_t rows = 1, x, i, y, area;
+  uint64_t inv[2], m, sum0, sum1, v;
+
+  qyuv_acc_set(acc, s + (size_t)y0 * p->sstride, len);
+  for (y = y0 + step; y < y1; y += step) {
+    qyuv_acc_add(acc, s + (size_t)y * p->sstride, len);
+    rows++;
+  }
+
+  /* box widths are hmin or hmin + 1 */
+  for (i = 0; i < 2; i++) {
+    area = (hmin + i) * rows;
+    inv[i] = area ? (((uint64_t)1 << QYUV_RECIP_BITS) + area / 2) / area : 0;
+  }
+
+  for (x = 0; x < p->w; x++) {
+    uint32_t x0 = p->xt[x];
+    uint32_t x1 = p->xt[x + 1];
+    m = inv[x1 - x0 - hmin];
+    if (1 == bpp) {
+      sum0 = 0;
+      for (i = x0; i < x1; i++) {
+        sum0 += acc[i];
+      }
+      v = (sum0 * m + ((uint64_t)1 << (QYUV_RECIP_BITS - 1))) >>
+        QYUV_RECIP_BITS;
+      out[x] = (uint8_t)(v > 255 ? 255 : v);
+    } else {
+      sum0 = sum1 = 0;
+      for (i = x0; i < x1; i++) {
+        sum0 += acc[2 * i];
+        sum1 += acc[2 * i + 1];
+      }
+      v = (sum0 * m + ((uint64_t)1 << (QYUV_RECIP_BITS - 1))) >>
+        QYUV_RECIP_BITS;
+      out[2 * x] = (uint8_t)(v > 255 ? 255 : v);
+      v = (sum1 * m + ((uint64_t)1 << (QYUV_RECIP_BITS - 1))) >>
+        QYUV_RECIP_BITS;
+      out[2 * x + 1] = (uint8_t)(v > 255 ? 255 : v);
+    }
+  }
+}
+
+/** qyuv_bilinear_row:
+ *
+ *  Arguments:
+ *    @p: plane job
+ *    @r: scaled row
+ *    @acc: accumulator row
+ *    @out: scaled row
+ *
+ *  Return:
+ *       none
+ *
+ *  Description:
+ *       Bilinear interpolation with 8 bit weights, rounded once
+ *
+ **/
+static void qyuv_bilinear_row(const qyuv_plane_t *p, uint32_t r,
+  uint16_t *acc, uint8_t *out)
+{
+  uint32_t bpp = p->bpp;
+  uint32_t wy = p->yt[2 * r + 1];
+  uint32_t len = p->crop.width * bpp;
+  const uint8_t *a = p->src + (size_t)(p->crop.top + p->yt[2 * r]) *
+    p->sstride + p->crop.left * bpp;
+  uint32_t x, k;
+
+  if (wy) {
+    qyuv_acc_blend(acc, a, a + p->sstride, wy, len);
+  } else {
+    /* a * 128 + a * 128 */
+    qyuv_acc_blend(acc, a, a, 128, len);
+  }
+
+  for (x = 0; x < p->w; x++) {
+    uint32_t x0 = p->xt[2 * x] * bpp;
+    uint32_t wx = p->xt[2 * x + 1];
+    uint32_t x1 = wx ? x0 + bpp : x0;
+    for (k = 0; k < bpp; k++) {
+      out[x * bpp + k] = (uint8_t)((acc[x0 + k] * (256 - wx) +
+        acc[x1 + k] * wx + 32768) >> 16);
+    }
+  }
+}
+
+/** qyuv_put_row:
+ *
+ *  Arguments:
+ *    @p: plane job
+ *    @r: scaled row
+ *    @row: scaled samples
+ *
+ *  Return:
+ *       none
+ *
+ *  Description:
+ *       Store a scaled row at its rotated position
+ *
+ **/
+static void qyuv_put_row(const qyuv_plane_t *p, uint32_t r,
+  const uint8_t *row)
+{
+  uint32_t bpp = p->bpp;
+  uint32_t x;
+  ptrdiff_t dx;
+  uint8_t *d;
+
+  switch (p->rotation) {
+  case 90:
+    /* row r becomes column h - 1 - r, top down */
+    d = p->dst + (p->h - 1 - r) * bpp;
+    dx = (ptrdiff_t)p->dstride;
+    break;
+  case 180:
+    /* row r becomes row h - 1 - r, right to left */
+    d = p->dst + (size_t)(p->h - 1 - r) * p->dstride + (p->w - 1) * bpp;
+    dx = -(ptrdiff_t)bpp;
+    break;
+  case 270:
+    /* row r becomes column r, bottom up */
+    d = p->dst + (size_t)(p->w - 1) * p->dstride + r * bpp;
+    dx = -(ptrdiff_t)p->dstride;
+    break;
+  default:
+    memcpy(p->dst + (size_t)r * p->dstride, row, p->w * bpp);
+    return;
+  }
+
+  if (1 == bpp) {
+    for (x = 0; x < p->w; x++, d += dx) {
+      d[0] = row[x];
+    }
+  } else {
+    for (x = 0; x < p->w; x++, d += dx) {
+      d[0] = row[2 * x];
+      d[1] = row[2 * x + 1];
+    }
+  }
+}
+
+/** qyuv_slice_run:
+ *
+ *  Arguments:
+ *    @data: slice
+ *
+ *  Return:
+ *       NULL
+ *
+ *  Description:
+ *       Scale and store the rows of a slice in both planes
+ *
+ **/
+static void *qyuv_slice_run(void *data)
+{
+  qyuv_slice_t *p_slice = (qyuv_slice_t *)data;
+  const qyuv_plane_t *p;
+  uint32_t i, r;
+
+  for (i = 0; i < 2; i++) {
+    p = &p_slice->planes[i];
+    for (r = p_slice->first[i]; r < p_slice->last[i]; r++) {
+      if (p->box) {
+        qyuv_box_row(p, r, p_slice->acc, p_slice->row);
+      } else {
+        qyuv_bilinear_row(p, r, p_slice->acc, p_slice->row);
+      }
+      qyuv_put_row(p, r, p_slice->row);
+    }
+  }
+  return NULL;
+}
+
+/** qyuv_plane_init:
+ *
+ *  Arguments:
+ *    @p: plane job, geometry already set
+ *
+ *  Return:
+ *       0 on success, -1 on no memory
+ *
+ *  Description:
+ *       Build the column and row tables. The box tables hold the
+ *       w + 1 / h + 1 window bounds, the bilinear tables a pair of
+ *       sample index and 8 bit weight per output sample, sampling
+ *       at the pixel centers.
+ *
+ **/
+static int qyuv_plane_init(qyuv_plane_t *p)
+{
+  uint32_t i, n, len, *t;
+  int64_t f;
+  int axis;
+
+  if (p->box) {
+    p->xt = (uint32_t *)malloc((p->w + p->h + 2) * sizeof(uint32_t));
+    if (NULL == p->xt) {
+      return -1;
+    }
+    p->yt = p->xt + p->w + 1;
+    for (i = 0; i <= p->w; i++) {
+      p->xt[i] = (uint32_t)(((uint64_t)i * p->crop.width) / p->w);
+    }
+    for (i = 0; i <= p->h; i++) {
+      p->yt[i] = (uint32_t)(((uint64_t)i * p->crop.height) / p->h);
+    }
+    return 0;
+  }
+
+  p->xt = (uint32_t *)malloc((p->w + p->h) * 2 * sizeof(uint32_t));
+  if (NULL == p->xt) {
+    return -1;
+  }
+  p->yt = p->xt + p->w * 2;
+  for (axis = 0; axis < 2; axis++) {
+    t = axis ? p->yt : p->xt;
+    n = axis ? p->h : p->w;
+    len = axis ? p->crop.height : p->crop.width;
+    for (i = 0; i < n; i++) {
+      f = (((int64_t)(2 * i + 1) * len << 15) / n) - 32768;
+      if (f < 0) {
+        f = 0;
+      }
+      t[2 * i] = (uint32_t)(f >> 16);
+      t[2 * i + 1] = (uint32_t)(f >> 8) & 0xFF;
+      if (t[2 * i] >= len - 1) {
+        t[2 * i] = len - 1;
+        t[2 * i + 1] = 0;
+      }
+    }
+  }
+  return 0;
+}
+
+/** qyuv_num_threads:
+ *
+ *  Arguments:
+ *    @requested: requested thread count, 0 for default
+ *    @rows: scaled luma rows
+ *
+ *  Return:
+ *       number of slices to use
+ *
+ **/
+static uint32_t qyuv_num_threads(uint32_t requested, uint32_t rows)
+{
+  uint32_t n = requested;
+
+  if (!n) {
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    n = (cpus > 0) ? (uint32_t)cpus : 1;
+  }
+  if (n > QYUV_MAX_THREADS) {
+    n = QYUV_MAX_THREADS;
+  }
+  if (n > rows / QYUV_MIN_SLICE_ROWS) {
+    n = rows / QYUV_MIN_SLICE_ROWS;
+  }
+  return n ? n : 1;
+}
+
+/** qyuv_scale:
+ *
+ *  Arguments:
+ *    @p_src: source image
+ *    @p_crop: source window, NULL or empty for the whole image
+ *    @p_dst: destination image, dimensions after rotation
+ *    @rotation: clockwise rotation 0/90/180/270
+ *    @filter: scaling filter
+ *    @num_threads: number of threads including the caller
+ *
+ *  Return:
+ *       0 on success, -1 on failure
+ *
+ *  Description:
+ *       Validate the request, set up both planes and run the
+ *       slices
+ *
+ **/
+int qyuv_scale(const qyuv_image_t *p_src, const qyuv_rect_t *p_crop,
+  const qyuv_image_t *p_dst, int rotation, qyuv_filter_t filter,
+  uint32_t num_threads)
+{
+  qyuv_plane_t planes[2];
+  qyuv_slice_t *slices;
+  qyuv_rect_t crop;
+  uint32_t w, h, n, i, acc_len, row_len, cw, ch;
+  int box, rc = 0;
+
+  if ((NULL == p_src) || (NULL == p_dst) || (NULL == p_src->y) ||
+    (NULL == p_src->uv) || (NULL == p_dst->y) || (NULL == p_dst->uv) ||
+    (p_src->y_stride < p_src->width) ||
+    (p_src->uv_stride < ((p_src->width + 1) & ~1U)) ||
+    !p_dst->width || !p_dst->height ||
+    (p_dst->y_stride < p_dst->width) ||
+    (p_dst->uv_stride < ((p_dst->width + 1) & ~1U))) {
+    return -1;
+  }
+
+  rotation = ((rotation % 360) + 360) % 360;
+  if (rotation % 90) {
+    return -1;
+  }
+
+  if ((NULL == p_crop) || !p_crop->width || !p_crop->height) {
+    crop.left = crop.top = 0;
+    crop.width = p_src->width;
+    crop.height = p_src->height;
+  } else {
+    crop = *p_crop;
+  }
+  if (!crop.width || !crop.height ||
+    (crop.left + crop.width > p_src->width) ||
+    (crop.top + crop.height > p_src->height)) {
+    return -1;
+  }
+
+  if ((90 == rotation) || (270 == rotation)) {
+    w = p_dst->height;
+    h = p_dst->width;
+  } else {
+    w = p_dst->width;
+    h = p_dst->height;
+  }
+
+  box = (QYUV_FILTER_BILINEAR != filter) &&
+    (crop.width >= w) && (crop.height >= h);
+  if (box && (QYUV_FILTER_AUTO == filter)) {
+    box = (crop.width >= 2 * w) && (crop.height >= 2 * h);
+  }
+
+  memset(planes, 0, sizeof(planes));
+  planes[0].src = p_src->y;
+  planes[0].sstride = p_src->y_stride;
+  planes[0].dst = p_dst->y;
+  planes[0].dstride = p_dst->y_stride;
+  planes[0].bpp = 1;
+  planes[0].crop = crop;
+  planes[0].w = w;
+  planes[0].h = h;
+
+  /* chroma window covering the luma window */
+  cw = (p_src->width + 1) >> 1;
+  ch = (p_src->height + 1) >> 1;
+  planes[1].src = p_src->uv;
+  planes[1].sstride = p_src->uv_stride;
+  planes[1].dst = p_dst->uv;
+  planes[1].dstride = p_dst->uv_stride;
+  planes[1].bpp = 2;
+  planes[1].crop.left = crop.left >> 1;
+  planes[1].crop.top = crop.top >> 1;
+  planes[1].crop.width = (crop.width + (crop.left & 1) + 1) >> 1;
+  planes[1].crop.height = (crop.height + (crop.top & 1) + 1) >> 1;
+  if (planes[1].crop.left + planes[1].crop.width > cw) {
+    planes[1].crop.width = cw - planes[1].crop.left;
+  }
+  if (planes[1].crop.top + planes[1].crop.height > ch) {
+    planes[1].crop.height = ch - planes[1].crop.top;
+  }
+  planes[1].w = (w + 1) >> 1;
+  planes[1].h = (h + 1) >> 1;
+
+  for (i = 0; i < 2; i++) {
+    planes[i].rotation = rotation;
+    planes[i].box = box;
+    if (qyuv_plane_init(&planes[i])) {
+      rc = -1;
+      goto done;
+    }
+  }
+
+  n = qyuv_num_threads(num_threads, h);
+  acc_len = planes[0].crop.width;
+  if (acc_len < planes[1].crop.width * 2) {
+    acc_len = planes[1].crop.width * 2;
+  }
+  row_len = planes[1].w * 2;
+  if (row_len < w) {
+    row_len = w;
+  }
+  /* keeps the next accumulator aligned */
+  row_len = (row_len + 15) & ~15U;
+
+  slices = (qyuv_slice_t *)calloc(n, sizeof(qyuv_slice_t) +
+    acc_len * sizeof(uint16_t) + row_len);
+  if (NULL == slices) {
+    rc = -1;
+    goto done;
+  }
+
+  /* luma bands start on even rows, the chroma band follows */
+  for (i = 0; i < n; i++) {
+    qyuv_slice_t *p_slice = &slices[i];
+    p_slice->planes = planes;
+    p_slice->first[0] = (uint32_t)(((uint64_t)i * h / n) & ~1ULL);
+    p_slice->last[0] = (i == n - 1) ? h :
+      (uint32_t)(((uint64_t)(i + 1) * h / n) & ~1ULL);
+    p_slice->first[1] = p_slice->first[0] >> 1;
+    p_slice->last[1] = (i == n - 1) ? planes[1].h : p_slice->last[0] >> 1;
+    p_slice->acc = (uint16_t *)((uint8_t *)(slices + n) +
+      i * (acc_len * sizeof(uint16_t) + row_len));
+    p_slice->row = (uint8_t *)(p_slice->acc + acc_len);
+  }
+
+  for (i = 1; i < n; i++) {
+    slices[i].started = !pthread_create(&slices[i].thread, NULL,
+      qyuv_slice_run, &slices[i]);
+    if (!slices[i].started) {
+      qyuv_slice_run(&slices[i]);
+    }
+  }
+  qyuv_slice_run(&slices[0]);
+  for (i = 1; i < n; i++) {
+    if (slices[i].started) {
+      pthread_join(slices[i].thread, NULL);
+    }
+  }
+  free(slices);
+
+done:
+  for (i = 0; i < 2; i++) {
+    free(planes[i].xt);
+  }
+  return rc;
+}
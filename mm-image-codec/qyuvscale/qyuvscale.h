@@ -0,0 +1,111 @@
+/* Copyright (c) 2014, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef QYUVSCALE_H
+#define QYUVSCALE_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define QYUV_MAX_THREADS 4
+
+/** qyuv_image_t
+*  View of a 4:2:0 pseudo planar image (NV12 or NV21, the
+*  chroma order is carried through unchanged)
+*  @y: luma plane
+*  @uv: interleaved chroma plane
+*  @width: image width in pixels
+*  @height: image height in pixels
+*  @y_stride: luma stride in bytes
+*  @uv_stride: chroma stride in bytes
+**/
+typedef struct {
+  uint8_t *y;
+  uint8_t *uv;
+  uint32_t width;
+  uint32_t height;
+  uint32_t y_stride;
+  uint32_t uv_stride;
+} qyuv_image_t;
+
+/** qyuv_rect_t
+*  Crop rectangle in luma coordinates
+**/
+typedef struct {
+  uint32_t left;
+  uint32_t top;
+  uint32_t width;
+  uint32_t height;
+} qyuv_rect_t;
+
+/** qyuv_filter_t
+*  QYUV_FILTER_AUTO: box when shrinking by 2 or more in both
+*    directions, bilinear otherwise
+*  QYUV_FILTER_BOX: area average whenever the image does not grow
+*  QYUV_FILTER_BILINEAR: always bilinear
+**/
+typedef enum {
+  QYUV_FILTER_AUTO,
+  QYUV_FILTER_BOX,
+  QYUV_FILTER_BILINEAR,
+} qyuv_filter_t;
+
+/** qyuv_scale:
+ *
+ *  Arguments:
+ *    @p_src: source image
+ *    @p_crop: source window, NULL or empty for the whole image
+ *    @p_dst: destination image, dimensions after rotation
+ *    @rotation: clockwise rotation 0/90/180/270
+ *    @filter: scaling filter
+ *    @num_threads: number of threads including the caller, 0 for
+ *                  one per CPU up to QYUV_MAX_THREADS
+ *
+ *  Return:
+ *       0 on success, -1 on invalid arguments or no memory
+ *
+ *  Description:
+ *       Scale the source window to the destination size and
+ *       rotate it. The output rows are split in horizontal slices
+ *       processed in parallel. The result does not depend on the
+ *       number of threads or on the SIMD flavour in use.
+ *
+ **/
+int qyuv_scale(const qyuv_image_t *p_src, const qyuv_rect_t *p_crop,
+  const qyuv_image_t *p_dst, int rotation, qyuv_filter_t filter,
+  uint32_t num_threads);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* QYUVSCALE_H */
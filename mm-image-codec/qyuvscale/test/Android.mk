@@ -0,0 +1,38 @@
+QYUVSCALE_TEST_PATH := $(call my-dir)
+
+# golden image comparison and throughput bench (qyuvscale-test -b)
+
+include $(CLEAR_VARS)
+LOCAL_PATH := $(QYUVSCALE_TEST_PATH)
+LOCAL_MODULE_TAGS := optional
+
+LOCAL_CFLAGS := -Wall -Wextra -Werror -Wno-unused-parameter -O2
+
+LOCAL_C_INCLUDES := $(LOCAL_PATH)/..
+
+LOCAL_SRC_FILES := qyuvscale_test.c
+
+LOCAL_MODULE           := qyuvscale-test
+LOCAL_PRELINK_MODULE   := false
+LOCAL_SHARED_LIBRARIES := libqyuvscale
+
+include $(BUILD_EXECUTABLE)
+
+# same test on the build host, built with the x86 SSE2 kernels
+
+include $(CLEAR_VARS)
+LOCAL_PATH := $(QYUVSCALE_TEST_PATH)
+LOCAL_MODULE_TAGS := optional
+
+LOCAL_CFLAGS := -Wall -Wextra -Werror -Wno-unused-parameter -O2
+
+LOCAL_C_INCLUDES := $(LOCAL_PATH)/..
+
+LOCAL_SRC_FILES := qyuvscale_test.c \
+                   ../qyuvscale.c
+
+LOCAL_LDLIBS := -lpthread -lrt
+
+LOCAL_MODULE := qyuvscale-test-host
+
+include $(BUILD_HOST_EXECUTABLE)
@@ -0,0 +1,523 @@
+/* Copyright (c) 2014, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+/* Checks qyuv_scale against a per pixel reference model and a few
+ * hand computed golden images, then optionally measures throughput.
+ *
+ *   qyuvscale-test          run the conformance cases
+ *   qyuvscale-test -b [n]   also benchmark n iterations per setup
+ *   qyuvscale-test -d dir   dump every output and reference as .yuv
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "qyuvscale.h"
+
+#define PAD_BYTE 0xA5
+
+typedef struct {
+  qyuv_image_t img;
+  uint8_t *buf;
+  size_t size;
+} test_image_t;
+
+static const char *g_dump_dir;
+static int g_failures;
+
+static void image_alloc(test_image_t *t, uint32_t w, uint32_t h,
+  uint32_t pad)
+{
+  uint32_t y_stride = w + pad;
+  uint32_t uv_stride = ((w + 1) & ~1U) + pad;
+  uint32_t uv_h = (h + 1) >> 1;
+
+  t->size = (size_t)y_stride * h + (size_t)uv_stride * uv_h;
+  t->buf = (uint8_t *)malloc(t->size);
+  if (NULL == t->buf) {
+    fprintf(stderr, "no memory for %zu bytes\n", t->size);
+    exit(1);
+  }
+  memset(t->buf, PAD_BYTE, t->size);
+  t->img.y = t->buf;
+  t->img.uv = t->buf + (size_t)y_stride * h;
+  t->img.width = w;
+  t->img.height = h;
+  t->img.y_stride = y_stride;
+  t->img.uv_stride = uv_stride;
+}
+
+static void image_free(test_image_t *t)
+{
+  free(t->buf);
+  t->buf = NULL;
+}
+
+/* gradients, a checkerboard and noise so that every filter tap counts */
+static void image_fill(test_image_t *t, uint32_t seed)
+{
+  uint32_t x, y, v;
+  uint32_t rnd = seed * 2654435761U + 1;
+
+  for (y = 0; y < t->img.height; y++) {
+    for (x = 0; x < t->img.width; x++) {
+      rnd = rnd * 1103515245U + 12345U;
+      v = (x * 255 / t->img.width + y * 97 / t->img.height) & 0xFF;
+      if (((x >> 3) ^ (y >> 3)) & 1) {
+        v = 255 - v;
+      }
+      v = (v + ((rnd >> 16) & 0x1F)) & 0xFF;
+      t->img.y[y * t->img.y_stride + x] = (uint8_t)v;
+    }
+  }
+  for (y = 0; y < (t->img.height + 1) >> 1; y++) {
+    for (x = 0; x < (t->img.width + 1) >> 1; x++) {
+      rnd = rnd * 1103515245U + 12345U;
+      t->img.uv[y * t->img.uv_stride + 2 * x] =
+        (uint8_t)(64 + x * 128 / t->img.width + ((rnd >> 16) & 0xF));
+      t->img.uv[y * t->img.uv_stride + 2 * x + 1] =
+        (uint8_t)(192 - y * 128 / t->img.height - ((rnd >> 20) & 0xF));
+    }
+  }
+}
+
+/* ------------------------------------------------------------------ */
+/* Reference model: one output sample at a time, straight from the    */
+/* filter definitions                                                  */
+/* ------------------------------------------------------------------ */
+
+static void ref_bilinear_pos(uint32_t i, uint32_t len, uint32_t n,
+  uint32_t *idx, uint32_t *wt)
+{
+  int64_t f = (((int64_t)(2 * i + 1) * len << 15) / n) - 32768;
+
+  if (f < 0) {
+    f = 0;
+  }
+  *idx = (uint32_t)(f >> 16);
+  *wt = (uint32_t)(f >> 8) & 0xFF;
+  if (*idx >= len - 1) {
+    *idx = len - 1;
+    *wt = 0;
+  }
+}
+
+static uint8_t ref_sample(const uint8_t *plane, uint32_t stride,
+  uint32_t bpp, uint32_t k, const qyuv_rect_t *c, uint32_t w, uint32_t h,
+  int box, uint32_t ux, uint32_t uy, double *p_exact)
+{
+  uint32_t x, y;
+
+  if (box) {
+    uint32_t x0 = (uint32_t)((uint64_t)ux * c->width / w);
+    uint32_t x1 = (uint32_t)((uint64_t)(ux + 1) * c->width / w);
+    uint32_t y0 = (uint32_t)((uint64_t)uy * c->height / h);
+    uint32_t y1 = (uint32_t)((uint64_t)(uy + 1) * c->height / h);
+    uint32_t step = (y1 - y0 + 255) / 256;
+    uint32_t rows = 0, area;
+    uint64_t sum = 0, inv, v;
+
+    for (y = y0; y < y1; y += step) {
+      rows++;
+      for (x = x0; x < x1; x++) {
+        sum += plane[(c->top + y) * stride + (c->left + x) * bpp + k];
+      }
+    }
+    area = rows * (x1 - x0);
+    inv = ((1ULL << 24) + area / 2) / area;
+    v = (sum * inv + (1ULL << 23)) >> 24;
+    *p_exact = (double)sum / area;
+    return (uint8_t)(v > 255 ? 255 : v);
+  } else {
+    uint32_t xi, wx, yi, wy, top, bot, x1, y1;
+    const uint8_t *r0, *r1;
+
+    ref_bilinear_pos(ux, c->width, w, &xi, &wx);
+    ref_bilinear_pos(uy, c->height, h, &yi, &wy);
+    x1 = wx ? xi + 1 : xi;
+    y1 = wy ? yi + 1 : yi;
+    r0 = plane + (c->top + yi) * stride + c->left * bpp + k;
+    r1 = plane + (c->top + y1) * stride + c->left * bpp + k;
+    top = r0[xi * bpp] * (256 - wx) + r0[x1 * bpp] * wx;
+    bot = r1[xi * bpp] * (256 - wx) + r1[x1 * bpp] * wx;
+    *p_exact = (top * (256.0 - wy) + bot * (double)wy) / 65536.0;
+    return (uint8_t)((top * (256 - wy) + bot * wy + 32768) >> 16);
+  }
+}
+
+/* maps an output sample to the scaled image before rotation */
+static void ref_unrotate(int rotation, uint32_t w, uint32_t h,
+  uint32_t ox, uint32_t oy, uint32_t *ux, uint32_t *uy)
+{
+  switch (rotation) {
+  case 90:
+    *ux = oy;
+    *uy = h - 1 - ox;
+    break;
+  case 180:
+    *ux = w - 1 - ox;
+    *uy = h - 1 - oy;
+    break;
+  case 270:
+    *ux = w - 1 - oy;
+    *uy = ox;
+    break;
+  default:
+    *ux = ox;
+    *uy = oy;
+    break;
+  }
+}
+
+static void ref_scale(const qyuv_image_t *src, const qyuv_rect_t *crop,
+  qyuv_image_t *dst, int rotation, int box, double *p_max_err)
+{
+  uint32_t w, h, cw, ch, ox, oy, ux, uy, k, ow, oh;
+  qyuv_rect_t cc;
+  double exact, err;
+  uint8_t v;
+
+  w = (rotation % 180) ? dst->height : dst->width;
+  h = (rotation % 180) ? dst->width : dst->height;
+  for (oy = 0; oy < dst->height; oy++) {
+    for (ox = 0; ox < dst->width; ox++) {
+      ref_unrotate(rotation, w, h, ox, oy, &ux, &uy);
+      v = ref_sample(src->y, src->y_stride, 1, 0, crop, w, h, box, ux, uy,
+        &exact);
+      err = v > exact ? v - exact : exact - v;
+      if (err > *p_max_err) {
+        *p_max_err = err;
+      }
+      dst->y[oy * dst->y_stride + ox] = v;
+    }
+  }
+
+  cw = (src->width + 1) >> 1;
+  ch = (src->height + 1) >> 1;
+  cc.left = crop->left >> 1;
+  cc.top = crop->top >> 1;
+  cc.width = (crop->width + (crop->left & 1) + 1) >> 1;
+  cc.height = (crop->height + (crop->top & 1) + 1) >> 1;
+  if (cc.left + cc.width > cw) {
+    cc.width = cw - cc.left;
+  }
+  if (cc.top + cc.height > ch) {
+    cc.height = ch - cc.top;
+  }
+  ow = (dst->width + 1) >> 1;
+  oh = (dst->height + 1) >> 1;
+  w = (w + 1) >> 1;
+  h = (h + 1) >> 1;
+  for (oy = 0; oy < oh; oy++) {
+    for (ox = 0; ox < ow; ox++) {
+      ref_unrotate(rotation, w, h, ox, oy, &ux, &uy);
+      for (k = 0; k < 2; k++) {
+        v = ref_sample(src->uv, src->uv_stride, 2, k, &cc, w, h, box,
+          ux, uy, &exact);
+        dst->uv[oy * dst->uv_stride + 2 * ox + k] = v;
+      }
+    }
+  }
+}
+
+/* ------------------------------------------------------------------ */
+
+static void dump(const char *tag, uint32_t id, const test_image_t *t)
+{
+  char name[256];
+  FILE *f;
+  uint32_t y;
+
+  if (NULL == g_dump_dir) {
+    return;
+  }
+  snprintf(name, sizeof(name), "%s/case%03u_%s_%ux%u.yuv", g_dump_dir, id,
+    tag, t->img.width, t->img.height);
+  f = fopen(name, "wb");
+  if (NULL == f) {
+    return;
+  }
+  for (y = 0; y < t->img.height; y++) {
+    fwrite(t->img.y + y * t->img.y_stride, 1, t->img.width, f);
+  }
+  for (y = 0; y < (t->img.height + 1) >> 1; y++) {
+    fwrite(t->img.uv + y * t->img.uv_stride, 1, (t->img.width + 1) & ~1U, f);
+  }
+  fclose(f);
+}
+
+/* compares the visible samples and checks the stride padding is intact */
+static int compare(const test_image_t *a, const test_image_t *b)
+{
+  size_t i;
+
+  if (a->size != b->size) {
+    return -1;
+  }
+  for (i = 0; i < a->size; i++) {
+    if (a->buf[i] != b->buf[i]) {
+      return (int)i;
+    }
+  }
+  return -1;
+}
+
+static void run_case(uint32_t id, uint32_t sw, uint32_t sh, uint32_t spad,
+  const qyuv_rect_t *crop, uint32_t dw, uint32_t dh, uint32_t dpad,
+  int rotation, qyuv_filter_t filter)
+{
+  static const uint32_t threads[] = { 1, 2, 3, 4 };
+  test_image_t src, out, ref;
+  qyuv_rect_t c;
+  uint32_t w, h, i;
+  double max_err = 0.0;
+  int box, pos;
+
+  image_alloc(&src, sw, sh, spad);
+  image_fill(&src, id);
+  image_alloc(&ref, dw, dh, dpad);
+
+  if (crop) {
+    c = *crop;
+  } else {
+    c.left = c.top = 0;
+    c.width = sw;
+    c.height = sh;
+  }
+  w = (rotation % 180) ? dh : dw;
+  h = (rotation % 180) ? dw : dh;
+  box = (QYUV_FILTER_BILINEAR != filter) && (c.width >= w) && (c.height >= h);
+  if (box && (QYUV_FILTER_AUTO == filter)) {
+    box = (c.width >= 2 * w) && (c.height >= 2 * h);
+  }
+  ref_scale(&src.img, &c, &ref.img, rotation, box, &max_err);
+  dump("ref", id, &ref);
+
+  for (i = 0; i < sizeof(threads) / sizeof(threads[0]); i++) {
+    image_alloc(&out, dw, dh, dpad);
+    if (qyuv_scale(&src.img, crop, &out.img, rotation, filter, threads[i])) {
+      printf("case %u: qyuv_scale failed\n", id);
+      g_failures++;
+    } else if ((pos = compare(&out, &ref)) >= 0) {
+      printf("case %u: %ux%u crop %u,%u %ux%u -> %ux%u rot %d %s "
+        "threads %u: mismatch at byte %d (%u != %u)\n", id, sw, sh,
+        c.left, c.top, c.width, c.height, dw, dh, rotation,
+        box ? "box" : "bilinear", threads[i], pos, out.buf[pos],
+        ref.buf[pos]);
+      g_failures++;
+    }
+    if (0 == i) {
+      dump("out", id, &out);
+    }
+    image_free(&out);
+  }
+
+  /* the fixed point result stays within rounding of the exact filter */
+  if (max_err > 1.0) {
+    printf("case %u: error %.3f against the exact filter\n", id, max_err);
+    g_failures++;
+  }
+
+  image_free(&ref);
+  image_free(&src);
+}
+
+/* 4x4 luma ramp halved by the box filter, computed by hand */
+static void run_golden(void)
+{
+  static const uint8_t src_y[16] = {
+     0,  1,  2,  3,
+     4,  5,  6,  7,
+     8,  9, 10, 11,
+    12, 13, 14, 15,
+  };
+  static const uint8_t src_uv[8] = {
+    10, 200, 30, 100,
+    50, 0, 70, 255,
+  };
+  /* (0+1+4+5)/4 = 2.5 rounds up, and so on */
+  static const uint8_t gold_rot0[4] = { 3, 5, 11, 13 };
+  static const uint8_t gold_rot90[4] = { 11, 3, 13, 5 };
+  static const uint8_t gold_uv[2] = { 40, 139 };
+  static const int rotations[2] = { 0, 90 };
+  uint8_t sy[16], suv[8], dy[4], duv[2];
+  qyuv_image_t src, dst;
+  const uint8_t *gold;
+  int i;
+
+  memcpy(sy, src_y, sizeof(sy));
+  memcpy(suv, src_uv, sizeof(suv));
+  src.y = sy;
+  src.uv = suv;
+  src.width = src.height = 4;
+  src.y_stride = src.uv_stride = 4;
+  dst.y = dy;
+  dst.uv = duv;
+  dst.width = dst.height = 2;
+  dst.y_stride = dst.uv_stride = 2;
+
+  for (i = 0; i < 2; i++) {
+    gold = rotations[i] ? gold_rot90 : gold_rot0;
+    if (qyuv_scale(&src, NULL, &dst, rotations[i], QYUV_FILTER_BOX, 1) ||
+      memcmp(dy, gold, sizeof(dy)) || memcmp(duv, gold_uv, sizeof(duv))) {
+      printf("golden rot %d: got %u %u %u %u / %u %u\n", rotations[i],
+        dy[0], dy[1], dy[2], dy[3], duv[0], duv[1]);
+      g_failures++;
+    }
+  }
+}
+
+static void run_invalid(void)
+{
+  test_image_t src, dst;
+  qyuv_rect_t crop = { 10, 10, 60, 60 };
+
+  image_alloc(&src, 64, 48, 0);
+  image_alloc(&dst, 16, 12, 0);
+  if (0 == qyuv_scale(&src.img, &crop, &dst.img, 0, QYUV_FILTER_AUTO, 1) ||
+    0 == qyuv_scale(&src.img, NULL, &dst.img, 45, QYUV_FILTER_AUTO, 1) ||
+    0 == qyuv_scale(NULL, NULL, &dst.img, 0, QYUV_FILTER_AUTO, 1)) {
+    printf("invalid arguments accepted\n");
+    g_failures++;
+  }
+  image_free(&dst);
+  image_free(&src);
+}
+
+static double now_ms(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+static void run_bench(uint32_t iterations)
+{
+  static const struct {
+    uint32_t w, h;
+  } outputs[] = { { 512, 384 }, { 1600, 1200 } };
+  static const qyuv_filter_t filters[] = {
+    QYUV_FILTER_BOX, QYUV_FILTER_BILINEAR
+  };
+  test_image_t src, dst;
+  uint32_t o, f, r, t, i;
+  double t0, ms;
+
+  image_alloc(&src, 4208, 3120, 0);
+  image_fill(&src, 7);
+  printf("\nsource %ux%u, %u iterations\n", src.img.width, src.img.height,
+    iterations);
+  printf("%-10s %-9s %4s %8s %10s %10s\n", "output", "filter", "rot",
+    "threads", "ms", "Mpix/s");
+  for (o = 0; o < sizeof(outputs) / sizeof(outputs[0]); o++) {
+    for (f = 0; f < 2; f++) {
+      for (r = 0; r < 2; r++) {
+        uint32_t dw = r ? outputs[o].h : outputs[o].w;
+        uint32_t dh = r ? outputs[o].w : outputs[o].h;
+        image_alloc(&dst, dw, dh, 0);
+        for (t = 1; t <= QYUV_MAX_THREADS; t++) {
+          qyuv_scale(&src.img, NULL, &dst.img, r ? 90 : 0, filters[f], t);
+          t0 = now_ms();
+          for (i = 0; i < iterations; i++) {
+            qyuv_scale(&src.img, NULL, &dst.img, r ? 90 : 0, filters[f], t);
+          }
+          ms = (now_ms() - t0) / iterations;
+          printf("%4ux%-5u %-9s %4d %8u %10.2f %10.1f\n", outputs[o].w,
+            outputs[o].h, f ? "bilinear" : "box", r ? 90 : 0, t, ms,
+            src.img.width * (double)src.img.height / (ms * 1000.0));
+        }
+        image_free(&dst);
+      }
+    }
+  }
+  image_free(&src);
+}
+
+int main(int argc, char **argv)
+{
+  static const int rotations[] = { 0, 90, 180, 270 };
+  static const qyuv_filter_t filters[] = {
+    QYUV_FILTER_AUTO, QYUV_FILTER_BOX, QYUV_FILTER_BILINEAR
+  };
+  static const struct {
+    uint32_t sw, sh, spad;
+    qyuv_rect_t crop;
+    uint32_t dw, dh, dpad;
+  } cases[] = {
+    { 64, 48, 0, { 0, 0, 0, 0 }, 16, 12, 0 },
+    { 64, 48, 32, { 0, 0, 0, 0 }, 32, 24, 16 },
+    { 97, 61, 7, { 0, 0, 0, 0 }, 23, 15, 3 },
+    { 97, 61, 7, { 3, 5, 50, 30 }, 20, 14, 0 },
+    { 640, 480, 0, { 80, 60, 480, 360 }, 160, 120, 0 },
+    { 640, 480, 64, { 0, 0, 0, 0 }, 512, 384, 0 },
+    { 640, 480, 0, { 1, 1, 637, 477 }, 96, 72, 8 },
+    { 320, 240, 0, { 0, 0, 0, 0 }, 400, 300, 0 },
+    { 1300, 40, 0, { 0, 0, 0, 0 }, 4, 2, 0 },
+    { 2000, 600, 0, { 0, 0, 0, 0 }, 6, 2, 0 },
+  };
+  uint32_t iterations = 0, c, r, f, id = 0;
+  int i;
+
+  for (i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "-b")) {
+      iterations = 20;
+      if ((i + 1 < argc) && (atoi(argv[i + 1]) > 0)) {
+        iterations = (uint32_t)atoi(argv[++i]);
+      }
+    } else if (!strcmp(argv[i], "-d") && (i + 1 < argc)) {
+      g_dump_dir = argv[++i];
+    } else {
+      printf("usage: %s [-b [iterations]] [-d dump_dir]\n", argv[0]);
+      return 2;
+    }
+  }
+
+  run_golden();
+  run_invalid();
+  for (c = 0; c < sizeof(cases) / sizeof(cases[0]); c++) {
+    for (r = 0; r < sizeof(rotations) / sizeof(rotations[0]); r++) {
+      for (f = 0; f < sizeof(filters) / sizeof(filters[0]); f++) {
+        uint32_t dw = (rotations[r] % 180) ? cases[c].dh : cases[c].dw;
+        uint32_t dh = (rotations[r] % 180) ? cases[c].dw : cases[c].dh;
+        run_case(id++, cases[c].sw, cases[c].sh, cases[c].spad,
+          cases[c].crop.width ? &cases[c].crop : NULL, dw, dh,
+          cases[c].dpad, rotations[r], filters[f]);
+      }
+    }
+  }
+  printf("%u cases, %d failures\n", id, g_failures);
+
+  if (iterations) {
+    run_bench(iterations);
+  }
+  return g_failures ? 1 : 0;
+}